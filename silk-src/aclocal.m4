@@ -1519,10 +1519,12 @@ AC_SUBST([am__untar])
 
 m4_include([m4/ax_check_libadns.m4])
 m4_include([m4/ax_check_libcares.m4])
+m4_include([m4/ax_check_liblz4.m4])
 m4_include([m4/ax_check_liblzo.m4])
 m4_include([m4/ax_check_libpcap.m4])
 m4_include([m4/ax_check_libsnappy.m4])
 m4_include([m4/ax_check_libz.m4])
+m4_include([m4/ax_check_libzstd.m4])
 m4_include([m4/ax_check_printf_z.m4])
 m4_include([m4/ax_check_pthread.m4])
 m4_include([m4/ax_pkg_check_gnutls.m4])
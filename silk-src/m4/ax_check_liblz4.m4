@@ -0,0 +1,106 @@
+dnl Copyright (C) 2004-2017 by Carnegie Mellon University.
+dnl
+dnl @OPENSOURCE_LICENSE_START@
+dnl See license information in ../LICENSE.txt
+dnl @OPENSOURCE_LICENSE_END@
+
+dnl RCSIDENT("$SiLK: ax_check_liblz4.m4 $")
+
+# ---------------------------------------------------------------------------
+# AX_CHECK_LIBLZ4
+#
+#    Determine how to use the lz4 compression library
+#
+#    Substitutions: SK_ENABLE_LZ4
+#    Output defines: ENABLE_LZ4
+#
+AC_DEFUN([AX_CHECK_LIBLZ4],[
+    ENABLE_LZ4=0
+
+    AC_ARG_WITH([lz4],[AS_HELP_STRING([--with-lz4=LZ4_DIR],
+            [specify location of the lz4 file compression library; find "lz4.h" in LZ4_DIR/include/; find "liblz4.so" in LZ4_DIR/lib/ [auto]])[]dnl
+        ],[
+            if test "x$withval" != "xyes"
+            then
+                lz4_dir="$withval"
+                lz4_includes="$lz4_dir/include"
+                lz4_libraries="$lz4_dir/lib"
+            fi
+    ])
+    AC_ARG_WITH([lz4-includes],[AS_HELP_STRING([--with-lz4-includes=DIR],
+            [find "lz4.h" in DIR/ (overrides LZ4_DIR/include/)])[]dnl
+        ],[
+            if test "x$withval" = "xno"
+            then
+                lz4_dir=no
+            elif test "x$withval" != "xyes"
+            then
+                lz4_includes="$withval"
+            fi
+    ])
+    AC_ARG_WITH([lz4-libraries],[AS_HELP_STRING([--with-lz4-libraries=DIR],
+            [find "liblz4.so" in DIR/ (overrides LZ4_DIR/lib/)])[]dnl
+        ],[
+            if test "x$withval" = "xno"
+            then
+                lz4_dir=no
+            elif test "x$withval" != "xyes"
+            then
+                lz4_libraries="$withval"
+            fi
+    ])
+
+    if test "x$lz4_dir" != "xno"
+    then
+        # Cache current values
+        sk_save_LDFLAGS="$LDFLAGS"
+        sk_save_LIBS="$LIBS"
+        sk_save_CFLAGS="$CFLAGS"
+        sk_save_CPPFLAGS="$CPPFLAGS"
+
+        if test "x$lz4_libraries" != "x"
+        then
+            LZ4_LDFLAGS="-L$lz4_libraries"
+            LDFLAGS="$LZ4_LDFLAGS $sk_save_LDFLAGS"
+        fi
+
+        if test "x$lz4_includes" != "x"
+        then
+            LZ4_CFLAGS="-I$lz4_includes"
+            CPPFLAGS="$LZ4_CFLAGS $sk_save_CPPFLAGS"
+        fi
+
+        AC_CHECK_LIB([lz4], [LZ4_compress_fast_extState],
+            [ENABLE_LZ4=1 ; LZ4_LDFLAGS="$LZ4_LDFLAGS -llz4"])
+
+        if test "x$ENABLE_LZ4" = "x1"
+        then
+            AC_CHECK_HEADER([lz4.h], , [
+                AC_MSG_WARN([Found lz4 but not lz4.h.  Maybe you should install lz4-devel?])
+                ENABLE_LZ4=0])
+        fi
+
+        # Restore cached values
+        LDFLAGS="$sk_save_LDFLAGS"
+        LIBS="$sk_save_LIBS"
+        CFLAGS="$sk_save_CFLAGS"
+        CPPFLAGS="$sk_save_CPPFLAGS"
+    fi
+
+    if test "x$ENABLE_LZ4" != "x1"
+    then
+        LZ4_CFLAGS=
+        LZ4_LDFLAGS=
+    fi
+
+    AC_DEFINE_UNQUOTED([ENABLE_LZ4], [$ENABLE_LZ4],
+        [Define to 1 build with support for lz4 compression.  Define
+         to 0 otherwise.  Requires the liblz4 library and the
+         lz4.h header file.])
+    AC_SUBST([SK_ENABLE_LZ4], [$ENABLE_LZ4])
+])# AX_CHECK_LZ4
+
+dnl Local Variables:
+dnl mode:autoconf
+dnl indent-tabs-mode:nil
+dnl End:
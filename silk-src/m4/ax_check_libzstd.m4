@@ -0,0 +1,106 @@
+dnl Copyright (C) 2004-2017 by Carnegie Mellon University.
+dnl
+dnl @OPENSOURCE_LICENSE_START@
+dnl See license information in ../LICENSE.txt
+dnl @OPENSOURCE_LICENSE_END@
+
+dnl RCSIDENT("$SiLK: ax_check_libzstd.m4 $")
+
+# ---------------------------------------------------------------------------
+# AX_CHECK_LIBZSTD
+#
+#    Determine how to use the zstd compression library
+#
+#    Substitutions: SK_ENABLE_ZSTD
+#    Output defines: ENABLE_ZSTD
+#
+AC_DEFUN([AX_CHECK_LIBZSTD],[
+    ENABLE_ZSTD=0
+
+    AC_ARG_WITH([zstd],[AS_HELP_STRING([--with-zstd=ZSTD_DIR],
+            [specify location of the zstd (Zstandard) file compression library; find "zstd.h" in ZSTD_DIR/include/; find "libzstd.so" in ZSTD_DIR/lib/ [auto]])[]dnl
+        ],[
+            if test "x$withval" != "xyes"
+            then
+                zstd_dir="$withval"
+                zstd_includes="$zstd_dir/include"
+                zstd_libraries="$zstd_dir/lib"
+            fi
+    ])
+    AC_ARG_WITH([zstd-includes],[AS_HELP_STRING([--with-zstd-includes=DIR],
+            [find "zstd.h" in DIR/ (overrides ZSTD_DIR/include/)])[]dnl
+        ],[
+            if test "x$withval" = "xno"
+            then
+                zstd_dir=no
+            elif test "x$withval" != "xyes"
+            then
+                zstd_includes="$withval"
+            fi
+    ])
+    AC_ARG_WITH([zstd-libraries],[AS_HELP_STRING([--with-zstd-libraries=DIR],
+            [find "libzstd.so" in DIR/ (overrides ZSTD_DIR/lib/)])[]dnl
+        ],[
+            if test "x$withval" = "xno"
+            then
+                zstd_dir=no
+            elif test "x$withval" != "xyes"
+            then
+                zstd_libraries="$withval"
+            fi
+    ])
+
+    if test "x$zstd_dir" != "xno"
+    then
+        # Cache current values
+        sk_save_LDFLAGS="$LDFLAGS"
+        sk_save_LIBS="$LIBS"
+        sk_save_CFLAGS="$CFLAGS"
+        sk_save_CPPFLAGS="$CPPFLAGS"
+
+        if test "x$zstd_libraries" != "x"
+        then
+            ZSTD_LDFLAGS="-L$zstd_libraries"
+            LDFLAGS="$ZSTD_LDFLAGS $sk_save_LDFLAGS"
+        fi
+
+        if test "x$zstd_includes" != "x"
+        then
+            ZSTD_CFLAGS="-I$zstd_includes"
+            CPPFLAGS="$ZSTD_CFLAGS $sk_save_CPPFLAGS"
+        fi
+
+        AC_CHECK_LIB([zstd], [ZSTD_compressCCtx],
+            [ENABLE_ZSTD=1 ; ZSTD_LDFLAGS="$ZSTD_LDFLAGS -lzstd"])
+
+        if test "x$ENABLE_ZSTD" = "x1"
+        then
+            AC_CHECK_HEADER([zstd.h], , [
+                AC_MSG_WARN([Found zstd but not zstd.h.  Maybe you should install libzstd-devel?])
+                ENABLE_ZSTD=0])
+        fi
+
+        # Restore cached values
+        LDFLAGS="$sk_save_LDFLAGS"
+        LIBS="$sk_save_LIBS"
+        CFLAGS="$sk_save_CFLAGS"
+        CPPFLAGS="$sk_save_CPPFLAGS"
+    fi
+
+    if test "x$ENABLE_ZSTD" != "x1"
+    then
+        ZSTD_CFLAGS=
+        ZSTD_LDFLAGS=
+    fi
+
+    AC_DEFINE_UNQUOTED([ENABLE_ZSTD], [$ENABLE_ZSTD],
+        [Define to 1 build with support for zstd compression.  Define
+         to 0 otherwise.  Requires the libzstd library and the
+         zstd.h header file.])
+    AC_SUBST([SK_ENABLE_ZSTD], [$ENABLE_ZSTD])
+])# AX_CHECK_ZSTD
+
+dnl Local Variables:
+dnl mode:autoconf
+dnl indent-tabs-mode:nil
+dnl End:
@@ -130,6 +130,24 @@ RCSIDENTVAR(rcsID_LIBFLOWSOURCE_H, "$SiLK: libflowsource.h 275df62a2e41 2017-01-
  */
 #define SOCKETBUFFER_MINIMUM_ENV "SK_SOCKETBUFFER_MINIMUM"
 
+/**
+ *    Number of sockets a UDP source opens on each address it listens
+ *    on, each read by its own thread.  When larger than 1, the
+ *    sockets are bound with SO_REUSEPORT so the kernel spreads the
+ *    incoming packets across them.
+ */
+#define UDP_READER_SOCKETS_DEFAULT  1
+
+/**
+ *    Environment variable to modify UDP_READER_SOCKETS_DEFAULT
+ */
+#define UDP_READER_SOCKETS_ENV "SILK_UDP_READER_SOCKETS"
+
+/**
+ *    Maximum value for UDP_READER_SOCKETS_ENV
+ */
+#define UDP_READER_SOCKETS_MAXIMUM  64
+
 
 typedef union skFlowSourceParams_un {
     uint32_t    max_pkts;
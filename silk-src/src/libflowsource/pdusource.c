@@ -838,6 +838,7 @@ skPDUSourceLogStats(
     pthread_mutex_lock(&source->stats_mutex);
     FLOWSOURCE_STATS_INFOMSG(source->name, &(source->statistics));
     pthread_mutex_unlock(&source->stats_mutex);
+    skUDPSourceLogDrops(source->source, 0);
 }
 
 /* Log statistics associated with a PDU source, and then clear the
@@ -850,6 +851,7 @@ skPDUSourceLogStatsAndClear(
     FLOWSOURCE_STATS_INFOMSG(source->name, &(source->statistics));
     memset(&source->statistics, 0, sizeof(source->statistics));
     pthread_mutex_unlock(&source->stats_mutex);
+    skUDPSourceLogDrops(source->source, 1);
 }
 
 /* Clear out current statistics */
@@ -39,12 +39,22 @@ RCSIDENT("$SiLK: udpsource.c b1f14bba708e 2017-06-28 15:29:44Z mthomas $");
 #define DEBUG_ACCEPT_FROM 0
 #endif
 
+/* Maximum number of packets a udp_reader() thread receives with a
+ * single call to recvmmsg(); 1 when recvmmsg() is not available. */
+#if SK_HAVE_RECVMMSG
+#define UDP_READER_BATCH 32
+#else
+#define UDP_READER_BATCH 1
+#endif
+
 
 /* forward declarations */
 struct skUDPSourceBase_st;
 typedef struct skUDPSourceBase_st skUDPSourceBase_t;
 struct peeraddr_source_st;
 typedef struct peeraddr_source_st peeraddr_source_t;
+struct udp_reader_st;
+typedef struct udp_reader_st udp_reader_t;
 
 
 /*
@@ -85,6 +95,19 @@ struct skUDPSource_st {
     sk_circbuf_t               *data_buffer;
     void                       *pkt_buffer;
 
+    /* protects 'pkt_buffer' when several udp_reader() threads add
+     * packets to this source */
+    pthread_mutex_t             writer_mutex;
+
+    /* number of udp_reader() threads that have found this source and
+     * may still write to it; protected by the base's mutex.
+     * skUDPSourceDestroy() waits for this to reach zero. */
+    uint32_t                    writers;
+
+    /* set, with the base's mutex held, when the source can no longer
+     * accept packets because its 'data_buffer' failed */
+    uint32_t                    write_failed;
+
     unsigned                    stopped : 1;
 };
 
@@ -106,8 +129,10 @@ struct skUDPSourceBase_st {
     /* addresses to bind() to */
     const sk_sockaddr_array_t *listen_address;
 
-    /* Thread data */
-    pthread_t               thread;
+    /* Thread data; there is one reader for each socket opened on an
+     * address */
+    udp_reader_t           *readers;
+    uint32_t                reader_count;
     pthread_mutex_t         mutex;
     pthread_cond_t          cond;
 
@@ -116,6 +141,14 @@ struct skUDPSourceBase_st {
     nfds_t                  pfd_len;   /* Size of array */
     nfds_t                  pfd_valid; /* Number of valid entries in array */
 
+    /* Number of packets the kernel dropped on each socket in 'pfd'
+     * as most recently reported by the socket ('count') and when the
+     * counts were last cleared ('cleared') */
+    struct udp_socket_drops_st {
+        uint32_t            count;
+        uint32_t            cleared;
+    }                      *drops;
+
     /* Used with file-based sources */
     uint8_t                *file_buffer;
 #if SK_ENABLE_ZLIB
@@ -134,12 +167,13 @@ struct skUDPSourceBase_st {
     /* number of 'sources' that are running */
     uint32_t                active_sources;
 
+    /* number of udp_reader threads that have started */
+    uint32_t                started;
+    /* number of udp_reader threads that are running */
+    uint32_t                running;
+
     /* Is this a file source? */
     unsigned                file       : 1;
-    /* Was the udp_reader thread started? */
-    unsigned                started    : 1;
-    /* Is the udp_reader thread running? */
-    unsigned                running    : 1;
 
     /* Set to 1 to signal the udp_reader thread to stop running */
     unsigned                stop       : 1;
@@ -165,6 +199,25 @@ struct peeraddr_source_st {
 };
 
 
+/*
+ *    A base has a 'udp_reader_t' for each udp_reader() thread.  Each
+ *    reader polls one socket for every address the base listens on;
+ *    its 'pfd' member points into the base's 'pfd' array.
+ */
+/* typedef struct udp_reader_st udp_reader_t; */
+struct udp_reader_st {
+    skUDPSourceBase_t  *base;
+    pthread_t           thread;
+    /* the sockets to listen to, their number, and the number that
+     * are valid */
+    struct pollfd      *pfd;
+    nfds_t              pfd_len;
+    nfds_t              pfd_valid;
+    /* index of 'pfd' within the base's 'pfd' array */
+    nfds_t              pfd_offset;
+};
+
+
 /* LOCAL VARIABLE DEFINITIONS */
 
 /* The 'source_bases' list contains pointers to all existing
@@ -201,25 +254,144 @@ peeraddr_compare(
 }
 
 
+/*
+ *    Return the number of sockets to open on each address, as
+ *    determined by the UDP_READER_SOCKETS_ENV environment variable.
+ */
+static uint32_t
+udp_reader_socket_count(
+    void)
+{
+    static uint32_t socket_count = 0;
+    const char *env;
+    uint32_t val;
+
+    assert(pthread_mutex_trylock(&source_bases_mutex) == EBUSY);
+
+    if (socket_count) {
+        return socket_count;
+    }
+    socket_count = UDP_READER_SOCKETS_DEFAULT;
+
+    env = getenv(UDP_READER_SOCKETS_ENV);
+    if (env && *env) {
+        if (skStringParseUint32(&val, env, 1, UDP_READER_SOCKETS_MAXIMUM)) {
+            NOTICEMSG("Ignoring invalid %s value '%s'",
+                      UDP_READER_SOCKETS_ENV, env);
+        } else {
+            socket_count = val;
+        }
+    }
+#ifndef SO_REUSEPORT
+    if (socket_count > 1) {
+        NOTICEMSG(("Ignoring %s value '%s':"
+                   " SO_REUSEPORT is not supported on this system"),
+                  UDP_READER_SOCKETS_ENV, env);
+        socket_count = 1;
+    }
+#endif
+    return socket_count;
+}
+
+
+/*
+ *    Find the source for a packet received from 'addr'.  Return NULL
+ *    if the packet should be ignored.  The caller must have the
+ *    base's mutex.
+ */
+static skUDPSource_t *
+udp_reader_find_source(
+    skUDPSourceBase_t  *base,
+    sk_sockaddr_t      *addr)
+{
+    const peeraddr_source_t *match_address;
+    peeraddr_source_t target;
+    skUDPSource_t *source;
+
+    if (base->any) {
+        /* When there is no accept-from address on the probe, there
+         * is a one-to-one mapping between source and base, and all
+         * connections are permitted. */
+        assert(NULL == base->addr_to_source);
+        source = base->any;
+    } else {
+        /* Using the address of the incoming connection, search for
+         * the source object associated with this address. */
+        assert(NULL != base->addr_to_source);
+        target.addr = addr;
+        match_address = ((const peeraddr_source_t*)
+                         rbfind(&target, base->addr_to_source));
+        if (match_address) {
+            /* we recognize the sender */
+            source = match_address->source;
+            base->unknown_host = 0;
+#if  !DEBUG_ACCEPT_FROM
+        } else if (!base->unknown_host) {
+            /* additional packets seen from one or more distinct
+             * unknown senders; ignore */
+            return NULL;
+#endif
+        } else {
+            /* first packet seen from unknown sender after receiving
+             * packet from valid sensder; log */
+            char addr_buf[2 * SK_NUM2DOT_STRLEN];
+            base->unknown_host = 1;
+            skSockaddrString(addr_buf, sizeof(addr_buf), addr);
+            INFOMSG("Ignoring packets from host %s", addr_buf);
+            return NULL;
+        }
+    }
+
+    if (source->stopped || source->write_failed) {
+        return NULL;
+    }
+    return source;
+}
+
+
 /*
  *    THREAD ENTRY POINT
  *
- *    The udp_reader() function is the thread for listening to data on
- *    a single UDP port.  The skUDPSourceBase_t object containing
- *    information about the port is passed into this function.  This
- *    thread is started from the udpSourceCreateBase() function.
+ *    The udp_reader() function is a thread for listening to data on
+ *    a UDP port.  The udp_reader_t object holding the sockets that
+ *    this thread reads is passed into this function.  A base has one
+ *    udp_reader() thread for each socket it opens on an address.
+ *    These threads are started from the udpSourceCreateBase()
+ *    function.
+ *
+ *    Where available, the thread uses recvmmsg() to receive up to
+ *    UDP_READER_BATCH packets with a single system call.
  */
 static void *
 udp_reader(
-    void               *vbase)
+    void               *vreader)
 {
-    skUDPSourceBase_t *base = (skUDPSourceBase_t*)vbase;
-    sk_sockaddr_t addr;
-    void *data;
-    peeraddr_source_t target;
-    socklen_t len;
-    skUDPSource_t *source = NULL;
-    const peeraddr_source_t *match_address;
+    udp_reader_t *reader = (udp_reader_t*)vreader;
+    skUDPSourceBase_t *base = reader->base;
+    skUDPSource_t *source[UDP_READER_BATCH];
+    sk_sockaddr_t addr[UDP_READER_BATCH];
+    struct iovec iov[UDP_READER_BATCH];
+#if SK_HAVE_RECVMMSG
+    struct mmsghdr msgs[UDP_READER_BATCH];
+#else
+    struct {
+        struct msghdr   msg_hdr;
+        unsigned int    msg_len;
+    } msgs[UDP_READER_BATCH];
+#endif
+#ifdef SO_RXQ_OVFL
+    union {
+        struct cmsghdr  align;
+        char            buf[CMSG_SPACE(sizeof(uint32_t))];
+    } control[UDP_READER_BATCH];
+    struct cmsghdr *cmsg;
+    uint32_t drops = 0;
+    int saw_drops;
+#endif  /* SO_RXQ_OVFL */
+    skUDPSource_t *found[UDP_READER_BATCH];
+    uint8_t *data;
+    int j;
+    int k;
 
     assert(base != NULL);
 
@@ -232,20 +404,33 @@ udp_reader(
     pthread_mutex_lock(&base->mutex);
 
     /* Note run state */
-    base->started = 1;
-    base->running = 1;
+    ++base->started;
+    ++base->running;
 
     /* Allocate a space to read data into */
-    data = (void *)malloc(base->data_size);
+    data = (uint8_t*)malloc(UDP_READER_BATCH * base->data_size);
     if (NULL == data) {
         NOTICEMSG("Unable to create UDP listener data buffer for %s: %s",
                   base->name, strerror(errno));
-        base->running = 0;
-        pthread_cond_signal(&base->cond);
+        --base->running;
+        pthread_cond_broadcast(&base->cond);
         pthread_mutex_unlock(&base->mutex);
         return NULL;
     }
 
+    /* Point each message at its part of the data buffer */
+    memset(msgs, 0, sizeof(msgs));
+    for (j = 0; j < UDP_READER_BATCH; ++j) {
+        iov[j].iov_base = data + j * base->data_size;
+        iov[j].iov_len = base->data_size;
+        msgs[j].msg_hdr.msg_name = &addr[j];
+        msgs[j].msg_hdr.msg_iov = &iov[j];
+        msgs[j].msg_hdr.msg_iovlen = 1;
+#ifdef SO_RXQ_OVFL
+        msgs[j].msg_hdr.msg_control = control[j].buf;
+#endif
+    }
+
     /* Signal completion of initialization */
     pthread_cond_broadcast(&base->cond);
 
@@ -256,12 +441,13 @@ udp_reader(
     pthread_mutex_unlock(&base->mutex);
 
     /* Main loop */
-    while (!base->stop && base->active_sources && base->pfd_valid) {
+    while (!base->stop && base->active_sources && reader->pfd_valid) {
         nfds_t i;
-        ssize_t rv;
+        int count;
+        int rv;
 
         /* Wait for data */
-        rv = poll(base->pfd, base->pfd_len, POLL_TIMEOUT);
+        rv = poll(reader->pfd, reader->pfd_len, POLL_TIMEOUT);
         if (rv == -1) {
             if (errno == EINTR || errno == EAGAIN) {
                 /* Interrupted by a signal, or internal alloc failed,
@@ -281,21 +467,21 @@ udp_reader(
         }
 
         /* Loop around file descriptors */
-        for (i = 0; i < base->pfd_len; i++) {
-            struct pollfd *pfd = &base->pfd[i];
+        for (i = 0; i < reader->pfd_len; i++) {
+            struct pollfd *pfd = &reader->pfd[i];
 
             if (pfd->revents & (POLLERR | POLLHUP | POLLNVAL)) {
                 if (!(pfd->revents & POLLNVAL)) {
                     close(pfd->fd);
                 }
                 pfd->fd = -1;
-                base->pfd_valid--;
+                reader->pfd_valid--;
                 DEBUGMSG("Poll for %s encountered a (%s,%s,%s) condition",
                          base->name, (pfd->revents & POLLERR) ? "ERR": "",
                          (pfd->revents & POLLHUP) ? "HUP": "",
                          (pfd->revents & POLLNVAL) ? "NVAL": "");
                 DEBUGMSG("Closing file handle, %d remaining",
-                         (int)base->pfd_valid);
+                         (int)reader->pfd_valid);
                 continue;
             }
 
@@ -303,13 +489,30 @@ udp_reader(
                 continue;
             }
 
-            /* Read the data */
-            len = sizeof(addr);
-            rv = recvfrom(pfd->fd, data, base->data_size, 0,
-                          (struct sockaddr *)&addr, &len);
+            /* Reset the lengths that the previous read modified */
+            for (j = 0; j < UDP_READER_BATCH; ++j) {
+                msgs[j].msg_hdr.msg_namelen = sizeof(addr[j]);
+#ifdef SO_RXQ_OVFL
+                msgs[j].msg_hdr.msg_controllen = sizeof(control[j].buf);
+#endif
+            }
 
-            /* Check for error or recv from wrong address */
+            /* Read the data */
+#if SK_HAVE_RECVMMSG
+            count = recvmmsg(pfd->fd, msgs, UDP_READER_BATCH,
+                             MSG_WAITFORONE, NULL);
+#else
+            rv = recvmsg(pfd->fd, &msgs[0].msg_hdr, 0);
             if (rv == -1) {
+                count = -1;
+            } else {
+                msgs[0].msg_len = rv;
+                count = 1;
+            }
+#endif  /* SK_HAVE_RECVMMSG */
+
+            /* Check for error */
+            if (count == -1) {
                 switch (errno) {
                   case EINTR:
                     /* Interrupted by a signal: ignore now, try again
@@ -328,80 +531,110 @@ udp_reader(
                 }
             }
 
+            /* Find the source for each packet and note the number of
+             * packets the kernel has dropped on this socket */
+#ifdef SO_RXQ_OVFL
+            saw_drops = 0;
+#endif
             pthread_mutex_lock(&base->mutex);
+            for (j = 0; j < count; ++j) {
+                source[j] = udp_reader_find_source(base, &addr[j]);
+                found[j] = source[j];
+                if (source[j]) {
+                    /* keep the source alive until the copy is done */
+                    ++source[j]->writers;
+                }
+#ifdef SO_RXQ_OVFL
+                for (cmsg = CMSG_FIRSTHDR(&msgs[j].msg_hdr);
+                     cmsg != NULL;
+                     cmsg = CMSG_NXTHDR(&msgs[j].msg_hdr, cmsg))
+                {
+                    if (SOL_SOCKET == cmsg->cmsg_level
+                        && SO_RXQ_OVFL == cmsg->cmsg_type)
+                    {
+                        memcpy(&drops, CMSG_DATA(cmsg), sizeof(drops));
+                        saw_drops = 1;
+                    }
+                }
+#endif  /* SO_RXQ_OVFL */
+            }
+#ifdef SO_RXQ_OVFL
+            if (saw_drops) {
+                base->drops[reader->pfd_offset + i].count = drops;
+            }
+#endif
+            pthread_mutex_unlock(&base->mutex);
 
-            if (base->any) {
-                /* When there is no accept-from address on the probe,
-                 * there is a one-to-one mapping between source and
-                 * base, and all connections are permitted. */
-                assert(NULL == base->addr_to_source);
-                source = base->any;
-            } else {
-                /* Using the address of the incoming connection,
-                 * search for the source object associated with this
-                 * address. */
-                assert(NULL != base->addr_to_source);
-                target.addr = &addr;
-                match_address = ((const peeraddr_source_t*)
-                                 rbfind(&target, base->addr_to_source));
-                if (match_address) {
-                    /* we recognize the sender */
-                    source = match_address->source;
-                    base->unknown_host = 0;
-#if  !DEBUG_ACCEPT_FROM
-                } else if (!base->unknown_host) {
-                    /* additional packets seen from one or more
-                     * distinct unknown senders; ignore */
-                    pthread_mutex_unlock(&base->mutex);
+            for (j = 0; j < count; ++j) {
+                if (NULL == source[j]) {
                     continue;
-#endif
-                } else {
-                    /* first packet seen from unknown sender after
-                     * receiving packet from valid sensder; log */
-                    char addr_buf[2 * SK_NUM2DOT_STRLEN];
-                    base->unknown_host = 1;
-                    pthread_mutex_unlock(&base->mutex);
-                    skSockaddrString(addr_buf, sizeof(addr_buf), &addr);
-                    INFOMSG("Ignoring packets from host %s", addr_buf);
+                }
+
+                /* Several readers may add packets to a source at
+                 * once */
+                pthread_mutex_lock(&source[j]->writer_mutex);
+
+                if (source[j]->write_failed) {
+                    /* another reader found the source's data buffer
+                     * gone after this reader found the source */
+                    pthread_mutex_unlock(&source[j]->writer_mutex);
                     continue;
                 }
-            }
 
-            if (source->stopped) {
-                pthread_mutex_unlock(&base->mutex);
-                continue;
-            }
+                /* Copy the data onto the source */
+                memcpy(source[j]->pkt_buffer, iov[j].iov_base,
+                       msgs[j].msg_len);
 
-            /* Copy the data onto the source */
-            memcpy(source->pkt_buffer, data, rv);
-            pthread_mutex_unlock(&base->mutex);
+                if (source[j]->reject_pkt_fn
+                    && source[j]->reject_pkt_fn(msgs[j].msg_len,
+                                                source[j]->pkt_buffer,
+                                                source[j]->fn_callback_data))
+                {
+                    /* reject the packet; do not advance to next
+                     * location */
+                    pthread_mutex_unlock(&source[j]->writer_mutex);
+                    continue;
+                }
 
-            if (source->reject_pkt_fn
-                && source->reject_pkt_fn(rv, source->pkt_buffer,
-                                         source->fn_callback_data))
-            {
-                /* reject the packet; do not advance to next location */
-                continue;
+                /* Acquire the next location */
+                rv = skCircBufGetWriterBlock(source[j]->data_buffer,
+                                             &source[j]->pkt_buffer, NULL);
+                if (rv) {
+                    /* The source has no place to put packets; stop
+                     * giving it any.  Other readers may have found
+                     * the source already, so the flag is set while
+                     * holding the writer mutex too. */
+                    NOTICEMSG("Non-existent data buffer for %s", base->name);
+                    pthread_mutex_lock(&base->mutex);
+                    source[j]->write_failed = 1;
+                    pthread_mutex_unlock(&base->mutex);
+                    for (k = j + 1; k < count; ++k) {
+                        if (source[k] == source[j]) {
+                            source[k] = NULL;
+                        }
+                    }
+                }
+                pthread_mutex_unlock(&source[j]->writer_mutex);
             }
 
-            /* Acquire the next location */
-
-            if (skCircBufGetWriterBlock(
-                    source->data_buffer, &source->pkt_buffer, NULL))
-            {
-                NOTICEMSG("Non-existent data buffer for %s", base->name);
-                break;
+            /* Release the sources found for this batch */
+            pthread_mutex_lock(&base->mutex);
+            for (j = 0; j < count; ++j) {
+                if (found[j] && 0 == --found[j]->writers) {
+                    pthread_cond_broadcast(&base->cond);
+                }
             }
-        } /* for (i = 0; i < base->nfds_t; i++) */
-    } /* while (!base->stop && base->pfd_valid) */
+            pthread_mutex_unlock(&base->mutex);
+        } /* for (i = 0; i < reader->pfd_len; i++) */
+    } /* while (!base->stop && reader->pfd_valid) */
 
   BREAK_WHILE:
 
     free(data);
 
-    /* Set running to zero, and notify waiters of our exit */
+    /* Decrement running, and notify waiters of our exit */
     pthread_mutex_lock(&base->mutex);
-    base->running = 0;
+    --base->running;
     pthread_cond_broadcast(&base->cond);
     pthread_mutex_unlock(&base->mutex);
 
@@ -476,6 +709,7 @@ static void
 udpSourceDestroyBase(
     skUDPSourceBase_t  *base)
 {
+    uint32_t k;
     nfds_t i;
 
     assert(base);
@@ -499,15 +733,17 @@ udpSourceDestroyBase(
             free(base->file_buffer);
         }
     } else {
-        /* If running, notify thread to stop, and then wait for exit */
-        if (base->running) {
-            base->stop = 1;
-            while (base->running) {
-                pthread_cond_wait(&base->cond, &base->mutex);
-            }
+        /* If running, notify threads to stop, and then wait for exit */
+        base->stop = 1;
+        while (base->running) {
+            pthread_cond_wait(&base->cond, &base->mutex);
+        }
+        /* Reap threads */
+        for (k = 0; k < base->reader_count; ++k) {
+            pthread_join(base->readers[k].thread, NULL);
         }
-        /* Reap thread */
-        pthread_join(base->thread, NULL);
+        free(base->readers);
+        base->readers = NULL;
 
         /* Close sockets */
         for (i = 0; i < base->pfd_len; i++) {
@@ -522,6 +758,8 @@ udpSourceDestroyBase(
         }
         free(base->pfd);
         base->pfd = NULL;
+        free(base->drops);
+        base->drops = NULL;
 
         /* Free addr_to_source tree */
         if (base->addr_to_source) {
@@ -565,9 +803,11 @@ udpSourceDestroyBase(
 
 
 /*
- *    Create a base object and its associated thread.  The file
- *    descriptors for the base to monitor are in the 'pfd_array'.  If
- *    an error occurs, close the descriptors and return NULL.
+ *    Create a base object and its associated threads.  The file
+ *    descriptors for the base to monitor are in the 'pfd_array'.  The
+ *    array is divided into 'reader_count' equal parts, and a separate
+ *    thread monitors each part.  If an error occurs, close the
+ *    descriptors and return NULL.
  */
 static skUDPSourceBase_t *
 udpSourceCreateBase(
@@ -576,11 +816,18 @@ udpSourceCreateBase(
     struct pollfd      *pfd_array,
     nfds_t              pfd_len,
     nfds_t              pfd_valid,
+    uint32_t            reader_count,
     uint32_t            itemsize)
 {
     skUDPSourceBase_t *base;
+    udp_reader_t *reader;
+    uint32_t k;
+    nfds_t i;
     int rv;
 
+    assert(reader_count > 0);
+    assert(0 == pfd_len % reader_count);
+
     /* Create base structure */
     base = (skUDPSourceBase_t*)calloc(1, sizeof(skUDPSourceBase_t));
     if (base == NULL) {
@@ -608,21 +855,43 @@ udpSourceCreateBase(
         snprintf(base->name, sizeof(base->name), "%s", name);
     }
 
-    /* Start the collection thread */
-    pthread_mutex_lock(&base->mutex);
-    rv = skthread_create(base->name, &base->thread, udp_reader, (void*)base);
-    if (rv != 0) {
-        pthread_mutex_unlock(&base->mutex);
-        WARNINGMSG("Unable to spawn new thread for '%s': %s",
-                   base->name, strerror(rv));
+    base->drops = ((struct udp_socket_drops_st*)
+                   calloc(pfd_len, sizeof(struct udp_socket_drops_st)));
+    base->readers = (udp_reader_t*)calloc(reader_count, sizeof(udp_reader_t));
+    if (NULL == base->drops || NULL == base->readers) {
         udpSourceDestroyBase(base);
         return NULL;
     }
 
-    /* Wait for the thread to finish initializing before returning. */
-    do {
+    /* Start the collection threads */
+    pthread_mutex_lock(&base->mutex);
+    for (k = 0; k < reader_count; ++k) {
+        reader = &base->readers[k];
+        reader->base = base;
+        reader->pfd_len = pfd_len / reader_count;
+        reader->pfd_offset = k * reader->pfd_len;
+        reader->pfd = &base->pfd[reader->pfd_offset];
+        for (i = 0; i < reader->pfd_len; ++i) {
+            if (reader->pfd[i].fd >= 0) {
+                ++reader->pfd_valid;
+            }
+        }
+        rv = skthread_create(base->name, &reader->thread, udp_reader,
+                             (void*)reader);
+        if (rv != 0) {
+            pthread_mutex_unlock(&base->mutex);
+            WARNINGMSG("Unable to spawn new thread for '%s': %s",
+                       base->name, strerror(rv));
+            udpSourceDestroyBase(base);
+            return NULL;
+        }
+        ++base->reader_count;
+    }
+
+    /* Wait for the threads to finish initializing before returning. */
+    while (base->started < base->reader_count) {
         pthread_cond_wait(&base->cond, &base->mutex);
-    } while (!base->started);
+    }
     pthread_mutex_unlock(&base->mutex);
 
     return base;
@@ -758,8 +1027,10 @@ udpSourceCreateFromSockaddr(
     skUDPSourceBase_t *base;
     skUDPSourceBase_t *cleanup_base = NULL;
     struct pollfd *pfd_array = NULL;
+    nfds_t pfd_len;
     nfds_t pfd_valid;
-    uint32_t i;
+    uint32_t socket_count;
+    nfds_t i;
     int rv;
     uint16_t arrayport;
     int retval = -1;
@@ -807,9 +1078,12 @@ udpSourceCreateFromSockaddr(
         }
     }
 
-    /* If not, attempt to bind the address/port pairs */
-    pfd_array = (struct pollfd*)calloc(skSockaddrArrayGetSize(listen_address),
-                                       sizeof(struct pollfd));
+    /* If not, attempt to bind the address/port pairs.  Open
+     * 'socket_count' sockets on each address; the sockets for the
+     * k'th reader thread begin at index k*size(listen_address). */
+    socket_count = udp_reader_socket_count();
+    pfd_len = socket_count * skSockaddrArrayGetSize(listen_address);
+    pfd_array = (struct pollfd*)calloc(pfd_len, sizeof(struct pollfd));
     if (pfd_array == NULL) {
         goto END;
     }
@@ -822,12 +1096,15 @@ udpSourceCreateFromSockaddr(
     DEBUGMSG(("Attempting to bind %" PRIu32 " addresses for %s"),
              skSockaddrArrayGetSize(listen_address),
              skSockaddrArrayGetHostPortPair(listen_address));
-    for (i = 0; i < skSockaddrArrayGetSize(listen_address); i++) {
+    for (i = 0; i < pfd_len; i++) {
         char addr_name[PATH_MAX];
         struct pollfd *pfd = &pfd_array[i];
         uint16_t port;
+        int optval = 1;
 
-        addr = skSockaddrArrayGet(listen_address, i);
+        pfd->fd = -1;
+        addr = skSockaddrArrayGet(listen_address,
+                                  i % skSockaddrArrayGetSize(listen_address));
 
         skSockaddrString(addr_name, sizeof(addr_name), addr);
 
@@ -838,6 +1115,28 @@ udpSourceCreateFromSockaddr(
                      addr_name, strerror(errno));
             continue;
         }
+#ifdef SO_REUSEPORT
+        /* Allow the other sockets of this source to bind the address */
+        if (socket_count > 1
+            && setsockopt(pfd->fd, SOL_SOCKET, SO_REUSEPORT,
+                          &optval, sizeof(optval)) == -1)
+        {
+            DEBUGMSG("Skipping %s: Unable to set SO_REUSEPORT: %s",
+                     addr_name, strerror(errno));
+            close(pfd->fd);
+            pfd->fd = -1;
+            continue;
+        }
+#endif  /* SO_REUSEPORT */
+#ifdef SO_RXQ_OVFL
+        /* Have the kernel report the number of dropped packets */
+        if (setsockopt(pfd->fd, SOL_SOCKET, SO_RXQ_OVFL,
+                       &optval, sizeof(optval)) == -1)
+        {
+            DEBUGMSG("Unable to set SO_RXQ_OVFL on %s: %s",
+                     addr_name, strerror(errno));
+        }
+#endif  /* SO_RXQ_OVFL */
         /* Bind socket to port */
         if (bind(pfd->fd, &addr->sa, skSockaddrGetLen(addr)) == -1) {
             DEBUGMSG("Skipping %s: Unable to bind: %s",
@@ -865,15 +1164,14 @@ udpSourceCreateFromSockaddr(
         goto END;
     }
 
-    DEBUGMSG(("Bound %" PRIu32 "/%" PRIu32 " addresses for %s"),
-             (uint32_t)pfd_valid, skSockaddrArrayGetSize(listen_address),
+    DEBUGMSG(("Bound %" PRIu32 "/%" PRIu32 " sockets for %s"),
+             (uint32_t)pfd_valid, (uint32_t)pfd_len,
              skSockaddrArrayGetHostPortPair(listen_address));
 
     assert(arrayport != 0);
     base = udpSourceCreateBase(skSockaddrArrayGetHostname(listen_address),
-                               arrayport, pfd_array,
-                               skSockaddrArrayGetSize(listen_address),
-                               pfd_valid, itemsize);
+                               arrayport, pfd_array, pfd_len, pfd_valid,
+                               socket_count, itemsize);
     if (base == NULL) {
         goto END;
     }
@@ -984,7 +1282,7 @@ udpSourceCreateFromUnixDomain(
     sock = -1;
 
     /* Create a base object */
-    base = udpSourceCreateBase(uds, 0, pfd_array, 1, 1, itemsize);
+    base = udpSourceCreateBase(uds, 0, pfd_array, 1, 1, 1, itemsize);
     if (base == NULL) {
         goto ERROR;
     }
@@ -1080,6 +1378,7 @@ skUDPSourceCreate(
     source->reject_pkt_fn = reject_pkt_fn;
     source->fn_callback_data = fn_callback_data;
     source->probe = probe;
+    pthread_mutex_init(&source->writer_mutex, NULL);
 
     if (NULL != skpcProbeGetPollDirectory(probe)
         || NULL != skpcProbeGetFileSource(probe))
@@ -1185,6 +1484,7 @@ skUDPSourceDestroy(
 
     if (NULL == base) {
         skCircBufDestroy(source->data_buffer);
+        pthread_mutex_destroy(&source->writer_mutex);
         free(source);
         return;
     }
@@ -1207,6 +1507,12 @@ skUDPSourceDestroy(
         }
     }
 
+    /* Wait for any udp_reader() threads that found the source before
+     * it stopped to finish copying packets into it */
+    while (source->writers) {
+        pthread_cond_wait(&base->cond, &base->mutex);
+    }
+
     /* Destroy the circular buffer */
     skCircBufDestroy(source->data_buffer);
 
@@ -1220,6 +1526,7 @@ skUDPSourceDestroy(
         pthread_mutex_unlock(&base->mutex);
     }
 
+    pthread_mutex_destroy(&source->writer_mutex);
     free(source);
 }
 
@@ -1287,6 +1594,54 @@ skUDPSourceNext(
     return data;
 }
 
+
+void
+skUDPSourceLogDrops(
+    skUDPSource_t      *source,
+    int                 clear)
+{
+#ifdef SO_RXQ_OVFL
+    skUDPSourceBase_t *base;
+    char buf[PATH_MAX];
+    size_t len;
+    uint64_t total;
+    uint32_t drops;
+    nfds_t i;
+
+    assert(source);
+    base = source->base;
+    if (NULL == base || base->file || NULL == base->drops) {
+        return;
+    }
+
+    /* Build a list of the drops on each socket, and compute the
+     * total */
+    buf[0] = '\0';
+    len = 0;
+    total = 0;
+    pthread_mutex_lock(&base->mutex);
+    for (i = 0; i < base->pfd_len; ++i) {
+        drops = base->drops[i].count - base->drops[i].cleared;
+        total += drops;
+        if (len < sizeof(buf)) {
+            len += snprintf(buf + len, sizeof(buf) - len, "%s%" PRIu32,
+                            ((0 == i) ? "" : ","), drops);
+        }
+        if (clear) {
+            base->drops[i].cleared = base->drops[i].count;
+        }
+    }
+    pthread_mutex_unlock(&base->mutex);
+
+    INFOMSG("'%s': Dropped %" PRIu64 " packets on %s sockets [%s]",
+            skpcProbeGetName(source->probe), total, base->name, buf);
+#else
+    SK_UNUSED_PARAM(source);
+    SK_UNUSED_PARAM(clear);
+#endif  /* SO_RXQ_OVFL */
+}
+
+
 /*
 ** Local Variables:
 ** mode:c
@@ -85,6 +85,24 @@ uint8_t *
 skUDPSourceNext(
     skUDPSource_t      *source);
 
+
+/**
+ *    Log the number of packets that the kernel dropped on each socket
+ *    the UDP Source reads from because the socket's receive buffer
+ *    was full.  The counts cover the time since they were last
+ *    cleared.  When 'clear' is non-zero, clear the counts after
+ *    logging them.
+ *
+ *    Sources that listen on the same address share the sockets, and
+ *    the counts include the packets destined for every such source.
+ *    Does nothing for file-based sources or when the operating system
+ *    does not report dropped packets.
+ */
+void
+skUDPSourceLogDrops(
+    skUDPSource_t      *source,
+    int                 clear);
+
 #ifdef __cplusplus
 }
 #endif
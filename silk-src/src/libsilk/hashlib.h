@@ -28,6 +28,9 @@ RCSIDENTVAR(rcsID_HASHLIB_H, "$SiLK: hashlib.h 275df62a2e41 2017-01-05 17:30:40Z
  *
  *    Implementation of a hashtable.
  *
+ *    A HashTable may be modified by only one thread at a time.  See
+ *    hashlib_sharded.h for a table that multiple threads may update.
+ *
  *    This file is part of libsilk.
  */
 
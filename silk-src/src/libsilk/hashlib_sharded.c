@@ -0,0 +1,713 @@
+/*
+** Copyright (C) 2017 by Carnegie Mellon University.
+**
+** @OPENSOURCE_LICENSE_START@
+** See license information in ../../LICENSE.txt
+** @OPENSOURCE_LICENSE_END@
+*/
+
+/*
+**  hashlib_sharded.c
+**
+**    A hash table that multiple threads may update concurrently.
+**
+**    The table is an array of shards.  The high bits of a key's hash
+**    select the shard, and the low bits select the bucket within the
+**    shard, which uses the same open addressing and double hashing as
+**    the blocks of a HashTable (see hashlib.c).
+**
+**    A HashTable grows by adding secondary blocks that every lookup
+**    must probe, and it occasionally stops to rehash all blocks into
+**    one.  A shard instead has a single block.  Once that block
+**    reaches the load factor, the shard allocates a block twice the
+**    size and, on each later insert into the shard, moves the entries
+**    from the next HASHLIB_SHARD_MIGRATE_STEP buckets of the old block
+**    into the new one.  The new block has room for as many entries
+**    again as the old block held, and the old block is drained long
+**    before that room is used, so at most two blocks exist at once.
+**
+**    An entry is never present in both blocks except during the
+**    instant after it has been copied: a key not found in the new
+**    block is searched for in the old block, and when it is found
+**    there it is updated in place (to be copied later); a key found
+**    in neither block is added to the new block.  Lookups search the
+**    new block first, so the copy in the new block is the one that is
+**    visible once an entry has been moved.  The old block's entries
+**    are not cleared as they are moved since doing so would break the
+**    probe sequences of the entries that remain.
+*/
+
+#include <silk/silk.h>
+
+RCSIDENT("$SiLK: hashlib_sharded.c $");
+
+#include <silk/hashlib_sharded.h>
+#include <silk/utils.h>
+
+
+/* LOCAL DEFINES AND TYPEDEFS */
+
+/*
+ *    The number of buckets of the old block whose entries are moved
+ *    to the new block on each insert while a shard is being resized.
+ *    Since an insert adds at most one entry and a block reaches the
+ *    load factor when it is 72% full, this must be at least 2 for
+ *    the old block to be drained before the new block fills.
+ */
+#define HASHLIB_SHARD_MIGRATE_STEP  16
+
+/*
+ *    The minimum number of entries in a shard's block.
+ */
+#define HASHLIB_SHARD_MIN_ENTRIES   (UINT64_C(1) << 8)
+
+/*
+ *    The maximum number of entries in a shard's block.  The hash
+ *    value is 32 bits, of which the high bits select the shard.
+ */
+#define HASHLIB_SHARD_MAX_ENTRIES   (UINT64_C(1) << 31)
+
+/* Distinguished values for block index in the iterator */
+#define HASH_ITER_BEGIN -1
+#define HASH_ITER_END -2
+
+
+/*
+ *    A block of buckets in a shard.
+ */
+typedef struct hash_shard_block_st {
+    /* Pointer to an array of variable-sized entries */
+    uint8_t            *data_ptr;
+    /* Total capacity of this block as a number of entries */
+    uint64_t            max_entries;
+} hash_shard_block_t;
+
+/*
+ *    A shard of the table.
+ */
+typedef struct hash_shard_st {
+    /* The block that receives new entries */
+    hash_shard_block_t  block;
+    /* The block being drained into 'block' during a resize; its
+     * 'data_ptr' is NULL when no resize is in progress */
+    hash_shard_block_t  old_block;
+    /* Index of the next bucket in 'old_block' to move */
+    uint64_t            migrate_index;
+    /* Number of unique keys in the shard */
+    uint64_t            num_entries;
+    /* Number of entries at which 'block' meets the load factor */
+    uint64_t            block_full;
+    /* Non-zero if growing the block has failed */
+    int                 grow_failed;
+    /* Protects the members of the shard */
+    pthread_mutex_t     mutex;
+} hash_shard_t;
+
+
+/* typedef struct HashShardedTable_st HashShardedTable; */
+struct HashShardedTable_st {
+    /**  The shards */
+    hash_shard_t       *shards;
+    /**  Pointer to representation of an empty value */
+    uint8_t            *no_value_ptr;
+    /**  Number of shards; a power of 2 */
+    uint32_t            num_shards;
+    /**  Number of bits to shift a hash value to get a shard index */
+    uint32_t            shard_shift;
+    /**  Storage size of a key in bytes */
+    uint8_t             key_len;
+    /**  Size of a value in bytes */
+    uint8_t             value_len;
+    /**  Point at which to resize (fraction of 255) */
+    uint8_t             load_factor;
+    /**  Non-zero if we can memset new memory to a value */
+    uint8_t             can_memset_val;
+};
+/* HashShardedTable */
+
+
+/* LOCAL FUNCTION PROTOTYPES */
+
+/* use the hash function defined in hashlib.c */
+#ifdef HASHLIB_LOOKUP2
+unsigned long
+hash(
+    const uint8_t      *k,
+    unsigned long       len,
+    unsigned long       initval);
+#else
+uint32_t
+hashlittle(
+    const void         *key,
+    size_t              length,
+    uint32_t            initval);
+uint32_t
+hashbig(
+    const void         *key,
+    size_t              length,
+    uint32_t            initval);
+#if SK_BIG_ENDIAN
+#  define hash  hashbig
+#else
+#  define hash  hashlittle
+#endif
+#endif  /* HASHLIB_LOOKUP2 */
+
+
+/* FUNCTION-LIKE MACROS */
+
+/*
+ *    Get number of bytes of storage required to hold an entry in the
+ *    HashShardedTable 'tbl_ptr'.
+ */
+#define HASH_GET_ENTRY_LEN(tbl_ptr)                     \
+    ((size_t)(tbl_ptr)->key_len + (tbl_ptr)->value_len)
+
+/*
+ *    Get a pointer to the entry at index 'hash_index' in the
+ *    hash_shard_block_t 'blk_ptr' of the HashShardedTable 'tbl_ptr'.
+ */
+#define HASH_ENTRY_AT(tbl_ptr, blk_ptr, hash_index)                     \
+    ((blk_ptr)->data_ptr + (HASH_GET_ENTRY_LEN(tbl_ptr) * (hash_index)))
+
+/*
+ *    Get a pointer to the value part of 'entry_ptr' in the
+ *    HashShardedTable 'tbl_ptr'.
+ */
+#define HASHENTRY_GET_VALUE(tbl_ptr, entry_ptr) \
+    ((entry_ptr) + (tbl_ptr)->key_len)
+
+/*
+ *    Return 1 if the value part of the entry at 'entry_ptr' matches
+ *    the empty value, otherwise 0.
+ */
+#define HASHENTRY_ISEMPTY(tbl_ptr, entry_ptr)                           \
+    (0 == memcmp(HASHENTRY_GET_VALUE(tbl_ptr, entry_ptr),               \
+                 (tbl_ptr)->no_value_ptr, (tbl_ptr)->value_len))
+
+/*
+ *    Return the shard of HashShardedTable 'tbl_ptr' that holds keys
+ *    whose hash is 'hash_value'.
+ */
+#define HASH_SHARD_FOR(tbl_ptr, hash_value)                             \
+    (&(tbl_ptr)->shards[((tbl_ptr)->num_shards == 1)                    \
+                        ? 0 : ((hash_value) >> (tbl_ptr)->shard_shift)])
+
+
+/* FUNCTION DEFINITIONS */
+
+/*
+ *  status = hashlib_shard_create_block(table_ptr, block_ptr, block_entries);
+ *
+ *    Allocate the data for the block 'block_ptr' of 'table_ptr' to
+ *    hold 'block_entries' entries, which must be a power of 2, and
+ *    set each entry to the empty value.  Return 0 on success or -1 on
+ *    allocation failure.
+ */
+static int
+hashlib_shard_create_block(
+    const HashShardedTable *table_ptr,
+    hash_shard_block_t     *block_ptr,
+    uint64_t                block_entries)
+{
+    uint64_t block_bytes;
+    uint8_t *data_ptr;
+    uint64_t i;
+
+    block_bytes = block_entries * (uint64_t)HASH_GET_ENTRY_LEN(table_ptr);
+#if SIZE_MAX < UINT64_MAX
+    /* verify we do not overflow the size of a size_t */
+    if (block_bytes > SIZE_MAX) {
+        return -1;
+    }
+#endif
+
+    block_ptr->data_ptr = (uint8_t*)malloc(block_bytes);
+    if (NULL == block_ptr->data_ptr) {
+        return -1;
+    }
+    block_ptr->max_entries = block_entries;
+
+    /* Copy "empty" value to each entry.  Garbage key values are
+     * ignored, so we don't bother writing to the keys. */
+    if (table_ptr->can_memset_val) {
+        memset(block_ptr->data_ptr, table_ptr->no_value_ptr[0], block_bytes);
+    } else {
+        for (i = 0, data_ptr = HASHENTRY_GET_VALUE(table_ptr,
+                                                   block_ptr->data_ptr);
+             i < block_entries;
+             ++i, data_ptr += HASH_GET_ENTRY_LEN(table_ptr))
+        {
+            memcpy(data_ptr, table_ptr->no_value_ptr, table_ptr->value_len);
+        }
+    }
+    return 0;
+}
+
+
+/*
+ *  status = hashlib_shard_find_entry(table_ptr, block_ptr, key_ptr,
+ *                                    hash_value, &entry_ptr);
+ *
+ *    Search the block 'block_ptr' of 'table_ptr' for 'key_ptr', whose
+ *    hash is 'hash_value'.  Set 'entry_ptr' to the entry and return
+ *    OK when found; otherwise set 'entry_ptr' to the empty bucket
+ *    where the key may be inserted and return ERR_NOTFOUND.
+ *
+ *    This uses the same probe sequence as hashlib_block_find_entry()
+ *    in hashlib.c.
+ */
+static int
+hashlib_shard_find_entry(
+    const HashShardedTable     *table_ptr,
+    const hash_shard_block_t   *block_ptr,
+    const uint8_t              *key_ptr,
+    uint32_t                    hash_value,
+    uint8_t                   **entry_pptr)
+{
+#ifndef NDEBUG
+    uint64_t num_tries = 0;
+#endif
+    const uint32_t hash_probe_increment = hash_value | 0x01;
+    const uint32_t mask = (uint32_t)block_ptr->max_entries - 1;
+
+    for (;;) {
+        *entry_pptr = HASH_ENTRY_AT(table_ptr, block_ptr, hash_value & mask);
+        if (HASHENTRY_ISEMPTY(table_ptr, *entry_pptr)) {
+            return ERR_NOTFOUND;
+        }
+        if (0 == memcmp(*entry_pptr, key_ptr, table_ptr->key_len)) {
+            return OK;
+        }
+        hash_value += hash_probe_increment;
+        assert(++num_tries < block_ptr->max_entries);
+    }
+}
+
+
+/*
+ *  hashlib_shard_migrate(table_ptr, shard, step);
+ *
+ *    Move the entries from the next 'step' buckets of the shard's old
+ *    block into its current block, and free the old block once every
+ *    bucket has been moved.  The caller must hold the shard's mutex
+ *    or otherwise have exclusive access to the shard.
+ */
+static void
+hashlib_shard_migrate(
+    const HashShardedTable *table_ptr,
+    hash_shard_t           *shard,
+    uint64_t                step)
+{
+    const size_t entry_len = HASH_GET_ENTRY_LEN(table_ptr);
+    uint8_t *old_entry;
+    uint8_t *new_entry;
+    uint64_t end;
+    int rv;
+
+    if (NULL == shard->old_block.data_ptr) {
+        return;
+    }
+
+    end = shard->migrate_index + step;
+    if (end > shard->old_block.max_entries) {
+        end = shard->old_block.max_entries;
+    }
+    for (old_entry = HASH_ENTRY_AT(table_ptr, &shard->old_block,
+                                   shard->migrate_index);
+         shard->migrate_index < end;
+         ++shard->migrate_index, old_entry += entry_len)
+    {
+        if (HASHENTRY_ISEMPTY(table_ptr, old_entry)) {
+            continue;
+        }
+        rv = hashlib_shard_find_entry(table_ptr, &shard->block, old_entry,
+                                      hash(old_entry, table_ptr->key_len, 0),
+                                      &new_entry);
+        if (ERR_NOTFOUND != rv) {
+            /* a key is added to the new block only when it is not in
+             * the old block, so either the hashlib code is broken or
+             * the caller set a value to the no_value_ptr value */
+            skAbort();
+        }
+        memcpy(new_entry, old_entry, entry_len);
+    }
+
+    if (shard->migrate_index == shard->old_block.max_entries) {
+        free(shard->old_block.data_ptr);
+        shard->old_block.data_ptr = NULL;
+        shard->old_block.max_entries = 0;
+        shard->migrate_index = 0;
+    }
+}
+
+
+/*
+ *  hashlib_shard_grow(table_ptr, shard);
+ *
+ *    Begin to resize 'shard' by replacing its block with one twice
+ *    the size; the entries in the existing block are moved to the
+ *    new block by later calls to hashlib_shard_migrate().  Do nothing
+ *    if the block is at its maximum size or the allocation fails.
+ *    The caller must hold the shard's mutex.
+ */
+static void
+hashlib_shard_grow(
+    const HashShardedTable *table_ptr,
+    hash_shard_t           *shard)
+{
+    hash_shard_block_t new_block;
+
+    /* a previous resize must be complete */
+    hashlib_shard_migrate(table_ptr, shard, shard->old_block.max_entries);
+
+    if (shard->block.max_entries >= HASHLIB_SHARD_MAX_ENTRIES
+        || hashlib_shard_create_block(table_ptr, &new_block,
+                                      shard->block.max_entries << 1))
+    {
+        shard->grow_failed = 1;
+        return;
+    }
+    shard->old_block = shard->block;
+    shard->migrate_index = 0;
+    shard->block = new_block;
+    shard->block_full = table_ptr->load_factor * (new_block.max_entries >> 8);
+}
+
+
+HashShardedTable *
+hashlib_sharded_create_table(
+    uint8_t             key_len,
+    uint8_t             value_len,
+    const uint8_t      *no_value_ptr,
+    uint64_t            estimated_count,
+    uint8_t             load_factor,
+    uint32_t            num_shards)
+{
+    HashShardedTable *table_ptr;
+    hash_shard_t *shard;
+    uint64_t shard_entries;
+    uint32_t shard_bits;
+    uint32_t i;
+
+    /* Validate arguments */
+    if (0 == key_len || 0 == value_len || 0 == load_factor
+        || num_shards > HASHLIB_MAX_SHARDS)
+    {
+        return NULL;
+    }
+    if (0 == num_shards) {
+        num_shards = 1;
+    }
+
+    /* round the shard count to a power of 2 */
+    shard_bits = skIntegerLog2(num_shards);
+    if ((UINT32_C(1) << shard_bits) < num_shards) {
+        ++shard_bits;
+    }
+    num_shards = UINT32_C(1) << shard_bits;
+
+    table_ptr = (HashShardedTable*)calloc(1, sizeof(HashShardedTable));
+    if (NULL == table_ptr) {
+        return NULL;
+    }
+    table_ptr->key_len = key_len;
+    table_ptr->value_len = value_len;
+    table_ptr->load_factor = load_factor;
+    table_ptr->num_shards = num_shards;
+    table_ptr->shard_shift = 32 - shard_bits;
+
+    /* Initialize no_value_ptr as hashlib_create_table() does */
+    table_ptr->no_value_ptr = (uint8_t*)calloc(value_len, sizeof(uint8_t));
+    if (NULL == table_ptr->no_value_ptr) {
+        free(table_ptr);
+        return NULL;
+    }
+    if (no_value_ptr == NULL) {
+        table_ptr->can_memset_val = 1;
+    } else {
+        memset(table_ptr->no_value_ptr, no_value_ptr[0], value_len);
+        if (memcmp(table_ptr->no_value_ptr, no_value_ptr, value_len)) {
+            table_ptr->can_memset_val = 0;
+            memcpy(table_ptr->no_value_ptr, no_value_ptr, value_len);
+        } else {
+            table_ptr->can_memset_val = 1;
+        }
+    }
+
+    table_ptr->shards = (hash_shard_t*)calloc(num_shards,
+                                              sizeof(hash_shard_t));
+    if (NULL == table_ptr->shards) {
+        free(table_ptr->no_value_ptr);
+        free(table_ptr);
+        return NULL;
+    }
+
+    /* Size each shard's block to hold its part of estimated_count
+     * below the load factor.  Clamp the count before shifting so the
+     * shift cannot overflow and skIntegerLog2() is never given 0. */
+    shard_entries = estimated_count / num_shards;
+    if (shard_entries < HASHLIB_SHARD_MIN_ENTRIES) {
+        shard_entries = HASHLIB_SHARD_MIN_ENTRIES;
+    } else if (shard_entries > HASHLIB_SHARD_MAX_ENTRIES) {
+        shard_entries = HASHLIB_SHARD_MAX_ENTRIES;
+    }
+    shard_entries = (shard_entries << 8) / load_factor;
+    shard_entries = UINT64_C(1) << (1 + skIntegerLog2(shard_entries));
+    if (shard_entries > HASHLIB_SHARD_MAX_ENTRIES) {
+        shard_entries = HASHLIB_SHARD_MAX_ENTRIES;
+    }
+
+    for (i = 0; i < num_shards; ++i) {
+        shard = &table_ptr->shards[i];
+        pthread_mutex_init(&shard->mutex, NULL);
+        if (hashlib_shard_create_block(table_ptr, &shard->block,
+                                       shard_entries))
+        {
+            table_ptr->num_shards = i + 1;
+            hashlib_sharded_free_table(table_ptr);
+            return NULL;
+        }
+        shard->block_full = load_factor * (shard_entries >> 8);
+    }
+
+    return table_ptr;
+}
+
+
+void
+hashlib_sharded_free_table(
+    HashShardedTable   *table_ptr)
+{
+    hash_shard_t *shard;
+    uint32_t i;
+
+    if (NULL == table_ptr) {
+        return;
+    }
+    for (i = 0; i < table_ptr->num_shards; ++i) {
+        shard = &table_ptr->shards[i];
+        free(shard->block.data_ptr);
+        free(shard->old_block.data_ptr);
+        pthread_mutex_destroy(&shard->mutex);
+    }
+    free(table_ptr->shards);
+    free(table_ptr->no_value_ptr);
+    free(table_ptr);
+}
+
+
+int
+hashlib_sharded_update(
+    HashShardedTable           *table_ptr,
+    const uint8_t              *key_ptr,
+    hashlib_sharded_update_fn   update_fn,
+    void                       *update_userdata)
+{
+    hash_shard_t *shard;
+    uint8_t *entry_ptr;
+    uint8_t *old_entry_ptr;
+    uint32_t hash_value;
+    int rv;
+
+    assert(table_ptr);
+    assert(update_fn);
+
+    hash_value = hash(key_ptr, table_ptr->key_len, 0);
+    shard = HASH_SHARD_FOR(table_ptr, hash_value);
+
+    pthread_mutex_lock(&shard->mutex);
+
+    /* Move part of the old block, if any */
+    hashlib_shard_migrate(table_ptr, shard, HASHLIB_SHARD_MIGRATE_STEP);
+
+    rv = hashlib_shard_find_entry(table_ptr, &shard->block, key_ptr,
+                                  hash_value, &entry_ptr);
+    if (OK != rv && shard->old_block.data_ptr
+        && OK == hashlib_shard_find_entry(table_ptr, &shard->old_block,
+                                          key_ptr, hash_value, &old_entry_ptr))
+    {
+        /* update the entry in place; it is moved later */
+        entry_ptr = old_entry_ptr;
+        rv = OK;
+    }
+    if (OK == rv) {
+        update_fn(HASHENTRY_GET_VALUE(table_ptr, entry_ptr), OK_DUPLICATE,
+                  update_userdata);
+        pthread_mutex_unlock(&shard->mutex);
+        return OK_DUPLICATE;
+    }
+
+    /* Add the key.  Grow the block first if adding the key would put
+     * it over the load factor. */
+    if (shard->num_entries >= shard->block_full && !shard->grow_failed) {
+        hashlib_shard_grow(table_ptr, shard);
+        /* the insertion point is in a different block, or finishing
+         * a previous resize may have filled it */
+        rv = hashlib_shard_find_entry(table_ptr, &shard->block, key_ptr,
+                                      hash_value, &entry_ptr);
+        assert(ERR_NOTFOUND == rv);
+    }
+    if (shard->num_entries + 1 >= shard->block.max_entries) {
+        /* the block could not be grown and is full */
+        pthread_mutex_unlock(&shard->mutex);
+        return ERR_OUTOFMEMORY;
+    }
+
+    memcpy(entry_ptr, key_ptr, table_ptr->key_len);
+    ++shard->num_entries;
+    update_fn(HASHENTRY_GET_VALUE(table_ptr, entry_ptr), OK,
+              update_userdata);
+    pthread_mutex_unlock(&shard->mutex);
+    return OK;
+}
+
+
+int
+hashlib_sharded_lookup(
+    HashShardedTable   *table_ptr,
+    const uint8_t      *key_ptr,
+    uint8_t            *value_ptr)
+{
+    hash_shard_t *shard;
+    uint8_t *entry_ptr;
+    uint32_t hash_value;
+    int rv;
+
+    assert(table_ptr);
+
+    hash_value = hash(key_ptr, table_ptr->key_len, 0);
+    shard = HASH_SHARD_FOR(table_ptr, hash_value);
+
+    pthread_mutex_lock(&shard->mutex);
+    rv = hashlib_shard_find_entry(table_ptr, &shard->block, key_ptr,
+                                  hash_value, &entry_ptr);
+    if (OK != rv && shard->old_block.data_ptr) {
+        rv = hashlib_shard_find_entry(table_ptr, &shard->old_block, key_ptr,
+                                      hash_value, &entry_ptr);
+    }
+    if (OK == rv) {
+        memcpy(value_ptr, HASHENTRY_GET_VALUE(table_ptr, entry_ptr),
+               table_ptr->value_len);
+    }
+    pthread_mutex_unlock(&shard->mutex);
+    return rv;
+}
+
+
+HASH_ITER
+hashlib_sharded_create_iterator(
+    HashShardedTable   *table_ptr)
+{
+    HASH_ITER iter;
+    hash_shard_t *shard;
+    uint32_t i;
+
+    /* finish any resize so each entry is in exactly one block */
+    for (i = 0; i < table_ptr->num_shards; ++i) {
+        shard = &table_ptr->shards[i];
+        pthread_mutex_lock(&shard->mutex);
+        hashlib_shard_migrate(table_ptr, shard, shard->old_block.max_entries);
+        pthread_mutex_unlock(&shard->mutex);
+    }
+
+    memset(&iter, 0, sizeof(HASH_ITER));
+    iter.block = HASH_ITER_BEGIN;
+    return iter;
+}
+
+
+int
+hashlib_sharded_iterate(
+    const HashShardedTable *table_ptr,
+    HASH_ITER              *iter_ptr,
+    uint8_t               **key_pptr,
+    uint8_t               **val_pptr)
+{
+    const hash_shard_block_t *block_ptr;
+    uint8_t *entry_ptr;
+
+    if (iter_ptr->block == HASH_ITER_END) {
+        return ERR_NOMOREENTRIES;
+    }
+
+    /* Start at the first entry in the first shard or increment the
+     * iterator to start looking at the next entry. */
+    if (iter_ptr->block == HASH_ITER_BEGIN) {
+        memset(iter_ptr, 0, sizeof(HASH_ITER));
+    } else {
+        ++iter_ptr->index;
+    }
+
+    /* Walk through the buckets of the current shard until we find a
+     * non-empty one.  Once we reach the end of the shard, move on to
+     * the next shard. */
+    while ((uint32_t)iter_ptr->block < table_ptr->num_shards) {
+        block_ptr = &table_ptr->shards[iter_ptr->block].block;
+        assert(NULL == table_ptr->shards[iter_ptr->block].old_block.data_ptr);
+
+        for (entry_ptr = HASH_ENTRY_AT(table_ptr, block_ptr, iter_ptr->index);
+             iter_ptr->index < block_ptr->max_entries;
+             ++iter_ptr->index, entry_ptr += HASH_GET_ENTRY_LEN(table_ptr))
+        {
+            if (!HASHENTRY_ISEMPTY(table_ptr, entry_ptr)) {
+                *key_pptr = entry_ptr;
+                *val_pptr = HASHENTRY_GET_VALUE(table_ptr, entry_ptr);
+                return OK;
+            }
+        }
+        ++iter_ptr->block;
+        iter_ptr->index = 0;
+    }
+
+    *key_pptr = NULL;
+    *val_pptr = NULL;
+    iter_ptr->block = HASH_ITER_END;
+    return ERR_NOMOREENTRIES;
+}
+
+
+uint32_t
+hashlib_sharded_count_shards(
+    const HashShardedTable *table_ptr)
+{
+    return table_ptr->num_shards;
+}
+
+
+uint64_t
+hashlib_sharded_count_buckets(
+    const HashShardedTable *table_ptr)
+{
+    uint64_t total = 0;
+    uint32_t i;
+
+    for (i = 0; i < table_ptr->num_shards; ++i) {
+        total += (table_ptr->shards[i].block.max_entries
+                  + table_ptr->shards[i].old_block.max_entries);
+    }
+    return total;
+}
+
+
+uint64_t
+hashlib_sharded_count_entries(
+    const HashShardedTable *table_ptr)
+{
+    uint64_t total = 0;
+    uint32_t i;
+
+    for (i = 0; i < table_ptr->num_shards; ++i) {
+        total += table_ptr->shards[i].num_entries;
+    }
+    return total;
+}
+
+
+/*
+** Local Variables:
+** mode:c
+** indent-tabs-mode:nil
+** c-basic-offset:4
+** End:
+*/
@@ -0,0 +1,245 @@
+/*
+** Copyright (C) 2017 by Carnegie Mellon University.
+**
+** @OPENSOURCE_LICENSE_START@
+** See license information in ../../LICENSE.txt
+** @OPENSOURCE_LICENSE_END@
+*/
+
+/*
+**  hashlib_sharded.h
+**
+**    Defines interface to a hash table that multiple threads may
+**    update concurrently.
+**
+*/
+
+#ifndef _HASHLIB_SHARDED_H
+#define _HASHLIB_SHARDED_H
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <silk/silk.h>
+
+RCSIDENTVAR(rcsID_HASHLIB_SHARDED_H, "$SiLK: hashlib_sharded.h $");
+
+#include <silk/hashlib.h>
+
+/**
+ *  @file
+ *
+ *    Implementation of a hashtable that is divided into shards, where
+ *    each shard is protected by its own mutex, allowing multiple
+ *    threads to insert into the table at once.
+ *
+ *    This file is part of libsilk-thrd.
+ *
+ *
+ *    The key and value widths, the "no value" representation, and
+ *    the return codes are the same as those of the HashTable defined
+ *    in hashlib.h.  The high bits of the hash of a key select the
+ *    shard that holds the key.
+ *
+ *    Each shard stores its entries in a single open-addressed block.
+ *    When a block reaches the load factor, the shard allocates a
+ *    block twice the size and moves a few entries from the old block
+ *    into the new block on each subsequent insert, so a lookup
+ *    examines at most two blocks and no single insert pays for
+ *    rehashing the entire shard.
+ *
+ *    Since other threads may modify the table, a caller never
+ *    receives a pointer into the table while the table is being
+ *    updated.  Instead, hashlib_sharded_update() invokes a callback
+ *    on the value while holding the lock on the shard.  Once all
+ *    updates are complete, the table may be iterated over by a
+ *    single thread.
+ */
+
+
+/**
+ *    The HashShardedTable structure.
+ */
+typedef struct HashShardedTable_st HashShardedTable;
+
+
+/**
+ *    Maximum number of shards a HashShardedTable may have.
+ */
+#define HASHLIB_MAX_SHARDS  256
+
+
+/**
+ *    Signature of a callback function used by
+ *    hashlib_sharded_update() to modify the value of an entry.
+ *
+ *    'value_ptr' is the value in the table associated with the key.
+ *    'status' is OK when the entry was newly added (and 'value_ptr'
+ *    holds the "no value" representation) or OK_DUPLICATE when the
+ *    entry already existed.  The function must not set the value to
+ *    the "no value" representation.
+ *
+ *    The 'update_userdata' parameter is a context pointer for the
+ *    function to use.
+ *
+ *    The function is called while the shard holding the entry is
+ *    locked, and it must not call any other function on the table.
+ */
+typedef void
+(*hashlib_sharded_update_fn)(
+    uint8_t            *value_ptr,
+    int                 status,
+    void               *update_userdata);
+
+
+/**
+ *    Creates a new sharded hash table.
+ *
+ *    Parameters:
+ *
+ *    key_width:      The width of a key in bytes.
+ *    value_width:    The width of a value in bytes
+ *    no_value_ptr:   A sequence of value_width bytes used to represent
+ *                    "no value" (i.e., an empty entry).  The hash table
+ *                    makes a copy of this value.  If 'no_value_ptr' is
+ *                    NULL, values will be initialized to all 0.
+ *    estimated_size: An estimate of the number of unique entries that will
+ *                    ultimately be inserted into the table.
+ *    load_factor:    As for hashlib_create_table().  Generally, simply
+ *                    use DEFAULT_LOAD_FACTOR here.
+ *    num_shards:     The number of shards.  This is rounded up to a
+ *                    power of 2 and must not be greater than
+ *                    HASHLIB_MAX_SHARDS.  A value of 0 is treated as 1.
+ *
+ *    Returns:
+ *
+ *    A pointer to the new table.
+ *    Will return NULL in the case of a memory allocation error or an
+ *    invalid argument.
+ */
+HashShardedTable *
+hashlib_sharded_create_table(
+    uint8_t             key_width,
+    uint8_t             value_width,
+    const uint8_t      *no_value_ptr,
+    uint64_t            estimated_size,
+    uint8_t             load_factor,
+    uint32_t            num_shards);
+
+
+/**
+ *    Frees the memory associated with a table.  Does nothing if
+ *    'table_ptr' is NULL.
+ */
+void
+hashlib_sharded_free_table(
+    HashShardedTable   *table_ptr);
+
+
+/**
+ *    Finds the entry for the key 'key_ptr' in the table, adding it
+ *    when it does not exist, and calls 'update_fn' with a pointer to
+ *    the entry's value, the status described below, and
+ *    'update_userdata'.  This function may be called by multiple
+ *    threads at once.
+ *
+ *    Returns:
+ *
+ *    OK in the case when a new entry has been added successfully,
+ *
+ *    OK_DUPLICATE if an entry with the given key already exists.
+ *
+ *    ERR_OUTOFMEMORY in the case of a memory allocation failure; the
+ *    callback is not invoked.
+ */
+int
+hashlib_sharded_update(
+    HashShardedTable           *table_ptr,
+    const uint8_t              *key_ptr,
+    hashlib_sharded_update_fn   update_fn,
+    void                       *update_userdata);
+
+
+/**
+ *    Looks up an entry with the given key in the hash table and
+ *    copies its value into the value_width bytes at 'value_ptr'.
+ *    When no entry has the given key, 'value_ptr' is untouched.  This
+ *    function may be called by multiple threads at once.
+ *
+ *    Returns:
+ *
+ *    OK if the entry exists.
+ *
+ *    ERR_NOTFOUND if the entry does not exist in the table.
+ */
+int
+hashlib_sharded_lookup(
+    HashShardedTable   *table_ptr,
+    const uint8_t      *key_ptr,
+    uint8_t            *value_ptr);
+
+
+/**
+ *    Completes any resize that is in progress and creates an iterator
+ *    to use in subsequent calls to hashlib_sharded_iterate().  The
+ *    table must not be modified while iterating over it.
+ */
+HASH_ITER
+hashlib_sharded_create_iterator(
+    HashShardedTable   *table_ptr);
+
+
+/**
+ *    Retrieves next available entry during iteration, as described
+ *    for hashlib_iterate().
+ *
+ *    Returns:
+ *
+ *    OK until the end of the table is reached.
+ *
+ *    ERR_NOMOREENTRIES to indicate the iterator has visited all entries.
+ */
+int
+hashlib_sharded_iterate(
+    const HashShardedTable *table_ptr,
+    HASH_ITER              *iter_ptr,
+    uint8_t               **key_pptr,
+    uint8_t               **val_pptr);
+
+
+/**
+ *    Returns the number of shards in the table.
+ */
+uint32_t
+hashlib_sharded_count_shards(
+    const HashShardedTable *table_ptr);
+
+
+/**
+ *    Returns the total number of buckets that have been allocated.
+ */
+uint64_t
+hashlib_sharded_count_buckets(
+    const HashShardedTable *table_ptr);
+
+
+/**
+ *    Returns the total number of entries in the table.
+ */
+uint64_t
+hashlib_sharded_count_entries(
+    const HashShardedTable *table_ptr);
+
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* _HASHLIB_SHARDED_H */
+
+/*
+** Local Variables:
+** mode:c
+** indent-tabs-mode:nil
+** c-basic-offset:4
+** End:
+*/
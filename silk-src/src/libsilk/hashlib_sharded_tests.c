@@ -0,0 +1,203 @@
+/*
+** Copyright (C) 2017 by Carnegie Mellon University.
+**
+** @OPENSOURCE_LICENSE_START@
+** See license information in ../../LICENSE.txt
+** @OPENSOURCE_LICENSE_END@
+*/
+
+/* File: hashlib_sharded_tests.c: regression testing application for
+ * the sharded hash table
+ *
+ * Several threads insert overlapping ranges of keys into a table that
+ * starts small, so that every shard is resized many times while
+ * other threads are inserting.
+ */
+#undef NDEBUG
+
+#include <silk/silk.h>
+
+RCSIDENT("$SiLK: hashlib_sharded_tests.c $");
+
+#include <silk/hashlib_sharded.h>
+
+
+/* number of threads inserting into the table */
+#define TEST_THREADS  4
+
+/* number of distinct keys */
+#define TEST_MAX_KEY  400000
+
+/* each thread inserts the keys from its start to TEST_MAX_KEY, where
+ * thread N starts at N*TEST_KEY_OFFSET+1 */
+#define TEST_KEY_OFFSET  50000
+
+
+static HashShardedTable *table;
+
+
+/*
+ *    Callback for hashlib_sharded_update() that increments the
+ *    counter in the value.
+ */
+static void
+count_key(
+    uint8_t            *value_ptr,
+    int                 status,
+    void        UNUSED(*userdata))
+{
+    uint32_t value;
+
+    if (OK == status) {
+        value = 1;
+    } else {
+        memcpy(&value, value_ptr, sizeof(value));
+        ++value;
+    }
+    memcpy(value_ptr, &value, sizeof(value));
+}
+
+
+static void *
+insert_keys(
+    void               *v_thread_num)
+{
+    uint32_t thread_num = *(uint32_t*)v_thread_num;
+    uint32_t key;
+    int rv;
+
+    for (key = 1 + thread_num * TEST_KEY_OFFSET; key <= TEST_MAX_KEY; ++key) {
+        rv = hashlib_sharded_update(table, (uint8_t*)&key, count_key, NULL);
+        assert(OK == rv || OK_DUPLICATE == rv);
+    }
+    return NULL;
+}
+
+
+/*
+ *    Return the number of times 'key' should have been inserted.
+ */
+static uint32_t
+expected_count(
+    uint32_t            key)
+{
+    uint32_t n = (key - 1) / TEST_KEY_OFFSET + 1;
+
+    return ((n < TEST_THREADS) ? n : TEST_THREADS);
+}
+
+
+int main(
+    int          UNUSED(argc),
+    char       UNUSED(**argv))
+{
+    pthread_t threads[TEST_THREADS];
+    uint32_t thread_num[TEST_THREADS];
+    uint32_t no_value = 0;
+    HASH_ITER iter;
+    uint32_t *key_ref;
+    uint32_t *val_ref;
+    uint32_t num_found;
+    uint32_t key;
+    uint32_t value;
+    uint32_t i;
+
+    fprintf(stdout, "Starting regression testing\n");
+    printf("\n--- Testing sharded hash table\n");
+
+    table = hashlib_sharded_create_table(sizeof(key), sizeof(value),
+                                         (uint8_t*)&no_value, 1000,
+                                         DEFAULT_LOAD_FACTOR, 8);
+    assert(table);
+    assert(8 == hashlib_sharded_count_shards(table));
+
+    for (i = 0; i < TEST_THREADS; ++i) {
+        thread_num[i] = i;
+        pthread_create(&threads[i], NULL, insert_keys, &thread_num[i]);
+    }
+    for (i = 0; i < TEST_THREADS; ++i) {
+        pthread_join(threads[i], NULL);
+    }
+
+    if (hashlib_sharded_count_entries(table) != TEST_MAX_KEY) {
+        printf("****Incorrect number of entries: %" PRIu64 " != %u\n",
+               hashlib_sharded_count_entries(table), TEST_MAX_KEY);
+        exit(EXIT_FAILURE);
+    }
+    printf("Insert test PASSED.\n");
+
+    printf("Testing lookup\n");
+    for (key = 1; key <= TEST_MAX_KEY; ++key) {
+        if (hashlib_sharded_lookup(table, (uint8_t*)&key, (uint8_t*)&value)
+            != OK)
+        {
+            printf("****Key %u not found\n", key);
+            exit(EXIT_FAILURE);
+        }
+        if (value != expected_count(key)) {
+            printf("****Incorrect value for %u: %u != %u\n",
+                   key, value, expected_count(key));
+            exit(EXIT_FAILURE);
+        }
+    }
+    key = TEST_MAX_KEY + 1;
+    if (hashlib_sharded_lookup(table, (uint8_t*)&key, (uint8_t*)&value)
+        != ERR_NOTFOUND)
+    {
+        printf("****Found key %u that was never inserted\n", key);
+        exit(EXIT_FAILURE);
+    }
+    printf("Lookup test PASSED.\n");
+
+    printf("Testing iteration\n");
+    num_found = 0;
+    iter = hashlib_sharded_create_iterator(table);
+    while (hashlib_sharded_iterate(table, &iter, (uint8_t**)&key_ref,
+                                   (uint8_t**)&val_ref)
+           != ERR_NOMOREENTRIES)
+    {
+        ++num_found;
+        if (*key_ref < 1 || *key_ref > TEST_MAX_KEY
+            || *val_ref != expected_count(*key_ref))
+        {
+            printf("****Incorrect entry %u --> %u\n", *key_ref, *val_ref);
+            exit(EXIT_FAILURE);
+        }
+    }
+    if (num_found != TEST_MAX_KEY) {
+        printf("Iteration failed.  Expected %d entries, found %d\n",
+               TEST_MAX_KEY, num_found);
+        exit(EXIT_FAILURE);
+    }
+    printf("Iteration test PASSED.\n");
+
+    hashlib_sharded_free_table(table);
+
+    printf("Testing zero estimated count\n");
+    table = hashlib_sharded_create_table(sizeof(key), sizeof(value),
+                                         (uint8_t*)&no_value, 0,
+                                         DEFAULT_LOAD_FACTOR, 1);
+    assert(table);
+    insert_keys(&thread_num[0]);
+    if (hashlib_sharded_count_entries(table) != TEST_MAX_KEY) {
+        printf("****Incorrect number of entries: %" PRIu64 " != %u\n",
+               hashlib_sharded_count_entries(table), TEST_MAX_KEY);
+        exit(EXIT_FAILURE);
+    }
+    hashlib_sharded_free_table(table);
+    printf("Zero estimated count test PASSED.\n");
+
+    /* If we reached this point, all tests were successful */
+    fprintf(stdout, "\nAll tests completed successfully.\n");
+
+    return 0;
+}
+
+
+/*
+** Local Variables:
+** mode:c
+** indent-tabs-mode:nil
+** c-basic-offset:4
+** End:
+*/
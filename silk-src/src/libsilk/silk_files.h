@@ -58,12 +58,24 @@ RCSIDENTVAR(rcsID_SILK_FILES_H, "$SiLK: silk_files.h 7e6884832fbd 2017-01-20 22:
  */
 #define SK_COMPMETHOD_SNAPPY    3
 
+/**
+ *    Use Zstandard compression.
+ */
+#define SK_COMPMETHOD_ZSTD      4
+
+/**
+ *    Use LZ4 compression.
+ */
+#define SK_COMPMETHOD_LZ4       5
+
 #ifdef SKCOMPMETHOD_SOURCE
 static const char *sk_compmethod_names[] = {
     "none",
     "zlib",
     "lzo1x",
     "snappy",
+    "zstd",
+    "lz4",
     ""
 };
 #endif /* SKCOMPMETHOD_SOURCE */
@@ -81,6 +93,7 @@ static const char *sk_compmethod_names[] = {
 /**
  *    Use the "best" compression method.  This is lzo1x if available,
  *    else snappy if available, else zlib if available, else none.
+ *    Zstandard and LZ4 are only used when requested explicitly.
  */
 #define SK_COMPMETHOD_BEST    254
 
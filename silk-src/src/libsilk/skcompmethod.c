@@ -173,6 +173,12 @@ skCompMethodCheck(
 #endif
 #if SK_ENABLE_SNAPPY
       case SK_COMPMETHOD_SNAPPY:
+#endif
+#if SK_ENABLE_ZSTD
+      case SK_COMPMETHOD_ZSTD:
+#endif
+#if SK_ENABLE_LZ4
+      case SK_COMPMETHOD_LZ4:
 #endif
         return SK_COMPMETHOD_IS_AVAIL;
     }
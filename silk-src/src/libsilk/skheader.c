@@ -758,6 +758,12 @@ skHeaderInitialize(
                                &skHentryProbenameCopy,
                                &skHentryProbenameFree,
                                &skHentryProbenamePrint);
+    rv |= skHentryTypeRegister(SK_HENTRY_BLOCKINDEX_ID,
+                               &skHentryBlockindexPacker,
+                               &skHentryBlockindexUnpacker,
+                               &skHentryBlockindexCopy,
+                               &skHentryBlockindexFree,
+                               &skHentryBlockindexPrint);
     /* defined in skprefixmap.c */
     rv |= skPrefixMapRegisterHeaderEntry(SK_HENTRY_PREFIXMAP_ID);
     /* defined in skbag.c */
@@ -2638,6 +2644,146 @@ skHentryProbenameUnpacker(
 
 
 
+/*
+ *
+ *  Block Index
+ *
+ */
+
+
+int
+skHeaderAddBlockindex(
+    sk_file_header_t   *hdr)
+{
+    int rv;
+    sk_header_entry_t *bi_hdr;
+
+    bi_hdr = skHentryBlockindexCreate(1);
+    if (bi_hdr == NULL) {
+        return SKHEADER_ERR_ALLOC;
+    }
+
+    rv = skHeaderAddEntry(hdr, bi_hdr);
+    if (rv) {
+        skHentryBlockindexFree(bi_hdr);
+    }
+    return rv;
+}
+
+
+sk_header_entry_t *
+skHentryBlockindexCopy(
+    const sk_header_entry_t    *hentry)
+{
+    const sk_hentry_blockindex_t *bi_hdr = (sk_hentry_blockindex_t*)hentry;
+
+    assert(hentry);
+    return skHentryBlockindexCreate(skHentryBlockindexGetVersion(bi_hdr));
+}
+
+
+sk_header_entry_t *
+skHentryBlockindexCreate(
+    uint32_t            version)
+{
+    sk_hentry_blockindex_t *bi_hdr;
+
+    bi_hdr = ((sk_hentry_blockindex_t*)
+              calloc(1, sizeof(sk_hentry_blockindex_t)));
+    if (NULL == bi_hdr) {
+        return NULL;
+    }
+
+    bi_hdr->he_spec.hes_id  = SK_HENTRY_BLOCKINDEX_ID;
+    bi_hdr->he_spec.hes_len = sizeof(sk_hentry_blockindex_t);
+    bi_hdr->version         = version;
+
+    return (sk_header_entry_t*)bi_hdr;
+}
+
+
+void
+skHentryBlockindexFree(
+    sk_header_entry_t  *hentry)
+{
+    /* allocated in a single block */
+    if (hentry) {
+        assert(skHeaderEntryGetTypeId(hentry) == SK_HENTRY_BLOCKINDEX_ID);
+        hentry->he_spec.hes_id = UINT32_MAX;
+        free(hentry);
+    }
+}
+
+
+ssize_t
+skHentryBlockindexPacker(
+    const sk_header_entry_t    *in_hentry,
+    uint8_t                    *out_packed,
+    size_t                      bufsize)
+{
+    sk_hentry_blockindex_t *bi_hdr = (sk_hentry_blockindex_t*)in_hentry;
+    sk_hentry_blockindex_t tmp_hdr;
+
+    assert(bi_hdr);
+    assert(out_packed);
+    assert(skHeaderEntryGetTypeId(bi_hdr) == SK_HENTRY_BLOCKINDEX_ID);
+
+    if (bufsize >= sizeof(sk_hentry_blockindex_t)) {
+        SK_HENTRY_SPEC_PACK(&tmp_hdr, &(bi_hdr->he_spec));
+        tmp_hdr.version = htonl(bi_hdr->version);
+
+        memcpy(out_packed, &tmp_hdr, sizeof(sk_hentry_blockindex_t));
+    }
+
+    return sizeof(sk_hentry_blockindex_t);
+}
+
+
+void
+skHentryBlockindexPrint(
+    const sk_header_entry_t    *hentry,
+    FILE                       *fh)
+{
+    sk_hentry_blockindex_t *bi_hdr = (sk_hentry_blockindex_t*)hentry;
+
+    assert(skHeaderEntryGetTypeId(bi_hdr) == SK_HENTRY_BLOCKINDEX_ID);
+    fprintf(fh, "v%" PRIu32, skHentryBlockindexGetVersion(bi_hdr));
+}
+
+
+sk_header_entry_t *
+skHentryBlockindexUnpacker(
+    uint8_t            *in_packed)
+{
+    sk_hentry_blockindex_t *bi_hdr;
+
+    assert(in_packed);
+
+    /* create space for new header */
+    bi_hdr = ((sk_hentry_blockindex_t*)
+              calloc(1, sizeof(sk_hentry_blockindex_t)));
+    if (NULL == bi_hdr) {
+        return NULL;
+    }
+
+    /* copy the spec */
+    SK_HENTRY_SPEC_UNPACK(&(bi_hdr->he_spec), in_packed);
+    assert(skHeaderEntryGetTypeId(bi_hdr) == SK_HENTRY_BLOCKINDEX_ID);
+
+    /* copy the data */
+    if (bi_hdr->he_spec.hes_len != sizeof(sk_hentry_blockindex_t)) {
+        free(bi_hdr);
+        return NULL;
+    }
+    memcpy(&(bi_hdr->version), &(in_packed[sizeof(sk_header_entry_spec_t)]),
+           sizeof(sk_hentry_blockindex_t)-sizeof(sk_header_entry_spec_t));
+    bi_hdr->version = ntohl(bi_hdr->version);
+
+    return (sk_header_entry_t*)bi_hdr;
+}
+
+
+
 /*
 ** Local Variables:
 ** mode:c
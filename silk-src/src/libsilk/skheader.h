@@ -1003,6 +1003,59 @@ skHentryProbenameUnpacker(
 
 
 
+/*
+ *    **********************************************************************
+ *
+ *    The 'blockindex' header entry type marks a SiLK Flow file whose
+ *    compressed blocks are followed by an index that summarizes the
+ *    records in each block.  See sk_block_zone_t in skstream.h.
+ *
+ *    **********************************************************************
+ */
+
+#define SK_HENTRY_BLOCKINDEX_ID     9
+
+typedef struct sk_hentry_blockindex_st {
+    sk_header_entry_spec_t  he_spec;
+    uint32_t                version;
+} sk_hentry_blockindex_t;
+
+int
+skHeaderAddBlockindex(
+    sk_file_header_t   *hdr);
+
+sk_header_entry_t *
+skHentryBlockindexCopy(
+    const sk_header_entry_t    *hentry);
+
+sk_header_entry_t *
+skHentryBlockindexCreate(
+    uint32_t            version);
+
+void
+skHentryBlockindexFree(
+    sk_header_entry_t  *hentry);
+
+ssize_t
+skHentryBlockindexPacker(
+    const sk_header_entry_t    *in_hentry,
+    uint8_t                    *out_packed,
+    size_t                      bufsize);
+
+void
+skHentryBlockindexPrint(
+    const sk_header_entry_t    *hentry,
+    FILE                       *fh);
+
+sk_header_entry_t *
+skHentryBlockindexUnpacker(
+    uint8_t            *in_packed);
+
+#define skHentryBlockindexGetVersion(hentry)    \
+    ((hentry)->version)
+
+
+
 #ifdef __cplusplus
 }
 #endif
@@ -92,29 +92,31 @@ delete_test_data(
     free(name);
 }
 
-static void
-test(
+/*
+ *    Write 'numrecs' records of size 'recsize' from 'data' to a new
+ *    temporary file using compression 'method' and 'blocksize'.  Put
+ *    the name of the file in 'filename' and return a descriptor open
+ *    on the file and positioned at its start.
+ */
+static int
+write_test_file(
+    char              **filename,
     int                 method,
     char               *data,
     unsigned            recsize,
     unsigned            numrecs,
-    uint32_t            blocksize,
-    unsigned            skipafter,
-    unsigned            skipfor)
+    uint32_t            blocksize)
 {
     char *name = strdup("/tmp/skiobuf-test.XXXXXX");
     int fd;
     sk_iobuf_t *buf = NULL;
     int rv;
     off_t ov;
-    unsigned i, j;
-    unsigned skip;
+    unsigned i;
     char *p;
     uint32_t i32;
     ssize_t out;
     off_t off;
-    char c;
-    int skipping;
 
     fd = mkstemp(name);
     if (fd == -1) {
@@ -174,6 +176,24 @@ test(
         FAIL;
     }
 
+    *filename = name;
+    return fd;
+}
+
+
+/*
+ *    Open an IO buffer to read the file on 'fd' that was written with
+ *    compression 'method', reading 'readahead' blocks ahead.
+ */
+static sk_iobuf_t *
+open_test_reader(
+    int                 fd,
+    int                 method,
+    uint32_t            readahead)
+{
+    sk_iobuf_t *buf;
+    int rv;
+
     buf = skIOBufCreate(SK_IO_READ);
     if (buf == NULL) {
         FAIL;
@@ -184,6 +204,39 @@ test(
         FAIL;
     }
 
+    rv = skIOBufSetReadAhead(buf, readahead);
+    if (rv == -1) {
+        FAIL;
+    }
+
+    return buf;
+}
+
+
+static void
+test(
+    int                 method,
+    char               *data,
+    unsigned            recsize,
+    unsigned            numrecs,
+    uint32_t            blocksize,
+    unsigned            skipafter,
+    unsigned            skipfor,
+    uint32_t            readahead)
+{
+    char *name;
+    int fd;
+    sk_iobuf_t *buf = NULL;
+    unsigned i, j;
+    unsigned skip;
+    char *p;
+    ssize_t out;
+    char c;
+    int skipping;
+
+    fd = write_test_file(&name, method, data, recsize, numrecs, blocksize);
+    buf = open_test_reader(fd, method, readahead);
+
     p = data;
     skip = 1;
     skipping = 0;
@@ -230,6 +283,95 @@ test(
     free(name);
 }
 
+
+/*
+ *    Read a few records while the read-ahead thread has blocks
+ *    queued, then destroy the IO buffer.
+ */
+static void
+test_early_destroy(
+    int                 method,
+    char               *data,
+    unsigned            recsize,
+    unsigned            numrecs,
+    uint32_t            blocksize,
+    uint32_t            readahead)
+{
+    char *name;
+    int fd;
+    sk_iobuf_t *buf;
+    ssize_t out;
+    char c;
+
+    fd = write_test_file(&name, method, data, recsize, numrecs, blocksize);
+    buf = open_test_reader(fd, method, readahead);
+
+    out = skIOBufRead(buf, &c, 1);
+    if (out != 1 || c != *data) {
+        FAIL;
+    }
+
+    skIOBufDestroy(buf);
+
+    close(fd);
+
+    unlink(name);
+    free(name);
+}
+
+
+/*
+ *    Cut the final block of a compressed file short and check that
+ *    reading it reports an error instead of end of file.
+ */
+static void
+test_truncated(
+    int                 method,
+    char               *data,
+    unsigned            recsize,
+    unsigned            numrecs,
+    uint32_t            blocksize,
+    uint32_t            readahead)
+{
+    char *name;
+    int fd;
+    sk_iobuf_t *buf;
+    struct stat st;
+    ssize_t out;
+    size_t total;
+    char c[64];
+
+    fd = write_test_file(&name, method, data, recsize, numrecs, blocksize);
+
+    /* remove the end-of-file marker and part of the final block */
+    if (fstat(fd, &st) == -1) {
+        FAIL;
+    }
+    if (ftruncate(fd, st.st_size - 2 * sizeof(uint32_t) - 1) == -1) {
+        FAIL;
+    }
+
+    buf = open_test_reader(fd, method, readahead);
+
+    total = 0;
+    do {
+        out = skIOBufRead(buf, c, sizeof(c));
+        if (out > 0) {
+            total += out;
+        }
+    } while (out > 0);
+    if (out != -1 || total >= (size_t)recsize * numrecs) {
+        FAIL;
+    }
+
+    skIOBufDestroy(buf);
+
+    close(fd);
+
+    unlink(name);
+    free(name);
+}
+
 int main()
 {
     char *testfname;
@@ -239,17 +381,53 @@ int main()
     testfile = create_test_data(&testfname, 10, 100000);
 
     test(SK_COMPMETHOD_NONE, testfile, 10, 100000, SKIOBUF_DEFAULT_BLOCKSIZE,
-         0, 0);
-    test(SK_COMPMETHOD_NONE, testfile, 10, 100000, 100, 50, 200);
+         0, 0, 0);
+    test(SK_COMPMETHOD_NONE, testfile, 10, 100000, 100, 50, 200, 0);
+    test(SK_COMPMETHOD_NONE, testfile, 10, 100000, 100, 50, 200, 4);
+    test_early_destroy(SK_COMPMETHOD_NONE, testfile, 10, 100000, 100, 4);
 #if SK_ENABLE_ZLIB
     test(SK_COMPMETHOD_ZLIB, testfile, 10, 100000, SKIOBUF_DEFAULT_BLOCKSIZE,
-         0, 0);
-    test(SK_COMPMETHOD_ZLIB, testfile, 10, 100000, 100, 50, 200);
+         0, 0, 0);
+    test(SK_COMPMETHOD_ZLIB, testfile, 10, 100000, 100, 50, 200, 0);
+    test(SK_COMPMETHOD_ZLIB, testfile, 10, 100000, SKIOBUF_DEFAULT_BLOCKSIZE,
+         0, 0, 4);
+    test(SK_COMPMETHOD_ZLIB, testfile, 10, 100000, 100, 50, 200, 4);
+    test_early_destroy(SK_COMPMETHOD_ZLIB, testfile, 10, 100000, 100, 4);
+    test_truncated(SK_COMPMETHOD_ZLIB, testfile, 10, 100000, 100, 0);
+    test_truncated(SK_COMPMETHOD_ZLIB, testfile, 10, 100000, 100, 4);
 #endif
 #if SK_ENABLE_LZO
     test(SK_COMPMETHOD_LZO1X, testfile, 10, 100000, SKIOBUF_DEFAULT_BLOCKSIZE,
-         0, 0);
-    test(SK_COMPMETHOD_LZO1X, testfile, 10, 100000, 100, 50, 200);
+         0, 0, 0);
+    test(SK_COMPMETHOD_LZO1X, testfile, 10, 100000, 100, 50, 200, 0);
+    test(SK_COMPMETHOD_LZO1X, testfile, 10, 100000, SKIOBUF_DEFAULT_BLOCKSIZE,
+         0, 0, 4);
+    test(SK_COMPMETHOD_LZO1X, testfile, 10, 100000, 100, 50, 200, 4);
+    test_early_destroy(SK_COMPMETHOD_LZO1X, testfile, 10, 100000, 100, 4);
+    test_truncated(SK_COMPMETHOD_LZO1X, testfile, 10, 100000, 100, 0);
+    test_truncated(SK_COMPMETHOD_LZO1X, testfile, 10, 100000, 100, 4);
+#endif
+#if SK_ENABLE_ZSTD
+    test(SK_COMPMETHOD_ZSTD, testfile, 10, 100000, SKIOBUF_DEFAULT_BLOCKSIZE,
+         0, 0, 0);
+    test(SK_COMPMETHOD_ZSTD, testfile, 10, 100000, 100, 50, 200, 0);
+    test(SK_COMPMETHOD_ZSTD, testfile, 10, 100000, SKIOBUF_DEFAULT_BLOCKSIZE,
+         0, 0, 4);
+    test(SK_COMPMETHOD_ZSTD, testfile, 10, 100000, 100, 50, 200, 4);
+    test_early_destroy(SK_COMPMETHOD_ZSTD, testfile, 10, 100000, 100, 4);
+    test_truncated(SK_COMPMETHOD_ZSTD, testfile, 10, 100000, 100, 0);
+    test_truncated(SK_COMPMETHOD_ZSTD, testfile, 10, 100000, 100, 4);
+#endif
+#if SK_ENABLE_LZ4
+    test(SK_COMPMETHOD_LZ4, testfile, 10, 100000, SKIOBUF_DEFAULT_BLOCKSIZE,
+         0, 0, 0);
+    test(SK_COMPMETHOD_LZ4, testfile, 10, 100000, 100, 50, 200, 0);
+    test(SK_COMPMETHOD_LZ4, testfile, 10, 100000, SKIOBUF_DEFAULT_BLOCKSIZE,
+         0, 0, 4);
+    test(SK_COMPMETHOD_LZ4, testfile, 10, 100000, 100, 50, 200, 4);
+    test_early_destroy(SK_COMPMETHOD_LZ4, testfile, 10, 100000, 100, 4);
+    test_truncated(SK_COMPMETHOD_LZ4, testfile, 10, 100000, 100, 0);
+    test_truncated(SK_COMPMETHOD_LZ4, testfile, 10, 100000, 100, 4);
 #endif
 
     delete_test_data(testfname, testfile, 10, 100000);
@@ -23,6 +23,12 @@ SK_DIAGNOSTIC_IGNORE_PUSH("-Wundef")
 #if SK_ENABLE_SNAPPY
 #include <snappy-c.h>
 #endif
+#if SK_ENABLE_ZSTD
+#include <zstd.h>
+#endif
+#if SK_ENABLE_LZ4
+#include <lz4.h>
+#endif
 #if SK_ENABLE_LZO
 #include SK_LZO_HEADER_NAME
 #endif
@@ -77,6 +83,22 @@ typedef union iobuf_opts_un {
     } lzo;
 #endif  /* SK_ENABLE_LZO */
 
+#if SK_ENABLE_ZSTD
+    /* zstd */
+    struct {
+        ZSTD_CCtx *cctx;
+        ZSTD_DCtx *dctx;
+        int level;
+    } zstd;
+#endif  /* SK_ENABLE_ZSTD */
+
+#if SK_ENABLE_LZ4
+    /* lz4 */
+    struct {
+        void *scratch;
+    } lz4;
+#endif  /* SK_ENABLE_LZ4 */
+
     char nothing;        /* Just to keep the union from being empty */
 } iobuf_opts_t;
 
@@ -131,6 +153,18 @@ struct sk_iobuf_st {
      * block_size */
     uint32_t        max_bytes;
 
+    /* Read-ahead thread, or NULL when it has not been started */
+    struct iobuf_readahead_st *readahead;
+    /* Number of blocks to read ahead; set by skIOBufSetReadAhead() */
+    uint32_t        readahead_blocks;
+
+    /* Function to invoke for each block and its data; set by
+     * skIOBufSetBlockCallback() */
+    skio_block_fn_t block_fn;
+    void           *block_cb_data;
+    /* Number of blocks read or written */
+    uint64_t        num_blocks;
+
     /* File descriptor */
     void           *fd;
     /* Function pointers that operate on the file descriptor */
@@ -172,6 +206,50 @@ struct sk_iobuf_st {
 /* typedef struct sk_iobuf_st sk_iobuf_t; */
 
 
+/*
+ *    iobuf_block_t is a decompressed block that the read-ahead thread
+ *    hands to the reader.
+ */
+typedef struct iobuf_block_st {
+    /* The buffer and its size */
+    uint8_t        *buf;
+    uint32_t        buf_size;
+    /* Number of uncompressed bytes in the block */
+    uint32_t        len;
+    /* Number of bytes read from disk for the block */
+    off_t           disk_bytes;
+    /* Position of the block in the file */
+    uint64_t        number;
+} iobuf_block_t;
+
+
+/*
+ *    iobuf_readahead_t is the state of the thread that reads and
+ *    decompresses blocks ahead of the reader.  The thread reads from
+ *    a copy of the IO buffer, 'reader', and fills the circular array
+ *    'blocks', whose 'ready' entries starting at 'first' are waiting
+ *    for the reader.  The reader returns each buffer it is done with
+ *    to the array for reuse.
+ */
+typedef struct iobuf_readahead_st {
+    sk_iobuf_t      reader;
+    pthread_t       thread;
+    pthread_mutex_t mutex;
+    pthread_cond_t  cond;
+    iobuf_block_t  *blocks;
+    uint32_t        block_count;
+    uint32_t        first;
+    uint32_t        ready;
+    /* Bytes read from disk after the final block (the end-of-file
+     * marker) */
+    off_t           tail_bytes;
+    /* Set by the reader to tell the thread to exit */
+    unsigned        stop      : 1;
+    /* Set by the thread once it reaches end of file or an error */
+    unsigned        done      : 1;
+} iobuf_readahead_t;
+
+
 /*
  *    The skio_uncomp_t values tell skio_uncompr() how to handle a
  *    compressed block.
@@ -431,6 +509,94 @@ snappy_uncompr_method(
 #endif  /* SK_ENABLE_SNAPPY */
 
 
+#if !SK_ENABLE_ZSTD
+#define ZSTD_METHODS   SKIOBUF_METHOD_PLACEHOLDER
+#else
+#define ZSTD_METHODS                            \
+    {                                           \
+        zstd_init_method,                       \
+        zstd_uninit_method,                     \
+        zstd_compr_size_method,                 \
+        zstd_compr_method,                      \
+        zstd_uncompr_method,                    \
+        1                                       \
+    }
+
+/*
+ *    The compression level to use for zstd.  The low levels compress
+ *    better than zlib at several times the speed.
+ */
+#define SKIOBUF_ZSTD_LEVEL  3
+
+/* Forward declarations for zstd methods */
+static int
+zstd_init_method(
+    iobuf_opts_t       *opts);
+static int
+zstd_uninit_method(
+    iobuf_opts_t       *opts);
+static uint32_t
+zstd_compr_size_method(
+    uint32_t            compr_size,
+    const iobuf_opts_t *opts);
+static int
+zstd_compr_method(
+    void               *dest,
+    uint32_t           *destlen,
+    const void         *source,
+    uint32_t            sourcelen,
+    const iobuf_opts_t *opts);
+static int
+zstd_uncompr_method(
+    void               *dest,
+    uint32_t           *destlen,
+    const void         *source,
+    uint32_t            sourcelen,
+    const iobuf_opts_t *opts);
+#endif  /* SK_ENABLE_ZSTD */
+
+
+#if !SK_ENABLE_LZ4
+#define LZ4_METHODS   SKIOBUF_METHOD_PLACEHOLDER
+#else
+#define LZ4_METHODS                             \
+    {                                           \
+        lz4_init_method,                        \
+        lz4_uninit_method,                      \
+        lz4_compr_size_method,                  \
+        lz4_compr_method,                       \
+        lz4_uncompr_method,                     \
+        1                                       \
+    }
+
+/* Forward declarations for lz4 methods */
+static int
+lz4_init_method(
+    iobuf_opts_t       *opts);
+static int
+lz4_uninit_method(
+    iobuf_opts_t       *opts);
+static uint32_t
+lz4_compr_size_method(
+    uint32_t            compr_size,
+    const iobuf_opts_t *opts);
+static int
+lz4_compr_method(
+    void               *dest,
+    uint32_t           *destlen,
+    const void         *source,
+    uint32_t            sourcelen,
+    const iobuf_opts_t *opts);
+static int
+lz4_uncompr_method(
+    void               *dest,
+    uint32_t           *destlen,
+    const void         *source,
+    uint32_t            sourcelen,
+    const iobuf_opts_t *opts);
+#endif  /* SK_ENABLE_LZ4 */
+
+
 /*
  *    Variable to hold the methods for each type of compression that
  *    SiLK supports.
@@ -440,10 +606,23 @@ static const iobuf_methods_t methods[] = {
     { NULL, NULL, NULL, NULL, NULL, 0 },
     ZLIB_METHODS,
     LZO_METHODS,
-    SNAPPY_METHODS
+    SNAPPY_METHODS,
+    ZSTD_METHODS,
+    LZ4_METHODS
 };
 
 
+/* LOCAL FUNCTION PROTOTYPES */
+
+static void
+iobufReadAheadStop(
+    sk_iobuf_t         *fd);
+static int32_t
+skio_uncompr(
+    sk_iobuf_t         *fd,
+    skio_uncomp_t       mode);
+
+
 /* FUNCTION DEFINITIONS */
 
 /* Create an IO buffer */
@@ -482,6 +661,8 @@ skIOBufDestroy(
         return;
     }
 
+    iobufReadAheadStop(fd);
+
     /* The flush call sets an error on a reader, but that's okay,
        since we are freeing the structure */
     skIOBufFlush(fd);
@@ -582,6 +763,12 @@ skIOBufBindAbstract(
 #endif
 #if SK_ENABLE_SNAPPY
       case SK_COMPMETHOD_SNAPPY:
+#endif
+#if SK_ENABLE_ZSTD
+      case SK_COMPMETHOD_ZSTD:
+#endif
+#if SK_ENABLE_LZ4
+      case SK_COMPMETHOD_LZ4:
 #endif
         break;
 
@@ -597,6 +784,9 @@ skIOBufBindAbstract(
      * method mid-stream, you do not want to throw away any data you
      * have pre-fetched using the old IO/compression methods. */
 
+    /* stop reading ahead on the old descriptor */
+    iobufReadAheadStop(fd);
+
     /* flush the IO stream and free the current IO handler if needed */
     if (fd->fd_valid && fd->is_writer) {
         total = skIOBufFlush(fd);
@@ -627,6 +817,7 @@ skIOBufBindAbstract(
 
     fd->compr_method = compmethod;
     fd->total = 0;
+    fd->num_blocks = 0;
     fd->used = 0;
     fd->has_error = 0;
     fd->has_interr = 0;
@@ -655,6 +846,354 @@ skIOBufBindAbstract(
 }
 
 
+/*
+ *    THREAD ENTRY POINT
+ *
+ *    Read and decompress blocks using the copy of the IO buffer in
+ *    the read-ahead state of the IO buffer 'v_fd' until the thread is
+ *    told to stop or it reaches end of file or an error.
+ */
+static void *
+iobufReadAheadThread(
+    void               *v_fd)
+{
+    iobuf_readahead_t *ra = ((sk_iobuf_t*)v_fd)->readahead;
+    sk_iobuf_t *reader = &ra->reader;
+    iobuf_block_t *blk;
+    uint8_t *buf;
+    uint32_t buf_size;
+    off_t total;
+    int32_t len;
+    sigset_t sigs;
+
+    /* leave signal handling to the main thread */
+    sigfillset(&sigs);
+    sigdelset(&sigs, SIGABRT);
+    sigdelset(&sigs, SIGBUS);
+    sigdelset(&sigs, SIGILL);
+    sigdelset(&sigs, SIGSEGV);
+    pthread_sigmask(SIG_SETMASK, &sigs, NULL);
+
+    total = reader->total;
+
+    pthread_mutex_lock(&ra->mutex);
+    for (;;) {
+        while (ra->ready == ra->block_count && !ra->stop) {
+            pthread_cond_wait(&ra->cond, &ra->mutex);
+        }
+        if (ra->stop) {
+            break;
+        }
+        pthread_mutex_unlock(&ra->mutex);
+
+        len = skio_uncompr(reader, SKIO_UNCOMP_NORMAL);
+
+        pthread_mutex_lock(&ra->mutex);
+        if (len <= 0) {
+            ra->tail_bytes = reader->total - total;
+            ra->done = 1;
+            pthread_cond_signal(&ra->cond);
+            break;
+        }
+
+        /* hand the block to the reader and take the block's old
+         * buffer in exchange */
+        blk = &ra->blocks[(ra->first + ra->ready) % ra->block_count];
+        buf = blk->buf;
+        buf_size = blk->buf_size;
+        blk->buf = reader->uncompr_buf;
+        blk->buf_size = reader->uncompr_buf_size;
+        reader->uncompr_buf = buf;
+        reader->uncompr_buf_size = buf_size;
+        blk->len = len;
+        blk->disk_bytes = reader->total - total;
+        blk->number = reader->num_blocks - 1;
+        total = reader->total;
+        ++ra->ready;
+        if (reader->at_eof) {
+            ra->done = 1;
+        }
+        pthread_cond_signal(&ra->cond);
+        if (ra->done) {
+            break;
+        }
+    }
+    pthread_mutex_unlock(&ra->mutex);
+
+    return NULL;
+}
+
+
+/*
+ *    Start the read-ahead thread for the IO buffer 'fd'.  Return 0 on
+ *    success, or -1 if the thread could not be started.
+ */
+static int
+iobufReadAheadStart(
+    sk_iobuf_t         *fd)
+{
+    iobuf_readahead_t *ra;
+
+    assert(NULL == fd->readahead);
+
+    ra = (iobuf_readahead_t*)calloc(1, sizeof(iobuf_readahead_t));
+    if (NULL == ra) {
+        return -1;
+    }
+    ra->block_count = fd->readahead_blocks;
+    ra->blocks = (iobuf_block_t*)calloc(ra->block_count,
+                                        sizeof(iobuf_block_t));
+    if (NULL == ra->blocks) {
+        free(ra);
+        return -1;
+    }
+
+    /* the thread reads with its own copy of 'fd'; the copy shares the
+     * descriptor and the compression options but has its own
+     * buffers */
+    ra->reader = *fd;
+    ra->reader.readahead = NULL;
+    ra->reader.readahead_blocks = 0;
+    ra->reader.block_fn = NULL;
+    ra->reader.compr_buf = NULL;
+    ra->reader.uncompr_buf = NULL;
+    ra->reader.compr_buf_size = 0;
+    ra->reader.uncompr_buf_size = 0;
+
+    pthread_mutex_init(&ra->mutex, NULL);
+    pthread_cond_init(&ra->cond, NULL);
+
+    fd->readahead = ra;
+    if (pthread_create(&ra->thread, NULL, &iobufReadAheadThread, fd)) {
+        fd->readahead = NULL;
+        pthread_cond_destroy(&ra->cond);
+        pthread_mutex_destroy(&ra->mutex);
+        free(ra->blocks);
+        free(ra);
+        return -1;
+    }
+
+    return 0;
+}
+
+
+/*
+ *    Stop the read-ahead thread for the IO buffer 'fd' if it is
+ *    running and free the read-ahead state.  Any blocks that have
+ *    been read ahead are discarded.
+ */
+static void
+iobufReadAheadStop(
+    sk_iobuf_t         *fd)
+{
+    iobuf_readahead_t *ra = fd->readahead;
+    uint32_t i;
+
+    if (NULL == ra) {
+        return;
+    }
+
+    pthread_mutex_lock(&ra->mutex);
+    ra->stop = 1;
+    pthread_cond_signal(&ra->cond);
+    pthread_mutex_unlock(&ra->mutex);
+    pthread_join(ra->thread, NULL);
+
+    for (i = 0; i < ra->block_count; ++i) {
+        free(ra->blocks[i].buf);
+    }
+    free(ra->blocks);
+    free(ra->reader.compr_buf);
+    free(ra->reader.uncompr_buf);
+    pthread_cond_destroy(&ra->cond);
+    pthread_mutex_destroy(&ra->mutex);
+    free(ra);
+    fd->readahead = NULL;
+}
+
+
+/*
+ *    Make the next block from the read-ahead thread the current block
+ *    of the IO buffer 'fd', starting the thread if needed.  For a
+ *    'mode' of SKIO_UNCOMP_NORMAL, pass each block to the block
+ *    callback first.  Return values are those of skio_uncompr().
+ */
+static int32_t
+iobufReadAheadNext(
+    sk_iobuf_t         *fd,
+    skio_uncomp_t       mode)
+{
+    iobuf_readahead_t *ra;
+    iobuf_block_t *blk;
+    uint8_t *buf;
+    uint32_t buf_size;
+    uint64_t number;
+
+    if (NULL == fd->readahead) {
+        if (fd->at_eof) {
+            return 0;
+        }
+        if (iobufReadAheadStart(fd)) {
+            /* read synchronously instead */
+            fd->readahead_blocks = 0;
+            return skio_uncompr(fd, mode);
+        }
+    }
+    ra = fd->readahead;
+
+    do {
+        pthread_mutex_lock(&ra->mutex);
+        while (0 == ra->ready && !ra->done) {
+            pthread_cond_wait(&ra->cond, &ra->mutex);
+        }
+        if (0 == ra->ready) {
+            /* the thread reached end of file or an error */
+            fd->total += ra->tail_bytes;
+            ra->tail_bytes = 0;
+            pthread_mutex_unlock(&ra->mutex);
+            if (ra->reader.has_error) {
+                fd->has_error = 1;
+                fd->has_interr = ra->reader.has_interr;
+                fd->has_ioerr = ra->reader.has_ioerr;
+                fd->io_errno = ra->reader.io_errno;
+                fd->error_line = ra->reader.error_line;
+                return -1;
+            }
+            fd->at_eof = 1;
+            return 0;
+        }
+
+        /* take the block, and give the thread the old buffer to
+         * reuse */
+        blk = &ra->blocks[ra->first];
+        buf = fd->uncompr_buf;
+        buf_size = fd->uncompr_buf_size;
+        fd->uncompr_buf = blk->buf;
+        fd->uncompr_buf_size = blk->buf_size;
+        blk->buf = buf;
+        blk->buf_size = buf_size;
+        fd->max_bytes = blk->len;
+        fd->total += blk->disk_bytes;
+        number = blk->number;
+        ra->first = (ra->first + 1) % ra->block_count;
+        --ra->ready;
+        pthread_cond_signal(&ra->cond);
+        pthread_mutex_unlock(&ra->mutex);
+
+        /* the thread has already decompressed the block, but a block
+         * the callback rejects is still never returned */
+    } while (SKIO_UNCOMP_NORMAL == mode && fd->block_fn
+             && fd->block_fn(fd->block_cb_data, number));
+
+    fd->pos = 0;
+    fd->in_core = 1;
+    fd->is_uncompr = 1;
+
+    return fd->max_bytes;
+}
+
+
+/*
+ *    Read the compressed and uncompressed sizes of the next block from
+ *    the IO buffer 'fd' into 'comp_block_size' and
+ *    'uncomp_block_size'.  Return 1 on success, 0 at end of file, or
+ *    -1 on error.
+ */
+static int
+iobufReadBlockSizes(
+    sk_iobuf_t         *fd,
+    uint32_t           *comp_block_size,
+    uint32_t           *uncomp_block_size)
+{
+    ssize_t readlen;
+
+    /* Read in the compressed block sizes */
+    readlen = fd->io.read(fd->fd, comp_block_size, sizeof(uint32_t));
+    if (readlen == -1) {
+        SKIOBUF_IO_ERROR(fd);
+    }
+    if (readlen == 0) {
+        /* We've reached eof. */
+        fd->at_eof = 1;
+        return 0;
+    }
+    fd->total += readlen;
+    if ((size_t)readlen < sizeof(uint32_t)) {
+        SKIOBUF_INTERNAL_ERROR(fd, ESKIO_SHORTREAD);
+    }
+
+    /* If we have reached the end of the compressed stream, we have
+     * the bytes we have. */
+    if (*comp_block_size == 0) {
+        fd->at_eof = 1;
+        return 0;
+    }
+
+    /* Read in the uncompressed block sizes */
+    readlen = fd->io.read(fd->fd, uncomp_block_size, sizeof(uint32_t));
+    if (readlen == -1) {
+        SKIOBUF_IO_ERROR(fd);
+    }
+    fd->total += readlen;
+    if ((size_t)readlen < sizeof(uint32_t)) {
+        /* We've reached eof, though we weren't expecting to */
+        fd->at_eof = 1;
+        SKIOBUF_INTERNAL_ERROR(fd, ESKIO_SHORTREAD);
+    }
+
+    *comp_block_size = ntohl(*comp_block_size);
+    *uncomp_block_size = ntohl(*uncomp_block_size);
+    ++fd->num_blocks;
+
+    return 1;
+}
+
+
+/*
+ *    Move the IO buffer 'fd' over the 'comp_block_size' bytes of a
+ *    block whose sizes have been read, seeking when possible.  Return
+ *    0 on success or -1 on error.
+ */
+static int
+iobufSkipBlock(
+    sk_iobuf_t         *fd,
+    uint32_t            comp_block_size)
+{
+    uint8_t buf[4096];
+    ssize_t readlen;
+    size_t len;
+
+    if (!fd->no_seek) {
+        errno = 0;
+        if (fd->io.seek(fd->fd, comp_block_size, SEEK_CUR) != (off_t)(-1)) {
+            fd->total += comp_block_size;
+            return 0;
+        }
+        if (errno != ESPIPE) {
+            SKIOBUF_IO_ERROR(fd);
+        }
+        fd->no_seek = 1;
+    }
+
+    while (comp_block_size) {
+        len = ((comp_block_size < sizeof(buf))
+               ? comp_block_size : sizeof(buf));
+        readlen = fd->io.read(fd->fd, buf, len);
+        if (readlen == -1) {
+            SKIOBUF_IO_ERROR(fd);
+        }
+        fd->total += readlen;
+        if ((size_t)readlen < len) {
+            fd->at_eof = 1;
+            SKIOBUF_INTERNAL_ERROR(fd, ESKIO_SHORTREAD);
+        }
+        comp_block_size -= len;
+    }
+
+    return 0;
+}
+
+
 /* Handle actual read and decompression of a block */
 static int32_t
 skio_uncompr(
@@ -667,6 +1206,7 @@ skio_uncompr(
     ssize_t readlen;
     uint8_t *bufpos;
     const iobuf_methods_t *method;
+    int rv;
 
     assert(fd);
 
@@ -675,6 +1215,13 @@ skio_uncompr(
            (mode == SKIO_UNCOMP_SKIP) ||
            (mode == SKIO_UNCOMP_REREAD && !fd->is_uncompr));
 
+    /* Get the block from the read-ahead thread when there is one;
+     * every block it provides is decompressed, so a skip is the same
+     * as a normal read */
+    if (fd->readahead_blocks) {
+        return iobufReadAheadNext(fd, mode);
+    }
+
     /* Alias our methods. */
     method = &methods[fd->compr_method];
 
@@ -699,44 +1246,24 @@ skio_uncompr(
         new_block_size = fd->max_bytes;
         padded_uncomp_block_size = fd->max_bytes;
     } else {
-        /* Read in the compressed block sizes */
-        readlen = fd->io.read(fd->fd, &comp_block_size,
-                              sizeof(comp_block_size));
-        if (readlen == -1) {
-            SKIOBUF_IO_ERROR(fd);
-        }
-        if (readlen == 0) {
-            /* We've reached eof. */
-            fd->at_eof = 1;
-            return 0;
-        }
-        fd->total += readlen;
-        if ((size_t)readlen < sizeof(comp_block_size)) {
-            SKIOBUF_INTERNAL_ERROR(fd, ESKIO_SHORTREAD);
-        }
-
-        /* If we have reached the end of the compressed stream, we
-         * have the bytes we have. */
-        if (comp_block_size == 0) {
-            fd->at_eof = 1;
-            return 0;
-        }
-
-        /* Read in the uncompressed block sizes */
-        readlen = fd->io.read(fd->fd, &uncomp_block_size,
-                              sizeof(uncomp_block_size));
-        if (readlen == -1) {
-            SKIOBUF_IO_ERROR(fd);
-        }
-        fd->total += readlen;
-        if ((size_t)readlen < sizeof(uncomp_block_size)) {
-            /* We've reached eof, though we weren't expecting to */
-            fd->at_eof = 1;
-            SKIOBUF_INTERNAL_ERROR(fd, ESKIO_SHORTREAD);
+        /* Read in the block sizes, moving over each block that the
+         * block callback rejects */
+        for (;;) {
+            rv = iobufReadBlockSizes(fd, &comp_block_size,
+                                     &uncomp_block_size);
+            if (rv <= 0) {
+                return rv;
+            }
+            if (mode != SKIO_UNCOMP_NORMAL || NULL == fd->block_fn
+                || !fd->block_fn(fd->block_cb_data, fd->num_blocks - 1))
+            {
+                break;
+            }
+            if (iobufSkipBlock(fd, comp_block_size)) {
+                return -1;
+            }
         }
-
-        comp_block_size = ntohl(comp_block_size);
-        uncomp_block_size = new_block_size = ntohl(uncomp_block_size);
+        new_block_size = uncomp_block_size;
 
         /*
          *   Some decompression algorithms require more space than the
@@ -1030,6 +1557,69 @@ skIOBufReadToChar(
     return iobufRead(fd, buf, count, &c);
 }
 
+/* Return a pointer into the uncompressed block instead of copying */
+ssize_t
+skIOBufReadInPlace(
+    sk_iobuf_t         *fd,
+    void              **data,
+    size_t              count)
+{
+    size_t left;
+    size_t num;
+
+    /* Take care of boundary conditions */
+    if (fd == NULL || data == NULL) {
+        return -1;
+    }
+    if (fd->has_error) {
+        return -1;
+    }
+    if (fd->is_writer) {
+        SKIOBUF_INTERNAL_ERROR(fd, ESKIO_NOREAD);
+    }
+    if (!fd->fd_valid) {
+        SKIOBUF_INTERNAL_ERROR(fd, ESKIO_NOFD);
+    }
+    if (count == 0) {
+        return 0;
+    }
+
+    left = fd->max_bytes - fd->pos;
+    if (left == 0) {
+        int32_t uncompr_size;
+
+        if (fd->at_eof) {
+            return 0;
+        }
+        uncompr_size = skio_uncompr(fd, SKIO_UNCOMP_NORMAL);
+        if (uncompr_size == -1) {
+            return -1;
+        }
+        fd->used = 1;
+        if (uncompr_size == 0) {
+            assert(fd->at_eof);
+            return 0;
+        }
+        left = fd->max_bytes;
+
+    } else if (!fd->is_uncompr) {
+        int32_t rv = skio_uncompr(fd, SKIO_UNCOMP_REREAD);
+        if (rv == -1) {
+            return -1;
+        }
+        if (rv == 0) {
+            assert(fd->at_eof);
+            return 0;
+        }
+    }
+
+    num = (count < left) ? count : left;
+    *data = &fd->uncompr_buf[fd->pos];
+    fd->pos += num;
+
+    return num;
+}
+
 
 /* Push 'count' bytes from 'buf' back into the read buffer.  */
 ssize_t
@@ -1159,6 +1749,13 @@ skio_compr(
 
     fd->pos = 0;
 
+    if (method->block_numbers) {
+        if (fd->block_fn) {
+            fd->block_fn(fd->block_cb_data, fd->num_blocks);
+        }
+        ++fd->num_blocks;
+    }
+
     return (int32_t)writelen;
 }
 
@@ -1233,6 +1830,57 @@ skIOBufWrite(
 }
 
 
+/* Write complete blocks from another IO buffer to an IO buffer */
+ssize_t
+skIOBufWriteBlocks(
+    sk_iobuf_t         *fd,
+    const void         *buf,
+    size_t              count)
+{
+    ssize_t writelen;
+
+    assert(fd);
+
+    /* Take care of boundary conditions */
+    if (count == 0) {
+        return 0;
+    }
+    if (fd == NULL) {
+        return -1;
+    }
+    if (!fd->is_writer) {
+        SKIOBUF_INTERNAL_ERROR(fd, ESKIO_NOWRITE);
+    }
+    if (!fd->fd_valid) {
+        SKIOBUF_INTERNAL_ERROR(fd, ESKIO_NOFD);
+    }
+    assert(count <= SSIZE_MAX);
+    if (count > SSIZE_MAX) {
+        SKIOBUF_INTERNAL_ERROR(fd, ESKIO_TOOBIG);
+    }
+
+    fd->used = 1;
+
+    /* Write any buffered data as its own block */
+    if (fd->pos) {
+        if (skio_compr(fd) == -1) {
+            return -1;
+        }
+    }
+
+    writelen = fd->io.write(fd->fd, buf, count);
+    if (writelen == -1) {
+        SKIOBUF_IO_ERROR(fd);
+    }
+    fd->total += writelen;
+    if ((size_t)writelen < count) {
+        SKIOBUF_INTERNAL_ERROR(fd, ESKIO_SHORTWRITE);
+    }
+
+    return writelen;
+}
+
+
 /* Finish writing to an IO buffer */
 off_t
 skIOBufFlush(
@@ -1393,6 +2041,57 @@ skIOBufSetRecordSize(
 }
 
 
+/* Set the number of blocks to read ahead */
+int
+skIOBufSetReadAhead(
+    sk_iobuf_t         *fd,
+    uint32_t            num_blocks)
+{
+    assert(fd);
+    if (fd == NULL) {
+        return -1;
+    }
+    if (fd->is_writer) {
+        SKIOBUF_INTERNAL_ERROR(fd, ESKIO_NOREAD);
+    }
+    if (num_blocks > SKIOBUF_MAX_READAHEAD) {
+        SKIOBUF_INTERNAL_ERROR(fd, ESKIO_BADOPT);
+    }
+
+    if (0 == num_blocks) {
+        if (fd->readahead) {
+            /* the data the thread read ahead is gone */
+            iobufReadAheadStop(fd);
+            fd->at_eof = 1;
+        }
+    } else if (fd->used) {
+        SKIOBUF_INTERNAL_ERROR(fd, ESKIO_USED);
+    }
+    fd->readahead_blocks = num_blocks;
+
+    return 0;
+}
+
+
+/* Set the function to invoke for each block */
+int
+skIOBufSetBlockCallback(
+    sk_iobuf_t         *fd,
+    skio_block_fn_t     block_fn,
+    void               *cb_data)
+{
+    assert(fd);
+    if (fd == NULL) {
+        return -1;
+    }
+
+    fd->block_fn = block_fn;
+    fd->block_cb_data = cb_data;
+
+    return 0;
+}
+
+
 /* Create an error message */
 const char *
 skIOBufStrError(
@@ -1851,6 +2550,192 @@ snappy_uncompr_method(
 #endif  /* SK_ENABLE_SNAPPY */
 
 
+#if SK_ENABLE_ZSTD
+
+/* ZSTD methods */
+
+/* iobuf_methods_t.init_method */
+static int
+zstd_init_method(
+    iobuf_opts_t       *opts)
+{
+    opts->zstd.level = SKIOBUF_ZSTD_LEVEL;
+    opts->zstd.cctx = ZSTD_createCCtx();
+    opts->zstd.dctx = ZSTD_createDCtx();
+    if (NULL == opts->zstd.cctx || NULL == opts->zstd.dctx) {
+        ZSTD_freeCCtx(opts->zstd.cctx);
+        ZSTD_freeDCtx(opts->zstd.dctx);
+        opts->zstd.cctx = NULL;
+        opts->zstd.dctx = NULL;
+        return -1;
+    }
+
+    return 0;
+}
+
+
+/* iobuf_methods_t.uninit_method */
+static int
+zstd_uninit_method(
+    iobuf_opts_t       *opts)
+{
+    ZSTD_freeCCtx(opts->zstd.cctx);
+    ZSTD_freeDCtx(opts->zstd.dctx);
+    opts->zstd.cctx = NULL;
+    opts->zstd.dctx = NULL;
+    return 0;
+}
+
+
+/* iobuf_methods_t.compr_size_method */
+static uint32_t
+zstd_compr_size_method(
+    uint32_t            compr_size,
+    const iobuf_opts_t *opts)
+{
+    (void)opts;                 /* UNUSED */
+
+    return (uint32_t)ZSTD_compressBound(compr_size);
+}
+
+
+/* iobuf_methods_t.compr_method */
+static int
+zstd_compr_method(
+    void               *dest,
+    uint32_t           *destlen,
+    const void         *source,
+    uint32_t            sourcelen,
+    const iobuf_opts_t *opts)
+{
+    size_t rv;
+
+    rv = ZSTD_compressCCtx(opts->zstd.cctx, dest, *destlen,
+                           source, sourcelen, opts->zstd.level);
+    if (ZSTD_isError(rv)) {
+        return -1;
+    }
+    *destlen = (uint32_t)rv;
+
+    return 0;
+}
+
+
+/* iobuf_methods_t.uncompr_method */
+static int
+zstd_uncompr_method(
+    void               *dest,
+    uint32_t           *destlen,
+    const void         *source,
+    uint32_t            sourcelen,
+    const iobuf_opts_t *opts)
+{
+    size_t rv;
+
+    rv = ZSTD_decompressDCtx(opts->zstd.dctx, dest, *destlen,
+                             source, sourcelen);
+    if (ZSTD_isError(rv)) {
+        return -1;
+    }
+    *destlen = (uint32_t)rv;
+
+    return 0;
+}
+
+#endif  /* SK_ENABLE_ZSTD */
+
+
+#if SK_ENABLE_LZ4
+
+/* LZ4 methods */
+
+/* iobuf_methods_t.init_method */
+static int
+lz4_init_method(
+    iobuf_opts_t       *opts)
+{
+    opts->lz4.scratch = malloc(LZ4_sizeofState());
+    if (opts->lz4.scratch == NULL) {
+        return -1;
+    }
+
+    return 0;
+}
+
+
+/* iobuf_methods_t.uninit_method */
+static int
+lz4_uninit_method(
+    iobuf_opts_t       *opts)
+{
+    assert(opts->lz4.scratch != NULL);
+    free(opts->lz4.scratch);
+    opts->lz4.scratch = NULL;
+    return 0;
+}
+
+
+/* iobuf_methods_t.compr_size_method */
+static uint32_t
+lz4_compr_size_method(
+    uint32_t            compr_size,
+    const iobuf_opts_t *opts)
+{
+    (void)opts;                 /* UNUSED */
+
+    return (uint32_t)LZ4_compressBound((int)compr_size);
+}
+
+
+/* iobuf_methods_t.compr_method */
+static int
+lz4_compr_method(
+    void               *dest,
+    uint32_t           *destlen,
+    const void         *source,
+    uint32_t            sourcelen,
+    const iobuf_opts_t *opts)
+{
+    int rv;
+
+    rv = LZ4_compress_fast_extState(opts->lz4.scratch, (const char*)source,
+                                    (char*)dest, (int)sourcelen,
+                                    (int)*destlen, 1);
+    if (rv <= 0) {
+        return -1;
+    }
+    *destlen = (uint32_t)rv;
+
+    return 0;
+}
+
+
+/* iobuf_methods_t.uncompr_method */
+static int
+lz4_uncompr_method(
+    void               *dest,
+    uint32_t           *destlen,
+    const void         *source,
+    uint32_t            sourcelen,
+    const iobuf_opts_t *opts)
+{
+    int rv;
+
+    (void)opts;                 /* UNUSED */
+
+    rv = LZ4_decompress_safe((const char*)source, (char*)dest,
+                             (int)sourcelen, (int)*destlen);
+    if (rv < 0) {
+        return -1;
+    }
+    *destlen = (uint32_t)rv;
+
+    return 0;
+}
+
+#endif  /* SK_ENABLE_LZ4 */
+
+
 /*
 ** Local Variables:
 ** mode:c
@@ -39,6 +39,13 @@ RCSIDENTVAR(rcsID_SKIOBUF_H, "$SiLK: skiobuf.h 275df62a2e41 2017-01-05 17:30:40Z
 #define SKIOBUF_MAX_BLOCKSIZE 0x100000 /* One megabyte */
 
 
+/**
+ *    The maximum number of blocks that may be read ahead; see
+ *    skIOBufSetReadAhead().
+ */
+#define SKIOBUF_MAX_READAHEAD 64
+
+
 /**
  *    The default record size.  A single record is guaranteed not to
  *    span multiple blocks.
@@ -138,6 +145,18 @@ typedef struct skio_abstract_st {
 } skio_abstract_t;
 
 
+/**
+ *    Signature of a callback function that skIOBuf invokes once for
+ *    each block of a file, where 'block_number' is the zero-based
+ *    position of the block in the IO buffer.  See
+ *    skIOBufSetBlockCallback().
+ */
+typedef int
+(*skio_block_fn_t)(
+    void           *cb_data,
+    uint64_t        block_number);
+
+
 /**
  *    Creates a new IO buffer for either reading or writing according
  *    to 'mode'.  A 'mode' of SK_IO_APPEND creates a writing IO
@@ -224,6 +243,30 @@ skIOBufRead(
     size_t              count);
 
 
+/**
+ *    Sets the location referenced by 'data' to the next uncompressed
+ *    bytes in the IO buffer 'iobuf' and moves the read location
+ *    forward by the number of bytes available in the current block,
+ *    which is no more than 'count'.  Avoids the copy that
+ *    skIOBufRead() makes.
+ *
+ *    The bytes remain valid until the next call to a read function
+ *    on 'iobuf', and the caller may modify them.  When the record
+ *    size has been set by skIOBufSetRecordSize(), the number of bytes
+ *    available is a multiple of the record size unless the stream
+ *    ends with a partial record.
+ *
+ *    Returns the number of bytes available, which may be less than
+ *    'count' even when the stream contains more data.  Returns 0 when
+ *    there is no more data in the stream.  Returns -1 on failure.
+ */
+ssize_t
+skIOBufReadInPlace(
+    sk_iobuf_t         *iobuf,
+    void              **data,
+    size_t              count);
+
+
 /**
  *    Copies 'count' bytes from 'data' back into the read buffer of
  *    the IO buffer 'iobuf' so those bytes will be returned by the
@@ -280,6 +323,27 @@ skIOBufWrite(
     size_t              count);
 
 
+/**
+ *    Writes 'count' bytes from 'data' directly to the underlying file
+ *    descriptor of the IO buffer writer 'iobuf'.  The bytes must be
+ *    complete blocks that were produced by another IO buffer writer
+ *    that uses the same compression method, block size, and record
+ *    size as 'iobuf'.  Any data in 'iobuf' is first written as a
+ *    block so that the new blocks follow it.
+ *
+ *    This allows several threads to compress blocks in parallel
+ *    using their own IO buffers and then append those blocks to a
+ *    single file.
+ *
+ *    Returns the number of bytes written on success, -1 on failure.
+ */
+ssize_t
+skIOBufWriteBlocks(
+    sk_iobuf_t         *iobuf,
+    const void         *data,
+    size_t              count);
+
+
 /**
  *    Flushes the IO buffer writer 'iobuf'.  This does not close the
  *    buffer or the underlying file descriptor.
@@ -346,6 +410,51 @@ skIOBufSetRecordSize(
     uint32_t            size);
 
 
+/**
+ *     Tells the reading IO buffer 'iobuf' to use a separate thread to
+ *     read and decompress up to 'num_blocks' blocks ahead of the
+ *     caller, so that reading and decompression overlap the caller's
+ *     processing.  The thread starts at the first read.  This
+ *     function can only enable read-ahead immediately after creation
+ *     or binding of the IO buffer, and 'num_blocks' may not exceed
+ *     SKIOBUF_MAX_READAHEAD.
+ *
+ *     A 'num_blocks' of 0 disables read-ahead.  When the thread is
+ *     running, it is stopped, the blocks it has read are discarded,
+ *     and 'iobuf' reports end of file on subsequent reads.  Call this
+ *     before closing the file descriptor bound to 'iobuf'.
+ *
+ *     Returns 0 on success, -1 on error.
+ */
+int
+skIOBufSetReadAhead(
+    sk_iobuf_t         *iobuf,
+    uint32_t            num_blocks);
+
+
+/**
+ *     Sets a function that the IO buffer 'iobuf' invokes with
+ *     'cb_data' for each block.  A writing IO buffer invokes
+ *     'block_fn' after each block has been written; the return value
+ *     is ignored.  A reading IO buffer invokes 'block_fn' once the
+ *     sizes of a block have been read and before the block is read;
+ *     when 'block_fn' returns non-zero, the block is moved over
+ *     without being decompressed and is never returned to the caller.
+ *     Blocks moved over by a skip (a read with a NULL buffer) are
+ *     counted but are not passed to 'block_fn'.
+ *
+ *     Blocks are only visible for compression methods that store the
+ *     sizes of each block; the function is never invoked for
+ *     uncompressed data.  A 'block_fn' of NULL removes the function.
+ *     Returns 0 on success, -1 on error.
+ */
+int
+skIOBufSetBlockCallback(
+    sk_iobuf_t         *iobuf,
+    skio_block_fn_t     block_fn,
+    void               *cb_data);
+
+
 /**
  *    Returns a string representing the error state of the IO buffer
  *    'buf'.  This is a static string similar to that used by
@@ -155,10 +155,12 @@ RCSIDENT("$SiLK: skipset.c ef5b2378ee80 2017-02-27 21:48:55Z mthomas $");
  *    structure also contains a flag denoting whether the index is a
  *    node or a leaf.
  *
- *    The on-disk storage may match the in-core storage.  This would
- *    allow us to mmap() the data section of the file when reading a
- *    set---as long as the set is in native byte order and the data
- *    section is not compressed.
+ *    The on-disk storage may match the in-core storage.  This allows
+ *    us to mmap() the data section of the file when reading a
+ *    set---as long as the set is in native byte order, the data
+ *    section is not compressed, and the data section is aligned.  The
+ *    mapped IPset is used in place until it is modified; see
+ *    ipsetCopyOnWrite().
  *
  *
  *    The IPset structure is currently optimized to hold large CIDR
@@ -243,9 +245,29 @@ RCSIDENT("$SiLK: skipset.c ef5b2378ee80 2017-02-27 21:48:55Z mthomas $");
  *    All IPv4 IPsets were written in this format between SiLK 3.0.0
  *    and SiLK 3.5.1.  SiLK 3.6.0 reverted to using
  *    IPSET_REC_VERSION_CLASSC files for IPv4 IPsets.
+ *
+ *    As of SiLK 3.16.0, the header is padded so that the data section
+ *    begins on an IPSET_RADIX_DATA_ALIGN boundary, and a large,
+ *    uncompressed file in native byte order is mmap()ed when it is
+ *    read.  Older readers ignore the padding.
  */
 #define IPSET_REC_VERSION_RADIX             3
 
+/*
+ *    The alignment of the data section of an IPSET_REC_VERSION_RADIX
+ *    file that allows the file to be mmap()ed and used in place.
+ */
+#define IPSET_RADIX_DATA_ALIGN              sizeof(uint64_t)
+
+/*
+ *    The minimum size of an IPSET_REC_VERSION_RADIX file that is
+ *    mmap()ed.  Searching an IPv4 set in the radix format is slower
+ *    than searching an IPTree, and reading a smaller file is quick,
+ *    so a smaller file is read and an IPv4 set is converted to an
+ *    IPTree.
+ */
+#define IPSET_RADIX_MMAP_MIN_SIZE           (1 << 23)
+
 /*
  *    The numeric id of the IPset file format introduced in SiLK-3.7.
  *    The file may contain either IPv4 or IPv6 addresses (a header
@@ -8226,6 +8248,40 @@ ipsetReadClasscIntoRadix(
 }
 
 
+/*
+ *  can_mmap = ipsetReadRadixCanMmap(stream, hdr);
+ *
+ *    Helper function for skIPSetRead() and ipsetReadRadixIntoRadix().
+ *
+ *    Return 1 if the data section of the IPSET_REC_VERSION_RADIX
+ *    file in 'stream' whose header is 'hdr' may be mmap()ed and used
+ *    in place; that is, if 'stream' is seekable, the data is
+ *    uncompressed and in native byte order, the data begins on an
+ *    IPSET_RADIX_DATA_ALIGN boundary, and the file is at least
+ *    IPSET_RADIX_MMAP_MIN_SIZE bytes.  Return 0 otherwise.
+ */
+static int
+ipsetReadRadixCanMmap(
+    skstream_t         *stream,
+    sk_file_header_t   *hdr)
+{
+    off_t data_start;
+
+    if (!skStreamIsSeekable(stream)
+        || !skHeaderIsNativeByteOrder(hdr)
+        || (SK_COMPMETHOD_NONE != skHeaderGetCompressionMethod(hdr)))
+    {
+        return 0;
+    }
+    data_start = skStreamTell(stream);
+    if ((data_start <= 0) || (0 != data_start % IPSET_RADIX_DATA_ALIGN)) {
+        return 0;
+    }
+    return (skFileSize(skStreamGetPathname(stream))
+            >= IPSET_RADIX_MMAP_MIN_SIZE);
+}
+
+
 /*
  *  status = ipsetReadRadixIntoIPTree(&ipset, stream, hdr);
  *
@@ -8326,10 +8382,7 @@ ipsetReadRadixIntoRadix(
     IPSET_ROOT_INDEX_SET(ipset, ipsetHentryGetRootIndex(hentry),
                          (ipsetHentryGetNodeCount(hentry) <= 1));
 
-    if (skStreamIsSeekable(stream)
-        && skHeaderIsNativeByteOrder(hdr)
-        && (SK_COMPMETHOD_NONE == skHeaderGetCompressionMethod(hdr)))
-    {
+    if (ipsetReadRadixCanMmap(stream, hdr)) {
         /* attempt to mmap() the file */
 
         /* get file size and offset where the data begins */
@@ -8337,9 +8390,7 @@ ipsetReadRadixIntoRadix(
         off_t data_start = skStreamTell(stream);
         uint8_t *buf;
 
-        if ((0 < data_start) && (data_start < file_size)
-            && (UINT32_MAX > file_size))
-        {
+        if ((data_start < file_size) && (UINT32_MAX > file_size)) {
             ipset->s.v3->mapped_size = (size_t)file_size;
             ipset->s.v3->mapped_file = mmap(0, ipset->s.v3->mapped_size,
                                             PROT_READ, MAP_SHARED,
@@ -8356,19 +8407,23 @@ ipsetReadRadixIntoRadix(
                 ipset->s.v3->nodes.buf = buf;
                 ipset->s.v3->nodes.entry_count
                     = ipsetHentryGetNodeCount(hentry);
+                ipset->s.v3->nodes.entry_capacity
+                    = ipset->s.v3->nodes.entry_count;
 
                 /* move over the nodes (to the leaves)  */
                 buf += (ipsetHentryGetNodeCount(hentry)
                         * ipset->s.v3->nodes.entry_size);
                 ipset->s.v3->leaves.buf = buf;
-                ipset->s.v3->nodes.entry_count
+                ipset->s.v3->leaves.entry_count
                     = ipsetHentryGetLeafCount(hentry);
+                ipset->s.v3->leaves.entry_capacity
+                    = ipset->s.v3->leaves.entry_count;
 
-                /* move over the leaves to the end of the file */
+                /* move over the leaves to the end of the data */
                 buf += (ipsetHentryGetLeafCount(hentry)
                         * ipset->s.v3->leaves.entry_size);
-                if (buf >= ((uint8_t*)ipset->s.v3->mapped_file
-                            + ipset->s.v3->mapped_size))
+                if (buf > ((uint8_t*)ipset->s.v3->mapped_file
+                           + ipset->s.v3->mapped_size))
                 {
                     /* error */
                     munmap(ipset->s.v3->mapped_file, ipset->s.v3->mapped_size);
@@ -8377,9 +8432,11 @@ ipsetReadRadixIntoRadix(
 
                     ipset->s.v3->nodes.buf = NULL;
                     ipset->s.v3->nodes.entry_count = 0;
+                    ipset->s.v3->nodes.entry_capacity = 0;
 
                     ipset->s.v3->leaves.buf = NULL;
-                    ipset->s.v3->nodes.entry_count = 0;
+                    ipset->s.v3->leaves.entry_count = 0;
+                    ipset->s.v3->leaves.entry_capacity = 0;
                 }
             }
         }
@@ -11182,6 +11239,14 @@ ipsetWriteRadix(
         skAbort();
     }
 
+    /* Pad the header so the data section may be mmap()ed */
+    rv = skHeaderSetPaddingModulus(hdr, IPSET_RADIX_DATA_ALIGN);
+    if (rv) {
+        skAppPrintErr("%s", skHeaderStrerror(rv));
+        rv = SKIPSET_ERR_FILEIO;
+        goto END;
+    }
+
     /* Add the appropriate header */
     rv = ipsetHentryAddToFile(hdr, IPSET_NUM_CHILDREN,
                               ipset->s.v3->leaves.entry_count,
@@ -13454,8 +13519,11 @@ skIPSetRead(
             }
             return ipsetCreate(ipset_out, is_ipv6, 1);
         }
-        if (!is_ipv6 && IPSET_USE_IPTREE) {
-            /* Read IPv4-only file into the IPTree format */
+        if (!is_ipv6 && IPSET_USE_IPTREE
+            && !ipsetReadRadixCanMmap(stream, hdr))
+        {
+            /* Read IPv4-only file into the IPTree format unless the
+             * file can be mmap()ed and used in place */
             return ipsetReadRadixIntoIPTree(ipset_out, stream, hdr);
         }
         return ipsetReadRadixIntoRadix(ipset_out, stream, hdr, is_ipv6);
@@ -16,6 +16,11 @@
 ** prefixmap file and an IP address and do a lookup on that file to
 ** print the result.
 **
+** When --benchmark is given, time lookups of random keys in the map
+** as read (which uses the compiled trie) and in a copy of the map
+** that is built with skPrefixMapAddRange() (which walks the tree),
+** and verify that both give the same results.
+**
 */
 
 
@@ -23,6 +28,7 @@
 
 RCSIDENT("$SiLK: skprefixmap-test.c 275df62a2e41 2017-01-05 17:30:40Z mthomas $");
 
+#include <silk/skipaddr.h>
 #include <silk/skprefixmap.h>
 #include <silk/skstream.h>
 #include <silk/utils.h>
@@ -36,6 +42,11 @@ RCSIDENT("$SiLK: skprefixmap-test.c 275df62a2e41 2017-01-05 17:30:40Z mthomas $"
 /* max expected length of a pmap dictionary entry */
 #define DICTIONARY_ENTRY_BUFLEN 2048
 
+/* microseconds between two struct timeval's */
+#define TIMEVAL_DIFF_USEC(a, b)                                         \
+    (((int64_t)(b).tv_sec - (a).tv_sec) * 1000000                       \
+     + ((int64_t)(b).tv_usec - (a).tv_usec))
+
 
 /* EXPORTED FUNCTIONS */
 
@@ -47,13 +58,14 @@ RCSIDENT("$SiLK: skprefixmap-test.c 275df62a2e41 2017-01-05 17:30:40Z mthomas $"
 /* OPTIONS SETUP */
 
 typedef enum {
-    OPT_MAP_FILE, OPT_ADDRESS, OPT_STRING
+    OPT_MAP_FILE, OPT_ADDRESS, OPT_STRING, OPT_BENCHMARK
 } appOptionsEnum;
 
 static struct option appOptions[] = {
-    {"map-file", REQUIRED_ARG, 0, OPT_MAP_FILE},
-    {"address",  REQUIRED_ARG, 0, OPT_ADDRESS},
-    {"string",   NO_ARG,       0, OPT_STRING},
+    {"map-file",  REQUIRED_ARG, 0, OPT_MAP_FILE},
+    {"address",   REQUIRED_ARG, 0, OPT_ADDRESS},
+    {"string",    NO_ARG,       0, OPT_STRING},
+    {"benchmark", REQUIRED_ARG, 0, OPT_BENCHMARK},
     {0,0,0,0}                   /* sentinel entry */
 };
 
@@ -62,6 +74,8 @@ static const char *appHelp[] = {
     "path name of the map file.",
     "IP address to look up",
     "output dictionary string instead of integer value",
+    ("time this many lookups of random keys using the compiled\n"
+     "\tmap and the tree, and verify they agree"),
     (char *)NULL
 };
 
@@ -70,6 +84,7 @@ static struct {
     skipaddr_t  address;        /* IP address to look up */
     uint32_t    have_address;   /* whether an address was given */
     uint32_t    string;         /* look up string */
+    uint32_t    benchmark;      /* number of lookups to time, or 0 */
 } prefixmap_test_opt;
 
 
@@ -179,11 +194,13 @@ appSetup(
     }
 
     if ( (NULL == prefixmap_test_opt.map_file) ||
-         (0 == prefixmap_test_opt.have_address) ) {
+         (0 == prefixmap_test_opt.have_address
+          && 0 == prefixmap_test_opt.benchmark) ) {
         if ( NULL == prefixmap_test_opt.map_file ) {
             skAppPrintErr("Required argument map-file not provided.");
         }
-        if ( 0 == prefixmap_test_opt.have_address ) {
+        if ( 0 == prefixmap_test_opt.have_address
+             && 0 == prefixmap_test_opt.benchmark ) {
             skAppPrintErr("Required argument address not provided.");
         }
         exit(EXIT_FAILURE);
@@ -237,12 +254,166 @@ appOptionsHandler(
     case OPT_STRING:
         prefixmap_test_opt.string = 1;
         break;
+
+      case OPT_BENCHMARK:
+        rv = skStringParseUint32(&prefixmap_test_opt.benchmark, opt_arg,
+                                 1, 0);
+        if (rv) {
+            skAppPrintErr("Invalid %s '%s': %s",
+                          appOptions[opt_index].name, opt_arg,
+                          skStringParseStrerror(rv));
+            exit(EXIT_FAILURE);
+        }
+        break;
     }
 
     return 0;  /* OK */
 }
 
 
+/*
+ *  copy = benchmarkCopyMap(map);
+ *
+ *    Create a copy of 'map' by adding each of its ranges to a new
+ *    prefix map.  The copy is never read from a stream, so lookups
+ *    in it walk the tree.  Exit the application on error.
+ */
+static skPrefixMap_t *
+benchmarkCopyMap(
+    const skPrefixMap_t    *map)
+{
+    skPrefixMapIterator_t *iter;
+    skPrefixMap_t *copy;
+    union key_un {
+        skipaddr_t              addr;
+        skPrefixMapProtoPort_t  pp;
+    } start, end;
+    uint32_t val;
+
+    if (skPrefixMapCreate(&copy)
+        || skPrefixMapSetContentType(copy, skPrefixMapGetContentType(map)))
+    {
+        skAppPrintErr("Unable to create prefix map");
+        exit(EXIT_FAILURE);
+    }
+    if (skPrefixMapIteratorCreate(&iter, map)) {
+        skAppPrintErr("Unable to create prefix map iterator");
+        exit(EXIT_FAILURE);
+    }
+    while (skPrefixMapIteratorNext(iter, &start, &end, &val)
+           == SK_ITERATOR_OK)
+    {
+        if (skPrefixMapAddRange(copy, &start, &end, val)) {
+            skAppPrintErr("Unable to add range to prefix map");
+            exit(EXIT_FAILURE);
+        }
+    }
+    skPrefixMapIteratorDestroy(&iter);
+
+    return copy;
+}
+
+
+/*
+ *  benchmarkRandomKey(map, key);
+ *
+ *    Fill 'key' with a random key appropriate to the content type of
+ *    'map'.
+ */
+static void
+benchmarkRandomKey(
+    const skPrefixMap_t    *map,
+    void                   *key)
+{
+    uint32_t r[4];
+    int i;
+
+    for (i = 0; i < 4; ++i) {
+        r[i] = ((uint32_t)random() << 16) ^ (uint32_t)random();
+    }
+
+    switch (skPrefixMapGetContentType(map)) {
+      case SKPREFIXMAP_CONT_PROTO_PORT:
+        ((skPrefixMapProtoPort_t*)key)->proto = (uint8_t)(r[0] >> 16);
+        ((skPrefixMapProtoPort_t*)key)->port = (uint16_t)r[0];
+        break;
+      case SKPREFIXMAP_CONT_ADDR_V4:
+        skipaddrSetV4((skipaddr_t*)key, &r[0]);
+        break;
+      case SKPREFIXMAP_CONT_ADDR_V6:
+#if SK_ENABLE_IPV6
+        skipaddrSetV6((skipaddr_t*)key, r);
+#else
+        skipaddrSetV4((skipaddr_t*)key, &r[0]);
+#endif
+        break;
+    }
+}
+
+
+/*
+ *  benchmarkMap(map, count);
+ *
+ *    Look up 'count' random keys in 'map' and in a copy of 'map' that
+ *    is built from its ranges, print the time per lookup of each, and
+ *    exit the application if the results differ.
+ */
+static void
+benchmarkMap(
+    const skPrefixMap_t    *map,
+    uint32_t                count)
+{
+    union key_un {
+        skipaddr_t              addr;
+        skPrefixMapProtoPort_t  pp;
+    } *keys;
+    skPrefixMap_t *copy;
+    struct timeval t0, t1, t2;
+    uint32_t *vals;
+    uint32_t sum = 0;
+    uint32_t i;
+
+    keys = (union key_un*)malloc(count * sizeof(union key_un));
+    vals = (uint32_t*)malloc(count * sizeof(uint32_t));
+    if (NULL == keys || NULL == vals) {
+        skAppPrintErr("Unable to allocate %" PRIu32 " keys", count);
+        exit(EXIT_FAILURE);
+    }
+    copy = benchmarkCopyMap(map);
+
+    srandom(1);
+    memset(keys, 0, count * sizeof(union key_un));
+    for (i = 0; i < count; ++i) {
+        benchmarkRandomKey(map, &keys[i]);
+    }
+
+    gettimeofday(&t0, NULL);
+    for (i = 0; i < count; ++i) {
+        vals[i] = skPrefixMapFindValue(map, &keys[i]);
+    }
+    gettimeofday(&t1, NULL);
+    for (i = 0; i < count; ++i) {
+        sum += (skPrefixMapFindValue(copy, &keys[i]) != vals[i]);
+    }
+    gettimeofday(&t2, NULL);
+
+    printf("compiled: %.2f ns/lookup\n",
+           1000.0 * TIMEVAL_DIFF_USEC(t0, t1) / count);
+    printf("tree:     %.2f ns/lookup\n",
+           1000.0 * TIMEVAL_DIFF_USEC(t1, t2) / count);
+
+    skPrefixMapDelete(copy);
+    free(keys);
+    free(vals);
+
+    if (sum) {
+        skAppPrintErr("Compiled map and tree disagree on %" PRIu32 " keys",
+                      sum);
+        exit(EXIT_FAILURE);
+    }
+}
+
+
 int main(int argc, char **argv)
 {
     skstream_t *inputFile;
@@ -274,7 +445,13 @@ int main(int argc, char **argv)
         exit(EXIT_FAILURE);
     }
 
-    if ( prefixmap_test_opt.string ) {
+    if ( prefixmap_test_opt.benchmark ) {
+        benchmarkMap(prefixMap, prefixmap_test_opt.benchmark);
+    }
+
+    if ( 0 == prefixmap_test_opt.have_address ) {
+        /* only benchmarking */
+    } else if ( prefixmap_test_opt.string ) {
         int v = skPrefixMapFindString(prefixMap, &prefixmap_test_opt.address,
                                       buf, sizeof(buf));
         if ( v < 0 ) {
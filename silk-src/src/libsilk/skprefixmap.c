@@ -43,6 +43,12 @@
 **    the value contains the ASCII representation of the two letters
 **    that make up the country code.)
 **
+**    When a prefix map file is in native byte order and is read from
+**    a seekable stream, the file is mmap()ed and the tree is used in
+**    place, so concurrent processes share its pages.  The tree is
+**    copied into memory when the map is modified.  The header of a
+**    prefix map file is padded so that the tree is aligned.
+**
 **    The bit size of the 'left' and 'right' members of the tree limit
 **    the number of unique blocks that can be assigned in the prefix
 **    map.  As of June 2011, the bit size size 32 bits, which limits
@@ -68,6 +74,15 @@
 **    Version 5: (SiLK-3.5.0) Key is an IPv6 address.  There is no
 **    dictionary, and the value represents the country code.
 **
+**
+**    When a prefix map is read from a stream, the tree is also
+**    compiled into a multibit trie that consumes 16 bits of the key
+**    at the root and 8 bits at each level below it, so a lookup
+**    visits a handful of tables instead of one node per bit.  The
+**    trie exists only in memory; it is discarded when the map is
+**    modified, and lookups fall back to walking the tree when the
+**    trie could not be built.
+**
 */
 
 #include <silk/silk.h>
@@ -94,6 +109,12 @@ typedef struct skPrefixMapRecord_st {
 struct skPrefixMap_st {
     /* the nodes that make up the tree */
     skPrefixMapRecord_t    *tree;
+    /* the tree compiled into a multibit trie for lookups, or NULL */
+    uint32_t               *trie;
+    /* pointer to the mmap()ed file that holds 'tree', or NULL */
+    void                   *mapped_file;
+    /* the size of the mmap()ed space */
+    size_t                  mapped_size;
     /* the name of the map */
     char                   *mapname;
     /* all terms in dictionary joined by '\0', or NULL for vers 1,5 */
@@ -120,6 +141,10 @@ struct skPrefixMap_st {
     struct rbtree          *word_map;
     /* Memory pool for word map entries */
     sk_mempool_t           *word_map_pool;
+    /* number of entries in 'trie' that are in use */
+    uint32_t                trie_used;
+    /* number of entries allocated to 'trie' */
+    uint32_t                trie_size;
     /* type of data in the map */
     skPrefixMapContent_t    content_type;
 };
@@ -157,6 +182,25 @@ typedef struct sk_hentry_prefixmap_st {
 #define SKPMAP_WORDS_COUNT_INIT    8192
 #define SKPMAP_WORDS_COUNT_GROW    2048
 
+/* The alignment of the data section of a prefix map file (the record
+ * count followed by the tree) that allows the file to be mmap()ed */
+#define SKPMAP_DATA_ALIGN          sizeof(uint32_t)
+
+/* The compiled trie is an array of tables of uint32_t entries.  Each
+ * entry is either a leaf (SKPMAP_IS_LEAF() is true) or the position
+ * in the array of the table for the next level.  The root table is
+ * indexed by the 16 most significant bits of the key, and each table
+ * below it by the next 8 bits, so an IPv4 or proto-port lookup makes
+ * at most 3 loads and an IPv6 lookup at most 15. */
+#define SKPMAP_TRIE_ROOT_BITS      16
+#define SKPMAP_TRIE_STRIDE         8
+
+/* The initial number of entries allocated to the compiled trie and
+ * the maximum; when the trie would need more entries than the
+ * maximum, lookups use the tree */
+#define SKPMAP_TRIE_SIZE_INIT      (1 << 18)
+#define SKPMAP_TRIE_SIZE_MAX       (1 << 25)
+
 
 #define SKPMAP_KEY_FROM_PROTO_PORT(kfpp)                \
     ((((skPrefixMapProtoPort_t*)(kfpp))->proto << 16)   \
@@ -221,6 +265,9 @@ prefixMapGrowTree(
 static sk_header_entry_t *
 prefixMapHentryCreate(
     const char         *mapname);
+static void
+prefixMapTrieDestroy(
+    skPrefixMap_t      *map);
 static int
 prefixMapWordCompare(
     const void         *va,
@@ -477,6 +524,38 @@ prefixMapAdd128(
 #endif  /* SK_ENABLE_IPV6 */
 
 
+/*
+ *  err = prefixMapCopyOnWrite(map);
+ *
+ *    Change the prefix map 'map' so that its tree is held in
+ *    allocated memory instead of the mmap()ed file.  Return
+ *    SKPREFIXMAP_OK on success or SKPREFIXMAP_ERR_MEMORY if memory
+ *    cannot be allocated.
+ */
+static skPrefixMapErr_t
+prefixMapCopyOnWrite(
+    skPrefixMap_t      *map)
+{
+    skPrefixMapRecord_t *tree;
+
+    assert(map->mapped_file && map->mapped_size);
+
+    tree = ((skPrefixMapRecord_t*)
+            malloc(map->tree_size * sizeof(skPrefixMapRecord_t)));
+    if (NULL == tree) {
+        return SKPREFIXMAP_ERR_MEMORY;
+    }
+    memcpy(tree, map->tree, map->tree_used * sizeof(skPrefixMapRecord_t));
+    map->tree = tree;
+
+    munmap(map->mapped_file, map->mapped_size);
+    map->mapped_file = NULL;
+    map->mapped_size = 0;
+
+    return SKPREFIXMAP_OK;
+}
+
+
 /*
  *  err = prefixMapDictionaryInsertHelper(map, pdict_val, word);
  *
@@ -1030,68 +1109,18 @@ prefixMapGrowTree(
 
 
 /*
- *    Given an input stream 'in' positioned at the beginning of the
- *    dictionary section of a prefix map file (specifically at the
- *    byte-length of the dictionary), create all the dictionary
- *    structures and read the dictionary entries into those
- *    structures.  The 'swap_flag' is true if the data in the stream
- *    is not in native byte order.
+ *    Given a prefix map 'map' whose 'dict_buf' holds the dictionary
+ *    entries read from a file, create the structures that index the
+ *    dictionary entries.
  */
 static skPrefixMapErr_t
-prefixMapReadDictionary(
-    skPrefixMap_t      *map,
-    skstream_t         *in,
-    int                 swap_flag)
+prefixMapIndexDictionary(
+    skPrefixMap_t      *map)
 {
-    char errbuf[2 * PATH_MAX];
     char *current;
     char *start;
     char *end;
     uint32_t i;
-    ssize_t rv;
-
-    /* Get number of bytes in the dictionary */
-    rv = skStreamRead(in, &(map->dict_buf_size), sizeof(uint32_t));
-    if (rv != (ssize_t)sizeof(uint32_t)) {
-        if (-1 == rv) {
-            skStreamLastErrMessage(in, rv, errbuf, sizeof(errbuf));
-        } else {
-            snprintf(errbuf, sizeof(errbuf),
-                     "read %" SK_PRIdZ " bytes of %" SK_PRIuZ " expected",
-                     rv, sizeof(map->dict_buf_size));
-        }
-        skAppPrintErr("Failed to read dictionary entry count (%s)", errbuf);
-        return SKPREFIXMAP_ERR_IO;
-    }
-    if (swap_flag) {
-        map->dict_buf_size = BSWAP32(map->dict_buf_size);
-    }
-    if (0 == map->dict_buf_size) {
-        /* odd, but allow it */
-        return SKPREFIXMAP_OK;
-    }
-
-    map->dict_buf = (char*)malloc(map->dict_buf_size * sizeof(char));
-    if (NULL == map->dict_buf) {
-        skAppPrintErr("Failed to allocate prefix map dictionary");
-        return SKPREFIXMAP_ERR_MEMORY;
-    }
-
-    /* Dictionary is allocated; now read the data. */
-    rv = skStreamRead(in, map->dict_buf, map->dict_buf_size);
-    if (rv != (ssize_t)map->dict_buf_size) {
-        if (-1 == rv) {
-            skStreamLastErrMessage(in, rv, errbuf, sizeof(errbuf));
-        } else {
-            snprintf(errbuf, sizeof(errbuf),
-                     "read %" SK_PRIdZ " bytes of %" PRIu32 " expected",
-                     rv, map->dict_buf_size);
-        }
-        skAppPrintErr("Failed to read dictionary entries (%s)", errbuf);
-        return SKPREFIXMAP_ERR_IO;
-    }
-    map->dict_buf_end = map->dict_buf_size;
-    map->dict_buf_used = map->dict_buf_size;
 
     /* Index the dictionary data */
 
@@ -1177,6 +1206,401 @@ prefixMapReadDictionary(
 }
 
 
+/*
+ *    Given an input stream 'in' positioned at the beginning of the
+ *    dictionary section of a prefix map file (specifically at the
+ *    byte-length of the dictionary), create all the dictionary
+ *    structures and read the dictionary entries into those
+ *    structures.  The 'swap_flag' is true if the data in the stream
+ *    is not in native byte order.
+ */
+static skPrefixMapErr_t
+prefixMapReadDictionary(
+    skPrefixMap_t      *map,
+    skstream_t         *in,
+    int                 swap_flag)
+{
+    char errbuf[2 * PATH_MAX];
+    ssize_t rv;
+
+    /* Get number of bytes in the dictionary */
+    rv = skStreamRead(in, &(map->dict_buf_size), sizeof(uint32_t));
+    if (rv != (ssize_t)sizeof(uint32_t)) {
+        if (-1 == rv) {
+            skStreamLastErrMessage(in, rv, errbuf, sizeof(errbuf));
+        } else {
+            snprintf(errbuf, sizeof(errbuf),
+                     "read %" SK_PRIdZ " bytes of %" SK_PRIuZ " expected",
+                     rv, sizeof(map->dict_buf_size));
+        }
+        skAppPrintErr("Failed to read dictionary entry count (%s)", errbuf);
+        return SKPREFIXMAP_ERR_IO;
+    }
+    if (swap_flag) {
+        map->dict_buf_size = BSWAP32(map->dict_buf_size);
+    }
+    if (0 == map->dict_buf_size) {
+        /* odd, but allow it */
+        return SKPREFIXMAP_OK;
+    }
+
+    map->dict_buf = (char*)malloc(map->dict_buf_size * sizeof(char));
+    if (NULL == map->dict_buf) {
+        skAppPrintErr("Failed to allocate prefix map dictionary");
+        return SKPREFIXMAP_ERR_MEMORY;
+    }
+
+    /* Dictionary is allocated; now read the data. */
+    rv = skStreamRead(in, map->dict_buf, map->dict_buf_size);
+    if (rv != (ssize_t)map->dict_buf_size) {
+        if (-1 == rv) {
+            skStreamLastErrMessage(in, rv, errbuf, sizeof(errbuf));
+        } else {
+            snprintf(errbuf, sizeof(errbuf),
+                     "read %" SK_PRIdZ " bytes of %" PRIu32 " expected",
+                     rv, map->dict_buf_size);
+        }
+        skAppPrintErr("Failed to read dictionary entries (%s)", errbuf);
+        return SKPREFIXMAP_ERR_IO;
+    }
+    map->dict_buf_end = map->dict_buf_size;
+    map->dict_buf_used = map->dict_buf_size;
+
+    return prefixMapIndexDictionary(map);
+}
+
+
+/*
+ *  err = prefixMapReadMmap(map, in, has_dictionary);
+ *
+ *    Attempt to mmap() the prefix map file that 'in' is reading,
+ *    where 'in' is positioned immediately after the file's header and
+ *    the file is in native byte order.  On success, point the 'tree'
+ *    member of 'map' into the mapped file, read the dictionary from
+ *    the mapped file when 'has_dictionary' is true, and return
+ *    SKPREFIXMAP_OK.
+ *
+ *    If the file cannot be mapped, return SKPREFIXMAP_OK and leave
+ *    the 'mapped_file' member of 'map' as NULL; the caller should
+ *    read the map from 'in', which has not been modified.  Return an
+ *    error code if the dictionary cannot be indexed.
+ */
+static skPrefixMapErr_t
+prefixMapReadMmap(
+    skPrefixMap_t      *map,
+    skstream_t         *in,
+    int                 has_dictionary)
+{
+    const uint8_t *buf;
+    const uint8_t *end;
+    uint32_t record_count;
+    off_t file_size;
+    off_t data_start;
+
+    if (!skStreamIsSeekable(in)) {
+        return SKPREFIXMAP_OK;
+    }
+    data_start = skStreamTell(in);
+    if ((data_start <= 0) || (0 != data_start % SKPMAP_DATA_ALIGN)) {
+        return SKPREFIXMAP_OK;
+    }
+    file_size = skFileSize(skStreamGetPathname(in));
+    if ((file_size <= data_start)
+        || ((uint64_t)file_size > (uint64_t)SIZE_MAX))
+    {
+        return SKPREFIXMAP_OK;
+    }
+
+    map->mapped_size = (size_t)file_size;
+    map->mapped_file = mmap(0, map->mapped_size, PROT_READ, MAP_SHARED,
+                            skStreamGetDescriptor(in), 0);
+    if (MAP_FAILED == map->mapped_file) {
+        map->mapped_file = NULL;
+        map->mapped_size = 0;
+        return SKPREFIXMAP_OK;
+    }
+    buf = (const uint8_t*)map->mapped_file + data_start;
+    end = (const uint8_t*)map->mapped_file + map->mapped_size;
+
+    /* get the record count and ensure the tree is in the file */
+    if ((size_t)(end - buf) < sizeof(record_count)) {
+        goto UNMAP;
+    }
+    memcpy(&record_count, buf, sizeof(record_count));
+    buf += sizeof(record_count);
+    if ((record_count < 1)
+        || ((size_t)(end - buf) / sizeof(skPrefixMapRecord_t) < record_count))
+    {
+        goto UNMAP;
+    }
+    map->tree = (skPrefixMapRecord_t*)buf;
+    map->tree_size = record_count;
+    map->tree_used = record_count;
+    buf += record_count * sizeof(skPrefixMapRecord_t);
+
+    if (!has_dictionary) {
+        return SKPREFIXMAP_OK;
+    }
+
+    /* copy the dictionary into memory, since it may be modified */
+    if ((size_t)(end - buf) < sizeof(map->dict_buf_size)) {
+        goto UNMAP;
+    }
+    memcpy(&map->dict_buf_size, buf, sizeof(map->dict_buf_size));
+    buf += sizeof(map->dict_buf_size);
+    if (0 == map->dict_buf_size) {
+        /* odd, but allow it */
+        return SKPREFIXMAP_OK;
+    }
+    if ((size_t)(end - buf) < map->dict_buf_size) {
+        goto UNMAP;
+    }
+    map->dict_buf = (char*)malloc(map->dict_buf_size * sizeof(char));
+    if (NULL == map->dict_buf) {
+        skAppPrintErr("Failed to allocate prefix map dictionary");
+        return SKPREFIXMAP_ERR_MEMORY;
+    }
+    memcpy(map->dict_buf, buf, map->dict_buf_size);
+    map->dict_buf_end = map->dict_buf_size;
+    map->dict_buf_used = map->dict_buf_size;
+
+    return prefixMapIndexDictionary(map);
+
+  UNMAP:
+    /* the file is too short; let the caller read it and report the
+     * error */
+    munmap(map->mapped_file, map->mapped_size);
+    map->mapped_file = NULL;
+    map->mapped_size = 0;
+    map->tree = NULL;
+    map->tree_size = 0;
+    map->tree_used = 0;
+    map->dict_buf_size = 0;
+    return SKPREFIXMAP_OK;
+}
+
+
+/*
+ *  ok = prefixMapTrieAddTable(map, &table);
+ *
+ *    Reserve a table of 2^'SKPMAP_TRIE_STRIDE' entries in the
+ *    compiled trie of 'map', growing the trie as needed, and set
+ *    'table' to the position of its first entry.  Return 0 on
+ *    success, or -1 when the trie cannot grow.
+ */
+static int
+prefixMapTrieAddTable(
+    skPrefixMap_t      *map,
+    uint32_t           *table)
+{
+    const uint32_t count = (1u << SKPMAP_TRIE_STRIDE);
+    uint32_t *old_trie;
+    uint32_t new_size;
+
+    if (map->trie_size - map->trie_used < count) {
+        if (map->trie_size >= SKPMAP_TRIE_SIZE_MAX) {
+            return -1;
+        }
+        new_size = 2 * map->trie_size;
+        old_trie = map->trie;
+        map->trie = (uint32_t*)realloc(old_trie, new_size * sizeof(uint32_t));
+        if (NULL == map->trie) {
+            map->trie = old_trie;
+            return -1;
+        }
+        map->trie_size = new_size;
+    }
+    *table = map->trie_used;
+    map->trie_used += count;
+    return 0;
+}
+
+
+/*
+ *  ok = prefixMapTrieFill(map, table, offset, bits, key_bits, node);
+ *
+ *    Fill the 2^'bits' entries of the compiled trie of 'map' that
+ *    begin at entry 'offset' of the table at position 'table' with
+ *    the subtree of 'map' rooted at 'node', where 'node' is either a
+ *    leaf or the index of a node in the tree.  'key_bits' is the
+ *    number of bits of the key that are not consumed by the tables
+ *    above this one.  Return 0 on success or -1 on failure.
+ */
+static int
+prefixMapTrieFill(
+    skPrefixMap_t      *map,
+    uint32_t            table,
+    uint32_t            offset,
+    int                 bits,
+    int                 key_bits,
+    uint32_t            node)
+{
+    uint32_t child;
+    uint32_t i;
+
+    if (SKPMAP_IS_LEAF(node)) {
+        for (i = table + offset; i < table + offset + (1u << bits); ++i) {
+            map->trie[i] = node;
+        }
+        return 0;
+    }
+    if (bits > 0) {
+        if (prefixMapTrieFill(map, table, offset, bits - 1, key_bits,
+                              map->tree[node].left))
+        {
+            return -1;
+        }
+        return prefixMapTrieFill(map, table, offset + (1u << (bits - 1)),
+                                 bits - 1, key_bits, map->tree[node].right);
+    }
+
+    /* the table is exhausted and 'node' is not a leaf; the subtree
+     * continues in a new table */
+    key_bits -= SKPMAP_TRIE_STRIDE;
+    if (key_bits < 0) {
+        /* This should be caught when the map is loaded. */
+        return -1;
+    }
+    if (prefixMapTrieAddTable(map, &child)) {
+        return -1;
+    }
+    map->trie[table + offset] = child;
+    return prefixMapTrieFill(map, child, 0, SKPMAP_TRIE_STRIDE, key_bits,
+                             node);
+}
+
+
+/*
+ *  prefixMapTrieCompile(map);
+ *
+ *    Compile the tree of 'map' into a multibit trie that
+ *    skPrefixMapFindValue() and skPrefixMapFindString() use for
+ *    lookups.  If the trie cannot be built, leave 'map' without one
+ *    so lookups walk the tree.
+ */
+static void
+prefixMapTrieCompile(
+    skPrefixMap_t      *map)
+{
+    int key_bits;
+
+    assert(NULL == map->trie);
+
+    switch (map->content_type) {
+#if SK_ENABLE_IPV6
+      case SKPREFIXMAP_CONT_ADDR_V6:
+        key_bits = 128;
+        break;
+#endif  /* SK_ENABLE_IPV6 */
+      case SKPREFIXMAP_CONT_ADDR_V4:
+      case SKPREFIXMAP_CONT_PROTO_PORT:
+        key_bits = 32;
+        break;
+      default:
+        return;
+    }
+
+    map->trie_size = SKPMAP_TRIE_SIZE_INIT;
+    map->trie = (uint32_t*)malloc(map->trie_size * sizeof(uint32_t));
+    if (NULL == map->trie) {
+        map->trie_size = 0;
+        return;
+    }
+    map->trie_used = (1u << SKPMAP_TRIE_ROOT_BITS);
+
+    if (prefixMapTrieFill(map, 0, 0, SKPMAP_TRIE_ROOT_BITS,
+                          key_bits - SKPMAP_TRIE_ROOT_BITS, 0))
+    {
+        prefixMapTrieDestroy(map);
+    }
+}
+
+
+/*
+ *  prefixMapTrieDestroy(map);
+ *
+ *    Free the compiled trie of 'map', if any.
+ */
+static void
+prefixMapTrieDestroy(
+    skPrefixMap_t      *map)
+{
+    free(map->trie);
+    map->trie = NULL;
+    map->trie_used = 0;
+    map->trie_size = 0;
+}
+
+
+/*
+ *  dict_val = prefixMapTrieFind(map, key);
+ *
+ *    Return the dict_val for 'key' using the compiled trie of 'map',
+ *    or SKPREFIXMAP_NOT_FOUND.  The caller must ensure 'map' has a
+ *    trie.
+ */
+static uint32_t
+prefixMapTrieFind(
+    const skPrefixMap_t    *map,
+    const void             *key)
+{
+    const uint32_t *trie = map->trie;
+    uint32_t entry;
+    uint32_t key32;
+    int shift;
+
+    switch (map->content_type) {
+#if SK_ENABLE_IPV6
+      case SKPREFIXMAP_CONT_ADDR_V6:
+        {
+            uint8_t key128[16];
+            const uint8_t *k;
+
+            skipaddrGetAsV6((const skipaddr_t*)key, key128);
+
+            /* the root consumes the first two octets; each table
+             * below it consumes one octet */
+            entry = trie[(key128[0] << 8) | key128[1]];
+            k = key128 + 2;
+            while (SKPMAP_IS_NODE(entry)) {
+                assert(k < key128 + sizeof(key128));
+                entry = trie[entry + *k];
+                ++k;
+            }
+            return SKPMAP_LEAF_VALUE(entry);
+        }
+#endif  /* SK_ENABLE_IPV6 */
+
+      case SKPREFIXMAP_CONT_PROTO_PORT:
+        key32 = SKPMAP_KEY_FROM_PROTO_PORT(key);
+        break;
+
+      case SKPREFIXMAP_CONT_ADDR_V4:
+#if !SK_ENABLE_IPV6
+        key32 = skipaddrGetV4((const skipaddr_t*)key);
+#else
+        if (skipaddrGetAsV4((const skipaddr_t*)key, &key32)) {
+            return SKPREFIXMAP_NOT_FOUND;
+        }
+#endif
+        break;
+
+      default:
+        skAbortBadCase(map->content_type);
+    }
+
+    shift = 32 - SKPMAP_TRIE_ROOT_BITS;
+    entry = trie[key32 >> shift];
+    while (SKPMAP_IS_NODE(entry)) {
+        assert(shift > 0);
+        shift -= SKPMAP_TRIE_STRIDE;
+        entry = trie[entry + ((key32 >> shift)
+                              & ((1u << SKPMAP_TRIE_STRIDE) - 1))];
+    }
+    return SKPMAP_LEAF_VALUE(entry);
+}
+
+
 /*
  *    Ensure that 'map' is a valid prefix map and adjust the
  *    'tree_used' member of 'map' to number of valid nodes in the
@@ -1190,8 +1614,11 @@ prefixMapValidate(
 #define MAX_DEPTH 128
     uint32_t path[MAX_DEPTH];
     uint8_t lr[MAX_DEPTH];
+    uint8_t *node_depth;
     int depth;
     int max_seen;
+    int is_forward;
+    int child;
     uint32_t branch;
     uint32_t max_key_used;
     uint32_t i;
@@ -1238,9 +1665,52 @@ prefixMapValidate(
         record_count = i;
     }
 
-    /* Traverse the tree to find chains that are longer than 32 or 128
-     * steps. depth is current level in tree (number of steps from
-     * root); max_seen is the maximum depth that has been seen */
+    /* Find chains that are longer than 32 or 128 steps.  max_seen is
+     * the maximum depth (number of steps from the root) that has been
+     * seen.
+     *
+     * When every child follows its parent in the array, as is true of
+     * every tree that SiLK writes, the depth of each node is found in
+     * a single pass over the array, which is much faster than
+     * traversing a large tree.  Otherwise, traverse the tree. */
+    max_seen = 0;
+    is_forward = 0;
+    node_depth = (uint8_t*)calloc(record_count, sizeof(uint8_t));
+    if (node_depth) {
+        is_forward = 1;
+        for (i = 0; i < record_count && is_forward; ++i) {
+            depth = node_depth[i] + 1;
+            for (child = 0; child < 2; ++child) {
+                branch = (child ? map->tree[i].right : map->tree[i].left);
+                if (SKPMAP_IS_LEAF(branch)) {
+                    continue;
+                }
+                if (branch <= i) {
+                    is_forward = 0;
+                    break;
+                }
+                if (depth >= MAX_DEPTH) {
+                    free(node_depth);
+                    skAppPrintErr("Prefix map is malformed"
+                                  " (contains invalid depth)");
+                    return SKPREFIXMAP_ERR_IO;
+                }
+                if (depth > node_depth[branch]) {
+                    node_depth[branch] = (uint8_t)depth;
+                    if (depth > max_seen) {
+                        max_seen = depth;
+                    }
+                }
+            }
+        }
+        free(node_depth);
+    }
+    if (is_forward) {
+        goto CHECK_DEPTH;
+    }
+
+    /* Traverse the tree.  depth is current level in tree (number of
+     * steps from root) */
     depth = max_seen = 0;
 
     /* path[] contains the indexes of the nodes from the root to our
@@ -1284,6 +1754,7 @@ prefixMapValidate(
             }
         }
     }
+  CHECK_DEPTH:
     if (max_seen > 31) {
         switch (map->content_type) {
           case SKPREFIXMAP_CONT_ADDR_V6:
@@ -1330,6 +1801,14 @@ skPrefixMapAddRange(
         return SKPREFIXMAP_ERR_ARGS;
     }
 
+    /* the compiled trie no longer matches the tree */
+    if (map->trie) {
+        prefixMapTrieDestroy(map);
+    }
+    if (map->mapped_file && prefixMapCopyOnWrite(map)) {
+        return SKPREFIXMAP_ERR_MEMORY;
+    }
+
     switch (map->content_type) {
 #if SK_ENABLE_IPV6
       case SKPREFIXMAP_CONT_ADDR_V6:
@@ -1417,25 +1896,28 @@ skPrefixMapDelete(
     if (NULL == map) {
         return;
     }
-    if (map->tree != NULL) {
-        if (map->mapname) {
-            free(map->mapname);
-        }
-        if (map->dict_buf) {
-            free(map->dict_buf);
-        }
-        if (map->dict_words) {
-            free(map->dict_words);
-        }
-        if (map->tree) {
-            free(map->tree);
-        }
-        if (map->word_map) {
-            rbdestroy(map->word_map);
-        }
-        skMemoryPoolDestroy(&map->word_map_pool);
-        memset(map, 0, sizeof(skPrefixMap_t));
+    if (map->mapname) {
+        free(map->mapname);
+    }
+    if (map->dict_buf) {
+        free(map->dict_buf);
     }
+    if (map->dict_words) {
+        free(map->dict_words);
+    }
+    if (map->mapped_file) {
+        munmap(map->mapped_file, map->mapped_size);
+    } else if (map->tree) {
+        free(map->tree);
+    }
+    if (map->trie) {
+        free(map->trie);
+    }
+    if (map->word_map) {
+        rbdestroy(map->word_map);
+    }
+    skMemoryPoolDestroy(&map->word_map_pool);
+    memset(map, 0, sizeof(skPrefixMap_t));
     free(map);
 }
 
@@ -1623,6 +2105,11 @@ skPrefixMapFindString(
     size_t                  bufsize)
 {
     int depth;
+
+    if (map->trie) {
+        return skPrefixMapDictionaryGetEntry(map, prefixMapTrieFind(map, key),
+                                             out_buf, bufsize);
+    }
     return skPrefixMapDictionaryGetEntry(map, prefixMapFind(map, key, &depth),
                                          out_buf, bufsize);
 }
@@ -1635,6 +2122,10 @@ skPrefixMapFindValue(
     const void             *key)
 {
     int depth;
+
+    if (map->trie) {
+        return prefixMapTrieFind(map, key);
+    }
     return prefixMapFind(map, key, &depth);
 }
 
@@ -1991,44 +2482,12 @@ skPrefixMapRead(
 
     swap_flag = !skHeaderIsNativeByteOrder(hdr);
 
-    /* Read record count */
-    rv = skStreamRead(in, &record_count, sizeof(record_count));
-    if (rv != (ssize_t)sizeof(record_count)) {
-        if (-1 == rv) {
-            skStreamLastErrMessage(in, rv, errbuf, sizeof(errbuf));
-        } else {
-            snprintf(errbuf, sizeof(errbuf),
-                     "read %" SK_PRIdZ " bytes of %" SK_PRIuZ " expected",
-                     rv, sizeof(record_count));
-        }
-        skAppPrintErr("Failed to read record count (%s)", errbuf);
-        return SKPREFIXMAP_ERR_IO;
-    }
-
-    if (swap_flag) {
-        record_count = BSWAP32(record_count);
-    }
-    if (record_count < 1) {
-        skAppPrintErr(
-            "Input file contains invalid prefix map (record count is 0)");
-        return SKPREFIXMAP_ERR_HEADER;
-    }
-    tree_size = record_count * sizeof(skPrefixMapRecord_t);
-
-    /* Allocate a prefix map, and a storage buffer */
+    /* Allocate a prefix map */
     map = (skPrefixMap_t*)calloc(1, sizeof(skPrefixMap_t));
     if (NULL == map) {
         skAppPrintErr("Failed to allocate prefix map");
         return SKPREFIXMAP_ERR_MEMORY;
     }
-    map->tree = (skPrefixMapRecord_t*)malloc(tree_size);
-    if (NULL == map->tree) {
-        skAppPrintErr("Failed to allocate prefix map data");
-        err = SKPREFIXMAP_ERR_MEMORY;
-        goto ERROR;
-    }
-    map->tree_size = record_count;
-    map->tree_used = record_count;
 
     /* most files have a dictionary */
     has_dictionary = 1;
@@ -2080,35 +2539,82 @@ skPrefixMapRead(
         }
     }
 
-    /* Allocation completed successfully, read in the records. */
-    rv = skStreamRead(in, map->tree, tree_size);
-    if (rv != (ssize_t)(tree_size)) {
-        if (-1 == rv) {
-            skStreamLastErrMessage(in, rv, errbuf, sizeof(errbuf));
-        } else {
-            snprintf(errbuf, sizeof(errbuf),
-                     "read %" SK_PRIdZ " bytes of %" SK_PRIuZ " expected",
-                     rv, tree_size);
+    /* Use the tree in place when the file can be mmap()ed */
+    if (!swap_flag) {
+        err = prefixMapReadMmap(map, in, has_dictionary);
+        if (err) {
+            goto ERROR;
         }
-        skAppPrintErr("Failed to read record data (%s)", errbuf);
-        err = SKPREFIXMAP_ERR_IO;
-        goto ERROR;
     }
+    if (map->mapped_file) {
+        record_count = map->tree_used;
+    } else {
+        /* Read record count */
+        rv = skStreamRead(in, &record_count, sizeof(record_count));
+        if (rv != (ssize_t)sizeof(record_count)) {
+            if (-1 == rv) {
+                skStreamLastErrMessage(in, rv, errbuf, sizeof(errbuf));
+            } else {
+                snprintf(errbuf, sizeof(errbuf),
+                         "read %" SK_PRIdZ " bytes of %" SK_PRIuZ " expected",
+                         rv, sizeof(record_count));
+            }
+            skAppPrintErr("Failed to read record count (%s)", errbuf);
+            err = SKPREFIXMAP_ERR_IO;
+            goto ERROR;
+        }
 
-    /* Swap the byte order of the data if needed. */
-    if (swap_flag) {
-        for (i = 0; i < record_count; i++) {
-            map->tree[i].left = BSWAP32(map->tree[i].left);
-            map->tree[i].right = BSWAP32(map->tree[i].right);
+        if (swap_flag) {
+            record_count = BSWAP32(record_count);
         }
-    }
+        if (record_count < 1) {
+            skAppPrintErr(
+                "Input file contains invalid prefix map (record count is 0)");
+            err = SKPREFIXMAP_ERR_HEADER;
+            goto ERROR;
+        }
+        tree_size = record_count * sizeof(skPrefixMapRecord_t);
 
-    /* Allocate and read the dictionary. */
-    if (has_dictionary) {
-        err = prefixMapReadDictionary(map, in, swap_flag);
-        if (err) {
+        /* Allocate a storage buffer */
+        map->tree = (skPrefixMapRecord_t*)malloc(tree_size);
+        if (NULL == map->tree) {
+            skAppPrintErr("Failed to allocate prefix map data");
+            err = SKPREFIXMAP_ERR_MEMORY;
+            goto ERROR;
+        }
+        map->tree_size = record_count;
+        map->tree_used = record_count;
+
+        /* Allocation completed successfully, read in the records. */
+        rv = skStreamRead(in, map->tree, tree_size);
+        if (rv != (ssize_t)(tree_size)) {
+            if (-1 == rv) {
+                skStreamLastErrMessage(in, rv, errbuf, sizeof(errbuf));
+            } else {
+                snprintf(errbuf, sizeof(errbuf),
+                         "read %" SK_PRIdZ " bytes of %" SK_PRIuZ " expected",
+                         rv, tree_size);
+            }
+            skAppPrintErr("Failed to read record data (%s)", errbuf);
+            err = SKPREFIXMAP_ERR_IO;
             goto ERROR;
         }
+
+        /* Swap the byte order of the data if needed. */
+        if (swap_flag) {
+            for (i = 0; i < record_count; i++) {
+                map->tree[i].left = BSWAP32(map->tree[i].left);
+                map->tree[i].right = BSWAP32(map->tree[i].right);
+            }
+        }
+
+        /* Allocate and read the dictionary. */
+        if (has_dictionary) {
+            err = prefixMapReadDictionary(map, in, swap_flag);
+            if (err) {
+                goto ERROR;
+            }
+        }
     }
 
     /* Validate the prefix map */
@@ -2117,6 +2623,9 @@ skPrefixMapRead(
         goto ERROR;
     }
 
+    /* Compile the tree for lookups; on failure, lookups use the tree */
+    prefixMapTrieCompile(map);
+
     *map_parm = map;
     return SKPREFIXMAP_OK;
 
@@ -2211,6 +2720,12 @@ skPrefixMapSetDefaultVal(
         return SKPREFIXMAP_ERR_NOTEMPTY;
     }
 
+    if (map->trie) {
+        prefixMapTrieDestroy(map);
+    }
+    if (map->mapped_file && prefixMapCopyOnWrite(map)) {
+        return SKPREFIXMAP_ERR_MEMORY;
+    }
     map->tree[0].left = SKPMAP_MAKE_LEAF(dict_val);
     map->tree[0].right = SKPMAP_MAKE_LEAF(dict_val);
     return SKPREFIXMAP_OK;
@@ -2309,6 +2824,7 @@ skPrefixMapWrite(
     skHeaderSetRecordVersion(hdr, vers);
     skHeaderSetCompressionMethod(hdr, SK_COMPMETHOD_NONE);
     skHeaderSetRecordLength(hdr, 1);
+    skHeaderSetPaddingModulus(hdr, SKPMAP_DATA_ALIGN);
 
     /* add the prefixmap header if a mapname was given */
     if (map->mapname) {
@@ -12,6 +12,9 @@
 **   A la Bentley and McIlroy in Software - Practice and Experience,
 **   Vol. 23 (11) 1249-1265. Nov. 1993
 **
+**   skRadixSort() is the "American flag sort" of McIlroy, Bostic,
+**   and McIlroy, "Engineering Radix Sort", Computing Systems,
+**   Vol. 6 (1) 5-27. 1993
 **
 */
 
@@ -175,6 +178,105 @@ skQSort(
 }
 
 
+/*
+ *    Buckets with fewer than this number of elements are sorted by
+ *    skRadixSort() using an insertion sort.
+ */
+#define RADIX_INSERTION_THRESHOLD  32
+
+/*
+ *  radixSort(a, n, es, depth, key_len, swaptype);
+ *
+ *    Helper for skRadixSort().  Sort the 'n' elements of size 'es'
+ *    in 'a' whose first 'depth' octets are identical by the octets
+ *    from 'depth' to 'key_len'.  This is an in-place MSD radix sort
+ *    ("American flag sort") that recurses into each bucket.
+ */
+static void
+radixSort(
+    char               *a,
+    size_t              n,
+    size_t              es,
+    size_t              depth,
+    size_t              key_len,
+    int                 swaptype)
+{
+    size_t count[256];
+    size_t next[256];
+    size_t pos;
+    char *pl, *pm;
+    unsigned int b;
+    unsigned int c;
+
+    for ( ; depth < key_len; ++depth) {
+        if (n < RADIX_INSERTION_THRESHOLD) {
+            for (pm = a + es; pm < a + n * es; pm += es) {
+                for (pl = pm;
+                     (pl > a
+                      && memcmp(pl - es + depth, pl + depth, key_len - depth)
+                      > 0);
+                     pl -= es)
+                {
+                    swapfunc(pl, pl - es, es, swaptype);
+                }
+            }
+            return;
+        }
+
+        memset(count, 0, sizeof(count));
+        for (pm = a + depth; pm < a + n * es; pm += es) {
+            ++count[*(uint8_t*)pm];
+        }
+        if (count[*(uint8_t*)(a + depth)] == n) {
+            /* every element has the same octet; move to the next */
+            continue;
+        }
+
+        /* move each element into its bucket */
+        for (b = 0, pos = 0; b < 256; pos += count[b], ++b) {
+            next[b] = pos;
+        }
+        for (b = 0, pos = 0; b < 256; pos += count[b], ++b) {
+            while (next[b] < pos + count[b]) {
+                pm = a + next[b] * es;
+                c = *(uint8_t*)(pm + depth);
+                if (c == b) {
+                    ++next[b];
+                } else {
+                    swapfunc(pm, a + next[c] * es, es, swaptype);
+                    ++next[c];
+                }
+            }
+        }
+
+        /* sort each bucket by the remaining octets */
+        for (b = 0, pos = 0; b < 256; pos += count[b], ++b) {
+            if (count[b] > 1) {
+                radixSort(a + pos * es, count[b], es, depth + 1, key_len,
+                          swaptype);
+            }
+        }
+        return;
+    }
+}
+
+
+void
+skRadixSort(
+    void               *a,
+    size_t              n,
+    size_t              es,
+    size_t              key_len)
+{
+    int swaptype;
+
+    assert(key_len <= es);
+
+    SWAPINIT(a, es);
+    radixSort((char*)a, n, es, 0, key_len, swaptype);
+}
+
+
 /*
 ** Local Variables:
 ** mode:c
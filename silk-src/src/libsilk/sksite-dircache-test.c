@@ -0,0 +1,176 @@
+/*
+** Copyright (C) 2005-2017 by Carnegie Mellon University.
+**
+** @OPENSOURCE_LICENSE_START@
+** See license information in ../../LICENSE.txt
+** @OPENSOURCE_LICENSE_END@
+*/
+
+/*
+**  Test the directory listing cache used by sksiteRepoFileExists().
+**
+**  Takes the name of an empty, writable directory as its argument.
+**
+*/
+
+
+#include <silk/silk.h>
+
+RCSIDENT("$SiLK: sksite-dircache-test.c $");
+
+#include <silk/sksite.h>
+#include <silk/utils.h>
+#include <utime.h>
+
+
+/* number of files created in the test directory; larger than the
+ * number of probes sksiteRepoFileExists() makes before it reads a
+ * directory's listing */
+#define FILE_COUNT  16
+
+#define TEST(s)    fprintf(stderr, "%s...", s);
+#define RESULT(b)                                                       \
+    if ((b)) {                                                          \
+        fprintf(stderr, "ok\n");                                        \
+    } else {                                                            \
+        fprintf(stderr, "failed at %s:%d\n", __FILE__, __LINE__);       \
+        exit(EXIT_FAILURE);                                             \
+    }
+
+
+static void
+makeFile(
+    const char         *path)
+{
+    FILE *fp;
+
+    fp = fopen(path, "w");
+    if (NULL == fp) {
+        skAppPrintSyserror("Unable to create '%s'", path);
+        exit(EXIT_FAILURE);
+    }
+    fclose(fp);
+}
+
+/*
+ *    Set the modification time of 'dirname' 'age' seconds into the
+ *    past so that the listing the cache reads is trusted.
+ */
+static void
+ageDirectory(
+    const char         *dirname,
+    time_t              age)
+{
+    struct utimbuf ut;
+
+    ut.actime = ut.modtime = time(NULL) - age;
+    if (utime(dirname, &ut)) {
+        skAppPrintSyserror("Unable to set time on '%s'", dirname);
+        exit(EXIT_FAILURE);
+    }
+}
+
+/*
+ *    Probe each of the FILE_COUNT files in 'dirname' and return the
+ *    number that sksiteRepoFileExists() reports as present.
+ */
+static int
+probeFiles(
+    const char         *dirname)
+{
+    char path[PATH_MAX];
+    int found = 0;
+    int i;
+
+    for (i = 0; i < FILE_COUNT; ++i) {
+        snprintf(path, sizeof(path), "%s/file-%02d", dirname, i);
+        found += sksiteRepoFileExists(path);
+    }
+    return found;
+}
+
+
+int main(int argc, char **argv)
+{
+    SILK_FEATURES_DEFINE_STRUCT(features);
+    char subdir[PATH_MAX];
+    /* large enough for 'subdir' and a file name */
+    char path[PATH_MAX + 16];
+    const char *dirname;
+    int i;
+
+    skAppRegister(argv[0]);
+    skAppVerifyFeatures(&features, NULL);
+
+    if (argc != 2) {
+        fprintf(stderr, "Usage: %s <empty-directory>\n", skAppName());
+        exit(EXIT_FAILURE);
+    }
+    dirname = argv[1];
+
+    /* create every other file, then probe all of them so the
+     * directory's listing is read and cached */
+    for (i = 0; i < FILE_COUNT; i += 2) {
+        snprintf(path, sizeof(path), "%s/file-%02d", dirname, i);
+        makeFile(path);
+    }
+    ageDirectory(dirname, 60);
+
+    TEST("sksiteRepoFileExists finds existing files");
+    RESULT(FILE_COUNT / 2 == probeFiles(dirname));
+
+    /* within a pass, the listing is not checked again */
+    TEST("sksiteRepoFileExists uses listing for rest of pass");
+    snprintf(path, sizeof(path), "%s/file-%02d", dirname, 1);
+    makeFile(path);
+    RESULT(0 == sksiteRepoFileExists(path));
+
+    TEST("sksiteRepoFileExists sees file created after listing");
+    sksiteRepoFileCacheRevalidate();
+    RESULT(1 == sksiteRepoFileExists(path)
+           && FILE_COUNT / 2 + 1 == probeFiles(dirname));
+
+    /* give the directory a new time so the next listing is trusted */
+    ageDirectory(dirname, 120);
+    sksiteRepoFileCacheRevalidate();
+    probeFiles(dirname);
+
+    TEST("sksiteRepoFileExists sees file removed after listing");
+    snprintf(path, sizeof(path), "%s/file-%02d", dirname, 0);
+    if (unlink(path)) {
+        skAppPrintSyserror("Unable to remove '%s'", path);
+        exit(EXIT_FAILURE);
+    }
+    sksiteRepoFileCacheRevalidate();
+    RESULT(0 == sksiteRepoFileExists(path)
+           && FILE_COUNT / 2 == probeFiles(dirname));
+
+    /* probe a directory that does not exist; it is cached as empty */
+    snprintf(subdir, sizeof(subdir), "%s/subdir", dirname);
+    TEST("sksiteRepoFileExists handles missing directory");
+    RESULT(0 == probeFiles(subdir));
+
+    TEST("sksiteRepoFileExists sees directory created after listing");
+    if (mkdir(subdir, 0755)) {
+        skAppPrintSyserror("Unable to create '%s'", subdir);
+        exit(EXIT_FAILURE);
+    }
+    snprintf(path, sizeof(path), "%s/file-%02d", subdir, 3);
+    makeFile(path);
+    sksiteRepoFileCacheRevalidate();
+    RESULT(1 == sksiteRepoFileExists(path) && 1 == probeFiles(subdir));
+
+    sksiteRepoFileCacheClear();
+    skAppUnregister();
+
+    return 0;
+}
+
+
+/*
+** Local Variables:
+** mode:c
+** indent-tabs-mode:nil
+** c-basic-offset:4
+** End:
+*/
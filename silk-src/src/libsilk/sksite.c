@@ -546,6 +546,8 @@ sksiteTeardown(
         }
         skVectorDestroy(sensor_list);
     }
+
+    sksiteRepoFileCacheClear();
 }
 
 
@@ -4077,6 +4079,433 @@ typedef struct sensor_flowtype_st {
 } sensor_flowtype_t;
 
 
+/*
+ *    The number of times sksiteRepoFileExists() calls stat() on files
+ *    in a directory before it reads the directory's listing.
+ */
+#define SITE_DIRCACHE_PROBES        4
+
+/*
+ *    The maximum number of directories whose listings are cached.
+ *    When the cache is full, the least recently used listing is
+ *    discarded.
+ */
+#define SITE_DIRCACHE_MAX_DIRS    256
+
+/*
+ *    A file in a cached directory listing.
+ */
+typedef struct site_dircache_file_st {
+    /* the file's name */
+    const char         *name;
+    /* offset of the name in the directory's 'names' buffer; used
+     * while the listing is being read */
+    size_t              offset;
+    /* whether readdir() did not report the file as a regular file or
+     * a FIFO, so that skFileExists() must be used to check it */
+    unsigned            verify :1;
+} site_dircache_file_t;
+
+/*
+ *    A directory in the cache used by sksiteRepoFileExists().
+ */
+typedef struct site_dircache_dir_st {
+    /* the directory's path; NULL when this entry is unused */
+    char                   *dirname;
+    /* the files in the directory sorted by name */
+    site_dircache_file_t   *files;
+    /* the names of the files */
+    char                   *names;
+    /* number of entries in 'files' */
+    size_t                  file_count;
+    /* the value of 'site_dircache_clock' when last used */
+    uint64_t                last_use;
+    /* the directory's modification time, device, and inode when the
+     * listing was read; used to detect a stale listing */
+    time_t                  mtime;
+    dev_t                   dev;
+    ino_t                   ino;
+    /* the time when the listing was read */
+    time_t                  read_time;
+    /* the value of 'site_dircache_pass' when the listing was read or
+     * last checked against the directory */
+    uint64_t                checked_pass;
+    /* hash of 'dirname' */
+    uint32_t                hash;
+    /* number of times a file in the directory has been probed */
+    uint32_t                probes;
+    /* whether 'files' holds the directory's listing */
+    unsigned                listed  :1;
+    /* whether the listing could not be read */
+    unsigned                nocache :1;
+    /* whether the directory did not exist when the listing was read */
+    unsigned                missing :1;
+} site_dircache_dir_t;
+
+/* the directories in the cache; allocated on first use */
+static site_dircache_dir_t *site_dircache = NULL;
+
+/* incremented on each use of the cache */
+static uint64_t site_dircache_clock = 0;
+
+/* incremented by sksiteRepoFileCacheRevalidate(); a listing is
+ * checked against its directory once per pass */
+static uint64_t site_dircache_pass = 0;
+
+/* whether the cache is enabled: -1 until SILK_REPO_DIRCACHE_ENVAR
+ * has been checked, then 0 or 1 */
+static int site_dircache_enabled = -1;
+
+
+/*
+ *  cmp = siteDircacheCompare(a, b);
+ *
+ *    Compare the names of the site_dircache_file_t objects 'a' and
+ *    'b'.
+ */
+static int
+siteDircacheCompare(
+    const void         *v_a,
+    const void         *v_b)
+{
+    return strcmp(((const site_dircache_file_t*)v_a)->name,
+                  ((const site_dircache_file_t*)v_b)->name);
+}
+
+
+/*
+ *  siteDircacheFreeDir(dir);
+ *
+ *    Free the listing and name of the cached directory 'dir' and mark
+ *    the entry as unused.
+ */
+static void
+siteDircacheFreeDir(
+    site_dircache_dir_t    *dir)
+{
+    free(dir->dirname);
+    free(dir->files);
+    free(dir->names);
+    memset(dir, 0, sizeof(*dir));
+}
+
+
+/*
+ *  siteDircacheDropListing(dir);
+ *
+ *    Discard the listing of the cached directory 'dir' so that
+ *    sksiteRepoFileExists() reads the directory again.  The probe
+ *    count is reset so that a directory that is changing rapidly is
+ *    checked with stat() until it settles.
+ */
+static void
+siteDircacheDropListing(
+    site_dircache_dir_t    *dir)
+{
+    free(dir->files);
+    free(dir->names);
+    dir->files = NULL;
+    dir->names = NULL;
+    dir->file_count = 0;
+    dir->probes = 0;
+    dir->listed = 0;
+    dir->missing = 0;
+}
+
+
+/*
+ *  dir = siteDircacheGetDir(path, dirname_len);
+ *
+ *    Return the cache entry for the directory whose name is the first
+ *    'dirname_len' characters of 'path', creating it if necessary.
+ *    Return NULL on allocation error.
+ */
+static site_dircache_dir_t *
+siteDircacheGetDir(
+    const char         *path,
+    size_t              dirname_len)
+{
+    site_dircache_dir_t *dir;
+    site_dircache_dir_t *oldest;
+    uint32_t hash;
+    size_t i;
+
+    if (NULL == site_dircache) {
+        site_dircache = ((site_dircache_dir_t*)
+                         calloc(SITE_DIRCACHE_MAX_DIRS,
+                                sizeof(site_dircache_dir_t)));
+        if (NULL == site_dircache) {
+            return NULL;
+        }
+    }
+
+    /* FNV-1a hash of the directory name */
+    hash = 2166136261u;
+    for (i = 0; i < dirname_len; ++i) {
+        hash = (hash ^ (uint8_t)path[i]) * 16777619u;
+    }
+
+    ++site_dircache_clock;
+    oldest = site_dircache;
+    for (i = 0, dir = site_dircache; i < SITE_DIRCACHE_MAX_DIRS; ++i, ++dir) {
+        if (NULL == dir->dirname) {
+            oldest = dir;
+            break;
+        }
+        if (dir->hash == hash
+            && 0 == strncmp(dir->dirname, path, dirname_len)
+            && '\0' == dir->dirname[dirname_len])
+        {
+            dir->last_use = site_dircache_clock;
+            return dir;
+        }
+        if (dir->last_use < oldest->last_use) {
+            oldest = dir;
+        }
+    }
+
+    /* not found; replace the unused or least recently used entry */
+    dir = oldest;
+    siteDircacheFreeDir(dir);
+    dir->dirname = (char*)malloc(dirname_len + 1);
+    if (NULL == dir->dirname) {
+        return NULL;
+    }
+    memcpy(dir->dirname, path, dirname_len);
+    dir->dirname[dirname_len] = '\0';
+    dir->hash = hash;
+    dir->last_use = site_dircache_clock;
+    return dir;
+}
+
+
+/*
+ *  status = siteDircacheRead(dir);
+ *
+ *    Read the listing of the directory 'dir' and sort it.  A
+ *    directory that does not exist is treated as empty.  Return 0 on
+ *    success, or -1 if the directory cannot be read or on allocation
+ *    error.
+ */
+static int
+siteDircacheRead(
+    site_dircache_dir_t    *dir)
+{
+    site_dircache_file_t *files = NULL;
+    site_dircache_file_t *tmp_files;
+    char *names = NULL;
+    char *tmp_names;
+    size_t names_len = 0;
+    size_t names_cap = 0;
+    size_t count = 0;
+    size_t cap = 0;
+    struct dirent *entry;
+    struct stat st;
+    DIR *dp;
+    size_t len;
+    size_t i;
+
+    /* note the time before reading the directory; a listing read in
+     * the same second the directory was modified cannot be trusted
+     * since a later change in that second does not alter st_mtime */
+    dir->read_time = time(NULL);
+    dir->checked_pass = site_dircache_pass;
+    if (-1 == stat(dir->dirname, &st)) {
+        if (ENOENT == errno || ENOTDIR == errno) {
+            dir->missing = 1;
+            dir->listed = 1;
+            return 0;
+        }
+        return -1;
+    }
+    dir->mtime = st.st_mtime;
+    dir->dev = st.st_dev;
+    dir->ino = st.st_ino;
+
+    dp = opendir(dir->dirname);
+    if (NULL == dp) {
+        if (ENOENT == errno || ENOTDIR == errno) {
+            /* removed since the stat(); the next lookup notices */
+            dir->listed = 1;
+            return 0;
+        }
+        return -1;
+    }
+
+    while ((entry = readdir(dp)) != NULL) {
+#ifdef DT_DIR
+        if (DT_DIR == entry->d_type) {
+            continue;
+        }
+#endif
+        if (count == cap) {
+            cap = ((cap) ? 2 * cap : 256);
+            tmp_files = ((site_dircache_file_t*)
+                         realloc(files, cap * sizeof(site_dircache_file_t)));
+            if (NULL == tmp_files) {
+                goto ERROR;
+            }
+            files = tmp_files;
+        }
+        len = 1 + strlen(entry->d_name);
+        if (names_len + len > names_cap) {
+            names_cap = ((names_cap) ? 2 * names_cap : 8192);
+            if (names_cap < names_len + len) {
+                names_cap = names_len + len;
+            }
+            tmp_names = (char*)realloc(names, names_cap);
+            if (NULL == tmp_names) {
+                goto ERROR;
+            }
+            names = tmp_names;
+        }
+        memcpy(names + names_len, entry->d_name, len);
+        files[count].offset = names_len;
+#ifdef DT_REG
+        files[count].verify = (DT_REG != entry->d_type
+                               && DT_FIFO != entry->d_type);
+#else
+        files[count].verify = 1;
+#endif
+        names_len += len;
+        ++count;
+    }
+    closedir(dp);
+
+    for (i = 0; i < count; ++i) {
+        files[i].name = names + files[i].offset;
+    }
+    if (count > 1) {
+        skQSort(files, count, sizeof(site_dircache_file_t),
+                &siteDircacheCompare);
+    }
+
+    dir->files = files;
+    dir->names = names;
+    dir->file_count = count;
+    dir->listed = 1;
+    return 0;
+
+  ERROR:
+    closedir(dp);
+    free(files);
+    free(names);
+    return -1;
+}
+
+
+/*
+ *  is_current = siteDircacheIsCurrent(dir);
+ *
+ *    Return 1 if the listing of the cached directory 'dir' still
+ *    reflects the directory's contents, or 0 if the directory has
+ *    been created, removed, replaced, or modified since the listing
+ *    was read.
+ */
+static int
+siteDircacheIsCurrent(
+    const site_dircache_dir_t  *dir)
+{
+    struct stat st;
+
+    if (-1 == stat(dir->dirname, &st)) {
+        return (dir->missing && (ENOENT == errno || ENOTDIR == errno));
+    }
+    return (!dir->missing
+            && st.st_mtime == dir->mtime
+            && st.st_ino == dir->ino
+            && st.st_dev == dir->dev
+            && dir->mtime < dir->read_time);
+}
+
+
+/*
+ *    Check for the file 'path' using cached directory listings.  See
+ *    header for details.
+ */
+int
+sksiteRepoFileExists(
+    const char         *path)
+{
+    site_dircache_file_t target;
+    site_dircache_dir_t *dir;
+    const site_dircache_file_t *found;
+    const char *base;
+    const char *env;
+
+    if (1 != site_dircache_enabled) {
+        if (-1 == site_dircache_enabled) {
+            env = getenv(SILK_REPO_DIRCACHE_ENVAR);
+            site_dircache_enabled = !(env && 0 == strcmp(env, "0"));
+        }
+        if (0 == site_dircache_enabled) {
+            return skFileExists(path);
+        }
+    }
+
+    base = strrchr(path, '/');
+    if (NULL == base || base == path) {
+        return skFileExists(path);
+    }
+    dir = siteDircacheGetDir(path, base - path);
+    if (NULL == dir) {
+        return skFileExists(path);
+    }
+    if (dir->listed && dir->checked_pass != site_dircache_pass) {
+        if (siteDircacheIsCurrent(dir)) {
+            dir->checked_pass = site_dircache_pass;
+        } else {
+            siteDircacheDropListing(dir);
+        }
+    }
+    if (!dir->listed) {
+        if (dir->nocache || ++dir->probes <= SITE_DIRCACHE_PROBES) {
+            return skFileExists(path);
+        }
+        if (siteDircacheRead(dir)) {
+            dir->nocache = 1;
+            return skFileExists(path);
+        }
+    }
+
+    target.name = base + 1;
+    found = ((const site_dircache_file_t*)
+             bsearch(&target, dir->files, dir->file_count,
+                     sizeof(site_dircache_file_t), &siteDircacheCompare));
+    if (NULL == found) {
+        return 0;
+    }
+    if (found->verify) {
+        return skFileExists(path);
+    }
+    return 1;
+}
+
+
+void
+sksiteRepoFileCacheRevalidate(
+    void)
+{
+    ++site_dircache_pass;
+}
+
+
+void
+sksiteRepoFileCacheClear(
+    void)
+{
+    size_t i;
+
+    if (site_dircache) {
+        for (i = 0; i < SITE_DIRCACHE_MAX_DIRS; ++i) {
+            siteDircacheFreeDir(&site_dircache[i]);
+        }
+        free(site_dircache);
+        site_dircache = NULL;
+    }
+}
+
+
 /*
  *  more_files = siteRepoIterIncrement(iter, &attr);
  *
@@ -4179,14 +4608,14 @@ siteRepoIterNext(
 
         cp = &name[strlen(name) + 1 - sizeof(suffix)];
         *cp = '\0';
-        if (skFileExists(name)) {
+        if (sksiteRepoFileExists(name)) {
             if (is_missing) {
                 *is_missing = 0;
             }
             return SK_ITERATOR_OK;
         }
         *cp = '.';
-        if (skFileExists(name)) {
+        if (sksiteRepoFileExists(name)) {
             if (is_missing) {
                 *is_missing = 0;
             }
@@ -4426,6 +4855,10 @@ sksiteRepoIteratorReset(
     iter->time_idx = iter->time_start;
     iter->sensor_idx = 0;
     iter->first_call = 1;
+
+    /* check the cached listings against the repository once during
+     * this pass */
+    sksiteRepoFileCacheRevalidate();
 }
 
 
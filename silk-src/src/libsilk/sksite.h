@@ -46,6 +46,12 @@ RCSIDENTVAR(rcsID_SKSITE_H, "$SiLK: sksite.h 87921afb7143 2017-02-14 14:50:58Z m
  */
 #define SILK_CONFIG_FILE_ENVAR "SILK_CONFIG_FILE"
 
+/**
+ *    Name of environment variable that, when set to 0, disables the
+ *    cache of directory listings used by sksiteRepoFileExists().
+ */
+#define SILK_REPO_DIRCACHE_ENVAR "SILK_REPO_DIRCACHE"
+
 
 /* Add an option for processing the silk.conf configuration file */
 #define SK_SITE_FLAG_CONFIG_FILE  0x01
@@ -1984,6 +1990,62 @@ void
 sksiteRepoIteratorReset(
     sksite_repo_iter_t *iter);
 
+/**
+ *    Return 1 if 'path' exists and is either a regular file or a
+ *    FIFO; return 0 otherwise.  This is similar to skFileExists(),
+ *    but it is intended for the files in the data repository, which
+ *    are probed in large numbers.  The repository iterator and
+ *    rwfilter's file selection use this function.
+ *
+ *    The first few times a directory is probed, this function calls
+ *    stat().  Once a directory has been probed more often, its
+ *    contents are read with readdir() and later probes in that
+ *    directory are answered from memory, so selecting files costs
+ *    one directory listing per directory rather than one or two
+ *    stat() calls per possible file.  A directory that does not exist
+ *    is remembered as empty.  A limited number of recently used
+ *    listings are kept.
+ *
+ *    The first time a cached listing is used after a call to
+ *    sksiteRepoFileCacheRevalidate(), the directory is checked with
+ *    stat(), and the listing is discarded when the directory's
+ *    modification time, device, or inode differs from when it was
+ *    read, so files created or removed after the listing are seen.
+ *    Setting the SILK_REPO_DIRCACHE environment variable to 0
+ *    disables the cache.
+ *
+ *    This function is not thread safe.
+ *
+ *    Since SiLK 3.16.0.
+ */
+int
+sksiteRepoFileExists(
+    const char         *path);
+
+/**
+ *    Begin a new pass over the repository.  Each directory listing
+ *    cached by sksiteRepoFileExists() is checked against its
+ *    directory the next time it is used, so that files created or
+ *    removed since the previous pass are seen.  Within a pass, each
+ *    listing is checked at most once.  sksiteRepoIteratorCreate(),
+ *    sksiteRepoIteratorReset(), and fglob call this function.
+ *
+ *    Since SiLK 3.16.0.
+ */
+void
+sksiteRepoFileCacheRevalidate(
+    void);
+
+/**
+ *    Free the directory listings cached by sksiteRepoFileExists().
+ *    sksiteTeardown() calls this function.
+ *
+ *    Since SiLK 3.16.0.
+ */
+void
+sksiteRepoFileCacheClear(
+    void);
+
 
 /*
  *    The following have been renamed and moved to silk_files.h.
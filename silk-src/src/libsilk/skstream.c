@@ -46,6 +46,48 @@ RCSIDENT("$SiLK: skstream.c 275df62a2e41 2017-01-05 17:30:40Z mthomas $");
 #define SILK_ICMP_SPORT_HANDLER_ENVAR "SILK_ICMP_SPORT_HANDLER"
 
 
+/*
+ *    Name of environment variable that sets the number of blocks a
+ *    separate thread reads and decompresses ahead of the reader of a
+ *    stream.  This variable determines the setting of the
+ *    'silk_iobuf_readahead' global.
+ */
+#define SILK_IOBUF_READAHEAD_ENVAR "SILK_IOBUF_READAHEAD"
+
+
+/*
+ *    Name of environment variable that, when set to a non-zero value,
+ *    causes streams that write compressed SiLK Flow files to add a
+ *    block index to the files.  This variable determines the setting
+ *    of the 'silk_block_index' global.
+ */
+#define SILK_BLOCK_INDEX_ENVAR "SILK_BLOCK_INDEX"
+
+/*
+ *    Name of environment variable that, when set to a non-empty
+ *    value, causes a stream that read a SiLK Flow file through a
+ *    block filter to report the number of blocks it skipped when the
+ *    stream is closed.  This variable determines the setting of the
+ *    'silk_block_index_debug' global.
+ */
+#define SILK_BLOCK_INDEX_DEBUG_ENVAR "SILK_BLOCK_INDEX_DEBUG"
+
+
+/*
+ *    The block index of a SiLK Flow file whose header contains the
+ *    SK_HENTRY_BLOCKINDEX_ID entry follows the final compressed
+ *    block.  It begins with a 4-byte block size of 0, which readers
+ *    treat as the end of the data, followed by a packed
+ *    sk_block_zone_t for each block, followed by a footer containing
+ *    the magic number, the size of a packed zone, the number of
+ *    zones, and the file offset of the end of the data.  All values
+ *    are in network byte order.
+ */
+#define STREAM_BLKIDX_MAGIC         0x534b4249
+#define STREAM_BLKIDX_ZONE_SIZE     76
+#define STREAM_BLKIDX_FOOTER_SIZE   24
+
+
 /*
  *    Return SKSTREAM_ERR_NULL_ARGUMENT when 'srin_stream' is NULL.
  */
@@ -89,6 +131,25 @@ RCSIDENT("$SiLK: skstream.c 275df62a2e41 2017-01-05 17:30:40Z mthomas $");
  */
 static int silk_icmp_nochange = 0;
 
+/*
+ *    The number of blocks to read ahead on streams that are read
+ *    through an IOBuf.  This is 0 (no read-ahead) unless the
+ *    SILK_IOBUF_READAHEAD envar is set.
+ */
+static uint32_t silk_iobuf_readahead = 0;
+
+/*
+ *    If nonzero, add a block index to compressed SiLK Flow files.
+ *    This is 0 unless the SILK_BLOCK_INDEX envar is set.
+ */
+static int silk_block_index = 0;
+
+/*
+ *    If nonzero, report the blocks skipped by a block filter.  This
+ *    is 0 unless the SILK_BLOCK_INDEX_DEBUG envar is set.
+ */
+static int silk_block_index_debug = 0;
+
 #ifdef SILK_CLOBBER_ENVAR
 /*
  *    If nonzero, enable clobbering (overwriting) of existing files
@@ -229,7 +290,7 @@ streamCheckOpen(
     assert(stream);
     if (stream->is_closed) {
         return SKSTREAM_ERR_CLOSED;
-    } else if (stream->fd == -1) {
+    } else if (stream->fd == -1 && !stream->is_block_writer) {
         return SKSTREAM_ERR_NOT_OPEN;
     } else {
         return SKSTREAM_OK;
@@ -355,6 +416,447 @@ streamGZWrite(
 #endif  /* SK_ENABLE_ZLIB */
 
 
+/*
+ *  status = streamBlockCallbackWrite(stream, buf, count);
+ *
+ *    Append the 'count' bytes of compressed blocks in 'buf' to the
+ *    block buffer of the block writer 'stream', growing the buffer as
+ *    needed.  Every record written to 'stream' is now in a complete
+ *    block.
+ *
+ *    This function is a callback invoked by skIOBufWrite() and
+ *    skIOBufFlush().
+ */
+static ssize_t
+streamBlockCallbackWrite(
+    skstream_t         *stream,
+    const void         *buf,
+    size_t              count)
+{
+    uint8_t *new_buf;
+    size_t new_size;
+
+    assert(stream->is_block_writer);
+
+    if (stream->block_buf_len + count > stream->block_buf_size) {
+        new_size = (stream->block_buf_size ? stream->block_buf_size : count);
+        while (new_size < stream->block_buf_len + count) {
+            new_size *= 2;
+        }
+        new_buf = (uint8_t*)realloc(stream->block_buf, new_size);
+        if (NULL == new_buf) {
+            stream->is_iobuf_error = 1;
+            stream->err_info = SKSTREAM_ERR_ALLOC;
+            return -1;
+        }
+        stream->block_buf = new_buf;
+        stream->block_buf_size = new_size;
+    }
+
+    memcpy(stream->block_buf + stream->block_buf_len, buf, count);
+    stream->block_buf_len += count;
+    stream->block_rec_count = stream->rec_count;
+
+    return (ssize_t)count;
+}
+
+
+/*
+ *  streamBlockZoneReset(zone);
+ *
+ *    Set 'zone' to summarize no records.
+ */
+static void
+streamBlockZoneReset(
+    sk_block_zone_t    *zone)
+{
+    memset(zone, 0, sizeof(sk_block_zone_t));
+    zone->stime_min = INT64_MAX;
+    zone->stime_max = INT64_MIN;
+    zone->etime_min = INT64_MAX;
+    zone->etime_max = INT64_MIN;
+    zone->sport_min = UINT16_MAX;
+    zone->dport_min = UINT16_MAX;
+}
+
+
+/*
+ *  streamBlockZoneAdd(zone, rwrec);
+ *
+ *    Add the record 'rwrec' to the summary in 'zone'.
+ */
+static void
+streamBlockZoneAdd(
+    sk_block_zone_t    *zone,
+    const rwRec        *rwrec)
+{
+    sktime_t t;
+    uint16_t sport = rwRecGetSPort(rwrec);
+    uint16_t dport = rwRecGetDPort(rwrec);
+    uint8_t proto = rwRecGetProto(rwrec);
+
+    ++zone->rec_count;
+
+    t = rwRecGetStartTime(rwrec);
+    if (t < zone->stime_min) {
+        zone->stime_min = t;
+    }
+    if (t > zone->stime_max) {
+        zone->stime_max = t;
+    }
+    t = rwRecGetEndTime(rwrec);
+    if (t < zone->etime_min) {
+        zone->etime_min = t;
+    }
+    if (t > zone->etime_max) {
+        zone->etime_max = t;
+    }
+
+    if (rwRecIsICMP(rwrec) && sport != 0 && dport == 0) {
+        /* unless SILK_ICMP_SPORT_HANDLER is "none", a reader moves
+         * the type and code to the dPort; allow for either */
+        zone->sport_min = 0;
+        if (sport > zone->dport_max) {
+            zone->dport_max = sport;
+        }
+    }
+    if (sport < zone->sport_min) {
+        zone->sport_min = sport;
+    }
+    if (sport > zone->sport_max) {
+        zone->sport_max = sport;
+    }
+    if (dport < zone->dport_min) {
+        zone->dport_min = dport;
+    }
+    if (dport > zone->dport_max) {
+        zone->dport_max = dport;
+    }
+
+    zone->protocols[proto >> 5] |= (1u << (proto & 0x1F));
+}
+
+
+/*
+ *  streamBlockZonePack(ar, zone);
+ *
+ *    Write 'zone' into the STREAM_BLKIDX_ZONE_SIZE bytes at 'ar'.
+ */
+static void
+streamBlockZonePack(
+    uint8_t                *ar,
+    const sk_block_zone_t  *zone)
+{
+    uint64_t u64;
+    uint32_t u32;
+    uint16_t u16;
+    int i;
+
+    u64 = hton64((uint64_t)zone->stime_min);
+    memcpy(ar, &u64, sizeof(u64));
+    u64 = hton64((uint64_t)zone->stime_max);
+    memcpy(ar + 8, &u64, sizeof(u64));
+    u64 = hton64((uint64_t)zone->etime_min);
+    memcpy(ar + 16, &u64, sizeof(u64));
+    u64 = hton64((uint64_t)zone->etime_max);
+    memcpy(ar + 24, &u64, sizeof(u64));
+    u32 = htonl(zone->rec_count);
+    memcpy(ar + 32, &u32, sizeof(u32));
+    u16 = htons(zone->sport_min);
+    memcpy(ar + 36, &u16, sizeof(u16));
+    u16 = htons(zone->sport_max);
+    memcpy(ar + 38, &u16, sizeof(u16));
+    u16 = htons(zone->dport_min);
+    memcpy(ar + 40, &u16, sizeof(u16));
+    u16 = htons(zone->dport_max);
+    memcpy(ar + 42, &u16, sizeof(u16));
+    for (i = 0; i < 8; ++i) {
+        u32 = htonl(zone->protocols[i]);
+        memcpy(ar + 44 + 4 * i, &u32, sizeof(u32));
+    }
+}
+
+
+/*
+ *  streamBlockZoneUnpack(zone, ar);
+ *
+ *    Fill 'zone' from the STREAM_BLKIDX_ZONE_SIZE bytes at 'ar'.
+ */
+static void
+streamBlockZoneUnpack(
+    sk_block_zone_t    *zone,
+    const uint8_t      *ar)
+{
+    uint64_t u64;
+    uint32_t u32;
+    uint16_t u16;
+    int i;
+
+    memcpy(&u64, ar, sizeof(u64));
+    zone->stime_min = (sktime_t)ntoh64(u64);
+    memcpy(&u64, ar + 8, sizeof(u64));
+    zone->stime_max = (sktime_t)ntoh64(u64);
+    memcpy(&u64, ar + 16, sizeof(u64));
+    zone->etime_min = (sktime_t)ntoh64(u64);
+    memcpy(&u64, ar + 24, sizeof(u64));
+    zone->etime_max = (sktime_t)ntoh64(u64);
+    memcpy(&u32, ar + 32, sizeof(u32));
+    zone->rec_count = ntohl(u32);
+    memcpy(&u16, ar + 36, sizeof(u16));
+    zone->sport_min = ntohs(u16);
+    memcpy(&u16, ar + 38, sizeof(u16));
+    zone->sport_max = ntohs(u16);
+    memcpy(&u16, ar + 40, sizeof(u16));
+    zone->dport_min = ntohs(u16);
+    memcpy(&u16, ar + 42, sizeof(u16));
+    zone->dport_max = ntohs(u16);
+    for (i = 0; i < 8; ++i) {
+        memcpy(&u32, ar + 44 + 4 * i, sizeof(u32));
+        zone->protocols[i] = ntohl(u32);
+    }
+}
+
+
+/*
+ *  streamBlockIndexDiscard(stream);
+ *
+ *    Free the block index on 'stream' and stop writing one.
+ */
+static void
+streamBlockIndexDiscard(
+    skstream_t         *stream)
+{
+    free(stream->blk_zones);
+    stream->blk_zones = NULL;
+    stream->blk_count = 0;
+    stream->blk_capacity = 0;
+    stream->is_blk_indexed = 0;
+}
+
+
+/*
+ *  ignored = streamBlockIndexCallbackWrite(stream, block_number);
+ *
+ *    Append the summary of the records written since the previous
+ *    block to the block index of 'stream'.  If memory cannot be
+ *    allocated, the file is written without an index.
+ *
+ *    This function is a callback invoked by skIOBufWrite() and
+ *    skIOBufFlush() after they write a block.
+ */
+static int
+streamBlockIndexCallbackWrite(
+    void               *v_stream,
+    uint64_t    UNUSED(block_number))
+{
+    skstream_t *stream = (skstream_t*)v_stream;
+    sk_block_zone_t *zones;
+    size_t capacity;
+
+    if (!stream->is_blk_indexed) {
+        return 0;
+    }
+    if (stream->blk_count == stream->blk_capacity) {
+        capacity = (stream->blk_capacity ? 2 * stream->blk_capacity : 64);
+        zones = ((sk_block_zone_t*)
+                 realloc(stream->blk_zones,
+                         capacity * sizeof(sk_block_zone_t)));
+        if (NULL == zones) {
+            streamBlockIndexDiscard(stream);
+            return 0;
+        }
+        stream->blk_zones = zones;
+        stream->blk_capacity = capacity;
+    }
+    stream->blk_zones[stream->blk_count++] = stream->blk_pending;
+    streamBlockZoneReset(&stream->blk_pending);
+
+    return 0;
+}
+
+
+/*
+ *  skip = streamBlockIndexCallbackRead(stream, block_number);
+ *
+ *    Return the result of passing the summary of the block at
+ *    'block_number' to the block filter of 'stream', or 0 when the
+ *    block must be read.
+ *
+ *    This function is a callback invoked by the IOBuf before it reads
+ *    each block.
+ */
+static int
+streamBlockIndexCallbackRead(
+    void               *v_stream,
+    uint64_t            block_number)
+{
+    skstream_t *stream = (skstream_t*)v_stream;
+
+    if (block_number >= stream->blk_count || stream->copyInputFD) {
+        return 0;
+    }
+    if (stream->blk_filter_fn(&stream->blk_zones[block_number],
+                              stream->blk_filter_data))
+    {
+        ++stream->blk_skipped;
+        return 1;
+    }
+    return 0;
+}
+
+
+/*
+ *  status = streamBlockIndexLoad(stream, &data_end);
+ *
+ *    Read the block index that follows the records of 'stream' into
+ *    the 'blk_zones' member of 'stream' without changing the file
+ *    position, and set 'data_end' to the offset where the records
+ *    end.  Return 1 when the index is read, 0 when the file does not
+ *    end with a valid index, or -1 when the file ends with an index
+ *    that cannot be read; 'data_end' is set in the first and last
+ *    cases.
+ */
+static int
+streamBlockIndexLoad(
+    skstream_t         *stream,
+    off_t              *data_end)
+{
+    uint8_t footer[STREAM_BLKIDX_FOOTER_SIZE];
+    sk_block_zone_t *zones;
+    uint8_t *packed;
+    struct stat st;
+    uint64_t count;
+    uint64_t end;
+    uint32_t u32;
+    size_t len;
+    size_t i;
+
+    if (-1 == fstat(stream->fd, &st)
+        || st.st_size < (off_t)(skHeaderGetLength(stream->silk_hdr)
+                                + sizeof(u32) + sizeof(footer))
+        || (pread(stream->fd, footer, sizeof(footer),
+                  st.st_size - sizeof(footer))
+            != (ssize_t)sizeof(footer)))
+    {
+        return 0;
+    }
+
+    /* verify the footer */
+    memcpy(&u32, footer, sizeof(u32));
+    if (ntohl(u32) != STREAM_BLKIDX_MAGIC) {
+        return 0;
+    }
+    memcpy(&u32, footer + 4, sizeof(u32));
+    if (ntohl(u32) != STREAM_BLKIDX_ZONE_SIZE) {
+        return 0;
+    }
+    memcpy(&count, footer + 8, sizeof(count));
+    count = ntoh64(count);
+    memcpy(&end, footer + 16, sizeof(end));
+    end = ntoh64(end);
+    if (end < skHeaderGetLength(stream->silk_hdr)
+        || end > (uint64_t)st.st_size
+        || count > ((uint64_t)st.st_size - end) / STREAM_BLKIDX_ZONE_SIZE
+        || (end + sizeof(u32) + count * STREAM_BLKIDX_ZONE_SIZE
+            + sizeof(footer)) != (uint64_t)st.st_size)
+    {
+        return 0;
+    }
+
+    /* the index follows the marker for the end of the data */
+    if (pread(stream->fd, &u32, sizeof(u32), end) != (ssize_t)sizeof(u32)
+        || u32 != 0)
+    {
+        return 0;
+    }
+    *data_end = (off_t)end;
+
+    len = count * STREAM_BLKIDX_ZONE_SIZE;
+    packed = (uint8_t*)malloc(len ? len : 1);
+    zones = (sk_block_zone_t*)malloc((count ? count : 1)
+                                     * sizeof(sk_block_zone_t));
+    if (NULL == packed || NULL == zones
+        || (pread(stream->fd, packed, len, end + sizeof(u32))
+            != (ssize_t)len))
+    {
+        free(packed);
+        free(zones);
+        return -1;
+    }
+    for (i = 0; i < count; ++i) {
+        streamBlockZoneUnpack(&zones[i], packed + i * STREAM_BLKIDX_ZONE_SIZE);
+    }
+    free(packed);
+
+    free(stream->blk_zones);
+    stream->blk_zones = zones;
+    stream->blk_count = count;
+    stream->blk_capacity = (count ? count : 1);
+
+    return 1;
+}
+
+
+/*
+ *  status = streamBlockIndexWrite(stream);
+ *
+ *    Write the marker for the end of the data, the block index, and
+ *    the index's footer to 'stream', whose final block has been
+ *    written.  Return SKSTREAM_OK on success, or an error code on
+ *    failure.
+ */
+static int
+streamBlockIndexWrite(
+    skstream_t         *stream)
+{
+    uint8_t *buf;
+    uint8_t *bp;
+    uint64_t u64;
+    uint32_t u32;
+    off_t end;
+    size_t len;
+    size_t i;
+    int rv = SKSTREAM_OK;
+
+    end = lseek(stream->fd, 0, SEEK_CUR);
+    if (end == (off_t)(-1)) {
+        stream->errnum = errno;
+        return SKSTREAM_ERR_SYS_LSEEK;
+    }
+
+    len = (sizeof(u32) + stream->blk_count * STREAM_BLKIDX_ZONE_SIZE
+           + STREAM_BLKIDX_FOOTER_SIZE);
+    buf = (uint8_t*)calloc(1, len);
+    if (NULL == buf) {
+        return SKSTREAM_ERR_ALLOC;
+    }
+
+    /* the first 4 bytes remain 0 */
+    bp = buf + sizeof(u32);
+    for (i = 0; i < stream->blk_count; ++i) {
+        streamBlockZonePack(bp, &stream->blk_zones[i]);
+        bp += STREAM_BLKIDX_ZONE_SIZE;
+    }
+
+    u32 = htonl(STREAM_BLKIDX_MAGIC);
+    memcpy(bp, &u32, sizeof(u32));
+    u32 = htonl(STREAM_BLKIDX_ZONE_SIZE);
+    memcpy(bp + 4, &u32, sizeof(u32));
+    u64 = hton64((uint64_t)stream->blk_count);
+    memcpy(bp + 8, &u64, sizeof(u64));
+    u64 = hton64((uint64_t)end);
+    memcpy(bp + 16, &u64, sizeof(u64));
+
+    if (skwriten(stream->fd, buf, len) != (ssize_t)len) {
+        stream->errnum = errno;
+        rv = SKSTREAM_ERR_WRITE;
+    }
+    free(buf);
+
+    return rv;
+}
+
+
 /*
  *  status = streamIOBufCreate(stream);
  *
@@ -466,6 +968,20 @@ streamIOBufCreate(
         }
     }
 
+    /* summarize each block when writing a block index */
+    if (stream->is_blk_indexed) {
+        skIOBufSetBlockCallback(stream->iobuf, &streamBlockIndexCallbackWrite,
+                                stream);
+    }
+
+    /* decompress in a separate thread when requested */
+    if (silk_iobuf_readahead && SK_IO_READ == stream->io_mode) {
+        if (-1 == skIOBufSetReadAhead(stream->iobuf, silk_iobuf_readahead)) {
+            rv = SKSTREAM_ERR_IOBUF;
+            goto END;
+        }
+    }
+
   END:
     return rv;
 }
@@ -1272,6 +1788,131 @@ streamSkipRecordsNonIOBuf(
 }
 
 
+/*
+ *  ignore = streamUnpackRecord(stream, rwrec, ar);
+ *
+ *    Convert the packed record in 'ar' that was read from 'stream'
+ *    into 'rwrec', fix the ICMP type and code when needed, write the
+ *    record to the copy-input stream, and apply the IPv6 policy.
+ *
+ *    Return 0 when the caller should use the record, or 1 when the
+ *    IPv6 policy says to ignore it.  'ar' may be modified.
+ */
+static int
+streamUnpackRecord(
+    skstream_t         *stream,
+    rwRec              *rwrec,
+    uint8_t            *ar)
+{
+    /* clear the caller's record */
+    RWREC_CLEAR(rwrec);
+
+    /* convert the byte array to an rwRec in native byte order */
+#if SK_ENABLE_IPV6
+    stream->rwUnpackFn(stream, rwrec, ar);
+#else
+    if (stream->rwUnpackFn(stream, rwrec, ar) == SKSTREAM_ERR_UNSUPPORT_IPV6) {
+        return 1;
+    }
+#endif
+
+    /* Handle incorrectly encoded ICMP Type/Code unless the
+     * SILK_ICMP_SPORT_HANDLER environment variable is set to none. */
+    if (rwRecIsICMP(rwrec)
+        && rwRecGetSPort(rwrec) != 0
+        && rwRecGetDPort(rwrec) == 0
+        && !silk_icmp_nochange)
+    {
+        /*
+         *  There are two ways for the ICMP Type/Code to appear in
+         *  "sPort" instead of in "dPort".
+         *
+         *  (1) The flow was an IPFIX bi-flow record read prior to
+         *  SiLK-3.4.0 where the sPort and dPort of the second record
+         *  were reversed when they should not have been.  Here, the
+         *  sPort contains ((type<<8)|code).
+         *
+         *  (2) The flow was a NetFlowV5 record read from a buggy
+         *  Cisco router and read prior to SiLK-0.8.0.  Here, the
+         *  sPort contains ((code<<8)|type).
+         *
+         *  The following assumes buggy ICMP flow records were created
+         *  from IPFIX sources unless they were created prior to SiLK
+         *  1.0 and appear in certain file formats more closely
+         *  associated with NetFlowV5.
+         *
+         *  Prior to SiLK-3.4.0, the buggy ICMP record would propagate
+         *  through the tool suite and be written to binary output
+         *  files.  As of 3.4.0, we modify the record on read.
+         */
+        if (skHeaderGetFileVersion(stream->silk_hdr) >= 16) {
+            /* File created by SiLK 1.0 or later; most likely the
+             * buggy value originated from an IPFIX source. */
+            rwRecSetDPort(rwrec, rwRecGetSPort(rwrec));
+        } else {
+            switch(skHeaderGetFileFormat(stream->silk_hdr)) {
+              case FT_RWFILTER:
+              case FT_RWNOTROUTED:
+              case FT_RWROUTED:
+              case FT_RWSPLIT:
+              case FT_RWWWW:
+                /* Most likely from a PDU source */
+                rwRecSetDPort(rwrec, BSWAP16(rwRecGetSPort(rwrec)));
+                break;
+              default:
+                /* Assume it is from an IPFIX source */
+                rwRecSetDPort(rwrec, rwRecGetSPort(rwrec));
+                break;
+            }
+        }
+        rwRecSetSPort(rwrec, 0);
+    }
+
+    /* Write to the copy-input stream */
+    if (stream->copyInputFD) {
+        skStreamWriteRecord(stream->copyInputFD, rwrec);
+    }
+
+    /* got a record */
+    ++stream->rec_count;
+
+#if SK_ENABLE_IPV6
+    switch (stream->v6policy) {
+      case SK_IPV6POLICY_MIX:
+        break;
+
+      case SK_IPV6POLICY_IGNORE:
+        if (rwRecIsIPv6(rwrec)) {
+            return 1;
+        }
+        break;
+
+      case SK_IPV6POLICY_ASV4:
+        if (rwRecIsIPv6(rwrec)) {
+            if (rwRecConvertToIPv4(rwrec)) {
+                return 1;
+            }
+        }
+        break;
+
+      case SK_IPV6POLICY_FORCE:
+        if (!rwRecIsIPv6(rwrec)) {
+            rwRecConvertToIPv6(rwrec);
+        }
+        break;
+
+      case SK_IPV6POLICY_ONLY:
+        if (!rwRecIsIPv6(rwrec)) {
+            return 1;
+        }
+        break;
+    }
+#endif /* SK_ENABLE_IPV6 */
+
+    return 0;
+}
+
+
 /*
  * *********************************
  * PUBLIC / EXPORTED FUNCTIONS
@@ -1476,7 +2117,9 @@ skStreamClose(
     rv = streamCheckOpen(stream);
     if (rv) { goto END; }
 
-    if (stream->fp) {
+    if (stream->is_block_writer) {
+        /* there is no file descriptor; any unmoved blocks are lost */
+    } else if (stream->fp) {
         if (stream->is_pager_active) {
             if (pclose(stream->fp) == -1) {
                 stream->errnum = errno;
@@ -1493,6 +2136,18 @@ skStreamClose(
             }
         }
     } else if (stream->fd != -1) {
+        if (stream->iobuf && stream->io_mode == SK_IO_READ) {
+            /* stop any thread that is reading ahead */
+            skIOBufSetReadAhead(stream->iobuf, 0);
+            if (silk_block_index_debug && stream->blk_filter_fn
+                && stream->blk_count)
+            {
+                skAppPrintErr(("SILK_BLOCK_INDEX_DEBUG: %s: Skipped %"
+                               PRIu64 " of %" SK_PRIuZ " blocks"),
+                              stream->pathname, stream->blk_skipped,
+                              stream->blk_count);
+            }
+        }
         if (stream->iobuf && stream->io_mode != SK_IO_READ) {
             if (skIOBufFlush(stream->iobuf) == -1) {
                 if (stream->is_iobuf_error) {
@@ -1501,6 +2156,8 @@ skStreamClose(
                 } else {
                     rv = SKSTREAM_ERR_IOBUF;
                 }
+            } else if (stream->is_blk_indexed) {
+                rv = streamBlockIndexWrite(stream);
             }
         }
 #if SK_ENABLE_ZLIB
@@ -1592,12 +2249,99 @@ skStreamCreate(
         (*new_stream)->is_silk = 1;
         /* FALLTHROUGH */
 
-      case SK_CONTENT_OTHERBINARY:
-        (*new_stream)->is_binary = 1;
-        break;
+      case SK_CONTENT_OTHERBINARY:
+        (*new_stream)->is_binary = 1;
+        break;
+    }
+
+    return ((*new_stream)->last_rv = SKSTREAM_OK);
+}
+
+
+int
+skStreamCreateBlockWriter(
+    skstream_t        **writer,
+    skstream_t         *stream)
+{
+    skio_abstract_t io_func;
+    skstream_t *w;
+    int rv;
+
+    if (writer == NULL) {
+        return SKSTREAM_ERR_NULL_ARGUMENT;
+    }
+    *writer = NULL;
+    STREAM_RETURN_IF_NULL(stream);
+
+    rv = streamCheckOpen(stream);
+    if (rv) { goto END; }
+
+    rv = streamCheckAttributes(stream, (SK_IO_WRITE | SK_IO_APPEND),
+                               SK_CONTENT_SILK_FLOW);
+    if (rv) { goto END; }
+
+    /* the format of the records is not known until the header has
+     * been written */
+    if (!stream->is_dirty) {
+        rv = skStreamWriteSilkHeader(stream);
+        if (rv) { goto END; }
+    }
+
+    /* an unbuffered stream does not write compressed blocks */
+    if (NULL == stream->iobuf) {
+        rv = SKSTREAM_ERR_UNSUPPORT_IOMODE;
+        goto END;
+    }
+
+    rv = skStreamCreate(writer, SK_IO_WRITE, SK_CONTENT_SILK_FLOW);
+    if (rv) { goto END; }
+    w = *writer;
+
+    if (skHeaderCopy(w->silk_hdr, stream->silk_hdr, SKHDR_CP_ALL)) {
+        rv = SKSTREAM_ERR_ALLOC;
+        goto END;
+    }
+
+    /* copy the values that the pack functions use */
+    w->rwPackFn = stream->rwPackFn;
+    w->recLen = stream->recLen;
+    w->hdr_starttime = stream->hdr_starttime;
+    w->hdr_sensor = stream->hdr_sensor;
+    w->hdr_flowtype = stream->hdr_flowtype;
+    w->v6policy = stream->v6policy;
+    w->supports_ipv6 = stream->supports_ipv6;
+    w->swapFlag = stream->swapFlag;
+    w->is_block_writer = 1;
+    w->is_dirty = 1;
+
+    /* create an IOBuf that matches the one on 'stream' and that
+     * writes its compressed blocks into memory */
+    w->iobuf = skIOBufCreate(SK_IO_WRITE);
+    if (NULL == w->iobuf) {
+        rv = SKSTREAM_ERR_ALLOC;
+        goto END;
+    }
+    if (-1 == skIOBufSetRecordSize(w->iobuf, w->recLen)) {
+        rv = SKSTREAM_ERR_IOBUF;
+        goto END;
+    }
+    memset(&io_func, 0, sizeof(skio_abstract_t));
+    io_func.write = (skio_write_fn_t)&streamBlockCallbackWrite;
+    io_func.strerror = (skio_strerror_fn_t)&streamCallbackStrerror;
+    if (skIOBufBindAbstract(w->iobuf, w,
+                            skHeaderGetCompressionMethod(w->silk_hdr),
+                            &io_func)
+        == -1)
+    {
+        rv = SKSTREAM_ERR_IOBUF;
+        goto END;
     }
 
-    return ((*new_stream)->last_rv = SKSTREAM_OK);
+  END:
+    if (rv && *writer) {
+        skStreamDestroy(writer);
+    }
+    return (stream->last_rv = rv);
 }
 
 
@@ -1622,6 +2366,16 @@ skStreamDestroy(
     /* Destroy the header */
     skHeaderDestroy(&((*stream)->silk_hdr));
 
+    /* Free the blocks of a block writer */
+    if ((*stream)->block_buf) {
+        free((*stream)->block_buf);
+        (*stream)->block_buf = NULL;
+    }
+
+    /* Free the block index */
+    free((*stream)->blk_zones);
+    (*stream)->blk_zones = NULL;
+
     /* Free the pathname */
     if ((*stream)->pathname) {
         free((*stream)->pathname);
@@ -2255,6 +3009,25 @@ skStreamInitialize(
         silk_icmp_nochange = 1;
     }
 
+    env = getenv(SILK_BLOCK_INDEX_ENVAR);
+    if (NULL != env && *env && *env != '0') {
+        silk_block_index = 1;
+    }
+
+    env = getenv(SILK_BLOCK_INDEX_DEBUG_ENVAR);
+    if (NULL != env && *env) {
+        silk_block_index_debug = 1;
+    }
+
+    env = getenv(SILK_IOBUF_READAHEAD_ENVAR);
+    if (NULL != env && *env) {
+        if (skStringParseUint32(&silk_iobuf_readahead, env, 0,
+                                SKIOBUF_MAX_READAHEAD))
+        {
+            silk_iobuf_readahead = 0;
+        }
+    }
+
 #ifdef SILK_CLOBBER_ENVAR
     env = getenv(SILK_CLOBBER_ENVAR);
     if (NULL != env && *env && *env != '0') {
@@ -2749,110 +3522,124 @@ skStreamReadRecord(
         goto END;
     }
 
-    /* clear the caller's record */
-    RWREC_CLEAR(rwrec);
-
-    /* convert the byte array to an rwRec in native byte order */
-#if SK_ENABLE_IPV6
-    stream->rwUnpackFn(stream, rwrec, ar);
-#else
-    if (stream->rwUnpackFn(stream, rwrec, ar) == SKSTREAM_ERR_UNSUPPORT_IPV6) {
+    if (streamUnpackRecord(stream, rwrec, ar)) {
         goto NEXT_RECORD;
     }
-#endif
 
-    /* Handle incorrectly encoded ICMP Type/Code unless the
-     * SILK_ICMP_SPORT_HANDLER environment variable is set to none. */
-    if (rwRecIsICMP(rwrec)
-        && rwRecGetSPort(rwrec) != 0
-        && rwRecGetDPort(rwrec) == 0
-        && !silk_icmp_nochange)
-    {
-        /*
-         *  There are two ways for the ICMP Type/Code to appear in
-         *  "sPort" instead of in "dPort".
-         *
-         *  (1) The flow was an IPFIX bi-flow record read prior to
-         *  SiLK-3.4.0 where the sPort and dPort of the second record
-         *  were reversed when they should not have been.  Here, the
-         *  sPort contains ((type<<8)|code).
-         *
-         *  (2) The flow was a NetFlowV5 record read from a buggy
-         *  Cisco router and read prior to SiLK-0.8.0.  Here, the
-         *  sPort contains ((code<<8)|type).
-         *
-         *  The following assumes buggy ICMP flow records were created
-         *  from IPFIX sources unless they were created prior to SiLK
-         *  1.0 and appear in certain file formats more closely
-         *  associated with NetFlowV5.
-         *
-         *  Prior to SiLK-3.4.0, the buggy ICMP record would propagate
-         *  through the tool suite and be written to binary output
-         *  files.  As of 3.4.0, we modify the record on read.
-         */
-        if (skHeaderGetFileVersion(stream->silk_hdr) >= 16) {
-            /* File created by SiLK 1.0 or later; most likely the
-             * buggy value originated from an IPFIX source. */
-            rwRecSetDPort(rwrec, rwRecGetSPort(rwrec));
-        } else {
-            switch(skHeaderGetFileFormat(stream->silk_hdr)) {
-              case FT_RWFILTER:
-              case FT_RWNOTROUTED:
-              case FT_RWROUTED:
-              case FT_RWSPLIT:
-              case FT_RWWWW:
-                /* Most likely from a PDU source */
-                rwRecSetDPort(rwrec, BSWAP16(rwRecGetSPort(rwrec)));
-                break;
-              default:
-                /* Assume it is from an IPFIX source */
-                rwRecSetDPort(rwrec, rwRecGetSPort(rwrec));
-                break;
-            }
-        }
-        rwRecSetSPort(rwrec, 0);
+  END:
+    return (stream->last_rv = rv);
+}
+
+
+int
+skStreamReadRecords(
+    skstream_t         *stream,
+    rwRec              *recs,
+    size_t              num_recs,
+    size_t             *recs_read)
+{
+#ifndef SK_HAVE_ALIGNED_ACCESS_REQUIRED
+    uint8_t ar_buf[SK_MAX_RECORD_SIZE];
+#else
+    /* force 'ar_buf' to be aligned on an 8byte boundary; see
+     * skStreamReadRecord() */
+    union force_align_un {
+        uint8_t  fa_ar[SK_MAX_RECORD_SIZE];
+        uint64_t fa_u64;
+    } force_align;
+    uint8_t *ar_buf = force_align.fa_ar;
+#endif  /* SK_HAVE_ALIGNED_ACCESS_REQUIRED */
+
+    size_t local_recs_read;
+    void *block;
+    uint8_t *bp;
+    size_t have;
+    ssize_t saw;
+    ssize_t tmp;
+    int rv = SKSTREAM_OK;
+
+    if (NULL == recs_read) {
+        recs_read = &local_recs_read;
     }
+    *recs_read = 0;
 
-    /* Write to the copy-input stream */
-    if (stream->copyInputFD) {
-        skStreamWriteRecord(stream->copyInputFD, rwrec);
+    if (stream->is_eof) {
+        rv = SKSTREAM_ERR_EOF;
+        goto END;
     }
 
-    /* got a record */
-    ++stream->rec_count;
+    assert(stream);
+    assert(stream->io_mode == SK_IO_READ || stream->io_mode == SK_IO_APPEND);
+    assert(stream->content_type != SK_CONTENT_TEXT);
+    assert(stream->is_binary);
+    assert(stream->fd != -1);
 
-#if SK_ENABLE_IPV6
-    switch (stream->v6policy) {
-      case SK_IPV6POLICY_MIX:
-        break;
+    if (!stream->iobuf) {
+        /* there is no block to unpack from; read each record */
+        while (*recs_read < num_recs
+               && ((rv = skStreamReadRecord(stream, &recs[*recs_read]))
+                   == SKSTREAM_OK))
+        {
+            ++*recs_read;
+        }
+        goto END;
+    }
 
-      case SK_IPV6POLICY_IGNORE:
-        if (rwRecIsIPv6(rwrec)) {
-            goto NEXT_RECORD;
+    while (*recs_read < num_recs) {
+        if (num_recs - *recs_read > (size_t)SSIZE_MAX / stream->recLen) {
+            tmp = (SSIZE_MAX / stream->recLen) * stream->recLen;
+        } else {
+            tmp = stream->recLen * (num_recs - *recs_read);
         }
-        break;
 
-      case SK_IPV6POLICY_ASV4:
-        if (rwRecIsIPv6(rwrec)) {
-            if (rwRecConvertToIPv4(rwrec)) {
-                goto NEXT_RECORD;
-            }
+        /* get the packed records that remain in the current block
+         * without copying them */
+        saw = skIOBufReadInPlace(stream->iobuf, &block, tmp);
+        if (saw <= 0) {
+            stream->is_eof = 1;
+            rv = ((0 == saw) ? SKSTREAM_ERR_EOF : SKSTREAM_ERR_IOBUF);
+            goto END;
         }
-        break;
 
-      case SK_IPV6POLICY_FORCE:
-        if (!rwRecIsIPv6(rwrec)) {
-            rwRecConvertToIPv6(rwrec);
+        /* unpack each complete record */
+        for (bp = (uint8_t*)block;
+             saw >= (ssize_t)stream->recLen;
+             bp += stream->recLen, saw -= stream->recLen)
+        {
+#ifndef SK_HAVE_ALIGNED_ACCESS_REQUIRED
+            if (0 == streamUnpackRecord(stream, &recs[*recs_read], bp)) {
+                ++*recs_read;
+            }
+#else
+            memcpy(ar_buf, bp, stream->recLen);
+            if (0 == streamUnpackRecord(stream, &recs[*recs_read], ar_buf)) {
+                ++*recs_read;
+            }
+#endif  /* SK_HAVE_ALIGNED_ACCESS_REQUIRED */
         }
-        break;
 
-      case SK_IPV6POLICY_ONLY:
-        if (!rwRecIsIPv6(rwrec)) {
-            goto NEXT_RECORD;
+        if (saw > 0) {
+            /* the block ended with part of a record; get the
+             * remainder of the record from the next block */
+            have = saw;
+            memcpy(ar_buf, bp, have);
+            saw = skIOBufRead(stream->iobuf, ar_buf + have,
+                              stream->recLen - have);
+            if (saw != (ssize_t)(stream->recLen - have)) {
+                stream->is_eof = 1;
+                if (saw == -1) {
+                    rv = SKSTREAM_ERR_IOBUF;
+                } else {
+                    stream->errobj.num = have + saw;
+                    rv = SKSTREAM_ERR_READ_SHORT;
+                }
+                goto END;
+            }
+            if (0 == streamUnpackRecord(stream, &recs[*recs_read], ar_buf)) {
+                ++*recs_read;
+            }
         }
-        break;
     }
-#endif /* SK_ENABLE_IPV6 */
 
   END:
     return (stream->last_rv = rv);
@@ -2908,6 +3695,32 @@ skStreamReadSilkHeader(
 
     /* Move to end of file is stream was open for append */
     if (stream->io_mode == SK_IO_APPEND) {
+        /* remove the block index from the end of the file; the index
+         * is rewritten to include the new records when the stream is
+         * closed */
+        if (stream->is_silk_flow
+            && skHeaderGetFirstMatch(stream->silk_hdr,
+                                     SK_HENTRY_BLOCKINDEX_ID))
+        {
+            off_t data_end;
+
+            switch (streamBlockIndexLoad(stream, &data_end)) {
+              case 0:
+                /* the file does not end with an index */
+                break;
+              case 1:
+                stream->is_blk_indexed = 1;
+                streamBlockZoneReset(&stream->blk_pending);
+                /* FALLTHROUGH */
+              default:
+                if (-1 == ftruncate(stream->fd, data_end)) {
+                    stream->errnum = errno;
+                    rv = SKSTREAM_ERR_SYS_FTRUNCATE;
+                    goto END;
+                }
+                break;
+            }
+        }
         if (-1 == lseek(stream->fd, 0, SEEK_END)) {
             stream->errnum = errno;
             rv = SKSTREAM_ERR_SYS_LSEEK;
@@ -2967,6 +3780,64 @@ skStreamReadSilkHeaderStart(
 }
 
 
+int
+skStreamSetBlockFilter(
+    skstream_t                     *stream,
+    sk_stream_block_filter_fn_t     filter_fn,
+    void                           *cb_data)
+{
+    off_t data_end;
+    int rv;
+
+    STREAM_RETURN_IF_NULL(stream);
+    STREAM_RETURN_IF_NULL(filter_fn);
+
+    rv = streamCheckOpen(stream);
+    if (rv) { goto END; }
+
+    rv = streamCheckAttributes(stream, SK_IO_READ, SK_CONTENT_SILK_FLOW);
+    if (rv) { goto END; }
+
+    if (!stream->is_dirty) {
+        rv = skStreamReadSilkHeader(stream, NULL);
+        if (rv) { goto END; }
+    }
+    if (stream->rec_count) {
+        rv = SKSTREAM_ERR_PREV_DATA;
+        goto END;
+    }
+
+    /* the index must exist and be readable, and the blocks must be
+     * visible to the IOBuf */
+    if (NULL == stream->iobuf
+        || !stream->is_seekable
+#if SK_ENABLE_ZLIB
+        || NULL != stream->gz
+#endif
+        || (SK_COMPMETHOD_NONE
+            == skHeaderGetCompressionMethod(stream->silk_hdr))
+        || (NULL == skHeaderGetFirstMatch(stream->silk_hdr,
+                                          SK_HENTRY_BLOCKINDEX_ID))
+        || (NULL == stream->blk_zones
+            && 1 != streamBlockIndexLoad(stream, &data_end)))
+    {
+        goto END;
+    }
+
+    stream->blk_filter_fn = filter_fn;
+    stream->blk_filter_data = cb_data;
+    if (skIOBufSetBlockCallback(stream->iobuf, &streamBlockIndexCallbackRead,
+                                stream))
+    {
+        rv = SKSTREAM_ERR_IOBUF;
+        goto END;
+    }
+
+  END:
+    return (stream->last_rv = rv);
+}
+
+
 int
 skStreamSetCommentStart(
     skstream_t         *stream,
@@ -3294,6 +4165,55 @@ skStreamWrite(
 }
 
 
+int
+skStreamWriteBlocks(
+    skstream_t         *stream,
+    skstream_t         *writer)
+{
+    ssize_t written;
+    int rv;
+
+    STREAM_RETURN_IF_NULL(stream);
+    STREAM_RETURN_IF_NULL(writer);
+
+    rv = streamCheckOpen(stream);
+    if (rv) { goto END; }
+
+    if (!writer->is_block_writer || NULL == stream->iobuf) {
+        rv = SKSTREAM_ERR_UNSUPPORT_IOMODE;
+        goto END;
+    }
+
+    if (0 == writer->block_buf_len) {
+        goto END;
+    }
+
+    /* the records in the blocks cannot be summarized */
+    if (stream->is_blk_indexed) {
+        streamBlockIndexDiscard(stream);
+    }
+
+    written = skIOBufWriteBlocks(stream->iobuf, writer->block_buf,
+                                 writer->block_buf_len);
+    if (written != (ssize_t)writer->block_buf_len) {
+        if (stream->is_iobuf_error) {
+            stream->is_iobuf_error = 0;
+            rv = stream->err_info;
+        } else {
+            rv = SKSTREAM_ERR_IOBUF;
+        }
+        goto END;
+    }
+
+    stream->rec_count += writer->block_rec_count - writer->moved_rec_count;
+    writer->moved_rec_count = writer->block_rec_count;
+    writer->block_buf_len = 0;
+
+  END:
+    return (stream->last_rv = rv);
+}
+
+
 int
 skStreamWriteRecord(
     skstream_t             *stream,
@@ -3321,7 +4241,7 @@ skStreamWriteRecord(
     assert(stream);
     assert(stream->io_mode == SK_IO_WRITE || stream->io_mode == SK_IO_APPEND);
     assert(stream->is_silk_flow);
-    assert(stream->fd != -1);
+    assert(stream->fd != -1 || stream->is_block_writer);
 
     if (!stream->is_dirty) {
         rv = skStreamWriteSilkHeader(stream);
@@ -3396,6 +4316,20 @@ skStreamWriteRecord(
             == (ssize_t)stream->recLen)
         {
             ++stream->rec_count;
+            if (stream->is_blk_indexed) {
+                /* summarize the record as a reader will see it; the
+                 * IOBuf invokes the block callback before copying the
+                 * record, so the record belongs to the pending block */
+#if SK_ENABLE_IPV6
+                rwRec *rec_read = &rec_copy;
+#else
+                rwRec rec_read_buf;
+                rwRec *rec_read = &rec_read_buf;
+#endif
+                RWREC_CLEAR(rec_read);
+                stream->rwUnpackFn(stream, rec_read, ar);
+                streamBlockZoneAdd(&stream->blk_pending, rec_read);
+            }
             return (stream->last_rv = SKSTREAM_OK);
         } else if (stream->is_iobuf_error) {
             stream->is_iobuf_error = 0;
@@ -3499,6 +4433,27 @@ skStreamWriteSilkHeader(
         streamCacheHeader(stream);
     }
 
+    /* note in the header that a block index follows the records.
+     * The index is only written to a seekable file where the records
+     * are compressed in blocks */
+    if (silk_block_index && stream->is_silk_flow && stream->is_seekable
+        && !stream->is_mpi && !stream->is_unbuffered
+#if SK_ENABLE_ZLIB
+        && NULL == stream->gz
+#endif
+        && (SK_COMPMETHOD_NONE
+            != skHeaderGetCompressionMethod(stream->silk_hdr)))
+    {
+        if (NULL == skHeaderGetFirstMatch(stream->silk_hdr,
+                                          SK_HENTRY_BLOCKINDEX_ID))
+        {
+            rv = skHeaderAddBlockindex(stream->silk_hdr);
+            if (rv) { goto END; }
+        }
+        stream->is_blk_indexed = 1;
+        streamBlockZoneReset(&stream->blk_pending);
+    }
+
     stream->is_dirty = 1;
     skHeaderSetLock(stream->silk_hdr, SKHDR_LOCK_FIXED);
 
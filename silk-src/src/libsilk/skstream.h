@@ -283,6 +283,52 @@ typedef enum {
 #define SKSTREAM_ERROR_IS_FATAL(err) ((err) != SKSTREAM_OK && (err) < 64)
 
 
+/**
+ *    A summary of the records in one block of a SiLK Flow file that
+ *    contains a block index.  When the SILK_BLOCK_INDEX environment
+ *    variable is set, a stream that writes compressed SiLK Flow
+ *    records adds a header entry (SK_HENTRY_BLOCKINDEX_ID) to the
+ *    file and writes an index containing one of these summaries for
+ *    each compressed block after the final block.  See
+ *    skStreamSetBlockFilter().
+ *
+ *    The time and port values are those the records have when they
+ *    are read.  The ICMP type and code of an ICMP record that holds
+ *    them in the source port are included in the range of both ports.
+ */
+typedef struct sk_block_zone_st {
+    /** Earliest and latest start times of the records */
+    sktime_t    stime_min;
+    sktime_t    stime_max;
+    /** Earliest and latest end times of the records */
+    sktime_t    etime_min;
+    sktime_t    etime_max;
+    /** Number of records in the block */
+    uint32_t    rec_count;
+    /** Smallest and largest source ports of the records */
+    uint16_t    sport_min;
+    uint16_t    sport_max;
+    /** Smallest and largest destination ports of the records */
+    uint16_t    dport_min;
+    uint16_t    dport_max;
+    /** Bitmap of the protocols of the records; the bit for protocol
+     * 'p' is (protocols[p >> 5] & (1u << (p & 0x1F))) */
+    uint32_t    protocols[8];
+} sk_block_zone_t;
+
+
+/**
+ *    Signature of the function that skStreamSetBlockFilter() invokes
+ *    for each block of a stream.  'zone' summarizes the records in
+ *    the block.  The function returns non-zero to have the stream
+ *    skip the block, or 0 to have the stream read the block.
+ */
+typedef int
+(*sk_stream_block_filter_fn_t)(
+    const sk_block_zone_t  *zone,
+    void                   *cb_data);
+
+
 /**
  *    Set 'stream' to operate on the file specified in 'pathname';
  *    'pathname' may also be one of "stdin", "stdout", or "stderr".
@@ -378,6 +424,40 @@ skStreamCreate(
     skcontent_t         content_type);
 
 
+/**
+ *    Create a block writer at the location pointed to by 'writer' for
+ *    the open SiLK Flow output stream 'stream'.  A block writer packs
+ *    and compresses the records written to it with
+ *    skStreamWriteRecord() exactly as 'stream' would, but it holds
+ *    the compressed blocks in memory until skStreamWriteBlocks()
+ *    appends them to 'stream'.  Call skStreamFlush() on 'writer' to
+ *    complete its current block.  Each thread may have its own block
+ *    writer, allowing the records to be packed and compressed in
+ *    parallel.  If the header of 'stream' has not been written, it is
+ *    written.  Destroy 'writer' with skStreamDestroy().
+ *
+ *    A block writer cannot be created for a stream that is
+ *    unbuffered; the function returns SKSTREAM_ERR_UNSUPPORT_IOMODE
+ *    and the caller should write the records to 'stream' directly.
+ *
+ *    Return SKSTREAM_OK on success, or one of these error codes:
+ *
+ *    SKSTREAM_ERR_NULL_ARGUMENT
+ *    SKSTREAM_ERR_CLOSED
+ *    SKSTREAM_ERR_NOT_OPEN
+ *    SKSTREAM_ERR_UNSUPPORT_IOMODE
+ *    SKSTREAM_ERR_UNSUPPORT_CONTENT
+ *    SKSTREAM_ERR_ALLOC
+ *    SKSTREAM_ERR_IOBUF
+ *
+ *    or any error code from skStreamWriteSilkHeader().
+ */
+int
+skStreamCreateBlockWriter(
+    skstream_t        **writer,
+    skstream_t         *stream);
+
+
 /**
  *    Closes the stream at '*stream', if open, destroys the stream
  *    pointed at by 'stream' and sets '*stream' to NULL.  If 'stream'
@@ -875,6 +955,25 @@ skStreamReadRecord(
     rwRec              *rec);
 
 
+/**
+ *    Read up to 'num_recs' SiLK Flow records from 'stream' into the
+ *    array 'recs'.  If 'recs_read' is not NULL, the number of records
+ *    read is stored in that location.  The records are identical to
+ *    those that repeated calls to skStreamReadRecord() would return,
+ *    but they are unpacked directly from the stream's buffer.
+ *
+ *    Return SKSTREAM_OK when 'num_recs' records were read.  Otherwise
+ *    return SKSTREAM_ERR_EOF or the error that stopped the read; the
+ *    records read before that condition are valid.
+ */
+int
+skStreamReadRecords(
+    skstream_t         *stream,
+    rwRec              *recs,
+    size_t              num_recs,
+    size_t             *recs_read);
+
+
 /**
  *    Attempt to read the SiLK file header from 'stream', putting the
  *    data into 'hdr'.  This function requires that 'stream' contain
@@ -963,6 +1062,28 @@ skStreamSetCommentStart(
                                   (comp_method)))
 
 
+/**
+ *    Tell 'stream', a stream that reads SiLK Flow records, to pass
+ *    the summary of each block to 'filter_fn' along with 'cb_data'
+ *    before reading the block, and to skip the records in each block
+ *    where 'filter_fn' returns non-zero.  The records in a skipped
+ *    block are not decompressed and are not included in the stream's
+ *    record count.  This function must be called after the stream's
+ *    header has been read and before any records are read.
+ *
+ *    The summaries come from the block index at the end of the file.
+ *    When the file has no block index, or when the stream cannot use
+ *    the index (for example, when the file is read from a pipe or
+ *    when skStreamSetCopyInput() has been called), this function
+ *    returns SKSTREAM_OK and 'filter_fn' is never invoked.
+ */
+int
+skStreamSetBlockFilter(
+    skstream_t                     *stream,
+    sk_stream_block_filter_fn_t     filter_fn,
+    void                           *cb_data);
+
+
 /**
  *    Inform 'read_stream' that all records it reads must be written
  *    to 'write_stream'.  'read_stream' and 'write_stream' must both
@@ -1095,6 +1216,24 @@ skStreamWrite(
     size_t              count);
 
 
+/**
+ *    Append to 'stream' the complete compressed blocks held by the
+ *    block writer 'writer', which must have been created from
+ *    'stream' by skStreamCreateBlockWriter(), and add the number of
+ *    records in those blocks to the record count of 'stream'.  The
+ *    records in the incomplete block of 'writer' are not moved.
+ *
+ *    The caller must ensure that only one thread at a time calls this
+ *    function or writes to 'stream'.
+ *
+ *    Return SKSTREAM_OK on success, or an error code on failure.
+ */
+int
+skStreamWriteBlocks(
+    skstream_t         *stream,
+    skstream_t         *writer);
+
+
 /**
  *    Write the SiLK Flow record 'rec' to 'stream'.
  */
@@ -247,6 +247,36 @@ struct skstream_st {
      * and --copy-input switches */
     skstream_t             *copyInputFD;
 
+    /* For a block writer, the compressed blocks waiting to be moved
+     * to the stream the writer was created from, the number of bytes
+     * in 'block_buf', and the size of 'block_buf' */
+    uint8_t                *block_buf;
+    size_t                  block_buf_len;
+    size_t                  block_buf_size;
+
+    /* For a block writer, the number of records that are in complete
+     * blocks and the number of those records that have been moved */
+    uint64_t                block_rec_count;
+    uint64_t                moved_rec_count;
+
+    /* For a SiLK Flow file that has a block index, the summary of
+     * each compressed block, the number of summaries in 'blk_zones',
+     * and the capacity of 'blk_zones' */
+    sk_block_zone_t        *blk_zones;
+    size_t                  blk_count;
+    size_t                  blk_capacity;
+
+    /* When writing a block index, the summary of the records written
+     * since the most recent block was written */
+    sk_block_zone_t         blk_pending;
+
+    /* When reading, the function that decides whether to skip a
+     * block, and its data; see skStreamSetBlockFilter() */
+    sk_stream_block_filter_fn_t blk_filter_fn;
+    void                   *blk_filter_data;
+    /* The number of blocks the block filter skipped */
+    uint64_t                blk_skipped;
+
     /* An object to hold the parameter that caused the last error */
     union {
         uint32_t        num;
@@ -346,6 +376,14 @@ struct skstream_st {
 
     /* Set to 1 if the data in the stream is in non-native byte order */
     unsigned                swapFlag        :1;
+
+    /* Set to 1 if the stream is a block writer that holds its
+     * compressed blocks in memory; see skStreamCreateBlockWriter() */
+    unsigned                is_block_writer :1;
+
+    /* Set to 1 if the stream writes a block index after its records
+     * when it is closed */
+    unsigned                is_blk_indexed  :1;
 };
 /* skstream_t */
 
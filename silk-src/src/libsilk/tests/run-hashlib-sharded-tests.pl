@@ -0,0 +1,11 @@
+#! /usr/bin/perl -w
+# STATUS: OK
+# TEST: ./hashlib_sharded_tests 2>&1
+
+use strict;
+use SiLKTests;
+
+my $hashlib_sharded_tests = check_silk_app('hashlib_sharded_tests');
+my $cmd = "$hashlib_sharded_tests 2>&1";
+
+exit (check_exit_status($cmd) ? 0 : 1);
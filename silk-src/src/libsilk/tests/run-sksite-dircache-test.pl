@@ -0,0 +1,12 @@
+#! /usr/bin/perl -w
+# STATUS: OK
+# TEST: ./sksite-dircache-test $tmpdir 2>&1
+
+use strict;
+use SiLKTests;
+
+my $sksite_dircache_test = check_silk_app('sksite-dircache-test');
+my $tmpdir = make_tempdir();
+my $cmd = "$sksite_dircache_test $tmpdir 2>&1";
+
+exit (check_exit_status($cmd) ? 0 : 1);
@@ -382,6 +382,18 @@ skBitmapGetBitF(
 #  define skBitmapGetBit(bitmap, pos) skBitmapGetBitFast(bitmap, pos)
 #endif
 
+/**
+ *    Return 1 if the bit at position 'pos' in 'bitmap' is ON; return
+ *    0 if it is OFF.  Unlike skBitmapGetBit(), 'pos' is not checked
+ *    against the size of the bitmap, and the caller must ensure it is
+ *    less than the number of bits in the bitmap.  Since the macro has
+ *    no branches, it may be used in loops the compiler vectorizes.
+ *
+ *    Since SiLK 3.16.0.
+ */
+#define skBitmapGetBitUnchecked(bitmap, pos)                    \
+    (((bitmap)->map[_BMAP_INDEX(pos)] >> ((pos) & 0x1F)) & 1)
+
 
 /**
  *    Turn ON the bit at position 'pos' in 'bitmap'.  Adjust the
@@ -1738,6 +1750,24 @@ skQSort_r(
     int               (*cmp)(const void *a, const void *b, void *thunk),
     void               *thunk);
 
+/**
+ *    Perform a radix sort on the elements in 'buffer', where each
+ *    element is 'element_size' octets and 'buffer' contains
+ *    'number_elements' such elements.
+ *
+ *    The elements are sorted in ascending order of their first
+ *    'key_length' octets, compared as by memcmp(); the remaining
+ *    octets of each element are carried along but do not affect the
+ *    order.  The order of elements whose keys are identical is not
+ *    specified.  'key_length' must not be larger than 'element_size'.
+ */
+void
+skRadixSort(
+    void               *buffer,
+    size_t              number_elements,
+    size_t              element_size,
+    size_t              key_length);
+
 
 /*
 **
@@ -7734,6 +7734,12 @@ silk_get_compression_methods(
 #endif
 #if SK_ENABLE_SNAPPY
         "SNAPPY",
+#endif
+#if SK_ENABLE_ZSTD
+        "ZSTD",
+#endif
+#if SK_ENABLE_LZ4
+        "LZ4",
 #endif
         NULL
     };
@@ -8245,6 +8251,8 @@ init_silkfile_module(
     PyModule_AddIntConstant(mod, "ZLIB", SK_COMPMETHOD_ZLIB);
     PyModule_AddIntConstant(mod, "LZO1X", SK_COMPMETHOD_LZO1X);
     PyModule_AddIntConstant(mod, "SNAPPY", SK_COMPMETHOD_SNAPPY);
+    PyModule_AddIntConstant(mod, "ZSTD", SK_COMPMETHOD_ZSTD);
+    PyModule_AddIntConstant(mod, "LZ4", SK_COMPMETHOD_LZ4);
 
     PyModule_AddObject(mod, "BAG_COUNTER_MAX",
                        PyLong_FromUnsignedLongLong(SKBAG_COUNTER_MAX));
@@ -23,19 +23,26 @@
  * 12/2 notes.  Often, the best is the enemy of the good, I am implementing
  * a simple version of this application for now with the long-term plan being
  * that I am going to write a better, faster, set-friendly version later.
+ *
+ * The counts are kept in a HashShardedTable keyed by the IP address
+ * (an IPv6 address when SiLK supports IPv6; IPv4 addresses are mapped
+ * into ::ffff:0:0/96).  The table starts small and grows as IPs are
+ * added.  When --threads is greater than 1, each thread reads entire
+ * input files and updates the shared table.
  */
 
 #include <silk/silk.h>
 
 RCSIDENT("$SiLK: rwaddrcount.c 6ed7bbd25102 2017-03-21 20:57:52Z mthomas $");
 
-#include <silk/iptree.h>
+#include <silk/hashlib_sharded.h>
 #include <silk/rwrec.h>
 #include <silk/skipaddr.h>
+#include <silk/skipset.h>
 #include <silk/sksite.h>
 #include <silk/skstream.h>
 #include <silk/skstringmap.h>
-#include <silk/skvector.h>
+#include <silk/skthread.h>
 #include <silk/utils.h>
 
 
@@ -44,37 +51,48 @@ RCSIDENT("$SiLK: rwaddrcount.c 6ed7bbd25102 2017-03-21 20:57:52Z mthomas $");
 /* where to write output from --help */
 #define USAGE_FH stdout
 
-/* number of buckets in hash table */
-#define RWAC_ARRAYSIZE   50865917
+/* number of IPs the hash table is initially sized to hold; the table
+ * grows as needed */
+#define RWAC_INITIAL_ENTRIES  4096
 
-/* number of countRecord_t to allocate at one time */
-#define RWAC_BLOCK_SIZE      4096
+/* number of records to read from a stream at one time */
+#define RWAC_READ_RECS         256
 
-/*
- * Get the IP address from the record 'r' to use as the key.  Uses the
- * global variable 'use_dest'
- */
-#define GETIP(r)                                                \
-    ((use_dest) ? rwRecGetDIPv4(r) : rwRecGetSIPv4(r))
+/* environment variable that sets the default number of threads */
+#define RWAC_THREADS_ENVAR    "SILK_RWADDRCOUNT_THREADS"
 
-/*
- * One of the problems I've had recently is a tendency to focus on
- * doing the perfect hash.  The perfect hash is nice, but what we need
- * RIGHT HERE RIGHT NOW is a tool that'll actually do the job.  Enough
- * mathematical wanking.
- *
- * So, this is a hash whose collision compensation algorithm is linear
- * chaining.  I'm not happy about it, but it'll do for now.
- */
-#define HASHFUNC(value)                                         \
-    ((value ^ (value >> 7) ^ (value << 23)) % RWAC_ARRAYSIZE)
+/* maximum number of threads */
+#define RWAC_THREADS_MAX        64
+
+/* number of shards in the hash table for each thread */
+#define RWAC_SHARDS_PER_THREAD   8
 
 /*
- * CMPFNC: return TRUE if IP on the rwRec 'r' matches the IP stored in
- * the countRecord_t 'b'.
+ * RWAC_KEY_WIDTH is the number of octets in a key.  GETKEY(r, key)
+ * fills the uint8_t array 'key' with the IP address from the record
+ * 'r' in network byte order, so that comparing keys with memcmp()
+ * sorts them by IP.  Uses the global variable 'use_dest'.
  */
-#define CMPFNC(r, cr)                           \
-    ((cr)->cr_key == GETIP(r))
+#if SK_ENABLE_IPV6
+#define RWAC_KEY_WIDTH  16
+#define GETKEY(r, key)                          \
+    do {                                        \
+        if (use_dest) {                         \
+            rwRecMemGetDIPv6((r), (key));       \
+        } else {                                \
+            rwRecMemGetSIPv6((r), (key));       \
+        }                                       \
+    } while (0)
+#else
+#define RWAC_KEY_WIDTH   4
+#define GETKEY(r, key)                                                  \
+    do {                                                                \
+        uint32_t getkey_ip;                                             \
+        getkey_ip = ((use_dest) ? rwRecGetDIPv4(r) : rwRecGetSIPv4(r)); \
+        getkey_ip = htonl(getkey_ip);                                   \
+        memcpy((key), &getkey_ip, sizeof(getkey_ip));                   \
+    } while (0)
+#endif  /* #else of #if SK_ENABLE_IPV6 */
 
 /*
  * when generating output, this macro will evaluate to TRUE if the
@@ -99,18 +117,22 @@ RCSIDENT("$SiLK: rwaddrcount.c 6ed7bbd25102 2017-03-21 20:57:52Z mthomas $");
 
 /* formats for printing statistics */
 #define FMT_STAT_VALUE                                                  \
-    "%*s%c%*" PRIu32 "%c%*" PRIu64 "%c%*" PRIu64 "%c%*" PRIu64 "%s\n"
+    "%*s%c%*" PRIu64 "%c%*" PRIu64 "%c%*" PRIu64 "%c%*" PRIu64 "%s\n"
 #define FMT_STAT_TITLE "%*s%c%*s%c%*s%c%*s%c%*s%s\n"
 #define FMT_STAT_WIDTH {10, 10, 20, 15, 15}
 
+/* width of the IP column when IPv6 addresses are present */
+#define FMT_IPV6_WIDTH  39
+
+/*
+ *    The value stored in the hash table for each IP address.  Since
+ *    the value follows the key in the table and may not be aligned,
+ *    it is copied into a countRecord_t before it is used.
+ */
 typedef struct countRecord_st countRecord_t;
 struct countRecord_st {
     /* total number of bytes */
     uint64_t        cr_bytes;
-    /* Pointer to the next record for collision */
-    countRecord_t  *cr_next;
-    /* IP address, or whatever we don't consider source or dest here*/
-    uint32_t        cr_key;
     /* total number of packets */
     uint32_t        cr_packets;
     /* total number of records */
@@ -121,6 +143,25 @@ struct countRecord_st {
     uint32_t        cr_end;
 };
 
+/*
+ *    A reference to an entry in the hash table, used when sorting the
+ *    entries by IP address.
+ */
+typedef struct countEntry_st {
+    const uint8_t  *ce_key;
+    const uint8_t  *ce_value;
+} countEntry_t;
+
+/*
+ *    The state of one of the threads that read the input.
+ */
+typedef struct countThread_st {
+    pthread_t       ct_thread;
+    /* whether the thread added an IPv6 address not in ::ffff:0:0/96 */
+    unsigned        ct_ipv6_keys :1;
+    unsigned        ct_started   :1;
+} countThread_t;
+
 typedef enum {
     RWAC_PMODE_NONE=0,
     RWAC_PMODE_IPS,
@@ -148,19 +189,32 @@ static uint32_t max_packets = UINT32_MAX;
 static uint32_t min_records = 0;
 static uint32_t max_records = UINT32_MAX;
 
-/* the hash table */
-static countRecord_t *hash_bins[RWAC_ARRAYSIZE];
+/* the hash table mapping each IP to its countRecord_t */
+static HashShardedTable *count_table = NULL;
+
+/* whether the table contains an IPv6 address that is not in
+ * ::ffff:0:0/96; when true, all IPs are printed as IPv6 */
+static int ipv6_keys = 0;
 
 /* IPset file for output when --set-file is specified */
 static const char *ipset_file = NULL;
 
-/* entries are allocated in blocks; the blocks are stored in a
- * vector */
-static sk_vector_t *mem_vector = NULL;
-
 /* whether to use the source(==0) or destination(==1) IPs */
 static uint8_t use_dest = 0;
 
+/* how to handle IPv6 flows */
+static sk_ipv6policy_t ipv6_policy = SK_IPV6POLICY_MIX;
+
+/* number of threads to use when reading the input */
+static uint32_t thread_count = 1;
+
+/* protects the options context and 'read_error' while threads are
+ * reading the input */
+static pthread_mutex_t read_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+/* set when any thread encounters an error reading the input */
+static int read_error = 0;
+
 /* output mode for IPs */
 static uint32_t ip_format = SKIPADDR_CANONICAL;
 static uint8_t sort_ips_flag = 0;
@@ -220,7 +274,8 @@ typedef enum {
     OPT_NO_FINAL_DELIMITER,
     OPT_DELIMITED,
     OPT_OUTPUT_PATH,
-    OPT_PAGER
+    OPT_PAGER,
+    OPT_THREADS
 } appOptionsEnum;
 
 static struct option appOptions[] = {
@@ -243,6 +298,7 @@ static struct option appOptions[] = {
     {"delimited",           OPTIONAL_ARG, 0, OPT_DELIMITED},
     {"output-path",         REQUIRED_ARG, 0, OPT_OUTPUT_PATH},
     {"pager",               REQUIRED_ARG, 0, OPT_PAGER},
+    {"threads",             REQUIRED_ARG, 0, OPT_THREADS},
     {0,0,0,0}               /* sentinel entry */
 };
 
@@ -272,6 +328,8 @@ static const char *appHelp[] = {
     "Shortcut for --no-columns --no-final-del --column-sep=CHAR",
     "Write the output to this stream or file. Def. stdout",
     "Invoke this program to page output. Def. $SILK_PAGER or $PAGER",
+    ("Read the input using this number of threads.\n"
+     "\tDef. $" RWAC_THREADS_ENVAR " or 1"),
     (char *)NULL
 };
 
@@ -338,6 +396,7 @@ appUsageLong(
         }
     }
     skOptionsCtxOptionsUsage(optctx, fh);
+    skIPv6PolicyUsage(fh);
     sksiteOptionsUsage(fh);
 
     fprintf(fh, "\nDEPRECATED SWITCHES:\n");
@@ -361,15 +420,7 @@ static void
 appTeardown(
     void)
 {
-/* #define RWAC_MAX_CHAIN  64 */
-
     static int teardownFlag = 0;
-    countRecord_t *bin;
-    uint32_t i;
-#ifdef RWAC_MAX_CHAIN
-    uint32_t chained[RWAC_MAX_CHAIN];
-    uint32_t chain_len;
-#endif
 
     if (teardownFlag) {
         return;
@@ -384,45 +435,8 @@ appTeardown(
     /* close the copy-stream */
     skOptionsCtxCopyStreamClose(optctx, &skAppPrintErr);
 
-#ifdef RWAC_MAX_CHAIN
-    /* print chain length of each bucket */
-    memset(chained, 0, sizeof(chained));
-    chain_len = 0;
-
-    for (i = 0; i < RWAC_ARRAYSIZE; ++i) {
-        if (NULL != hash_bins[i]) {
-            bin = hash_bins[i];
-            chain_len = 0;
-            do {
-                ++chain_len;
-                bin = bin->cr_next;
-            } while (bin != hash_bins[i]);
-            if (chain_len < RWAC_MAX_CHAIN) {
-                ++chained[chain_len];
-            } else {
-                ++chained[RWAC_MAX_CHAIN-1];
-            }
-        }
-    }
-
-    if (chain_len) {
-        fprintf(stderr, "Hash Chaining Information\n%10s|%10s|\n",
-                "Length", "Count");
-    }
-    for (i = 0; i < RWAC_MAX_CHAIN; ++i) {
-        if (chained[i]) {
-            fprintf(stderr, ("%10" PRIu32 "|%10" PRIu32 "|\n"),
-                    i, chained[i]);
-        }
-    }
-#endif  /* RWAC_MAX_CHAIN */
-
-    if (mem_vector) {
-        for (i = 0; 0 == skVectorGetValue(&bin, mem_vector, i); ++i) {
-            free(bin);
-        }
-        skVectorDestroy(mem_vector);
-    }
+    hashlib_sharded_free_table(count_table);
+    count_table = NULL;
 
     skOptionsCtxDestroy(&optctx);
     skAppUnregister();
@@ -460,6 +474,7 @@ appSetup(
 
     /* initialize globals */
     use_dest = 0;
+    ipv6_policy = SK_IPV6POLICY_MIX;
     memset(&output, 0, sizeof(output));
     output.of_fp = stdout;
 
@@ -474,6 +489,7 @@ appSetup(
         || skOptionsRegister(legacyOptions, &appOptionsHandler, NULL)
         || skOptionsTimestampFormatRegister(&time_flags, time_register_flags)
         || skOptionsIPFormatRegister(&ip_format, ip_format_register_flags)
+        || skIPv6PolicyOptionsRegister(&ipv6_policy)
         || sksiteOptionsRegister(SK_SITE_FLAG_CONFIG_FILE))
     {
         skAppPrintErr("Unable to register options");
@@ -487,6 +503,19 @@ appSetup(
         exit(EXIT_FAILURE);
     }
 
+    /* check the thread count envar */
+    {
+        char *env;
+        uint32_t tc;
+
+        env = getenv(RWAC_THREADS_ENVAR);
+        if (env && env[0]) {
+            if (skStringParseUint32(&tc, env, 1, 0) == 0) {
+                thread_count = tc;
+            }
+        }
+    }
+
     /* parse options */
     rv = skOptionsCtxOptionsParse(optctx, argc, argv);
     if (rv < 0) {
@@ -563,10 +592,27 @@ appSetup(
         }
     }
 
-    /* create vector */
-    mem_vector = skVectorNew(sizeof(countRecord_t*));
-    if (NULL == mem_vector) {
-        skAppPrintErr("Cannot create vector");
+    /* the threads would share the --copy-input stream; do not use
+     * threads when it is given */
+    if (thread_count > 1 && skOptionsCtxCopyStreamIsActive(optctx)) {
+        thread_count = 1;
+    }
+    if (thread_count > RWAC_THREADS_MAX) {
+        thread_count = RWAC_THREADS_MAX;
+    }
+
+    /* create the hash table; use a single shard when there is only
+     * one thread */
+    count_table = hashlib_sharded_create_table(
+        RWAC_KEY_WIDTH, sizeof(countRecord_t), NULL, RWAC_INITIAL_ENTRIES,
+        DEFAULT_LOAD_FACTOR,
+        ((1 == thread_count)
+         ? 1
+         : ((thread_count * RWAC_SHARDS_PER_THREAD > HASHLIB_MAX_SHARDS)
+            ? HASHLIB_MAX_SHARDS
+            : thread_count * RWAC_SHARDS_PER_THREAD)));
+    if (NULL == count_table) {
+        skAppPrintErr("Cannot create hash table");
         exit(EXIT_FAILURE);
     }
 
@@ -717,6 +763,13 @@ appOptionsHandler(
       case OPT_PAGER:
         pager = opt_arg;
         break;
+
+      case OPT_THREADS:
+        rv = skStringParseUint32(&thread_count, opt_arg, 1, 0);
+        if (rv) {
+            goto PARSE_ERROR;
+        }
+        break;
     }
 
     return 0;                     /* OK */
@@ -730,71 +783,198 @@ appOptionsHandler(
 
 
 /*
- * void addToBin(countRecord_t *bin, rwRec *rwrec)
+ *  addToBin(value_ptr, status, rwrec);
  *
- * Adds the contents of a record to the values stored in a bin.
+ *    Callback for hashlib_sharded_update().  Initializes the
+ *    countRecord_t at 'value_ptr' from the record 'rwrec' when the
+ *    entry is new ('status' is OK); otherwise adds the contents of
+ *    the record to the values stored in the entry.
  */
 static void
 addToBin(
-    countRecord_t      *bin,
-    const rwRec        *rwrec)
+    uint8_t            *value_ptr,
+    int                 status,
+    void               *v_rwrec)
 {
-    assert(bin->cr_key == GETIP(rwrec));
-    bin->cr_bytes += rwRecGetBytes(rwrec);
-    bin->cr_packets += rwRecGetPkts(rwrec);
-    ++bin->cr_records;
-    if (rwRecGetStartSeconds(rwrec) < bin->cr_start) {
-        bin->cr_start = rwRecGetStartSeconds(rwrec);
+    const rwRec *rwrec = (const rwRec*)v_rwrec;
+    countRecord_t bin;
+
+    if (OK == status) {
+        bin.cr_bytes = rwRecGetBytes(rwrec);
+        bin.cr_packets = rwRecGetPkts(rwrec);
+        bin.cr_records = 1;
+        bin.cr_start = rwRecGetStartSeconds(rwrec);
+        bin.cr_end = rwRecGetEndSeconds(rwrec);
+    } else {
+        memcpy(&bin, value_ptr, sizeof(bin));
+        bin.cr_bytes += rwRecGetBytes(rwrec);
+        bin.cr_packets += rwRecGetPkts(rwrec);
+        ++bin.cr_records;
+        if (rwRecGetStartSeconds(rwrec) < bin.cr_start) {
+            bin.cr_start = rwRecGetStartSeconds(rwrec);
+        }
+        if (bin.cr_end < rwRecGetEndSeconds(rwrec)) {
+            bin.cr_end = rwRecGetEndSeconds(rwrec);
+        }
     }
-    if (bin->cr_end < rwRecGetEndSeconds(rwrec)) {
-        bin->cr_end = rwRecGetEndSeconds(rwrec);
+    memcpy(value_ptr, &bin, sizeof(bin));
+}
+
+
+/*
+ *  status = countFile(stream, count_thread);
+ *
+ *    Read the flow records from stream and add them to the hash
+ *    table.  A read error is reported and ends the stream.  Return 0
+ *    on success, or -1 if memory cannot be allocated.
+ */
+static int
+countFile(
+    skstream_t         *stream,
+    countThread_t      *count_thread)
+{
+    uint8_t key[RWAC_KEY_WIDTH];
+    rwRec recs[RWAC_READ_RECS];
+    size_t count;
+    size_t i;
+    int rv;
+
+    do {
+        rv = skStreamReadRecords(stream, recs, RWAC_READ_RECS, &count);
+        for (i = 0; i < count; ++i) {
+            GETKEY(&recs[i], key);
+            switch (hashlib_sharded_update(count_table, key, &addToBin,
+                                           &recs[i]))
+            {
+              case OK:
+#if SK_ENABLE_IPV6
+                if (!SK_IPV6_IS_V4INV6(key)) {
+                    count_thread->ct_ipv6_keys = 1;
+                }
+#endif
+                break;
+              case OK_DUPLICATE:
+                break;
+              default:
+                skAppPrintErr("Error allocating memory for bin");
+                return -1;
+            }
+        }
+    } while (SKSTREAM_OK == rv);
+    if (rv != SKSTREAM_ERR_EOF) {
+        skStreamPrintLastErr(stream, rv, &skAppPrintErr);
     }
+    return 0;
 }
 
 
 /*
- * int newBin(rwRec *rwrec)
+ *  countReadInputs(count_thread);
  *
- * Creates a new countRecord and initializes it with the values from
- * the record.
+ *    Get input streams from the options context and add the records
+ *    in each to the hash table until there are no more streams or
+ *    until an error occurs in any thread.
  */
-static countRecord_t *
-newBin(
-    const rwRec        *rwrec)
+static void
+countReadInputs(
+    countThread_t      *count_thread)
 {
-    static countRecord_t *current_block = NULL;
-    static uint32_t available = 0;
-    countRecord_t *bin;
-
-    if (available) {
-        --available;
-        bin = current_block;
-        ++current_block;
-    } else {
-        current_block
-            = (countRecord_t*)malloc(RWAC_BLOCK_SIZE * sizeof(countRecord_t));
-        if (NULL == current_block) {
-            skAppPrintErr("Error allocating memory for bin");
-            exit(EXIT_FAILURE);
+    skstream_t *stream;
+    int rv;
+
+    for (;;) {
+        pthread_mutex_lock(&read_mutex);
+        if (read_error) {
+            rv = 1;
+        } else {
+            rv = skOptionsCtxNextSilkFile(optctx, &stream, &skAppPrintErr);
+            if (0 == rv) {
+                skStreamSetIPv6Policy(stream, ipv6_policy);
+            } else if (rv < 0) {
+                read_error = 1;
+            }
         }
-        if (skVectorAppendValue(mem_vector, &current_block)) {
-            skAppPrintErr("Error allocating memory for bin");
-            exit(EXIT_FAILURE);
+        pthread_mutex_unlock(&read_mutex);
+        if (rv) {
+            return;
+        }
+
+        rv = countFile(stream, count_thread);
+        skStreamDestroy(&stream);
+        if (rv) {
+            pthread_mutex_lock(&read_mutex);
+            read_error = 1;
+            pthread_mutex_unlock(&read_mutex);
+            return;
         }
-        bin = current_block;
-        ++current_block;
-        available = RWAC_BLOCK_SIZE - 1;
     }
+}
 
-    bin->cr_bytes = rwRecGetBytes(rwrec);
-    bin->cr_packets = rwRecGetPkts(rwrec);
-    bin->cr_records = 1;
-    bin->cr_key = GETIP(rwrec);
-    bin->cr_start = rwRecGetStartSeconds(rwrec);
-    bin->cr_end = rwRecGetEndSeconds(rwrec);
-    bin->cr_next = NULL;
 
-    return bin;
+/*
+ *  countReaderThread(&count_thread);
+ *
+ *    THREAD ENTRY POINT.
+ *
+ *    Read records for countInputs().
+ */
+static void *
+countReaderThread(
+    void               *v_count_thread)
+{
+    skthread_ignore_signals();
+
+    countReadInputs((countThread_t*)v_count_thread);
+    return NULL;
+}
+
+
+/*
+ *  status = countInputs();
+ *
+ *    Read the records from all inputs into the hash table using
+ *    'thread_count' threads, one of which is the calling thread.
+ *    Return 0 on success or -1 on error.
+ */
+static int
+countInputs(
+    void)
+{
+    countThread_t *threads;
+    uint32_t i;
+
+    threads = (countThread_t*)calloc(thread_count, sizeof(countThread_t));
+    if (NULL == threads) {
+        skAppPrintOutOfMemory("reader threads");
+        return -1;
+    }
+
+    /* the calling thread uses the final index and any index whose
+     * thread could not be created */
+    for (i = 0; i + 1 < thread_count; ++i) {
+        if (0 == pthread_create(&threads[i].ct_thread, NULL,
+                                &countReaderThread, &threads[i]))
+        {
+            threads[i].ct_started = 1;
+        }
+    }
+    for (i = thread_count; i > 0; ) {
+        --i;
+        if (!threads[i].ct_started) {
+            countReadInputs(&threads[i]);
+        }
+    }
+    for (i = 0; i < thread_count; ++i) {
+        if (threads[i].ct_started) {
+            pthread_join(threads[i].ct_thread, NULL);
+        }
+        if (threads[i].ct_ipv6_keys) {
+            ipv6_keys = 1;
+        }
+    }
+
+    free(threads);
+    return ((read_error) ? -1 : 0);
 }
 
 
@@ -806,56 +986,144 @@ newBin(
 
 
 /*
- *  hashToIPTree(&iptree);
+ *  keyToAddr(&ipaddr, key);
  *
- *    Fills in the 'iptree' with all the IPs in global hash_bins array.
+ *    Fill 'ipaddr' with the IP address in the hash table key 'key'.
+ *    When the table holds no IPv6 addresses outside of ::ffff:0:0/96,
+ *    the address is converted to IPv4.
  */
 static void
-hashToIPTree(
-    skIPTree_t        **ip_tree)
+keyToAddr(
+    skipaddr_t         *ipaddr,
+    const uint8_t      *key)
 {
-    countRecord_t *bin;
-    uint32_t i;
+#if SK_ENABLE_IPV6
+    skipaddrSetV6(ipaddr, key);
+    if (!ipv6_keys) {
+        skipaddrV6toV4(ipaddr, ipaddr);
+    }
+#else
+    uint32_t ip;
 
-    skIPTreeCreate(ip_tree);
+    memcpy(&ip, key, sizeof(ip));
+    ip = ntohl(ip);
+    skipaddrSetV4(ipaddr, &ip);
+#endif  /* #else of #if SK_ENABLE_IPV6 */
+}
 
-    for (i = 0; i < RWAC_ARRAYSIZE; i++) {
-        if (NULL != hash_bins[i]) {
-            bin = hash_bins[i];
-            do {
-                if (IS_RECORD_WITHIN_LIMITS(bin)) {
-                    skIPTreeAddAddress((*ip_tree), (bin->cr_key));
-                }
-                bin = bin->cr_next;
-            } while (bin != hash_bins[i]);
+
+/*
+ *  cmp = compareEntries(a, b);
+ *
+ *    Compare the keys of the countEntry_t objects 'a' and 'b'.  Used
+ *    to sort the entries by IP address.
+ */
+static int
+compareEntries(
+    const void         *v_a,
+    const void         *v_b)
+{
+    return memcmp(((const countEntry_t*)v_a)->ce_key,
+                  ((const countEntry_t*)v_b)->ce_key, RWAC_KEY_WIDTH);
+}
+
+
+/*
+ *  entries = sortEntries(&count);
+ *
+ *    Return an array of the entries in the hash table that are
+ *    within the limits, sorted by IP address, and set 'count' to the
+ *    number of entries.  The caller must free() the array.  Return
+ *    NULL if the array cannot be allocated.
+ */
+static countEntry_t *
+sortEntries(
+    size_t             *count)
+{
+    countEntry_t *entries;
+    countRecord_t bin;
+    HASH_ITER iter;
+    uint8_t *key_ptr;
+    uint8_t *val_ptr;
+    size_t i;
+
+    entries = ((countEntry_t*)
+               malloc((1 + hashlib_sharded_count_entries(count_table))
+                      * sizeof(countEntry_t)));
+    if (NULL == entries) {
+        skAppPrintOutOfMemory("sorted IPs");
+        return NULL;
+    }
+
+    i = 0;
+    iter = hashlib_sharded_create_iterator(count_table);
+    while (hashlib_sharded_iterate(count_table, &iter, &key_ptr, &val_ptr)
+           == OK)
+    {
+        memcpy(&bin, val_ptr, sizeof(bin));
+        if (IS_RECORD_WITHIN_LIMITS(&bin)) {
+            entries[i].ce_key = key_ptr;
+            entries[i].ce_value = val_ptr;
+            ++i;
         }
     }
+
+    skQSort(entries, i, sizeof(countEntry_t), &compareEntries);
+    *count = i;
+    return entries;
 }
 
 
 /*
- *  int dumpRecords(outfp)
- *
- *    Dumps the addrcount contents as a record of bytes, packets,
- *    times &c to 'outfp'
- *
- *    This is the typical text output from addrcount.
+ *  printRecord(outfp, w, key, value);
  *
+ *    Print the IP address in 'key' and the countRecord_t in 'value'
+ *    to 'outfp' using the column widths in 'w'.
  */
-static int
-dumpRecords(
-    FILE               *outfp)
+static void
+printRecord(
+    FILE               *outfp,
+    const int           w[],
+    const uint8_t      *key,
+    const uint8_t      *value)
 {
-    int w[] = FMT_REC_WIDTH;
-    uint32_t i;
-    countRecord_t *bin;
+    countRecord_t bin;
     char ip_st[SK_NUM2DOT_STRLEN];
     char start_st[SKTIMESTAMP_STRLEN];
     char end_st[SKTIMESTAMP_STRLEN];
     skipaddr_t ipaddr;
 
+    memcpy(&bin, value, sizeof(bin));
+    keyToAddr(&ipaddr, key);
+    fprintf(outfp, FMT_REC_VALUE,
+            w[0], skipaddrString(ip_st, &ipaddr, ip_format), delimiter,
+            w[1], bin.cr_bytes,   delimiter,
+            w[2], bin.cr_packets, delimiter,
+            w[3], bin.cr_records, delimiter,
+            w[4], sktimestamp_r(start_st, sktimeCreate(bin.cr_start, 0),
+                                time_flags),
+            delimiter,
+            w[5], sktimestamp_r(end_st, sktimeCreate(bin.cr_end, 0),
+                                time_flags),
+            final_delim);
+}
+
+
+/*
+ *  printRecordTitle(outfp, w);
+ *
+ *    Set the column widths in 'w' and print the title for
+ *    printRecord() to 'outfp' unless titles are disabled.
+ */
+static void
+printRecordTitle(
+    FILE               *outfp,
+    int                 w[])
+{
     if (no_columns) {
-        memset(w, 0, sizeof(w));
+        memset(w, 0, 6 * sizeof(int));
+    } else if (ipv6_keys) {
+        w[0] = FMT_IPV6_WIDTH;
     }
 
     if ( !no_titles) {
@@ -867,30 +1135,37 @@ dumpRecords(
                 w[4], "Start_Time", delimiter,
                 w[5], "End_Time",   final_delim);
     }
+}
 
-    for (i = 0; i < RWAC_ARRAYSIZE; i++) {
-        if (NULL != hash_bins[i]) {
-            bin = hash_bins[i];
-            do {
-                if (IS_RECORD_WITHIN_LIMITS(bin)) {
-                    skipaddrSetV4(&ipaddr, &bin->cr_key);
-                    fprintf(outfp, FMT_REC_VALUE,
-                            w[0], skipaddrString(ip_st, &ipaddr, ip_format),
-                            delimiter,
-                            w[1], bin->cr_bytes,   delimiter,
-                            w[2], bin->cr_packets, delimiter,
-                            w[3], bin->cr_records, delimiter,
-                            w[4], sktimestamp_r(start_st,
-                                                sktimeCreate(bin->cr_start, 0),
-                                                time_flags),
-                            delimiter,
-                            w[5], sktimestamp_r(end_st,
-                                                sktimeCreate(bin->cr_end, 0),
-                                                time_flags),
-                            final_delim);
-                }
-                bin = bin->cr_next;
-            } while (bin != hash_bins[i]);
+
+/*
+ *  int dumpRecords(outfp)
+ *
+ *    Dumps the addrcount contents as a record of bytes, packets,
+ *    times &c to 'outfp'
+ *
+ *    This is the typical text output from addrcount.
+ *
+ */
+static int
+dumpRecords(
+    FILE               *outfp)
+{
+    int w[] = FMT_REC_WIDTH;
+    countRecord_t bin;
+    HASH_ITER iter;
+    uint8_t *key_ptr;
+    uint8_t *val_ptr;
+
+    printRecordTitle(outfp, w);
+
+    iter = hashlib_sharded_create_iterator(count_table);
+    while (hashlib_sharded_iterate(count_table, &iter, &key_ptr, &val_ptr)
+           == OK)
+    {
+        memcpy(&bin, val_ptr, sizeof(bin));
+        if (IS_RECORD_WITHIN_LIMITS(&bin)) {
+            printRecord(outfp, w, key_ptr, val_ptr);
         }
     }
     return 0;
@@ -909,69 +1184,22 @@ dumpRecordsSorted(
     FILE               *outfp)
 {
     int w[] = FMT_REC_WIDTH;
-    uint32_t ip, key;
-    countRecord_t *bin;
-    skIPTree_t *ipset;
-    skIPTreeIterator_t iter;
-    char ip_st[SK_NUM2DOT_STRLEN];
-    char start_st[SKTIMESTAMP_STRLEN];
-    char end_st[SKTIMESTAMP_STRLEN];
-    skipaddr_t ipaddr;
-
-    if (no_columns) {
-        memset(w, 0, sizeof(w));
-    }
+    countEntry_t *entries;
+    size_t count;
+    size_t i;
 
-    hashToIPTree(&ipset);
-    if (skIPTreeIteratorBind(&iter, ipset)) {
-        skAppPrintErr("Unable to bind IPTree iterator");
-        skIPTreeDelete(&ipset);
+    entries = sortEntries(&count);
+    if (NULL == entries) {
         return 1;
     }
 
-    if ( !no_titles) {
-        fprintf(outfp, FMT_REC_TITLE,
-                w[0], (use_dest ? "dIP" : "sIP"), delimiter,
-                w[1], "Bytes",      delimiter,
-                w[2], "Packets",    delimiter,
-                w[3], "Records",    delimiter,
-                w[4], "Start_Time", delimiter,
-                w[5], "End_Time",   final_delim);
-    }
-
-    while (skIPTreeIteratorNext(&ip, &iter) == SK_ITERATOR_OK) {
-
-        /* find the ip's entry in the hash table */
-        key = HASHFUNC(ip);
+    printRecordTitle(outfp, w);
 
-        /* loop through the list of records at this hash table entry
-         * until we find the one that has the IP we want */
-        bin = hash_bins[key];
-        while (ip != bin->cr_key) {
-            /* not the ip we wanted; goto next */
-            bin = bin->cr_next;
-            /* if we've looped all the around, we missed the
-             * IP we wanted, and things are horked */
-            assert(bin != hash_bins[key]);
-        }
-
-        skipaddrSetV4(&ipaddr, &bin->cr_key);
-        fprintf(outfp, FMT_REC_VALUE,
-                w[0], skipaddrString(ip_st, &ipaddr, ip_format), delimiter,
-                w[1], bin->cr_bytes,   delimiter,
-                w[2], bin->cr_packets, delimiter,
-                w[3], bin->cr_records, delimiter,
-                w[4], sktimestamp_r(start_st,
-                                    sktimeCreate(bin->cr_start, 0),
-                                    time_flags),
-                delimiter,
-                w[5], sktimestamp_r(end_st,
-                                    sktimeCreate(bin->cr_end, 0),
-                                    time_flags),
-                final_delim);
+    for (i = 0; i < count; ++i) {
+        printRecord(outfp, w, entries[i].ce_key, entries[i].ce_value);
     }
 
-    skIPTreeDelete(&ipset);
+    free(entries);
     return 0;
 }
 
@@ -988,26 +1216,27 @@ static int
 dumpIPs(
     FILE               *outfp)
 {
-    uint32_t i;
-    countRecord_t *bin;
+    int w = (ipv6_keys ? FMT_IPV6_WIDTH : 15);
+    countRecord_t bin;
+    HASH_ITER iter;
+    uint8_t *key_ptr;
+    uint8_t *val_ptr;
     char ip_st[SK_NUM2DOT_STRLEN];
     skipaddr_t ipaddr;
 
     if ( !no_titles) {
-        fprintf(outfp, "%15s\n", (use_dest ? "dIP" : "sIP"));
+        fprintf(outfp, "%*s\n", w, (use_dest ? "dIP" : "sIP"));
     }
 
-    for (i = 0; i < RWAC_ARRAYSIZE; i++) {
-        if (NULL != hash_bins[i]) {
-            bin = hash_bins[i];
-            do {
-                if (IS_RECORD_WITHIN_LIMITS(bin)) {
-                    skipaddrSetV4(&ipaddr, &bin->cr_key);
-                    fprintf(outfp, "%15s\n",
-                            skipaddrString(ip_st, &ipaddr, ip_format));
-                }
-                bin = bin->cr_next;
-            } while (bin != hash_bins[i]);
+    iter = hashlib_sharded_create_iterator(count_table);
+    while (hashlib_sharded_iterate(count_table, &iter, &key_ptr, &val_ptr)
+           == OK)
+    {
+        memcpy(&bin, val_ptr, sizeof(bin));
+        if (IS_RECORD_WITHIN_LIMITS(&bin)) {
+            keyToAddr(&ipaddr, key_ptr);
+            fprintf(outfp, "%*s\n",
+                    w, skipaddrString(ip_st, &ipaddr, ip_format));
         }
     }
     return 0;
@@ -1024,28 +1253,27 @@ static int
 dumpIPsSorted(
     FILE               *outfp)
 {
-    uint32_t ip;
-    skIPTree_t *ipset;
-    skIPTreeIterator_t iter;
+    int w = (ipv6_keys ? FMT_IPV6_WIDTH : 15);
+    countEntry_t *entries;
+    size_t count;
+    size_t i;
     char ip_st[SK_NUM2DOT_STRLEN];
     skipaddr_t ipaddr;
 
-    hashToIPTree(&ipset);
-    if (skIPTreeIteratorBind(&iter, ipset)) {
-        skAppPrintErr("Unable to create IPTree iterator");
-        skIPTreeDelete(&ipset);
+    entries = sortEntries(&count);
+    if (NULL == entries) {
         return 1;
     }
 
     if ( !no_titles) {
-        fprintf(outfp, "%15s\n", (use_dest ? "dIP" : "sIP"));
+        fprintf(outfp, "%*s\n", w, (use_dest ? "dIP" : "sIP"));
     }
-    while (skIPTreeIteratorNext(&ip, &iter) == SK_ITERATOR_OK) {
-        skipaddrSetV4(&ipaddr, &ip);
-        fprintf(outfp, "%15s\n", skipaddrString(ip_st, &ipaddr, ip_format));
+    for (i = 0; i < count; ++i) {
+        keyToAddr(&ipaddr, entries[i].ce_key);
+        fprintf(outfp, "%*s\n", w, skipaddrString(ip_st, &ipaddr, ip_format));
     }
 
-    skIPTreeDelete(&ipset);
+    free(entries);
     return 0;
 }
 
@@ -1061,12 +1289,14 @@ dumpStats(
     FILE               *outfp)
 {
     int fmt_width[] = FMT_STAT_WIDTH;
-    uint32_t i;
-    uint32_t qual_ips;
-    uint32_t tot_ips;
+    uint64_t qual_ips;
+    uint64_t tot_ips;
     uint64_t qual_bytes, qual_packets, qual_records;
     uint64_t tot_bytes,  tot_packets,  tot_records;
-    countRecord_t *bin;
+    countRecord_t bin;
+    HASH_ITER iter;
+    uint8_t *key_ptr;
+    uint8_t *val_ptr;
 
     qual_ips = 0;
     tot_ips = 0;
@@ -1076,23 +1306,22 @@ dumpStats(
     if (no_columns) {
         memset(fmt_width, 0, sizeof(fmt_width));
     }
-    for (i = 0; i < RWAC_ARRAYSIZE; i++) {
-        if (NULL != hash_bins[i]) {
-            bin = hash_bins[i];
-            do {
-                ++tot_ips;
-                tot_bytes   += bin->cr_bytes;
-                tot_packets += bin->cr_packets;
-                tot_records += bin->cr_records;
-
-                if (IS_RECORD_WITHIN_LIMITS(bin)) {
-                    ++qual_ips;
-                    qual_bytes   += bin->cr_bytes;
-                    qual_packets += bin->cr_packets;
-                    qual_records += bin->cr_records;
-                }
-                bin = bin->cr_next;
-            } while (bin != hash_bins[i]);
+
+    iter = hashlib_sharded_create_iterator(count_table);
+    while (hashlib_sharded_iterate(count_table, &iter, &key_ptr, &val_ptr)
+           == OK)
+    {
+        memcpy(&bin, val_ptr, sizeof(bin));
+        ++tot_ips;
+        tot_bytes   += bin.cr_bytes;
+        tot_packets += bin.cr_packets;
+        tot_records += bin.cr_records;
+
+        if (IS_RECORD_WITHIN_LIMITS(&bin)) {
+            ++qual_ips;
+            qual_bytes   += bin.cr_bytes;
+            qual_packets += bin.cr_packets;
+            qual_records += bin.cr_records;
         }
     }
 
@@ -1140,97 +1369,62 @@ static int
 dumpIPSet(
     const char         *path)
 {
-    skIPTree_t *ipset;
+    skipset_t *ipset;
+    countRecord_t bin;
+    HASH_ITER iter;
+    uint8_t *key_ptr;
+    uint8_t *val_ptr;
+    skipaddr_t ipaddr;
+    int rv;
 
-    /* Create the ip tree */
-    hashToIPTree(&ipset);
+    /* Create the IPset; it converts itself to IPv6 when an IPv6
+     * address is inserted */
+    rv = skIPSetCreate(&ipset, 0);
+    if (rv) {
+        skAppPrintErr("Unable to create IPset: %s", skIPSetStrerror(rv));
+        exit(EXIT_FAILURE);
+    }
+
+    iter = hashlib_sharded_create_iterator(count_table);
+    while (hashlib_sharded_iterate(count_table, &iter, &key_ptr, &val_ptr)
+           == OK)
+    {
+        memcpy(&bin, val_ptr, sizeof(bin));
+        if (IS_RECORD_WITHIN_LIMITS(&bin)) {
+            keyToAddr(&ipaddr, key_ptr);
+            rv = skIPSetInsertAddress(ipset, &ipaddr, 0);
+            if (rv) {
+                skAppPrintErr("Unable to add IP to IPset: %s",
+                              skIPSetStrerror(rv));
+                exit(EXIT_FAILURE);
+            }
+        }
+    }
+    skIPSetClean(ipset);
 
     /*
      * Okay, now we write to disk.
      */
-    if (skIPTreeSave(ipset, path)) {
+    rv = skIPSetSave(ipset, path);
+    if (rv) {
+        skAppPrintErr("Unable to write IPset to '%s': %s",
+                      path, skIPSetStrerror(rv));
         exit(EXIT_FAILURE);
     }
 
-    skIPTreeDelete(&ipset);
+    skIPSetDestroy(&ipset);
     return 0;
 }
 
 
-/*
- *  void countFile(stream)
- *
- *    Read the flow records from stream and fill the hash table with
- *    countRecord_t's.
- */
-static void
-countFile(
-    skstream_t         *stream)
-{
-    uint32_t hash_idx;
-    countRecord_t *bin;
-    rwRec rwrec;
-    int rv;
-
-    /* Read records */
-    while ((rv = skStreamReadRecord(stream, &rwrec)) == SKSTREAM_OK) {
-        hash_idx = HASHFUNC(GETIP(&rwrec));
-
-        /*
-         * standard hash foo - check to see if we've got a value.
-         * If not, create and stuff.  If so, check to see if they
-         * match - if so, stuff.  If not, move down until you do -
-         * if you find nothing, stuff.
-         */
-        if (hash_bins[hash_idx] == NULL) {
-            /* new bin */
-            hash_bins[hash_idx] = newBin(&rwrec);
-            hash_bins[hash_idx]->cr_next = hash_bins[hash_idx];
-        } else {
-            /* hash collision */
-            bin = hash_bins[hash_idx];
-            while ((bin->cr_next != hash_bins[hash_idx]) &&
-                   !CMPFNC(&rwrec, bin))
-            {
-                bin = bin->cr_next;
-            }
-            /*
-             * Alright, we've either hit the end of the linked
-             * list or we've found the value (or both).  Check if
-             * we found the value. */
-            if (CMPFNC(&rwrec, bin)) {
-                addToBin(bin, &rwrec);
-            } else {
-                assert(bin->cr_next == hash_bins[hash_idx]);
-                bin->cr_next = newBin(&rwrec);
-                bin = bin->cr_next;
-                bin->cr_next = hash_bins[hash_idx]; /* Restore the loop */
-            }
-            hash_bins[hash_idx] = bin;
-        }
-    }
-    if (rv != SKSTREAM_ERR_EOF) {
-        skStreamPrintLastErr(stream, rv, &skAppPrintErr);
-    }
-}
-
-
 int main(int argc, char **argv)
 {
-    skstream_t *stream;
     int rv;
 
     appSetup(argc, argv);                 /* never returns on error */
 
     /* Read in records from all input files */
-    while ((rv = skOptionsCtxNextSilkFile(optctx, &stream, &skAppPrintErr))
-           == 0)
-    {
-        skStreamSetIPv6Policy(stream, SK_IPV6POLICY_ASV4);
-        countFile(stream);
-        skStreamDestroy(&stream);
-    }
-    if (rv < 0) {
+    if (countInputs()) {
         exit(EXIT_FAILURE);
     }
 
@@ -0,0 +1,17 @@
+#! /usr/bin/perl -w
+# MD5: b735044e71450c95df568cccd459d741
+# TEST: ./rwaddrcount --print-rec --sort-ips --threads=4 ../../tests/data.rwf ../../tests/data-v6.rwf ../../tests/empty.rwf ../../tests/data.rwf
+
+use strict;
+use SiLKTests;
+
+my $rwaddrcount = check_silk_app('rwaddrcount');
+my %file;
+$file{data} = get_data_or_exit77('data');
+$file{v6data} = get_data_or_exit77('v6data');
+$file{empty} = get_data_or_exit77('empty');
+check_features(qw(ipv6));
+my $cmd = "$rwaddrcount --print-rec --sort-ips --threads=4 $file{data} $file{v6data} $file{empty} $file{data}";
+my $md5 = "b735044e71450c95df568cccd459d741";
+
+check_md5_output($md5, $cmd);
@@ -45,6 +45,12 @@ while (<DATA>) {
     elsif (!$SiLKTests::SK_ENABLE_SNAPPY && $tail_name =~ /-c3-/) {
         # skip
     }
+    elsif (!$SiLKTests::SK_ENABLE_ZSTD && $tail_name =~ /-c4-/) {
+        # skip
+    }
+    elsif (!$SiLKTests::SK_ENABLE_LZ4 && $tail_name =~ /-c5-/) {
+        # skip
+    }
     else {
         $checksums{$tail_name} = [$expect];
     }
@@ -150,6 +156,10 @@ aad19fce22233c7766afcb5bacc72148  FT_FLOWCAP-v2-c0-L.dat
 17452fc1de6627ec5bee7c9943bd08b3  FT_FLOWCAP-v2-c2-L.dat
 fe6d1d23029632ebf082705a16332077  FT_FLOWCAP-v2-c3-B.dat
 25ad9a986d62feaf6062cf02fe0f6733  FT_FLOWCAP-v2-c3-L.dat
+6a9d21ab30fa7359ccd569a5e5eeb5ea  FT_FLOWCAP-v2-c4-B.dat
+96fe88bf85480dc28781e72a939ddb63  FT_FLOWCAP-v2-c4-L.dat
+03f7b7cbc884b3fc2c1bea572226a9be  FT_FLOWCAP-v2-c5-B.dat
+09fcc1ae65a4002c199258ee3493d7eb  FT_FLOWCAP-v2-c5-L.dat
 cee1b1f74822b31a7441a8211fa5bfed  FT_FLOWCAP-v3-c0-B.dat
 a93c68d3143fe1f5c341f56ab860492b  FT_FLOWCAP-v3-c0-L.dat
 86dca7d5924c99c676f2613b9a655fdc  FT_FLOWCAP-v3-c1-B.dat
@@ -158,6 +168,10 @@ ffe123fdb7dd8e01099575c3f9219ba3  FT_FLOWCAP-v3-c1-L.dat
 085b796186e4392ff8df1436bf5b57f0  FT_FLOWCAP-v3-c2-L.dat
 d805f91ec2f50f173df4804fccaf7c13  FT_FLOWCAP-v3-c3-B.dat
 5efaf2bdb2c3bc24f41a936464d53208  FT_FLOWCAP-v3-c3-L.dat
+71d95b9de1c42879c40fbf45f9ae7bea  FT_FLOWCAP-v3-c4-B.dat
+0044ad746890b52e809fce956757e9c7  FT_FLOWCAP-v3-c4-L.dat
+2806750be50483113af1c1b36311ecb8  FT_FLOWCAP-v3-c5-B.dat
+cf850596f03d2a017867824f42f1f96e  FT_FLOWCAP-v3-c5-L.dat
 ca48fd33ad7dd52b39b2fd7845c5068c  FT_FLOWCAP-v4-c0-B.dat
 be8884450fa255feafb1c29237543abe  FT_FLOWCAP-v4-c0-L.dat
 c18e37c1d921c4085a9a468c034d4cec  FT_FLOWCAP-v4-c1-B.dat
@@ -166,6 +180,10 @@ cc5788bf9bd9170c8e1866133b9db791  FT_FLOWCAP-v4-c2-B.dat
 7268776400d7f2e33b9be03dd119a989  FT_FLOWCAP-v4-c2-L.dat
 5dab0633d7c8ba725d655571924fba00  FT_FLOWCAP-v4-c3-B.dat
 d6ca894b19d402c8edfda2f50d82a694  FT_FLOWCAP-v4-c3-L.dat
+49445c6511acbac656769396ff9a997d  FT_FLOWCAP-v4-c4-B.dat
+ae5e647348b1193d4f5bde90a046f2f6  FT_FLOWCAP-v4-c4-L.dat
+cd1aad84d94acde2672c74241d5dbbe0  FT_FLOWCAP-v4-c5-B.dat
+c1dd67f2926663597e05792b6f1fd0eb  FT_FLOWCAP-v4-c5-L.dat
 7528be67c52e6f0dd5752ef39d9a8c8e  FT_FLOWCAP-v5-c0-B.dat
 a85ad2f2bdb42130027602e743bdc04c  FT_FLOWCAP-v5-c0-L.dat
 adb12ec96e46e3d7afd7cbb8dc2b0260  FT_FLOWCAP-v5-c1-B.dat
@@ -174,6 +192,10 @@ adb12ec96e46e3d7afd7cbb8dc2b0260  FT_FLOWCAP-v5-c1-B.dat
 f52996762d83f050fe0e95bbb47c0a16  FT_FLOWCAP-v5-c2-L.dat
 cad0d5f8e7e3a70f2699252932d8b132  FT_FLOWCAP-v5-c3-B.dat
 911b7081ec8fd2c6a9cac2a5159d59a3  FT_FLOWCAP-v5-c3-L.dat
+6e1a83f814ce535ebba6e230fc947e69  FT_FLOWCAP-v5-c4-B.dat
+5eeb0ee22740a6e97c7dbf002c48e491  FT_FLOWCAP-v5-c4-L.dat
+dea7225d26849fcd2dce7fc8fe4420d2  FT_FLOWCAP-v5-c5-B.dat
+4066e76aac60826a985a0bc433ff4844  FT_FLOWCAP-v5-c5-L.dat
 c1cc1ca72b1732d6ffb2f2c2085d4c89  FT_FLOWCAP-v6-c0-B.dat
 02580d776eb78efbc269641247589afd  FT_FLOWCAP-v6-c0-L.dat
 259634b5542115cd8fb92ff156eaca2c  FT_FLOWCAP-v6-c1-B.dat
@@ -182,6 +204,10 @@ c1cc1ca72b1732d6ffb2f2c2085d4c89  FT_FLOWCAP-v6-c0-B.dat
 64329ca995c82e4f2df92af5338c4693  FT_FLOWCAP-v6-c2-L.dat
 e96c4ee5ebe6fed9279d411d282f2bec  FT_FLOWCAP-v6-c3-B.dat
 63ae160c0b59d1b4c7a239730661bead  FT_FLOWCAP-v6-c3-L.dat
+ce1f7791bd1420b8f342e3038fbde581  FT_FLOWCAP-v6-c4-B.dat
+15a1c59bf2b07af79635b856844b91a7  FT_FLOWCAP-v6-c4-L.dat
+1e5d27016dfe36a96032068ed388699f  FT_FLOWCAP-v6-c5-B.dat
+d4543902102dffa505e328b346499c72  FT_FLOWCAP-v6-c5-L.dat
 4a50279ac5644e9303abed48e86932e9  FT_RWAUGMENTED-v1-c0-B.dat
 3bf9a754b721f9baed5430524a81367c  FT_RWAUGMENTED-v1-c0-L.dat
 a5e5d3717c3ff3392677b15620167b9f  FT_RWAUGMENTED-v1-c1-B.dat
@@ -190,6 +216,10 @@ b1f2ef65432af17c8c23eae012e5e677  FT_RWAUGMENTED-v1-c2-B.dat
 8055ba43f57bccb4237d21abd815949b  FT_RWAUGMENTED-v1-c2-L.dat
 cf6d053719435ef62cd666966be412da  FT_RWAUGMENTED-v1-c3-B.dat
 36e77f1bb6b8fd3d2d26d3436e53468e  FT_RWAUGMENTED-v1-c3-L.dat
+2786ffaea29f24a7b74ba13c630fe539  FT_RWAUGMENTED-v1-c4-B.dat
+407927c63b2f3ab61a789402bd6070cd  FT_RWAUGMENTED-v1-c4-L.dat
+ecff759d215d22e84f2bb8a03c911195  FT_RWAUGMENTED-v1-c5-B.dat
+a11b8c96c5fd02b849009ff7843f2593  FT_RWAUGMENTED-v1-c5-L.dat
 373b4efb3dcd689d43bd1a872d8a0b82  FT_RWAUGMENTED-v2-c0-B.dat
 e49b4d08689b220153101d6a306fa144  FT_RWAUGMENTED-v2-c0-L.dat
 cd2058d07fdf08190ddd1ba70dc9ed19  FT_RWAUGMENTED-v2-c1-B.dat
@@ -198,6 +228,10 @@ cd2058d07fdf08190ddd1ba70dc9ed19  FT_RWAUGMENTED-v2-c1-B.dat
 f21bcd9349a304f81195f947b151880b  FT_RWAUGMENTED-v2-c2-L.dat
 30ab357f7685d8e8c3308a7a6b7cb422  FT_RWAUGMENTED-v2-c3-B.dat
 7eaa5ba20e024652e53b13d9da0cfed8  FT_RWAUGMENTED-v2-c3-L.dat
+155a6a9f502295a5a53176f906240664  FT_RWAUGMENTED-v2-c4-B.dat
+c53237b30d8f2df3b8a496e49ae7efb4  FT_RWAUGMENTED-v2-c4-L.dat
+c329fae9cc3bb7976fcc2b008c33d2a4  FT_RWAUGMENTED-v2-c5-B.dat
+d27ed7ee8ad41765ef4f5a603875a78b  FT_RWAUGMENTED-v2-c5-L.dat
 b2bd70fb60cfcb7f61e928508b2fcbb0  FT_RWAUGMENTED-v3-c0-B.dat
 dd3828107a232b67e074d3b2883d2ca1  FT_RWAUGMENTED-v3-c0-L.dat
 564cadb0881704e57e641acdca8d2505  FT_RWAUGMENTED-v3-c1-B.dat
@@ -206,6 +240,10 @@ dd3828107a232b67e074d3b2883d2ca1  FT_RWAUGMENTED-v3-c0-L.dat
 5b3da2eb1dbb9720ae439bbaaaa8d2d7  FT_RWAUGMENTED-v3-c2-L.dat
 c5d01f2efe0f0d4029cb6ad6c8cb2baa  FT_RWAUGMENTED-v3-c3-B.dat
 61200d95966950d63c156876ad2d3b8b  FT_RWAUGMENTED-v3-c3-L.dat
+ff2c7208fb3db94632a9e16c006c417f  FT_RWAUGMENTED-v3-c4-B.dat
+139e67eba13254ecc61a1364051196fa  FT_RWAUGMENTED-v3-c4-L.dat
+1044bf82404c02746b41a37d143242da  FT_RWAUGMENTED-v3-c5-B.dat
+f02915f0a9792b56c51642edc44d9f99  FT_RWAUGMENTED-v3-c5-L.dat
 262f51d3ae0f756e0127aa08538519b1  FT_RWAUGMENTED-v4-c0-B.dat
 144aba6d77cd68ea8370460f74a4461c  FT_RWAUGMENTED-v4-c0-L.dat
 92093094295a885840f97b1c836ea23d  FT_RWAUGMENTED-v4-c1-B.dat
@@ -214,6 +252,10 @@ c5d01f2efe0f0d4029cb6ad6c8cb2baa  FT_RWAUGMENTED-v3-c3-B.dat
 345545ae3004e0db2b2a8f352e079876  FT_RWAUGMENTED-v4-c2-L.dat
 e8102fc1bb038ab258c10cc95074cf5c  FT_RWAUGMENTED-v4-c3-B.dat
 740778a2db383b4f7e4351bf0abd9c6d  FT_RWAUGMENTED-v4-c3-L.dat
+1a06b3dcea6c8a8a3713a4f7ccee7d78  FT_RWAUGMENTED-v4-c4-B.dat
+b5d5533c6f50d50c80ad022311b73583  FT_RWAUGMENTED-v4-c4-L.dat
+69a19294379566c0bbd2dcabb6b9dd2d  FT_RWAUGMENTED-v4-c5-B.dat
+f4e75f17231b3fe2bd9a26f314572cc5  FT_RWAUGMENTED-v4-c5-L.dat
 a837739733c2ff3df2148bb5cd4947af  FT_RWAUGMENTED-v5-c0-B.dat
 d2480d6252e5efe1ec04b1a1bde56241  FT_RWAUGMENTED-v5-c0-L.dat
 df4441021aaf12ce64736a4bce232359  FT_RWAUGMENTED-v5-c1-B.dat
@@ -222,6 +264,10 @@ df4441021aaf12ce64736a4bce232359  FT_RWAUGMENTED-v5-c1-B.dat
 8da2469163cd8f18965ad1cccfedb138  FT_RWAUGMENTED-v5-c2-L.dat
 c90f360d0df2c5ade0807c33b02412fb  FT_RWAUGMENTED-v5-c3-B.dat
 44e712f5762c5ae44b0dbe939db90eb7  FT_RWAUGMENTED-v5-c3-L.dat
+c71f6cc0c503b280fb6d1512350e3c24  FT_RWAUGMENTED-v5-c4-B.dat
+0bbbcc4c9d002f687dd8a67a08249327  FT_RWAUGMENTED-v5-c4-L.dat
+f88d76881be7ef8572170c88f4174fa5  FT_RWAUGMENTED-v5-c5-B.dat
+fad2078d5fc0f0ffcec2b8eb04adfaf0  FT_RWAUGMENTED-v5-c5-L.dat
 98f941dd108eb9adb6cd2345e84f3446  FT_RWAUGROUTING-v1-c0-B.dat
 142535ea5803b315fe462c577f489981  FT_RWAUGROUTING-v1-c0-L.dat
 385a009413348bd9907bc4ee9b42971d  FT_RWAUGROUTING-v1-c1-B.dat
@@ -230,6 +276,10 @@ f0345fe39fa5ba8c2850e1d0fc7e3512  FT_RWAUGROUTING-v1-c2-B.dat
 b2ce0a2060dd7394e18e44ab8479739d  FT_RWAUGROUTING-v1-c2-L.dat
 f3f0b7602ca707bc192eff99253b7dbf  FT_RWAUGROUTING-v1-c3-B.dat
 1f8fbfe9192ee25162945c1657e5d235  FT_RWAUGROUTING-v1-c3-L.dat
+1094b1f86b969c6e4957f7f181249dcf  FT_RWAUGROUTING-v1-c4-B.dat
+5210ddfea5a8eaf4f2f1609698910036  FT_RWAUGROUTING-v1-c4-L.dat
+6d43287ca79453816da8b3d408e4f751  FT_RWAUGROUTING-v1-c5-B.dat
+8bad46f5215052fa8b7d3325a9d7ef29  FT_RWAUGROUTING-v1-c5-L.dat
 6c15e70f39c472ce767cb980b60f0906  FT_RWAUGROUTING-v2-c0-B.dat
 75399a83966d3aaee25fab55e6880670  FT_RWAUGROUTING-v2-c0-L.dat
 83c2f84eff7b0d9bf60d2ce8c754cf0b  FT_RWAUGROUTING-v2-c1-B.dat
@@ -238,6 +288,10 @@ fee5b7e3606874f0547bf24980cec47e  FT_RWAUGROUTING-v2-c2-B.dat
 b0e1615a33b13a784c88fe4bc5d4760d  FT_RWAUGROUTING-v2-c2-L.dat
 79adb620cd8ea27e516d36c12273e2ba  FT_RWAUGROUTING-v2-c3-B.dat
 5e657b4449207187e5f70a7b8af6585c  FT_RWAUGROUTING-v2-c3-L.dat
+0896b0e7b380c75c6f4b1487efb8a614  FT_RWAUGROUTING-v2-c4-B.dat
+1a69de211cf297d85dfb016dd1d4f9c4  FT_RWAUGROUTING-v2-c4-L.dat
+ebefe0b0e3bc1e86f4ddc23767495bb5  FT_RWAUGROUTING-v2-c5-B.dat
+6dbe2385439484f74a2413b92984f030  FT_RWAUGROUTING-v2-c5-L.dat
 38de6be29e51e2ae9612ad38ad13c38d  FT_RWAUGROUTING-v3-c0-B.dat
 f6de88739278985c7b8f3b4e3b359d0f  FT_RWAUGROUTING-v3-c0-L.dat
 c4ff7dc4cb28933647ca1ad9a2383850  FT_RWAUGROUTING-v3-c1-B.dat
@@ -246,6 +300,10 @@ bcfd975c66e9166a95b28b76cd1c49a9  FT_RWAUGROUTING-v3-c1-L.dat
 af234bd2185ae67b6ee988bf7b3ffb25  FT_RWAUGROUTING-v3-c2-L.dat
 bdcf6fb78713040ceb518c72d49b15b4  FT_RWAUGROUTING-v3-c3-B.dat
 c9550388429c76a9eb22246ac2af3e86  FT_RWAUGROUTING-v3-c3-L.dat
+f7866d94b3562d1ceffa22acd440ba47  FT_RWAUGROUTING-v3-c4-B.dat
+46a403918606e92b88d11d4b97a23e87  FT_RWAUGROUTING-v3-c4-L.dat
+3c322eee0f51006b39a0eaf146c24132  FT_RWAUGROUTING-v3-c5-B.dat
+2ef2fe57ffcc7d0ee45678758752cfdc  FT_RWAUGROUTING-v3-c5-L.dat
 c971232239be750b0ce8ef6078955f9a  FT_RWAUGROUTING-v4-c0-B.dat
 bac0c79592ffa00c6cfe37af3aee49a6  FT_RWAUGROUTING-v4-c0-L.dat
 053445f125f46dc694c60bb8981f7b92  FT_RWAUGROUTING-v4-c1-B.dat
@@ -254,6 +312,10 @@ ed5bdbdddf969a7717cc6c4e29d6b1a7  FT_RWAUGROUTING-v4-c1-L.dat
 378a8c3a4ce5507ff77ed4205eb2e1b9  FT_RWAUGROUTING-v4-c2-L.dat
 5c8f763e8ebb546d02ab4d26e47180f5  FT_RWAUGROUTING-v4-c3-B.dat
 8e52de08624fe717944eff1295058039  FT_RWAUGROUTING-v4-c3-L.dat
+fdd26955f41ab8f46a517d0d2526085a  FT_RWAUGROUTING-v4-c4-B.dat
+e7575cfe0e8dfa47e74f68c4209bbd3e  FT_RWAUGROUTING-v4-c4-L.dat
+4678a12b69b092438e32ff2cac00031b  FT_RWAUGROUTING-v4-c5-B.dat
+9644af07c72d0d5622ca3af170df3194  FT_RWAUGROUTING-v4-c5-L.dat
 f5eb6d15777dd5ce35a31b5869f0b3bc  FT_RWAUGROUTING-v5-c0-B.dat
 0ccdac22beb624a192afca1b1dbb6e48  FT_RWAUGROUTING-v5-c0-L.dat
 1f927fbb39227e6787d8d5c9d980fb89  FT_RWAUGROUTING-v5-c1-B.dat
@@ -262,6 +324,10 @@ c280bc817bd45b18a4d215c6a42ca6d8  FT_RWAUGROUTING-v5-c2-B.dat
 040ee413492170a753c1bc77d98c34c6  FT_RWAUGROUTING-v5-c2-L.dat
 be3106f3e37ccef53e31be43e3b709a0  FT_RWAUGROUTING-v5-c3-B.dat
 758857a1139310bcb82583b261364924  FT_RWAUGROUTING-v5-c3-L.dat
+5354ae0350f56c080346f0bdaeae84bd  FT_RWAUGROUTING-v5-c4-B.dat
+0d601ecef01a66baede505e4df84fb9d  FT_RWAUGROUTING-v5-c4-L.dat
+0a04c1b9ad38c80c8d7df44032b3f545  FT_RWAUGROUTING-v5-c5-B.dat
+a1eac938ba013ca04727c819fbead8a2  FT_RWAUGROUTING-v5-c5-L.dat
 149c0f889c54d264053645ed0f02931a  FT_RWAUGSNMPOUT-v1-c0-B.dat
 0cd1a08bdc4ddc2aac2192a84d7141d9  FT_RWAUGSNMPOUT-v1-c0-L.dat
 7b252a5581fd720576dd48b707720c4a  FT_RWAUGSNMPOUT-v1-c1-B.dat
@@ -270,6 +336,10 @@ d2956ea1e10a511257265490d46cdec0  FT_RWAUGSNMPOUT-v1-c2-B.dat
 5d3b367607de68d1a2de072bdecfb870  FT_RWAUGSNMPOUT-v1-c2-L.dat
 c276530855a82a5b5018dacf0c51958f  FT_RWAUGSNMPOUT-v1-c3-B.dat
 013c933cf10011bb6cd00474a60a90b7  FT_RWAUGSNMPOUT-v1-c3-L.dat
+963d2bd33b38d80fee4e5af7118f1f54  FT_RWAUGSNMPOUT-v1-c4-B.dat
+316b7999fb13e62a87ad1d20ed887cf3  FT_RWAUGSNMPOUT-v1-c4-L.dat
+8fe44b2f2e7c9f0988f710ec12995193  FT_RWAUGSNMPOUT-v1-c5-B.dat
+301cfc09878f68a1e620ae36fe23a477  FT_RWAUGSNMPOUT-v1-c5-L.dat
 ae2efb2041e4b72ef737de7c22a0018d  FT_RWAUGSNMPOUT-v2-c0-B.dat
 d736603959b74a839365489823f37354  FT_RWAUGSNMPOUT-v2-c0-L.dat
 3a7a9ee77c5572e850274c82d2caa238  FT_RWAUGSNMPOUT-v2-c1-B.dat
@@ -278,6 +348,10 @@ adc9b15e3e734d3786172a192b36ad22  FT_RWAUGSNMPOUT-v2-c1-L.dat
 d7d2d6dfd254167b8c866bea1d713340  FT_RWAUGSNMPOUT-v2-c2-L.dat
 02cb6e2c4d24825f2e621a119db16dd0  FT_RWAUGSNMPOUT-v2-c3-B.dat
 2de3078ec7192efb93fff01ef5ff4d4b  FT_RWAUGSNMPOUT-v2-c3-L.dat
+ccce156daa4656ac59282fff9818b433  FT_RWAUGSNMPOUT-v2-c4-B.dat
+734f4b3e71344ec0ad1908d396a2b165  FT_RWAUGSNMPOUT-v2-c4-L.dat
+7acd486f9c1d3a08a016094a6db8f5ef  FT_RWAUGSNMPOUT-v2-c5-B.dat
+38ab87e6e7d2c5e8752e81555c3d8430  FT_RWAUGSNMPOUT-v2-c5-L.dat
 a3bd51c268884138d6264aaa648fb345  FT_RWAUGSNMPOUT-v3-c0-B.dat
 3143664e6fa8a9f234d1aad9af982ece  FT_RWAUGSNMPOUT-v3-c0-L.dat
 c5896cb89ebb0f8f2d0283beb8f870f6  FT_RWAUGSNMPOUT-v3-c1-B.dat
@@ -286,6 +360,10 @@ e9b386334dcdbf368301499546d1ac21  FT_RWAUGSNMPOUT-v3-c2-B.dat
 2e42052b89abfb6807e28bca0c5773f6  FT_RWAUGSNMPOUT-v3-c2-L.dat
 0161cf2f82c1b79280a6c947e94c9f55  FT_RWAUGSNMPOUT-v3-c3-B.dat
 8acb3c5a8256dbbf1c8b04841f6b9cec  FT_RWAUGSNMPOUT-v3-c3-L.dat
+e776a124f186142d9c921f6cd839373c  FT_RWAUGSNMPOUT-v3-c4-B.dat
+f180a42be09ef62df5a0dd6f278e3ef1  FT_RWAUGSNMPOUT-v3-c4-L.dat
+0a823c5025ab521ec26d3e933229c3c8  FT_RWAUGSNMPOUT-v3-c5-B.dat
+894c23ffb0cf817949b27137ffb193db  FT_RWAUGSNMPOUT-v3-c5-L.dat
 2c877ee05351789df6aa8059311278c1  FT_RWAUGSNMPOUT-v4-c0-B.dat
 8bd3676ddb668cb8024ef9a8dc2bb2f3  FT_RWAUGSNMPOUT-v4-c0-L.dat
 5d42754bbf97415a1c20954b4416e615  FT_RWAUGSNMPOUT-v4-c1-B.dat
@@ -294,6 +372,10 @@ e3e4ca6136c8541600b1178c508dde73  FT_RWAUGSNMPOUT-v4-c1-L.dat
 eb30d1b37ef7b04f0a019339e890d1a4  FT_RWAUGSNMPOUT-v4-c2-L.dat
 6a4253ac078f942ca98a9d10b494fef8  FT_RWAUGSNMPOUT-v4-c3-B.dat
 3cc69f0bc614ecbe2bb20494a14850be  FT_RWAUGSNMPOUT-v4-c3-L.dat
+71458a80dd6e4b367626f1daecd65948  FT_RWAUGSNMPOUT-v4-c4-B.dat
+9c237ac45af971fb342482facc585673  FT_RWAUGSNMPOUT-v4-c4-L.dat
+886f94764a44de4c6b08eca73f26419b  FT_RWAUGSNMPOUT-v4-c5-B.dat
+b9b39328694f8145f318622d4c619ddd  FT_RWAUGSNMPOUT-v4-c5-L.dat
 518c0691f788ef76fb71fe58d3d921b3  FT_RWAUGSNMPOUT-v5-c0-B.dat
 0fe6d5e27c443f63a5a31e7045189e19  FT_RWAUGSNMPOUT-v5-c0-L.dat
 d4b8d59f94c25fb0ed1c75c5ffd333a1  FT_RWAUGSNMPOUT-v5-c1-B.dat
@@ -302,6 +384,10 @@ d4b8d59f94c25fb0ed1c75c5ffd333a1  FT_RWAUGSNMPOUT-v5-c1-B.dat
 56620fa7b835ef1a9259876be4a9d5c5  FT_RWAUGSNMPOUT-v5-c2-L.dat
 9acb3dfb44fde9a574ed3f7b62983b10  FT_RWAUGSNMPOUT-v5-c3-B.dat
 86940744902547ea20ba44c8c385ca43  FT_RWAUGSNMPOUT-v5-c3-L.dat
+295a5d1225f9fd82dd48296e0e6b083c  FT_RWAUGSNMPOUT-v5-c4-B.dat
+a217aef1b67eda9f31229482df2be1cb  FT_RWAUGSNMPOUT-v5-c4-L.dat
+aab6352168a1c7d3364882f10ed0faf1  FT_RWAUGSNMPOUT-v5-c5-B.dat
+7ab600fbe339d637a748dcfb2c7c5e76  FT_RWAUGSNMPOUT-v5-c5-L.dat
 3e8a44d3508c1759901f66681433b28a  FT_RWAUGWEB-v1-c0-B.dat
 242d72f8797f1bfd645f95d0863dda01  FT_RWAUGWEB-v1-c0-L.dat
 258e9e083d17f50ff5254e768f8ae1b3  FT_RWAUGWEB-v1-c1-B.dat
@@ -310,6 +396,10 @@ d4b8d59f94c25fb0ed1c75c5ffd333a1  FT_RWAUGSNMPOUT-v5-c1-B.dat
 fc29b6b2b7d8073abeb4f2e44b16e16a  FT_RWAUGWEB-v1-c2-L.dat
 6c4b063e3b025c74a456e57224db227a  FT_RWAUGWEB-v1-c3-B.dat
 4d34c817ff3a08ba3c266069f901d766  FT_RWAUGWEB-v1-c3-L.dat
+44c27ebf947d66791893af154531cead  FT_RWAUGWEB-v1-c4-B.dat
+736a22a74596043f8c23915a810486a5  FT_RWAUGWEB-v1-c4-L.dat
+d0daaa516ba40fb61a0a78c94e308527  FT_RWAUGWEB-v1-c5-B.dat
+08ea55a0eb619e1ec9a490d9e289f9c3  FT_RWAUGWEB-v1-c5-L.dat
 fb8842cf8fc017d74ddf481bcfeccc3c  FT_RWAUGWEB-v2-c0-B.dat
 10a7545e53e6359186ec43e9625911df  FT_RWAUGWEB-v2-c0-L.dat
 9e5906f38d5ac464bce779618b26adac  FT_RWAUGWEB-v2-c1-B.dat
@@ -318,6 +408,10 @@ fb8842cf8fc017d74ddf481bcfeccc3c  FT_RWAUGWEB-v2-c0-B.dat
 147f54af0fe2c71c574a541e41caba89  FT_RWAUGWEB-v2-c2-L.dat
 2f0e694c6258f120b1da32bad2d385c5  FT_RWAUGWEB-v2-c3-B.dat
 62f017729111163cdb27bb46f69ac088  FT_RWAUGWEB-v2-c3-L.dat
+69b921548a9ffd6a6881668ecc3a72b4  FT_RWAUGWEB-v2-c4-B.dat
+78db8c64094b58caaced1e410a97dd1c  FT_RWAUGWEB-v2-c4-L.dat
+28889ea2f9b1964842d58613357ac973  FT_RWAUGWEB-v2-c5-B.dat
+441f9db8e9b29319b04ed45a7eaddb7e  FT_RWAUGWEB-v2-c5-L.dat
 0dbcf4148f9ef1d5134b60032d8f955c  FT_RWAUGWEB-v3-c0-B.dat
 1b60b8c8a9d5d7208956e4b0a0e65c50  FT_RWAUGWEB-v3-c0-L.dat
 8917f6d3683d6a8eea94bf2c24d16387  FT_RWAUGWEB-v3-c1-B.dat
@@ -326,6 +420,10 @@ fb8842cf8fc017d74ddf481bcfeccc3c  FT_RWAUGWEB-v2-c0-B.dat
 1701fbb1ac43031ceb4ffe3828b48c05  FT_RWAUGWEB-v3-c2-L.dat
 817db6a6dd2be1f1d6324131b56f7b73  FT_RWAUGWEB-v3-c3-B.dat
 a070b5986ff94a850b08e22abd569a91  FT_RWAUGWEB-v3-c3-L.dat
+fa10e134c76a6f75bc8417392d3a8620  FT_RWAUGWEB-v3-c4-B.dat
+103c283aa25f3195c0c69d339d12c36a  FT_RWAUGWEB-v3-c4-L.dat
+7db32f1da6cf5cbd833c89678f6a52a4  FT_RWAUGWEB-v3-c5-B.dat
+4c6ec6b38c609aa8b60307832f0a819e  FT_RWAUGWEB-v3-c5-L.dat
 d6b90b5d7a3c9a97a03d0e2c9f583f42  FT_RWAUGWEB-v4-c0-B.dat
 539b181b898acd59e463ff779a7c059e  FT_RWAUGWEB-v4-c0-L.dat
 8d7523adafeb5364c66eba36dca77c80  FT_RWAUGWEB-v4-c1-B.dat
@@ -334,6 +432,10 @@ f60be431bbee22799abe42c0990ff8b4  FT_RWAUGWEB-v4-c1-L.dat
 d899792cdebb3ec7017326ea9c07ce81  FT_RWAUGWEB-v4-c2-L.dat
 36aa859db50bee9cc021a7262389de81  FT_RWAUGWEB-v4-c3-B.dat
 60af440bdf464554e4fb1fd7459eb260  FT_RWAUGWEB-v4-c3-L.dat
+6edb14355cfd8dcd34ab77886a3c9089  FT_RWAUGWEB-v4-c4-B.dat
+672fb1c395160cb9193f96005068d959  FT_RWAUGWEB-v4-c4-L.dat
+19ce3b5615a6a4a6787cd25f591da275  FT_RWAUGWEB-v4-c5-B.dat
+13461a679566208bcbb1d53d10fdcfbe  FT_RWAUGWEB-v4-c5-L.dat
 1ff83fc66e0f959967fbe7fc94068071  FT_RWAUGWEB-v5-c0-B.dat
 f958d7a2d8f5522802a714934a0fc38e  FT_RWAUGWEB-v5-c0-L.dat
 be5e60a075f8371045a66157b34271f0  FT_RWAUGWEB-v5-c1-B.dat
@@ -342,6 +444,10 @@ a4609989704d4904e94ad83ed79b55d0  FT_RWAUGWEB-v5-c1-L.dat
 de709ae76c4326f845b4f9c908a93f93  FT_RWAUGWEB-v5-c2-L.dat
 41ec757064a1b24eed1d88428824ca94  FT_RWAUGWEB-v5-c3-B.dat
 a882f4687ef89f8dbc589e61cd35ac00  FT_RWAUGWEB-v5-c3-L.dat
+50bf41ba9d509422aabdbd654e4979a0  FT_RWAUGWEB-v5-c4-B.dat
+c2685108cc3abd9a758ba13a8e1f5b37  FT_RWAUGWEB-v5-c4-L.dat
+c641d5f913d3fc6efa3cc370b5933cd8  FT_RWAUGWEB-v5-c5-B.dat
+9edf346062fb1f64fd86afceaad032b7  FT_RWAUGWEB-v5-c5-L.dat
 6986dfb3ca505b391d5f9fa9be1cda30  FT_RWFILTER-v1-c0-B.dat
 cea530e72ae2b25052dbc5e96d9d0aa5  FT_RWFILTER-v1-c0-L.dat
 091cf3a98cf8c1ec3d30e1d3f4936b7a  FT_RWFILTER-v1-c1-B.dat
@@ -350,6 +456,10 @@ f714e7a5380e16cb1fd7cb81d7c1a20b  FT_RWFILTER-v1-c2-B.dat
 103f8d51add43fe1cf1f1e6e5ec0b765  FT_RWFILTER-v1-c2-L.dat
 746c67b5a512be05c5fdf1c6eca18bfe  FT_RWFILTER-v1-c3-B.dat
 f457f61d48f8bddced3203e9d9c64ae4  FT_RWFILTER-v1-c3-L.dat
+3fcb5f452df10cc2474c2dd0d50da0f1  FT_RWFILTER-v1-c4-B.dat
+f8ca2e48ecf18592db37d9ccc7cb713b  FT_RWFILTER-v1-c4-L.dat
+ffe1c9d1f656fe53b7c529ed64088ed0  FT_RWFILTER-v1-c5-B.dat
+a24ad93300e1a0b5970ff4e531c2c289  FT_RWFILTER-v1-c5-L.dat
 c1fc3a70265e72fbebe417ef8d675093  FT_RWFILTER-v2-c0-B.dat
 d64003c3c6d3abed3c0df4db0529fd7b  FT_RWFILTER-v2-c0-L.dat
 26c4e838cdeb201d791727e112fb96d8  FT_RWFILTER-v2-c1-B.dat
@@ -358,6 +468,10 @@ d64003c3c6d3abed3c0df4db0529fd7b  FT_RWFILTER-v2-c0-L.dat
 9838648a479719d6c891832cb8b8d42d  FT_RWFILTER-v2-c2-L.dat
 058ac1ebd00160d8b7dfafb8fa53cf30  FT_RWFILTER-v2-c3-B.dat
 bf6ea3f45df1cc0aab338812f1c59661  FT_RWFILTER-v2-c3-L.dat
+935c6146326d2bc533320b614eb66b0c  FT_RWFILTER-v2-c4-B.dat
+6b71083c18c17fbe37dce39003a9edc8  FT_RWFILTER-v2-c4-L.dat
+0687d2f2254b815c4f11f84879055cf7  FT_RWFILTER-v2-c5-B.dat
+79c78adaa3be9b9eb7b835bc7278a577  FT_RWFILTER-v2-c5-L.dat
 82e819749752c149e6517bcf4c8c2e61  FT_RWFILTER-v3-c0-B.dat
 0fd4b025dcb2d0adcdcc86b79eba6bb0  FT_RWFILTER-v3-c0-L.dat
 29c6934e0d4cd6df4a34cb1225080257  FT_RWFILTER-v3-c1-B.dat
@@ -366,6 +480,10 @@ cc3bc63da36bab23aeaaa58ee69d54d0  FT_RWFILTER-v3-c2-B.dat
 fab739247996547627ce22e31d4bac89  FT_RWFILTER-v3-c2-L.dat
 993bf373f1d4142872ac81dfe0e713c0  FT_RWFILTER-v3-c3-B.dat
 81973b698cfd39d615d51aec5b99ded1  FT_RWFILTER-v3-c3-L.dat
+cb2ef789e263f8b5b26ae61d94b6c4a1  FT_RWFILTER-v3-c4-B.dat
+139ec0b26361600b1678c86c425e2fb1  FT_RWFILTER-v3-c4-L.dat
+3d5caa27e7216d9556aa0571795610bb  FT_RWFILTER-v3-c5-B.dat
+02145deabcb26d7e278377d960a8e192  FT_RWFILTER-v3-c5-L.dat
 4d67c6ff508ee230c297195531fdf9a6  FT_RWFILTER-v4-c0-B.dat
 8e0dccab479e7f961961e5f41155c255  FT_RWFILTER-v4-c0-L.dat
 2aa64ffe5dc55c6808f1028961bf1fff  FT_RWFILTER-v4-c1-B.dat
@@ -374,6 +492,10 @@ e96b80f6ca5903cedea61d001bec5008  FT_RWFILTER-v4-c2-B.dat
 dc5d2ffe74ff1b7ec6843a63abc23536  FT_RWFILTER-v4-c2-L.dat
 1b5e29bc71c834a296ad106b6a83be5e  FT_RWFILTER-v4-c3-B.dat
 03d387c3612a061f3ab4c756e4a4c0e0  FT_RWFILTER-v4-c3-L.dat
+68b043d09410b61b965f8479a1278b9c  FT_RWFILTER-v4-c4-B.dat
+d37604b629b64e59658201ad2663ea02  FT_RWFILTER-v4-c4-L.dat
+6d42ed201e5308f0fa1c58f26091a123  FT_RWFILTER-v4-c5-B.dat
+472154b6dde2be96f39675d5474484e5  FT_RWFILTER-v4-c5-L.dat
 e5b1e8db7a40a8f0ddb1982168a8181f  FT_RWFILTER-v5-c0-B.dat
 8b6c7f61e15b9226e1ceaf899aed253e  FT_RWFILTER-v5-c0-L.dat
 1e17cf9578609c27e1b9ca574caa4d9a  FT_RWFILTER-v5-c1-B.dat
@@ -382,6 +504,10 @@ e5b1e8db7a40a8f0ddb1982168a8181f  FT_RWFILTER-v5-c0-B.dat
 5e00a4bde82f084cf12bd7f179a33d36  FT_RWFILTER-v5-c2-L.dat
 41a6470d76eb57ce10c6717631c9ff75  FT_RWFILTER-v5-c3-B.dat
 048cdc23f96b7313f741d847b3325a44  FT_RWFILTER-v5-c3-L.dat
+b3480d98b1fe8927cb2003b4ba93ca41  FT_RWFILTER-v5-c4-B.dat
+d22be69b4500c9696198110a9e569c6a  FT_RWFILTER-v5-c4-L.dat
+256e4e5ce159aa61456d87053475da59  FT_RWFILTER-v5-c5-B.dat
+399470a2a4087f0fb494881b41de4006  FT_RWFILTER-v5-c5-L.dat
 7dcaa52987c38d63b84a5b7c5ce33941  FT_RWGENERIC-v0-c0-B.dat
 fd656c86111fe47d0cbf13ed392bed67  FT_RWGENERIC-v0-c0-L.dat
 27893661440063991af0c88614fed945  FT_RWGENERIC-v0-c1-B.dat
@@ -390,6 +516,10 @@ f3122e81b9b23638187aa3376cc65ac5  FT_RWGENERIC-v0-c1-L.dat
 bc415d8b1b19e9390c165e8d35a1a6bf  FT_RWGENERIC-v0-c2-L.dat
 04bf5772661751dff7298bc5c8b4dcf9  FT_RWGENERIC-v0-c3-B.dat
 2628e85d1ed676e359fea7ac4a593252  FT_RWGENERIC-v0-c3-L.dat
+9e31acbdc02d61af1c7bf030953a70bc  FT_RWGENERIC-v0-c4-B.dat
+a0d01a3768f410b811aabc01801e3291  FT_RWGENERIC-v0-c4-L.dat
+e02052417efd455e224cd5696777ff68  FT_RWGENERIC-v0-c5-B.dat
+31050ace6c0fbe5868c62eca87577680  FT_RWGENERIC-v0-c5-L.dat
 513984dc560dde040158a1971320680c  FT_RWGENERIC-v1-c0-B.dat
 1640b04c5156437dcb9c3f7395fe98c1  FT_RWGENERIC-v1-c0-L.dat
 099d36f38bfebec3ec35952b327ce13c  FT_RWGENERIC-v1-c1-B.dat
@@ -398,6 +528,10 @@ e3d4609ba3e3729f4f0d7b7335f3ed44  FT_RWGENERIC-v1-c1-L.dat
 d51f3cb16cb0830019bfca4b1cd70247  FT_RWGENERIC-v1-c2-L.dat
 54869a671c6ecdc2d7cf9585d230c8a2  FT_RWGENERIC-v1-c3-B.dat
 b56688150cfcc6410c075fe0157022d6  FT_RWGENERIC-v1-c3-L.dat
+29dfa4b6751289bc47d9186992a12d5c  FT_RWGENERIC-v1-c4-B.dat
+eb46913971b931f80471e88d723e05bc  FT_RWGENERIC-v1-c4-L.dat
+236d573aad59fa08e55dbb875bff4a54  FT_RWGENERIC-v1-c5-B.dat
+cf70a0bac6750baf79ada136297a4f55  FT_RWGENERIC-v1-c5-L.dat
 947f1421d65b62e736c08d7a79f0ff42  FT_RWGENERIC-v2-c0-B.dat
 d05b78204f16fb235fc150b1be56d0b7  FT_RWGENERIC-v2-c0-L.dat
 a490c651a771b764ab218a6bb5e3a6e8  FT_RWGENERIC-v2-c1-B.dat
@@ -406,6 +540,10 @@ a490c651a771b764ab218a6bb5e3a6e8  FT_RWGENERIC-v2-c1-B.dat
 bf959c2fb40352f6234df8b9f3717e1f  FT_RWGENERIC-v2-c2-L.dat
 851780723e7a5f0279716f118e8ed7f3  FT_RWGENERIC-v2-c3-B.dat
 e66e5c63ef892c361269061fb9c41cf3  FT_RWGENERIC-v2-c3-L.dat
+3a7f3a28a8639d1c235ad391ea41aa9e  FT_RWGENERIC-v2-c4-B.dat
+d9a6b895ece5d2226e24e2811426165c  FT_RWGENERIC-v2-c4-L.dat
+87f3f4870b760ac40cb1dc1511c9ce73  FT_RWGENERIC-v2-c5-B.dat
+a9ad076605adef37b38a87fea4070a3a  FT_RWGENERIC-v2-c5-L.dat
 d6a93bcf2a9a6020bed0835ceb646ea2  FT_RWGENERIC-v3-c0-B.dat
 0f0add9723e5b1fc24330730297c1b34  FT_RWGENERIC-v3-c0-L.dat
 f57e0dd0e62b5c927f117101c88caeaa  FT_RWGENERIC-v3-c1-B.dat
@@ -414,6 +552,10 @@ f57e0dd0e62b5c927f117101c88caeaa  FT_RWGENERIC-v3-c1-B.dat
 aee6d908907c55f7c430bfb7aa5c1bcb  FT_RWGENERIC-v3-c2-L.dat
 aca3d2a9bba4c109e8ff371e371bea8d  FT_RWGENERIC-v3-c3-B.dat
 b1bf034389cb31bcc66c5ddca45b2d7e  FT_RWGENERIC-v3-c3-L.dat
+cc458c015ef48f284146bbaa302cd259  FT_RWGENERIC-v3-c4-B.dat
+48872637610e157b9551f3f63453cc69  FT_RWGENERIC-v3-c4-L.dat
+bb0b186e48962d4419e994de53264ebf  FT_RWGENERIC-v3-c5-B.dat
+bb2e336f52584a8472ef6eb33e4983bd  FT_RWGENERIC-v3-c5-L.dat
 71d4e55cd818777ee5438be65f7ccac5  FT_RWGENERIC-v4-c0-B.dat
 14f984703521151b77b2a63669abefe4  FT_RWGENERIC-v4-c0-L.dat
 d8b9226e8477614aebbb376a78dc5576  FT_RWGENERIC-v4-c1-B.dat
@@ -422,6 +564,10 @@ d8b9226e8477614aebbb376a78dc5576  FT_RWGENERIC-v4-c1-B.dat
 dd18b1eabe121da6f8ac7c323e504e04  FT_RWGENERIC-v4-c2-L.dat
 c961dd9662deb11f4887a7388ef7e66b  FT_RWGENERIC-v4-c3-B.dat
 b9e5250ddc6498937417c4d2d8d81add  FT_RWGENERIC-v4-c3-L.dat
+de027dd8d6126ecbbae9b81b12cf35a0  FT_RWGENERIC-v4-c4-B.dat
+4dff740c9d8e5179b1ad9551bf02cdfa  FT_RWGENERIC-v4-c4-L.dat
+aeddd99e4ec273a8eb6e7b2ad87de74a  FT_RWGENERIC-v4-c5-B.dat
+fe94e43fa9603f8b1d1e6a1a3b746362  FT_RWGENERIC-v4-c5-L.dat
 dd89f00bd51f03caf9de1e7812108005  FT_RWGENERIC-v5-c0-B.dat
 223ab374329314618fe9d8a1d2f300e8  FT_RWGENERIC-v5-c0-L.dat
 0884d019bfed192007a770275cfc52a7  FT_RWGENERIC-v5-c1-B.dat
@@ -430,6 +576,10 @@ dd89f00bd51f03caf9de1e7812108005  FT_RWGENERIC-v5-c0-B.dat
 aeb77d2fcb5bbd7d8d13c48de54d36ff  FT_RWGENERIC-v5-c2-L.dat
 52915d901799aca23f5798491c53e0f6  FT_RWGENERIC-v5-c3-B.dat
 19e2a823b0f729a71d462e78d2aa4d68  FT_RWGENERIC-v5-c3-L.dat
+b6ed86295ae7a47e07c7aa129e6266eb  FT_RWGENERIC-v5-c4-B.dat
+085d6d554a52191bbc2fe3c78206d845  FT_RWGENERIC-v5-c4-L.dat
+4eefa5ab2664adb4eb41f05b0f687d7a  FT_RWGENERIC-v5-c5-B.dat
+084c312a08751c82bc53eb6f486a2917  FT_RWGENERIC-v5-c5-L.dat
 2f9f457aa09dadb79ce6e6b9cac7aa05  FT_RWIPV6-v1-c0-B.dat
 9c18ef017e67ee89fa0daabc31daa233  FT_RWIPV6-v1-c0-L.dat
 699212297d2621249b08d909de8b80a3  FT_RWIPV6-v1-c1-B.dat
@@ -438,6 +588,10 @@ aeb77d2fcb5bbd7d8d13c48de54d36ff  FT_RWGENERIC-v5-c2-L.dat
 9584e20a7b9641afd78422afbd81a09b  FT_RWIPV6-v1-c2-L.dat
 34820ff7361b78cda507f060d7674e58  FT_RWIPV6-v1-c3-B.dat
 23638d77118b8cd4435fc3d75318b2f5  FT_RWIPV6-v1-c3-L.dat
+cac44054a3a247f3dad798c8cf9cfafa  FT_RWIPV6-v1-c4-B.dat
+eb3e45df7a845ebbdb99753eb2620f79  FT_RWIPV6-v1-c4-L.dat
+1b10641df6569612b026ee190fb7d5a2  FT_RWIPV6-v1-c5-B.dat
+45f161107103d85554c7a77cdf52e8bb  FT_RWIPV6-v1-c5-L.dat
 acc4780b215db74a91c541c98811e77f  FT_RWIPV6-v2-c0-B.dat
 1c69b295749a55894504e9d5d00042e5  FT_RWIPV6-v2-c0-L.dat
 6ff220d018769f8caa8aa3d96b9c92e5  FT_RWIPV6-v2-c1-B.dat
@@ -446,6 +600,10 @@ d3f5dcce303ef4395641299a4ea316cb  FT_RWIPV6-v2-c2-B.dat
 f147e9fa29126c13c715aba56df5d842  FT_RWIPV6-v2-c2-L.dat
 c9bcf6015ed77a86747f8e327152d936  FT_RWIPV6-v2-c3-B.dat
 f51b84442edfbe75a70afcd6fc204661  FT_RWIPV6-v2-c3-L.dat
+78703f3a538ff385426e4f6dc045acff  FT_RWIPV6-v2-c4-B.dat
+63013ac62b6a2fd47ef3b337efffbb42  FT_RWIPV6-v2-c4-L.dat
+1eb4d04225e5bf42ccc8f2cb63a57098  FT_RWIPV6-v2-c5-B.dat
+aef56c016186259210bdd782665b1524  FT_RWIPV6-v2-c5-L.dat
 c603a50b2fe0f71073449bb00ffdcd7b  FT_RWIPV6ROUTING-v1-c0-B.dat
 5ce7f5f312d053e719a09de2bdf4dd48  FT_RWIPV6ROUTING-v1-c0-L.dat
 01db8a0206495ffa9cb3853b6a263565  FT_RWIPV6ROUTING-v1-c1-B.dat
@@ -454,6 +612,10 @@ f2c65c5fabba2f150acb324ebdb26b51  FT_RWIPV6ROUTING-v1-c2-B.dat
 58f02ba420d0860f0f5dd860827e7d61  FT_RWIPV6ROUTING-v1-c2-L.dat
 41b963254853c12657905e5d14e87586  FT_RWIPV6ROUTING-v1-c3-B.dat
 a177c82eed9c423cea2f89296aeb2ec9  FT_RWIPV6ROUTING-v1-c3-L.dat
+2ca0219ff18c1d7d0d79a9d3a9c19ca5  FT_RWIPV6ROUTING-v1-c4-B.dat
+a871828d320dbcba4645eade60b1a64e  FT_RWIPV6ROUTING-v1-c4-L.dat
+005b981b70192e729a425ddd6d178314  FT_RWIPV6ROUTING-v1-c5-B.dat
+c651f067aa25518686d0752af55bc4a1  FT_RWIPV6ROUTING-v1-c5-L.dat
 0655e3c8de4049f43adf2f9eceff540b  FT_RWIPV6ROUTING-v2-c0-B.dat
 5ed32a580fcf09eefd1016f68b3eab3b  FT_RWIPV6ROUTING-v2-c0-L.dat
 59aefe73f0b406ac0c5b2dae4db48aec  FT_RWIPV6ROUTING-v2-c1-B.dat
@@ -462,6 +624,10 @@ ba749a6064c4b274960437ca1b1d11c8  FT_RWIPV6ROUTING-v2-c2-B.dat
 7d0990a104def93b4350ed12bab74e69  FT_RWIPV6ROUTING-v2-c2-L.dat
 110fe7b5b54a778bea340e51d8517d7a  FT_RWIPV6ROUTING-v2-c3-B.dat
 e15e835a64c7940743dd4c738cf84363  FT_RWIPV6ROUTING-v2-c3-L.dat
+2d61e5f1c37a38e04e1d8c30908e184b  FT_RWIPV6ROUTING-v2-c4-B.dat
+3a7a68cf3c181e678cf8ee307d60e240  FT_RWIPV6ROUTING-v2-c4-L.dat
+4e20c506fa3756b2e6708bb5410b1391  FT_RWIPV6ROUTING-v2-c5-B.dat
+e94d00d1f7409282a2ce30497026d66d  FT_RWIPV6ROUTING-v2-c5-L.dat
 df514250db00d79242f13463b7245c70  FT_RWIPV6ROUTING-v3-c0-B.dat
 041296f90b30ede7da5f81d7c3864074  FT_RWIPV6ROUTING-v3-c0-L.dat
 d68e6034f3621bfad96967aec9e753c9  FT_RWIPV6ROUTING-v3-c1-B.dat
@@ -470,6 +636,10 @@ f695cab19a9a761ffcf918db10d936d8  FT_RWIPV6ROUTING-v3-c1-L.dat
 aa9f2303e3c62bb5ac60e4bd404b41bf  FT_RWIPV6ROUTING-v3-c2-L.dat
 86c78131cd4bde9200c61421553abe73  FT_RWIPV6ROUTING-v3-c3-B.dat
 d39a9dd77f8cfe88f20a7182d62ea465  FT_RWIPV6ROUTING-v3-c3-L.dat
+b3702262f1dff686a578fdd1fbf5027d  FT_RWIPV6ROUTING-v3-c4-B.dat
+e031e5e85f206ce484d6ac083265daf5  FT_RWIPV6ROUTING-v3-c4-L.dat
+45e49527a285edc5dda9aff045438f3c  FT_RWIPV6ROUTING-v3-c5-B.dat
+54096a64d0b36643cbee22dee33cf7e6  FT_RWIPV6ROUTING-v3-c5-L.dat
 63ab6740566b8c6af7d43c2948ee8e82  FT_RWNOTROUTED-v1-c0-B.dat
 c0fe797de574e9d2fd85447032910ff6  FT_RWNOTROUTED-v1-c0-L.dat
 d305bcb80c26979cfa5aaaa19c74530c  FT_RWNOTROUTED-v1-c1-B.dat
@@ -478,6 +648,10 @@ ba6c890bd067b4459ddb411bc04f547e  FT_RWNOTROUTED-v1-c2-B.dat
 bf52e8553b91ac3f5eae64583c6dabb9  FT_RWNOTROUTED-v1-c2-L.dat
 804e4bfef6d18a74972aac43f1cc2175  FT_RWNOTROUTED-v1-c3-B.dat
 a1aaa711c8ad5c30020d1eb37a60f77f  FT_RWNOTROUTED-v1-c3-L.dat
+28e32ade2a713404670d42d168867779  FT_RWNOTROUTED-v1-c4-B.dat
+191d14606a3fd67c3d1ba2735efe1bf2  FT_RWNOTROUTED-v1-c4-L.dat
+5b413fb653d3393b55de1366f1cd83db  FT_RWNOTROUTED-v1-c5-B.dat
+ef1a583fdbbc0574c2be587d70366dfc  FT_RWNOTROUTED-v1-c5-L.dat
 c68a35d9f1f8536fda5b27b7a2e7fc9b  FT_RWNOTROUTED-v2-c0-B.dat
 2389313df8dab0ae4c0c732cedbb5ea1  FT_RWNOTROUTED-v2-c0-L.dat
 500b1718ee443086107097de48f9ca77  FT_RWNOTROUTED-v2-c1-B.dat
@@ -486,6 +660,10 @@ c68a35d9f1f8536fda5b27b7a2e7fc9b  FT_RWNOTROUTED-v2-c0-B.dat
 e321d9f627262e931838c6df4ed0209e  FT_RWNOTROUTED-v2-c2-L.dat
 2fcab32ffe1f358f471b033c4a923507  FT_RWNOTROUTED-v2-c3-B.dat
 8a34fcffb89ab2b05f76b8a6018084fb  FT_RWNOTROUTED-v2-c3-L.dat
+c9d6dfdf15e8ab29c62bbb6be9666c8f  FT_RWNOTROUTED-v2-c4-B.dat
+cf757a29868e46865c2a96cdb0213d02  FT_RWNOTROUTED-v2-c4-L.dat
+51ec368f0822192a0d6395cc05585590  FT_RWNOTROUTED-v2-c5-B.dat
+814dd8d4e1b8ba92f5d199cfbbb67d87  FT_RWNOTROUTED-v2-c5-L.dat
 8a5362f0ab8f6bcbd48463878c23c94d  FT_RWNOTROUTED-v3-c0-B.dat
 b572af9ccec4743025b7c28d66cf2d2d  FT_RWNOTROUTED-v3-c0-L.dat
 540025825039fae3208d91d3567881c2  FT_RWNOTROUTED-v3-c1-B.dat
@@ -494,6 +672,10 @@ b572af9ccec4743025b7c28d66cf2d2d  FT_RWNOTROUTED-v3-c0-L.dat
 044eec2be252b10c34adc4fe32d6cfa0  FT_RWNOTROUTED-v3-c2-L.dat
 3afc036af530ad061c3dbb1724bf45f5  FT_RWNOTROUTED-v3-c3-B.dat
 4f28efc9ed6a1c33318cbaf86f805273  FT_RWNOTROUTED-v3-c3-L.dat
+5351d12c313838752e5cab8ced8e82c7  FT_RWNOTROUTED-v3-c4-B.dat
+dfb97cd9052bdc42c15ad3014dcb7cc9  FT_RWNOTROUTED-v3-c4-L.dat
+f7df00cae567c68aa93938d2c3d871d2  FT_RWNOTROUTED-v3-c5-B.dat
+c1a00221e74f35e4d200696b6fe2e780  FT_RWNOTROUTED-v3-c5-L.dat
 72e1c54caaa54243661c0a0c1a9de78b  FT_RWNOTROUTED-v4-c0-B.dat
 96f05809a0f851cd5baf40ef450e514e  FT_RWNOTROUTED-v4-c0-L.dat
 da068228b2ba1390c5fa065529ed65d1  FT_RWNOTROUTED-v4-c1-B.dat
@@ -502,6 +684,10 @@ da068228b2ba1390c5fa065529ed65d1  FT_RWNOTROUTED-v4-c1-B.dat
 ad7338ea337bcfb54177950e83f34ece  FT_RWNOTROUTED-v4-c2-L.dat
 8837f213217d4a6e593004eb05a67f97  FT_RWNOTROUTED-v4-c3-B.dat
 7bf22de122856f329718fc99125615fe  FT_RWNOTROUTED-v4-c3-L.dat
+0c8fb8cfdc4a585b2cf17ab0424561ee  FT_RWNOTROUTED-v4-c4-B.dat
+34a528dd05904eb252e5d1ed8e2e7b03  FT_RWNOTROUTED-v4-c4-L.dat
+573d738c5c9528ad9f69d620d04f3397  FT_RWNOTROUTED-v4-c5-B.dat
+fb4dab2a70da195213f7ba3794c033ac  FT_RWNOTROUTED-v4-c5-L.dat
 db20862725dc8c2b7ae234eb74f2e6dd  FT_RWNOTROUTED-v5-c0-B.dat
 5a5fdb68fa587d361ad47ab3071a0150  FT_RWNOTROUTED-v5-c0-L.dat
 152f9f6672ef4556c5b611459b6cdbee  FT_RWNOTROUTED-v5-c1-B.dat
@@ -510,6 +696,10 @@ c1a0505018059c833fb3d1b41e0b7ce7  FT_RWNOTROUTED-v5-c2-B.dat
 f8bf559b9a06dc7dd3cbeeef8c45716d  FT_RWNOTROUTED-v5-c2-L.dat
 4174d5c48ca071991c60355da3340750  FT_RWNOTROUTED-v5-c3-B.dat
 e320776b2770cfb4a34cfa6644469cd1  FT_RWNOTROUTED-v5-c3-L.dat
+9a2f4a557b1aed3afe781d15123e992e  FT_RWNOTROUTED-v5-c4-B.dat
+81e1cc30c89792ee1ffc1325ff1c3f59  FT_RWNOTROUTED-v5-c4-L.dat
+7b92eacf2f8a03fbc84a428060e27f3f  FT_RWNOTROUTED-v5-c5-B.dat
+ca58c46858d4a7aea0ed589cad45ae05  FT_RWNOTROUTED-v5-c5-L.dat
 45e616c2ea42dfc32ea7f238e2e2cfe5  FT_RWROUTED-v1-c0-B.dat
 82c16c2a864c206de65bc5119767dff1  FT_RWROUTED-v1-c0-L.dat
 fa9d7a6c0e8267b967c128349d010392  FT_RWROUTED-v1-c1-B.dat
@@ -518,6 +708,10 @@ fa9d7a6c0e8267b967c128349d010392  FT_RWROUTED-v1-c1-B.dat
 3ce7398124bccbb727ee3ad436b4e25e  FT_RWROUTED-v1-c2-L.dat
 6fbb998631eb33e25e29ce441ea9b1fe  FT_RWROUTED-v1-c3-B.dat
 a1e9596481448fd42f1f1e053dadb55a  FT_RWROUTED-v1-c3-L.dat
+4f4205c65c3d7b72d0a7015f2f5d1b05  FT_RWROUTED-v1-c4-B.dat
+e33eee20ff9a7c339fa6b8e67d421e26  FT_RWROUTED-v1-c4-L.dat
+fc146d13c339d8e49c1cafadca287a37  FT_RWROUTED-v1-c5-B.dat
+02c1202b408e4cfd3df9a28f6cfac986  FT_RWROUTED-v1-c5-L.dat
 cb581ce9f132280ca46394fdaae64e63  FT_RWROUTED-v2-c0-B.dat
 5e56afa64d9351d69c2ae973d5f663ed  FT_RWROUTED-v2-c0-L.dat
 576e4ce47503cf80d7992db86b99d2dc  FT_RWROUTED-v2-c1-B.dat
@@ -526,6 +720,10 @@ deeddd3127643705a1fd0b50c1b8ca7b  FT_RWROUTED-v2-c2-B.dat
 cbbe239c3af9e33ed6212a55b527a45e  FT_RWROUTED-v2-c2-L.dat
 d6e95b66a68449c2bf42765c69cce513  FT_RWROUTED-v2-c3-B.dat
 1ced1b2871256a8a2bc3dc0ca3586bc2  FT_RWROUTED-v2-c3-L.dat
+7948ad1bd9b728942ef8479a236c3318  FT_RWROUTED-v2-c4-B.dat
+1769d7bd23742f2f7a2a9df13c108845  FT_RWROUTED-v2-c4-L.dat
+338f8c421b80ca32e554c66cb2f40e74  FT_RWROUTED-v2-c5-B.dat
+276f34d9ff096ccc6f12378d181877df  FT_RWROUTED-v2-c5-L.dat
 077f02f2ee0d4a6ec5ac3b50e231a4d2  FT_RWROUTED-v3-c0-B.dat
 f3a099444867927403f4fdd06a10a8ea  FT_RWROUTED-v3-c0-L.dat
 b99deaad26c4199c189ab21111d3c698  FT_RWROUTED-v3-c1-B.dat
@@ -534,6 +732,10 @@ f67ea6d04eff01384f2809999e9dda53  FT_RWROUTED-v3-c1-L.dat
 a5b89aa73ac64b9d988e8b7d0f96a301  FT_RWROUTED-v3-c2-L.dat
 8fe039cf744c49f9e274384610d96378  FT_RWROUTED-v3-c3-B.dat
 3bca18712738a656cf1a79b69f8d3957  FT_RWROUTED-v3-c3-L.dat
+b027a3e5db6633ef5356ca65836b5f4d  FT_RWROUTED-v3-c4-B.dat
+be6b3008fa956296f5312adc4a411f42  FT_RWROUTED-v3-c4-L.dat
+0b32107a71a670ffc54773e65f6a6939  FT_RWROUTED-v3-c5-B.dat
+3c662ae5d5a5c8024798946e0e3f0660  FT_RWROUTED-v3-c5-L.dat
 f17d7d2aa5427eaff43c4fac1574857f  FT_RWROUTED-v4-c0-B.dat
 5034cea9260da8a6dad733b5f7c78d5a  FT_RWROUTED-v4-c0-L.dat
 9e755deb6b1aad2aebed1cec1ab39ea1  FT_RWROUTED-v4-c1-B.dat
@@ -542,6 +744,10 @@ a89778891e1ba5f86b2cc095465284ed  FT_RWROUTED-v4-c2-B.dat
 8ed64ad91f5c7c98f8fa4e03ff8873e4  FT_RWROUTED-v4-c2-L.dat
 cfbaadc084411a4363d0864b42aab35d  FT_RWROUTED-v4-c3-B.dat
 93a5241b99ab85af3f0a4016ddf72c51  FT_RWROUTED-v4-c3-L.dat
+802dc938d55ba47ed16e20438952d9ab  FT_RWROUTED-v4-c4-B.dat
+c3d6033b2d9ade3e55b10db5a3ea658f  FT_RWROUTED-v4-c4-L.dat
+2357215b78cf55ffc637c81997d9f46c  FT_RWROUTED-v4-c5-B.dat
+bf408eef25edc2d3fbefef519410d954  FT_RWROUTED-v4-c5-L.dat
 e9e16d7a47a3ba266bc5df8584d1b88f  FT_RWROUTED-v5-c0-B.dat
 e5d2153a62b3691069e49dfb15ac71b7  FT_RWROUTED-v5-c0-L.dat
 53ca49143ecb4ebd9ec5513c6fe1e62e  FT_RWROUTED-v5-c1-B.dat
@@ -550,6 +756,10 @@ e5d2153a62b3691069e49dfb15ac71b7  FT_RWROUTED-v5-c0-L.dat
 f946ee0f1b13a987c555f0aab85bf411  FT_RWROUTED-v5-c2-L.dat
 f335fe9494e3313da07b93233c4a8904  FT_RWROUTED-v5-c3-B.dat
 aa6e59633699ba5c43965f77512761c4  FT_RWROUTED-v5-c3-L.dat
+31abc921d3aa1379393989e207b526f8  FT_RWROUTED-v5-c4-B.dat
+17f055f89a9d28c0c93983b6b7dce104  FT_RWROUTED-v5-c4-L.dat
+373e08e841097e4c95082e36b58d8887  FT_RWROUTED-v5-c5-B.dat
+9354041dd79178b8fcd82aceb6bce024  FT_RWROUTED-v5-c5-L.dat
 6be74a9eff6b196a51e97dfcc8e31d0a  FT_RWSPLIT-v1-c0-B.dat
 ead8c12cd4ceed70f9d1cdbde78b37de  FT_RWSPLIT-v1-c0-L.dat
 11a9157a43acfc36a5d6837cdf46899c  FT_RWSPLIT-v1-c1-B.dat
@@ -558,6 +768,10 @@ db25ad2e4c631bd22a4e55b829102ba0  FT_RWSPLIT-v1-c1-L.dat
 9f668bae733c50a8991ee3cec869cbed  FT_RWSPLIT-v1-c2-L.dat
 c3636cccae4a563430b2b9a9dbaac5a4  FT_RWSPLIT-v1-c3-B.dat
 f00fa0ffffc97473cb9a0f5975d48e21  FT_RWSPLIT-v1-c3-L.dat
+8c513c17fdb600d51237d673b12c8aec  FT_RWSPLIT-v1-c4-B.dat
+9ed77ed62d5810850368ca0eb40f2309  FT_RWSPLIT-v1-c4-L.dat
+d015e696f226fa6e154653a0b2f5612c  FT_RWSPLIT-v1-c5-B.dat
+e58407f314d53f582ec8f30089df33a6  FT_RWSPLIT-v1-c5-L.dat
 d2210f9a7d15e606b4a9bdadcb05e017  FT_RWSPLIT-v2-c0-B.dat
 3a796fa45a437dcb01eeb16cf0bcc6d4  FT_RWSPLIT-v2-c0-L.dat
 79bd8edb052c5644d92f402a13805f68  FT_RWSPLIT-v2-c1-B.dat
@@ -566,6 +780,10 @@ b933981892054094ab04faa9dceb1f34  FT_RWSPLIT-v2-c2-B.dat
 104c0dee9f0dfae12ed6ec08d4fd9519  FT_RWSPLIT-v2-c2-L.dat
 53528851aae4b1ad6584bc496f51b29a  FT_RWSPLIT-v2-c3-B.dat
 7377659ec4c05b1dde5e1c197e8595a0  FT_RWSPLIT-v2-c3-L.dat
+baa283c3f8981b8e65a4c41a59cb8366  FT_RWSPLIT-v2-c4-B.dat
+d4e4a8d839607a04cceb83e0966abc23  FT_RWSPLIT-v2-c4-L.dat
+c0f5c011b365bb8e0e9ad43401c6b5cb  FT_RWSPLIT-v2-c5-B.dat
+c6915b37a38bf318de0e133a0ab21a30  FT_RWSPLIT-v2-c5-L.dat
 d43215bde7090e7badc8c9fb4f133095  FT_RWSPLIT-v3-c0-B.dat
 366b18ddbd8d7d5ea7a3bcdea35cebdf  FT_RWSPLIT-v3-c0-L.dat
 4a09747c160f6e23c085e2c2bcf60151  FT_RWSPLIT-v3-c1-B.dat
@@ -574,6 +792,10 @@ a76c1ef9e575c1b84030a7158d57acb2  FT_RWSPLIT-v3-c1-L.dat
 99f031786758815819964b0d42388fc2  FT_RWSPLIT-v3-c2-L.dat
 84d8ab1418fff30ffdc1330a2bd1103f  FT_RWSPLIT-v3-c3-B.dat
 a1f71249450c07d93ddd7d2023d300f5  FT_RWSPLIT-v3-c3-L.dat
+abb65fba46539f73a4c444e83229e1cb  FT_RWSPLIT-v3-c4-B.dat
+5261ef15da3fc33c9947e243b64dea44  FT_RWSPLIT-v3-c4-L.dat
+eac6153af95fe1ca9e3e5c57b7b6993a  FT_RWSPLIT-v3-c5-B.dat
+93c1de5fe5e80b70c0ce4bece2a6fd71  FT_RWSPLIT-v3-c5-L.dat
 6ea55e3e335e04f9b1a4a845ad7b3223  FT_RWSPLIT-v4-c0-B.dat
 0fa608aacfea2014dc4556072853fdf0  FT_RWSPLIT-v4-c0-L.dat
 9c9528e2f6bff9acaf3b8347d9dd2c0c  FT_RWSPLIT-v4-c1-B.dat
@@ -582,6 +804,10 @@ be1126439a83f8b295fab6b355d92430  FT_RWSPLIT-v4-c2-B.dat
 b1d788cec04da73ac18c0df4fc858db5  FT_RWSPLIT-v4-c2-L.dat
 bf6e7460317944cda8b366e2470473a1  FT_RWSPLIT-v4-c3-B.dat
 82ed30caa69da391b7e14e13de634336  FT_RWSPLIT-v4-c3-L.dat
+845538761461012c5a8de38b13c43077  FT_RWSPLIT-v4-c4-B.dat
+d3e223ab663e03eedd3e5c1f7ea7b825  FT_RWSPLIT-v4-c4-L.dat
+e96fb5c2f616903c717e5d36b6701b36  FT_RWSPLIT-v4-c5-B.dat
+e0086e8fc4799adee89191762870f893  FT_RWSPLIT-v4-c5-L.dat
 a4405165075cb9286a941c90bb68019d  FT_RWSPLIT-v5-c0-B.dat
 cd3c855001d584165bc8ea62afa352c9  FT_RWSPLIT-v5-c0-L.dat
 298e49f809f86d6d265a725383a2aa9c  FT_RWSPLIT-v5-c1-B.dat
@@ -590,6 +816,10 @@ cd3c855001d584165bc8ea62afa352c9  FT_RWSPLIT-v5-c0-L.dat
 5a47281757ea51957f0b9c8d9514b9ca  FT_RWSPLIT-v5-c2-L.dat
 178130efb5e30c94449ce30c4ce5005b  FT_RWSPLIT-v5-c3-B.dat
 04318041701f5385ad2e52511a768522  FT_RWSPLIT-v5-c3-L.dat
+93ea6ab36c3901d466b33ed1dc716f97  FT_RWSPLIT-v5-c4-B.dat
+67e29122e9a457129723679eec6a52a9  FT_RWSPLIT-v5-c4-L.dat
+6b6c9e68db05aeaabdf1afd453c804e9  FT_RWSPLIT-v5-c5-B.dat
+edeffa6a70bec9d01155c5333a210323  FT_RWSPLIT-v5-c5-L.dat
 0e1b1e8228b57886008a97cb765c331b  FT_RWWWW-v1-c0-B.dat
 6c123a6c98d83c8cf317d0254c002cb6  FT_RWWWW-v1-c0-L.dat
 089f3ea77e04dab201087a299f5d3ae0  FT_RWWWW-v1-c1-B.dat
@@ -598,6 +828,10 @@ fa07a51f375a495e8ae5efa2ec5115fb  FT_RWWWW-v1-c2-B.dat
 be8c53ead9dbe25bbe4158c87844db72  FT_RWWWW-v1-c2-L.dat
 94d07a9a5f89f4c9d8a44ab4b20cc45d  FT_RWWWW-v1-c3-B.dat
 1ad58acc9fb4d750f14e2e5f2b5d47df  FT_RWWWW-v1-c3-L.dat
+0794a645db2aef2dd3422aa7cf0840aa  FT_RWWWW-v1-c4-B.dat
+9a868961c48679ddfa789758883c0ca6  FT_RWWWW-v1-c4-L.dat
+9cc15e7c252f001ab8ecd5d51d101784  FT_RWWWW-v1-c5-B.dat
+5039a47e5c9548b43e71b82001e1cbf8  FT_RWWWW-v1-c5-L.dat
 9f1f0176f53e5cc804b1bddfc2421b98  FT_RWWWW-v2-c0-B.dat
 4a9b9dbc6f98dc0d5df5b9f83b1b140f  FT_RWWWW-v2-c0-L.dat
 27a3e17dcc5525c9d200b4d61ae5f487  FT_RWWWW-v2-c1-B.dat
@@ -606,6 +840,10 @@ be8c53ead9dbe25bbe4158c87844db72  FT_RWWWW-v1-c2-L.dat
 3e060aeb0fd815f70ccdb9a36191c73b  FT_RWWWW-v2-c2-L.dat
 8a268afdc2e04c5f3ee60642cb1786b3  FT_RWWWW-v2-c3-B.dat
 0b9ff55c9d5f2c689677feb4118745d5  FT_RWWWW-v2-c3-L.dat
+666f753f356c05c0be31d326f55ce03b  FT_RWWWW-v2-c4-B.dat
+8098283e00684b6b7a72cdd62b16d75a  FT_RWWWW-v2-c4-L.dat
+4cb83339f09318af6f6036d9998c727f  FT_RWWWW-v2-c5-B.dat
+464c2b3d53a58248cc1e8498113dd31b  FT_RWWWW-v2-c5-L.dat
 a726e5fc2c493da0856695a85fd11298  FT_RWWWW-v3-c0-B.dat
 cfdd861442b0a4a49723d57595681bf7  FT_RWWWW-v3-c0-L.dat
 7a027dd8366cf4b8d681d5a06ca37d8c  FT_RWWWW-v3-c1-B.dat
@@ -614,6 +852,10 @@ b55cb6891fcea6f5249ba629f8631e9b  FT_RWWWW-v3-c2-B.dat
 abc4c8b10b22ba1277c1a04343e2a874  FT_RWWWW-v3-c2-L.dat
 a6b489645e4802df7bdca98b18761adf  FT_RWWWW-v3-c3-B.dat
 43fa802816383cd671671ecde04386d4  FT_RWWWW-v3-c3-L.dat
+662c62ff530e462d2a3ee0150f8fdef7  FT_RWWWW-v3-c4-B.dat
+558a8a4eed6cbc9ac82d5f0e0199f606  FT_RWWWW-v3-c4-L.dat
+bebdb448aab2f4307eff1cab673a7c62  FT_RWWWW-v3-c5-B.dat
+0f38bac1713d2460b61d8db3954d4dd4  FT_RWWWW-v3-c5-L.dat
 b67d537959ff93208eafb81469c5a09c  FT_RWWWW-v4-c0-B.dat
 4c348bb299e4dd82ed24223aa0ed9a14  FT_RWWWW-v4-c0-L.dat
 cd0c4dca54ac9922397da0bd398dfacd  FT_RWWWW-v4-c1-B.dat
@@ -622,6 +864,10 @@ b0ff24fded4b760dc6fcb008761749b0  FT_RWWWW-v4-c2-B.dat
 da6711570db3fcdfe2f9a9b82c6e51ff  FT_RWWWW-v4-c2-L.dat
 920a1d3a6c5888f4e45f09a834f837b2  FT_RWWWW-v4-c3-B.dat
 cc7e778a78f81c85e863573193cb2cec  FT_RWWWW-v4-c3-L.dat
+1766428fd1a77cf593cb05e72807bb8c  FT_RWWWW-v4-c4-B.dat
+fc3ff8c2c6cf48e09df21e8df2ef0a76  FT_RWWWW-v4-c4-L.dat
+5130303c55c2a3be07c150494e47c1e4  FT_RWWWW-v4-c5-B.dat
+482ececf8cca9c919a7fbc854cf9b65c  FT_RWWWW-v4-c5-L.dat
 123deb72a005b827d60a8e211a13f077  FT_RWWWW-v5-c0-B.dat
 eed0098880ea791ccf34c4e1311887b4  FT_RWWWW-v5-c0-L.dat
 32810191c8b2c8265b4bafc5a3d3181a  FT_RWWWW-v5-c1-B.dat
@@ -630,6 +876,10 @@ eed0098880ea791ccf34c4e1311887b4  FT_RWWWW-v5-c0-L.dat
 fed04907fc9b1b72e4c7c7955f491abe  FT_RWWWW-v5-c2-L.dat
 694b30c27dee268f7ac6837ecc3a2ad0  FT_RWWWW-v5-c3-B.dat
 b8468a4747f90849cd260a7b3d2740fa  FT_RWWWW-v5-c3-L.dat
+3357e0eac704745d026934f4ea096fcb  FT_RWWWW-v5-c4-B.dat
+82f3e8c67ec37bca22dae954b0e9c2b8  FT_RWWWW-v5-c4-L.dat
+648263f3922303dd6736cd9d6faef260  FT_RWWWW-v5-c5-B.dat
+bfb58503bcea73a485f7cc8a6223aecb  FT_RWWWW-v5-c5-L.dat
 
 # these are for LZ0 2.05
 a4e0ac1c437310d6c17be507c559afeb  FT_FLOWCAP-v2-c2-B.dat
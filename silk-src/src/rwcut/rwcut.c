@@ -34,6 +34,10 @@ RCSIDENT("$SiLK: rwcut.c 275df62a2e41 2017-01-05 17:30:40Z mthomas $");
  * parameter to pass to that function. */
 #define CUT_SKIP_COUNT 65536
 
+/* The number of records to read from a stream with a single call to
+ * skStreamReadRecords(). */
+#define CUT_READ_COUNT 256
+
 /* EXPORTED VARIABLES */
 
 /* The object to convert the record to text; includes pointer to the
@@ -83,15 +87,19 @@ static int
 tailFile(
     skstream_t         *stream)
 {
+    size_t count;
     int rv = SKSTREAM_OK;
 
-    while ((rv = skStreamReadRecord(stream, tail_buf_cur)) == SKSTREAM_OK) {
-        ++tail_buf_cur;
+    /* read directly into the buffer, up to its end */
+    do {
+        rv = skStreamReadRecords(stream, tail_buf_cur,
+                                 &tail_buf[tail_recs] - tail_buf_cur, &count);
+        tail_buf_cur += count;
         if (tail_buf_cur == &tail_buf[tail_recs]) {
             tail_buf_cur = tail_buf;
             tail_buf_full = 1;
         }
-    }
+    } while (SKSTREAM_OK == rv);
     if (SKSTREAM_ERR_EOF != rv) {
         skStreamPrintLastErr(stream, rv, &skAppPrintErr);
         return -1;
@@ -159,9 +167,11 @@ cutFile(
     skstream_t         *stream)
 {
     static int copy_input_only = 0;
-    rwRec rwrec;
+    rwRec recs[CUT_READ_COUNT];
     int rv = SKSTREAM_OK;
     size_t num_skipped;
+    size_t count;
+    size_t i;
     int ret_val = 0;
 
     /* handle case where all requested records have been printed, but
@@ -195,18 +205,28 @@ cutFile(
 
     if (0 == num_recs) {
         /* print all records */
-        while ((rv = skStreamReadRecord(stream, &rwrec)) == SKSTREAM_OK) {
-            rwAsciiPrintRec(ascii_str, &rwrec);
-        }
+        do {
+            rv = skStreamReadRecords(stream, recs, CUT_READ_COUNT, &count);
+            for (i = 0; i < count; ++i) {
+                rwAsciiPrintRec(ascii_str, &recs[i]);
+            }
+        } while (SKSTREAM_OK == rv);
         if (SKSTREAM_ERR_EOF != rv) {
             ret_val = -1;
         }
     } else {
-        while (num_recs
-               && ((rv = skStreamReadRecord(stream, &rwrec)) == SKSTREAM_OK))
-        {
-            rwAsciiPrintRec(ascii_str, &rwrec);
-            --num_recs;
+        while (num_recs) {
+            rv = skStreamReadRecords(stream, recs,
+                                     ((num_recs < CUT_READ_COUNT)
+                                      ? num_recs : CUT_READ_COUNT),
+                                     &count);
+            for (i = 0; i < count; ++i) {
+                rwAsciiPrintRec(ascii_str, &recs[i]);
+            }
+            num_recs -= count;
+            if (rv) {
+                break;
+            }
         }
         switch (rv) {
           case SKSTREAM_OK:
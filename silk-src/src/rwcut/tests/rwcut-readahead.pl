@@ -0,0 +1,61 @@
+#! /usr/bin/perl -w
+#
+#
+# RCSIDENT("$SiLK: rwcut-readahead.pl $")
+#
+#  Read a compressed file with SILK_IOBUF_READAHEAD set and verify
+#  that the records match those read without read-ahead, that rwcut
+#  can stop reading while decompressed blocks are still queued, and
+#  that a truncated file is reported as an error and not as the end
+#  of the file.
+
+use strict;
+use SiLKTests;
+
+my $NAME = $0;
+$NAME =~ s,.*/,,;
+
+my $rwcut = check_silk_app('rwcut');
+my $rwcat = check_silk_app('rwcat');
+my %file;
+$file{data} = get_data_or_exit77('data');
+skip_test('No zlib support') unless $SiLKTests::SK_ENABLE_ZLIB;
+my %temp;
+$temp{zlib} = make_tempname('zlib');
+$temp{short} = make_tempname('short');
+
+my $fields = ("--fields=1-15,20,21,26-29 --ipv6-policy=ignore"
+              ." --timestamp-format=epoch --ip-format=decimal --delimited");
+
+# write a compressed copy of the data, and a copy whose final block
+# is missing its last few bytes
+my $cmd = ("$rwcat --compression-method=zlib --output-path=$temp{zlib}"
+           ." $file{data}");
+check_exit_status($cmd)
+    or die "$NAME: Failed to create compressed file\n";
+
+system("cp", $temp{zlib}, $temp{short})
+    and die "$NAME: Cannot copy file to '$temp{short}'\n";
+open F, "+<", $temp{short}
+    or die "$NAME: Cannot open '$temp{short}' for update: $!'\n";
+binmode F;
+truncate F, ((-s F) - 3)
+    or die "$NAME: Cannot truncate '$temp{short}': $!\n";
+close F
+    or die "$NAME: Cannot close '$temp{short}': $!\n";
+
+$ENV{SILK_IOBUF_READAHEAD} = 4;
+push @SiLKTests::DUMP_ENVVARS, qw(SILK_IOBUF_READAHEAD);
+
+# all records, which must match rwcat-one-file.pl
+check_md5_output('ead5679c2b281268a7b8a717e5907429',
+                 "$rwcut $fields $temp{zlib}");
+
+# the first few records; rwcut closes the file while the read-ahead
+# thread has blocks queued
+check_md5_output('5c320472f3eae111d5cf737244bb9b5b',
+                 "$rwcut --num-recs=20 $fields $temp{zlib}");
+
+# the short block must be an error
+check_exit_status("$rwcut $fields $temp{short}")
+    and die "$NAME: No error when reading truncated file\n";
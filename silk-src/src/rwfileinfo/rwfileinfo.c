@@ -62,7 +62,8 @@ enum rwinfo_id {
     RWINFO_PREFIX_MAP,
     RWINFO_IPSET,
     RWINFO_BAG,
-    RWINFO_AGGBAG
+    RWINFO_AGGBAG,
+    RWINFO_BLOCK_INDEX
 };
 
 /*
@@ -192,6 +193,12 @@ static const sk_stringmap_entry_t rwinfo_entry[] = {
      NULL},
     {"18",  RWINFO_AGGBAG, NULL, NULL},
 
+    {"block-index",
+     RWINFO_BLOCK_INDEX,
+     ("For a flow file, the version of the index of its compressed blocks"),
+     NULL},
+    {"19",  RWINFO_BLOCK_INDEX, NULL, NULL},
+
     SK_STRINGMAP_SENTINEL
 };
 
@@ -809,6 +816,17 @@ printFileInfo(
         }
     }
 
+    if (skBitmapGetBit(print_fields, RWINFO_BLOCK_INDEX)) {
+        count = 0;
+        skHeaderIteratorBindType(&iter, hdr, SK_HENTRY_BLOCKINDEX_ID);
+        while ((he = skHeaderIteratorNext(&iter)) != NULL) {
+            printLabel(RWINFO_BLOCK_INDEX, 0);
+            skHeaderEntryPrint(he, stdout);
+            printf("\n");
+            ++count;
+        }
+    }
+
     if (skBitmapGetBit(print_fields, RWINFO_COMMAND_LINES)) {
         count = 0;
         skHeaderIteratorBindType(&iter, hdr, SK_HENTRY_INVOCATION_ID);
@@ -27,6 +27,14 @@ my @methods = (
      id => 3,
      avail => $SiLKTests::SK_ENABLE_SNAPPY,
      md5 => '1703dfaed2dba83e42085ca00d117af0'},
+    {option => 'zstd',
+     id => 4,
+     avail => $SiLKTests::SK_ENABLE_ZSTD,
+     md5 => '95bafe85b080794930c9d01c085d35f7'},
+    {option => 'lz4',
+     id => 5,
+     avail => $SiLKTests::SK_ENABLE_LZ4,
+     md5 => 'fd4c6f3d44151a331b2bcca5391775be'},
     );
 
 for my $m (@methods) {
@@ -533,7 +533,7 @@ fglobNext(
     char *ext;
 
     {
-        file_exists_fn = &skFileExists;
+        file_exists_fn = &sksiteRepoFileExists;
     }
 
     if (!fList->fg_initialized) {
@@ -678,6 +678,10 @@ fglobInit(
         return 1;
     }
 
+    /* check the cached listings against the repository once during
+     * this pass */
+    sksiteRepoFileCacheRevalidate();
+
     return 0;
 }
 
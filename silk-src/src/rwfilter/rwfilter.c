@@ -51,6 +51,10 @@ FILE *dryrun_fp = NULL;
  * has not been provided */
 FILE *filenames_fp = NULL;
 
+/* where to print output for --print-filter-plan; NULL when the
+ * switch has not been provided */
+FILE *filter_plan_fp = NULL;
+
 /* input file specified by --input-pipe */
 const char *input_pipe = NULL;
 
@@ -71,6 +75,12 @@ int print_volume_stats = 0;
 /* total number of threads */
 uint32_t thread_count = RWFILTER_THREADS_DEFAULT;
 
+/* whether the threads split each file into blocks of records */
+int thread_blocks = 0;
+
+/* whether to keep the order of the records when splitting files */
+int keep_order = 0;
+
 /* number of checks to preform */
 int checker_count = 0;
 
@@ -85,6 +95,10 @@ checktype_t (*checker[MAX_CHECKERS])(rwRec*);
 static int pargc;
 static char **pargv;
 
+/* the columns filterFile() uses to check a block of records when not
+ * running with multiple threads; allocated by the first call */
+static filter_block_t *check_columns = NULL;
+
 
 /* FUNCTION DEFINITIONS */
 
@@ -481,6 +495,69 @@ closeOneOutput(
 }
 
 
+/*
+ *  status = filterReadBlock(stream, block, &count);
+ *
+ *    Read up to FILTER_BLOCK_SIZE records from 'stream' into 'block'
+ *    and set 'count' to the number of records read.  Return the
+ *    status of the final read: SKSTREAM_OK when the block was filled,
+ *    otherwise SKSTREAM_ERR_EOF or the error that stopped the read.
+ */
+int
+filterReadBlock(
+    skstream_t         *stream,
+    rwRec              *block,
+    uint32_t           *count)
+{
+    size_t n;
+    int rv;
+
+    rv = skStreamReadRecords(stream, block, FILTER_BLOCK_SIZE, &n);
+    *count = (uint32_t)n;
+    return rv;
+}
+
+
+/*
+ *  filterRunCheckers(block, count, result, columns);
+ *
+ *    Run the checker()'s on the 'count' records in 'block' and set
+ *    'result[i]' to the checktype_t for the record 'block[i]'.  The
+ *    built-in partitioning switches, when present, are always the
+ *    first checker and are evaluated across the entire block using
+ *    'columns', which filterBlockCreate() allocated; the remaining
+ *    checkers are run on each record until one does not pass.
+ */
+void
+filterRunCheckers(
+    rwRec              *block,
+    uint32_t            count,
+    uint8_t            *result,
+    filter_block_t     *columns)
+{
+    uint32_t r;
+    int first = 0;
+    int i;
+
+    if (checker_count > 0
+        && checker[0] == (checktype_t (*)(rwRec*))filterCheck)
+    {
+        filterCheckBlock(block, count, result, columns);
+        first = 1;
+    } else {
+        memset(result, RWF_PASS, count);
+    }
+
+    if (first < checker_count) {
+        for (r = 0; r < count; ++r) {
+            for (i = first; i < checker_count && result[r] == RWF_PASS; ++i) {
+                result[r] = (*(checker[i]))(&block[r]);
+            }
+        }
+    }
+}
+
+
 /*
  *  ok = filterFile(datafile, ipfile_basename, stats);
  *
@@ -501,11 +578,13 @@ filterFile(
     const char         *ipfile_basename,
     filter_stats_t     *stats)
 {
-    rwRec rwrec;
+    static rwRec block[FILTER_BLOCK_SIZE];
+    static uint8_t result[FILTER_BLOCK_SIZE];
+    rwRec *rwrec;
+    uint32_t count;
+    uint32_t r;
     skstream_t *in_stream;
-    int i;
     int fail_entire_file = 0;
-    int result = RWF_PASS;
     int rv = SKSTREAM_OK;
     int in_rv = SKSTREAM_OK;
 
@@ -568,7 +647,6 @@ filterFile(
     if (filterCheckFile(in_stream, ipfile_basename) == 1) {
         /* all records in the file will fail the user's tests */
         fail_entire_file = 1;
-        result = RWF_FAIL;
 
         /* determine if we can more efficiently handle the file */
         if ((dest_type[DEST_ALL].count == 0)
@@ -591,75 +669,100 @@ filterFile(
             /* else computing volume stats, and we need to read each
              * record to get its byte and packet counts. */
         }
+    } else {
+        /* use the file's block index to skip blocks of records that
+         * will fail the user's tests */
+        filterSkipBlocks(in_stream, &stats->read.flows);
+    }
+
+    /* the columns used by the partitioning switches are allocated
+     * once and reused for every file */
+    if (NULL == check_columns) {
+        check_columns = filterBlockCreate();
+        if (NULL == check_columns) {
+            skAppPrintOutOfMemory("filter block");
+            reading_records = 0;
+            goto END;
+        }
     }
 
-    /* read and process each record */
-    while (reading_records
-           && (SKSTREAM_OK == (in_rv = skStreamReadRecord(in_stream, &rwrec))))
-    {
-        /* increment number of read records */
-        INCR_REC_COUNT(stats->read, &rwrec);
-
-        /* the all-dest */
-        if (dest_type[DEST_ALL].count) {
-            PRINT_REC_TO_DEST_ID(&rwrec, DEST_ALL);
-#if 0 /* dest_type[DEST_ALL].max_records is never set */
-            /* close all streams for this destination type if we are
-             * at user's requested max.  If max_records is 0, this
-             * will never be true, and all records will be
-             * processed. */
-            if (stats->read.flows == dest_type[DEST_ALL].max_records) {
-                reading_records = closeOutputDests(DEST_ALL, 0);
-            }
-#endif  /* 0 */
+    /* read and process the records a block at a time */
+    while (reading_records) {
+        in_rv = filterReadBlock(in_stream, block, &count);
+        if (0 == count) {
+            break;
         }
 
-        if (!fail_entire_file) {
-            /* run all checker()'s until end or one doesn't pass */
-            for (i=0, result=RWF_PASS;
-                 i < checker_count && result == RWF_PASS;
-                 ++i)
-            {
-                result = (*(checker[i]))(&rwrec);
-            }
+        /* run all checker()'s on the block */
+        if (fail_entire_file) {
+            memset(result, RWF_FAIL, count);
+        } else {
+            filterRunCheckers(block, count, result, check_columns);
         }
 
-        switch (result) {
-          case RWF_PASS:
-          case RWF_PASS_NOW:
-            /* increment number of record that pass */
-            INCR_REC_COUNT(stats->pass, &rwrec);
-
-            /* the pass-dest */
-            if (dest_type[DEST_PASS].count) {
-                PRINT_REC_TO_DEST_ID(&rwrec, DEST_PASS);
-                if (stats->pass.flows == dest_type[DEST_PASS].max_records) {
-                    /* close all streams for this destination type
-                     * since we are at user's specified max. */
-                    reading_records = closeOutputDests(DEST_PASS, 0);
+        for (r = 0, rwrec = block;
+             reading_records && r < count;
+             ++r, ++rwrec)
+        {
+            /* increment number of read records */
+            INCR_REC_COUNT(stats->read, rwrec);
+
+            /* the all-dest */
+            if (dest_type[DEST_ALL].count) {
+                PRINT_REC_TO_DEST_ID(rwrec, DEST_ALL);
+#if 0 /* dest_type[DEST_ALL].max_records is never set */
+                /* close all streams for this destination type if we are
+                 * at user's requested max.  If max_records is 0, this
+                 * will never be true, and all records will be
+                 * processed. */
+                if (stats->read.flows == dest_type[DEST_ALL].max_records) {
+                    reading_records = closeOutputDests(DEST_ALL, 0);
                 }
+#endif  /* 0 */
             }
-            break;
 
-          case RWF_FAIL:
-            /* the fail-dest */
-            if (dest_type[DEST_FAIL].count) {
-                PRINT_REC_TO_DEST_ID(&rwrec, DEST_FAIL);
-                if ((stats->read.flows - stats->pass.flows)
-                    == dest_type[DEST_FAIL].max_records)
-                {
-                    /* close all streams for this destination type
-                     * since we are at user's specified max. */
-                    reading_records = closeOutputDests(DEST_FAIL, 0);
+            switch (result[r]) {
+              case RWF_PASS:
+              case RWF_PASS_NOW:
+                /* increment number of record that pass */
+                INCR_REC_COUNT(stats->pass, rwrec);
+
+                /* the pass-dest */
+                if (dest_type[DEST_PASS].count) {
+                    PRINT_REC_TO_DEST_ID(rwrec, DEST_PASS);
+                    if (stats->pass.flows
+                        == dest_type[DEST_PASS].max_records)
+                    {
+                        /* close all streams for this destination type
+                         * since we are at user's specified max. */
+                        reading_records = closeOutputDests(DEST_PASS, 0);
+                    }
+                }
+                break;
+
+              case RWF_FAIL:
+                /* the fail-dest */
+                if (dest_type[DEST_FAIL].count) {
+                    PRINT_REC_TO_DEST_ID(rwrec, DEST_FAIL);
+                    if ((stats->read.flows - stats->pass.flows)
+                        == dest_type[DEST_FAIL].max_records)
+                    {
+                        /* close all streams for this destination type
+                         * since we are at user's specified max. */
+                        reading_records = closeOutputDests(DEST_FAIL, 0);
+                    }
                 }
+                break;
+
+              default:
+                break;
             }
-            break;
+        } /* for (r < count) */
 
-          default:
+        if (in_rv) {
             break;
         }
-
-    } /* while (reading_records && skStreamReadRecord()) */
+    } /* while (reading_records) */
 
   END:
     if (in_rv == SKSTREAM_OK || in_rv == SKSTREAM_ERR_EOF) {
@@ -818,6 +921,15 @@ int main(int argc, char **argv)
         printStats(print_stat, &stats);
     }
 
+    /* add the counts from the columns to the filter plan */
+    filterBlockDestroy(check_columns);
+    check_columns = NULL;
+
+    /* Print the filter plan and the pass rate of each step */
+    if (filter_plan_fp) {
+        filterPrintPlan(filter_plan_fp);
+    }
+
     time(&end_timer);
     logStats(&stats, &start_timer, &end_timer);
 
@@ -40,6 +40,9 @@ RCSIDENTVAR(rcsID_RWFILTER_H, "$SiLK: rwfilter.h 275df62a2e41 2017-01-05 17:30:4
 /* where to send file names when --print-filenames is active */
 #define PRINT_FILENAMES_FH stderr
 
+/* where to send the plan when --print-filter-plan is active */
+#define PRINT_FILTER_PLAN_FH stderr
+
 /* whether rwfilter supports threads */
 #define SK_RWFILTER_THREADED 1
 
@@ -50,6 +53,9 @@ RCSIDENTVAR(rcsID_RWFILTER_H, "$SiLK: rwfilter.h 275df62a2e41 2017-01-05 17:30:4
 #define RWFILTER_THREADS_DEFAULT 1
 
 
+/* number of records that are read and checked as a group */
+#define FILTER_BLOCK_SIZE 1024
+
 /* maximum number of dynamic libraries that we support */
 #define APP_MAX_DYNLIBS 8
 
@@ -85,6 +91,10 @@ typedef struct rec_count_st {
     uint64_t  bytes;
 } rec_count_t;
 
+/* the fields of a block of records that filterCheckBlock() tests,
+ * stored as columns; defined in rwfiltercheck.c */
+typedef struct filter_block_st filter_block_t;
+
 /* holds filter-statistics data */
 typedef struct filter_stats_st {
     rec_count_t     read;           /* count of records read */
@@ -139,6 +149,10 @@ extern FILE *dryrun_fp;
  * has not been provided */
 extern FILE *filenames_fp;
 
+/* where to print output for --print-filter-plan; NULL when the
+ * switch has not been provided */
+extern FILE *filter_plan_fp;
+
 /* input file specified by --input-pipe; NULL when the switch has not
  * been provided */
 extern const char *input_pipe;
@@ -161,6 +175,12 @@ extern int print_volume_stats;
 /* number of total threads */
 extern uint32_t thread_count;
 
+/* whether the threads split each file into blocks of records */
+extern int thread_blocks;
+
+/* whether to keep the order of the records when splitting files */
+extern int keep_order;
+
 /* number of checks to preform */
 extern int checker_count;
 
@@ -233,6 +253,17 @@ char *
 appNextInput(
     char               *buf,
     size_t              bufsize);
+int
+filterReadBlock(
+    skstream_t         *stream,
+    rwRec              *block,
+    uint32_t           *count);
+void
+filterRunCheckers(
+    rwRec              *block,
+    uint32_t            count,
+    uint8_t            *result,
+    filter_block_t     *columns);
 
 
 /* filtering  functions (rwfiltercheck.c) */
@@ -241,9 +272,31 @@ int
 filterCheckFile(
     skstream_t         *path,
     const char         *ip_dir);
+void
+filterSkipBlocks(
+    skstream_t         *stream,
+    uint64_t           *skipped_flows);
 checktype_t
 filterCheck(
     const rwRec        *rwrec);
+filter_block_t *
+filterBlockCreate(
+    void);
+void
+filterBlockDestroy(
+    filter_block_t     *blk);
+void
+filterCheckBlock(
+    const rwRec        *recs,
+    uint32_t            count,
+    uint8_t            *result,
+    filter_block_t     *blk);
+int
+filterCompilePlan(
+    void);
+void
+filterPrintPlan(
+    FILE               *fh);
 void
 filterUsage(
     FILE*);
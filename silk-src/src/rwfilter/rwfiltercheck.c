@@ -25,6 +25,15 @@ RCSIDENT("$SiLK: rwfiltercheck.c 275df62a2e41 2017-01-05 17:30:40Z mthomas $");
 #include <silk/skipset.h>
 #include <silk/skcountry.h>
 
+/* The plan's sampling flag is read without the plan's mutex when C11
+ * atomics are available */
+#if defined(SK_HAVE_STDATOMIC_H) && !defined(__STDC_NO_ATOMICS__)
+#include <stdatomic.h>
+#define PLAN_ATOMIC_SAMPLING 1
+#else
+#define PLAN_ATOMIC_SAMPLING 0
+#endif
+
 
 /* TYPEDEFS AND DEFINES */
 
@@ -174,6 +183,107 @@ typedef struct filter_checks_st {
 
 } filter_checks_t;
 
+/*
+ *    Number of records that are run through every step of the filter
+ *    plan to measure the pass rate of each step before the plan is
+ *    re-ordered.
+ */
+#define FILTER_PLAN_SAMPLE_SIZE  8192
+
+/*
+ *    Bits that name the columns of a filter_block_t.
+ */
+#define FILTER_COL_STIME     (1u <<  0)
+#define FILTER_COL_ETIME     (1u <<  1)
+#define FILTER_COL_ELAPSED   (1u <<  2)
+#define FILTER_COL_BYTES     (1u <<  3)
+#define FILTER_COL_PKTS      (1u <<  4)
+#define FILTER_COL_SPORT     (1u <<  5)
+#define FILTER_COL_DPORT     (1u <<  6)
+#define FILTER_COL_PROTO     (1u <<  7)
+#define FILTER_COL_FLAGS     (1u <<  8)
+#define FILTER_COL_INPUT     (1u <<  9)
+#define FILTER_COL_OUTPUT    (1u << 10)
+#define FILTER_COL_SIPV4     (1u << 11)
+#define FILTER_COL_DIPV4     (1u << 12)
+
+/*
+ *    A structure-of-arrays view of the fields of a block of records
+ *    that are tested by the block predicates.  filterCheckBlock()
+ *    fills only the columns that the plan uses.
+ */
+struct filter_block_st {
+    uint64_t        stime[FILTER_BLOCK_SIZE];
+    uint64_t        etime[FILTER_BLOCK_SIZE];
+    uint32_t        elapsed[FILTER_BLOCK_SIZE];
+    uint32_t        bytes[FILTER_BLOCK_SIZE];
+    uint32_t        pkts[FILTER_BLOCK_SIZE];
+    uint32_t        sipv4[FILTER_BLOCK_SIZE];
+    uint32_t        dipv4[FILTER_BLOCK_SIZE];
+    uint16_t        sport[FILTER_BLOCK_SIZE];
+    uint16_t        dport[FILTER_BLOCK_SIZE];
+    uint16_t        input[FILTER_BLOCK_SIZE];
+    uint16_t        output[FILTER_BLOCK_SIZE];
+    uint8_t         proto[FILTER_BLOCK_SIZE];
+    uint8_t         flags[FILTER_BLOCK_SIZE];
+    /* whether any record in the block is IPv6, in which case the
+     * sipv4 and dipv4 columns are not filled */
+    int             has_ipv6;
+    /* for --print-filter-plan: the number of records the thread ran
+     * each step of the plan on and the number of those that passed;
+     * added to the plan by filterBlockDestroy() */
+    uint64_t        evaluated[FILTER_CHECK_MAX];
+    uint64_t        passed[FILTER_CHECK_MAX];
+};
+
+/* A single step of the compiled filter plan */
+typedef struct filter_plan_step_st {
+    /* the predicate; returns non-zero when the record passes */
+    int           (*pred)(const rwRec *rwrec);
+    /* the block predicate; clears the selection mask of the records
+     * in a filter_block_t that fail.  NULL when the check has no
+     * block version */
+    void          (*block_pred)(const filter_block_t *blk, uint32_t count,
+                                uint8_t *sel);
+    /* the FILTER_COL_* columns that 'block_pred' reads */
+    uint32_t        columns;
+    /* estimated relative cost of running 'pred' */
+    double          cost;
+    /* cost / (1 - pass_rate), used to order the steps */
+    double          rank;
+    /* number of sampled records that passed this step */
+    uint64_t        sample_passed;
+    /* for --print-filter-plan: the number of records this step was
+     * run on and the number of those that passed */
+    uint64_t        evaluated;
+    uint64_t        passed;
+    /* the key in checkSet[] that this step implements */
+    uint8_t         check_key;
+} filter_plan_step_t;
+
+/* The compiled filter plan */
+typedef struct filter_plan_st {
+    filter_plan_step_t  step[FILTER_CHECK_MAX];
+    pthread_mutex_t     mutex;
+    /* number of records sampled so far */
+    uint64_t            sample_count;
+    /* number of steps in the plan */
+    unsigned int        count;
+    /* the union of the columns the steps of the plan read */
+    uint32_t            columns;
+    /* whether the plan is being sampled.  It is cleared once, while
+     * holding 'mutex', after the steps have been re-ordered */
+#if PLAN_ATOMIC_SAMPLING
+    atomic_int          sampling;
+#else
+    int                 sampling;
+#endif
+    /* whether to count the records each step evaluates */
+    unsigned            counting :1;
+    /* whether the plan's mutex must be used */
+    unsigned            lock     :1;
+} filter_plan_t;
+
 
 
 /* LOCAL VARIABLES */
@@ -181,6 +291,9 @@ typedef struct filter_checks_st {
 static filter_checks_t static_checks;
 static filter_checks_t * const checks = &static_checks;
 
+static filter_plan_t static_plan;
+static filter_plan_t * const plan = &static_plan;
+
 
 /* OPTION SETUP */
 
@@ -1016,351 +1129,1161 @@ compatOptionsHandler(
 
 
 /*
- *  pass = filterCheck(&rwrec)
+ *    The individual predicates that make up a compiled filter plan.
  *
- *    Check the rw record 'rwrec' against all of the checks the user
- *    specified.  If the record fails any check, RWF_PASS is returned.
- *    If the record passes all of the checks, RWF_FAIL is returned.
+ *    Each predicate tests a single partitioning switch against the
+ *    record 'rwrec' and returns non-zero when the record passes that
+ *    switch.  filterCompilePlan() chooses the predicate for each
+ *    check the user specified, picking a specialized version where
+ *    one exists (e.g., a CIDR list with a single block, or a negated
+ *    IPset), so no per-record decisions remain other than the tests
+ *    themselves.
  */
-checktype_t
-filterCheck(
+
+static int
+predSTime(
     const rwRec        *rwrec)
 {
-    unsigned int i;
-    int j;
-    int wanted;
-    skipaddr_t ip1;
-    skipaddr_t ip2;
-    skcidr_t *cidr;
+    return CHECK_RANGE((uint64_t)rwRecGetStartTime(rwrec), checks->sTime);
+}
 
-/* If (test) is zero, the record fails the filter and a non-zero value
- * is returned.  Else we continue with additional checks. */
-#define FILTER_CHECK(test) \
-    if (test) {/*pass*/} else return RWF_FAIL
+static int
+predETime(
+    const rwRec        *rwrec)
+{
+    return CHECK_RANGE((uint64_t)rwRecGetEndTime(rwrec), checks->eTime);
+}
 
+static int
+predActiveTime(
+    const rwRec        *rwrec)
+{
+    /* to pass the record; check that flow's start time is less than
+     * the max value of range and that flow's end time is greater
+     * than the min value of the range. */
+    return (((uint64_t)rwRecGetStartTime(rwrec) <= checks->active_time.max)
+            && ((uint64_t)rwRecGetEndTime(rwrec) >= checks->active_time.min));
+}
 
-    for (j = 0; j < checks->check_count; j++) {
-        switch (checks->checkSet[j]) {
+static int
+predDuration(
+    const rwRec        *rwrec)
+{
+    return CHECK_RANGE(rwRecGetElapsed(rwrec), checks->elapsed);
+}
 
-          case OPT_STIME:
-            FILTER_CHECK(CHECK_RANGE((uint64_t)rwRecGetStartTime(rwrec),
-                                     checks->sTime));
-            break;
+static int
+predSPort(
+    const rwRec        *rwrec)
+{
+    return skBitmapGetBit(checks->sPort, rwRecGetSPort(rwrec));
+}
 
-          case OPT_ETIME:
-            FILTER_CHECK(CHECK_RANGE((uint64_t)rwRecGetEndTime(rwrec),
-                                     checks->eTime));
-            break;
+static int
+predDPort(
+    const rwRec        *rwrec)
+{
+    return skBitmapGetBit(checks->dPort, rwRecGetDPort(rwrec));
+}
 
-          case OPT_ACTIVE_TIME:
-            /* to pass the record; check that flow's start time is
-             * less than the max value of range and that flow's end
-             * time is greater than the min value of the range. */
-            FILTER_CHECK((uint64_t)rwRecGetStartTime(rwrec)
-                         <= checks->active_time.max);
-            FILTER_CHECK((uint64_t)rwRecGetEndTime(rwrec)
-                         >= checks->active_time.min);
-            break;
+static int
+predAnyPort(
+    const rwRec        *rwrec)
+{
+    return (skBitmapGetBit(checks->any_port, rwRecGetSPort(rwrec))
+            || skBitmapGetBit(checks->any_port, rwRecGetDPort(rwrec)));
+}
 
-          case OPT_DURATION:
-            FILTER_CHECK(CHECK_RANGE(rwRecGetElapsed(rwrec),
-                                     checks->elapsed));
-            break;
+static int
+predProtocol(
+    const rwRec        *rwrec)
+{
+    return skBitmapGetBit(checks->proto, rwRecGetProto(rwrec));
+}
 
-          case OPT_SPORT:
-            FILTER_CHECK(skBitmapGetBit(checks->sPort, rwRecGetSPort(rwrec)));
-            break;
+static int
+predIcmpType(
+    const rwRec        *rwrec)
+{
+    return (rwRecIsICMP(rwrec)
+            && skBitmapGetBit(checks->icmp_type, rwRecGetIcmpType(rwrec)));
+}
 
-          case OPT_DPORT:
-            FILTER_CHECK(skBitmapGetBit(checks->dPort, rwRecGetDPort(rwrec)));
-            break;
+static int
+predIcmpCode(
+    const rwRec        *rwrec)
+{
+    return (rwRecIsICMP(rwrec)
+            && skBitmapGetBit(checks->icmp_code, rwRecGetIcmpCode(rwrec)));
+}
 
-          case OPT_APORT:
-            FILTER_CHECK(skBitmapGetBit(checks->any_port, rwRecGetSPort(rwrec))
-                         || skBitmapGetBit(checks->any_port,
-                                           rwRecGetDPort(rwrec)));
-            break;
+static int
+predBytes(
+    const rwRec        *rwrec)
+{
+    return CHECK_RANGE(rwRecGetBytes(rwrec), checks->bytes);
+}
 
-          case OPT_PROTOCOL:
-            FILTER_CHECK(skBitmapGetBit(checks->proto, rwRecGetProto(rwrec)));
-            break;
+static int
+predPackets(
+    const rwRec        *rwrec)
+{
+    return CHECK_RANGE(rwRecGetPkts(rwrec), checks->pkts);
+}
 
-          case OPT_ICMP_TYPE:
-            FILTER_CHECK(rwRecIsICMP(rwrec)
-                         && skBitmapGetBit(checks->icmp_type,
-                                           rwRecGetIcmpType(rwrec)));
-            break;
+static int
+predBytesPerPacket(
+    const rwRec        *rwrec)
+{
+    return CHECK_RANGE(((double)rwRecGetBytes(rwrec)
+                        / (double)rwRecGetPkts(rwrec)),
+                       checks->bytes_per_packet);
+}
 
-          case OPT_ICMP_CODE:
-            FILTER_CHECK(rwRecIsICMP(rwrec)
-                         && skBitmapGetBit(checks->icmp_code,
-                                           rwRecGetIcmpCode(rwrec)));
-            break;
+#if RATE_FILTERS
+static int
+predBytesPerSecond(
+    const rwRec        *rwrec)
+{
+    if (rwRecGetElapsed(rwrec) > 0) {
+        return CHECK_RANGE(((double)rwRecGetBytes(rwrec)
+                            / (double)rwRecGetElapsed(rwrec)),
+                           checks->bytes_per_second);
+    }
+    /* use a one second duration */
+    return CHECK_RANGE((double)rwRecGetBytes(rwrec),
+                       checks->bytes_per_second);
+}
 
-          case OPT_BYTES:
-            FILTER_CHECK(CHECK_RANGE(rwRecGetBytes(rwrec), checks->bytes));
-            break;
+static int
+predPacketsPerSecond(
+    const rwRec        *rwrec)
+{
+    if (rwRecGetElapsed(rwrec) > 0) {
+        return CHECK_RANGE(((double)rwRecGetPkts(rwrec)
+                            / (double)rwRecGetElapsed(rwrec)),
+                           checks->packets_per_second);
+    }
+    /* use a one second duration */
+    return CHECK_RANGE((double)rwRecGetPkts(rwrec),
+                       checks->packets_per_second);
+}
+#endif  /* RATE_FILTERS */
 
-          case OPT_PACKETS:
-            FILTER_CHECK(CHECK_RANGE(rwRecGetPkts(rwrec), checks->pkts));
-            break;
+/*
+ *    Return 1 if 'ip' is contained in any CIDR block on the list at
+ *    position 'idx' of checks->cidr_list[]; 0 otherwise.
+ */
+static int
+cidrListContains(
+    enum ip_index       idx,
+    const skipaddr_t   *ip)
+{
+    const skcidr_t *cidr = checks->cidr_list[idx];
+    const skcidr_t *end_cidr = cidr + checks->cidr_list_len[idx];
 
-          case OPT_BYTES_PER_PACKET:
-            FILTER_CHECK(CHECK_RANGE(((double)rwRecGetBytes(rwrec)
-                                      / (double)rwRecGetPkts(rwrec)),
-                                     checks->bytes_per_packet));
-            break;
+    for ( ; cidr < end_cidr; ++cidr) {
+        if (skcidrCheckIP(cidr, ip)) {
+            return 1;
+        }
+    }
+    return 0;
+}
 
-#if RATE_FILTERS
-          case OPT_BYTES_PER_SECOND:
-            if (rwRecGetElapsed(rwrec) > 0) {
-                FILTER_CHECK(CHECK_RANGE(((double)rwRecGetBytes(rwrec)
-                                          / (double)rwRecGetElapsed(rwrec)),
-                                         checks->bytes_per_second));
-            } else {
-                /* use a one second duration */
-                FILTER_CHECK(CHECK_RANGE((double)rwRecGetBytes(rwrec),
-                                         checks->bytes_per_second));
-            }
-            break;
+static int
+predSCidr(
+    const rwRec        *rwrec)
+{
+    skipaddr_t ip;
 
-          case OPT_PACKETS_PER_SECOND:
-            if (rwRecGetElapsed(rwrec) > 0) {
-                FILTER_CHECK(CHECK_RANGE(((double)rwRecGetPkts(rwrec)
-                                          / (double)rwRecGetElapsed(rwrec)),
-                                         checks->packets_per_second));
-            } else {
-                /* use a one second duration */
-                FILTER_CHECK(CHECK_RANGE((double)rwRecGetPkts(rwrec),
-                                         checks->packets_per_second));
-            }
-            break;
-#endif  /* RATE_FILTERS */
+    rwRecMemGetSIP(rwrec, &ip);
+    return cidrListContains(SRC, &ip) ^ checks->cidr_negated[SRC];
+}
 
-          case OPT_NOT_SCIDR:
-          case OPT_SCIDR:
-            rwRecMemGetSIP(rwrec, &ip1);
-            wanted = checks->cidr_negated[SRC];
-            for (i = 0, cidr = checks->cidr_list[SRC];
-                 i < checks->cidr_list_len[SRC];
-                 ++i, ++cidr)
-            {
-                if (skcidrCheckIP(cidr, &ip1)) {
-                    wanted = !wanted;
-                    break;
-                }
-            }
-            FILTER_CHECK(wanted);
-            break;
+static int
+predSCidrSingle(
+    const rwRec        *rwrec)
+{
+    skipaddr_t ip;
 
-          case OPT_NOT_DCIDR:
-          case OPT_DCIDR:
-            rwRecMemGetDIP(rwrec, &ip1);
-            wanted = checks->cidr_negated[DST];
-            for (i = 0, cidr = checks->cidr_list[DST];
-                 i < checks->cidr_list_len[DST];
-                 ++i, ++cidr)
-            {
-                if (skcidrCheckIP(cidr, &ip1)) {
-                    wanted = !wanted;
-                    break;
-                }
-            }
-            FILTER_CHECK(wanted);
-            break;
+    rwRecMemGetSIP(rwrec, &ip);
+    return skcidrCheckIP(checks->cidr_list[SRC], &ip);
+}
 
-          case OPT_NOT_NHCIDR:
-          case OPT_NHCIDR:
-            rwRecMemGetNhIP(rwrec, &ip1);
-            wanted = checks->cidr_negated[NHIP];
-            for (i = 0, cidr = checks->cidr_list[NHIP];
-                 i < checks->cidr_list_len[NHIP];
-                 ++i, ++cidr)
-            {
-                if (skcidrCheckIP(cidr, &ip1)) {
-                    wanted = !wanted;
-                    break;
-                }
-            }
-            FILTER_CHECK(wanted);
-            break;
+static int
+predDCidr(
+    const rwRec        *rwrec)
+{
+    skipaddr_t ip;
 
-          case OPT_NOT_ANY_CIDR:
-          case OPT_ANY_CIDR:
-            rwRecMemGetSIP(rwrec, &ip1);
-            rwRecMemGetDIP(rwrec, &ip2);
-            wanted = checks->cidr_negated[ANY];
-            for (i = 0, cidr = checks->cidr_list[ANY];
-                 i < checks->cidr_list_len[ANY];
-                 ++i, ++cidr)
-            {
-                if (skcidrCheckIP(cidr, &ip1)
-                    || skcidrCheckIP(cidr, &ip2))
-                {
-                    wanted = !wanted;
-                    break;
-                }
-            }
-            FILTER_CHECK(wanted);
-            break;
+    rwRecMemGetDIP(rwrec, &ip);
+    return cidrListContains(DST, &ip) ^ checks->cidr_negated[DST];
+}
 
-          case OPT_NOT_SADDRESS:
-          case OPT_SADDRESS:
-            /* Check if record's sIP matches the bitmap.  The record
-             * FAILS the filter when the result of the check MATCHES
-             * the status of the negate flag.  E.g., the record
-             * matches the address-bitmap (skIPWildcardCheckIp()==1)
-             * and the user entered --not-saddr (ipwild_negate==1).
-             * Since the record FAILS when the values are equal, it
-             * will PASS when they are not-equal; i.e., when the
-             * XOR(^) of the two values is true.
-             */
-            rwRecMemGetSIP(rwrec, &ip1);
-            FILTER_CHECK(skIPWildcardCheckIp(&checks->ipwild[SRC], &ip1)
-                         ^ checks->ipwild_negate[SRC]);
-            break;
-
-          case OPT_NOT_DADDRESS:
-          case OPT_DADDRESS:
-            rwRecMemGetDIP(rwrec, &ip1);
-            FILTER_CHECK(skIPWildcardCheckIp(&checks->ipwild[DST], &ip1)
-                         ^ checks->ipwild_negate[DST]);
-            break;
+static int
+predDCidrSingle(
+    const rwRec        *rwrec)
+{
+    skipaddr_t ip;
 
-          case OPT_NOT_NEXT_HOP_ID:
-          case OPT_NEXT_HOP_ID:
-            rwRecMemGetNhIP(rwrec, &ip1);
-            FILTER_CHECK(skIPWildcardCheckIp(&checks->ipwild[NHIP], &ip1)
-                         ^ checks->ipwild_negate[NHIP]);
-            break;
+    rwRecMemGetDIP(rwrec, &ip);
+    return skcidrCheckIP(checks->cidr_list[DST], &ip);
+}
 
-          case OPT_NOT_ANY_ADDRESS:
-          case OPT_ANY_ADDRESS:
-            rwRecMemGetSIP(rwrec, &ip1);
-            rwRecMemGetDIP(rwrec, &ip2);
-            FILTER_CHECK((skIPWildcardCheckIp(&checks->ipwild[ANY], &ip1)
-                          | skIPWildcardCheckIp(&checks->ipwild[ANY], &ip2))
-                         ^ checks->ipwild_negate[ANY]);
-            break;
+static int
+predNhCidr(
+    const rwRec        *rwrec)
+{
+    skipaddr_t ip;
 
-          case OPT_NOT_SET_SIP:
-          case OPT_SET_SIP:
-            /* As with OPT_SADDRESS, for the record to pass the
-             * filter, the result of the check must not equal the
-             * result of the negate flag. */
-            FILTER_CHECK(skIPSetCheckRecordSIP(checks->ipset[SRC], rwrec)
-                         ^ checks->ipset_reject[SRC]);
-            break;
+    rwRecMemGetNhIP(rwrec, &ip);
+    return cidrListContains(NHIP, &ip) ^ checks->cidr_negated[NHIP];
+}
 
-          case OPT_NOT_SET_DIP:
-          case OPT_SET_DIP:
-            FILTER_CHECK(skIPSetCheckRecordDIP(checks->ipset[DST], rwrec)
-                         ^ checks->ipset_reject[DST]);
-            break;
+static int
+predAnyCidr(
+    const rwRec        *rwrec)
+{
+    skipaddr_t ip1;
+    skipaddr_t ip2;
+    const skcidr_t *cidr = checks->cidr_list[ANY];
+    const skcidr_t *end_cidr = cidr + checks->cidr_list_len[ANY];
+
+    rwRecMemGetSIP(rwrec, &ip1);
+    rwRecMemGetDIP(rwrec, &ip2);
+    for ( ; cidr < end_cidr; ++cidr) {
+        if (skcidrCheckIP(cidr, &ip1) || skcidrCheckIP(cidr, &ip2)) {
+            return !checks->cidr_negated[ANY];
+        }
+    }
+    return checks->cidr_negated[ANY];
+}
 
-          case OPT_NOT_SET_NHIP:
-          case OPT_SET_NHIP:
-            FILTER_CHECK(skIPSetCheckRecordNhIP(checks->ipset[NHIP], rwrec)
-                         ^ checks->ipset_reject[NHIP]);
-            break;
+/*
+ *    For the wildcard and IPset predicates, the record FAILS the
+ *    filter when the result of the check MATCHES the status of the
+ *    negate flag.  E.g., the record matches the address-bitmap
+ *    (skIPWildcardCheckIp()==1) and the user entered --not-saddr
+ *    (ipwild_negate==1).  Since the record FAILS when the values are
+ *    equal, it will PASS when they are not-equal; i.e., when the
+ *    XOR(^) of the two values is true.
+ */
+static int
+predSAddress(
+    const rwRec        *rwrec)
+{
+    skipaddr_t ip;
 
-          case OPT_NOT_SET_ANY:
-          case OPT_SET_ANY:
-            FILTER_CHECK((skIPSetCheckRecordSIP(checks->ipset[ANY], rwrec)
-                          | skIPSetCheckRecordDIP(checks->ipset[ANY], rwrec))
-                         ^ checks->ipset_reject[ANY]);
-            break;
+    rwRecMemGetSIP(rwrec, &ip);
+    return (skIPWildcardCheckIp(&checks->ipwild[SRC], &ip)
+            ^ checks->ipwild_negate[SRC]);
+}
 
-          case OPT_INPUT_INDEX:
-            FILTER_CHECK(skBitmapGetBit(checks->input_index,
-                                        rwRecGetInput(rwrec)));
-            break;
+static int
+predDAddress(
+    const rwRec        *rwrec)
+{
+    skipaddr_t ip;
 
-          case OPT_OUTPUT_INDEX:
-            FILTER_CHECK(skBitmapGetBit(checks->output_index,
-                                        rwRecGetOutput(rwrec)));
-            break;
+    rwRecMemGetDIP(rwrec, &ip);
+    return (skIPWildcardCheckIp(&checks->ipwild[DST], &ip)
+            ^ checks->ipwild_negate[DST]);
+}
 
-          case OPT_ANY_INDEX:
-            FILTER_CHECK(skBitmapGetBit(checks->any_index,rwRecGetInput(rwrec))
-                         || skBitmapGetBit(checks->any_index,
-                                           rwRecGetOutput(rwrec)));
-            break;
+static int
+predNextHopId(
+    const rwRec        *rwrec)
+{
+    skipaddr_t ip;
 
-            /*
-             * TCP check.  Passes if there's an intersection between
-             * the raised flags and the filter flags.
-             */
-          case OPT_TCP_FLAGS:
-            FILTER_CHECK(checks->flags & rwRecGetFlags(rwrec));
-            break;
+    rwRecMemGetNhIP(rwrec, &ip);
+    return (skIPWildcardCheckIp(&checks->ipwild[NHIP], &ip)
+            ^ checks->ipwild_negate[NHIP]);
+}
 
-          case OPT_FLAGS_ALL:
-            wanted = 0;
-            for (i = 0; i < checks->count_flags_all; ++i) {
-                if (CHECK_TCP_HIGH_MASK(rwRecGetFlags(rwrec),
-                                        checks->flags_all[i]))
-                {
-                    wanted = 1;
-                    break; /* wanted */
-                }
-            }
-            FILTER_CHECK(wanted);
-            break;
+static int
+predAnyAddress(
+    const rwRec        *rwrec)
+{
+    skipaddr_t ip1;
+    skipaddr_t ip2;
 
-          case OPT_FLAGS_INITIAL:
-            wanted = 0;
-            for (i = 0; i < checks->count_flags_init; ++i) {
-                if (CHECK_TCP_HIGH_MASK(rwRecGetInitFlags(rwrec),
-                                        checks->flags_init[i]))
-                {
-                    wanted = 1;
-                    break; /* wanted */
-                }
-            }
-            FILTER_CHECK(wanted);
-            break;
+    rwRecMemGetSIP(rwrec, &ip1);
+    rwRecMemGetDIP(rwrec, &ip2);
+    return ((skIPWildcardCheckIp(&checks->ipwild[ANY], &ip1)
+             | skIPWildcardCheckIp(&checks->ipwild[ANY], &ip2))
+            ^ checks->ipwild_negate[ANY]);
+}
 
-          case OPT_FLAGS_SESSION:
-            wanted = 0;
-            for (i = 0; i < checks->count_flags_session; ++i) {
-                if (CHECK_TCP_HIGH_MASK(rwRecGetRestFlags(rwrec),
-                                        checks->flags_session[i]))
-                {
-                    wanted = 1;
-                    break;
-                }
-            }
-            FILTER_CHECK(wanted);
-            break;
+static int
+predSetSIP(
+    const rwRec        *rwrec)
+{
+    return skIPSetCheckRecordSIP(checks->ipset[SRC], rwrec);
+}
 
-          case OPT_ATTRIBUTES:
-            wanted = 0;
-            for (i = 0; i < checks->count_attributes; ++i) {
-                if (CHECK_TCP_HIGH_MASK(rwRecGetTcpState(rwrec),
-                                        checks->attributes[i]))
-                {
-                    wanted = 1;
-                    break;
+static int
+predNotSetSIP(
+    const rwRec        *rwrec)
+{
+    return !skIPSetCheckRecordSIP(checks->ipset[SRC], rwrec);
+}
+
+static int
+predSetDIP(
+    const rwRec        *rwrec)
+{
+    return skIPSetCheckRecordDIP(checks->ipset[DST], rwrec);
+}
+
+static int
+predNotSetDIP(
+    const rwRec        *rwrec)
+{
+    return !skIPSetCheckRecordDIP(checks->ipset[DST], rwrec);
+}
+
+static int
+predSetNhIP(
+    const rwRec        *rwrec)
+{
+    return (skIPSetCheckRecordNhIP(checks->ipset[NHIP], rwrec)
+            ^ checks->ipset_reject[NHIP]);
+}
+
+static int
+predSetAny(
+    const rwRec        *rwrec)
+{
+    return ((skIPSetCheckRecordSIP(checks->ipset[ANY], rwrec)
+             | skIPSetCheckRecordDIP(checks->ipset[ANY], rwrec))
+            ^ checks->ipset_reject[ANY]);
+}
+
+static int
+predInputIndex(
+    const rwRec        *rwrec)
+{
+    return skBitmapGetBit(checks->input_index, rwRecGetInput(rwrec));
+}
+
+static int
+predOutputIndex(
+    const rwRec        *rwrec)
+{
+    return skBitmapGetBit(checks->output_index, rwRecGetOutput(rwrec));
+}
+
+static int
+predAnyIndex(
+    const rwRec        *rwrec)
+{
+    return (skBitmapGetBit(checks->any_index, rwRecGetInput(rwrec))
+            || skBitmapGetBit(checks->any_index, rwRecGetOutput(rwrec)));
+}
+
+/*
+ *    TCP check.  Passes if there's an intersection between the
+ *    raised flags and the filter flags.
+ */
+static int
+predTcpFlags(
+    const rwRec        *rwrec)
+{
+    return (checks->flags & rwRecGetFlags(rwrec));
+}
+
+/*
+ *    Return 1 if 'flags' matches any of the 'count' high/mask pairs
+ *    in 'high_mask'; 0 otherwise.
+ */
+static int
+highMaskListMatches(
+    uint8_t             flags,
+    const high_mask_t  *high_mask,
+    unsigned int        count)
+{
+    unsigned int i;
+
+    for (i = 0; i < count; ++i) {
+        if (CHECK_TCP_HIGH_MASK(flags, high_mask[i])) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static int
+predFlagsAll(
+    const rwRec        *rwrec)
+{
+    return highMaskListMatches(rwRecGetFlags(rwrec), checks->flags_all,
+                               checks->count_flags_all);
+}
+
+static int
+predFlagsInitial(
+    const rwRec        *rwrec)
+{
+    return highMaskListMatches(rwRecGetInitFlags(rwrec), checks->flags_init,
+                               checks->count_flags_init);
+}
+
+static int
+predFlagsSession(
+    const rwRec        *rwrec)
+{
+    return highMaskListMatches(rwRecGetRestFlags(rwrec),
+                               checks->flags_session,
+                               checks->count_flags_session);
+}
+
+static int
+predAttributes(
+    const rwRec        *rwrec)
+{
+    return highMaskListMatches(rwRecGetTcpState(rwrec), checks->attributes,
+                               checks->count_attributes);
+}
+
+static int
+predApplication(
+    const rwRec        *rwrec)
+{
+    return skBitmapGetBit(checks->application, rwRecGetApplication(rwrec));
+}
+
+static int
+predIPv6Only(
+    const rwRec        *rwrec)
+{
+    return rwRecIsIPv6(rwrec);
+}
+
+static int
+predIPv4Only(
+    const rwRec        *rwrec)
+{
+    return !rwRecIsIPv6(rwrec);
+}
+
+static int
+predSensors(
+    const rwRec        *rwrec)
+{
+    return skBitmapGetBit(checks->sID, rwRecGetSensor(rwrec));
+}
+
+static int
+predFlowType(
+    const rwRec        *rwrec)
+{
+    return skBitmapGetBit(checks->flow_type, rwRecGetFlowType(rwrec));
+}
+
+static int
+predSCountry(
+    const rwRec        *rwrec)
+{
+    skipaddr_t ip;
+
+    rwRecMemGetSIP(rwrec, &ip);
+    return skBitmapGetBit(checks->scc, skCountryLookupCode(&ip));
+}
+
+static int
+predDCountry(
+    const rwRec        *rwrec)
+{
+    skipaddr_t ip;
+
+    rwRecMemGetDIP(rwrec, &ip);
+    return skBitmapGetBit(checks->dcc, skCountryLookupCode(&ip));
+}
+
+static int
+predAnyCountry(
+    const rwRec        *rwrec)
+{
+    skipaddr_t ip;
+
+    rwRecMemGetSIP(rwrec, &ip);
+    if (skBitmapGetBit(checks->any_cc, skCountryLookupCode(&ip))) {
+        return 1;
+    }
+    rwRecMemGetDIP(rwrec, &ip);
+    return skBitmapGetBit(checks->any_cc, skCountryLookupCode(&ip));
+}
+
+
+/*
+ *    The block predicates.
+ *
+ *    A block predicate tests a single partitioning switch against
+ *    every record in a filter_block_t and clears the entry in the
+ *    selection mask 'sel' for each record that fails.  The loops
+ *    contain no branches so the compiler is able to vectorize them;
+ *    records that have already failed an earlier step are tested
+ *    anyway since that is cheaper than skipping them.
+ */
+
+static void
+blockSTime(
+    const filter_block_t   *blk,
+    uint32_t                count,
+    uint8_t                *sel)
+{
+    const uint64_t min = checks->sTime.min;
+    const uint64_t max = checks->sTime.max;
+    uint32_t i;
+
+    for (i = 0; i < count; ++i) {
+        sel[i] &= (blk->stime[i] >= min) & (blk->stime[i] <= max);
+    }
+}
+
+static void
+blockETime(
+    const filter_block_t   *blk,
+    uint32_t                count,
+    uint8_t                *sel)
+{
+    const uint64_t min = checks->eTime.min;
+    const uint64_t max = checks->eTime.max;
+    uint32_t i;
+
+    for (i = 0; i < count; ++i) {
+        sel[i] &= (blk->etime[i] >= min) & (blk->etime[i] <= max);
+    }
+}
+
+static void
+blockActiveTime(
+    const filter_block_t   *blk,
+    uint32_t                count,
+    uint8_t                *sel)
+{
+    const uint64_t min = checks->active_time.min;
+    const uint64_t max = checks->active_time.max;
+    uint32_t i;
+
+    for (i = 0; i < count; ++i) {
+        sel[i] &= (blk->stime[i] <= max) & (blk->etime[i] >= min);
+    }
+}
+
+static void
+blockDuration(
+    const filter_block_t   *blk,
+    uint32_t                count,
+    uint8_t                *sel)
+{
+    const uint64_t min = checks->elapsed.min;
+    const uint64_t max = checks->elapsed.max;
+    uint32_t i;
+
+    for (i = 0; i < count; ++i) {
+        sel[i] &= (blk->elapsed[i] >= min) & (blk->elapsed[i] <= max);
+    }
+}
+
+static void
+blockBytes(
+    const filter_block_t   *blk,
+    uint32_t                count,
+    uint8_t                *sel)
+{
+    const uint64_t min = checks->bytes.min;
+    const uint64_t max = checks->bytes.max;
+    uint32_t i;
+
+    for (i = 0; i < count; ++i) {
+        sel[i] &= (blk->bytes[i] >= min) & (blk->bytes[i] <= max);
+    }
+}
+
+static void
+blockPackets(
+    const filter_block_t   *blk,
+    uint32_t                count,
+    uint8_t                *sel)
+{
+    const uint64_t min = checks->pkts.min;
+    const uint64_t max = checks->pkts.max;
+    uint32_t i;
+
+    for (i = 0; i < count; ++i) {
+        sel[i] &= (blk->pkts[i] >= min) & (blk->pkts[i] <= max);
+    }
+}
+
+static void
+blockSPort(
+    const filter_block_t   *blk,
+    uint32_t                count,
+    uint8_t                *sel)
+{
+    const sk_bitmap_t *bmap = checks->sPort;
+    uint32_t i;
+
+    for (i = 0; i < count; ++i) {
+        sel[i] &= skBitmapGetBitUnchecked(bmap, blk->sport[i]);
+    }
+}
+
+static void
+blockDPort(
+    const filter_block_t   *blk,
+    uint32_t                count,
+    uint8_t                *sel)
+{
+    const sk_bitmap_t *bmap = checks->dPort;
+    uint32_t i;
+
+    for (i = 0; i < count; ++i) {
+        sel[i] &= skBitmapGetBitUnchecked(bmap, blk->dport[i]);
+    }
+}
+
+static void
+blockAnyPort(
+    const filter_block_t   *blk,
+    uint32_t                count,
+    uint8_t                *sel)
+{
+    const sk_bitmap_t *bmap = checks->any_port;
+    uint32_t i;
+
+    for (i = 0; i < count; ++i) {
+        sel[i] &= (skBitmapGetBitUnchecked(bmap, blk->sport[i])
+                   | skBitmapGetBitUnchecked(bmap, blk->dport[i]));
+    }
+}
+
+static void
+blockProtocol(
+    const filter_block_t   *blk,
+    uint32_t                count,
+    uint8_t                *sel)
+{
+    const sk_bitmap_t *bmap = checks->proto;
+    uint32_t i;
+
+    for (i = 0; i < count; ++i) {
+        sel[i] &= skBitmapGetBitUnchecked(bmap, blk->proto[i]);
+    }
+}
+
+static void
+blockInputIndex(
+    const filter_block_t   *blk,
+    uint32_t                count,
+    uint8_t                *sel)
+{
+    const sk_bitmap_t *bmap = checks->input_index;
+    uint32_t i;
+
+    for (i = 0; i < count; ++i) {
+        sel[i] &= skBitmapGetBitUnchecked(bmap, blk->input[i]);
+    }
+}
+
+static void
+blockOutputIndex(
+    const filter_block_t   *blk,
+    uint32_t                count,
+    uint8_t                *sel)
+{
+    const sk_bitmap_t *bmap = checks->output_index;
+    uint32_t i;
+
+    for (i = 0; i < count; ++i) {
+        sel[i] &= skBitmapGetBitUnchecked(bmap, blk->output[i]);
+    }
+}
+
+static void
+blockAnyIndex(
+    const filter_block_t   *blk,
+    uint32_t                count,
+    uint8_t                *sel)
+{
+    const sk_bitmap_t *bmap = checks->any_index;
+    uint32_t i;
+
+    for (i = 0; i < count; ++i) {
+        sel[i] &= (skBitmapGetBitUnchecked(bmap, blk->input[i])
+                   | skBitmapGetBitUnchecked(bmap, blk->output[i]));
+    }
+}
+
+static void
+blockTcpFlags(
+    const filter_block_t   *blk,
+    uint32_t                count,
+    uint8_t                *sel)
+{
+    const uint8_t flags = checks->flags;
+    uint32_t i;
+
+    for (i = 0; i < count; ++i) {
+        sel[i] &= ((blk->flags[i] & flags) != 0);
+    }
+}
+
+static void
+blockSCidrV4(
+    const filter_block_t   *blk,
+    uint32_t                count,
+    uint8_t                *sel)
+{
+    const uint32_t ip = checks->cidr_list[SRC]->v4.ip;
+    const uint32_t mask = checks->cidr_list[SRC]->v4.mask;
+    uint32_t i;
+
+    for (i = 0; i < count; ++i) {
+        sel[i] &= ((blk->sipv4[i] & mask) == ip);
+    }
+}
+
+static void
+blockDCidrV4(
+    const filter_block_t   *blk,
+    uint32_t                count,
+    uint8_t                *sel)
+{
+    const uint32_t ip = checks->cidr_list[DST]->v4.ip;
+    const uint32_t mask = checks->cidr_list[DST]->v4.mask;
+    uint32_t i;
+
+    for (i = 0; i < count; ++i) {
+        sel[i] &= ((blk->dipv4[i] & mask) == ip);
+    }
+}
+
+
+/*
+ *  planSetBlockPredicate(step);
+ *
+ *    Set the block predicate and the columns it reads on the plan
+ *    step 'step' when the check it implements has a block version.
+ *    Otherwise leave the block predicate NULL so filterCheckBlock()
+ *    runs the step's predicate on each record.
+ */
+static void
+planSetBlockPredicate(
+    filter_plan_step_t *step)
+{
+    switch (step->check_key) {
+      case OPT_STIME:
+        step->block_pred = &blockSTime;
+        step->columns = FILTER_COL_STIME;
+        break;
+      case OPT_ETIME:
+        step->block_pred = &blockETime;
+        step->columns = FILTER_COL_ETIME;
+        break;
+      case OPT_ACTIVE_TIME:
+        step->block_pred = &blockActiveTime;
+        step->columns = FILTER_COL_STIME | FILTER_COL_ETIME;
+        break;
+      case OPT_DURATION:
+        step->block_pred = &blockDuration;
+        step->columns = FILTER_COL_ELAPSED;
+        break;
+      case OPT_BYTES:
+        step->block_pred = &blockBytes;
+        step->columns = FILTER_COL_BYTES;
+        break;
+      case OPT_PACKETS:
+        step->block_pred = &blockPackets;
+        step->columns = FILTER_COL_PKTS;
+        break;
+      case OPT_SPORT:
+        step->block_pred = &blockSPort;
+        step->columns = FILTER_COL_SPORT;
+        break;
+      case OPT_DPORT:
+        step->block_pred = &blockDPort;
+        step->columns = FILTER_COL_DPORT;
+        break;
+      case OPT_APORT:
+        step->block_pred = &blockAnyPort;
+        step->columns = FILTER_COL_SPORT | FILTER_COL_DPORT;
+        break;
+      case OPT_PROTOCOL:
+        step->block_pred = &blockProtocol;
+        step->columns = FILTER_COL_PROTO;
+        break;
+      case OPT_INPUT_INDEX:
+        step->block_pred = &blockInputIndex;
+        step->columns = FILTER_COL_INPUT;
+        break;
+      case OPT_OUTPUT_INDEX:
+        step->block_pred = &blockOutputIndex;
+        step->columns = FILTER_COL_OUTPUT;
+        break;
+      case OPT_ANY_INDEX:
+        step->block_pred = &blockAnyIndex;
+        step->columns = FILTER_COL_INPUT | FILTER_COL_OUTPUT;
+        break;
+      case OPT_TCP_FLAGS:
+        step->block_pred = &blockTcpFlags;
+        step->columns = FILTER_COL_FLAGS;
+        break;
+      case OPT_SCIDR:
+        /* only a single, positive IPv4 CIDR block; the test falls
+         * back to the record predicate for blocks holding IPv6 */
+        if (&predSCidrSingle == step->pred
+            && !checks->cidr_list[SRC]->v4.is_ipv6)
+        {
+            step->block_pred = &blockSCidrV4;
+            step->columns = FILTER_COL_SIPV4;
+        }
+        break;
+      case OPT_DCIDR:
+        if (&predDCidrSingle == step->pred
+            && !checks->cidr_list[DST]->v4.is_ipv6)
+        {
+            step->block_pred = &blockDCidrV4;
+            step->columns = FILTER_COL_DIPV4;
+        }
+        break;
+      default:
+        break;
+    }
+}
+
+
+/*
+ *  blockFillColumns(blk, recs, count, columns);
+ *
+ *    Copy the fields named by the FILTER_COL_* bits in 'columns' from
+ *    the 'count' records in 'recs' into the arrays of 'blk'.
+ */
+static void
+blockFillColumns(
+    filter_block_t     *blk,
+    const rwRec        *recs,
+    uint32_t            count,
+    uint32_t            columns)
+{
+    uint32_t i;
+
+    if (columns & (FILTER_COL_STIME | FILTER_COL_ETIME)) {
+        for (i = 0; i < count; ++i) {
+            blk->stime[i] = (uint64_t)rwRecGetStartTime(&recs[i]);
+        }
+    }
+    if (columns & (FILTER_COL_ELAPSED | FILTER_COL_ETIME)) {
+        for (i = 0; i < count; ++i) {
+            blk->elapsed[i] = rwRecGetElapsed(&recs[i]);
+        }
+    }
+    if (columns & FILTER_COL_ETIME) {
+        for (i = 0; i < count; ++i) {
+            blk->etime[i] = blk->stime[i] + blk->elapsed[i];
+        }
+    }
+    if (columns & FILTER_COL_BYTES) {
+        for (i = 0; i < count; ++i) {
+            blk->bytes[i] = rwRecGetBytes(&recs[i]);
+        }
+    }
+    if (columns & FILTER_COL_PKTS) {
+        for (i = 0; i < count; ++i) {
+            blk->pkts[i] = rwRecGetPkts(&recs[i]);
+        }
+    }
+    if (columns & FILTER_COL_SPORT) {
+        for (i = 0; i < count; ++i) {
+            blk->sport[i] = rwRecGetSPort(&recs[i]);
+        }
+    }
+    if (columns & FILTER_COL_DPORT) {
+        for (i = 0; i < count; ++i) {
+            blk->dport[i] = rwRecGetDPort(&recs[i]);
+        }
+    }
+    if (columns & FILTER_COL_PROTO) {
+        for (i = 0; i < count; ++i) {
+            blk->proto[i] = rwRecGetProto(&recs[i]);
+        }
+    }
+    if (columns & FILTER_COL_FLAGS) {
+        for (i = 0; i < count; ++i) {
+            blk->flags[i] = rwRecGetFlags(&recs[i]);
+        }
+    }
+    if (columns & FILTER_COL_INPUT) {
+        for (i = 0; i < count; ++i) {
+            blk->input[i] = rwRecGetInput(&recs[i]);
+        }
+    }
+    if (columns & FILTER_COL_OUTPUT) {
+        for (i = 0; i < count; ++i) {
+            blk->output[i] = rwRecGetOutput(&recs[i]);
+        }
+    }
+    if (columns & (FILTER_COL_SIPV4 | FILTER_COL_DIPV4)) {
+        blk->has_ipv6 = 0;
+        for (i = 0; i < count; ++i) {
+            blk->has_ipv6 |= rwRecIsIPv6(&recs[i]);
+        }
+        if (!blk->has_ipv6) {
+            if (columns & FILTER_COL_SIPV4) {
+                for (i = 0; i < count; ++i) {
+                    blk->sipv4[i] = rwRecGetSIPv4(&recs[i]);
+                }
+            }
+            if (columns & FILTER_COL_DIPV4) {
+                for (i = 0; i < count; ++i) {
+                    blk->dipv4[i] = rwRecGetDIPv4(&recs[i]);
                 }
             }
-            FILTER_CHECK(wanted);
+        }
+    }
+}
+
+
+/*
+ *  cost = planStepCost(check_key);
+ *
+ *    Return an estimate of the relative cost of evaluating the check
+ *    whose key is 'check_key'.  The values are a rough count of the
+ *    memory references and branches the predicate performs; they are
+ *    combined with the pass rates observed while sampling to order
+ *    the steps of the plan.
+ */
+static double
+planStepCost(
+    int                 check_key)
+{
+    switch (check_key) {
+      case OPT_STIME:
+      case OPT_ETIME:
+      case OPT_DURATION:
+      case OPT_BYTES:
+      case OPT_PACKETS:
+      case OPT_PROTOCOL:
+      case OPT_SPORT:
+      case OPT_DPORT:
+      case OPT_TCP_FLAGS:
+      case OPT_SENSORS:
+      case OPT_FLOW_TYPE:
+      case OPT_INPUT_INDEX:
+      case OPT_OUTPUT_INDEX:
+      case OPT_APPLICATION:
+      case OPT_IP_VERSION:
+        return 1.0;
+      case OPT_ACTIVE_TIME:
+      case OPT_APORT:
+      case OPT_ANY_INDEX:
+      case OPT_ICMP_TYPE:
+      case OPT_ICMP_CODE:
+        return 1.5;
+      case OPT_FLAGS_ALL:
+        return 1.0 + 0.5 * checks->count_flags_all;
+      case OPT_FLAGS_INITIAL:
+        return 1.0 + 0.5 * checks->count_flags_init;
+      case OPT_FLAGS_SESSION:
+        return 1.0 + 0.5 * checks->count_flags_session;
+      case OPT_ATTRIBUTES:
+        return 1.0 + 0.5 * checks->count_attributes;
+      case OPT_BYTES_PER_PACKET:
+#if RATE_FILTERS
+      case OPT_BYTES_PER_SECOND:
+      case OPT_PACKETS_PER_SECOND:
+#endif
+        return 3.0;
+      case OPT_SCIDR:
+        return 2.0 + checks->cidr_list_len[SRC];
+      case OPT_DCIDR:
+        return 2.0 + checks->cidr_list_len[DST];
+      case OPT_NHCIDR:
+        return 2.0 + checks->cidr_list_len[NHIP];
+      case OPT_ANY_CIDR:
+        return 2.0 + 2.0 * checks->cidr_list_len[ANY];
+      case OPT_SADDRESS:
+      case OPT_DADDRESS:
+      case OPT_NEXT_HOP_ID:
+        return 4.0;
+      case OPT_ANY_ADDRESS:
+        return 8.0;
+      case OPT_SET_SIP:
+      case OPT_SET_DIP:
+      case OPT_SET_NHIP:
+        return 8.0;
+      case OPT_SET_ANY:
+        return 16.0;
+      case OPT_SCC:
+      case OPT_DCC:
+        return 12.0;
+      case OPT_ANY_CC:
+        return 24.0;
+    }
+    return 4.0;
+}
+
+
+/*
+ *  status = filterCompilePlan();
+ *
+ *    Compile the checks the user requested into the filter plan: an
+ *    array of predicate functions that filterCheck() runs until one
+ *    of them fails.  Checks that can never fail a record are dropped
+ *    from the plan.  Initially the steps are ordered by their
+ *    estimated cost; once FILTER_PLAN_SAMPLE_SIZE records have been
+ *    seen, the steps are re-ordered using the pass rate observed for
+ *    each step.  Return 0 on success.
+ */
+int
+filterCompilePlan(
+    void)
+{
+    filter_plan_step_t *step;
+    filter_plan_step_t tmp;
+    int key;
+    int j;
+    int k;
+
+    memset(plan, 0, sizeof(filter_plan_t));
+
+    for (j = 0; j < checks->check_count; ++j) {
+        key = checks->checkSet[j];
+        step = &plan->step[plan->count];
+        step->check_key = key;
+        switch (key) {
+          case OPT_STIME:
+            step->pred = &predSTime;
+            break;
+          case OPT_ETIME:
+            step->pred = &predETime;
+            break;
+          case OPT_ACTIVE_TIME:
+            step->pred = &predActiveTime;
+            break;
+          case OPT_DURATION:
+            step->pred = &predDuration;
+            break;
+          case OPT_SPORT:
+            step->pred = &predSPort;
+            break;
+          case OPT_DPORT:
+            step->pred = &predDPort;
+            break;
+          case OPT_APORT:
+            step->pred = &predAnyPort;
+            break;
+          case OPT_PROTOCOL:
+            step->pred = &predProtocol;
+            break;
+          case OPT_ICMP_TYPE:
+            step->pred = &predIcmpType;
+            break;
+          case OPT_ICMP_CODE:
+            step->pred = &predIcmpCode;
+            break;
+          case OPT_BYTES:
+            step->pred = &predBytes;
+            break;
+          case OPT_PACKETS:
+            step->pred = &predPackets;
+            break;
+          case OPT_BYTES_PER_PACKET:
+            step->pred = &predBytesPerPacket;
+            break;
+#if RATE_FILTERS
+          case OPT_BYTES_PER_SECOND:
+            step->pred = &predBytesPerSecond;
+            break;
+          case OPT_PACKETS_PER_SECOND:
+            step->pred = &predPacketsPerSecond;
+            break;
+#endif  /* RATE_FILTERS */
+          case OPT_SCIDR:
+            if (1 == checks->cidr_list_len[SRC] && !checks->cidr_negated[SRC]){
+                step->pred = &predSCidrSingle;
+            } else {
+                step->pred = &predSCidr;
+            }
+            break;
+          case OPT_DCIDR:
+            if (1 == checks->cidr_list_len[DST] && !checks->cidr_negated[DST]){
+                step->pred = &predDCidrSingle;
+            } else {
+                step->pred = &predDCidr;
+            }
+            break;
+          case OPT_NHCIDR:
+            step->pred = &predNhCidr;
+            break;
+          case OPT_ANY_CIDR:
+            step->pred = &predAnyCidr;
+            break;
+          case OPT_SADDRESS:
+            step->pred = &predSAddress;
+            break;
+          case OPT_DADDRESS:
+            step->pred = &predDAddress;
+            break;
+          case OPT_NEXT_HOP_ID:
+            step->pred = &predNextHopId;
+            break;
+          case OPT_ANY_ADDRESS:
+            step->pred = &predAnyAddress;
+            break;
+          case OPT_SET_SIP:
+            step->pred = ((checks->ipset_reject[SRC])
+                          ? &predNotSetSIP : &predSetSIP);
+            break;
+          case OPT_SET_DIP:
+            step->pred = ((checks->ipset_reject[DST])
+                          ? &predNotSetDIP : &predSetDIP);
+            break;
+          case OPT_SET_NHIP:
+            step->pred = &predSetNhIP;
+            break;
+          case OPT_SET_ANY:
+            step->pred = &predSetAny;
+            break;
+          case OPT_INPUT_INDEX:
+            step->pred = &predInputIndex;
+            break;
+          case OPT_OUTPUT_INDEX:
+            step->pred = &predOutputIndex;
+            break;
+          case OPT_ANY_INDEX:
+            step->pred = &predAnyIndex;
+            break;
+          case OPT_TCP_FLAGS:
+            step->pred = &predTcpFlags;
+            break;
+          case OPT_FLAGS_ALL:
+            step->pred = &predFlagsAll;
+            break;
+          case OPT_FLAGS_INITIAL:
+            step->pred = &predFlagsInitial;
+            break;
+          case OPT_FLAGS_SESSION:
+            step->pred = &predFlagsSession;
+            break;
+          case OPT_ATTRIBUTES:
+            step->pred = &predAttributes;
             break;
-
           case OPT_APPLICATION:
-            FILTER_CHECK(skBitmapGetBit(checks->application,
-                                        rwRecGetApplication(rwrec)));
+            step->pred = &predApplication;
             break;
-
           case OPT_IP_VERSION:
             switch (checks->ipv6_policy) {
               case SK_IPV6POLICY_MIX:
-                break;
+                /* every record passes; no need for a step */
+                continue;
               case SK_IPV6POLICY_ONLY:
-                FILTER_CHECK(rwRecIsIPv6(rwrec));
+                step->pred = &predIPv6Only;
                 break;
               case SK_IPV6POLICY_IGNORE:
-                FILTER_CHECK(!rwRecIsIPv6(rwrec));
+                step->pred = &predIPv4Only;
                 break;
               case SK_IPV6POLICY_ASV4:
               case SK_IPV6POLICY_FORCE:
@@ -1368,46 +2291,449 @@ filterCheck(
                 skAbortBadCase(checks->ipv6_policy);
             }
             break;
-
           case OPT_SENSORS:
-            FILTER_CHECK(skBitmapGetBit(checks->sID, rwRecGetSensor(rwrec)));
+            step->pred = &predSensors;
             break;
-
           case OPT_FLOW_TYPE:
-            FILTER_CHECK(skBitmapGetBit(checks->flow_type,
-                                        rwRecGetFlowType(rwrec)));
+            step->pred = &predFlowType;
             break;
-
           case OPT_SCC:
-            rwRecMemGetSIP(rwrec, &ip1);
-            FILTER_CHECK(skBitmapGetBit(checks->scc,
-                                        skCountryLookupCode(&ip1)));
+            step->pred = &predSCountry;
             break;
-
           case OPT_DCC:
-            rwRecMemGetDIP(rwrec, &ip1);
-            FILTER_CHECK(skBitmapGetBit(checks->dcc,
-                                        skCountryLookupCode(&ip1)));
+            step->pred = &predDCountry;
             break;
-
           case OPT_ANY_CC:
-            rwRecMemGetSIP(rwrec, &ip1);
-            rwRecMemGetDIP(rwrec, &ip2);
-            FILTER_CHECK(skBitmapGetBit(checks->any_cc,
-                                        skCountryLookupCode(&ip1))
-                         || skBitmapGetBit(checks->any_cc,
-                                           skCountryLookupCode(&ip2)));
+            step->pred = &predAnyCountry;
             break;
-
           default:
-            skAbortBadCase(checks->checkSet[j]);
+            skAbortBadCase(key);
+        }
+        step->cost = planStepCost(key);
+        planSetBlockPredicate(step);
+        plan->columns |= step->columns;
+        ++plan->count;
+    }
+
+    /* order the steps by cost; insertion sort keeps the user's order
+     * among steps of equal cost */
+    for (j = 1; j < (int)plan->count; ++j) {
+        tmp = plan->step[j];
+        for (k = j; k > 0 && plan->step[k-1].cost > tmp.cost; --k) {
+            plan->step[k] = plan->step[k-1];
+        }
+        plan->step[k] = tmp;
+    }
+
+#if PLAN_ATOMIC_SAMPLING
+    atomic_init(&plan->sampling, (plan->count > 1));
+#else
+    plan->sampling = (plan->count > 1);
+#endif
+    plan->counting = (NULL != filter_plan_fp);
+    plan->lock = (thread_count > 1);
+    if (plan->lock) {
+        pthread_mutex_init(&plan->mutex, NULL);
+    }
+
+    return 0;
+}
+
+
+/*
+ *  planReorder();
+ *
+ *    Use the pass rates observed while sampling to re-order the
+ *    steps of the filter plan.  The caller must hold the plan's mutex
+ *    when running with multiple threads.
+ *
+ *    Since the steps are a conjunction of independent tests, the
+ *    expected cost of the plan is minimized by running the steps in
+ *    increasing order of cost / (1 - pass_rate); that is, cheap steps
+ *    that reject many records run first.  A step that passes every
+ *    sampled record sorts last.
+ */
+static void
+planReorder(
+    void)
+{
+    filter_plan_step_t tmp;
+    double rate;
+    unsigned int j;
+    unsigned int k;
+
+    for (j = 0; j < plan->count; ++j) {
+        rate = ((double)plan->step[j].sample_passed
+                / (double)plan->sample_count);
+        if (rate >= 1.0) {
+            plan->step[j].rank = HUGE_VAL;
+        } else {
+            plan->step[j].rank = plan->step[j].cost / (1.0 - rate);
+        }
+    }
+    for (j = 1; j < plan->count; ++j) {
+        tmp = plan->step[j];
+        for (k = j; k > 0 && plan->step[k-1].rank > tmp.rank; --k) {
+            plan->step[k] = plan->step[k-1];
+        }
+        plan->step[k] = tmp;
+    }
+}
+
+
+/*
+ *  sampling = planIsSampling();
+ *
+ *    Return 1 if the plan is being sampled, or 0 if it is not.
+ *    filterCheckSlow() re-orders the steps and then clears the flag
+ *    while holding the plan's mutex.  Once the flag is 0 it does not
+ *    change, and the steps are not modified.  When C11 atomics are
+ *    available, the flag is read with an acquire load that pairs with
+ *    the release store that clears it, so a thread that sees 0 also
+ *    sees the re-ordered steps.  Otherwise the flag is read while
+ *    holding the mutex when running with multiple threads.
+ */
+static int
+planIsSampling(
+    void)
+{
+#if PLAN_ATOMIC_SAMPLING
+    return atomic_load_explicit(&plan->sampling, memory_order_acquire);
+#else
+    int sampling;
+
+    if (!plan->lock) {
+        return plan->sampling;
+    }
+    pthread_mutex_lock(&plan->mutex);
+    sampling = plan->sampling;
+    pthread_mutex_unlock(&plan->mutex);
+    return sampling;
+#endif  /* #else of #if PLAN_ATOMIC_SAMPLING */
+}
+
+
+/*
+ *  result = filterCheckSlow(rwrec, blk);
+ *
+ *    Helper for filterCheck() and filterCheckBlock() that handles the
+ *    records seen while the plan is being sampled and the records
+ *    when the user asked for the per-step counts of
+ *    --print-filter-plan.
+ *
+ *    While sampling, every step is run on the record so that the
+ *    pass rate of each step is independent of the current order;
+ *    this is done while holding the plan's mutex.  Sampled records
+ *    are not included in the per-step counts.
+ *
+ *    Once sampling is complete, the per-step counts are added to the
+ *    counters in 'blk', which belong to the calling thread, so the
+ *    mutex is not needed.  When 'blk' is NULL, the counts are added to
+ *    the plan while holding the mutex.
+ */
+static checktype_t
+filterCheckSlow(
+    const rwRec        *rwrec,
+    filter_block_t     *blk)
+{
+    filter_plan_step_t *step;
+    filter_plan_step_t *end_step;
+    checktype_t result = RWF_PASS;
+    unsigned int j;
+
+    end_step = plan->step + plan->count;
+
+    if (planIsSampling()) {
+        if (plan->lock) {
+            pthread_mutex_lock(&plan->mutex);
         }
-    } /* outer for */
+        /* check again, since another thread may have finished the
+         * sample */
+        if (plan->sampling) {
+            for (step = plan->step; step < end_step; ++step) {
+                if (step->pred(rwrec)) {
+                    ++step->sample_passed;
+                } else {
+                    result = RWF_FAIL;
+                }
+            }
+            ++plan->sample_count;
+            if (plan->sample_count == FILTER_PLAN_SAMPLE_SIZE) {
+                planReorder();
+#if PLAN_ATOMIC_SAMPLING
+                atomic_store_explicit(&plan->sampling, 0,
+                                      memory_order_release);
+#else
+                plan->sampling = 0;
+#endif
+            }
+            if (plan->lock) {
+                pthread_mutex_unlock(&plan->mutex);
+            }
+            return result;
+        }
+        if (plan->lock) {
+            pthread_mutex_unlock(&plan->mutex);
+        }
+    }
+
+    if (blk) {
+        for (j = 0; j < plan->count; ++j) {
+            ++blk->evaluated[j];
+            if (!plan->step[j].pred(rwrec)) {
+                return RWF_FAIL;
+            }
+            ++blk->passed[j];
+        }
+        return RWF_PASS;
+    }
+
+    if (plan->lock) {
+        pthread_mutex_lock(&plan->mutex);
+    }
+    for (step = plan->step; step < end_step; ++step) {
+        ++step->evaluated;
+        if (!step->pred(rwrec)) {
+            result = RWF_FAIL;
+            break;
+        }
+        ++step->passed;
+    }
+    if (plan->lock) {
+        pthread_mutex_unlock(&plan->mutex);
+    }
+    return result;
+}
+
+
+/*
+ *  pass = filterCheck(&rwrec)
+ *
+ *    Check the rw record 'rwrec' against all of the checks the user
+ *    specified by running the steps of the compiled filter plan.  If
+ *    the record fails any check, RWF_FAIL is returned.  If the record
+ *    passes all of the checks, RWF_PASS is returned.
+ */
+checktype_t
+filterCheck(
+    const rwRec        *rwrec)
+{
+    const filter_plan_step_t *step;
+    const filter_plan_step_t *end_step;
 
+    if (plan->counting || planIsSampling()) {
+        return filterCheckSlow(rwrec, NULL);
+    }
+
+    end_step = plan->step + plan->count;
+    for (step = plan->step; step < end_step; ++step) {
+        if (!step->pred(rwrec)) {
+            return RWF_FAIL;
+        }
+    }
     return RWF_PASS;                     /* WANTED! */
 }
 
 
+/*
+ *  blk = filterBlockCreate();
+ *
+ *    Allocate the columns and the per-step counters that
+ *    filterCheckBlock() uses.  Each thread that calls
+ *    filterCheckBlock() needs its own.  Return NULL on allocation
+ *    error.
+ */
+filter_block_t *
+filterBlockCreate(
+    void)
+{
+    return (filter_block_t*)calloc(1, sizeof(filter_block_t));
+}
+
+
+/*
+ *  filterBlockDestroy(blk);
+ *
+ *    Add the per-step counts in 'blk' to the filter plan and free
+ *    'blk', which filterBlockCreate() allocated.  Do nothing when
+ *    'blk' is NULL.
+ */
+void
+filterBlockDestroy(
+    filter_block_t     *blk)
+{
+    unsigned int j;
+
+    if (NULL == blk) {
+        return;
+    }
+    if (plan->counting) {
+        if (plan->lock) {
+            pthread_mutex_lock(&plan->mutex);
+        }
+        for (j = 0; j < plan->count; ++j) {
+            plan->step[j].evaluated += blk->evaluated[j];
+            plan->step[j].passed += blk->passed[j];
+        }
+        if (plan->lock) {
+            pthread_mutex_unlock(&plan->mutex);
+        }
+    }
+    free(blk);
+}
+
+
+/*
+ *  filterCheckBlock(recs, count, result, blk);
+ *
+ *    Check the 'count' records in 'recs' against all of the checks
+ *    the user specified and set 'result[i]' to RWF_PASS or RWF_FAIL
+ *    for the record at 'recs[i]'.  'count' must not be larger than
+ *    FILTER_BLOCK_SIZE.
+ *
+ *    The fields of the records that the plan tests are copied into
+ *    the columns 'blk', which filterBlockCreate() allocated, and the
+ *    steps of the plan are run across the entire block, building a
+ *    selection mask in 'result'.  Steps that do not have a block
+ *    predicate run the per-record predicate on the records that are
+ *    still selected.
+ */
+void
+filterCheckBlock(
+    const rwRec        *recs,
+    uint32_t            count,
+    uint8_t            *result,
+    filter_block_t     *blk)
+{
+    const filter_plan_step_t *step;
+    const filter_plan_step_t *end_step;
+    uint32_t i;
+
+    assert(count <= FILTER_BLOCK_SIZE);
+    /* the selection mask is used as the result */
+    assert(0 == RWF_FAIL && 1 == RWF_PASS);
+
+    /* the sampling flag is read once for the block */
+    if (plan->counting || planIsSampling()) {
+        for (i = 0; i < count; ++i) {
+            result[i] = (uint8_t)filterCheckSlow(&recs[i], blk);
+        }
+        return;
+    }
+
+    memset(result, RWF_PASS, count);
+    blockFillColumns(blk, recs, count, plan->columns);
+
+    end_step = plan->step + plan->count;
+    for (step = plan->step; step < end_step; ++step) {
+        if (step->block_pred
+            && !((step->columns & (FILTER_COL_SIPV4 | FILTER_COL_DIPV4))
+                 && blk->has_ipv6))
+        {
+            step->block_pred(blk, count, result);
+        } else {
+            for (i = 0; i < count; ++i) {
+                if (result[i]) {
+                    result[i] = (0 != step->pred(&recs[i]));
+                }
+            }
+        }
+    }
+}
+
+
+/*
+ *  name = planStepName(step);
+ *
+ *    Return the name of the switch that created the plan step 'step'.
+ */
+static const char *
+planStepName(
+    const filter_plan_step_t   *step)
+{
+    int key = step->check_key;
+
+    switch (key) {
+      case OPT_SENSORS:
+        return "sensors";
+      case OPT_FLOW_TYPE:
+        return "flowtypes";
+      case OPT_SCIDR:
+      case OPT_DCIDR:
+      case OPT_ANY_CIDR:
+      case OPT_NHCIDR:
+        if (checks->cidr_negated[key - OPT_SCIDR]) {
+            key += IP_INDEX_COUNT;
+        }
+        break;
+      case OPT_SADDRESS:
+      case OPT_DADDRESS:
+      case OPT_ANY_ADDRESS:
+      case OPT_NEXT_HOP_ID:
+        if (checks->ipwild_negate[key - OPT_SADDRESS]) {
+            key += IP_INDEX_COUNT;
+        }
+        break;
+      case OPT_SET_SIP:
+      case OPT_SET_DIP:
+      case OPT_SET_ANY:
+      case OPT_SET_NHIP:
+        if (checks->ipset_reject[key - OPT_SET_SIP]) {
+            key += IP_INDEX_COUNT;
+        }
+        break;
+    }
+    return filterOptions[key].name;
+}
+
+
+/*
+ *  filterPrintPlan(fh);
+ *
+ *    Print to 'fh' the steps of the filter plan in the order they
+ *    are evaluated, the estimated cost of each, the pass rate each
+ *    step had on the sampled records, and---when records were
+ *    counted---the number of records each step evaluated and passed.
+ */
+void
+filterPrintPlan(
+    FILE               *fh)
+{
+    const filter_plan_step_t *step;
+    char sample_rate[32];
+    char pass_rate[32];
+    unsigned int j;
+
+    if (NULL == fh) {
+        return;
+    }
+
+    fprintf(fh, ("%5s|%-18s|%8s|%12s|%20s|%20s|%12s|\n"),
+            "Step", "Switch", "Cost", "Sample%", "Evaluated", "Passed",
+            "Pass%");
+    for (j = 0, step = plan->step; j < plan->count; ++j, ++step) {
+        if (plan->sample_count) {
+            snprintf(sample_rate, sizeof(sample_rate), "%.4f",
+                     (100.0 * (double)step->sample_passed
+                      / (double)plan->sample_count));
+        } else {
+            strncpy(sample_rate, "-", sizeof(sample_rate));
+        }
+        if (step->evaluated) {
+            snprintf(pass_rate, sizeof(pass_rate), "%.4f",
+                     (100.0 * (double)step->passed
+                      / (double)step->evaluated));
+        } else {
+            strncpy(pass_rate, "-", sizeof(pass_rate));
+        }
+        fprintf(fh, ("%5u|%-18s|%8.2f|%12s|%20" PRIu64 "|%20" PRIu64
+                     "|%12s|\n"),
+                j + 1, planStepName(step), step->cost, sample_rate,
+                step->evaluated, step->passed, pass_rate);
+    }
+}
+
+
 /*
  *  pass = filterCheckFile(stream, ip_dir)
  *
@@ -1837,6 +3163,135 @@ filterCheckFile(
 }
 
 
+/*
+ *  skip = filterCheckZone(zone, skipped_flows);
+ *
+ *    Return 1 if none of the records in the block summarized by
+ *    'zone' can pass the user's time, protocol, and port checks, or 0
+ *    if the block must be read.  When returning 1, add the number of
+ *    records in the block to the uint64_t that 'skipped_flows'
+ *    references.
+ *
+ *    This is the callback that filterSkipBlocks() sets on a stream.
+ */
+static int
+filterCheckZone(
+    const sk_block_zone_t  *zone,
+    void                   *skipped_flows)
+{
+    int skip_block = 0;
+    unsigned int p;
+    int j;
+
+    /* times are compared as unsigned values, as the record checks do;
+     * a block with negative times may not be ordered that way */
+    if (zone->stime_min < 0 || zone->etime_min < 0) {
+        return 0;
+    }
+
+    for (j = 0; ((0 == skip_block) && (j < checks->check_count)); ++j) {
+        switch (checks->checkSet[j]) {
+          case OPT_STIME:
+            skip_block = (((uint64_t)zone->stime_min > checks->sTime.max)
+                          || ((uint64_t)zone->stime_max < checks->sTime.min));
+            break;
+
+          case OPT_ETIME:
+            skip_block = (((uint64_t)zone->etime_min > checks->eTime.max)
+                          || ((uint64_t)zone->etime_max < checks->eTime.min));
+            break;
+
+          case OPT_ACTIVE_TIME:
+            skip_block
+                = (((uint64_t)zone->stime_min > checks->active_time.max)
+                   || ((uint64_t)zone->etime_max < checks->active_time.min));
+            break;
+
+          case OPT_PROTOCOL:
+            skip_block = 1;
+            for (p = 0; p < MAX_PROTOCOLS && skip_block; ++p) {
+                if ((zone->protocols[p >> 5] & (1u << (p & 0x1F)))
+                    && skBitmapGetBit(checks->proto, p))
+                {
+                    skip_block = 0;
+                }
+            }
+            break;
+
+          case OPT_SPORT:
+            skip_block = (0 == skBitmapRangeCountHigh(checks->sPort,
+                                                      zone->sport_min,
+                                                      zone->sport_max));
+            break;
+
+          case OPT_DPORT:
+            skip_block = (0 == skBitmapRangeCountHigh(checks->dPort,
+                                                      zone->dport_min,
+                                                      zone->dport_max));
+            break;
+
+          case OPT_APORT:
+            skip_block = ((0 == skBitmapRangeCountHigh(checks->any_port,
+                                                       zone->sport_min,
+                                                       zone->sport_max))
+                          && (0 == skBitmapRangeCountHigh(checks->any_port,
+                                                          zone->dport_min,
+                                                          zone->dport_max)));
+            break;
+
+          default:
+            break;
+        }
+    }
+
+    if (skip_block) {
+        *(uint64_t*)skipped_flows += zone->rec_count;
+    }
+    return skip_block;
+}
+
+
+/*
+ *  filterSkipBlocks(stream, skipped_flows);
+ *
+ *    When the SiLK Flow file read by 'stream' has a block index, tell
+ *    'stream' to skip the blocks whose records cannot pass the user's
+ *    time, protocol, and port checks, and to add the number of
+ *    records in each skipped block to 'skipped_flows'.  Nothing is
+ *    skipped when the records that fail are written somewhere or
+ *    when volume statistics are computed.
+ */
+void
+filterSkipBlocks(
+    skstream_t         *stream,
+    uint64_t           *skipped_flows)
+{
+    int j;
+
+    if (dest_type[DEST_ALL].count || dest_type[DEST_FAIL].count
+        || print_volume_stats)
+    {
+        return;
+    }
+
+    for (j = 0; j < checks->check_count; ++j) {
+        switch (checks->checkSet[j]) {
+          case OPT_STIME:
+          case OPT_ETIME:
+          case OPT_ACTIVE_TIME:
+          case OPT_PROTOCOL:
+          case OPT_SPORT:
+          case OPT_DPORT:
+          case OPT_APORT:
+            skStreamSetBlockFilter(stream, &filterCheckZone, skipped_flows);
+            return;
+          default:
+            break;
+        }
+    }
+}
+
+
 /*
  * int filterSetup()
  *
@@ -1985,6 +3440,10 @@ filterTeardown(
         free(filterOptions);
         filterOptions = NULL;
     }
+    if (plan->lock) {
+        pthread_mutex_destroy(&plan->mutex);
+        plan->lock = 0;
+    }
     skCountryTeardown();
 }
 
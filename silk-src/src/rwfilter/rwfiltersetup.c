@@ -65,10 +65,10 @@ static const char *app_plugin_names[] = {
 typedef enum {
     OPT_DRY_RUN,
 #if SK_RWFILTER_THREADED
-    OPT_THREADS,
+    OPT_THREADS, OPT_THREAD_SPLIT, OPT_KEEP_ORDER,
 #endif
     OPT_MAX_PASS_RECORDS, OPT_MAX_FAIL_RECORDS,
-    OPT_PRINT_FILE, OPT_PLUGIN,
+    OPT_PRINT_FILE, OPT_PRINT_FILTER_PLAN, OPT_PLUGIN,
     OPT_INPUT_PIPE, OPT_XARGS,
     OPT_PASS_DEST, OPT_FAIL_DEST, OPT_ALL_DEST,
     OPT_PRINT_STAT, OPT_PRINT_VOLUME
@@ -78,10 +78,13 @@ static struct option appOptions[] = {
     {"dry-run",                 NO_ARG,       0, OPT_DRY_RUN},
 #if SK_RWFILTER_THREADED
     {"threads",                 REQUIRED_ARG, 0, OPT_THREADS},
+    {"thread-split",            REQUIRED_ARG, 0, OPT_THREAD_SPLIT},
+    {"keep-order",              NO_ARG,       0, OPT_KEEP_ORDER},
 #endif
     {"max-pass-records",        REQUIRED_ARG, 0, OPT_MAX_PASS_RECORDS},
     {"max-fail-records",        REQUIRED_ARG, 0, OPT_MAX_FAIL_RECORDS},
     {"print-filenames",         NO_ARG,       0, OPT_PRINT_FILE},
+    {"print-filter-plan",       NO_ARG,       0, OPT_PRINT_FILTER_PLAN},
     {"plugin",                  REQUIRED_ARG, 0, OPT_PLUGIN},
 
     {"input-pipe",              REQUIRED_ARG, 0, OPT_INPUT_PIPE},
@@ -98,12 +101,18 @@ static const char *appHelp[] = {
     "Parse command line switches but do not process records",
 #if SK_RWFILTER_THREADED
     "Use this number of threads. Def $SILK_RWFILTER_THREADS or 1",
+    ("Divide the input among the threads by 'files' or\n"
+     "\tby 'blocks' of records within each file. Def. files"),
+    ("Divide the input by blocks and write the records in\n"
+     "\tthe order they were read. Def. No"),
 #endif
     ("Write at most this many records to\n"
      "\tthe pass-destination; 0 for all.  Def. 0"),
     ("Write at most this many records to\n"
      "\tthe fail-destination; 0 for all.  Def. 0"),
     "Print names of input files during processing. Def. No",
+    ("Print the order in which the partitioning switches\n"
+     "\tare checked and the rate at which records pass each. Def. No"),
     ("Augment processing with the specified plug-in.\n"
      "\tSwitch may be repeated to load multiple plug-ins. No default"),
     ("Read SiLK flow records from a pipe: 'stdin' or\n"
@@ -311,6 +320,10 @@ appSetup(
     if ((thread_count > 1) && !skPluginIsThreadSafe()) {
         thread_count = 1;
     }
+    /* keeping the order requires splitting the files into blocks */
+    if (keep_order) {
+        thread_blocks = 1;
+    }
 #endif  /* SK_RWFILTER_THREADED */
 
     /* Check that there is one and only one source of input to process */
@@ -461,6 +474,22 @@ appOptionsHandler(
             goto PARSE_ERROR;
         }
         break;
+
+      case OPT_THREAD_SPLIT:
+        if (0 == strcmp(opt_arg, "files")) {
+            thread_blocks = 0;
+        } else if (0 == strcmp(opt_arg, "blocks")) {
+            thread_blocks = 1;
+        } else {
+            skAppPrintErr("Invalid %s '%s': Expected 'files' or 'blocks'",
+                          appOptions[opt_index].name, opt_arg);
+            return 1;
+        }
+        break;
+
+      case OPT_KEEP_ORDER:
+        keep_order = 1;
+        break;
 #endif  /* SK_RWFILTER_THREADED */
 
       case OPT_INPUT_PIPE:
@@ -491,6 +520,10 @@ appOptionsHandler(
         filenames_fp = PRINT_FILENAMES_FH;
         break;
 
+      case OPT_PRINT_FILTER_PLAN:
+        filter_plan_fp = PRINT_FILTER_PLAN_FH;
+        break;
+
       case OPT_PRINT_VOLUME:
         print_volume_stats = 1;
         /* FALLTHROUGH */
@@ -850,6 +883,9 @@ filterSetCheckers(
     int rv;
 
     if (filterGetCheckCount() > 0) {
+        if (filterCompilePlan()) {
+            return -1;
+        }
         checker[count] = (checktype_t (*)(rwRec*))filterCheck;
         ++count;
     }
@@ -11,6 +11,12 @@
 **
 **    Variables/Functions to support having rwfilter spawn multiple
 **    threads to process files.
+**
+**    By default, each thread reads and filters its own input files.
+**    When --thread-split=blocks is given, the main thread reads the
+**    input files and places blocks of records onto a queue, and the
+**    other threads take blocks from the queue and filter them, so a
+**    single large file is processed by all the threads.
 */
 
 #include <silk/silk.h>
@@ -29,14 +35,85 @@ RCSIDENT("$SiLK: rwfilterthread.c 275df62a2e41 2017-01-05 17:30:40Z mthomas $");
  */
 #define THREAD_RECBUF_SIZE   0x10000
 
+/*
+ *    When splitting files into blocks, the number of blocks in the
+ *    block queue for each worker thread.
+ */
+#define THREAD_BLOCKS_PER_WORKER  4
+
 
 typedef struct filter_thread_st {
     rwRec          *recbuf[DESTINATION_TYPES];
+    /* for each destination type, a block writer for each destination
+     * and the destination it writes to.  The thread packs and
+     * compresses its records into the block writers, and the
+     * destination's mutex is only held while the compressed blocks
+     * are written.  The destination is NULL once it has been closed.
+     * 'writer' is NULL when the records are written to the
+     * destination's stream by dumpBuffer(). */
+    skstream_t    **writer[DESTINATION_TYPES];
+    destination_t **writer_dest[DESTINATION_TYPES];
+    int             writer_count[DESTINATION_TYPES];
+    /* the block of records read from the input and their results */
+    rwRec          *block;
+    uint8_t        *result;
+    /* the columns used when checking a block of records */
+    filter_block_t *columns;
     filter_stats_t  stats;
     pthread_t       thread;
     int             rv;
 } filter_thread_t;
 
+/*
+ *    The state of a slot in the block queue.  The reader fills an
+ *    EMPTY slot, which becomes FILLED.  A worker filters a FILLED
+ *    slot; when the order of the records is not being maintained, it
+ *    writes the records and the slot becomes EMPTY.  Otherwise the
+ *    slot becomes DONE until the records in all earlier slots have
+ *    been written.
+ */
+typedef enum filter_slot_state_en {
+    SLOT_EMPTY, SLOT_FILLED, SLOT_DONE
+} filter_slot_state_t;
+
+/*
+ *    A slot in the block queue holding the records read from a file
+ *    and the results of checking them.
+ */
+typedef struct filter_slot_st {
+    rwRec              *block;
+    uint8_t            *result;
+    uint32_t            count;
+    filter_slot_state_t state;
+    /* whether all records in the block fail the checks */
+    unsigned            fail_entire_file :1;
+} filter_slot_t;
+
+/*
+ *    The block queue.  The slots are used in a fixed circular order
+ *    so that the sequence number of a block determines its slot.
+ */
+typedef struct filter_block_queue_st {
+    filter_slot_t      *slot;
+    uint32_t            slot_count;
+    /* sequence number of the next block to be filled by the reader,
+     * taken by a worker, and written when keeping the order */
+    uint64_t            next_fill;
+    uint64_t            next_work;
+    uint64_t            next_emit;
+    /* when keeping the order, the thread whose record buffers and
+     * block writers receive the blocks, and the number of records in
+     * each of its record buffers */
+    filter_thread_t    *order_thread;
+    uint32_t            order_count[DESTINATION_TYPES];
+    pthread_mutex_t     mutex;
+    pthread_cond_t      cond;
+    /* whether a worker is writing the DONE blocks */
+    unsigned            emitting :1;
+    /* whether the reader has finished reading */
+    unsigned            done_reading :1;
+} filter_block_queue_t;
+
 
 /* LOCAL VARIABLE DEFINITIONS */
 
@@ -50,6 +127,9 @@ static pthread_mutex_t dest_mutex[DESTINATION_TYPES];
 /* max number of records the recbuf can hold */
 static const size_t recbuf_max_recs = THREAD_RECBUF_SIZE / sizeof(rwRec);
 
+/* the queue of blocks when splitting files into blocks */
+static filter_block_queue_t block_queue;
+
 
 /* FUNCTION DEFINITIONS */
 
@@ -78,28 +158,162 @@ appHandleSignal(
 
 
 /*
- *  status = dumpBuffer(dest_id, rec_buffer, rec_count);
+ *  recomputeReading();
+ *
+ *    Set 'reading_records' to false if all the output streams have
+ *    been closed.  The caller must not hold any of the 'dest_mutex'
+ *    mutexes.
+ */
+static void
+recomputeReading(
+    void)
+{
+    int num_outs = 0;
+    int i;
+
+    /* deadlock avoidance: lock the mutexes for all destination types,
+     * sum the number of outputs, then free all mutexes in reverse
+     * order. */
+    for (i = 0; i < DESTINATION_TYPES; ++i) {
+        pthread_mutex_lock(&dest_mutex[i]);
+        num_outs += dest_type[i].count;
+    }
+    if (!num_outs) {
+        reading_records = 0;
+    }
+    for (i = DESTINATION_TYPES - 1; i >= 0; --i) {
+        pthread_mutex_unlock(&dest_mutex[i]);
+    }
+}
+
+
+/*
+ *  status = dumpBlocks(thread, dest_id, rec_count, flush);
+ *
+ *    Pack and compress the 'rec_count' records in the record buffer
+ *    of 'thread' for 'dest_id' (PASS, FAIL, ALL) into the block
+ *    writers of 'thread', then write the complete blocks to the
+ *    destinations.  When 'flush' is true, also complete the partial
+ *    block in each block writer.  Only writing the compressed blocks
+ *    requires the destination's mutex.  Return SKSTREAM_OK on
+ *    success, non-zero on error.
+ */
+static int
+dumpBlocks(
+    filter_thread_t    *thread,
+    int                 dest_id,
+    uint32_t            reccount,
+    int                 flush)
+{
+    skstream_t **writer = thread->writer[dest_id];
+    destination_t **writer_dest = thread->writer_dest[dest_id];
+    destination_t *dest;
+    const rwRec *recbuf_pos;
+    const rwRec *end_rec;
+    int recompute_reading = 0;
+    int k;
+    int rv = SKSTREAM_OK;
+
+    /* pack and compress the records without holding the mutex */
+    end_rec = thread->recbuf[dest_id] + reccount;
+    for (k = 0; k < thread->writer_count[dest_id]; ++k) {
+        if (NULL == writer_dest[k]) {
+            continue;
+        }
+        for (recbuf_pos = thread->recbuf[dest_id];
+             recbuf_pos < end_rec;
+             ++recbuf_pos)
+        {
+            rv = skStreamWriteRecord(writer[k], recbuf_pos);
+            if (SKSTREAM_ERROR_IS_FATAL(rv)) {
+                skStreamPrintLastErr(writer[k], rv, &skAppPrintErr);
+                reading_records = 0;
+                return rv;
+            }
+        }
+        if (flush) {
+            rv = skStreamFlush(writer[k]);
+            if (rv) {
+                skStreamPrintLastErr(writer[k], rv, &skAppPrintErr);
+                reading_records = 0;
+                return rv;
+            }
+        }
+    }
+    rv = SKSTREAM_OK;
+
+    pthread_mutex_lock(&dest_mutex[dest_id]);
+
+    for (k = 0; k < thread->writer_count[dest_id]; ++k) {
+        if (NULL == writer_dest[k]) {
+            continue;
+        }
+        /* find the destination; another thread may have closed it */
+        for (dest = dest_type[dest_id].dest_list;
+             dest != NULL && dest != writer_dest[k];
+             dest = dest->next)
+            ;                   /* empty */
+        if (NULL == dest) {
+            skStreamDestroy(&writer[k]);
+            writer_dest[k] = NULL;
+            continue;
+        }
+        rv = skStreamWriteBlocks(dest->stream, writer[k]);
+        if (SKSTREAM_ERROR_IS_FATAL(rv)) {
+            if (skStreamGetLastErrno(dest->stream) == EPIPE) {
+                /* close this stream */
+                closeOneOutput(dest_id, dest);
+                skStreamDestroy(&writer[k]);
+                writer_dest[k] = NULL;
+                recompute_reading = 1;
+            } else {
+                /* print the error and return */
+                skStreamPrintLastErr(dest->stream, rv, &skAppPrintErr);
+                reading_records = 0;
+                goto END;
+            }
+        }
+        rv = SKSTREAM_OK;
+    }
+
+  END:
+    pthread_mutex_unlock(&dest_mutex[dest_id]);
+    if (recompute_reading) {
+        recomputeReading();
+    }
+    return rv;
+}
+
+
+/*
+ *  status = dumpBuffer(thread, dest_id, rec_count);
  *
- *    Write 'rec_count' records from 'rec_buffer' to the destinations
- *    in the global 'dest_type' array indexed by 'dest_id' (PASS,
- *    FAIL, ALL).  Return SKSTREAM_OK on success, non-zero on error.
+ *    Write the 'rec_count' records in the record buffer of 'thread'
+ *    for 'dest_id' (PASS, FAIL, ALL) to the destinations in the
+ *    global 'dest_type' array indexed by 'dest_id'.  When 'thread'
+ *    has block writers for 'dest_id', call dumpBlocks() to write the
+ *    records.  Return SKSTREAM_OK on success, non-zero on error.
  */
 static int
 dumpBuffer(
+    filter_thread_t    *thread,
     int                 dest_id,
-    const rwRec        *recbuf,
     uint32_t            reccount)
 {
     destination_t *dest;
     destination_t *dest_next;
+    const rwRec *recbuf = thread->recbuf[dest_id];
     const rwRec *recbuf_pos;
     const rwRec *end_rec;
     uint64_t total_rec_count;
     int close_after_add = 0;
     int recompute_reading = 0;
-    int i;
     int rv = SKSTREAM_OK;
 
+    if (thread->writer[dest_id]) {
+        return dumpBlocks(thread, dest_id, reccount, 0);
+    }
+
     pthread_mutex_lock(&dest_mutex[dest_id]);
 
     /* list of destinations to get the records */
@@ -151,22 +365,8 @@ dumpBuffer(
     rv = SKSTREAM_OK;
 
     if (recompute_reading) {
-        /* deadlock avoidance: unlock the mutex for this 'dest_id',
-         * then lock the mutexes for all destination types, sum the
-         * number of outputs, then free all mutexes in reverse
-         * order. */
-        int num_outs = 0;
         pthread_mutex_unlock(&dest_mutex[dest_id]);
-        for (i = 0; i < DESTINATION_TYPES; ++i) {
-            pthread_mutex_lock(&dest_mutex[i]);
-            num_outs += dest_type[i].count;
-        }
-        if (!num_outs) {
-            reading_records = 0;
-        }
-        for (i = DESTINATION_TYPES - 1; i >= 0; --i) {
-            pthread_mutex_unlock(&dest_mutex[i]);
-        }
+        recomputeReading();
         return rv;
     }
 
@@ -177,17 +377,241 @@ dumpBuffer(
 
 
 /*
- *  ok = filterFileThreaded(datafile, ipfile_basename, stats, recbuf,reccount);
+ *  status = bufferRecord(thread, dest_id, recbuf_count, rwrec);
  *
- *    This is the actual filtering of the file named 'datafile'.
+ *    Append 'rwrec' to the record buffer of 'thread' for 'dest_id'
+ *    which currently holds 'recbuf_count[dest_id]' records.  When
+ *    the buffer becomes full, write its records to the destinations
+ *    by calling dumpBuffer().  Return SKSTREAM_OK on success,
+ *    non-zero on error.
+ */
+static int
+bufferRecord(
+    filter_thread_t    *thread,
+    int                 dest_id,
+    uint32_t            recbuf_count[],
+    const rwRec        *rwrec)
+{
+    rwRec *recbuf = thread->recbuf[dest_id];
+    int rv = SKSTREAM_OK;
+
+    assert(NULL != recbuf);
+    memcpy(recbuf + recbuf_count[dest_id], rwrec, sizeof(rwRec));
+    ++recbuf_count[dest_id];
+    if (recbuf_count[dest_id] == recbuf_max_recs) {
+        rv = dumpBuffer(thread, dest_id, recbuf_count[dest_id]);
+        recbuf_count[dest_id] = 0;
+    }
+    return rv;
+}
+
+
+/*
+ *  status = emitBlock(stats, thread, recbuf_count, block, result, count);
+ *
+ *    Add the 'count' records in 'block' to the statistics in 'stats'
+ *    and to the record buffers of 'thread' for the destinations that
+ *    the checktype_t values in 'result' select.  'recbuf_count' is
+ *    the current number of records in each record buffer.  Stop once
+ *    'reading_records' becomes false.  Return SKSTREAM_OK on success,
+ *    non-zero on error.
+ */
+static int
+emitBlock(
+    filter_stats_t     *stats,
+    filter_thread_t    *thread,
+    uint32_t            recbuf_count[],
+    const rwRec        *block,
+    const uint8_t      *result,
+    uint32_t            count)
+{
+    const rwRec *rwrec;
+    uint32_t r;
+    int rv = SKSTREAM_OK;
+
+    for (r = 0, rwrec = block; reading_records && r < count; ++r, ++rwrec) {
+        /* increment number of read records */
+        INCR_REC_COUNT(stats->read, rwrec);
+
+        /* the all-dest */
+        if (dest_type[DEST_ALL].count) {
+            rv = bufferRecord(thread, DEST_ALL, recbuf_count, rwrec);
+            if (rv) {
+                return rv;
+            }
+        }
+
+        switch (result[r]) {
+          case RWF_PASS:
+          case RWF_PASS_NOW:
+            /* increment number of record that pass */
+            INCR_REC_COUNT(stats->pass, rwrec);
+
+            /* the pass-dest */
+            if (dest_type[DEST_PASS].count) {
+                rv = bufferRecord(thread, DEST_PASS, recbuf_count, rwrec);
+                if (rv) {
+                    return rv;
+                }
+            }
+            break;
+
+          case RWF_FAIL:
+            /* the fail-dest */
+            if (dest_type[DEST_FAIL].count) {
+                rv = bufferRecord(thread, DEST_FAIL, recbuf_count, rwrec);
+                if (rv) {
+                    return rv;
+                }
+            }
+            break;
+
+          default:
+            break;
+        }
+    }
+
+    return rv;
+}
+
+
+/*
+ *  flushBuffers(thread, recbuf_count);
+ *
+ *    Write the records that remain in the record buffers of 'thread',
+ *    where 'recbuf_count' is the number of records in each buffer,
+ *    and complete the partial block in each of its block writers.
+ */
+static void
+flushBuffers(
+    filter_thread_t    *thread,
+    const uint32_t      recbuf_count[])
+{
+    int i;
+
+    for (i = 0; i < DESTINATION_TYPES; ++i) {
+        if (thread->writer[i]) {
+            dumpBlocks(thread, i, recbuf_count[i], 1);
+        } else if (recbuf_count[i]) {
+            dumpBuffer(thread, i, recbuf_count[i]);
+        }
+    }
+}
+
+
+/*
+ *  ok = createBlockWriters(thread);
+ *
+ *    Create the block writers for 'thread' for each destination type
+ *    that has outputs.  Block writers are not used for a destination
+ *    type that has a limit on the number of records, since the limit
+ *    is checked as the records are written, nor for a destination
+ *    type where an output does not support them; the records for
+ *    those types are written by dumpBuffer().  Return 0 on success,
+ *    or -1 on error.
+ */
+static int
+createBlockWriters(
+    filter_thread_t    *thread)
+{
+    static int warned = 0;
+    destination_t *dest;
+    int i;
+    int k;
+    int rv;
+
+    for (i = 0; i < DESTINATION_TYPES; ++i) {
+        if (0 == dest_type[i].count || dest_type[i].max_records) {
+            continue;
+        }
+        thread->writer[i] = ((skstream_t**)
+                             calloc(dest_type[i].count, sizeof(skstream_t*)));
+        thread->writer_dest[i] = ((destination_t**)
+                                  calloc(dest_type[i].count,
+                                         sizeof(destination_t*)));
+        if (NULL == thread->writer[i] || NULL == thread->writer_dest[i]) {
+            skAppPrintOutOfMemory("block writers");
+            return -1;
+        }
+        thread->writer_count[i] = dest_type[i].count;
+        for (k = 0, dest = dest_type[i].dest_list;
+             dest != NULL;
+             ++k, dest = dest->next)
+        {
+            rv = skStreamCreateBlockWriter(&thread->writer[i][k],
+                                           dest->stream);
+            if (SKSTREAM_ERR_UNSUPPORT_IOMODE == rv) {
+                /* write this destination type a record at a time */
+                if (!warned) {
+                    warned = 1;
+                    skAppPrintErr(("Warning: Output '%s' is unbuffered;"
+                                   " records are not compressed in"
+                                   " parallel"),
+                                  skStreamGetPathname(dest->stream));
+                }
+                for (k = 0; k < thread->writer_count[i]; ++k) {
+                    skStreamDestroy(&thread->writer[i][k]);
+                }
+                free(thread->writer[i]);
+                thread->writer[i] = NULL;
+                free(thread->writer_dest[i]);
+                thread->writer_dest[i] = NULL;
+                thread->writer_count[i] = 0;
+                break;
+            }
+            if (rv) {
+                skStreamPrintLastErr(dest->stream, rv, &skAppPrintErr);
+                return -1;
+            }
+            thread->writer_dest[i][k] = dest;
+        }
+    }
+    return 0;
+}
+
+
+/*
+ *  destroyBlockWriters(thread);
+ *
+ *    Destroy the block writers for 'thread'.
+ */
+static void
+destroyBlockWriters(
+    filter_thread_t    *thread)
+{
+    int i;
+    int k;
+
+    for (i = 0; i < DESTINATION_TYPES; ++i) {
+        if (thread->writer[i]) {
+            for (k = 0; k < thread->writer_count[i]; ++k) {
+                skStreamDestroy(&thread->writer[i][k]);
+            }
+            free(thread->writer[i]);
+            thread->writer[i] = NULL;
+        }
+        if (thread->writer_dest[i]) {
+            free(thread->writer_dest[i]);
+            thread->writer_dest[i] = NULL;
+        }
+        thread->writer_count[i] = 0;
+    }
+}
+
+
+/*
+ *  ok = filterFileThreaded(datafile, ipfile_basename, thread, reccount);
+ *
+ *    This is the actual filtering of the file named 'datafile' by the
+ *    thread whose data is in 'thread'.
  *    The 'ipfile_basename' parameter is passed to filterCheckFile();
  *    it should be NULL or contain the full-path (minus extension) of the
  *    file that contains Bloom filter or IPset information about the
  *    'datafile'.  The function returns 0 on success; or 1 if the
  *    input file could not be opened.
  *
- *    'recbuf' contains pointers to DESTINATION_TYPES number of record
- *    buffers.  A record buffer may be NULL if that output was not
+ *    'thread->recbuf' contains pointers to DESTINATION_TYPES number
+ *    of record buffers.  A record buffer may be NULL if that output was not
  *    requested to that dest_id.  'reccount' is the current number of
  *    records in each record buffer.  Records that PASS or FAIL the
  *    checks are written into the appropriate record buffer.  When the
@@ -198,18 +622,15 @@ static int
 filterFileThreaded(
     const char         *datafile,
     const char         *ipfile_basename,
-    filter_stats_t     *stats,
-    rwRec              *recbuf[],
+    filter_thread_t    *thread,
     uint32_t            recbuf_count[])
 {
-    rwRec rwrec;
+    filter_stats_t *stats = &thread->stats;
+    uint32_t count;
     skstream_t *in_stream;
-    int i;
     int fail_entire_file = 0;
-    int result = RWF_PASS;
     int rv = SKSTREAM_OK;
     int in_rv = SKSTREAM_OK;
-    rwRec *recbuf_pos[DESTINATION_TYPES];
 
     /* nothing to do in dry-run mode but print the file names */
     if (dryrun_fp) {
@@ -221,18 +642,6 @@ filterFileThreaded(
         return 0;
     }
 
-    /* initialize: set each buffer's current record pointer to the
-     * appropriate location */
-    for (i = 0; i < DESTINATION_TYPES; ++i) {
-        if (dest_type[i].count) {
-            assert(NULL != recbuf[i]);
-            recbuf_pos[i] = recbuf[i] + recbuf_count[i];
-        } else {
-            /* not used.  initialize to avoid gcc warning. */
-            recbuf_pos[i] = NULL;
-        }
-    }
-
     /* print filenames if requested */
     if (filenames_fp) {
         fprintf(filenames_fp, "%s\n", datafile);
@@ -250,7 +659,6 @@ filterFileThreaded(
     if (filterCheckFile(in_stream, ipfile_basename) == 1) {
         /* all records in the file will fail the user's tests */
         fail_entire_file = 1;
-        result = RWF_FAIL;
 
         /* determine if we can more efficiently handle the file */
         if ((dest_type[DEST_ALL].count == 0)
@@ -273,87 +681,36 @@ filterFileThreaded(
             /* else computing volume stats, and we need to read each
              * record to get its byte and packet counts. */
         }
+    } else {
+        /* use the file's block index to skip blocks of records that
+         * will fail the user's tests */
+        filterSkipBlocks(in_stream, &stats->read.flows);
     }
 
-    /* read and process each record */
-    while (reading_records
-           && (SKSTREAM_OK == (in_rv = skStreamReadRecord(in_stream, &rwrec))))
-    {
-        /* increment number of read records */
-        INCR_REC_COUNT(stats->read, &rwrec);
-
-        /* the all-dest */
-        if (dest_type[DEST_ALL].count) {
-            memcpy(recbuf_pos[DEST_ALL], &rwrec, sizeof(rwRec));
-            ++recbuf_pos[DEST_ALL];
-            ++recbuf_count[DEST_ALL];
-            if (recbuf_count[DEST_ALL] == recbuf_max_recs) {
-                rv = dumpBuffer(DEST_ALL, recbuf[DEST_ALL],
-                                recbuf_count[DEST_ALL]);
-                if (rv) {
-                    goto END;
-                }
-                recbuf_pos[DEST_ALL] = recbuf[DEST_ALL];
-                recbuf_count[DEST_ALL] = 0;
-            }
+    /* read and process the records a block at a time */
+    while (reading_records) {
+        in_rv = filterReadBlock(in_stream, thread->block, &count);
+        if (0 == count) {
+            break;
         }
 
-        if (!fail_entire_file) {
-            /* run all checker()'s until end or one doesn't pass */
-            for (i=0, result=RWF_PASS;
-                 i < checker_count && result == RWF_PASS;
-                 ++i)
-            {
-                result = (*(checker[i]))(&rwrec);
-            }
+        /* run all checker()'s on the block */
+        if (fail_entire_file) {
+            memset(thread->result, RWF_FAIL, count);
+        } else {
+            filterRunCheckers(thread->block, count, thread->result,
+                              thread->columns);
         }
 
-        switch (result) {
-          case RWF_PASS:
-          case RWF_PASS_NOW:
-            /* increment number of record that pass */
-            INCR_REC_COUNT(stats->pass, &rwrec);
-
-            /* the pass-dest */
-            if (dest_type[DEST_PASS].count) {
-                memcpy(recbuf_pos[DEST_PASS], &rwrec, sizeof(rwRec));
-                ++recbuf_pos[DEST_PASS];
-                ++recbuf_count[DEST_PASS];
-                if (recbuf_count[DEST_PASS] == recbuf_max_recs) {
-                    rv = dumpBuffer(DEST_PASS, recbuf[DEST_PASS],
-                                    recbuf_count[DEST_PASS]);
-                    if (rv) {
-                        goto END;
-                    }
-                    recbuf_pos[DEST_PASS] = recbuf[DEST_PASS];
-                    recbuf_count[DEST_PASS] = 0;
-                }
-            }
-            break;
-
-          case RWF_FAIL:
-            /* the fail-dest */
-            if (dest_type[DEST_FAIL].count) {
-                memcpy(recbuf_pos[DEST_FAIL], &rwrec, sizeof(rwRec));
-                ++recbuf_pos[DEST_FAIL];
-                ++recbuf_count[DEST_FAIL];
-                if (recbuf_count[DEST_FAIL] == recbuf_max_recs) {
-                    rv = dumpBuffer(DEST_FAIL, recbuf[DEST_FAIL],
-                                    recbuf_count[DEST_FAIL]);
-                    if (rv) {
-                        goto END;
-                    }
-                    recbuf_pos[DEST_FAIL] = recbuf[DEST_FAIL];
-                    recbuf_count[DEST_FAIL] = 0;
-                }
-            }
-            break;
-
-          default:
+        rv = emitBlock(stats, thread, recbuf_count,
+                       thread->block, thread->result, count);
+        if (rv) {
+            goto END;
+        }
+        if (in_rv) {
             break;
         }
-
-    } /* while (reading_records && skStreamReadRecord()) */
+    } /* while (reading_records) */
 
   END:
     if (in_rv == SKSTREAM_OK || in_rv == SKSTREAM_ERR_EOF) {
@@ -441,12 +798,9 @@ static void *
 workerThread(
     void               *v_thread)
 {
-    filter_stats_t *stats = &(((filter_thread_t*)v_thread)->stats);
-    rwRec **recbuf = ((filter_thread_t*)v_thread)->recbuf;
     uint32_t recbuf_count[DESTINATION_TYPES];
     char datafile[PATH_MAX];
     int rv = 0;
-    int i;
 
     /* ignore all signals unless this thread is the main thread */
     if (!pthread_equal(main_thread, ((filter_thread_t*)v_thread)->thread)) {
@@ -458,7 +812,8 @@ workerThread(
     ((filter_thread_t*)v_thread)->rv = 0;
 
     while (nextInputThreaded(datafile, sizeof(datafile)) != NULL) {
-        rv = filterFileThreaded(datafile, NULL, stats, recbuf, recbuf_count);
+        rv = filterFileThreaded(datafile, NULL, (filter_thread_t*)v_thread,
+                                recbuf_count);
         if (rv < 0) {
             /* fatal error */
             ((filter_thread_t*)v_thread)->rv = rv;
@@ -468,12 +823,316 @@ workerThread(
     }
 
     /* dump any records still in the buffers */
-    for (i = 0; i < DESTINATION_TYPES; ++i) {
-        if (recbuf_count[i]) {
-            dumpBuffer(i, recbuf[i], recbuf_count[i]);
+    flushBuffers((filter_thread_t*)v_thread, recbuf_count);
+
+    return NULL;
+}
+
+
+/*
+ *  ok = blockQueueCreate(order_thread);
+ *
+ *    Initialize the block queue used when splitting files into
+ *    blocks.  'order_thread' is the thread whose record buffers
+ *    receive the records when keeping the order of the records.
+ *    Return 0 on success, or -1 on allocation error.
+ */
+static int
+blockQueueCreate(
+    filter_thread_t    *order_thread)
+{
+    uint32_t i;
+
+    memset(&block_queue, 0, sizeof(block_queue));
+    pthread_mutex_init(&block_queue.mutex, NULL);
+    pthread_cond_init(&block_queue.cond, NULL);
+    block_queue.order_thread = order_thread;
+
+    block_queue.slot_count = THREAD_BLOCKS_PER_WORKER * (thread_count - 1);
+    block_queue.slot = (filter_slot_t*)calloc(block_queue.slot_count,
+                                              sizeof(filter_slot_t));
+    if (NULL == block_queue.slot) {
+        return -1;
+    }
+    for (i = 0; i < block_queue.slot_count; ++i) {
+        block_queue.slot[i].block
+            = (rwRec*)malloc(FILTER_BLOCK_SIZE * sizeof(rwRec));
+        block_queue.slot[i].result = (uint8_t*)malloc(FILTER_BLOCK_SIZE);
+        if (NULL == block_queue.slot[i].block
+            || NULL == block_queue.slot[i].result)
+        {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+
+/*
+ *  blockQueueDestroy();
+ *
+ *    Free the memory used by the block queue.
+ */
+static void
+blockQueueDestroy(
+    void)
+{
+    uint32_t i;
+
+    if (0 == block_queue.slot_count) {
+        /* queue was never created */
+        return;
+    }
+    if (block_queue.slot) {
+        for (i = 0; i < block_queue.slot_count; ++i) {
+            free(block_queue.slot[i].block);
+            free(block_queue.slot[i].result);
         }
+        free(block_queue.slot);
+        block_queue.slot = NULL;
+    }
+    pthread_cond_destroy(&block_queue.cond);
+    pthread_mutex_destroy(&block_queue.mutex);
+}
+
+
+/*
+ *  ok = readFileBlocks(datafile, stats);
+ *
+ *    Read the records from the file named 'datafile' and add them to
+ *    the block queue for the worker threads to filter.  Update the
+ *    number of files in 'stats'.  This is the counterpart to
+ *    filterFileThreaded() when splitting files into blocks.  The
+ *    function returns 0 on success; or 1 if the input file could not
+ *    be opened or read.
+ */
+static int
+readFileBlocks(
+    const char         *datafile,
+    filter_stats_t     *stats)
+{
+    filter_slot_t *slot;
+    skstream_t *in_stream;
+    int fail_entire_file = 0;
+    int in_rv = SKSTREAM_OK;
+
+    /* nothing to do in dry-run mode but print the file names */
+    if (dryrun_fp) {
+        fprintf(dryrun_fp, "%s\n", datafile);
+        return 0;
+    }
+
+    /* print filenames if requested */
+    if (filenames_fp) {
+        fprintf(filenames_fp, "%s\n", datafile);
     }
 
+    /* open the input file */
+    in_rv = skStreamOpenSilkFlow(&in_stream, datafile, SK_IO_READ);
+    if (in_rv) {
+        goto END;
+    }
+
+    ++stats->files;
+
+    /* determine if all the records in the file will fail the checks */
+    if (filterCheckFile(in_stream, NULL) == 1) {
+        /* all records in the file will fail the user's tests */
+        fail_entire_file = 1;
+
+        /* determine if we can more efficiently handle the file */
+        if ((dest_type[DEST_ALL].count == 0)
+            && (dest_type[DEST_FAIL].count == 0))
+        {
+            /* no output is being generated for these records */
+            if (print_stat == NULL) {
+                goto END;
+            }
+            if (print_volume_stats == 0) {
+                size_t skipped = 0;
+                in_rv = skStreamSkipRecords(in_stream, SIZE_MAX, &skipped);
+                stats->read.flows += skipped;
+                goto END;
+            }
+        }
+    } else {
+        filterSkipBlocks(in_stream, &stats->read.flows);
+    }
+
+    while (reading_records) {
+        /* wait for the next slot to become empty */
+        pthread_mutex_lock(&block_queue.mutex);
+        slot = &block_queue.slot[block_queue.next_fill
+                                 % block_queue.slot_count];
+        while (SLOT_EMPTY != slot->state && reading_records) {
+            pthread_cond_wait(&block_queue.cond, &block_queue.mutex);
+        }
+        pthread_mutex_unlock(&block_queue.mutex);
+        if (!reading_records) {
+            break;
+        }
+
+        /* the slot is not visible to the workers until next_fill is
+         * incremented, so it may be filled without holding the
+         * mutex */
+        in_rv = filterReadBlock(in_stream, slot->block, &slot->count);
+        if (slot->count) {
+            slot->fail_entire_file = fail_entire_file;
+            pthread_mutex_lock(&block_queue.mutex);
+            slot->state = SLOT_FILLED;
+            ++block_queue.next_fill;
+            pthread_cond_broadcast(&block_queue.cond);
+            pthread_mutex_unlock(&block_queue.mutex);
+        }
+        if (in_rv) {
+            break;
+        }
+    }
+
+  END:
+    if (in_rv == SKSTREAM_OK || in_rv == SKSTREAM_ERR_EOF) {
+        in_rv = 0;
+    } else {
+        skStreamPrintLastErr(in_stream, in_rv, &skAppPrintErr);
+        in_rv = 1;
+    }
+
+    /* close input */
+    skStreamDestroy(&in_stream);
+
+    return in_rv;
+}
+
+
+/*
+ *  blockReader(&filter_thread_data);
+ *
+ *    Read each input file and add its records to the block queue.
+ *    Once all files have been read, tell the worker threads there
+ *    are no more blocks.  This is run by the main thread when
+ *    splitting files into blocks.
+ */
+static void
+blockReader(
+    filter_thread_t    *reader)
+{
+    char datafile[PATH_MAX];
+
+    reader->rv = 0;
+
+    while (reading_records
+           && appNextInput(datafile, sizeof(datafile)) != NULL)
+    {
+        /* ignore errors opening/reading input */
+        readFileBlocks(datafile, &reader->stats);
+    }
+
+    pthread_mutex_lock(&block_queue.mutex);
+    block_queue.done_reading = 1;
+    pthread_cond_broadcast(&block_queue.cond);
+    pthread_mutex_unlock(&block_queue.mutex);
+}
+
+
+/*
+ *  blockWorkerThread(&filter_thread_data);
+ *
+ *    THREAD ENTRY POINT.
+ *
+ *    Takes the next block from the block queue, checks its records,
+ *    and writes them.  When keeping the order of the records, the
+ *    records are written only once the blocks before them have been
+ *    written; whichever thread finds the next block to write writes
+ *    it along with any DONE blocks that follow it.  Stops when the
+ *    reader has finished and the queue is empty.
+ */
+static void *
+blockWorkerThread(
+    void               *v_thread)
+{
+    filter_thread_t *thread = (filter_thread_t*)v_thread;
+    uint32_t recbuf_count[DESTINATION_TYPES];
+    filter_slot_t *slot;
+    int rv;
+
+    skthread_ignore_signals();
+
+    memset(recbuf_count, 0, sizeof(recbuf_count));
+
+    thread->rv = 0;
+
+    pthread_mutex_lock(&block_queue.mutex);
+    for (;;) {
+        while (block_queue.next_work == block_queue.next_fill
+               && !block_queue.done_reading)
+        {
+            pthread_cond_wait(&block_queue.cond, &block_queue.mutex);
+        }
+        if (block_queue.next_work == block_queue.next_fill) {
+            /* reader is done and the queue is empty */
+            break;
+        }
+        slot = &block_queue.slot[block_queue.next_work
+                                 % block_queue.slot_count];
+        ++block_queue.next_work;
+        pthread_mutex_unlock(&block_queue.mutex);
+
+        /* run all checker()'s on the block */
+        if (slot->fail_entire_file) {
+            memset(slot->result, RWF_FAIL, slot->count);
+        } else {
+            filterRunCheckers(slot->block, slot->count, slot->result,
+                              thread->columns);
+        }
+
+        if (!keep_order) {
+            rv = emitBlock(&thread->stats, thread, recbuf_count,
+                           slot->block, slot->result, slot->count);
+            if (rv) {
+                /* fatal error; stop reading but continue to drain the
+                 * queue so the reader does not block */
+                thread->rv = -1;
+                reading_records = 0;
+            }
+            pthread_mutex_lock(&block_queue.mutex);
+            slot->state = SLOT_EMPTY;
+            pthread_cond_broadcast(&block_queue.cond);
+            continue;
+        }
+
+        pthread_mutex_lock(&block_queue.mutex);
+        slot->state = SLOT_DONE;
+        if (block_queue.emitting) {
+            /* another thread will write this block */
+            continue;
+        }
+        block_queue.emitting = 1;
+        for (;;) {
+            slot = &block_queue.slot[block_queue.next_emit
+                                     % block_queue.slot_count];
+            if (SLOT_DONE != slot->state) {
+                break;
+            }
+            pthread_mutex_unlock(&block_queue.mutex);
+            rv = emitBlock(&thread->stats, block_queue.order_thread,
+                           block_queue.order_count,
+                           slot->block, slot->result, slot->count);
+            if (rv) {
+                thread->rv = -1;
+                reading_records = 0;
+            }
+            pthread_mutex_lock(&block_queue.mutex);
+            slot->state = SLOT_EMPTY;
+            ++block_queue.next_emit;
+            pthread_cond_broadcast(&block_queue.cond);
+        }
+        block_queue.emitting = 0;
+    }
+    pthread_mutex_unlock(&block_queue.mutex);
+
+    /* dump any records still in the buffers */
+    flushBuffers(thread, recbuf_count);
+
     return NULL;
 }
 
@@ -484,7 +1143,9 @@ workerThread(
  *    The "main" to use when rwfilter is used with threads.
  *
  *    Creates necessary data structures and then creates threads to
- *    process input files.  Once all input files have been processed,
+ *    process input files.  When splitting files into blocks, the main
+ *    thread reads the files and the other threads filter the blocks.
+ *    Once all input files have been processed,
  *    combines results from all threads to fill in the statistics
  *    structure 'stats'.  Returns 0 on success, non-zero on error.
  */
@@ -530,16 +1191,58 @@ threadedFilter(
         }
     }
 
+    for (j = 0; j < thread_count; ++j) {
+        if (createBlockWriters(&thread[j])) {
+            rv = -1;
+            goto END;
+        }
+        thread[j].columns = filterBlockCreate();
+        if (NULL == thread[j].columns) {
+            skAppPrintOutOfMemory("filter block");
+            rv = -1;
+            goto END;
+        }
+    }
+
     /* thread[0] is the main_thread */
     thread[0].thread = main_thread;
 
-    /* create the threads, skip 0 since that is the main thread */
-    for (j = 1; j < thread_count; ++j) {
-        pthread_create(&thread[j].thread, NULL, &workerThread, &thread[j]);
-    }
+    if (thread_blocks) {
+        /* the main thread is the reader and does not use its record
+         * buffers, so they receive the records when keeping order */
+        if (blockQueueCreate(&thread[0])) {
+            skAppPrintOutOfMemory("block queue");
+            rv = -1;
+            goto END;
+        }
+
+        /* create the threads, skip 0 since that is the main thread */
+        for (j = 1; j < thread_count; ++j) {
+            pthread_create(&thread[j].thread, NULL, &blockWorkerThread,
+                           &thread[j]);
+        }
 
-    /* allow the main thread to also process files */
-    workerThread(&thread[0]);
+        /* the main thread reads the files */
+        blockReader(&thread[0]);
+    } else {
+        for (j = 0; j < thread_count; ++j) {
+            thread[j].block
+                = (rwRec*)malloc(FILTER_BLOCK_SIZE * sizeof(rwRec));
+            thread[j].result = (uint8_t*)malloc(FILTER_BLOCK_SIZE);
+            if (NULL == thread[j].block || NULL == thread[j].result) {
+                goto END;
+            }
+        }
+
+        /* create the threads, skip 0 since that is the main thread */
+        for (j = 1; j < thread_count; ++j) {
+            pthread_create(&thread[j].thread, NULL, &workerThread,
+                           &thread[j]);
+        }
+
+        /* allow the main thread to also process files */
+        workerThread(&thread[0]);
+    }
 
     /* join with the threads as they die off */
     for (j = 0; j < thread_count; ++j) {
@@ -563,7 +1266,15 @@ threadedFilter(
 #endif
     }
 
+    if (thread_blocks) {
+        /* dump the records written in order */
+        flushBuffers(&thread[0], block_queue.order_count);
+    }
+
   END:
+    if (thread_blocks) {
+        blockQueueDestroy();
+    }
     if (thread) {
         for (i = 0; i < DESTINATION_TYPES; ++i) {
             for (j = 0; j < thread_count; ++j) {
@@ -572,6 +1283,12 @@ threadedFilter(
                 }
             }
         }
+        for (j = 0; j < thread_count; ++j) {
+            free(thread[j].block);
+            free(thread[j].result);
+            filterBlockDestroy(thread[j].columns);
+            destroyBlockWriters(&thread[j]);
+        }
         free(thread);
     }
 
@@ -0,0 +1,70 @@
+#! /usr/bin/perl -w
+#
+#
+# RCSIDENT("$SiLK: rwfilter-block-index.pl $")
+#
+#  Write a time-sorted file with a block index, verify that the index
+#  is present, and verify that rwfilter skips blocks using the index
+#  while producing the same records as a filter of the unindexed data.
+
+use strict;
+use SiLKTests;
+
+my $NAME = $0;
+$NAME =~ s,.*/,,;
+
+my $rwfilter = check_silk_app('rwfilter');
+my $rwsort = check_silk_app('rwsort');
+my $rwcut = check_silk_app('rwcut');
+my $rwfileinfo = check_silk_app('rwfileinfo');
+my %file;
+$file{data} = get_data_or_exit77('data');
+skip_test('No zlib support') unless $SiLKTests::SK_ENABLE_ZLIB;
+my %temp;
+$temp{sorted} = make_tempname('sorted');
+
+my $filter = "--stime=2009/02/14:10-2009/02/14:11 --proto=6";
+my $md5 = "e5f637bb33c94bc7147e6766f115c18e";
+
+# write the sorted file with a block index
+my $cmd = ("SILK_BLOCK_INDEX=1 $rwsort --fields=stime"
+           ." --compression-method=zlib --output-path=$temp{sorted}"
+           ." $file{data}");
+check_exit_status($cmd)
+    or die "$NAME: Failed to create indexed file\n";
+
+# the file must have the block-index header entry
+my $has_index = 0;
+$cmd = "$rwfileinfo --fields=block-index $temp{sorted}";
+run_command($cmd, sub {
+    my ($io) = @_;
+    while (<$io>) {
+        $has_index = 1 if /^\s*block-index\s+v\d+/;
+    }
+});
+die "$NAME: No block-index entry reported by '$cmd'\n"
+    unless $has_index;
+
+# the filter must skip some, but not all, of the blocks
+my ($skipped, $total);
+$cmd = ("SILK_BLOCK_INDEX_DEBUG=1 $rwfilter $filter --print-stat"
+        ." $temp{sorted} 2>&1");
+run_command($cmd, sub {
+    my ($io) = @_;
+    while (<$io>) {
+        if (/Skipped (\d+) of (\d+) blocks/) {
+            ($skipped, $total) = ($1, $2);
+        }
+    }
+});
+die "$NAME: No block index report from '$cmd'\n"
+    unless defined $skipped;
+die "$NAME: Expected some of $total blocks to be skipped; got $skipped\n"
+    unless ($skipped > 0 && $skipped < $total);
+
+# the indexed file and the original data must give the same records
+check_md5_output($md5, ("$rwfilter $filter --pass=stdout $temp{sorted}"
+                        ." | $rwcut --fields=1-10 --ipv6-policy=ignore"));
+check_md5_output($md5, ("$rwfilter $filter --pass=stdout $file{data}"
+                        ." | $rwsort --fields=stime"
+                        ." | $rwcut --fields=1-10 --ipv6-policy=ignore"));
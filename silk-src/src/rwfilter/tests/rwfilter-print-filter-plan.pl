@@ -0,0 +1,14 @@
+#! /usr/bin/perl -w
+# MD5: a3f85f4a0c2d6179de42b3d3766de576
+# TEST: ./rwfilter --proto=6,17 --dport=25,53 --sport=0-1023 --print-filter-plan --pass=/dev/null ../../tests/data.rwf 2>&1
+
+use strict;
+use SiLKTests;
+
+my $rwfilter = check_silk_app('rwfilter');
+my %file;
+$file{data} = get_data_or_exit77('data');
+my $cmd = "$rwfilter --proto=6,17 --dport=25,53 --sport=0-1023 --print-filter-plan --pass=/dev/null $file{data} 2>&1";
+my $md5 = "a3f85f4a0c2d6179de42b3d3766de576";
+
+check_md5_output($md5, $cmd);
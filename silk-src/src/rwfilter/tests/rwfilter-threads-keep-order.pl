@@ -0,0 +1,15 @@
+#! /usr/bin/perl -w
+# MD5: dc2f178253d90c4e44dcffe0ebd5c0a3
+# TEST: ./rwfilter --threads=4 --keep-order --proto=17 --dport=53 --pass=stdout ../../tests/data.rwf ../../tests/data.rwf | ../rwcut/rwcut --fields=1-5,stime --timestamp-format=epoch --delimited --no-titles
+
+use strict;
+use SiLKTests;
+
+my $rwfilter = check_silk_app('rwfilter');
+my $rwcut = check_silk_app('rwcut');
+my %file;
+$file{data} = get_data_or_exit77('data');
+my $cmd = "$rwfilter --threads=4 --keep-order --proto=17 --dport=53 --pass=stdout $file{data} $file{data} | $rwcut --fields=1-5,stime --timestamp-format=epoch --delimited --no-titles";
+my $md5 = "dc2f178253d90c4e44dcffe0ebd5c0a3";
+
+check_md5_output($md5, $cmd);
@@ -95,6 +95,17 @@ RCSIDENT("$SiLK: rwflowpack.c 4ba08a73ecbf 2017-05-05 22:05:45Z mthomas $");
 #include "rwflowpack_priv.h"
 #include "stream-cache.h"
 
+/* The --pack-threads switch requires C11 atomics */
+#if defined(SK_HAVE_STDATOMIC_H) && !defined(__STDC_NO_ATOMICS__)
+#include <stdatomic.h>
+#include <sched.h>
+#define PACK_THREADS_ENABLED 1
+#define PACK_THREADS_ACTIVE  (NULL != pack_threads)
+#else
+#define PACK_THREADS_ENABLED 0
+#define PACK_THREADS_ACTIVE  0
+#endif
+
 /* use TRACEMSG_LEVEL as our tracing variable */
 #define TRACEMSG(lvl, msg) TRACEMSG_TO_TRACEMSGLVL(lvl, msg)
 #include <silk/sktracemsg.h>
@@ -133,6 +144,21 @@ RCSIDENT("$SiLK: rwflowpack.c 4ba08a73ecbf 2017-05-05 22:05:45Z mthomas $");
 #define STREAM_CACHE_SIZE 128
 #define STREAM_CACHE_MIN  4
 
+#if PACK_THREADS_ENABLED
+/* The maximum number of packing threads that --pack-threads accepts */
+#define PACK_THREADS_MAX  64
+
+/* The number of records the queue of each packing thread holds.  Must
+ * be a power of 2. */
+#define PACK_QUEUE_SIZE  8192
+
+/* While waiting on a packing thread's queue, the number of times to
+ * yield the CPU before sleeping, and the length of each sleep in
+ * nanoseconds. */
+#define PACK_WAIT_YIELDS  64
+#define PACK_WAIT_NSEC    250000
+#endif  /* PACK_THREADS_ENABLED */
+
 /* These next two values are used when rwflowpack is using probes that
  * poll directories, and they specify fractions of the
  * stream_cache_size.
@@ -215,6 +241,51 @@ typedef enum {
     _INPUT_MODE_TYPE_MAX_
 } input_mode_type_id_t;
 
+#if PACK_THREADS_ENABLED
+/*
+ *    pack_slot_t is one entry in the queue of a packing thread.  The
+ *    'seq' member tells whether the slot is free or holds a record;
+ *    see packThreadEnqueue().
+ */
+typedef struct pack_slot_st {
+    atomic_size_t       seq;
+    const skpc_probe_t *probe;
+    rwRec               rwrec;
+} pack_slot_t;
+
+/*
+ *    pack_thread_t is a thread that writes records when --pack-threads
+ *    is greater than 1.  Each packing thread owns a stream cache, and
+ *    packRecord() gives each record to the thread chosen by the
+ *    record's (flowtype, sensor, hour) key, so each output file is
+ *    written by a single thread.
+ *
+ *    The reader threads hand records to the packing thread through
+ *    'queue', a bounded ring that many threads may add to and one
+ *    thread removes from without taking a lock.
+ */
+typedef struct pack_thread_st {
+    /* the ring of PACK_QUEUE_SIZE slots */
+    pack_slot_t        *queue;
+    /* the files that this thread writes */
+    stream_cache_t     *cache;
+    /* the position at which the readers add the next record */
+    atomic_size_t       enqueue_pos;
+    /* the number of records the thread has removed and written */
+    atomic_size_t       done_pos;
+    /* set to tell the thread to exit once its queue is empty */
+    atomic_int          stop;
+    /* set by the thread when it exits on a fatal error */
+    atomic_int          failed;
+    /* statistics; written only by this thread */
+    uint64_t            rec_count_total;
+    uint64_t            rec_count_bad;
+    pthread_t           thread;
+    unsigned int        id;
+    unsigned int        running;
+} pack_thread_t;
+#endif  /* PACK_THREADS_ENABLED */
+
 
 /* LOCAL VARIABLES */
 
@@ -307,6 +378,17 @@ static stream_cache_t *stream_cache;
  * --file-cache-size switch. */
 static uint32_t stream_cache_size = STREAM_CACHE_SIZE;
 
+/* Number of threads that write the packed records.  When 1, each
+ * reader thread writes its own records to 'stream_cache'; otherwise
+ * each thread in 'pack_threads' writes to its own stream cache.  Can
+ * be modified by the --pack-threads switch. */
+static uint32_t pack_thread_count = 1;
+
+#if PACK_THREADS_ENABLED
+/* The packing threads when pack_thread_count is greater than 1 */
+static pack_thread_t *pack_threads = NULL;
+#endif
+
 /* Maximum number of input file handles and the number remaining.
  * They are computed as a fraction of the stream_cache_size.  */
 static int input_filehandles_max;
@@ -428,6 +510,9 @@ typedef enum {
     OPT_NO_FILE_LOCKING,
     OPT_FLUSH_TIMEOUT,
     OPT_STREAM_CACHE_SIZE,
+#if PACK_THREADS_ENABLED
+    OPT_PACK_THREADS,
+#endif
     OPT_PACK_INTERFACES, OPT_BYTE_ORDER,
     OPT_ERROR_DIRECTORY,
     OPT_ARCHIVE_DIRECTORY, OPT_FLAT_ARCHIVE, OPT_POST_ARCHIVE_COMMAND,
@@ -449,6 +534,9 @@ static struct option appOptions[] = {
     {"no-file-locking",         NO_ARG,       0, OPT_NO_FILE_LOCKING},
     {"flush-timeout",           REQUIRED_ARG, 0, OPT_FLUSH_TIMEOUT},
     {"file-cache-size",         REQUIRED_ARG, 0, OPT_STREAM_CACHE_SIZE},
+#if PACK_THREADS_ENABLED
+    {"pack-threads",            REQUIRED_ARG, 0, OPT_PACK_THREADS},
+#endif
     {"pack-interfaces",         NO_ARG,       0, OPT_PACK_INTERFACES},
     {"byte-order",              REQUIRED_ARG, 0, OPT_BYTE_ORDER},
 
@@ -487,6 +575,11 @@ static const char *appHelp[] = {
      "\tSiLK Flow files to disk"),
     ("Maximum number of SiLK Flow files to have open for\n"
      "\twriting simultaneously"),
+#if PACK_THREADS_ENABLED
+    ("Number of threads that write packed records.  When\n"
+     "\tgreater than 1, each thread owns a share of the output files and\n"
+     "\tof the file-cache-size"),
+#endif
     ("Include SNMP interface indexes in packed records\n"
      "\t(useful for debugging the router configuration). Def. No"),
     ("Byte order to use for newly packed files:\n"
@@ -550,6 +643,9 @@ static int  validateOptions(opt_cache_t *ocache, size_t arg_count);
 static int  flowpackSetMaximumFileHandles(int new_max_fh);
 static int  startAllProcessors(void);
 static void stopAllProcessors(void);
+static void stopPackThreads(void);
+static int  cacheFlushOrCloseAll(int close_all, cache_file_iter_t **iter);
+static void destroyStreamCaches(void);
 static void printReaderStats(void);
 static int  getProbes(sk_vector_t *probe_vec);
 static int  createFlowProcessorsFlowcap(void);
@@ -629,6 +725,13 @@ appUsageLong(
                     UINT16_MAX, STREAM_CACHE_SIZE);
             break;
 
+#if PACK_THREADS_ENABLED
+          case OPT_PACK_THREADS:
+            fprintf(fh, "%s. Range 1-%d. Def. 1",
+                    appHelp[i], PACK_THREADS_MAX);
+            break;
+#endif
+
           case OPT_INPUT_MODE:
             fprintf(fh, "%s\n\tChoices: %s",
                     appHelp[i], available_modes[0].name);
@@ -777,8 +880,9 @@ appTeardown(
 
     printReaderStats();
     stopAllProcessors();
+    stopPackThreads();
 
-    if (stream_cache) {
+    if (stream_cache || PACK_THREADS_ACTIVE) {
         cache_file_iter_t *iter;
         const char *path;
         uint64_t count;
@@ -787,9 +891,8 @@ appTeardown(
          * open streams.  We're in shutdown, so ignore the return
          * code. */
         INFOMSG("Closing all files...");
-        skCacheCloseAll(stream_cache, &iter);
-        skCacheDestroy(stream_cache);
-        stream_cache = NULL;
+        cacheFlushOrCloseAll(1, &iter);
+        destroyStreamCaches();
 
         if (OUTPUT_INCREMENTAL_FILES == output_mode) {
             /* In incremental-files mode, go ahead and move the files
@@ -1235,6 +1338,16 @@ appOptionsProcessOpt(
         stream_cache_size = (int)opt_val;
         break;
 
+#if PACK_THREADS_ENABLED
+      case OPT_PACK_THREADS:
+        rv = skStringParseUint32(&opt_val, opt_arg, 1, PACK_THREADS_MAX);
+        if (rv) {
+            goto PARSE_ERROR;
+        }
+        pack_thread_count = opt_val;
+        break;
+#endif
+
       case OPT_NETFLOW_FILE:
         if (opt_arg[0] == '\0') {
             skAppPrintErr("Empty %s supplied", appOptions[opt_index].name);
@@ -1457,6 +1570,15 @@ validateOptions(
         options_error = -1;
     }
 
+    /* each packing thread needs a stream cache of a usable size */
+    if (stream_cache_size / pack_thread_count < STREAM_CACHE_MIN) {
+        skAppPrintErr(("The --%s must be at least %d times the"
+                       " number of --%s"),
+                      appOptions[OPT_STREAM_CACHE_SIZE].name,
+                      STREAM_CACHE_MIN, "pack-threads");
+        options_error = -1;
+    }
+
     /* return if we have options problems */
     if (options_error) {
         return -1;
@@ -2028,6 +2150,171 @@ printReaderStats(
             fproc->input_mode_type->print_stats_fn(fproc);
         }
     }
+
+#if PACK_THREADS_ENABLED
+    /* Records with write errors are counted by the packing threads */
+    if (pack_threads) {
+        pack_thread_t *pt;
+
+        for (i = 0; i < pack_thread_count; ++i) {
+            pt = &pack_threads[i];
+            if (pt->rec_count_bad) {
+                INFOMSG(("Packing thread #%u: Wrote %" PRIu64
+                         " recs; %" PRIu64 " bad"),
+                        pt->id, (pt->rec_count_total - pt->rec_count_bad),
+                        pt->rec_count_bad);
+            } else {
+                INFOMSG("Packing thread #%u: Wrote %" PRIu64 " recs",
+                        pt->id, pt->rec_count_total);
+            }
+        }
+    }
+#endif  /* PACK_THREADS_ENABLED */
+}
+
+
+/*
+ *  status = createStreamCaches(open_fn);
+ *
+ *    Create the stream cache that holds the open output files, where
+ *    'open_fn' opens or creates a file.  When --pack-threads is
+ *    greater than 1, instead create the packing threads, each having
+ *    its own queue and a stream cache that holds a share of the
+ *    file-cache-size; startPackThreads() starts them.
+ *
+ *    Return 0 on success, or -1 on failure.
+ */
+static int
+createStreamCaches(
+    cache_open_fn_t     open_fn)
+{
+#if PACK_THREADS_ENABLED
+    pack_thread_t *pt;
+    uint32_t i;
+    size_t j;
+
+    if (pack_thread_count > 1) {
+        pack_threads = ((pack_thread_t*)
+                        calloc(pack_thread_count, sizeof(pack_thread_t)));
+        if (NULL == pack_threads) {
+            return -1;
+        }
+        for (i = 0; i < pack_thread_count; ++i) {
+            pt = &pack_threads[i];
+            pt->id = 1u + i;
+            atomic_init(&pt->enqueue_pos, 0);
+            atomic_init(&pt->done_pos, 0);
+            atomic_init(&pt->stop, 0);
+            atomic_init(&pt->failed, 0);
+            pt->cache = skCacheCreate((stream_cache_size / pack_thread_count),
+                                      open_fn);
+            pt->queue = ((pack_slot_t*)
+                         malloc(PACK_QUEUE_SIZE * sizeof(pack_slot_t)));
+            if (NULL == pt->cache || NULL == pt->queue) {
+                return -1;
+            }
+            for (j = 0; j < PACK_QUEUE_SIZE; ++j) {
+                atomic_init(&pt->queue[j].seq, j);
+            }
+        }
+        return 0;
+    }
+#endif  /* PACK_THREADS_ENABLED */
+
+    stream_cache = skCacheCreate(stream_cache_size, open_fn);
+    return ((NULL == stream_cache) ? -1 : 0);
+}
+
+
+/*
+ *  destroyStreamCaches();
+ *
+ *    Destroy the stream cache(s) created by createStreamCaches() and
+ *    free the packing threads.  The packing threads must have been
+ *    stopped.
+ */
+static void
+destroyStreamCaches(
+    void)
+{
+#if PACK_THREADS_ENABLED
+    uint32_t i;
+
+    if (pack_threads) {
+        for (i = 0; i < pack_thread_count; ++i) {
+            assert(!pack_threads[i].running);
+            if (pack_threads[i].cache) {
+                skCacheDestroy(pack_threads[i].cache);
+            }
+            free(pack_threads[i].queue);
+        }
+        free(pack_threads);
+        pack_threads = NULL;
+    }
+#endif  /* PACK_THREADS_ENABLED */
+
+    if (stream_cache) {
+        skCacheDestroy(stream_cache);
+        stream_cache = NULL;
+    }
+}
+
+
+/*
+ *  status = cacheFlushOrCloseAll(close_all, &file_iter);
+ *
+ *    Call skCacheFlush() on the stream cache, or skCacheCloseAll()
+ *    when 'close_all' is non-zero, and set the referent of
+ *    'file_iter' to the iterator over the files.  When there are
+ *    packing threads, visit the stream cache of each and join their
+ *    iterators into one.
+ *
+ *    Return 0 on success, or -1 if any call fails.
+ */
+static int
+cacheFlushOrCloseAll(
+    int                 close_all,
+    cache_file_iter_t **file_iter)
+{
+#if PACK_THREADS_ENABLED
+    cache_file_iter_t *iter;
+    stream_cache_t *cache;
+    int retval = 0;
+    uint32_t i;
+
+    if (pack_threads) {
+        *file_iter = NULL;
+        for (i = 0; i < pack_thread_count; ++i) {
+            cache = pack_threads[i].cache;
+            if (NULL == cache) {
+                continue;
+            }
+            iter = NULL;
+            if (close_all
+                ? skCacheCloseAll(cache, &iter)
+                : skCacheFlush(cache, &iter))
+            {
+                retval = -1;
+            }
+            if (NULL == iter) {
+                continue;
+            }
+            if (NULL == *file_iter) {
+                *file_iter = iter;
+            } else if (skCacheFileIterAppend(*file_iter, iter)) {
+                skAppPrintOutOfMemory(NULL);
+                skCacheFileIterDestroy(iter);
+                retval = -1;
+            }
+        }
+        return retval;
+    }
+#endif  /* PACK_THREADS_ENABLED */
+
+    if (close_all) {
+        return skCacheCloseAll(stream_cache, file_iter);
+    }
+    return skCacheFlush(stream_cache, file_iter);
 }
 
 
@@ -2039,7 +2326,7 @@ printReaderStats(
  *    This function is invoked by the skTimer_t, and it is used when
  *    the output_mode is OUTPUT_LOCAL_STORAGE.
  *
- *    Flushes all the files in global stream cache stream_cache.
+ *    Flushes all the files in the stream cache(s).
  *
  *    Called every 'flush_timeout' seconds by the timing_thread.
  */
@@ -2054,7 +2341,7 @@ timedFlush(
     /* Flush the stream cache */
     NOTICEMSG("Flushing files after %" PRIu32 " seconds.", flush_timeout);
     printReaderStats();
-    if (skCacheFlush(stream_cache, &iter)) {
+    if (cacheFlushOrCloseAll(0, &iter)) {
         CRITMSG("Error flushing files -- shutting down");
         exit(EXIT_FAILURE);
     }
@@ -3069,6 +3356,261 @@ openOutputStreamRepo(
 }
 
 
+/*
+ *  status = writeRecord(cache, probe, key, rwrec);
+ *
+ *    Write 'rwrec', which was read from 'probe', to the file in
+ *    'cache' whose flowtype, sensor, and hour are given by 'key'.
+ *    The flowtype and sensor of 'rwrec' must already be set.
+ *
+ *    Return 0 on success.  Return -1 to indicate a fatal error.
+ *    Return 1 to indicate a non-fatal write error.
+ */
+static int
+writeRecord(
+    stream_cache_t     *cache,
+    const skpc_probe_t *probe,
+    const cache_key_t  *key,
+    const rwRec        *rwrec)
+{
+    cache_entry_t *entry;
+    skstream_t *stream;
+    int rv;
+
+    /* Get the file from the cache, which may use an open file, open
+     * an existing file, or create a new file as required.  If the
+     * file is not already open, this function will invoke
+     * openOutputStream() to open or create the file.  */
+    rv = skCacheLookupOrOpenAdd(cache, key, (void*)probe, &entry);
+    if (rv) {
+        if (-1 == rv) {
+            /* problem opening file or adding file to cache */
+            CRITMSG(("Error opening file for probe '%s' -- "
+                     " shutting down"),
+                    skpcProbeGetName(probe));
+        } else if (1 == rv) {
+            /* problem closing existing cache entry */
+            CRITMSG("Error closing file -- shutting down");
+        } else {
+            CRITMSG(("Unexpected error code from stream cache %d -- "
+                     "shutting down"),
+                    rv);
+        }
+        return -1;
+    }
+
+    /* Write record */
+    stream = skCacheEntryGetStream(entry);
+    rv = skStreamWriteRecord(stream, rwrec);
+    if (SKSTREAM_OK != rv) {
+        if (SKSTREAM_ERROR_IS_FATAL(rv)) {
+            skStreamPrintLastErr(stream, rv, &ERRMSG);
+            CRITMSG(("Error writing record for probe '%s' -- "
+                     " shutting down"),
+                    skpcProbeGetName(probe));
+            skCacheEntryRelease(entry);
+            return -1;
+        }
+        skStreamPrintLastErr(stream, rv, &WARNINGMSG);
+        skCacheEntryRelease(entry);
+        return 1;
+    }
+
+    /* unlock stream */
+    skCacheEntryRelease(entry);
+    return 0;
+}
+
+
+#if PACK_THREADS_ENABLED
+/*
+ *  packThreadPause(&wait_count);
+ *
+ *    Wait for a packing thread's queue to change.  Yield the CPU for
+ *    the first PACK_WAIT_YIELDS calls, then sleep for PACK_WAIT_NSEC
+ *    nanoseconds.  'wait_count' is the number of consecutive calls;
+ *    the caller sets it to 0 once the queue changes.
+ */
+static void
+packThreadPause(
+    unsigned int       *wait_count)
+{
+    struct timespec ts;
+
+    if (*wait_count < PACK_WAIT_YIELDS) {
+        ++*wait_count;
+        sched_yield();
+        return;
+    }
+    ts.tv_sec = 0;
+    ts.tv_nsec = PACK_WAIT_NSEC;
+    nanosleep(&ts, NULL);
+}
+
+
+/*
+ *  ok = packThreadEnqueue(pt, probe, rwrec);
+ *
+ *    Copy 'rwrec', which was read from 'probe', into the queue of the
+ *    packing thread 'pt', waiting while the queue is full.  Return 0
+ *    on success, or -1 if the packing thread has stopped because of
+ *    an error.
+ *
+ *    The queue is the bounded multiple-producer, single-consumer ring
+ *    described by Dmitry Vyukov.  The slot at position 'pos' is free
+ *    when its 'seq' is 'pos' and holds a record when its 'seq' is
+ *    'pos + 1'.  A reader claims a free slot by advancing
+ *    'enqueue_pos' with a compare-and-swap, fills it, and publishes
+ *    it by storing 'pos + 1' in 'seq'.
+ */
+static int
+packThreadEnqueue(
+    pack_thread_t      *pt,
+    const skpc_probe_t *probe,
+    const rwRec        *rwrec)
+{
+    pack_slot_t *slot;
+    unsigned int wait_count = 0;
+    size_t pos;
+    size_t seq;
+    intptr_t diff;
+
+    pos = atomic_load_explicit(&pt->enqueue_pos, memory_order_relaxed);
+    for (;;) {
+        slot = &pt->queue[pos & (PACK_QUEUE_SIZE - 1)];
+        seq = atomic_load_explicit(&slot->seq, memory_order_acquire);
+        diff = (intptr_t)seq - (intptr_t)pos;
+        if (0 == diff) {
+            if (atomic_compare_exchange_weak_explicit(
+                    &pt->enqueue_pos, &pos, pos + 1,
+                    memory_order_relaxed, memory_order_relaxed))
+            {
+                break;
+            }
+            /* another reader took the slot; 'pos' has been reloaded */
+        } else if (diff < 0) {
+            /* queue is full */
+            if (atomic_load_explicit(&pt->failed, memory_order_relaxed)) {
+                return -1;
+            }
+            packThreadPause(&wait_count);
+            pos = atomic_load_explicit(&pt->enqueue_pos,
+                                       memory_order_relaxed);
+        } else {
+            pos = atomic_load_explicit(&pt->enqueue_pos,
+                                       memory_order_relaxed);
+        }
+    }
+
+    slot->probe = probe;
+    RWREC_COPY(&slot->rwrec, rwrec);
+    atomic_store_explicit(&slot->seq, pos + 1, memory_order_release);
+    return 0;
+}
+
+
+/*
+ *  packThreadMain(pt);
+ *
+ *  THREAD ENTRY POINT for each packing thread.
+ *
+ *    Removes records from the queue of the packing thread 'pt' and
+ *    writes them to the files in the thread's stream cache.  Runs
+ *    until the queue is empty after stopPackThreads() sets the
+ *    'stop' member, or until a fatal error occurs.
+ */
+static void *
+packThreadMain(
+    void               *vp_pt)
+{
+    pack_thread_t *pt = (pack_thread_t*)vp_pt;
+    unsigned int wait_count = 0;
+    pack_slot_t *slot;
+    cache_key_t key;
+    size_t pos;
+    size_t seq;
+    int rv;
+
+    DEBUGMSG("Started packing thread #%u", pt->id);
+
+    pos = 0;
+    for (;;) {
+        slot = &pt->queue[pos & (PACK_QUEUE_SIZE - 1)];
+        seq = atomic_load_explicit(&slot->seq, memory_order_acquire);
+        if (seq != pos + 1) {
+            /* queue is empty */
+            if (atomic_load_explicit(&pt->stop, memory_order_acquire)
+                && (atomic_load_explicit(&pt->enqueue_pos,
+                                         memory_order_acquire) == pos))
+            {
+                break;
+            }
+            packThreadPause(&wait_count);
+            continue;
+        }
+        wait_count = 0;
+
+        key.time_stamp = rwRecGetStartTime(&slot->rwrec);
+        key.time_stamp -= key.time_stamp % 3600000;
+        key.flowtype_id = rwRecGetFlowType(&slot->rwrec);
+        key.sensor_id = rwRecGetSensor(&slot->rwrec);
+
+        ++pt->rec_count_total;
+        rv = writeRecord(pt->cache, slot->probe, &key, &slot->rwrec);
+        if (rv) {
+            if (-1 == rv) {
+                atomic_store_explicit(&pt->failed, 1, memory_order_relaxed);
+                shuttingDown = 1;
+                pthread_kill(main_thread, READER_DONE_SIGNAL);
+                break;
+            }
+            ++pt->rec_count_bad;
+        }
+
+        /* give the slot back to the readers */
+        atomic_store_explicit(&slot->seq, pos + PACK_QUEUE_SIZE,
+                              memory_order_release);
+        ++pos;
+        atomic_store_explicit(&pt->done_pos, pos, memory_order_release);
+    }
+
+    DEBUGMSG("Stopping packing thread #%u", pt->id);
+    return NULL;
+}
+
+
+/*
+ *  packThreadsDrain();
+ *
+ *    Wait until the packing threads have written every record that
+ *    was in their queues when this function was called.
+ */
+static void
+packThreadsDrain(
+    void)
+{
+    pack_thread_t *pt;
+    unsigned int wait_count;
+    size_t target;
+    uint32_t i;
+
+    for (i = 0; i < pack_thread_count; ++i) {
+        pt = &pack_threads[i];
+        target = atomic_load_explicit(&pt->enqueue_pos, memory_order_acquire);
+        wait_count = 0;
+        while (atomic_load_explicit(&pt->done_pos, memory_order_acquire)
+               < target)
+        {
+            if (atomic_load_explicit(&pt->failed, memory_order_relaxed)) {
+                break;
+            }
+            packThreadPause(&wait_count);
+        }
+    }
+}
+#endif  /* PACK_THREADS_ENABLED */
+
+
 /*
  *  ok = packRecord(probe, rwrec);
  *
@@ -3077,6 +3619,9 @@ openOutputStreamRepo(
  *    pack it into the correct file(s) using the appropriate file
  *    output format(s).
  *
+ *    When --pack-threads is greater than 1, hand the record to the
+ *    packing thread that owns each file instead of writing it here.
+ *
  *    Return 0 on success.  Return -1 to indicate a fatal error.
  *    Return 1 to indicate a non-fatal write error or an error to
  *    determine the flowtype and sensor for the record.
@@ -3086,11 +3631,9 @@ packRecord(
     const skpc_probe_t *probe,
     rwRec              *rwrec)
 {
-    cache_entry_t *entry;
     cache_key_t key;
     sk_flowtype_id_t ftypes[MAX_SPLIT_FLOWTYPES];
     sk_sensor_id_t sensorids[MAX_SPLIT_FLOWTYPES];
-    skstream_t *stream;
     int count;
     int rec_is_bad;
     int i;
@@ -3131,46 +3674,34 @@ packRecord(
         key.sensor_id = sensorids[i];
         rwRecSetSensor(rwrec, sensorids[i]);
 
-        /* Get the file from the cache, which may use an open file,
-         * open an existing file, or create a new file as required.
-         * If the file is not already open, this function will invoke
-         * openOutputStream() to open or create the file.  */
-        rv = skCacheLookupOrOpenAdd(stream_cache, &key, (void*)probe, &entry);
-        if (rv) {
-            if (-1 == rv) {
-                /* problem opening file or adding file to cache */
-                CRITMSG(("Error opening file for probe '%s' -- "
-                         " shutting down"),
+#if PACK_THREADS_ENABLED
+        if (pack_threads) {
+            uint32_t h;
+
+            /* choose the packing thread that owns this file */
+            h = (uint32_t)(key.time_stamp / 3600000);
+            h = h * 0x9E3779B1u + key.sensor_id;
+            h = h * 0x9E3779B1u + key.flowtype_id;
+            h ^= h >> 16;
+            if (packThreadEnqueue(&pack_threads[h % pack_thread_count],
+                                  probe, rwrec))
+            {
+                CRITMSG(("Packing thread stopped; cannot pack record"
+                         " for probe '%s' -- shutting down"),
                         skpcProbeGetName(probe));
-            } else if (1 == rv) {
-                /* problem closing existing cache entry */
-                CRITMSG("Error closing file -- shutting down");
-            } else {
-                CRITMSG(("Unexpected error code from stream cache %d -- "
-                         "shutting down"),
-                        rv);
+                return -1;
             }
-            return -1;
+            continue;
         }
+#endif  /* PACK_THREADS_ENABLED */
 
-        /* Write record */
-        stream = skCacheEntryGetStream(entry);
-        rv = skStreamWriteRecord(stream, rwrec);
-        if (SKSTREAM_OK != rv) {
-            if (SKSTREAM_ERROR_IS_FATAL(rv)) {
-                skStreamPrintLastErr(stream, rv, &ERRMSG);
-                CRITMSG(("Error writing record for probe '%s' -- "
-                         " shutting down"),
-                        skpcProbeGetName(probe));
-                skCacheEntryRelease(entry);
+        rv = writeRecord(stream_cache, probe, &key, rwrec);
+        if (rv) {
+            if (-1 == rv) {
                 return -1;
             }
-            skStreamPrintLastErr(stream, rv, &WARNINGMSG);
             rec_is_bad = 1;
         }
-
-        /* unlock stream */
-        skCacheEntryRelease(entry);
     }
 
     return rec_is_bad;
@@ -3217,6 +3748,11 @@ manageProcessor(
             /* We've processed all the input; there is no more.  Tell
              * the sender to send the packed files we've created.
              * Set 'shuttingDown' to begin the shutdown process. */
+#if PACK_THREADS_ENABLED
+            if (pack_threads) {
+                packThreadsDrain();
+            }
+#endif
             flushAndMoveFiles();
             shuttingDown = 1;
             goto END;
@@ -3322,6 +3858,71 @@ startTimer(
 }
 
 
+/*
+ *  status = startPackThreads();
+ *
+ *    Spawn the packing threads when --pack-threads is greater than
+ *    1.  Return 0 on success, or -1 on failure.
+ */
+static int
+startPackThreads(
+    void)
+{
+#if PACK_THREADS_ENABLED
+    pack_thread_t *pt;
+    uint32_t i;
+
+    if (NULL == pack_threads) {
+        return 0;
+    }
+
+    INFOMSG("Starting %" PRIu32 " packing threads", pack_thread_count);
+    for (i = 0; i < pack_thread_count; ++i) {
+        pt = &pack_threads[i];
+        if (skthread_create("packer", &pt->thread, &packThreadMain, pt)) {
+            ERRMSG("Unable to create packing thread #%u", pt->id);
+            return -1;
+        }
+        pt->running = 1;
+    }
+#endif  /* PACK_THREADS_ENABLED */
+
+    return 0;
+}
+
+
+/*
+ *  stopPackThreads();
+ *
+ *    Tell each packing thread to exit once it has written the records
+ *    in its queue, and join the threads.  The reader threads must
+ *    have been stopped.  This function is idempotent.
+ */
+static void
+stopPackThreads(
+    void)
+{
+#if PACK_THREADS_ENABLED
+    pack_thread_t *pt;
+    uint32_t i;
+
+    if (NULL == pack_threads) {
+        return;
+    }
+
+    for (i = 0; i < pack_thread_count; ++i) {
+        pt = &pack_threads[i];
+        if (pt->running) {
+            DEBUGMSG("Stopping packing thread #%u", pt->id);
+            atomic_store_explicit(&pt->stop, 1, memory_order_release);
+            pthread_join(pt->thread, NULL);
+            pt->running = 0;
+        }
+    }
+#endif  /* PACK_THREADS_ENABLED */
+}
+
+
 /*
  *  status = startAllProcessors();
  *
@@ -3339,7 +3940,7 @@ startAllProcessors(
     flow_proc_t *fproc;
     size_t i;
 
-    assert(stream_cache);
+    assert(stream_cache || PACK_THREADS_ACTIVE);
 
     /* Start each flow_processor, but don't start reading records
      * until every processor is running */
@@ -3356,6 +3957,11 @@ startAllProcessors(
         }
     }
 
+    /* Start the packing threads before any records arrive */
+    if (startPackThreads()) {
+        return 1;
+    }
+
     reading = 1;
 
     /* Spawn threads to read records from each processor */
@@ -3543,7 +4149,7 @@ flushAndMoveFiles(
     NOTICEMSG("Closing and moving incremental files...");
 
     /* Close all the output files. */
-    if (skCacheCloseAll(stream_cache, &incr_files)) {
+    if (cacheFlushOrCloseAll(1, &incr_files)) {
         CRITMSG("Error closing incremental files -- shutting down");
         exit(EXIT_FAILURE);
     }
@@ -3798,8 +4404,7 @@ int main(int argc, char **argv)
      * incur the expense of reopening files */
     INFOMSG("Creating stream cache");
     if (output_mode == OUTPUT_LOCAL_STORAGE) {
-        stream_cache = skCacheCreate(stream_cache_size, &openOutputStreamRepo);
-        if (NULL == stream_cache) {
+        if (createStreamCaches(&openOutputStreamRepo)) {
             CRITMSG("Unable to create stream cache.");
             exit(EXIT_FAILURE);
         }
@@ -3807,8 +4412,7 @@ int main(int argc, char **argv)
     } else if (output_mode == OUTPUT_INCREMENTAL_FILES
                || output_mode == OUTPUT_SENDING)
     {
-        stream_cache = skCacheCreate(stream_cache_size, &openOutputStreamIncr);
-        if (NULL == stream_cache) {
+        if (createStreamCaches(&openOutputStreamIncr)) {
             CRITMSG("Unable to create stream cache.");
             exit(EXIT_FAILURE);
         }
@@ -459,6 +459,26 @@ skCacheEntryRelease(
 }
 
 
+/* move the files in 'src' to the end of 'dst'; destroy 'src' */
+int
+skCacheFileIterAppend(
+    cache_file_iter_t  *dst,
+    cache_file_iter_t  *src)
+{
+    assert(dst);
+    assert(src);
+    assert(0 == dst->pos && 0 == src->pos);
+
+    if (skVectorAppendVector(dst->vector, src->vector)) {
+        return -1;
+    }
+    /* 'dst' now owns the filenames */
+    skVectorDestroy(src->vector);
+    free(src);
+    return 0;
+}
+
+
 /* return the number of files in the iterator */
 size_t
 skCacheFileIterCountEntries(
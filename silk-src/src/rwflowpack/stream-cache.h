@@ -194,6 +194,21 @@ skCacheEntryRelease(
     cache_entry_t  *entry);
 
 
+/**
+ *    Move the files in the iterator 'src' to the end of the iterator
+ *    'dst' and destroy 'src'.  Both iterators must have been returned
+ *    by skCacheCloseAll() or skCacheFlush() and neither may have been
+ *    visited by skCacheFileIterNext().
+ *
+ *    Return 0 on success.  Return -1 on memory allocation error, in
+ *    which case neither iterator is modified.
+ */
+int
+skCacheFileIterAppend(
+    cache_file_iter_t  *dst,
+    cache_file_iter_t  *src);
+
+
 /**
  *    Return the number of entries in the iterator returned by
  *    skCacheCloseAll() or skCacheFlush().
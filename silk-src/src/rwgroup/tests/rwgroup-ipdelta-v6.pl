@@ -1,5 +1,5 @@
 #! /usr/bin/perl -w
-# MD5: 6527472ce67376aa9f4ec40e929833b3
+# MD5: 7c9276dfc41ef13aed8b1599cf1f8ea2
 # TEST: ../rwsort/rwsort --fields=1 ../../tests/data-v6.rwf | ./rwgroup --delta-field=1 --delta-value=64 | ../rwcat/rwcat --compression-method=none --byte-order=little
 
 use strict;
@@ -12,6 +12,6 @@ my %file;
 $file{v6data} = get_data_or_exit77('v6data');
 check_features(qw(ipv6));
 my $cmd = "$rwsort --fields=1 $file{v6data} | $rwgroup --delta-field=1 --delta-value=64 | $rwcat --compression-method=none --byte-order=little";
-my $md5 = "6527472ce67376aa9f4ec40e929833b3";
+my $md5 = "7c9276dfc41ef13aed8b1599cf1f8ea2";
 
 check_md5_output($md5, $cmd);
@@ -1,5 +1,5 @@
 #! /usr/bin/perl -w
-# MD5: 7d4fc97050bf1120c0736cfd813c0be3
+# MD5: 288c4317a537d7de28dbace70d88c533
 # TEST: ../rwsort/rwsort --fields=3 ../../tests/data.rwf | ./rwgroup --id-fields=3 --rec-threshold=20 --group-offset=0.1.0.0 | ../rwcat/rwcat --compression-method=none --byte-order=little --ipv4-output
 
 use strict;
@@ -11,6 +11,6 @@ my $rwsort = check_silk_app('rwsort');
 my %file;
 $file{data} = get_data_or_exit77('data');
 my $cmd = "$rwsort --fields=3 $file{data} | $rwgroup --id-fields=3 --rec-threshold=20 --group-offset=0.1.0.0 | $rwcat --compression-method=none --byte-order=little --ipv4-output";
-my $md5 = "7d4fc97050bf1120c0736cfd813c0be3";
+my $md5 = "288c4317a537d7de28dbace70d88c533";
 
 check_md5_output($md5, $cmd);
@@ -23,6 +23,12 @@
 **  before the buffer is filled, the records are sorted and printed to
 **  standard out or to the named output file.
 **
+**  To sort the buffer, rwdedupe builds an index that holds, for each
+**  record, the values of the fields being compared encoded so that
+**  the index may be sorted with a radix sort.  When a --*-delta
+**  switch applies to one of those fields, the records are sorted by
+**  comparing them instead.
+**
 **  However, if the buffer fills before the input is completely read,
 **  the records in the buffer are sorted and written to a temporary
 **  file on disk; the buffer is cleared, and reading of the input
@@ -574,6 +580,305 @@ mergeFiles(
 }
 
 
+/* Append the 'n'-octet value 'v' to the key 'k' in big-endian order */
+#define KEY_PUT(k, v, n)                                \
+    {                                                   \
+        uint64_t kp_v = (uint64_t)(v);                  \
+        size_t kp_i;                                    \
+        for (kp_i = (n); kp_i > 0; --kp_i) {            \
+            (k)[kp_i - 1] = (uint8_t)(kp_v & 0xFF);     \
+            kp_v >>= 8;                                 \
+        }                                               \
+        (k) += (n);                                     \
+    }
+
+/*
+ *    Append an IP address to the key 'k'.  When 'ipv6' is set, the
+ *    address takes 17 octets: a leading octet that sorts IPv4 before
+ *    IPv6 (as compareIPs() does) followed by the address.
+ */
+#define KEY_PUT_IP(k, func, rec, ipv6)                  \
+    {                                                   \
+        skipaddr_t kpi_ip;                              \
+        func(rec, &kpi_ip);                             \
+        if (!(ipv6)) {                                  \
+            KEY_PUT(k, skipaddrGetV4(&kpi_ip), 4);      \
+        } else if (!skipaddrIsV6(&kpi_ip)) {            \
+            memset((k), 0, 13);                         \
+            (k) += 13;                                  \
+            KEY_PUT(k, skipaddrGetV4(&kpi_ip), 4);      \
+        } else {                                        \
+            *(k)++ = 1;                                 \
+            skipaddrGetV6(&kpi_ip, (k));                \
+            (k) += 16;                                  \
+        }                                               \
+    }
+
+
+/*
+ *  key_len = sortKeyLength(ipv6);
+ *
+ *    Return the number of octets in the normalized key for the
+ *    fields in sort_fields[], where 'ipv6' is non-zero when the IP
+ *    addresses require 17 octets.  Return 0 when the key cannot be
+ *    normalized because a --*-delta switch applies to one of the
+ *    fields.
+ */
+static size_t
+sortKeyLength(
+    int                 ipv6)
+{
+    size_t key_len = 0;
+    uint32_t i;
+
+    if (0 == num_fields) {
+        return NODE_SIZE;
+    }
+    for (i = 0; i < num_fields; ++i) {
+        switch (sort_fields[i]) {
+          case RWREC_FIELD_SIP:
+          case RWREC_FIELD_DIP:
+          case RWREC_FIELD_NHIP:
+            key_len += ((ipv6) ? 17 : 4);
+            break;
+          case RWREC_FIELD_STIME:
+          case RWREC_FIELD_STIME_MSEC:
+            if (delta.d_stime) {
+                return 0;
+            }
+            key_len += 8;
+            break;
+          case RWREC_FIELD_ELAPSED:
+          case RWREC_FIELD_ELAPSED_MSEC:
+            if (delta.d_elapsed) {
+                return 0;
+            }
+            key_len += 4;
+            break;
+          case RWREC_FIELD_PKTS:
+            if (delta.d_packets) {
+                return 0;
+            }
+            key_len += 4;
+            break;
+          case RWREC_FIELD_BYTES:
+            if (delta.d_bytes) {
+                return 0;
+            }
+            key_len += 4;
+            break;
+          case RWREC_FIELD_SPORT:
+          case RWREC_FIELD_DPORT:
+          case RWREC_FIELD_SID:
+          case RWREC_FIELD_INPUT:
+          case RWREC_FIELD_OUTPUT:
+          case RWREC_FIELD_APPLICATION:
+            key_len += 2;
+            break;
+          case RWREC_FIELD_PROTO:
+          case RWREC_FIELD_FLAGS:
+          case RWREC_FIELD_INIT_FLAGS:
+          case RWREC_FIELD_REST_FLAGS:
+          case RWREC_FIELD_TCP_STATE:
+          case RWREC_FIELD_FTYPE_CLASS:
+          case RWREC_FIELD_FTYPE_TYPE:
+            key_len += 1;
+            break;
+          default:
+            /* rwrecCompare() ignores this field */
+            break;
+        }
+    }
+    return key_len;
+}
+
+
+/*
+ *  sortKeyFill(key, rec, ipv6);
+ *
+ *    Write into 'key' the normalized key of the record 'rec', where
+ *    'ipv6' is as for sortKeyLength().  Comparing two keys with
+ *    memcmp() gives the same order as rwrecCompare() when no delta
+ *    applies.
+ */
+static void
+sortKeyFill(
+    uint8_t            *key,
+    const rwRec        *rec,
+    int                 ipv6)
+{
+    uint8_t *k = key;
+    uint32_t i;
+
+    if (0 == num_fields) {
+        memcpy(key, rec, NODE_SIZE);
+        return;
+    }
+
+    for (i = 0; i < num_fields; ++i) {
+        switch (sort_fields[i]) {
+          case RWREC_FIELD_SIP:
+            KEY_PUT_IP(k, rwRecMemGetSIP, rec, ipv6);
+            break;
+          case RWREC_FIELD_DIP:
+            KEY_PUT_IP(k, rwRecMemGetDIP, rec, ipv6);
+            break;
+          case RWREC_FIELD_NHIP:
+            KEY_PUT_IP(k, rwRecMemGetNhIP, rec, ipv6);
+            break;
+          case RWREC_FIELD_SPORT:
+            KEY_PUT(k, rwRecGetSPort(rec), 2);
+            break;
+          case RWREC_FIELD_DPORT:
+            KEY_PUT(k, rwRecGetDPort(rec), 2);
+            break;
+          case RWREC_FIELD_PROTO:
+            KEY_PUT(k, rwRecGetProto(rec), 1);
+            break;
+          case RWREC_FIELD_PKTS:
+            KEY_PUT(k, rwRecGetPkts(rec), 4);
+            break;
+          case RWREC_FIELD_BYTES:
+            KEY_PUT(k, rwRecGetBytes(rec), 4);
+            break;
+          case RWREC_FIELD_FLAGS:
+            KEY_PUT(k, rwRecGetFlags(rec), 1);
+            break;
+          case RWREC_FIELD_STIME:
+          case RWREC_FIELD_STIME_MSEC:
+            /* flip the sign bit so negative times sort first */
+            KEY_PUT(k, ((uint64_t)rwRecGetStartTime(rec)
+                        ^ UINT64_C(0x8000000000000000)), 8);
+            break;
+          case RWREC_FIELD_ELAPSED:
+          case RWREC_FIELD_ELAPSED_MSEC:
+            KEY_PUT(k, rwRecGetElapsed(rec), 4);
+            break;
+          case RWREC_FIELD_SID:
+            KEY_PUT(k, rwRecGetSensor(rec), 2);
+            break;
+          case RWREC_FIELD_INPUT:
+            KEY_PUT(k, rwRecGetInput(rec), 2);
+            break;
+          case RWREC_FIELD_OUTPUT:
+            KEY_PUT(k, rwRecGetOutput(rec), 2);
+            break;
+          case RWREC_FIELD_INIT_FLAGS:
+            KEY_PUT(k, rwRecGetInitFlags(rec), 1);
+            break;
+          case RWREC_FIELD_REST_FLAGS:
+            KEY_PUT(k, rwRecGetRestFlags(rec), 1);
+            break;
+          case RWREC_FIELD_TCP_STATE:
+            KEY_PUT(k, rwRecGetTcpState(rec), 1);
+            break;
+          case RWREC_FIELD_APPLICATION:
+            KEY_PUT(k, rwRecGetApplication(rec), 2);
+            break;
+          case RWREC_FIELD_FTYPE_CLASS:
+          case RWREC_FIELD_FTYPE_TYPE:
+            KEY_PUT(k, rwRecGetFlowType(rec), 1);
+            break;
+          default:
+            break;
+        }
+    }
+}
+
+
+/*
+ *  sortBuffer(record_buffer, record_count);
+ *
+ *    Sort the 'record_count' records in 'record_buffer'.
+ *
+ *    Create an index holding the normalized key of each record
+ *    followed by the record's position, sort the index with
+ *    skRadixSort(), and move the records into the sorted order.
+ *    Since the position is part of each entry, records with
+ *    identical keys keep their input order, and the first of a run
+ *    of duplicates is the earliest one read.
+ *
+ *    When the key cannot be normalized or the index cannot be
+ *    allocated, sort the records with skQSort().
+ */
+static void
+sortBuffer(
+    uint8_t            *record_buffer,
+    size_t              record_count)
+{
+    rwRec tmp_rec;
+    uint8_t *index = NULL;
+    uint8_t *entry;
+    uint32_t *order;
+    size_t entry_size = 0;
+    size_t key_len;
+    size_t c;
+    size_t i;
+    size_t j;
+    int ipv6 = 0;
+
+    TRACEMSG(("Sorting %" SK_PRIuZ " records...", record_count));
+
+#if SK_ENABLE_IPV6
+    for (c = 0; c < record_count; ++c) {
+        if (rwRecIsIPv6((rwRec*)(record_buffer + c * NODE_SIZE))) {
+            ipv6 = 1;
+            break;
+        }
+    }
+#endif
+
+    key_len = sortKeyLength(ipv6);
+    if (key_len > 0 && record_count <= UINT32_MAX) {
+        entry_size = key_len + sizeof(uint32_t);
+        index = (uint8_t*)malloc(record_count * entry_size);
+    }
+    if (NULL == index) {
+        skQSort(record_buffer, record_count, NODE_SIZE, &rwrecCompare);
+        TRACEMSG(("Sorting %" SK_PRIuZ " records...done", record_count));
+        return;
+    }
+
+    for (c = 0, entry = index; c < record_count; ++c, entry += entry_size) {
+        sortKeyFill(entry, (rwRec*)(record_buffer + c * NODE_SIZE), ipv6);
+        entry += key_len;
+        KEY_PUT(entry, c, sizeof(uint32_t));
+        entry -= entry_size;
+    }
+    skRadixSort(index, record_count, entry_size, entry_size);
+
+    /* pack the positions into the start of the index; 'order[i]' is
+     * the position of the record that belongs at position 'i' */
+    order = (uint32_t*)index;
+    for (c = 0, entry = index + key_len;
+         c < record_count;
+         ++c, entry += entry_size)
+    {
+        order[c] = (((uint32_t)entry[0] << 24) | ((uint32_t)entry[1] << 16)
+                    | ((uint32_t)entry[2] << 8) | (uint32_t)entry[3]);
+    }
+
+    /* move the records by following each cycle of the permutation */
+    for (c = 0; c < record_count; ++c) {
+        if (order[c] == c) {
+            continue;
+        }
+        memcpy(&tmp_rec, record_buffer + c * NODE_SIZE, NODE_SIZE);
+        for (i = c; order[i] != c; i = j) {
+            j = order[i];
+            memcpy(record_buffer + i * NODE_SIZE,
+                   record_buffer + j * NODE_SIZE, NODE_SIZE);
+            order[i] = i;
+        }
+        memcpy(record_buffer + i * NODE_SIZE, &tmp_rec, NODE_SIZE);
+        order[i] = i;
+    }
+
+    free(index);
+    TRACEMSG(("Sorting %" SK_PRIuZ " records...done", record_count));
+}
+
+
 /*
  *  sortRandom();
  *
@@ -715,10 +1020,7 @@ sortRandom(
              * failed. */
             if (record_count == buffer_max_recs) {
                 /* Sort */
-                TRACEMSG(("Sorting %" SK_PRIuZ " records...", record_count));
-                skQSort(record_buffer, record_count, NODE_SIZE, &rwrecCompare);
-                TRACEMSG(("Sorting %" SK_PRIuZ " records...done",
-                          record_count));
+                sortBuffer(record_buffer, record_count);
 
                 /* Write to temp file */
                 if (skTempFileWriteBufferStream(
@@ -740,9 +1042,7 @@ sortRandom(
 
     /* Sort (and maybe store) last batch of records */
     if (record_count > 0) {
-        TRACEMSG(("Sorting %" SK_PRIuZ " records...", record_count));
-        skQSort(record_buffer, record_count, NODE_SIZE, &rwrecCompare);
-        TRACEMSG(("Sorting %" SK_PRIuZ " records...done", record_count));
+        sortBuffer(record_buffer, record_count);
 
         if (temp_file_idx >= 0) {
             /* Write last batch to temp file */
@@ -47,6 +47,16 @@
 **  temporary files will be between 1 and 1.5 times the number of
 **  records.
 **
+**  When the --threads switch is greater than 1, each buffer is
+**  divided into that many partitions that are sorted in parallel and
+**  then merged as they are written.  Once the first buffer has been
+**  written to a temporary file, the buffer is split into two halves:
+**  a background thread sorts and stores one half while the input is
+**  read into the other.  The final merge of the temporary files is
+**  also spread across the threads: each thread merges a group of the
+**  files and hands blocks of records to the main thread, which merges
+**  the groups into the output.
+**
 */
 
 #include <silk/silk.h>
@@ -94,6 +104,71 @@ int presorted_input = 0;
 /* maximum amount of RAM to attempt to allocate */
 size_t sort_buffer_size;
 
+/* number of threads to use for sorting and merging */
+uint32_t thread_count = RWSORT_THREADS_DEFAULT;
+
+
+/* LOCAL DEFINES AND TYPEDEFS */
+
+/* a partition of a record buffer that one thread sorts.  When
+ * 'index' is not NULL, it holds one 'entry_size'-octet entry per
+ * record in sorted order; otherwise the records were sorted in
+ * place.  'rec' is the record at position 'pos' in sorted order, or
+ * NULL once all records have been visited. */
+typedef struct sort_part_st {
+    pthread_t           thread;
+    uint8_t            *buffer;
+    size_t              count;
+    uint8_t            *index;
+    size_t              entry_size;
+    size_t              pos;
+    uint8_t            *rec;
+    unsigned            started :1;
+} sort_part_t;
+
+/* a buffer of records that a background thread sorts and writes to a
+ * temporary file while the main thread reads the next buffer */
+typedef struct sort_run_st {
+    pthread_t           thread;
+    uint8_t            *buffer;
+    size_t              count;
+    int                *temp_idx;
+    unsigned            active :1;
+} sort_run_t;
+
+/* a group of temporary files that one thread merges during the final
+ * merge.  The thread fills the two blocks in turn and the main thread
+ * empties them; a block is empty when its 'block_count' is 0. */
+typedef struct merge_group_st {
+    pthread_t           thread;
+    pthread_mutex_t     mutex;
+    pthread_cond_t      cond;
+    /* the temporary files and their current records; the group uses
+     * the entries from 'first' to 'first'+'count'-1 */
+    skstream_t        **fps;
+    uint8_t           (*recs)[MAX_NODE_SIZE];
+    uint16_t            first;
+    uint16_t            count;
+    uint8_t            *block[2];
+    size_t              block_count[2];
+    /* the block and record the main thread is reading */
+    unsigned            read_block;
+    size_t              read_pos;
+    /* the main thread's current record; NULL when group is empty */
+    uint8_t            *rec;
+    /* set when the thread has merged all its files */
+    unsigned            done :1;
+} merge_group_t;
+
+/* an input stream and a block of records read from it.  The records
+ * from 'pos' to 'count'-1 have not been used. */
+typedef struct sort_reader_st {
+    skstream_t         *stream;
+    rwRec               recs[SORT_READ_RECS];
+    size_t              count;
+    size_t              pos;
+} sort_reader_t;
+
 
 /* FUNCTION DEFINITIONS */
 
@@ -328,6 +403,8 @@ rwrecCompare(
  *    Callback function used by the heap two compare two heapnodes,
  *    there are just indexes into an array of records.  'v_recs' is
  *    the array of records, where each record is MAX_NODE_SIZE bytes.
+ *    Records that compare equal are ordered by their index, so that
+ *    the record from the earlier file is taken first.
  *
  *    Note the order of arguments is 'b', 'a'.
  */
@@ -338,9 +415,48 @@ compHeapNodes(
     void               *v_recs)
 {
     uint8_t *recs = (uint8_t*)v_recs;
+    uint16_t idx_a = *(uint16_t*)a;
+    uint16_t idx_b = *(uint16_t*)b;
+    int rv;
 
-    return rwrecCompare(&recs[*(uint16_t*)a * MAX_NODE_SIZE],
-                        &recs[*(uint16_t*)b * MAX_NODE_SIZE]);
+    rv = rwrecCompare(&recs[idx_a * MAX_NODE_SIZE],
+                      &recs[idx_b * MAX_NODE_SIZE]);
+    if (rv) {
+        return rv;
+    }
+    return ((idx_a < idx_b) ? -1 : (idx_a > idx_b));
+}
+
+
+/*
+ *  fillKey(buf);
+ *
+ *    Computes the key for the record at the start of 'buf' based on
+ *    the global key_fields[] settings and fills in the parameter
+ *    'buf' with the key after the record.
+ */
+static void
+fillKey(
+    uint8_t            *buf)
+{
+    rwRec *rwrec = (rwRec*)buf;
+    skplugin_err_t err;
+    const char **name;
+    size_t i;
+
+    /* lookup data from plug-in */
+    for (i = 0; i < key_num_fields; ++i) {
+        err = skPluginFieldRunRecToBinFn(key_fields[i].kf_field_handle,
+                                         &(buf[key_fields[i].kf_offset]),
+                                         rwrec, NULL);
+        if (err != SKPLUGIN_OK) {
+            skPluginFieldName(key_fields[i].kf_field_handle, &name);
+            skAppPrintErr(("Plugin-based field %s failed "
+                           "converting to binary "
+                           "with error code %d"), name[0], err);
+            appExit(EXIT_FAILURE);
+        }
+    }
 }
 
 
@@ -357,13 +473,9 @@ fillRecordAndKey(
     skstream_t         *stream,
     uint8_t            *buf)
 {
-    rwRec *rwrec = (rwRec*)buf;
-    skplugin_err_t err;
-    const char **name;
-    size_t i;
     int rv;
 
-    rv = skStreamReadRecord(stream, rwrec);
+    rv = skStreamReadRecord(stream, (rwRec*)buf);
     if (rv) {
         /* end of file or error getting record */
         if (SKSTREAM_ERR_EOF != rv) {
@@ -372,19 +484,40 @@ fillRecordAndKey(
         return 0;
     }
 
-    /* lookup data from plug-in */
-    for (i = 0; i < key_num_fields; ++i) {
-        err = skPluginFieldRunRecToBinFn(key_fields[i].kf_field_handle,
-                                         &(buf[key_fields[i].kf_offset]),
-                                         rwrec, NULL);
-        if (err != SKPLUGIN_OK) {
-            skPluginFieldName(key_fields[i].kf_field_handle, &name);
-            skAppPrintErr(("Plugin-based field %s failed "
-                           "converting to binary "
-                           "with error code %d"), name[0], err);
-            appExit(EXIT_FAILURE);
+    fillKey(buf);
+    return 1;
+}
+
+
+/*
+ *  status = readRecordAndKey(reader, buf);
+ *
+ *    Behaves as fillRecordAndKey() on the stream of 'reader', but
+ *    takes the record from the block of records that 'reader' reads
+ *    from its stream with skStreamReadRecords().
+ */
+static int
+readRecordAndKey(
+    sort_reader_t      *reader,
+    uint8_t            *buf)
+{
+    int rv;
+
+    if (reader->pos == reader->count) {
+        reader->pos = 0;
+        rv = skStreamReadRecords(reader->stream, reader->recs,
+                                 SORT_READ_RECS, &reader->count);
+        if (rv && SKSTREAM_ERR_EOF != rv) {
+            skStreamPrintLastErr(reader->stream, rv, &skAppPrintErr);
+        }
+        if (0 == reader->count) {
+            return 0;
         }
     }
+
+    memcpy(buf, &reader->recs[reader->pos], sizeof(rwRec));
+    ++reader->pos;
+    fillKey(buf);
     return 1;
 }
 
@@ -431,148 +564,1065 @@ sortTempReopen(
 }
 
 /*
- *    Close a temporary file.  Exit the application if stream was open
- *    for write and closing fails.
+ *    Close a temporary file.  Exit the application if stream was open
+ *    for write and closing fails.
+ */
+static void
+sortTempClose(
+    skstream_t         *stream)
+{
+    char errbuf[2 * PATH_MAX];
+    ssize_t rv;
+
+    rv = skStreamClose(stream);
+    switch (rv) {
+      case SKSTREAM_OK:
+      case SKSTREAM_ERR_NOT_OPEN:
+      case SKSTREAM_ERR_CLOSED:
+        skStreamDestroy(&stream);
+        return;
+      case SKSTREAM_ERR_NULL_ARGUMENT:
+        return;
+    }
+
+    skStreamLastErrMessage(stream, rv, errbuf, sizeof(errbuf));
+    skAppPrintErr("Error closing temporary file: %s", errbuf);
+    if (skStreamGetMode(stream) == SK_IO_WRITE) {
+        appExit(EXIT_FAILURE);
+    }
+    skStreamDestroy(&stream);
+}
+
+/*
+ *    Read 'str_size' bytes from 'str_stream' into 'str_buf'.  Return
+ *    'str_size' on success or 0 for other condition (end-of-file,
+ *    short read, error).
+ */
+#define sortTempRead(str_stream, str_buf, str_size)                     \
+    sortTempReadHelper(str_stream, str_buf, str_size, __FILE__, __LINE__)
+
+static ssize_t
+sortTempReadHelper(
+    skstream_t         *stream,
+    void               *buf,
+    size_t              size,
+    const char         *file_name,
+    int                 file_line)
+{
+    ssize_t rv;
+
+    rv = skStreamRead(stream, buf, size);
+    if (rv == (ssize_t)size) {
+        return rv;
+    }
+#if TRACEMSG_LEVEL == 0
+    (void)file_name;
+    (void)file_line;
+#else
+    if (rv == 0) {
+        TRACEMSG(("%s:%d: Failed to read %" SK_PRIuZ " bytes: EOF on '%s'",
+                  file_name, file_line, size, skStreamGetPathname(stream)));
+    } else if (rv > 0) {
+        TRACEMSG(("%s:%d: Failed to read %" SK_PRIuZ " bytes:"
+                  " Short read of %" SK_PRIdZ " on '%s'",
+                  file_name, file_line, size, rv, skStreamGetPathname(stream)));
+    } else {
+        char errbuf[2 * PATH_MAX];
+
+        skStreamLastErrMessage(stream, rv, errbuf, sizeof(errbuf));
+        TRACEMSG(("%s:%d: Failed to read %" SK_PRIuZ " bytes: %s",
+                  file_name, file_line, size, errbuf));
+    }
+#endif
+    return 0;
+}
+
+
+/*
+ *    Write 'stw_size' bytes from 'stw_buf' to 'stw_stream'.  Return
+ *    'stw_size' on success and exit the appliation on error or short
+ *    write.
+ */
+#define sortTempWrite(stw_stream, stw_buf, stw_size)                    \
+    sortTempWriteHelper(stw_stream, stw_buf, stw_size, __FILE__, __LINE__)
+
+static void
+sortTempWriteHelper(
+    skstream_t         *stream,
+    const void         *buf,
+    size_t              size,
+    const char         *file_name,
+    int                 file_line)
+{
+    char errbuf[2 * PATH_MAX];
+    ssize_t rv;
+
+    rv = skStreamWrite(stream, buf, size);
+    if (rv == (ssize_t)size) {
+        return;
+    }
+    skStreamLastErrMessage(stream, rv, errbuf, sizeof(errbuf));
+
+#if TRACEMSG_LEVEL == 0
+    (void)file_name;
+    (void)file_line;
+#else
+    if (rv >= 0) {
+        TRACEMSG(("%s:%d: Failed to write %" SK_PRIuZ " bytes:"
+                  " Short write of %" SK_PRIdZ " on '%s'",
+                  file_name, file_line, size, rv, skStreamGetPathname(stream)));
+    } else {
+        TRACEMSG(("%s:%d: Failed to write %" SK_PRIuZ " bytes: %s",
+                  file_name, file_line, size, errbuf));
+    }
+#endif
+
+    if (rv >= 0) {
+        snprintf(errbuf,sizeof(errbuf),
+                 "Short write of %" SK_PRIdZ " bytes to '%s'",
+                 rv, skStreamGetPathname(stream));
+    }
+    skAppPrintErr("Error writing to temporary file: %s", errbuf);
+    appExit(EXIT_FAILURE);
+}
+
+/*
+ *    Write the contents of 'rec_buffer' to a new temp file, where
+ *    'rec_buffer' contains 'rec_count' records of size 'rec_size'.
+ *    Fill 'tmp_idx' with the new temporary file's index.  Exit the
+ *    application on error.
+ */
+static void
+sortTempWriteBuffer(
+    int                *tmp_idx,
+    const void         *rec_buffer,
+    uint32_t            rec_size,
+    uint32_t            rec_count)
+{
+    if (skTempFileWriteBufferStream(tmpctx, tmp_idx, rec_buffer,
+                                    rec_size, rec_count))
+    {
+        skAppPrintErr("Error saving sorted buffer to temporary file: %s",
+                      strerror(errno));
+        appExit(EXIT_FAILURE);
+    }
+}
+
+
+#ifndef SKTHREAD_UNKNOWN_ID
+/* Create a local copy of the function from libsilk-thrd. */
+/*
+ *    Tell the current thread to ignore all signals except those
+ *    indicating a failure (e.g., SIGBUS and SIGSEGV).
+ */
+static void
+skthread_ignore_signals(
+    void)
+{
+    sigset_t sigs;
+
+    sigfillset(&sigs);
+    sigdelset(&sigs, SIGABRT);
+    sigdelset(&sigs, SIGBUS);
+    sigdelset(&sigs, SIGILL);
+    sigdelset(&sigs, SIGSEGV);
+
+#ifdef SIGEMT
+    sigdelset(&sigs, SIGEMT);
+#endif
+#ifdef SIGIOT
+    sigdelset(&sigs, SIGIOT);
+#endif
+#ifdef SIGSYS
+    sigdelset(&sigs, SIGSYS);
+#endif
+
+    pthread_sigmask(SIG_SETMASK, &sigs, NULL);
+}
+#endif  /* #ifndef SKTHREAD_UNKNOWN_ID */
+
+
+/*
+ *  sortWriteNode(stream, node);
+ *
+ *    Write the record in 'node' to the temporary file 'stream', or
+ *    to the output stream when 'stream' is NULL.  Exit the
+ *    application on a fatal error.
+ */
+static void
+sortWriteNode(
+    skstream_t         *stream,
+    const uint8_t      *node)
+{
+    int rv;
+
+    if (stream) {
+        sortTempWrite(stream, node, node_size);
+        return;
+    }
+    rv = skStreamWriteRecord(out_stream, (const rwRec*)node);
+    if (0 != rv) {
+        skStreamPrintLastErr(out_stream, rv, &skAppPrintErr);
+        if (SKSTREAM_ERROR_IS_FATAL(rv)) {
+            appExit(EXIT_FAILURE);
+        }
+    }
+}
+
+
+/*
+ *  width = sortKeyFieldWidth(field_id, ipv6);
+ *
+ *    Return the number of octets that the field 'field_id' occupies
+ *    in the normalized key, where 'ipv6' is non-zero when the IP
+ *    addresses require 16 octets.  Return 0 for a field that comes
+ *    from a plug-in.
+ */
+static size_t
+sortKeyFieldWidth(
+    uint32_t            field_id,
+    int                 ipv6)
+{
+    switch (field_id) {
+      case RWREC_FIELD_SIP:
+      case RWREC_FIELD_DIP:
+      case RWREC_FIELD_NHIP:
+        return ((ipv6) ? 16 : 4);
+
+      case RWREC_FIELD_STIME:
+      case RWREC_FIELD_STIME_MSEC:
+      case RWREC_FIELD_ETIME:
+      case RWREC_FIELD_ETIME_MSEC:
+        return 8;
+
+      case RWREC_FIELD_PKTS:
+      case RWREC_FIELD_BYTES:
+      case RWREC_FIELD_ELAPSED:
+      case RWREC_FIELD_ELAPSED_MSEC:
+        return 4;
+
+      case RWREC_FIELD_SPORT:
+      case RWREC_FIELD_DPORT:
+      case RWREC_FIELD_SID:
+      case RWREC_FIELD_INPUT:
+      case RWREC_FIELD_OUTPUT:
+      case RWREC_FIELD_APPLICATION:
+        return 2;
+
+      case RWREC_FIELD_PROTO:
+      case RWREC_FIELD_FLAGS:
+      case RWREC_FIELD_INIT_FLAGS:
+      case RWREC_FIELD_REST_FLAGS:
+      case RWREC_FIELD_TCP_STATE:
+      case RWREC_FIELD_FTYPE_CLASS:
+      case RWREC_FIELD_FTYPE_TYPE:
+      case RWREC_FIELD_ICMP_TYPE:
+      case RWREC_FIELD_ICMP_CODE:
+        return 1;
+
+      default:
+        return 0;
+    }
+}
+
+
+/* Append the 'n'-octet value 'v' to the key 'k' in big-endian order */
+#define KEY_PUT(k, v, n)                                \
+    {                                                   \
+        uint64_t kp_v = (uint64_t)(v);                  \
+        size_t kp_i;                                    \
+        for (kp_i = (n); kp_i > 0; --kp_i) {            \
+            (k)[kp_i - 1] = (uint8_t)(kp_v & 0xFF);     \
+            kp_v >>= 8;                                 \
+        }                                               \
+        (k) += (n);                                     \
+    }
+
+/* Append an IP address to the key 'k' */
+#if !SK_ENABLE_IPV6
+#define KEY_PUT_IP(k, func, rec, ipv6)                  \
+    KEY_PUT(k, func(rec), 4)
+#else
+#define KEY_PUT_IP(k, func, rec, ipv6)                  \
+    {                                                   \
+        skipaddr_t kpi_ip;                              \
+        func(rec, &kpi_ip);                             \
+        if (ipv6) {                                     \
+            skipaddrGetAsV6(&kpi_ip, (k));              \
+            (k) += 16;                                  \
+        } else {                                        \
+            KEY_PUT(k, skipaddrGetV4(&kpi_ip), 4);      \
+        }                                               \
+    }
+#endif  /* SK_ENABLE_IPV6 */
+
+
+/*
+ *  sortKeyFill(key, rec, field_count, ipv6);
+ *
+ *    Write into 'key' the normalized key of the record 'rec' for the
+ *    first 'field_count' fields in sort_fields[], where 'ipv6' is as
+ *    for sortKeyFieldWidth().  Comparing two keys with memcmp() gives
+ *    the same order as rwrecCompare() does on those fields.
+ */
+static void
+sortKeyFill(
+    uint8_t            *key,
+    const rwRec        *rec,
+    uint32_t            field_count,
+    int                 ipv6)
+{
+    uint8_t *k = key;
+    uint32_t i;
+
+    (void)ipv6;
+
+    for (i = 0; i < field_count; ++i) {
+        switch (sort_fields[i]) {
+          case RWREC_FIELD_SIP:
+#if !SK_ENABLE_IPV6
+            KEY_PUT_IP(k, rwRecGetSIPv4, rec, ipv6);
+#else
+            KEY_PUT_IP(k, rwRecMemGetSIP, rec, ipv6);
+#endif
+            break;
+          case RWREC_FIELD_DIP:
+#if !SK_ENABLE_IPV6
+            KEY_PUT_IP(k, rwRecGetDIPv4, rec, ipv6);
+#else
+            KEY_PUT_IP(k, rwRecMemGetDIP, rec, ipv6);
+#endif
+            break;
+          case RWREC_FIELD_NHIP:
+#if !SK_ENABLE_IPV6
+            KEY_PUT_IP(k, rwRecGetNhIPv4, rec, ipv6);
+#else
+            KEY_PUT_IP(k, rwRecMemGetNhIP, rec, ipv6);
+#endif
+            break;
+          case RWREC_FIELD_SPORT:
+            KEY_PUT(k, rwRecGetSPort(rec), 2);
+            break;
+          case RWREC_FIELD_DPORT:
+            KEY_PUT(k, rwRecGetDPort(rec), 2);
+            break;
+          case RWREC_FIELD_PROTO:
+            KEY_PUT(k, rwRecGetProto(rec), 1);
+            break;
+          case RWREC_FIELD_PKTS:
+            KEY_PUT(k, rwRecGetPkts(rec), 4);
+            break;
+          case RWREC_FIELD_BYTES:
+            KEY_PUT(k, rwRecGetBytes(rec), 4);
+            break;
+          case RWREC_FIELD_FLAGS:
+            KEY_PUT(k, rwRecGetFlags(rec), 1);
+            break;
+          case RWREC_FIELD_STIME:
+          case RWREC_FIELD_STIME_MSEC:
+            /* flip the sign bit so negative times sort first */
+            KEY_PUT(k, ((uint64_t)rwRecGetStartTime(rec)
+                        ^ UINT64_C(0x8000000000000000)), 8);
+            break;
+          case RWREC_FIELD_ELAPSED:
+          case RWREC_FIELD_ELAPSED_MSEC:
+            KEY_PUT(k, rwRecGetElapsed(rec), 4);
+            break;
+          case RWREC_FIELD_ETIME:
+          case RWREC_FIELD_ETIME_MSEC:
+            KEY_PUT(k, ((uint64_t)rwRecGetEndTime(rec)
+                        ^ UINT64_C(0x8000000000000000)), 8);
+            break;
+          case RWREC_FIELD_SID:
+            KEY_PUT(k, rwRecGetSensor(rec), 2);
+            break;
+          case RWREC_FIELD_INPUT:
+            KEY_PUT(k, rwRecGetInput(rec), 2);
+            break;
+          case RWREC_FIELD_OUTPUT:
+            KEY_PUT(k, rwRecGetOutput(rec), 2);
+            break;
+          case RWREC_FIELD_INIT_FLAGS:
+            KEY_PUT(k, rwRecGetInitFlags(rec), 1);
+            break;
+          case RWREC_FIELD_REST_FLAGS:
+            KEY_PUT(k, rwRecGetRestFlags(rec), 1);
+            break;
+          case RWREC_FIELD_TCP_STATE:
+            KEY_PUT(k, rwRecGetTcpState(rec), 1);
+            break;
+          case RWREC_FIELD_APPLICATION:
+            KEY_PUT(k, rwRecGetApplication(rec), 2);
+            break;
+          case RWREC_FIELD_FTYPE_CLASS:
+          case RWREC_FIELD_FTYPE_TYPE:
+            KEY_PUT(k, rwRecGetFlowType(rec), 1);
+            break;
+          case RWREC_FIELD_ICMP_TYPE:
+            KEY_PUT(k, getIcmpType(rec), 1);
+            break;
+          case RWREC_FIELD_ICMP_CODE:
+            KEY_PUT(k, getIcmpCode(rec), 1);
+            break;
+          default:
+            skAbortBadCase(sort_fields[i]);
+        }
+    }
+
+    /* handle --reverse by inverting the key */
+    if (reverse) {
+        for ( ; key < k; ++key) {
+            *key = ~*key;
+        }
+    }
+}
+
+
+/*
+ *  pos = sortIndexPosition(part, entry);
+ *
+ *    Return the position of the record in 'part' that the sort index
+ *    entry 'entry' references.  The position is stored in big-endian
+ *    order in the final four octets of the entry so that it acts as
+ *    the least significant part of the key.
+ */
+static uint32_t
+sortIndexPosition(
+    const sort_part_t  *part,
+    const uint8_t      *entry)
+{
+    const uint8_t *p = entry + part->entry_size - sizeof(uint32_t);
+
+    return (((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16)
+            | ((uint32_t)p[2] << 8) | (uint32_t)p[3]);
+}
+
+
+/*
+ *  status = compIndexEntries(a, b, v_part);
+ *
+ *    Callback function used by skQSort_r() to order the entries of
+ *    the sort index of the sort_part_t 'v_part' whose normalized keys
+ *    are identical.  Compares the records that the entries reference
+ *    and uses the position of the records to break a tie.
+ */
+static int
+compIndexEntries(
+    const void         *a,
+    const void         *b,
+    void               *v_part)
+{
+    const sort_part_t *part = (const sort_part_t*)v_part;
+    uint32_t idx_a;
+    uint32_t idx_b;
+    int rv;
+
+    idx_a = sortIndexPosition(part, (const uint8_t*)a);
+    idx_b = sortIndexPosition(part, (const uint8_t*)b);
+    rv = rwrecCompare(part->buffer + idx_a * node_size,
+                      part->buffer + idx_b * node_size);
+    if (rv) {
+        return rv;
+    }
+    return ((idx_a < idx_b) ? -1 : (idx_a > idx_b));
+}
+
+
+/*
+ *  sortPartition(part);
+ *
+ *    Sort the records in 'part'.  Create a sort index for the records
+ *    when the leading fields of the key can be normalized: each entry
+ *    in the index holds the normalized key of a record followed by
+ *    the record's position, and the index is sorted with
+ *    skRadixSort().  Since the position is part of the entry, records
+ *    with identical keys keep their input order.  Any fields that
+ *    follow a plug-in field are compared with rwrecCompare().
+ *
+ *    When the index cannot be created, sort the records themselves
+ *    with skQSort().
+ */
+static void
+sortPartition(
+    sort_part_t        *part)
+{
+    const uint8_t *node;
+    uint8_t *entry;
+    uint8_t *pos;
+    uint8_t *run;
+    uint32_t field_count;
+    size_t key_len = 0;
+    size_t width;
+    size_t c;
+    int ipv6 = 0;
+
+    part->pos = 0;
+    part->rec = part->buffer;
+    if (0 == part->count) {
+        part->rec = NULL;
+        return;
+    }
+
+#if SK_ENABLE_IPV6
+    for (c = 0, node = part->buffer; c < part->count; ++c, node += node_size){
+        if (rwRecIsIPv6((const rwRec*)node)) {
+            ipv6 = 1;
+            break;
+        }
+    }
+#endif
+
+    for (field_count = 0; field_count < num_fields; ++field_count) {
+        width = sortKeyFieldWidth(sort_fields[field_count], ipv6);
+        if (0 == width) {
+            break;
+        }
+        key_len += width;
+    }
+
+    if (key_len > 0 && part->count <= UINT32_MAX) {
+        part->entry_size = key_len + sizeof(uint32_t);
+        part->index = (uint8_t*)malloc(part->count * part->entry_size);
+    }
+    if (NULL == part->index) {
+        TRACEMSG(("Sorting %" SK_PRIuZ " records with skQSort()",
+                  part->count));
+        skQSort(part->buffer, part->count, node_size, &rwrecCompare);
+        return;
+    }
+
+    for (c = 0, node = part->buffer, entry = part->index;
+         c < part->count;
+         ++c, node += node_size, entry += part->entry_size)
+    {
+        sortKeyFill(entry, (const rwRec*)node, field_count, ipv6);
+        pos = entry + key_len;
+        KEY_PUT(pos, c, sizeof(uint32_t));
+    }
+
+    if (field_count == num_fields) {
+        /* the key and position determine the order */
+        skRadixSort(part->index, part->count, part->entry_size,
+                    part->entry_size);
+    } else {
+        /* sort by the normalized key, then sort each run of entries
+         * with the same normalized key on the remaining fields */
+        skRadixSort(part->index, part->count, part->entry_size, key_len);
+        run = part->index;
+        entry = run + part->entry_size;
+        for (c = 1; c <= part->count; ++c, entry += part->entry_size) {
+            if (c < part->count && 0 == memcmp(run, entry, key_len)) {
+                continue;
+            }
+            if (entry - run > (ptrdiff_t)part->entry_size) {
+                skQSort_r(run, (entry - run) / part->entry_size,
+                          part->entry_size, &compIndexEntries, part);
+            }
+            run = entry;
+        }
+    }
+
+    part->rec = (part->buffer
+                 + sortIndexPosition(part, part->index) * node_size);
+}
+
+
+/*
+ *  rec = sortPartitionNext(part);
+ *
+ *    Move to the next record in sorted order in 'part', which
+ *    sortPartition() has sorted, and return it.  Return NULL when no
+ *    records remain.
+ */
+static uint8_t *
+sortPartitionNext(
+    sort_part_t        *part)
+{
+    const uint8_t *entry;
+
+    if (++part->pos >= part->count) {
+        part->rec = NULL;
+    } else if (part->index) {
+        entry = part->index + part->pos * part->entry_size;
+        part->rec = (part->buffer
+                     + sortIndexPosition(part, entry) * node_size);
+    } else {
+        part->rec += node_size;
+    }
+    return part->rec;
+}
+
+
+/*
+ *  status = compPartNodes(b, a, v_parts);
+ *
+ *    Callback function used by the heap that merges the sorted
+ *    partitions of a buffer.  The heap nodes are indexes into the
+ *    array of sort_part_t in 'v_parts'.  Records that compare equal
+ *    are taken from the earlier partition first.
+ *
+ *    Note the order of arguments is 'b', 'a'.
+ */
+static int
+compPartNodes(
+    const skheapnode_t  b,
+    const skheapnode_t  a,
+    void               *v_parts)
+{
+    sort_part_t *parts = (sort_part_t*)v_parts;
+    uint16_t idx_a = *(uint16_t*)a;
+    uint16_t idx_b = *(uint16_t*)b;
+    int rv;
+
+    rv = rwrecCompare(parts[idx_a].rec, parts[idx_b].rec);
+    if (rv) {
+        return rv;
+    }
+    return ((idx_a < idx_b) ? -1 : (idx_a > idx_b));
+}
+
+
+/*
+ *  sortPartitionThread(&part);
+ *
+ *    THREAD ENTRY POINT.
+ *
+ *    Sort the records in the partition 'part' of a buffer.
+ */
+static void *
+sortPartitionThread(
+    void               *v_part)
+{
+    skthread_ignore_signals();
+
+    sortPartition((sort_part_t*)v_part);
+    return NULL;
+}
+
+
+/*
+ *  sortWriteBuffer(record_buffer, record_count, temp_idx);
+ *
+ *    Sort the 'record_count' records in 'record_buffer'.  When
+ *    'temp_idx' is NULL, write the sorted records to the output
+ *    stream; otherwise, write them to a new temporary file and put
+ *    the index of that file in 'temp_idx'.
+ *
+ *    When 'thread_count' is greater than 1, divide the buffer into
+ *    partitions, sort the partitions in parallel, and merge the
+ *    partitions as the records are written.  Exit the application on
+ *    error.
+ */
+static void
+sortWriteBuffer(
+    uint8_t            *record_buffer,
+    size_t              record_count,
+    int                *temp_idx)
+{
+    sort_part_t *parts;
+    skstream_t *stream = NULL;
+    skheap_t *heap;
+    size_t part_count;
+    size_t part_recs;
+    uint16_t *top_heap;
+    uint16_t lowest;
+    uint16_t i;
+
+    /* do not create tiny partitions */
+    part_count = thread_count;
+    if (part_count > record_count / MIN_IN_CORE_RECORDS) {
+        part_count = record_count / MIN_IN_CORE_RECORDS;
+    }
+    if (part_count > MAX_MERGE_FILES) {
+        part_count = MAX_MERGE_FILES;
+    } else if (part_count < 1) {
+        part_count = 1;
+    }
+
+    parts = (sort_part_t*)calloc(part_count, sizeof(sort_part_t));
+    if (NULL == parts) {
+        skAppPrintOutOfMemory("sort partitions");
+        appExit(EXIT_FAILURE);
+    }
+
+    /* divide the buffer and start a thread to sort each partition;
+     * this thread sorts the final partition and any partition whose
+     * thread could not be created */
+    TRACEMSG(("Sorting %" SK_PRIuZ " records in %" SK_PRIuZ " partitions...",
+              record_count, part_count));
+    part_recs = record_count / part_count;
+    for (i = 0; i < part_count; ++i) {
+        parts[i].buffer = record_buffer + i * part_recs * node_size;
+        parts[i].count = part_recs;
+        if (i + 1u == part_count) {
+            parts[i].count = record_count - i * part_recs;
+        } else if (0 == pthread_create(&parts[i].thread, NULL,
+                                       &sortPartitionThread, &parts[i]))
+        {
+            parts[i].started = 1;
+        }
+    }
+    for (i = 0; i < part_count; ++i) {
+        if (parts[i].started) {
+            pthread_join(parts[i].thread, NULL);
+        } else {
+            sortPartition(&parts[i]);
+        }
+    }
+    TRACEMSG(("Sorting %" SK_PRIuZ " records in %" SK_PRIuZ
+              " partitions...done", record_count, part_count));
+
+    if (1 == part_count && NULL == parts[0].index && temp_idx) {
+        /* the records were sorted in place; write them at once */
+        sortTempWriteBuffer(temp_idx, record_buffer, node_size,
+                            record_count);
+        free(parts);
+        return;
+    }
+
+    if (temp_idx) {
+        stream = sortTempCreate(temp_idx);
+    } else {
+        TRACEMSG((("Writing %" SK_PRIuZ " records to '%s'"),
+                  record_count, skStreamGetPathname(out_stream)));
+    }
+
+    if (1 == part_count) {
+        for ( ; parts[0].rec; sortPartitionNext(&parts[0])) {
+            sortWriteNode(stream, parts[0].rec);
+        }
+    } else {
+        /* merge the partitions as they are written */
+        heap = skHeapCreate2(compPartNodes, part_count, sizeof(uint16_t),
+                             NULL, parts);
+        if (NULL == heap) {
+            skAppPrintOutOfMemory("heap");
+            appExit(EXIT_FAILURE);
+        }
+        for (i = 0; i < part_count; ++i) {
+            if (parts[i].rec) {
+                skHeapInsert(heap, &i);
+            }
+        }
+        while (skHeapPeekTop(heap, (skheapnode_t*)&top_heap) == SKHEAP_OK) {
+            lowest = *top_heap;
+            sortWriteNode(stream, parts[lowest].rec);
+            if (sortPartitionNext(&parts[lowest])) {
+                skHeapReplaceTop(heap, &lowest, NULL);
+            } else {
+                skHeapExtractTop(heap, NULL);
+            }
+        }
+        skHeapFree(heap);
+    }
+
+    if (stream) {
+        sortTempClose(stream);
+    }
+    for (i = 0; i < part_count; ++i) {
+        free(parts[i].index);
+    }
+    free(parts);
+}
+
+
+/*
+ *  sortRunThread(&run);
+ *
+ *    THREAD ENTRY POINT.
+ *
+ *    Sort the buffer described by 'run' and write it to a temporary
+ *    file.
+ */
+static void *
+sortRunThread(
+    void               *v_run)
+{
+    sort_run_t *run = (sort_run_t*)v_run;
+
+    skthread_ignore_signals();
+
+    sortWriteBuffer(run->buffer, run->count, run->temp_idx);
+    return NULL;
+}
+
+
+/*
+ *  sortRunStart(run, record_buffer, record_count, temp_idx);
+ *
+ *    Start a background thread that sorts the 'record_count' records
+ *    in 'record_buffer' and writes them to a new temporary file whose
+ *    index is put into 'temp_idx'.  If the thread cannot be created,
+ *    sort and write the records before returning.
+ */
+static void
+sortRunStart(
+    sort_run_t         *run,
+    uint8_t            *record_buffer,
+    size_t              record_count,
+    int                *temp_idx)
+{
+    assert(!run->active);
+
+    run->buffer = record_buffer;
+    run->count = record_count;
+    run->temp_idx = temp_idx;
+    if (0 == pthread_create(&run->thread, NULL, &sortRunThread, run)) {
+        run->active = 1;
+    } else {
+        TRACEMSG(("pthread_create() failed"));
+        sortWriteBuffer(record_buffer, record_count, temp_idx);
+    }
+}
+
+
+/*
+ *  sortRunWait(run);
+ *
+ *    Wait for the background thread started by sortRunStart(), if
+ *    any, to finish.
  */
 static void
-sortTempClose(
-    skstream_t         *stream)
+sortRunWait(
+    sort_run_t         *run)
 {
-    char errbuf[2 * PATH_MAX];
-    ssize_t rv;
-
-    rv = skStreamClose(stream);
-    switch (rv) {
-      case SKSTREAM_OK:
-      case SKSTREAM_ERR_NOT_OPEN:
-      case SKSTREAM_ERR_CLOSED:
-        skStreamDestroy(&stream);
-        return;
-      case SKSTREAM_ERR_NULL_ARGUMENT:
-        return;
+    if (run->active) {
+        pthread_join(run->thread, NULL);
+        run->active = 0;
     }
+}
 
-    skStreamLastErrMessage(stream, rv, errbuf, sizeof(errbuf));
-    skAppPrintErr("Error closing temporary file: %s", errbuf);
-    if (skStreamGetMode(stream) == SK_IO_WRITE) {
-        appExit(EXIT_FAILURE);
+
+/*
+ *  status = compGroupNodes(b, a, v_groups);
+ *
+ *    Callback function used by the heap that merges the records from
+ *    the merge groups.  The heap nodes are indexes into the array of
+ *    merge_group_t in 'v_groups'.  Records that compare equal are
+ *    taken from the earlier group first.
+ *
+ *    Note the order of arguments is 'b', 'a'.
+ */
+static int
+compGroupNodes(
+    const skheapnode_t  b,
+    const skheapnode_t  a,
+    void               *v_groups)
+{
+    merge_group_t *groups = (merge_group_t*)v_groups;
+    uint16_t idx_a = *(uint16_t*)a;
+    uint16_t idx_b = *(uint16_t*)b;
+    int rv;
+
+    rv = rwrecCompare(groups[idx_a].rec, groups[idx_b].rec);
+    if (rv) {
+        return rv;
     }
-    skStreamDestroy(&stream);
+    return ((idx_a < idx_b) ? -1 : (idx_a > idx_b));
 }
 
+
 /*
- *    Read 'str_size' bytes from 'str_stream' into 'str_buf'.  Return
- *    'str_size' on success or 0 for other condition (end-of-file,
- *    short read, error).
+ *  mergeGroupThread(&group);
+ *
+ *    THREAD ENTRY POINT.
+ *
+ *    Merge the temporary files in 'group', whose first records have
+ *    already been read, and fill the group's blocks with the merged
+ *    records.
  */
-#define sortTempRead(str_stream, str_buf, str_size)                     \
-    sortTempReadHelper(str_stream, str_buf, str_size, __FILE__, __LINE__)
-
-static ssize_t
-sortTempReadHelper(
-    skstream_t         *stream,
-    void               *buf,
-    size_t              size,
-    const char         *file_name,
-    int                 file_line)
+static void *
+mergeGroupThread(
+    void               *v_group)
 {
-    ssize_t rv;
+    merge_group_t *group = (merge_group_t*)v_group;
+    skheap_t *heap;
+    uint16_t *top_heap;
+    uint16_t lowest;
+    uint16_t i;
+    unsigned int b = 0;
+    size_t n = 0;
 
-    rv = skStreamRead(stream, buf, size);
-    if (rv == (ssize_t)size) {
-        return rv;
+    skthread_ignore_signals();
+
+    heap = skHeapCreate2(compHeapNodes, group->count, sizeof(uint16_t),
+                         NULL, group->recs);
+    if (NULL == heap) {
+        skAppPrintOutOfMemory("heap");
+        appExit(EXIT_FAILURE);
+    }
+    for (i = group->first; i < group->first + group->count; ++i) {
+        skHeapInsert(heap, &i);
     }
-#if TRACEMSG_LEVEL == 0
-    (void)file_name;
-    (void)file_line;
-#else
-    if (rv == 0) {
-        TRACEMSG(("%s:%d: Failed to read %" SK_PRIuZ " bytes: EOF on '%s'",
-                  file_name, file_line, size, skStreamGetPathname(stream)));
-    } else if (rv > 0) {
-        TRACEMSG(("%s:%d: Failed to read %" SK_PRIuZ " bytes:"
-                  " Short read of %" SK_PRIdZ " on '%s'",
-                  file_name, file_line, size, rv, skStreamGetPathname(stream)));
-    } else {
-        char errbuf[2 * PATH_MAX];
 
-        skStreamLastErrMessage(stream, rv, errbuf, sizeof(errbuf));
-        TRACEMSG(("%s:%d: Failed to read %" SK_PRIuZ " bytes: %s",
-                  file_name, file_line, size, errbuf));
+    while (skHeapPeekTop(heap, (skheapnode_t*)&top_heap) == SKHEAP_OK) {
+        if (0 == n) {
+            /* wait for the main thread to empty this block */
+            pthread_mutex_lock(&group->mutex);
+            while (group->block_count[b]) {
+                pthread_cond_wait(&group->cond, &group->mutex);
+            }
+            pthread_mutex_unlock(&group->mutex);
+        }
+
+        lowest = *top_heap;
+        memcpy(group->block[b] + n * node_size, group->recs[lowest],
+               node_size);
+        if (sortTempRead(group->fps[lowest], group->recs[lowest], node_size)){
+            skHeapReplaceTop(heap, &lowest, NULL);
+        } else {
+            skHeapExtractTop(heap, NULL);
+        }
+
+        if (++n == MERGE_BLOCK_RECS) {
+            pthread_mutex_lock(&group->mutex);
+            group->block_count[b] = n;
+            pthread_cond_signal(&group->cond);
+            pthread_mutex_unlock(&group->mutex);
+            b = 1 - b;
+            n = 0;
+        }
     }
-#endif
-    return 0;
+
+    pthread_mutex_lock(&group->mutex);
+    group->block_count[b] = n;
+    group->done = 1;
+    pthread_cond_signal(&group->cond);
+    pthread_mutex_unlock(&group->mutex);
+
+    skHeapFree(heap);
+    return NULL;
 }
 
 
 /*
- *    Write 'stw_size' bytes from 'stw_buf' to 'stw_stream'.  Return
- *    'stw_size' on success and exit the appliation on error or short
- *    write.
+ *  rec = mergeGroupNext(group);
+ *
+ *    Set the current record of 'group' to the next record that its
+ *    thread has merged and return it, waiting for the thread if
+ *    needed.  Return NULL once the group has no more records.
  */
-#define sortTempWrite(stw_stream, stw_buf, stw_size)                    \
-    sortTempWriteHelper(stw_stream, stw_buf, stw_size, __FILE__, __LINE__)
-
-static void
-sortTempWriteHelper(
-    skstream_t         *stream,
-    const void         *buf,
-    size_t              size,
-    const char         *file_name,
-    int                 file_line)
+static uint8_t *
+mergeGroupNext(
+    merge_group_t      *group)
 {
-    char errbuf[2 * PATH_MAX];
-    ssize_t rv;
+    size_t n;
 
-    rv = skStreamWrite(stream, buf, size);
-    if (rv == (ssize_t)size) {
-        return;
+    if (group->rec) {
+        if (++group->read_pos < group->block_count[group->read_block]) {
+            group->rec += node_size;
+            return group->rec;
+        }
+        /* hand the block back to the thread */
+        pthread_mutex_lock(&group->mutex);
+        group->block_count[group->read_block] = 0;
+        pthread_cond_signal(&group->cond);
+        pthread_mutex_unlock(&group->mutex);
+        group->read_block = 1 - group->read_block;
     }
-    skStreamLastErrMessage(stream, rv, errbuf, sizeof(errbuf));
 
-#if TRACEMSG_LEVEL == 0
-    (void)file_name;
-    (void)file_line;
-#else
-    if (rv >= 0) {
-        TRACEMSG(("%s:%d: Failed to write %" SK_PRIuZ " bytes:"
-                  " Short write of %" SK_PRIdZ " on '%s'",
-                  file_name, file_line, size, rv, skStreamGetPathname(stream)));
-    } else {
-        TRACEMSG(("%s:%d: Failed to write %" SK_PRIuZ " bytes: %s",
-                  file_name, file_line, size, errbuf));
+    pthread_mutex_lock(&group->mutex);
+    while (0 == group->block_count[group->read_block] && !group->done) {
+        pthread_cond_wait(&group->cond, &group->mutex);
     }
-#endif
+    n = group->block_count[group->read_block];
+    pthread_mutex_unlock(&group->mutex);
 
-    if (rv >= 0) {
-        snprintf(errbuf,sizeof(errbuf),
-                 "Short write of %" SK_PRIdZ " bytes to '%s'",
-                 rv, skStreamGetPathname(stream));
-    }
-    skAppPrintErr("Error writing to temporary file: %s", errbuf);
-    appExit(EXIT_FAILURE);
+    group->read_pos = 0;
+    group->rec = ((n) ? group->block[group->read_block] : NULL);
+    return group->rec;
 }
 
+
 /*
- *    Write the contents of 'rec_buffer' to a new temp file, where
- *    'rec_buffer' contains 'rec_count' records of size 'rec_size'.
- *    Fill 'tmp_idx' with the new temporary file's index.  Exit the
- *    application on error.
+ *  mergeFilesThreaded(fps, recs, open_count);
+ *
+ *    Merge the 'open_count' temporary files in 'fps', whose first
+ *    records are in 'recs', into the output stream.  Divide the files
+ *    into one group per thread; each thread merges the files in its
+ *    group, and this thread merges the groups.  Exit the application
+ *    on error.
  */
 static void
-sortTempWriteBuffer(
-    int                *tmp_idx,
-    const void         *rec_buffer,
-    uint32_t            rec_size,
-    uint32_t            rec_count)
+mergeFilesThreaded(
+    skstream_t         *fps[],
+    uint8_t             recs[][MAX_NODE_SIZE],
+    uint16_t            open_count)
 {
-    if (skTempFileWriteBufferStream(tmpctx, tmp_idx, rec_buffer,
-                                    rec_size, rec_count))
-    {
-        skAppPrintErr("Error saving sorted buffer to temporary file: %s",
-                      strerror(errno));
+    merge_group_t *groups;
+    skheap_t *heap;
+    uint16_t group_count;
+    uint16_t *top_heap;
+    uint16_t lowest;
+    uint16_t i;
+
+    group_count = open_count;
+    if (group_count > thread_count) {
+        group_count = (uint16_t)thread_count;
+    }
+
+    TRACEMSG((("Merging %" PRIu16 " temporary files in %" PRIu16 " groups"),
+              open_count, group_count));
+
+    groups = (merge_group_t*)calloc(group_count, sizeof(merge_group_t));
+    if (NULL == groups) {
+        skAppPrintOutOfMemory("merge groups");
+        appExit(EXIT_FAILURE);
+    }
+    heap = skHeapCreate2(compGroupNodes, group_count, sizeof(uint16_t),
+                         NULL, groups);
+    if (NULL == heap) {
+        skAppPrintOutOfMemory("heap");
         appExit(EXIT_FAILURE);
     }
+
+    for (i = 0; i < group_count; ++i) {
+        groups[i].fps = fps;
+        groups[i].recs = recs;
+        groups[i].first = (uint16_t)((uint32_t)i * open_count / group_count);
+        groups[i].count = (uint16_t)((uint32_t)(i + 1) * open_count
+                                     / group_count) - groups[i].first;
+        groups[i].block[0] = (uint8_t*)malloc(2*MERGE_BLOCK_RECS * node_size);
+        if (NULL == groups[i].block[0]) {
+            skAppPrintOutOfMemory("merge block");
+            appExit(EXIT_FAILURE);
+        }
+        groups[i].block[1] = groups[i].block[0] + MERGE_BLOCK_RECS*node_size;
+        pthread_mutex_init(&groups[i].mutex, NULL);
+        pthread_cond_init(&groups[i].cond, NULL);
+        errno = pthread_create(&groups[i].thread, NULL, &mergeGroupThread,
+                               &groups[i]);
+        if (errno) {
+            skAppPrintSyserror("Unable to create merge thread");
+            appExit(EXIT_FAILURE);
+        }
+    }
+
+    /* prime the heap with the first record from each group */
+    for (i = 0; i < group_count; ++i) {
+        if (mergeGroupNext(&groups[i])) {
+            skHeapInsert(heap, &i);
+        }
+    }
+
+    while (skHeapPeekTop(heap, (skheapnode_t*)&top_heap) == SKHEAP_OK) {
+        lowest = *top_heap;
+        sortWriteNode(NULL, groups[lowest].rec);
+        if (mergeGroupNext(&groups[lowest])) {
+            skHeapReplaceTop(heap, &lowest, NULL);
+        } else {
+            skHeapExtractTop(heap, NULL);
+        }
+    }
+
+    for (i = 0; i < group_count; ++i) {
+        pthread_join(groups[i].thread, NULL);
+        pthread_cond_destroy(&groups[i].cond);
+        pthread_mutex_destroy(&groups[i].mutex);
+        free(groups[i].block[0]);
+    }
+    skHeapFree(heap);
+    free(groups);
 }
 
 
@@ -699,66 +1749,74 @@ mergeFiles(
         heap_count = skHeapGetNumberEntries(heap);
         assert(heap_count == open_count);
 
-        /* exit this while() once we are only processing a single
-         * file */
-        while (heap_count > 1) {
-            /* entry at the top of the heap has the lowest key */
-            skHeapPeekTop(heap, (skheapnode_t*)&top_heap);
-            lowest = *top_heap;
-
-            /* write the lowest record */
-            if (fp_intermediate) {
-                /* write record to intermediate tmp file */
-                sortTempWrite(fp_intermediate, recs[lowest], node_size);
-            } else {
-                /* we successfully opened all (remaining) temp files,
-                 * write to record to the final destination */
-                rv = skStreamWriteRecord(out_stream,(rwRec*)recs[lowest]);
-                if (0 != rv) {
-                    skStreamPrintLastErr(out_stream, rv, &skAppPrintErr);
-                    if (SKSTREAM_ERROR_IS_FATAL(rv)) {
-                        appExit(EXIT_FAILURE);
+        if (NULL == fp_intermediate && thread_count > 1 && open_count > 1) {
+            /* merge groups of the files in parallel into the final
+             * destination */
+            skHeapEmpty(heap);
+            mergeFilesThreaded(fps, recs, open_count);
+        } else {
+            /* exit this while() once we are only processing a single
+             * file */
+            while (heap_count > 1) {
+                /* entry at the top of the heap has the lowest key */
+                skHeapPeekTop(heap, (skheapnode_t*)&top_heap);
+                lowest = *top_heap;
+
+                /* write the lowest record */
+                if (fp_intermediate) {
+                    /* write record to intermediate tmp file */
+                    sortTempWrite(fp_intermediate, recs[lowest], node_size);
+                } else {
+                    /* we successfully opened all (remaining) temp files,
+                     * write to record to the final destination */
+                    rv = skStreamWriteRecord(out_stream,(rwRec*)recs[lowest]);
+                    if (0 != rv) {
+                        skStreamPrintLastErr(out_stream, rv, &skAppPrintErr);
+                        if (SKSTREAM_ERROR_IS_FATAL(rv)) {
+                            appExit(EXIT_FAILURE);
+                        }
                     }
                 }
-            }
 
-            /* replace the record we just wrote */
-            if (sortTempRead(fps[lowest], recs[lowest], node_size)) {
-                /* read was successful.  "insert" the new entry into
-                 * the heap (which has same value as old entry). */
-                skHeapReplaceTop(heap, &lowest, NULL);
-            } else {
-                /* no more data for this file; remove it from the
-                 * heap */
-                skHeapExtractTop(heap, NULL);
-                --heap_count;
-                TRACEMSG(("Finished reading file #%u; %u files remain",
-                          tmp_idx_a + lowest, heap_count));
+                /* replace the record we just wrote */
+                if (sortTempRead(fps[lowest], recs[lowest], node_size)) {
+                    /* read was successful.  "insert" the new entry into
+                     * the heap (which has same value as old entry). */
+                    skHeapReplaceTop(heap, &lowest, NULL);
+                } else {
+                    /* no more data for this file; remove it from the
+                     * heap */
+                    skHeapExtractTop(heap, NULL);
+                    --heap_count;
+                    TRACEMSG(("Finished reading file #%u; %u files remain",
+                              tmp_idx_a + lowest, heap_count));
+                }
             }
-        }
 
-        /* get index of the remaining file */
-        skHeapExtractTop(heap, &lowest);
-        assert(SKHEAP_ERR_EMPTY==skHeapPeekTop(heap,(skheapnode_t*)&top_heap));
+            /* get index of the remaining file */
+            skHeapExtractTop(heap, &lowest);
+            assert(SKHEAP_ERR_EMPTY
+                   == skHeapPeekTop(heap, (skheapnode_t*)&top_heap));
 
-        /* read records from the remaining file */
-        if (fp_intermediate) {
-            do {
-                sortTempWrite(fp_intermediate, recs[lowest], node_size);
-            } while (sortTempRead(fps[lowest], recs[lowest], node_size));
-        } else {
-            do {
-                rv = skStreamWriteRecord(out_stream, (rwRec*)recs[lowest]);
-                if (0 != rv) {
-                    skStreamPrintLastErr(out_stream, rv, &skAppPrintErr);
-                    if (SKSTREAM_ERROR_IS_FATAL(rv)) {
-                        appExit(EXIT_FAILURE);
+            /* read records from the remaining file */
+            if (fp_intermediate) {
+                do {
+                    sortTempWrite(fp_intermediate, recs[lowest], node_size);
+                } while (sortTempRead(fps[lowest], recs[lowest], node_size));
+            } else {
+                do {
+                    rv = skStreamWriteRecord(out_stream, (rwRec*)recs[lowest]);
+                    if (0 != rv) {
+                        skStreamPrintLastErr(out_stream, rv, &skAppPrintErr);
+                        if (SKSTREAM_ERROR_IS_FATAL(rv)) {
+                            appExit(EXIT_FAILURE);
+                        }
                     }
-                }
-            } while (sortTempRead(fps[lowest], recs[lowest], node_size));
+                } while (sortTempRead(fps[lowest], recs[lowest], node_size));
+            }
+            TRACEMSG(("Finished reading file #%u; 0 files remain", lowest));
         }
 
-        TRACEMSG(("Finished reading file #%u; 0 files remain", lowest));
         TRACEMSG((("Finished processing #%d through #%d"),
                   tmp_idx_a, tmp_idx_b));
 
@@ -1002,16 +2060,21 @@ sortRandom(
     void)
 {
     int temp_file_idx = -1;
-    skstream_t *input_stream;       /* input stream */
+    sort_reader_t reader;           /* input stream and its records */
     uint8_t *record_buffer = NULL;  /* Region of memory for records */
-    uint8_t *cur_node = NULL;       /* Ptr into record_buffer */
+    uint8_t *fill_buffer = NULL;    /* Part of record_buffer being filled */
+    uint8_t *cur_node = NULL;       /* Ptr into fill_buffer */
     size_t buffer_max_recs;         /* max buffer size (in number of recs) */
     size_t buffer_recs;             /* current buffer size (# records) */
     size_t buffer_chunk_recs;       /* how to grow from current to max buf */
     size_t num_chunks;              /* how quickly to grow buffer */
     size_t record_count = 0;        /* Number of records read */
+    int split_buffer = 0;           /* Whether buffer is used as halves */
+    sort_run_t run;                 /* Background sort of other half */
     int rv;
 
+    memset(&run, 0, sizeof(run));
+
     /* Determine the maximum number of records that will fit into the
      * buffer if it grows the maximum size */
     buffer_max_recs = sort_buffer_size / node_size;
@@ -1060,7 +2123,8 @@ sortRandom(
     TRACEMSG((("buffer_recs = %" SK_PRIuZ), buffer_recs));
 
     /* open first file */
-    rv = appNextInput(&input_stream);
+    memset(&reader, 0, sizeof(reader));
+    rv = appNextInput(&reader.stream);
     if (rv) {
         free(record_buffer);
         if (1 == rv) {
@@ -1070,17 +2134,18 @@ sortRandom(
     }
 
     record_count = 0;
-    cur_node = record_buffer;
-    while (input_stream != NULL) {
+    fill_buffer = cur_node = record_buffer;
+    while (reader.stream != NULL) {
         /* read record */
-        rv = fillRecordAndKey(input_stream, cur_node);
+        rv = readRecordAndKey(&reader, cur_node);
         if (rv == 0) {
             /* close current and open next */
-            skStreamDestroy(&input_stream);
-            rv = appNextInput(&input_stream);
+            skStreamDestroy(&reader.stream);
+            rv = appNextInput(&reader.stream);
             if (rv < 0) {
                 /* processing these input files one at a time, so we
                  * will not hit the EMFILE limit here */
+                sortRunWait(&run);
                 free(record_buffer);
                 appExit(EXIT_FAILURE);
             }
@@ -1094,7 +2159,7 @@ sortRandom(
             /* Filled the current buffer */
 
             /* If buffer not at max size, see if we can grow it */
-            if (buffer_recs < buffer_max_recs) {
+            if (!split_buffer && buffer_recs < buffer_max_recs) {
                 uint8_t *old_buf = record_buffer;
 
                 /* add a chunk of records.  if we are near the max,
@@ -1113,6 +2178,7 @@ sortRandom(
                 if (record_buffer) {
                     /* Success, make certain cur_node points into the
                      * new buffer */
+                    fill_buffer = record_buffer;
                     cur_node = (record_buffer + (record_count * node_size));
                 } else {
                     /* Unable to grow it */
@@ -1124,60 +2190,50 @@ sortRandom(
 
             /* Either buffer at maximum size or attempt to grow it
              * failed. */
-            if (record_count == buffer_max_recs) {
-                /* Sort */
-                TRACEMSG(("Sorting %" SK_PRIuZ " records...", record_count));
-                skQSort(record_buffer, record_count, node_size, &rwrecCompare);
-                TRACEMSG(("Sorting %" SK_PRIuZ " records...done",
-                          record_count));
-
-                /* Write to temp file */
-                sortTempWriteBuffer(&temp_file_idx, record_buffer,
-                                    node_size, record_count);
+            if (record_count == buffer_recs) {
+                if (!split_buffer) {
+                    /* Sort and write to temp file */
+                    sortWriteBuffer(record_buffer, record_count,
+                                    &temp_file_idx);
+
+                    /* When threaded, from now on sort and store one
+                     * half of the buffer in the background while
+                     * reading into the other half */
+                    if (thread_count > 1
+                        && buffer_recs >= 2 * MIN_IN_CORE_RECORDS)
+                    {
+                        split_buffer = 1;
+                        buffer_recs /= 2;
+                    }
+                } else {
+                    /* Wait for the other half to be stored, then
+                     * store this half and start filling the other */
+                    sortRunWait(&run);
+                    sortRunStart(&run, fill_buffer, record_count,
+                                 &temp_file_idx);
+                    if (fill_buffer == record_buffer) {
+                        fill_buffer += buffer_recs * node_size;
+                    } else {
+                        fill_buffer = record_buffer;
+                    }
+                }
 
                 /* Reset record buffer to 'empty' */
                 record_count = 0;
-                cur_node = record_buffer;
+                cur_node = fill_buffer;
             }
         }
     }
 
-    /* Sort (and maybe store) last batch of records */
-    if (record_count > 0) {
-        TRACEMSG(("Sorting %" SK_PRIuZ " records...", record_count));
-        skQSort(record_buffer, record_count, node_size, &rwrecCompare);
-        TRACEMSG(("Sorting %" SK_PRIuZ " records...done", record_count));
-
-        if (temp_file_idx >= 0) {
-            /* Write last batch to temp file */
-            sortTempWriteBuffer(&temp_file_idx, record_buffer,
-                                node_size, record_count);
-        }
-    }
-
-    /* Generate the output */
-
-    if (record_count > 0 && temp_file_idx == -1) {
-        /* No temp files written, just output batch of records */
-        size_t c;
+    sortRunWait(&run);
 
-        TRACEMSG((("Writing %" SK_PRIuZ " records to '%s'"),
-                  record_count, skStreamGetPathname(out_stream)));
-        for (c = 0, cur_node = record_buffer;
-             c < record_count;
-             ++c, cur_node += node_size)
-        {
-            rv = skStreamWriteRecord(out_stream, (rwRec*)cur_node);
-            if (0 != rv) {
-                skStreamPrintLastErr(out_stream, rv, &skAppPrintErr);
-                if (SKSTREAM_ERROR_IS_FATAL(rv)) {
-                    free(record_buffer);
-                    appExit(EXIT_FAILURE);
-                }
-            }
-        }
+    /* Sort the last batch of records and store it or, when no temp
+     * files were written, write it to the output.  Otherwise a merge
+     * sort is required; which gets invoked from main() */
+    if (record_count > 0) {
+        sortWriteBuffer(fill_buffer, record_count,
+                        ((temp_file_idx >= 0) ? &temp_file_idx : NULL));
     }
-    /* else a merge sort is required; which gets invoked from main() */
 
     if (record_buffer) {
         free(record_buffer);
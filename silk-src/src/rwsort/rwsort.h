@@ -80,6 +80,25 @@ RCSIDENTVAR(rcsID_RWSORT_H, "$SiLK: rwsort.h 275df62a2e41 2017-01-05 17:30:40Z m
  */
 #define MAX_MERGE_FILES         1024
 
+/*
+ *    Number of records that a merging thread hands to the final merge
+ *    at once when merging the temporary files in parallel.
+ */
+#define MERGE_BLOCK_RECS        4096
+
+/*
+ *    Number of records to read from an input stream at once.
+ */
+#define SORT_READ_RECS          256
+
+/*
+ *    Environment variable that determines the number of threads, and
+ *    the number of threads to use when neither it nor the --threads
+ *    switch is given.
+ */
+#define RWSORT_THREADS_ENVAR    "SILK_RWSORT_THREADS"
+#define RWSORT_THREADS_DEFAULT  1
+
 /*
  *    Maximum number of fields that can come from plugins.  Allow four
  *    per plug-in.
@@ -154,6 +173,9 @@ extern int presorted_input;
 /* maximum amount of RAM to attempt to allocate */
 extern size_t sort_buffer_size;
 
+/* number of threads to use for sorting and merging */
+extern uint32_t thread_count;
+
 /* FUNCTIONS */
 
 void
@@ -96,7 +96,8 @@ typedef enum {
     OPT_OUTPUT_PATH,
     OPT_PLUGIN,
     OPT_PRESORTED_INPUT,
-    OPT_SORT_BUFFER_SIZE
+    OPT_SORT_BUFFER_SIZE,
+    OPT_THREADS
 } appOptionsEnum;
 
 static struct option appOptions[] = {
@@ -108,6 +109,7 @@ static struct option appOptions[] = {
     {"plugin",              REQUIRED_ARG, 0, OPT_PLUGIN},
     {"presorted-input",     NO_ARG,       0, OPT_PRESORTED_INPUT},
     {"sort-buffer-size",    REQUIRED_ARG, 0, OPT_SORT_BUFFER_SIZE},
+    {"threads",             REQUIRED_ARG, 0, OPT_THREADS},
     {0,0,0,0}               /* sentinel entry */
 };
 
@@ -123,6 +125,8 @@ static const char *appHelp[] = {
     ("Assume input has been presorted using\n"
      "\trwsort invoked with the exact same --fields value. Def. No"),
     NULL, /* generated dynamically */
+    ("Sort and merge the records using this number of threads.\n"
+     "\tDef. $" RWSORT_THREADS_ENVAR " or 1"),
     (char *)NULL
 };
 
@@ -345,6 +349,21 @@ appSetup(
         skPluginLoadPlugin(app_plugin_names[j], 0);
     }
 
+    /* check the thread count envar */
+    {
+        char *env;
+        uint32_t tc;
+
+        env = getenv(RWSORT_THREADS_ENVAR);
+        if (env && env[0]) {
+            if (skStringParseUint32(&tc, env, 1, 0) == 0) {
+                thread_count = tc;
+            } else {
+                thread_count = 1;
+            }
+        }
+    }
+
     /* parse options */
     rv = skOptionsCtxOptionsParse(optctx, argc, argv);
     if (rv < 0) {
@@ -374,6 +393,14 @@ appSetup(
         skAppUsage();           /* never returns */
     }
 
+    /* the plug-ins compare the key fields they provide; do not use
+     * threads when those plug-ins do not support it */
+    if ((thread_count > 1) && (key_num_fields > 0)
+        && !skPluginIsThreadSafe())
+    {
+        thread_count = 1;
+    }
+
     /* verify that the temp directory is valid */
     if (skTempFileInitialize(&tmpctx, temp_directory, NULL, &skAppPrintErr)) {
         appExit(EXIT_FAILURE);
@@ -508,6 +535,13 @@ appOptionsHandler(
         }
         sort_buffer_size = tmp64;
         break;
+
+      case OPT_THREADS:
+        rv = skStringParseUint32(&thread_count, opt_arg, 1, 0);
+        if (rv) {
+            goto PARSE_ERROR;
+        }
+        break;
     }
 
     return 0;                     /* OK */
@@ -1,5 +1,5 @@
 #! /usr/bin/perl -w
-# MD5: 4d68466b8f35b4cc95929a4bfac81da7
+# MD5: a954e3b1e20a40024405a837420fc197
 # TEST: ./rwdedupe --ignore-fields=stime ../../tests/data-v6.rwf ../../tests/empty.rwf | ../rwstats/rwuniq --fields=1-5 --ipv6-policy=force --timestamp-format=epoch --values=bytes,packets,records,stime,etime --sort-output --delimited --no-title
 
 use strict;
@@ -11,6 +11,6 @@ my %file;
 $file{v6data} = get_data_or_exit77('v6data');
 $file{empty} = get_data_or_exit77('empty');
 my $cmd = "$rwdedupe --ignore-fields=stime $file{v6data} $file{empty} | $rwuniq --fields=1-5 --ipv6-policy=force --timestamp-format=epoch --values=bytes,packets,records,stime,etime --sort-output --delimited --no-title";
-my $md5 = "4d68466b8f35b4cc95929a4bfac81da7";
+my $md5 = "a954e3b1e20a40024405a837420fc197";
 
 check_md5_output($md5, $cmd);
@@ -1,5 +1,5 @@
 #! /usr/bin/perl -w
-# MD5: b49b8fd109db835d2332d87274e4aeb5
+# MD5: 8b71a26a134b5d16a3bad0436f2ee61b
 # TEST: ./rwdedupe --ignore-fields=stime ../../tests/data.rwf ../../tests/empty.rwf | ../rwstats/rwuniq --fields=1-5 --ipv6-policy=ignore --timestamp-format=epoch --values=bytes,packets,records,stime,etime --sort-output --delimited --no-title
 
 use strict;
@@ -11,6 +11,6 @@ my %file;
 $file{data} = get_data_or_exit77('data');
 $file{empty} = get_data_or_exit77('empty');
 my $cmd = "$rwdedupe --ignore-fields=stime $file{data} $file{empty} | $rwuniq --fields=1-5 --ipv6-policy=ignore --timestamp-format=epoch --values=bytes,packets,records,stime,etime --sort-output --delimited --no-title";
-my $md5 = "b49b8fd109db835d2332d87274e4aeb5";
+my $md5 = "8b71a26a134b5d16a3bad0436f2ee61b";
 
 check_md5_output($md5, $cmd);
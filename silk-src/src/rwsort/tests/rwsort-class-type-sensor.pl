@@ -1,5 +1,5 @@
 #! /usr/bin/perl -w
-# MD5: 97f1cb331a5f21c440c68ef8f0b011e6
+# MD5: 93ef04ec27f0ec47bfe50ee4d3abd057
 # TEST: ./rwsort --fields=class,type,sensor ../../tests/data.rwf | ../rwcat/rwcat --compression-method=none --byte-order=little --ipv4-output
 
 use strict;
@@ -10,6 +10,6 @@ my $rwcat = check_silk_app('rwcat');
 my %file;
 $file{data} = get_data_or_exit77('data');
 my $cmd = "$rwsort --fields=class,type,sensor $file{data} | $rwcat --compression-method=none --byte-order=little --ipv4-output";
-my $md5 = "97f1cb331a5f21c440c68ef8f0b011e6";
+my $md5 = "93ef04ec27f0ec47bfe50ee4d3abd057";
 
 check_md5_output($md5, $cmd);
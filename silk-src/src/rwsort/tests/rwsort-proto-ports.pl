@@ -1,5 +1,5 @@
 #! /usr/bin/perl -w
-# MD5: 68edbb3ee62df387bb487770291ba652
+# MD5: 43080a57137378d66f43159f4638ad22
 # TEST: ./rwsort --fields=5,3-4 ../../tests/data.rwf | ../rwcat/rwcat --compression-method=none --byte-order=little --ipv4-output
 
 use strict;
@@ -10,6 +10,6 @@ my $rwcat = check_silk_app('rwcat');
 my %file;
 $file{data} = get_data_or_exit77('data');
 my $cmd = "$rwsort --fields=5,3-4 $file{data} | $rwcat --compression-method=none --byte-order=little --ipv4-output";
-my $md5 = "68edbb3ee62df387bb487770291ba652";
+my $md5 = "43080a57137378d66f43159f4638ad22";
 
 check_md5_output($md5, $cmd);
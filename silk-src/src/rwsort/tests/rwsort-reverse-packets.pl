@@ -1,5 +1,5 @@
 #! /usr/bin/perl -w
-# MD5: 19bf4e0a8d85fdb7601ff769ead63efa
+# MD5: 7ea9d5d0fe8139014eeb90323e83de4e
 # TEST: ./rwsort --fields=6 --reverse ../../tests/data.rwf | ../rwcat/rwcat --compression-method=none --byte-order=little --ipv4-output
 
 use strict;
@@ -10,6 +10,6 @@ my $rwcat = check_silk_app('rwcat');
 my %file;
 $file{data} = get_data_or_exit77('data');
 my $cmd = "$rwsort --fields=6 --reverse $file{data} | $rwcat --compression-method=none --byte-order=little --ipv4-output";
-my $md5 = "19bf4e0a8d85fdb7601ff769ead63efa";
+my $md5 = "7ea9d5d0fe8139014eeb90323e83de4e";
 
 check_md5_output($md5, $cmd);
@@ -273,6 +273,9 @@ app_flags_t app_flags;
 /* number of records read */
 uint64_t record_count = 0;
 
+/* number of threads that read and bin the records */
+uint32_t thread_count = RWSTATS_THREADS_DEFAULT;
+
 /* Summation of whatever value (bytes, packets, flows) we are using.
  * When counting flows, this will be equal to record_count. */
 uint64_t value_total = 0;
@@ -923,6 +926,23 @@ rwstatsComparePluginAny(
     return ((RWSTATS_DIR_TOP == direction) ? -cmp : cmp);
 }
 
+static int
+rwstatsCompareApproxDistinct(
+    const skheapnode_t  node1,
+    const skheapnode_t  node2)
+{
+    uint8_t sketch1[HASHLIB_MAX_VALUE_WIDTH];
+    uint8_t sketch2[HASHLIB_MAX_VALUE_WIDTH];
+    int cmp;
+
+    skFieldListExtractFromBuffer(value_fields, HEAP_PTR_VALUE(node1),
+                                 limit.fl_entry, sketch1);
+    skFieldListExtractFromBuffer(value_fields, HEAP_PTR_VALUE(node2),
+                                 limit.fl_entry, sketch2);
+    cmp = skFieldListEntryCompareBuffers(sketch1, sketch2, limit.fl_entry);
+    return ((RWSTATS_DIR_TOP == direction) ? -cmp : cmp);
+}
+
 static int
 rwstatsCompareDistinctsAny(
     const skheapnode_t  node1,
@@ -1048,7 +1068,9 @@ statsRandom(
     sk_unique_iterator_t *iter;
     uint8_t *outbuf[3] = {NULL, NULL, NULL};
     skstream_t *stream;
-    rwRec rwrec;
+    rwRec recs[RWSTATS_READ_RECS];
+    size_t num_recs;
+    size_t i;
     int rv = 0;
     size_t len;
     union count_un {
@@ -1060,28 +1082,48 @@ statsRandom(
     } count;
 
     /* read SiLK Flow records and insert into the skunique data structure */
-    while (0 == (rv = appNextInput(&stream))) {
-        while (SKSTREAM_OK == (rv = readRecord(stream, &rwrec))) {
-            if (0 != skUniqueAddRecord(uniq, &rwrec)) {
+    if (thread_count > 1) {
+        /* each thread reads files and bins their records */
+        if (skUniqueAddInputs(uniq, &appNextInput, &readRecords)) {
+            return -1;
+        }
+    } else {
+        while (0 == (rv = appNextInput(&stream))) {
+            do {
+                rv = readRecords(stream, recs, RWSTATS_READ_RECS, &num_recs);
+                for (i = 0; i < num_recs; ++i) {
+                    if (0 != skUniqueAddRecord(uniq, &recs[i])) {
+                        return -1;
+                    }
+                }
+            } while (SKSTREAM_OK == rv);
+            if (rv != SKSTREAM_ERR_EOF) {
+                /* corrupt record in file */
+                skStreamPrintLastErr(stream, rv, &skAppPrintErr);
+                skStreamDestroy(&stream);
                 return -1;
             }
-        }
-        if (rv != SKSTREAM_ERR_EOF) {
-            /* corrupt record in file */
-            skStreamPrintLastErr(stream, rv, &skAppPrintErr);
             skStreamDestroy(&stream);
+        }
+        if (rv == -1) {
+            /* error opening file */
             return -1;
         }
-        skStreamDestroy(&stream);
-    }
-    if (rv == -1) {
-        /* error opening file */
-        return -1;
     }
 
     /* no more input; prepare for output */
     skUniquePrepareForOutput(uniq);
 
+    /* when --approximate-top replaced bins, the values are only lower
+     * bounds; say by how much they may be low */
+    if (skUniqueGetMaxBinsError(uniq)) {
+        skAppPrintErr(("Warning: Values are lower bounds that may be low"
+                       " by as much as %" PRIu64 "; keys whose values are"
+                       " within that amount of one another may be missing"
+                       " or out of order"),
+                      skUniqueGetMaxBinsError(uniq));
+    }
+
     if (limit.distinct) {
         value_total = skUniqueGetTotalDistinctCount(uniq);
     }
@@ -1283,6 +1325,10 @@ statsRandom(
               default:
                 skFieldListExtractFromBuffer(value_fields, outbuf[1],
                                              limit.fl_entry, count.ar);
+                if (SK_FIELD_APPROX_DISTINCT == limit.fl_id) {
+                    count.u64 = skFieldListEntryGetApproxDistinctCount(
+                        limit.fl_entry, count.ar);
+                }
                 if (!VALUE_MEETS_THRESHOLD(count.u64)) {
                     continue;
                 }
@@ -1531,6 +1577,10 @@ presortedEntryCallback(
           default:
             skFieldListExtractFromBuffer(value_fields, value,
                                          limit.fl_entry, count.ar);
+            if (SK_FIELD_APPROX_DISTINCT == limit.fl_id) {
+                count.u64 = skFieldListEntryGetApproxDistinctCount(
+                    limit.fl_entry, count.ar);
+            }
             if (!VALUE_MEETS_THRESHOLD(count.u64)) {
                 return 0;
             }
@@ -1623,6 +1673,11 @@ topnMain(
             cmp_fn = &rwstatsComparePluginAny;
             break;
 
+          case DIR_AND_TYPE(RWSTATS_DIR_TOP, SK_FIELD_APPROX_DISTINCT):
+          case DIR_AND_TYPE(RWSTATS_DIR_BOTTOM, SK_FIELD_APPROX_DISTINCT):
+            cmp_fn = &rwstatsCompareApproxDistinct;
+            break;
+
           default:
             skAbortBadCase(DIR_AND_TYPE(direction, limit.fl_id));
         }
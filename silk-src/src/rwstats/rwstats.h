@@ -39,6 +39,21 @@ RCSIDENTVAR(rcsID_RWSTATS_H, "$SiLK: rwstats.h 275df62a2e41 2017-01-05 17:30:40Z
 /* default sTime bin size to use when --bin-time is requested */
 #define DEFAULT_TIME_BIN  60
 
+/* environment variable that determines number of threads */
+#define RWSTATS_THREADS_ENVAR   "SILK_RWSTATS_THREADS"
+
+/* default number of threads to use */
+#define RWSTATS_THREADS_DEFAULT 1
+
+/* number of records to read from an input stream at once */
+#define RWSTATS_READ_RECS      256
+
+/* default, smallest, and bin limit for the --approximate-top
+ * percentage */
+#define RWSTATS_APPROX_TOP_DEFAULT      0.1
+#define RWSTATS_APPROX_TOP_MINIMUM      0.0001
+#define RWSTATS_APPROX_TOP_MAX_BINS     (1u << 24)
+
 #define HEAP_PTR_KEY(hp)                        \
     ((uint8_t*)(hp) + heap_offset_key)
 
@@ -139,12 +154,12 @@ typedef enum {
     OPT_OVERALL_STATS, OPT_DETAIL_PROTO_STATS,
 
     OPT_HELP_FIELDS,
-    OPT_FIELDS, OPT_VALUES, OPT_PLUGIN,
+    OPT_FIELDS, OPT_VALUES, OPT_PLUGIN, OPT_APPROXIMATE_DISTINCT,
 
     /* keep these in same order as stat_stat_type_t */
     OPT_COUNT, OPT_THRESHOLD, OPT_PERCENTAGE,
 
-    OPT_TOP, OPT_BOTTOM,
+    OPT_TOP, OPT_BOTTOM, OPT_APPROXIMATE_TOP,
 
     OPT_PRESORTED_INPUT,
     OPT_NO_PERCENTS,
@@ -160,6 +175,7 @@ typedef enum {
     OPT_COPY_INPUT,
     OPT_OUTPUT_PATH,
     OPT_PAGER,
+    OPT_THREADS,
     OPT_LEGACY_HELP
 } appOptionsEnum;
 
@@ -252,6 +268,9 @@ extern unsigned int time_fields_key;
 /* whether dPort is part of the key */
 extern unsigned int dport_key;
 
+/* number of threads that read and bin the records */
+extern uint32_t thread_count;
+
 
 /* FUNCTION DECLARATIONS */
 
@@ -273,6 +292,12 @@ readRecord(
     skstream_t         *stream,
     rwRec              *rwrec);
 int
+readRecords(
+    skstream_t         *stream,
+    rwRec              *recs,
+    size_t              num_recs,
+    size_t             *recs_read);
+int
 appNextInput(
     skstream_t        **stream);
 void
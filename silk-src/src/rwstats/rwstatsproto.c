@@ -329,21 +329,25 @@ static int
 protoStatsProcessFile(
     skstream_t         *stream)
 {
-    rwRec rwrec;
+    rwRec recs[RWSTATS_READ_RECS];
+    size_t count;
+    size_t i;
     int proto_idx;
     int rv;
 
-    while ((rv = skStreamReadRecord(stream, &rwrec)) == SKSTREAM_OK) {
-        /* Statistics across ALL protocols */
-        protoStatsUpdateStatistics(0, &rwrec);
+    do {
+        rv = skStreamReadRecords(stream, recs, RWSTATS_READ_RECS, &count);
+        for (i = 0; i < count; ++i) {
+            /* Statistics across ALL protocols */
+            protoStatsUpdateStatistics(0, &recs[i]);
 
-        /* Compute statistics for specific protocol if requested */
-        proto_idx = proto_to_stats_idx[rwRecGetProto(&rwrec)];
-        if (proto_idx) {
-            protoStatsUpdateStatistics(proto_idx, &rwrec);
+            /* Compute statistics for specific protocol if requested */
+            proto_idx = proto_to_stats_idx[rwRecGetProto(&recs[i])];
+            if (proto_idx) {
+                protoStatsUpdateStatistics(proto_idx, &recs[i]);
+            }
         }
-
-    } /* while skStreamReadRecord() */
+    } while (SKSTREAM_OK == rv);
     if (SKSTREAM_ERR_EOF != rv) {
         skStreamPrintLastErr(stream, rv, &skAppPrintErr);
     }
@@ -102,6 +102,22 @@ static unsigned int time_fields;
 /* input checker */
 static sk_options_ctx_t *optctx = NULL;
 
+/* number of plug-in fields the user requested */
+static unsigned int plugin_field_count = 0;
+
+/* when non-zero, the built-in distinct fields are estimated using
+ * this precision; set by --approximate-distinct */
+static uint8_t approx_distinct_precision = 0;
+
+/* when non-zero, only the bins that may be among the top are kept,
+ * where a bin is dropped only when its primary value is less than
+ * this percentage of the total; set by --approximate-top */
+static double approx_top_percent = 0.0;
+
+/* protects 'record_count' and 'value_total' when multiple threads
+ * call readRecord() */
+static pthread_mutex_t count_mutex = PTHREAD_MUTEX_INITIALIZER;
+
 /* fields that get defined just like plugins */
 static const struct app_static_plugins_st {
     const char         *name;
@@ -139,6 +155,7 @@ static struct option appOptions[] = {
     {"fields",              REQUIRED_ARG, 0, OPT_FIELDS},
     {"values",              REQUIRED_ARG, 0, OPT_VALUES},
     {"plugin",              REQUIRED_ARG, 0, OPT_PLUGIN},
+    {"approximate-distinct", OPTIONAL_ARG, 0, OPT_APPROXIMATE_DISTINCT},
 
     {"count",               REQUIRED_ARG, 0, OPT_COUNT},
     {"threshold",           REQUIRED_ARG, 0, OPT_THRESHOLD},
@@ -146,6 +163,7 @@ static struct option appOptions[] = {
 
     {"top",                 NO_ARG,       0, OPT_TOP},
     {"bottom",              NO_ARG,       0, OPT_BOTTOM},
+    {"approximate-top",     OPTIONAL_ARG, 0, OPT_APPROXIMATE_TOP},
 
     {"presorted-input",     NO_ARG,       0, OPT_PRESORTED_INPUT},
     {"no-percents",         NO_ARG,       0, OPT_NO_PERCENTS},
@@ -161,6 +179,7 @@ static struct option appOptions[] = {
     {"copy-input",          REQUIRED_ARG, 0, OPT_COPY_INPUT},
     {"output-path",         REQUIRED_ARG, 0, OPT_OUTPUT_PATH},
     {"pager",               REQUIRED_ARG, 0, OPT_PAGER},
+    {"threads",             REQUIRED_ARG, 0, OPT_THREADS},
 
     {"legacy-help",         NO_ARG,       0, OPT_LEGACY_HELP},
 
@@ -181,6 +200,10 @@ static const char *appHelp[] = {
      "\tvalue will be used as the basis for the Top-N/Bottom-N"),
     ("Load given plug-in to add fields and/or values. Switch may\n"
      "\tbe repeated to load multiple plug-ins. Def. None"),
+    ("Estimate the built-in distinct counts in a fixed amount\n"
+     "\tof memory per bin; optionally give the largest relative standard\n"
+     "\terror as a percentage. Def. Count exactly; error is 6.5 when no\n"
+     "\tpercentage is given"),
 
     ("Print the specified number of bins"),
     ("Print bins where the primary value is greater-/less-than\n"
@@ -191,6 +214,10 @@ static const char *appHelp[] = {
 
     ("Print the top N keys and their values. Def. Yes"),
     ("Print the bottom N keys and their values. Def. No"),
+    ("Find the top N in a fixed amount of memory, keeping\n"
+     "\tthe bins whose primary value may exceed this percentage of the\n"
+     "\ttotal.  Values are upper bounds.  Def. Exact; 0.1 when no\n"
+     "\tpercentage is given"),
 
     ("Assume input has been presorted using\n"
      "\trwsort invoked with the exact same --fields value. Def. No"),
@@ -208,6 +235,8 @@ static const char *appHelp[] = {
     "Copy all input SiLK Flows to given pipe or file. Def. No",
     "Write the output to this stream or file. Def. stdout",
     "Invoke this program to page output. Def. $SILK_PAGER or $PAGER",
+    ("Read and bin the records using this number of threads.\n"
+     "\tDef. $" RWSTATS_THREADS_ENVAR " or 1"),
     "Print help, including legacy switches",
     (char *)NULL
 };
@@ -232,6 +261,7 @@ isFieldDuplicate(
     const sk_fieldlist_t   *flist,
     sk_fieldid_t            fid,
     const void             *fcontext);
+static uint32_t getFieldId(const sk_fieldentry_t *fl_entry);
 static int  prepareFileForRead(skstream_t *stream);
 
 static void topnSetup(const rwstats_legacy_t *leg);
@@ -413,6 +443,21 @@ appSetup(
         skPluginLoadPlugin(app_plugin_names[j], 0);
     }
 
+    /* check the thread count envar */
+    {
+        char *env;
+        uint32_t tc;
+
+        env = getenv(RWSTATS_THREADS_ENVAR);
+        if (env && env[0]) {
+            if (skStringParseUint32(&tc, env, 1, 0) == 0) {
+                thread_count = tc;
+            } else {
+                thread_count = 1;
+            }
+        }
+    }
+
     /* parse options */
     rv = skOptionsCtxOptionsParse(optctx, argc, argv);
     if (rv < 0) {
@@ -595,6 +640,7 @@ appOptionsHandler(
 {
     static int saw_direction = 0;
     uint32_t val32;
+    double percent;
     int rv;
 
     switch ((appOptionsEnum)opt_index) {
@@ -636,6 +682,39 @@ appOptionsHandler(
         }
         break;
 
+      case OPT_APPROXIMATE_TOP:
+        if (NULL == opt_arg) {
+            approx_top_percent = RWSTATS_APPROX_TOP_DEFAULT;
+        } else {
+            rv = skStringParseDouble(&approx_top_percent, opt_arg,
+                                     RWSTATS_APPROX_TOP_MINIMUM, 100.0);
+            if (rv) {
+                goto PARSE_ERROR;
+            }
+        }
+        break;
+
+      case OPT_APPROXIMATE_DISTINCT:
+        if (NULL == opt_arg) {
+            approx_distinct_precision = SK_FIELD_APPROX_DISTINCT_MAX_PRECISION;
+        } else {
+            rv = skStringParseDouble(&percent, opt_arg, 0.0, 100.0);
+            if (rv) {
+                goto PARSE_ERROR;
+            }
+            approx_distinct_precision
+                = skFieldListApproxDistinctPrecision(percent);
+            if (0 == approx_distinct_precision) {
+                percent = (104.0
+                           / sqrt(1u << SK_FIELD_APPROX_DISTINCT_MAX_PRECISION));
+                skAppPrintErr(("Invalid %s '%s':"
+                               " The smallest supported error is %.1f"),
+                              appOptions[opt_index].name, opt_arg, percent);
+                return 1;
+            }
+        }
+        break;
+
       case OPT_COUNT:
       case OPT_THRESHOLD:
       case OPT_PERCENTAGE:
@@ -771,6 +850,13 @@ appOptionsHandler(
         pager = opt_arg;
         break;
 
+      case OPT_THREADS:
+        rv = skStringParseUint32(&thread_count, opt_arg, 1, 0);
+        if (rv) {
+            goto PARSE_ERROR;
+        }
+        break;
+
       case OPT_LEGACY_HELP:
         legacy_help_requested = 1;
         appUsageLong();
@@ -893,6 +979,55 @@ topnSetup(
     if (parseValueFields(values_arg)) {
         appExit(EXIT_FAILURE);
     }
+    if (approx_distinct_precision
+        && skFieldListGetBufferSize(value_fields) > HASHLIB_MAX_VALUE_WIDTH)
+    {
+        skAppPrintErr(("The values require more than %u octets;"
+                       " give a larger error to --%s"),
+                      (unsigned int)HASHLIB_MAX_VALUE_WIDTH,
+                      appOptions[OPT_APPROXIMATE_DISTINCT].name);
+        appExit(EXIT_FAILURE);
+    }
+    if (SK_FIELD_APPROX_DISTINCT == limit.fl_id
+        && RWSTATS_PERCENTAGE == limit.type)
+    {
+        skAppPrintErr(("The --%s limit is not supported when the"
+                       " primary value is an approximate distinct count"),
+                      appOptions[OPT_PERCENTAGE].name);
+        appExit(EXIT_FAILURE);
+    }
+    if (approx_top_percent > 0.0) {
+        if (RWSTATS_DIR_TOP != direction) {
+            skAppPrintErr("The --%s switch requires --%s",
+                          appOptions[OPT_APPROXIMATE_TOP].name,
+                          appOptions[OPT_TOP].name);
+            appExit(EXIT_FAILURE);
+        }
+        if (app_flags.presorted_input) {
+            skAppPrintErr("May not use --%s with --%s",
+                          appOptions[OPT_APPROXIMATE_TOP].name,
+                          appOptions[OPT_PRESORTED_INPUT].name);
+            appExit(EXIT_FAILURE);
+        }
+        switch (limit.fl_id) {
+          case SK_FIELD_RECORDS:
+          case SK_FIELD_SUM_BYTES:
+          case SK_FIELD_SUM_PACKETS:
+            break;
+          default:
+            skAppPrintErr(("The --%s switch requires the primary value to"
+                           " be Records, Packets, or Bytes"),
+                          appOptions[OPT_APPROXIMATE_TOP].name);
+            appExit(EXIT_FAILURE);
+        }
+        if (skFieldListGetFieldCount(distinct_fields) > 0) {
+            skAppPrintErr(("May not use --%s when counting distinct values;"
+                           " consider using --%s"),
+                          appOptions[OPT_APPROXIMATE_TOP].name,
+                          appOptions[OPT_APPROXIMATE_DISTINCT].name);
+            appExit(EXIT_FAILURE);
+        }
+    }
 
     /* create and initialize the uniq object */
     if (app_flags.presorted_input) {
@@ -936,6 +1071,19 @@ topnSetup(
         skPresortedUniqueSetReadFn(ps_uniq, readRecord);
 
     } else {
+        /* the threads call the plug-ins and share the --copy-input
+         * stream; do not use threads when either does not support
+         * it */
+        if ((thread_count > 1)
+            && (copy_input || approx_top_percent > 0.0
+                || ((plugin_field_count > 0) && !skPluginIsThreadSafe())))
+        {
+            thread_count = 1;
+        }
+        if (thread_count > SKUNIQUE_MAX_THREADS) {
+            thread_count = SKUNIQUE_MAX_THREADS;
+        }
+
         if (skUniqueCreate(&uniq)) {
             appExit(EXIT_FAILURE);
         }
@@ -946,6 +1094,28 @@ topnSetup(
         if (0 == rv && limit.distinct) {
             rv = skUniqueEnableTotalDistinct(uniq);
         }
+        if (0 == rv) {
+            rv = skUniqueSetThreads(uniq, thread_count);
+        }
+        if (0 == rv && approx_top_percent > 0.0) {
+            /* keep enough bins that any bin holding more than the
+             * percentage survives, and never fewer than the count */
+            uint64_t max_bins = (uint64_t)ceil(100.0 / approx_top_percent);
+
+            if (RWSTATS_COUNT == limit.type
+                && limit.value[RWSTATS_COUNT].u64 > max_bins)
+            {
+                max_bins = limit.value[RWSTATS_COUNT].u64;
+            }
+            if (max_bins > RWSTATS_APPROX_TOP_MAX_BINS) {
+                skAppPrintErr(("Cannot use --%s: The number of bins %" PRIu64
+                               " is larger than the maximum %u"),
+                              appOptions[OPT_APPROXIMATE_TOP].name, max_bins,
+                              (unsigned int)RWSTATS_APPROX_TOP_MAX_BINS);
+                appExit(EXIT_FAILURE);
+            }
+            rv = skUniqueSetMaxBins(uniq, (uint32_t)max_bins, limit.fl_entry);
+        }
         if (0 == rv) {
             rv = skUniquePrepareForInput(uniq);
         }
@@ -1051,6 +1221,13 @@ value_to_ascii(
         snprintf(text_buf, text_buf_size, ("%" PRIu32), val32);
         break;
 
+      case SK_FIELD_APPROX_DISTINCT:
+        skFieldListExtractFromBuffer(value_fields, HEAP_PTR_VALUE(v_heap_ptr),
+                                     fl_entry, bin_buf);
+        snprintf(text_buf, text_buf_size, ("%" PRIu64),
+                 skFieldListEntryGetApproxDistinctCount(fl_entry, bin_buf));
+        break;
+
       case SK_FIELD_CALLER:
         /* get the binary value from the field-list */
         skFieldListExtractFromBuffer(value_fields, HEAP_PTR_VALUE(v_heap_ptr),
@@ -1088,7 +1265,7 @@ builtin_distinct_get_title(
     int id;
     size_t sz;
 
-    id = skFieldListEntryGetId(fl_entry);
+    id = getFieldId(fl_entry);
     switch (id) {
       case SK_FIELD_SIPv4:
       case SK_FIELD_SIPv6:
@@ -1810,6 +1987,47 @@ parseKeyFields(
 }
 
 
+/*
+ *  fl_entry = appAddApproxDistinct(field_id, bf, name, text_len);
+ *
+ *    Add to the value fields a field that estimates the number of
+ *    distinct values of the built-in field 'field_id'.  'bf' is the
+ *    context for the field, 'name' is used in error messages, and
+ *    'text_len' is the width of the column.  Return the new field
+ *    list entry, or NULL on failure.
+ */
+static sk_fieldentry_t *
+appAddApproxDistinct(
+    sk_fieldid_t        field_id,
+    builtin_field_t    *bf,
+    const char         *name,
+    int                 text_len)
+{
+    sk_fieldentry_t *fl_entry;
+
+    if (isFieldDuplicate(value_fields, field_id, NULL)) {
+        skAppPrintErr("Invalid %s: Duplicate distinct '%s'",
+                      appOptions[OPT_VALUES].name, name);
+        return NULL;
+    }
+    fl_entry = skFieldListAddApproxDistinctField(
+        value_fields, field_id, approx_distinct_precision, bf);
+    if (NULL == fl_entry) {
+        skAppPrintErr("Cannot add distinct field '%s' to field list", name);
+        return NULL;
+    }
+    if (rwAsciiAppendCallbackFieldExtra(ascii_str,
+                                        &builtin_distinct_get_title,
+                                        &value_to_ascii,
+                                        fl_entry, text_len))
+    {
+        skAppPrintErr("Cannot add distinct field '%s' to stream", name);
+        return NULL;
+    }
+    return fl_entry;
+}
+
+
 /*
  *  ok = parseValueFields(field_string);
  *
@@ -1941,6 +2159,21 @@ parseValueFields(
                               sm_entry->name);
                 goto END;
             }
+        } else if (SK_FIELD_CALLER != bf->bf_id && approx_distinct_precision) {
+            /* one of the old sip-distinct,dip-distinct fields whose
+             * count is estimated; must have no attribute */
+            field_type = FIELD_TYPE_VALUE;
+            if (sm_attr[0]) {
+                skAppPrintErr("Invalid %s: Unrecognized field '%s:%s'",
+                              appOptions[OPT_VALUES].name,
+                              bf->bf_title, sm_attr);
+                goto END;
+            }
+            fl_entry = appAddApproxDistinct(bf->bf_id, bf, bf->bf_title,
+                                            bf->bf_text_len);
+            if (NULL == fl_entry) {
+                goto END;
+            }
         } else if (SK_FIELD_CALLER != bf->bf_id) {
             /* one of the old sip-distinct,dip-distinct fields; must
              * have no attribute */
@@ -2042,21 +2275,31 @@ parseValueFields(
                 }
             }
 #endif  /* #if SK_ENABLE_IPV6 */
-            fl_entry = skFieldListAddKnownField(distinct_fields,
-                                                sm_entry_id, NULL);
-            if (NULL == fl_entry) {
-                skAppPrintErr("Cannot add distinct field '%s' to field list",
-                              sm_entry->name);
-                goto END;
-            }
-            if (rwAsciiAppendCallbackFieldExtra(ascii_str,
-                                                &builtin_distinct_get_title,
-                                                &distinct_to_ascii,
-                                                fl_entry, bf->bf_text_len))
-            {
-                skAppPrintErr("Cannot add distinct field '%s' to stream",
-                              sm_entry->name);
-                goto END;
+            if (approx_distinct_precision) {
+                field_type = FIELD_TYPE_VALUE;
+                fl_entry = appAddApproxDistinct((sk_fieldid_t)sm_entry_id,
+                                                NULL, sm_entry->name,
+                                                bf->bf_text_len);
+                if (NULL == fl_entry) {
+                    goto END;
+                }
+            } else {
+                fl_entry = skFieldListAddKnownField(distinct_fields,
+                                                    sm_entry_id, NULL);
+                if (NULL == fl_entry) {
+                    skAppPrintErr(("Cannot add distinct field '%s'"
+                                   " to field list"),
+                                  sm_entry->name);
+                    goto END;
+                }
+                if (rwAsciiAppendCallbackFieldExtra(
+                        ascii_str, &builtin_distinct_get_title,
+                        &distinct_to_ascii, fl_entry, bf->bf_text_len))
+                {
+                    skAppPrintErr("Cannot add distinct field '%s' to stream",
+                                  sm_entry->name);
+                    goto END;
+                }
             }
         }
 
@@ -2067,7 +2310,7 @@ parseValueFields(
             limit.fl_id = (sk_fieldid_t)skFieldListEntryGetId(fl_entry);
             limit.bf_value = bf;
             limit.distinct = (FIELD_TYPE_DISTINCT == field_type);
-            if (limit.distinct) {
+            if (limit.distinct || SK_FIELD_APPROX_DISTINCT == limit.fl_id) {
                 builtin_distinct_get_title(limit.title, sizeof(limit.title),
                                            fl_entry);
             } else {
@@ -2149,6 +2392,7 @@ appAddPlugin(
     if (pi_err != SKPLUGIN_OK) {
         return -1;
     }
+    ++plugin_field_count;
 
     /* initialize this field */
     pi_err = skPluginFieldRunInitialize(pi_field);
@@ -2276,7 +2520,7 @@ isFieldDuplicate(
       case SK_FIELD_SIPv4:
       case SK_FIELD_SIPv6:
         while ((fl_entry = skFieldListIteratorNext(&fl_iter)) != NULL) {
-            switch (skFieldListEntryGetId(fl_entry)) {
+            switch (getFieldId(fl_entry)) {
               case SK_FIELD_SIPv4:
               case SK_FIELD_SIPv6:
                 return 1;
@@ -2289,7 +2533,7 @@ isFieldDuplicate(
       case SK_FIELD_DIPv4:
       case SK_FIELD_DIPv6:
         while ((fl_entry = skFieldListIteratorNext(&fl_iter)) != NULL) {
-            switch (skFieldListEntryGetId(fl_entry)) {
+            switch (getFieldId(fl_entry)) {
               case SK_FIELD_DIPv4:
               case SK_FIELD_DIPv6:
                 return 1;
@@ -2302,7 +2546,7 @@ isFieldDuplicate(
       case SK_FIELD_NHIPv4:
       case SK_FIELD_NHIPv6:
         while ((fl_entry = skFieldListIteratorNext(&fl_iter)) != NULL) {
-            switch (skFieldListEntryGetId(fl_entry)) {
+            switch (getFieldId(fl_entry)) {
               case SK_FIELD_NHIPv4:
               case SK_FIELD_NHIPv6:
                 return 1;
@@ -2314,7 +2558,7 @@ isFieldDuplicate(
 
       case SK_FIELD_CALLER:
         while ((fl_entry = skFieldListIteratorNext(&fl_iter)) != NULL) {
-            if ((skFieldListEntryGetId(fl_entry) == (uint32_t)fid)
+            if ((getFieldId(fl_entry) == (uint32_t)fid)
                 && (skFieldListEntryGetContext(fl_entry) == fcontext))
             {
                 return 1;
@@ -2324,7 +2568,7 @@ isFieldDuplicate(
 
       default:
         while ((fl_entry = skFieldListIteratorNext(&fl_iter)) != NULL) {
-            if (skFieldListEntryGetId(fl_entry) == (uint32_t)fid) {
+            if (getFieldId(fl_entry) == (uint32_t)fid) {
                 return 1;
             }
         }
@@ -2334,6 +2578,26 @@ isFieldDuplicate(
 }
 
 
+/*
+ *  id = getFieldId(fl_entry);
+ *
+ *    Return the sk_fieldid_t of 'fl_entry'.  When 'fl_entry'
+ *    estimates a distinct count, return the id of the field whose
+ *    distinct values are estimated.
+ */
+static uint32_t
+getFieldId(
+    const sk_fieldentry_t  *fl_entry)
+{
+    uint32_t id = skFieldListEntryGetId(fl_entry);
+
+    if (SK_FIELD_APPROX_DISTINCT == id) {
+        return skFieldListEntryGetApproxDistinctId(fl_entry);
+    }
+    return id;
+}
+
+
 static int
 prepareFileForRead(
     skstream_t         *stream)
@@ -2351,85 +2615,124 @@ prepareFileForRead(
 
 
 /*
- *  status = readRecord(stream, rwrec);
- *
- *    Fill 'rwrec' with a SiLK Flow record read from 'stream'.  Modify
- *    the times on the record if the user has requested time binning.
- *    Modify the IPs if the user has specified CIDR blocks.
+ *  binRecordTimes(rwrec);
  *
- *    Return the status of reading the record.
+ *    Modify the times on 'rwrec' to the user's requested time bin.
  */
-int
-readRecord(
-    skstream_t         *stream,
+static void
+binRecordTimes(
     rwRec              *rwrec)
 {
     sktime_t sTime;
     sktime_t sTime_mod;
     uint32_t elapsed;
+
+    switch (time_fields) {
+      case PARSE_KEY_STIME:
+      case (PARSE_KEY_STIME | PARSE_KEY_ELAPSED):
+        /* adjust start time */
+        sTime = rwRecGetStartTime(rwrec);
+        sTime_mod = sTime % time_bin_size;
+        rwRecSetStartTime(rwrec, (sTime - sTime_mod));
+        break;
+      case PARSE_KEY_ALL_TIMES:
+      case (PARSE_KEY_STIME | PARSE_KEY_ETIME):
+        /* adjust sTime and elapsed/duration */
+        sTime = rwRecGetStartTime(rwrec);
+        sTime_mod = sTime % time_bin_size;
+        rwRecSetStartTime(rwrec, (sTime - sTime_mod));
+        /*
+         * the following sets elapsed to:
+         * ((eTime - (eTime % bin_size)) - (sTime - (sTime % bin_size)))
+         */
+        elapsed = rwRecGetElapsed(rwrec);
+        elapsed = (elapsed + sTime_mod
+                   - ((sTime + elapsed) % time_bin_size));
+        rwRecSetElapsed(rwrec, elapsed);
+        break;
+      case PARSE_KEY_ETIME:
+      case (PARSE_KEY_ETIME | PARSE_KEY_ELAPSED):
+        /* want to set eTime to (eTime - (eTime % bin_size)), but
+         * eTime is computed as (sTime + elapsed) */
+        sTime = rwRecGetStartTime(rwrec);
+        rwRecSetStartTime(rwrec,
+                          (sTime - ((sTime + rwRecGetElapsed(rwrec))
+                                    % time_bin_size)));
+        break;
+      case 0:
+      case PARSE_KEY_ELAPSED:
+      default:
+        skAbortBadCase(time_fields);
+    }
+}
+
+
+/*
+ *  status = readRecords(stream, recs, num_recs, &recs_read);
+ *
+ *    Fill 'recs' with up to 'num_recs' SiLK Flow records read from
+ *    'stream' and set 'recs_read' to the number read.  Modify the
+ *    times on the records if the user has requested time binning.
+ *    Modify the IPs if the user has specified CIDR blocks.
+ *
+ *    Return the status of reading the records, as for
+ *    skStreamReadRecords().
+ */
+int
+readRecords(
+    skstream_t         *stream,
+    rwRec              *recs,
+    size_t              num_recs,
+    size_t             *recs_read)
+{
+    size_t local_recs_read;
+    uint64_t total = 0;
+    size_t i;
     int rv;
 
-    rv = skStreamReadRecord(stream, rwrec);
-    if (SKSTREAM_OK == rv) {
-        ++record_count;
-        switch (limit.fl_id) {
-          case SK_FIELD_RECORDS:
-            ++value_total;
-            break;
-          case SK_FIELD_SUM_BYTES:
-            value_total += rwRecGetBytes(rwrec);
-            break;
-          case SK_FIELD_SUM_PACKETS:
-            value_total += rwRecGetPkts(rwrec);
-            break;
-          default:
-            break;
+    if (NULL == recs_read) {
+        recs_read = &local_recs_read;
+    }
+    rv = skStreamReadRecords(stream, recs, num_recs, recs_read);
+    if (0 == *recs_read) {
+        return rv;
+    }
+
+    switch (limit.fl_id) {
+      case SK_FIELD_RECORDS:
+        total = *recs_read;
+        break;
+      case SK_FIELD_SUM_BYTES:
+        for (i = 0; i < *recs_read; ++i) {
+            total += rwRecGetBytes(&recs[i]);
         }
+        break;
+      case SK_FIELD_SUM_PACKETS:
+        for (i = 0; i < *recs_read; ++i) {
+            total += rwRecGetPkts(&recs[i]);
+        }
+        break;
+      default:
+        break;
+    }
+    if (thread_count > 1) {
+        pthread_mutex_lock(&count_mutex);
+    }
+    record_count += *recs_read;
+    value_total += total;
+    if (thread_count > 1) {
+        pthread_mutex_unlock(&count_mutex);
+    }
 
+    for (i = 0; i < *recs_read; ++i) {
         if (cidr_sip) {
-            rwRecSetSIPv4(rwrec, rwRecGetSIPv4(rwrec) & cidr_sip);
+            rwRecSetSIPv4(&recs[i], rwRecGetSIPv4(&recs[i]) & cidr_sip);
         }
         if (cidr_dip) {
-            rwRecSetDIPv4(rwrec, rwRecGetDIPv4(rwrec) & cidr_dip);
+            rwRecSetDIPv4(&recs[i], rwRecGetDIPv4(&recs[i]) & cidr_dip);
         }
         if (time_bin_size > 1) {
-            switch (time_fields) {
-              case PARSE_KEY_STIME:
-              case (PARSE_KEY_STIME | PARSE_KEY_ELAPSED):
-                /* adjust start time */
-                sTime = rwRecGetStartTime(rwrec);
-                sTime_mod = sTime % time_bin_size;
-                rwRecSetStartTime(rwrec, (sTime - sTime_mod));
-                break;
-              case PARSE_KEY_ALL_TIMES:
-              case (PARSE_KEY_STIME | PARSE_KEY_ETIME):
-                /* adjust sTime and elapsed/duration */
-                sTime = rwRecGetStartTime(rwrec);
-                sTime_mod = sTime % time_bin_size;
-                rwRecSetStartTime(rwrec, (sTime - sTime_mod));
-                /*
-                 * the following sets elapsed to:
-                 * ((eTime - (eTime % bin_size)) - (sTime - (sTime % bin_size)))
-                 */
-                elapsed = rwRecGetElapsed(rwrec);
-                elapsed = (elapsed + sTime_mod
-                           - ((sTime + elapsed) % time_bin_size));
-                rwRecSetElapsed(rwrec, elapsed);
-                break;
-              case PARSE_KEY_ETIME:
-              case (PARSE_KEY_ETIME | PARSE_KEY_ELAPSED):
-                /* want to set eTime to (eTime - (eTime % bin_size)), but
-                 * eTime is computed as (sTime + elapsed) */
-                sTime = rwRecGetStartTime(rwrec);
-                rwRecSetStartTime(rwrec,
-                                  (sTime - ((sTime + rwRecGetElapsed(rwrec))
-                                            % time_bin_size)));
-                break;
-              case 0:
-              case PARSE_KEY_ELAPSED:
-              default:
-                skAbortBadCase(time_fields);
-            }
+            binRecordTimes(&recs[i]);
         }
     }
 
@@ -2437,6 +2740,24 @@ readRecord(
 }
 
 
+/*
+ *  status = readRecord(stream, rwrec);
+ *
+ *    Fill 'rwrec' with a SiLK Flow record read from 'stream'.  Modify
+ *    the times on the record if the user has requested time binning.
+ *    Modify the IPs if the user has specified CIDR blocks.
+ *
+ *    Return the status of reading the record.
+ */
+int
+readRecord(
+    skstream_t         *stream,
+    rwRec              *rwrec)
+{
+    return readRecords(stream, rwrec, 1, NULL);
+}
+
+
 /*
  *  int = appNextInput(&stream);
  *
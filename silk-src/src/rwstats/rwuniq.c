@@ -101,6 +101,9 @@ unsigned int time_fields_key = 0;
 /* whether dPort is part of the key */
 unsigned int dport_key = 0;
 
+/* number of threads that read and bin the records */
+uint32_t thread_count = RWUNIQ_THREADS_DEFAULT;
+
 /* how to handle IPv6 flows */
 sk_ipv6policy_t ipv6_policy = SK_IPV6POLICY_MIX;
 
@@ -166,6 +169,7 @@ writeAsciiRecord(
     uint8_t           **outbuf)
 {
     rwRec rwrec;
+    uint8_t approx_buf[HASHLIB_MAX_VALUE_WIDTH];
     uint64_t val64;
     uint32_t val32;
     uint32_t eTime = 0;
@@ -233,6 +237,20 @@ writeAsciiRecord(
                 }
                 break;
 
+              case SK_FIELD_APPROX_DISTINCT:
+                if (bf) {
+                    skFieldListExtractFromBuffer(value_fields, outbuf[1],
+                                                 field, approx_buf);
+                    val64 = skFieldListEntryGetApproxDistinctCount(
+                        field, approx_buf);
+                    if ((val64 < bf->bf_min)
+                        || (val64 > bf->bf_max))
+                    {
+                        return;
+                    }
+                }
+                break;
+
               default:
                 break;
             }
@@ -461,25 +479,37 @@ uniqRandom(
     sk_unique_iterator_t *iter;
     uint8_t *outbuf[3];
     skstream_t *stream;
-    rwRec rwrec;
+    rwRec recs[RWUNIQ_READ_RECS];
+    size_t count;
+    size_t i;
     int rv = 0;
 
-    while (0 == (rv = appNextInput(&stream))) {
-        while (SKSTREAM_OK == (rv = readRecord(stream, &rwrec))) {
-            if (0 != skUniqueAddRecord(uniq, &rwrec)) {
-                appExit(EXIT_FAILURE);
-            }
+    if (thread_count > 1) {
+        /* each thread reads files and bins their records */
+        if (skUniqueAddInputs(uniq, &appNextInput, &readRecords)) {
+            appExit(EXIT_FAILURE);
         }
-        if (rv != SKSTREAM_ERR_EOF) {
-            skStreamPrintLastErr(stream, rv, &skAppPrintErr);
+    } else {
+        while (0 == (rv = appNextInput(&stream))) {
+            do {
+                rv = readRecords(stream, recs, RWUNIQ_READ_RECS, &count);
+                for (i = 0; i < count; ++i) {
+                    if (0 != skUniqueAddRecord(uniq, &recs[i])) {
+                        appExit(EXIT_FAILURE);
+                    }
+                }
+            } while (SKSTREAM_OK == rv);
+            if (rv != SKSTREAM_ERR_EOF) {
+                skStreamPrintLastErr(stream, rv, &skAppPrintErr);
+                skStreamDestroy(&stream);
+                return;
+            }
             skStreamDestroy(&stream);
-            return;
         }
-        skStreamDestroy(&stream);
-    }
-    if (rv == -1) {
-        /* error reading file */
-        appExit(EXIT_FAILURE);
+        if (rv == -1) {
+            /* error reading file */
+            appExit(EXIT_FAILURE);
+        }
     }
 
     /* Write out the headings */
@@ -37,6 +37,15 @@ RCSIDENTVAR(rcsID_RWUNIQ_H, "$SiLK: rwuniq.h 275df62a2e41 2017-01-05 17:30:40Z m
 /* default sTime bin size to use when --bin-time is requested */
 #define DEFAULT_TIME_BIN  60
 
+/* environment variable that determines number of threads */
+#define RWUNIQ_THREADS_ENVAR    "SILK_RWUNIQ_THREADS"
+
+/* default number of threads to use */
+#define RWUNIQ_THREADS_DEFAULT  1
+
+/* number of records to read from an input stream at once */
+#define RWUNIQ_READ_RECS      256
+
 
 /* struct to hold information about built-in aggregate value fields */
 typedef struct builtin_field_st {
@@ -116,6 +125,9 @@ extern unsigned int time_fields_key;
 /* whether dPort is part of the key */
 extern unsigned int dport_key;
 
+/* number of threads that read and bin the records */
+extern uint32_t thread_count;
+
 /* FUNCTION DECLARATIONS */
 
 void
@@ -136,6 +148,12 @@ int
 readRecord(
     skstream_t         *stream,
     rwRec              *rwrec);
+int
+readRecords(
+    skstream_t         *stream,
+    rwRec              *recs,
+    size_t              num_recs,
+    size_t             *recs_read);
 void
 setOutputHandle(
     void);
@@ -108,6 +108,13 @@ static char delimiter = '|';
 /* input checker */
 static sk_options_ctx_t *optctx = NULL;
 
+/* number of plug-in fields the user requested */
+static unsigned int plugin_field_count = 0;
+
+/* when non-zero, the built-in distinct fields are estimated using
+ * this precision; set by --approximate-distinct */
+static uint8_t approx_distinct_precision = 0;
+
 /* fields that get defined just like plugins */
 static const struct app_static_plugins_st {
     const char         *name;
@@ -149,6 +156,7 @@ typedef enum {
     OPT_ETIME,
     OPT_SIP_DISTINCT,
     OPT_DIP_DISTINCT,
+    OPT_APPROXIMATE_DISTINCT,
     OPT_PRESORTED_INPUT,
     OPT_SORT_OUTPUT,
     OPT_BIN_TIME,
@@ -162,7 +170,8 @@ typedef enum {
     OPT_PRINT_FILENAMES,
     OPT_COPY_INPUT,
     OPT_OUTPUT_PATH,
-    OPT_PAGER
+    OPT_PAGER,
+    OPT_THREADS
 } appOptionsEnum;
 
 
@@ -179,6 +188,7 @@ static struct option appOptions[] = {
     {"etime",               NO_ARG,       0, OPT_ETIME},
     {"sip-distinct",        OPTIONAL_ARG, 0, OPT_SIP_DISTINCT},
     {"dip-distinct",        OPTIONAL_ARG, 0, OPT_DIP_DISTINCT},
+    {"approximate-distinct", OPTIONAL_ARG, 0, OPT_APPROXIMATE_DISTINCT},
     {"presorted-input",     NO_ARG,       0, OPT_PRESORTED_INPUT},
     {"sort-output",         NO_ARG,       0, OPT_SORT_OUTPUT},
     {"bin-time",            OPTIONAL_ARG, 0, OPT_BIN_TIME},
@@ -193,6 +203,7 @@ static struct option appOptions[] = {
     {"copy-input",          REQUIRED_ARG, 0, OPT_COPY_INPUT},
     {"output-path",         REQUIRED_ARG, 0, OPT_OUTPUT_PATH},
     {"pager",               REQUIRED_ARG, 0, OPT_PAGER},
+    {"threads",             REQUIRED_ARG, 0, OPT_THREADS},
     {0,0,0,0}               /* sentinel entry */
 };
 
@@ -218,6 +229,10 @@ static const char *appHelp[] = {
      "\tprint bins whose count is in range; range is MIN or MIN-MAX. Def. No"),
     ("Count distinct dIPs in each bin; optionally choose to\n"
      "\tprint bins whose count is in range; range is MIN or MIN-MAX. Def. No"),
+    ("Estimate the built-in distinct counts in a fixed amount\n"
+     "\tof memory per bin; optionally give the largest relative standard\n"
+     "\terror as a percentage. Def. Count exactly; error is 6.5 when no\n"
+     "\tpercentage is given"),
     ("Assume input has been presorted using\n"
      "\trwsort invoked with the exact same --fields value. Def. No"),
     ("Present the output in sorted order. Def. No"),
@@ -234,6 +249,8 @@ static const char *appHelp[] = {
     "Copy all input SiLK Flows to given pipe or file. Def. No",
     "Write the output to this stream or file. Def. stdout",
     "Invoke this program to page output. Def. $SILK_PAGER or $PAGER",
+    ("Read and bin the records using this number of threads.\n"
+     "\tDef. $" RWUNIQ_THREADS_ENVAR " or 1"),
     (char *)NULL
 };
 
@@ -258,6 +275,7 @@ isFieldDuplicate(
     const sk_fieldlist_t   *flist,
     sk_fieldid_t            fid,
     const void             *fcontext);
+static uint32_t getFieldId(const sk_fieldentry_t *fl_entry);
 static int  prepareFileForRead(skstream_t *stream);
 
 
@@ -397,6 +415,21 @@ appSetup(
         skPluginLoadPlugin(app_plugin_names[j], 0);
     }
 
+    /* check the thread count envar */
+    {
+        char *env;
+        uint32_t tc;
+
+        env = getenv(RWUNIQ_THREADS_ENVAR);
+        if (env && env[0]) {
+            if (skStringParseUint32(&tc, env, 1, 0) == 0) {
+                thread_count = tc;
+            } else {
+                thread_count = 1;
+            }
+        }
+    }
+
     /* parse options */
     rv = skOptionsCtxOptionsParse(optctx, argc, argv);
     if (rv < 0) {
@@ -452,6 +485,15 @@ appSetup(
     if (parseValueFields(values_arg)) {
         appExit(EXIT_FAILURE);
     }
+    if (approx_distinct_precision
+        && skFieldListGetBufferSize(value_fields) > HASHLIB_MAX_VALUE_WIDTH)
+    {
+        skAppPrintErr(("The values require more than %u octets;"
+                       " give a larger error to --%s"),
+                      (unsigned int)HASHLIB_MAX_VALUE_WIDTH,
+                      appOptions[OPT_APPROXIMATE_DISTINCT].name);
+        appExit(EXIT_FAILURE);
+    }
 
     /* make certain stdout is not being used for multiple outputs */
     if (copy_input
@@ -467,6 +509,18 @@ appSetup(
         }
     }
 
+    /* the threads call the plug-ins and share the --copy-input
+     * stream; do not use threads when either does not support it */
+    if ((thread_count > 1)
+        && (copy_input
+            || ((plugin_field_count > 0) && !skPluginIsThreadSafe())))
+    {
+        thread_count = 1;
+    }
+    if (thread_count > SKUNIQUE_MAX_THREADS) {
+        thread_count = SKUNIQUE_MAX_THREADS;
+    }
+
     /* create and initialize the uniq object */
     if (app_flags.presorted_input) {
         if (skPresortedUniqueCreate(&ps_uniq)) {
@@ -505,6 +559,7 @@ appSetup(
         skUniqueSetTempDirectory(uniq, temp_directory);
 
         if (skUniqueSetFields(uniq, key_fields, distinct_fields, value_fields)
+            || skUniqueSetThreads(uniq, thread_count)
             || skUniquePrepareForInput(uniq))
         {
             skAppPrintErr("Unable to set fields");
@@ -627,6 +682,7 @@ appOptionsHandler(
     char               *opt_arg)
 {
     uint32_t val32;
+    double percent;
     size_t i;
     int rv;
 
@@ -689,6 +745,27 @@ appOptionsHandler(
         }
         break;
 
+      case OPT_APPROXIMATE_DISTINCT:
+        if (NULL == opt_arg) {
+            approx_distinct_precision = SK_FIELD_APPROX_DISTINCT_MAX_PRECISION;
+        } else {
+            rv = skStringParseDouble(&percent, opt_arg, 0.0, 100.0);
+            if (rv) {
+                goto PARSE_ERROR;
+            }
+            approx_distinct_precision
+                = skFieldListApproxDistinctPrecision(percent);
+            if (0 == approx_distinct_precision) {
+                percent = (104.0
+                           / sqrt(1u << SK_FIELD_APPROX_DISTINCT_MAX_PRECISION));
+                skAppPrintErr(("Invalid %s '%s':"
+                               " The smallest supported error is %.1f"),
+                              appOptions[opt_index].name, opt_arg, percent);
+                return 1;
+            }
+        }
+        break;
+
       case OPT_PLUGIN:
         if (skPluginLoadPlugin(opt_arg, 1) != 0) {
             skAppPrintErr("Unable to load %s as a plugin", opt_arg);
@@ -780,6 +857,13 @@ appOptionsHandler(
       case OPT_PAGER:
         pager = opt_arg;
         break;
+
+      case OPT_THREADS:
+        rv = skStringParseUint32(&thread_count, opt_arg, 1, 0);
+        if (rv) {
+            goto PARSE_ERROR;
+        }
+        break;
     }
 
     return 0;                     /* OK */
@@ -934,6 +1018,13 @@ value_to_ascii(
         sktimestamp_r(text_buf, sktimeCreate(val32, 0), timestamp_format);
         break;
 
+      case SK_FIELD_APPROX_DISTINCT:
+        skFieldListExtractFromBuffer(value_fields, ((uint8_t**)v_outbuf)[1],
+                                     fl_entry, bin_buf);
+        snprintf(text_buf, text_buf_size, ("%" PRIu64),
+                 skFieldListEntryGetApproxDistinctCount(fl_entry, bin_buf));
+        break;
+
       case SK_FIELD_CALLER:
         /* get the binary value from the field-list */
         skFieldListExtractFromBuffer(value_fields, ((uint8_t**)v_outbuf)[1],
@@ -971,7 +1062,7 @@ builtin_distinct_get_title(
     int id;
     size_t sz;
 
-    id = skFieldListEntryGetId(fl_entry);
+    id = getFieldId(fl_entry);
     switch (id) {
       case SK_FIELD_SIPv4:
       case SK_FIELD_SIPv6:
@@ -1687,6 +1778,47 @@ parseKeyFields(
 }
 
 
+/*
+ *  status = appAddApproxDistinct(field_id, bf, name, text_len);
+ *
+ *    Add to the value fields a field that estimates the number of
+ *    distinct values of the built-in field 'field_id'.  'bf' is the
+ *    context for the field, 'name' is used in error messages, and
+ *    'text_len' is the width of the column.  Return 0 on success or
+ *    -1 on failure.
+ */
+static int
+appAddApproxDistinct(
+    sk_fieldid_t        field_id,
+    builtin_field_t    *bf,
+    const char         *name,
+    int                 text_len)
+{
+    sk_fieldentry_t *fl_entry;
+
+    if (isFieldDuplicate(value_fields, field_id, NULL)) {
+        skAppPrintErr("Invalid %s: Duplicate distinct '%s'",
+                      appOptions[OPT_VALUES].name, name);
+        return -1;
+    }
+    fl_entry = skFieldListAddApproxDistinctField(
+        value_fields, field_id, approx_distinct_precision, bf);
+    if (NULL == fl_entry) {
+        skAppPrintErr("Cannot add distinct field '%s' to field list", name);
+        return -1;
+    }
+    if (rwAsciiAppendCallbackFieldExtra(ascii_str,
+                                        &builtin_distinct_get_title,
+                                        &value_to_ascii,
+                                        fl_entry, text_len))
+    {
+        skAppPrintErr("Cannot add distinct field '%s' to stream", name);
+        return -1;
+    }
+    return 0;
+}
+
+
 /*
  *  ok = parseValueFields(field_string);
  *
@@ -1920,6 +2052,14 @@ parseValueFields(
                               bf->bf_title, sm_attr);
                 goto END;
             }
+            if (approx_distinct_precision) {
+                if (appAddApproxDistinct(bf->bf_id, bf, bf->bf_title,
+                                         bf->bf_text_len))
+                {
+                    goto END;
+                }
+                continue;
+            }
             /* is this a duplicate field? */
             if (isFieldDuplicate(distinct_fields, bf->bf_id, NULL)) {
                 skAppPrintErr("Invalid %s: Duplicate name '%s'",
@@ -2010,6 +2150,14 @@ parseValueFields(
                 }
             }
 #endif  /* #if SK_ENABLE_IPV6 */
+            if (approx_distinct_precision) {
+                if (appAddApproxDistinct((sk_fieldid_t)sm_entry_id, NULL,
+                                         sm_entry->name, bf->bf_text_len))
+                {
+                    goto END;
+                }
+                continue;
+            }
             fl_entry = skFieldListAddKnownField(distinct_fields,
                                                 sm_entry_id, NULL);
             if (NULL == fl_entry) {
@@ -2091,6 +2239,7 @@ appAddPlugin(
     if (pi_err != SKPLUGIN_OK) {
         return -1;
     }
+    ++plugin_field_count;
 
     /* initialize this field */
     pi_err = skPluginFieldRunInitialize(pi_field);
@@ -2203,7 +2352,7 @@ isFieldDuplicate(
       case SK_FIELD_SIPv4:
       case SK_FIELD_SIPv6:
         while ((fl_entry = skFieldListIteratorNext(&fl_iter)) != NULL) {
-            switch (skFieldListEntryGetId(fl_entry)) {
+            switch (getFieldId(fl_entry)) {
               case SK_FIELD_SIPv4:
               case SK_FIELD_SIPv6:
                 return 1;
@@ -2216,7 +2365,7 @@ isFieldDuplicate(
       case SK_FIELD_DIPv4:
       case SK_FIELD_DIPv6:
         while ((fl_entry = skFieldListIteratorNext(&fl_iter)) != NULL) {
-            switch (skFieldListEntryGetId(fl_entry)) {
+            switch (getFieldId(fl_entry)) {
               case SK_FIELD_DIPv4:
               case SK_FIELD_DIPv6:
                 return 1;
@@ -2229,7 +2378,7 @@ isFieldDuplicate(
       case SK_FIELD_NHIPv4:
       case SK_FIELD_NHIPv6:
         while ((fl_entry = skFieldListIteratorNext(&fl_iter)) != NULL) {
-            switch (skFieldListEntryGetId(fl_entry)) {
+            switch (getFieldId(fl_entry)) {
               case SK_FIELD_NHIPv4:
               case SK_FIELD_NHIPv6:
                 return 1;
@@ -2241,7 +2390,7 @@ isFieldDuplicate(
 
       case SK_FIELD_CALLER:
         while ((fl_entry = skFieldListIteratorNext(&fl_iter)) != NULL) {
-            if ((skFieldListEntryGetId(fl_entry) == (uint32_t)fid)
+            if ((getFieldId(fl_entry) == (uint32_t)fid)
                 && (skFieldListEntryGetContext(fl_entry) == fcontext))
             {
                 return 1;
@@ -2251,7 +2400,7 @@ isFieldDuplicate(
 
       default:
         while ((fl_entry = skFieldListIteratorNext(&fl_iter)) != NULL) {
-            if (skFieldListEntryGetId(fl_entry) == (uint32_t)fid) {
+            if (getFieldId(fl_entry) == (uint32_t)fid) {
                 return 1;
             }
         }
@@ -2261,6 +2410,26 @@ isFieldDuplicate(
 }
 
 
+/*
+ *  id = getFieldId(fl_entry);
+ *
+ *    Return the sk_fieldid_t of 'fl_entry'.  When 'fl_entry'
+ *    estimates a distinct count, return the id of the field whose
+ *    distinct values are estimated.
+ */
+static uint32_t
+getFieldId(
+    const sk_fieldentry_t  *fl_entry)
+{
+    uint32_t id = skFieldListEntryGetId(fl_entry);
+
+    if (SK_FIELD_APPROX_DISTINCT == id) {
+        return skFieldListEntryGetApproxDistinctId(fl_entry);
+    }
+    return id;
+}
+
+
 static int
 prepareFileForRead(
     skstream_t         *stream)
@@ -2278,62 +2447,85 @@ prepareFileForRead(
 
 
 /*
- *  status = readRecord(stream, rwrec);
+ *  binRecordTimes(rwrec);
  *
- *    Fill 'rwrec' with a SiLK Flow record read from 'stream'.  Modify
- *    the times on the record if the user has requested time binning.
- *
- *    Return the status of reading the record.
+ *    Modify the times on 'rwrec' to the user's requested time bin.
  */
-int
-readRecord(
-    skstream_t         *stream,
+static void
+binRecordTimes(
     rwRec              *rwrec)
 {
     sktime_t sTime;
     sktime_t sTime_mod;
     uint32_t elapsed;
+
+    switch (time_fields) {
+      case PARSE_KEY_STIME:
+      case (PARSE_KEY_STIME | PARSE_KEY_ELAPSED):
+        /* adjust start time */
+        sTime = rwRecGetStartTime(rwrec);
+        sTime_mod = sTime % time_bin_size;
+        rwRecSetStartTime(rwrec, (sTime - sTime_mod));
+        break;
+      case PARSE_KEY_ALL_TIMES:
+      case (PARSE_KEY_STIME | PARSE_KEY_ETIME):
+        /* adjust sTime and elapsed/duration */
+        sTime = rwRecGetStartTime(rwrec);
+        sTime_mod = sTime % time_bin_size;
+        rwRecSetStartTime(rwrec, (sTime - sTime_mod));
+        /*
+         * the following sets elapsed to:
+         * ((eTime - (eTime % bin_size)) - (sTime - (sTime % bin_size)))
+         */
+        elapsed = rwRecGetElapsed(rwrec);
+        elapsed = (elapsed + sTime_mod
+                   - ((sTime + elapsed) % time_bin_size));
+        rwRecSetElapsed(rwrec, elapsed);
+        break;
+      case PARSE_KEY_ETIME:
+      case (PARSE_KEY_ETIME | PARSE_KEY_ELAPSED):
+        /* want to set eTime to (eTime - (eTime % bin_size)), but
+         * eTime is computed as (sTime + elapsed) */
+        sTime = rwRecGetStartTime(rwrec);
+        rwRecSetStartTime(rwrec, (sTime - ((sTime + rwRecGetElapsed(rwrec))
+                                           % time_bin_size)));
+        break;
+      case 0:
+      case PARSE_KEY_ELAPSED:
+      default:
+        skAbortBadCase(time_fields);
+    }
+}
+
+
+/*
+ *  status = readRecords(stream, recs, num_recs, &recs_read);
+ *
+ *    Fill 'recs' with up to 'num_recs' SiLK Flow records read from
+ *    'stream' and set 'recs_read' to the number read.  Modify the
+ *    times on the records if the user has requested time binning.
+ *
+ *    Return the status of reading the records, as for
+ *    skStreamReadRecords().
+ */
+int
+readRecords(
+    skstream_t         *stream,
+    rwRec              *recs,
+    size_t              num_recs,
+    size_t             *recs_read)
+{
+    size_t local_recs_read;
+    size_t i;
     int rv;
 
-    rv = skStreamReadRecord(stream, rwrec);
-    if (SKSTREAM_OK == rv
-        && time_bin_size > 1)
-    {
-        switch (time_fields) {
-          case PARSE_KEY_STIME:
-          case (PARSE_KEY_STIME | PARSE_KEY_ELAPSED):
-            /* adjust start time */
-            sTime = rwRecGetStartTime(rwrec);
-            sTime_mod = sTime % time_bin_size;
-            rwRecSetStartTime(rwrec, (sTime - sTime_mod));
-            break;
-          case PARSE_KEY_ALL_TIMES:
-          case (PARSE_KEY_STIME | PARSE_KEY_ETIME):
-            /* adjust sTime and elapsed/duration */
-            sTime = rwRecGetStartTime(rwrec);
-            sTime_mod = sTime % time_bin_size;
-            rwRecSetStartTime(rwrec, (sTime - sTime_mod));
-            /*
-             * the following sets elapsed to:
-             * ((eTime - (eTime % bin_size)) - (sTime - (sTime % bin_size)))
-             */
-            elapsed = rwRecGetElapsed(rwrec);
-            elapsed = (elapsed + sTime_mod
-                       - ((sTime + elapsed) % time_bin_size));
-            rwRecSetElapsed(rwrec, elapsed);
-            break;
-          case PARSE_KEY_ETIME:
-          case (PARSE_KEY_ETIME | PARSE_KEY_ELAPSED):
-            /* want to set eTime to (eTime - (eTime % bin_size)), but
-             * eTime is computed as (sTime + elapsed) */
-            sTime = rwRecGetStartTime(rwrec);
-            rwRecSetStartTime(rwrec, (sTime - ((sTime + rwRecGetElapsed(rwrec))
-                                               % time_bin_size)));
-            break;
-          case 0:
-          case PARSE_KEY_ELAPSED:
-          default:
-            skAbortBadCase(time_fields);
+    if (NULL == recs_read) {
+        recs_read = &local_recs_read;
+    }
+    rv = skStreamReadRecords(stream, recs, num_recs, recs_read);
+    if (time_bin_size > 1) {
+        for (i = 0; i < *recs_read; ++i) {
+            binRecordTimes(&recs[i]);
         }
     }
 
@@ -2341,6 +2533,23 @@ readRecord(
 }
 
 
+/*
+ *  status = readRecord(stream, rwrec);
+ *
+ *    Fill 'rwrec' with a SiLK Flow record read from 'stream'.  Modify
+ *    the times on the record if the user has requested time binning.
+ *
+ *    Return the status of reading the record.
+ */
+int
+readRecord(
+    skstream_t         *stream,
+    rwRec              *rwrec)
+{
+    return readRecords(stream, rwrec, 1, NULL);
+}
+
+
 /*
  *  int = appNextInput(&stream);
  *
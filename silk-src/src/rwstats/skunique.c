@@ -49,6 +49,36 @@ RCSIDENT("$SiLK: skunique.c 7ef130398e4c 2017-06-20 14:58:08Z mthomas $");
 
 #define MAX_MERGE_FILES 1024
 
+/* When multiple threads add records, the number of bins a thread
+ * holds in its own hash table before it merges them into the
+ * partitions */
+#define THREAD_TABLE_SIZE    (HASH_INITIAL_SIZE >> 2)
+
+/* The number of records a thread in skUniqueAddInputs() reads from a
+ * stream at once */
+#define UNIQUE_READ_RECS     256
+
+/* Seed for the hash that chooses the partition for a key.  This
+ * differs from the seed used by hashlib so that the keys in a
+ * partition are spread across all buckets of the partition's table */
+#define PARTITION_HASH_SEED  0x9e3779b9
+
+/* seed for the hash used by approximate distinct fields */
+#define APPROX_DISTINCT_HASH_SEED  0x3c6ef372
+
+/* number of bits in each register of an approximate distinct field */
+#define APPROX_DISTINCT_REGISTER_BITS  5
+
+/* number of octets required by an approximate distinct field having
+ * the specified precision */
+#define APPROX_DISTINCT_OCTETS(ado_precision)                   \
+    ((APPROX_DISTINCT_REGISTER_BITS << (ado_precision)) >> 3)
+
+/* Largest bin returned by the iterator over the partitions: the key,
+ * the value, and the distinct counts */
+#define PART_MAX_NODE_BYTES                                 \
+    (2 * HASHLIB_MAX_KEY_WIDTH + HASHLIB_MAX_VALUE_WIDTH)
+
 #define COMP_FUNC_CAST(cfc_func)                                \
     (int (*)(const void*, const void*, void*))(cfc_func)
 
@@ -90,6 +120,33 @@ RCSIDENT("$SiLK: skunique.c 7ef130398e4c 2017-06-20 14:58:08Z mthomas $");
 
 
 
+/* use the hash function defined in hashlib.c to choose a partition */
+#ifdef HASHLIB_LOOKUP2
+unsigned long
+hash(
+    const uint8_t      *k,
+    unsigned long       len,
+    unsigned long       initval);
+#else
+uint32_t
+hashlittle(
+    const void         *key,
+    size_t              length,
+    uint32_t            initval);
+uint32_t
+hashbig(
+    const void         *key,
+    size_t              length,
+    uint32_t            initval);
+#if SK_BIG_ENDIAN
+#  define hash  hashbig
+#else
+#  define hash  hashlittle
+#endif
+#endif  /* HASHLIB_LOOKUP2 */
+
+
+
 /* FUNCTION DEFINITIONS */
 
 
@@ -185,6 +242,12 @@ struct sk_fieldentry_st {
     uint8_t                        *initial_value;
 
     sk_fieldlist_t                 *parent_list;
+
+    /* for an SK_FIELD_APPROX_DISTINCT field, a list holding the field
+     * whose distinct values are counted and the number of hash bits
+     * that select a register */
+    sk_fieldlist_t                 *approx_source;
+    uint8_t                         approx_precision;
 };
 
 
@@ -334,6 +397,7 @@ skFieldListDestroy(
         if (field->initial_value) {
             free(field->initial_value);
         }
+        skFieldListDestroy(&field->approx_source);
     }
 
     free(fl);
@@ -462,6 +526,7 @@ skFieldListAddKnownField(
         bin_octets = 16;
         break;
 
+      case SK_FIELD_APPROX_DISTINCT:
       case SK_FIELD_CALLER:
         break;
     }
@@ -487,6 +552,279 @@ skFieldListAddKnownField(
 }
 
 
+/*  add an approximate distinct field to a field list */
+sk_fieldentry_t *
+skFieldListAddApproxDistinctField(
+    sk_fieldlist_t     *field_list,
+    int                 distinct_id,
+    uint8_t             precision,
+    void               *ctx)
+{
+    sk_fieldentry_t *field = NULL;
+    sk_fieldlist_t *source;
+
+    if (NULL == field_list) {
+        return NULL;
+    }
+    if (FIELDLIST_MAX_NUM_FIELDS == field_list->num_fields) {
+        return NULL;
+    }
+    if (precision < SK_FIELD_APPROX_DISTINCT_MIN_PRECISION
+        || precision > SK_FIELD_APPROX_DISTINCT_MAX_PRECISION)
+    {
+        skAppPrintErr("Invalid approximate distinct precision %u",
+                      (unsigned int)precision);
+        return NULL;
+    }
+
+    /* the source list holds the field whose values are counted */
+    if (skFieldListCreate(&source)) {
+        return NULL;
+    }
+    if (NULL == skFieldListAddKnownField(source, distinct_id, NULL)) {
+        skFieldListDestroy(&source);
+        return NULL;
+    }
+
+    field = &field_list->fields[field_list->num_fields];
+    ++field_list->num_fields;
+
+    memset(field, 0, sizeof(sk_fieldentry_t));
+    field->offset = field_list->total_octets;
+    field->octets = APPROX_DISTINCT_OCTETS(precision);
+    field->parent_list = field_list;
+    field->id = SK_FIELD_APPROX_DISTINCT;
+    field->context = ctx;
+    field->approx_source = source;
+    field->approx_precision = precision;
+
+    field_list->total_octets += field->octets;
+
+    return field;
+}
+
+
+/*  return the precision needed for an approximate distinct error */
+uint8_t
+skFieldListApproxDistinctPrecision(
+    double              error_percent)
+{
+    uint8_t p;
+
+    for (p = SK_FIELD_APPROX_DISTINCT_MIN_PRECISION;
+         p <= SK_FIELD_APPROX_DISTINCT_MAX_PRECISION;
+         ++p)
+    {
+        if (104.0 / sqrt((double)(1u << p)) <= error_percent) {
+            return p;
+        }
+    }
+    return 0;
+}
+
+
+/*
+ *  value = approxDistinctGetRegister(field, registers, idx);
+ *
+ *    Return the value of register 'idx' in 'registers', the buffer of
+ *    the approximate distinct field 'field'.
+ */
+static uint8_t
+approxDistinctGetRegister(
+    const sk_fieldentry_t  *field,
+    const uint8_t          *registers,
+    uint32_t                idx)
+{
+    size_t bit = (size_t)idx * APPROX_DISTINCT_REGISTER_BITS;
+    size_t octet = bit >> 3;
+    uint32_t v;
+
+    v = registers[octet];
+    if (octet + 1 < field->octets) {
+        v |= (uint32_t)registers[octet + 1] << 8;
+    }
+    return (uint8_t)((v >> (bit & 0x7))
+                     & ((1u << APPROX_DISTINCT_REGISTER_BITS) - 1));
+}
+
+
+/*
+ *  approxDistinctSetRegister(field, registers, idx, value);
+ *
+ *    Set register 'idx' in 'registers', the buffer of the approximate
+ *    distinct field 'field', to 'value'.
+ */
+static void
+approxDistinctSetRegister(
+    const sk_fieldentry_t  *field,
+    uint8_t                *registers,
+    uint32_t                idx,
+    uint8_t                 value)
+{
+    size_t bit = (size_t)idx * APPROX_DISTINCT_REGISTER_BITS;
+    size_t octet = bit >> 3;
+    uint32_t mask = ((1u << APPROX_DISTINCT_REGISTER_BITS) - 1) << (bit & 0x7);
+    uint32_t v;
+
+    v = registers[octet];
+    if (octet + 1 < field->octets) {
+        v |= (uint32_t)registers[octet + 1] << 8;
+    }
+    v = (v & ~mask) | (((uint32_t)value << (bit & 0x7)) & mask);
+    registers[octet] = (uint8_t)(v & 0xFF);
+    if (octet + 1 < field->octets) {
+        registers[octet + 1] = (uint8_t)(v >> 8);
+    }
+}
+
+
+/*
+ *  approxDistinctAddRec(field, rwrec, registers);
+ *
+ *    Add the value of the source field of the approximate distinct
+ *    field 'field' on 'rwrec' to the sketch in 'registers'.  The high
+ *    bits of the value's hash select a register, and the register is
+ *    set to the position of the first 1 bit among the remaining bits
+ *    when that is larger than the register's current value.
+ */
+static void
+approxDistinctAddRec(
+    const sk_fieldentry_t  *field,
+    const rwRec            *rwrec,
+    uint8_t                *registers)
+{
+    uint8_t value[HASHLIB_MAX_KEY_WIDTH];
+    const uint8_t precision = field->approx_precision;
+    uint32_t h;
+    uint32_t idx;
+    uint8_t rho;
+
+    skFieldListRecToBinary(field->approx_source, rwrec, value);
+    h = (uint32_t)hash(value, field->approx_source->total_octets,
+                       APPROX_DISTINCT_HASH_SEED);
+    idx = h >> (32 - precision);
+    h <<= precision;
+    for (rho = 1; rho <= 32 - precision && 0 == (h & 0x80000000); ++rho) {
+        h <<= 1;
+    }
+    if (rho > approxDistinctGetRegister(field, registers, idx)) {
+        approxDistinctSetRegister(field, registers, idx, rho);
+    }
+}
+
+
+/*
+ *  approxDistinctMerge(field, registers_a, registers_b);
+ *
+ *    Merge the sketch in 'registers_b' into 'registers_a' by setting
+ *    each register in 'registers_a' to the larger of the two.
+ */
+static void
+approxDistinctMerge(
+    const sk_fieldentry_t  *field,
+    uint8_t                *registers_a,
+    const uint8_t          *registers_b)
+{
+    const uint32_t m = 1u << field->approx_precision;
+    uint8_t val_b;
+    uint32_t j;
+
+    for (j = 0; j < m; ++j) {
+        val_b = approxDistinctGetRegister(field, registers_b, j);
+        if (val_b > approxDistinctGetRegister(field, registers_a, j)) {
+            approxDistinctSetRegister(field, registers_a, j, val_b);
+        }
+    }
+}
+
+
+/*  return the estimated distinct count of an approximate distinct
+ *  field */
+uint64_t
+skFieldListEntryGetApproxDistinctCount(
+    const sk_fieldentry_t  *field,
+    const uint8_t          *field_buffer)
+{
+    const double two_32 = 4294967296.0;
+    const uint32_t m = 1u << field->approx_precision;
+    uint32_t zeros = 0;
+    double alpha;
+    double sum = 0.0;
+    double estimate;
+    uint8_t val;
+    uint32_t j;
+
+    assert(SK_FIELD_APPROX_DISTINCT == field->id);
+
+    for (j = 0; j < m; ++j) {
+        val = approxDistinctGetRegister(field, field_buffer, j);
+        sum += ldexp(1.0, -(int)val);
+        if (0 == val) {
+            ++zeros;
+        }
+    }
+    if (zeros == m) {
+        return 0;
+    }
+
+    switch (m) {
+      case 16:
+        alpha = 0.673;
+        break;
+      case 32:
+        alpha = 0.697;
+        break;
+      case 64:
+        alpha = 0.709;
+        break;
+      default:
+        alpha = 0.7213 / (1.0 + 1.079 / m);
+        break;
+    }
+    estimate = alpha * m * m / sum;
+
+    if (estimate <= 2.5 * m && zeros) {
+        /* small range correction: use linear counting */
+        estimate = m * log((double)m / zeros);
+    } else if (estimate > two_32 / 30.0) {
+        /* large range correction for collisions in a 32-bit hash */
+        estimate = -two_32 * log(1.0 - estimate / two_32);
+    }
+    return (uint64_t)(estimate + 0.5);
+}
+
+
+/*  return the id of the field counted by an approximate distinct
+ *  field */
+uint32_t
+skFieldListEntryGetApproxDistinctId(
+    const sk_fieldentry_t  *field)
+{
+    assert(field);
+    assert(SK_FIELD_APPROX_DISTINCT == field->id);
+    return field->approx_source->fields[0].id;
+}
+
+
+/*
+ *  cmp = approxDistinctCompare(field, registers_a, registers_b);
+ *
+ *    Compare the estimated distinct counts of two approximate
+ *    distinct sketches and return -1, 0, 1.
+ */
+static int
+approxDistinctCompare(
+    const sk_fieldentry_t  *field,
+    const uint8_t          *registers_a,
+    const uint8_t          *registers_b)
+{
+    uint64_t a = skFieldListEntryGetApproxDistinctCount(field, registers_a);
+    uint64_t b = skFieldListEntryGetApproxDistinctCount(field, registers_b);
+
+    return COMPARE(a, b);
+}
+
+
 /*  return context for a field */
 void *
 skFieldListEntryGetContext(
@@ -804,6 +1142,10 @@ skFieldListAddRecToBuffer(
                 break;
 #endif  /* SKUNIQ_USE_MEMCPY */
 
+              case SK_FIELD_APPROX_DISTINCT:
+                approxDistinctAddRec(f, rwrec, FIELD_PTR(summed, f));
+                break;
+
               case SK_FIELD_CALLER:
                 break;
 
@@ -918,6 +1260,11 @@ skFieldListMergeBuffers(
                 break;
 #endif  /* SKUNIQ_USE_MEMCPY */
 
+              case SK_FIELD_APPROX_DISTINCT:
+                approxDistinctMerge(f, FIELD_PTR(all_fields_buffer1, f),
+                                    FIELD_PTR(all_fields_buffer2, f));
+                break;
+
               default:
                 break;
             }
@@ -1004,6 +1351,11 @@ skFieldListCompareBuffers(
                              FIELD_PTR(all_fields_buffer2, f));
                 break;
 
+              case SK_FIELD_APPROX_DISTINCT:
+                rv = approxDistinctCompare(f, FIELD_PTR(all_fields_buffer1, f),
+                                           FIELD_PTR(all_fields_buffer2, f));
+                break;
+
               default:
                 rv = memcmp(FIELD_PTR(all_fields_buffer1, f),
                             FIELD_PTR(all_fields_buffer2, f),
@@ -1083,6 +1435,11 @@ skFieldListEntryCompareBuffers(
             CMP_INT_PTRS(rv, uint64_t, field_buffer1, field_buffer2);
             break;
 
+          case SK_FIELD_APPROX_DISTINCT:
+            rv = approxDistinctCompare(field_entry, field_buffer1,
+                                       field_buffer2);
+            break;
+
           default:
             rv = memcmp(field_buffer1, field_buffer2, field_entry->octets);
             break;
@@ -1776,6 +2133,7 @@ static struct allowed_fieldid_st {
     {SK_FIELD_SUM_ELAPSED,      VALUE_ONLY},
     {SK_FIELD_MIN_STARTTIME,    VALUE_ONLY},
     {SK_FIELD_MAX_ENDTIME,      VALUE_ONLY},
+    {SK_FIELD_APPROX_DISTINCT,  VALUE_ONLY},
     {SK_FIELD_CALLER,           KEY_VALUE_DISTINCT}
 };
 
@@ -2238,6 +2596,73 @@ uniqDistinctShortListToHashSet(
 }
 
 
+/*
+ *  status = uniqDistinctIncrementOne(dist, value);
+ *
+ *    Add the distinct value at 'value' to the single distinct counter
+ *    'dist'.  Return 0 on success or -1 on memory allocation failure.
+ */
+static int
+uniqDistinctIncrementOne(
+    distinct_value_t   *dist,
+    const uint8_t      *value)
+{
+    int rv;
+
+    switch (dist->dv_type) {
+      case DISTINCT_BITMAP:
+        skBitmapSetBit(dist->dv_v.dv_bitmap, *value);
+        dist->dv_count = skBitmapGetHighCount(dist->dv_v.dv_bitmap);
+        break;
+      case DISTINCT_SHORTLIST:
+        rv = skShortListInsert(dist->dv_v.dv_shortlist, (void*)value);
+        switch (rv) {
+          case SK_SHORT_LIST_OK:
+            ++dist->dv_count;
+            break;
+          case SK_SHORT_LIST_OK_DUPLICATE:
+            break;
+          case SK_SHORT_LIST_ERR_FULL:
+            if (uniqDistinctShortListToHashSet(dist)) {
+                return -1;
+            }
+            rv = hashset_insert(dist->dv_v.dv_hashset, (uint8_t*)value);
+            switch (rv) {
+              case OK:
+                ++dist->dv_count;
+                break;
+              case OK_DUPLICATE:
+                break;
+              default:
+                TRACEMSG(("%s:%d: Error inserting value into hashset",
+                          __FILE__, __LINE__));
+                return -1;
+            }
+            break;
+          default:
+            skAbortBadCase(rv);
+        }
+        break;
+      case DISTINCT_HASHSET:
+        rv = hashset_insert(dist->dv_v.dv_hashset, (uint8_t*)value);
+        switch (rv) {
+          case OK:
+            ++dist->dv_count;
+            break;
+          case OK_DUPLICATE:
+            break;
+          default:
+            TRACEMSG(("%s:%d: Error inserting value into hashset",
+                      __FILE__, __LINE__));
+            return -1;
+        }
+        break;
+    }
+
+    return 0;
+}
+
+
 /*
  *  status = uniqDistinctIncrement(uniq_fields, distincts, key);
  *
@@ -2250,62 +2675,69 @@ uniqDistinctIncrement(
     distinct_value_t           *distincts,
     const uint8_t              *key)
 {
+    uint8_t i;
+
+    for (i = 0; i < field_info->distinct_num_fields; ++i) {
+        if (uniqDistinctIncrementOne(&distincts[i],
+                                     DISTINCT_PTR(key, distincts, i)))
+        {
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+
+/*
+ *  status = uniqDistinctMerge(uniq_fields, distincts, src_distincts);
+ *
+ *    Add every value held by the distinct counters in
+ *    'src_distincts' to the counters in 'distincts'.  'src_distincts'
+ *    is not modified.  Return 0 on success or -1 on memory allocation
+ *    failure, in which case 'distincts' may hold some of the values.
+ */
+static int
+uniqDistinctMerge(
+    const sk_uniq_field_info_t *field_info,
+    distinct_value_t           *distincts,
+    const distinct_value_t     *src_distincts)
+{
+    const distinct_value_t *src;
     distinct_value_t *dist;
+    hashset_iter h_iter;
+    uint8_t *hash_key;
+    uint32_t j;
     uint8_t i;
-    int rv;
 
     for (i = 0; i < field_info->distinct_num_fields; ++i) {
         dist = &distincts[i];
-        switch (dist->dv_type) {
+        src = &src_distincts[i];
+        switch (src->dv_type) {
           case DISTINCT_BITMAP:
-            skBitmapSetBit(dist->dv_v.dv_bitmap,
-                           *(uint8_t*)DISTINCT_PTR(key, distincts, i));
+            assert(DISTINCT_BITMAP == dist->dv_type);
+            skBitmapUnion(dist->dv_v.dv_bitmap, src->dv_v.dv_bitmap);
             dist->dv_count = skBitmapGetHighCount(dist->dv_v.dv_bitmap);
             break;
           case DISTINCT_SHORTLIST:
-            rv = skShortListInsert(dist->dv_v.dv_shortlist,
-                                   (void*)DISTINCT_PTR(key,distincts,i));
-            switch (rv) {
-              case SK_SHORT_LIST_OK:
-                ++dist->dv_count;
-                break;
-              case SK_SHORT_LIST_OK_DUPLICATE:
-                break;
-              case SK_SHORT_LIST_ERR_FULL:
-                if (uniqDistinctShortListToHashSet(dist)) {
-                    return -1;
-                }
-                rv = hashset_insert(dist->dv_v.dv_hashset,
-                                    DISTINCT_PTR(key,distincts,i));
-                switch (rv) {
-                  case OK:
-                    ++dist->dv_count;
-                    break;
-                  case OK_DUPLICATE:
-                    break;
-                  default:
-                    TRACEMSG(("%s:%d: Error inserting value into hashset",
-                              __FILE__, __LINE__));
+            for (j = skShortListCountEntries(src->dv_v.dv_shortlist); j > 0;){
+                --j;
+                if (uniqDistinctIncrementOne(
+                        dist, (uint8_t*)skShortListGetElement(
+                            src->dv_v.dv_shortlist, j)))
+                {
                     return -1;
                 }
-                break;
-              default:
-                skAbortBadCase(rv);
             }
             break;
           case DISTINCT_HASHSET:
-            rv = hashset_insert(dist->dv_v.dv_hashset,
-                                DISTINCT_PTR(key, distincts, i));
-            switch (rv) {
-              case OK:
-                ++dist->dv_count;
-                break;
-              case OK_DUPLICATE:
-                break;
-              default:
-                TRACEMSG(("%s:%d: Error inserting value into hashset",
-                          __FILE__, __LINE__));
-                return -1;
+            h_iter = hashset_create_iterator(src->dv_v.dv_hashset);
+            while (OK == hashset_iterate(src->dv_v.dv_hashset,
+                                         &h_iter, &hash_key))
+            {
+                if (uniqDistinctIncrementOne(dist, hash_key)) {
+                    return -1;
+                }
             }
             break;
         }
@@ -3549,23 +3981,115 @@ uniqTempWriteTriple(
 
 /* **************************************************************** */
 
-/* structure for binning records */
+/*
+ *    When multiple threads add records to an sk_unique_t, the bins
+ *    are divided among partitions by a hash of the key.  Each
+ *    partition is an sk_unique_t that is used by one thread at a
+ *    time.
+ */
+typedef struct uniq_partition_st {
+    /* the bins whose keys hash to this partition */
+    sk_unique_t            *uniq;
 
-/* typedef struct sk_unique_st sk_unique_t; */
-struct sk_unique_st {
-    /* information about the fields */
-    sk_uniq_field_info_t    fi;
+    /* the object that owns this partition */
+    sk_unique_t            *parent;
 
-    /* where to write temporary files */
-    char                   *temp_dir;
+    /* protects 'uniq' while threads are adding records */
+    pthread_mutex_t         mutex;
 
-    /* the hash table */
-    HashTable              *ht;
+    /* the thread that merges this partition */
+    pthread_t               thread;
 
-    /* the temp file context */
-    sk_tempfilectx_t       *tmpctx;
+    /* index of this partition */
+    uint32_t                part_idx;
 
-    /* pointer to the current intermediate temporary file; it's index
+    /* when the partition wrote its bins to temporary files, the index
+     * of the temporary file holding the merged bins; otherwise -1 */
+    int                     result_idx;
+
+    /* result of merging this partition: 0 on success, -1 on error */
+    int                     rv;
+
+    /* whether 'thread' was started */
+    unsigned                started :1;
+} uniq_partition_t;
+
+
+/*
+ *    When the number of bins is bounded by skUniqueSetMaxBins(), the
+ *    bins are held in a fixed array and maintained with the
+ *    Space-Saving algorithm: a record whose key is not present when
+ *    the array is full replaces the bin having the smallest rank.
+ *    The new key's values start from their initial values, and the
+ *    rank of the replaced bin becomes the new bin's error: the most
+ *    by which the values undercount the key.  Bins are ranked by
+ *    their rank value plus their error.
+ *
+ *    The bins are located by an open-addressed table of bin indexes
+ *    that uses linear probing, and they are ordered by rank in a
+ *    min-heap of bin indexes.
+ */
+typedef struct uniq_maxbins_st {
+    /* the bins; each is the key, the value, and the error as a
+     * uint64_t */
+    uint8_t                *bins;
+
+    /* the hash of the key of each bin */
+    uint32_t               *bin_hash;
+
+    /* the min-heap of bin indexes ordered by rank */
+    uint32_t               *heap;
+
+    /* the position of each bin in 'heap' */
+    uint32_t               *heap_pos;
+
+    /* the open-addressed table of bin indexes */
+    uint32_t               *slots;
+
+    /* the field in the value that ranks the bins */
+    const sk_fieldentry_t  *rank_field;
+
+    /* one less than the number of entries in 'slots' */
+    uint32_t                slot_mask;
+
+    /* the maximum number of bins */
+    uint32_t                max_bins;
+
+    /* the number of bins in use */
+    uint32_t                num_bins;
+
+    /* the size of a bin */
+    uint32_t                bin_octets;
+
+    /* the offset of the error within a bin */
+    uint32_t                error_offset;
+
+    /* the number of times a bin has been replaced */
+    uint64_t                evictions;
+
+    /* the most by which any key's values may be undercounted; set
+     * by skUniquePrepareForOutput() */
+    uint64_t                error_bound;
+} uniq_maxbins_t;
+
+
+/* structure for binning records */
+
+/* typedef struct sk_unique_st sk_unique_t; */
+struct sk_unique_st {
+    /* information about the fields */
+    sk_uniq_field_info_t    fi;
+
+    /* where to write temporary files */
+    char                   *temp_dir;
+
+    /* the hash table */
+    HashTable              *ht;
+
+    /* the temp file context */
+    sk_tempfilectx_t       *tmpctx;
+
+    /* pointer to the current intermediate temporary file; it's index
      * is given by the 'temp_idx' member */
     skstream_t             *temp_fp;
 
@@ -3590,6 +4114,28 @@ struct sk_unique_st {
      * index of 'dist_fp'. */
     int                     max_temp_idx;
 
+    /* when multiple threads add records, the partitions.  there is
+     * one partition per thread */
+    uniq_partition_t       *parts;
+
+    /* when multiple threads add records, the hash table for each
+     * thread */
+    HashTable             **thread_ht;
+
+    /* when multiple threads add records, protects 'total_dist' */
+    pthread_mutex_t         total_dist_mutex;
+
+    /* when the number of bins is bounded, the bins */
+    uniq_maxbins_t         *maxbins;
+
+    /* the maximum number of bins and the field that ranks them, as
+     * given to skUniqueSetMaxBins() */
+    const sk_fieldentry_t  *maxbins_rank;
+    uint32_t                maxbins_count;
+
+    /* number of threads that add records */
+    uint32_t                thread_count;
+
     uint32_t                hash_value_octets;
 
     /* whether the output should be sorted */
@@ -3709,43 +4255,56 @@ uniqueCreateHashTable(
 
 
 /*
- *  uniqueDestroyHashTable(uniq);
+ *  uniqueFreeHashTable(field_info, ht);
  *
- *    Destroy the hashlib hash table stored on 'uniq'.
+ *    Free the distinct values held by the hash table 'ht', whose
+ *    entries are described by 'field_info', and then free 'ht'.
  */
 static void
-uniqueDestroyHashTable(
-    sk_unique_t        *uniq)
+uniqueFreeHashTable(
+    const sk_uniq_field_info_t *field_info,
+    HashTable                  *ht)
 {
     distinct_value_t *distincts;
     uint8_t *hash_key;
     uint8_t *hash_val;
     HASH_ITER ithash;
 
-    if (NULL == uniq->ht) {
+    if (NULL == ht) {
         return;
     }
 #if 0 && defined(HASHLIB_RECORD_STATS)
-    hashlib_print_stats(stderr, uniq->ht);
+    hashlib_print_stats(stderr, ht);
 #endif
-    if (0 == uniq->fi.distinct_num_fields) {
-        hashlib_free_table(uniq->ht);
-        uniq->ht = NULL;
+    if (0 == field_info->distinct_num_fields) {
+        hashlib_free_table(ht);
         return;
     }
 
     /* must loop through table and free the distincts */
-    ithash = hashlib_create_iterator(uniq->ht);
-    while (hashlib_iterate(uniq->ht, &ithash, &hash_key, &hash_val)
+    ithash = hashlib_create_iterator(ht);
+    while (hashlib_iterate(ht, &ithash, &hash_key, &hash_val)
            != ERR_NOMOREENTRIES)
     {
-        memcpy(&distincts, hash_val + uniq->fi.value_octets, sizeof(void*));
-        uniqDistinctFree(&uniq->fi, distincts);
+        memcpy(&distincts, hash_val + field_info->value_octets, sizeof(void*));
+        uniqDistinctFree(field_info, distincts);
     }
 
-    hashlib_free_table(uniq->ht);
+    hashlib_free_table(ht);
+}
+
+
+/*
+ *  uniqueDestroyHashTable(uniq);
+ *
+ *    Destroy the hashlib hash table stored on 'uniq'.
+ */
+static void
+uniqueDestroyHashTable(
+    sk_unique_t        *uniq)
+{
+    uniqueFreeHashTable(&uniq->fi, uniq->ht);
     uniq->ht = NULL;
-    return;
 }
 
 
@@ -3832,183 +4391,1182 @@ uniqueDumpHashToTemp(
 }
 
 
-/*  create a new unique object */
-int
-skUniqueCreate(
-    sk_unique_t       **uniq)
-{
-    sk_unique_t *u;
-    const char *env_value;
-    uint32_t debug_lvl;
-
-    u = (sk_unique_t*)calloc(1, sizeof(sk_unique_t));
-    if (NULL == u) {
-        *uniq = NULL;
-        return -1;
-    }
-
-    u->temp_idx = -1;
-    u->max_temp_idx = -1;
-
-    env_value = getenv(SKUNIQUE_DEBUG_ENVAR);
-    if (env_value && 0 == skStringParseUint32(&debug_lvl, env_value, 1, 0)) {
-        u->print_debug = 1;
-    }
-
-    *uniq = u;
-    return 0;
-}
-
-
-/*  destroy a unique object; cleans up any temporary files; etc. */
-void
-skUniqueDestroy(
-    sk_unique_t       **uniq)
+/*
+ *  status = uniqueInsertRecord(field_info, ht, rwrec, &insert_rv,
+ *                              &memory_error);
+ *
+ *    Add the SiLK Flow record 'rwrec' to its bin in the hash table
+ *    'ht', whose entries are described by 'field_info'.  Set
+ *    'insert_rv' to the result of inserting the key into 'ht'.
+ *
+ *    Return 0 on success.  Return 1 when memory is exhausted, after
+ *    setting a bit in 'memory_error' that describes where memory was
+ *    exhausted.  Return -1 on any other error.
+ */
+static int
+uniqueInsertRecord(
+    const sk_uniq_field_info_t *field_info,
+    HashTable                  *ht,
+    const rwRec                *rwrec,
+    int                        *insert_rv,
+    uint32_t                   *memory_error)
 {
-    sk_unique_t *u;
-
-    if (NULL == uniq || NULL == *uniq) {
-        return;
-    }
-
-    u = *uniq;
-    *uniq = NULL;
+    distinct_value_t *distincts = NULL;
+    uint8_t field_buf[HASHLIB_MAX_KEY_WIDTH];
+    uint8_t *hash_val;
 
-    if (u->temp_fp) {
-        uniqTempClose(u->temp_fp);
-        u->temp_fp = NULL;
-    }
-    if (u->dist_fp) {
-        uniqTempClose(u->dist_fp);
-        u->dist_fp = NULL;
-    }
-    uniqTotalDistinctDestroy(&u->total_dist);
-    skTempFileTeardown(&u->tmpctx);
-    u->temp_idx = -1;
-    uniqueDestroyHashTable(u);
-    free(u->temp_dir);
+    skFieldListRecToBinary(field_info->key_fields, rwrec, field_buf);
 
-    free(u);
-}
+    /* the 'insert' will set 'hash_val' to the memory to use to
+     * store the values. either fresh memory or the existing
+     * value(s). */
+    *insert_rv = hashlib_insert(ht, field_buf, &hash_val);
+    switch (*insert_rv) {
+      case OK:
+        /* new key; don't increment value until we are sure we can
+         * allocate the space for the distinct fields */
+        skFieldListInitializeBuffer(field_info->value_fields, hash_val);
+        if (field_info->distinct_num_fields) {
+            skFieldListRecToBinary(field_info->distinct_fields, rwrec,
+                                   field_buf);
+            if (uniqDistinctAlloc(field_info, &distincts)) {
+                *memory_error |= 2;
+                return 1;
+            }
+            if (uniqDistinctIncrement(field_info, distincts, field_buf)) {
+                uniqDistinctFree(field_info, distincts);
+                *memory_error |= 4;
+                return 1;
+            }
+            memcpy(hash_val + field_info->value_octets, &distincts,
+                   sizeof(void*));
+        }
+        skFieldListAddRecToBuffer(field_info->value_fields, rwrec, hash_val);
+        return 0;
 
+      case OK_DUPLICATE:
+        /* existing key; merge the distinct fields first, then
+         * merge the value */
+        if (field_info->distinct_num_fields) {
+            memcpy(&distincts, hash_val + field_info->value_octets,
+                   sizeof(void*));
+            skFieldListRecToBinary(field_info->distinct_fields, rwrec,
+                                   field_buf);
+            if (uniqDistinctIncrement(field_info, distincts, field_buf)) {
+                *memory_error |= 8;
+                return 1;
+            }
+        }
+        skFieldListAddRecToBuffer(field_info->value_fields, rwrec, hash_val);
+        return 0;
 
-/*  specify that output from 'uniq' should be sorted */
-int
-skUniqueSetSortedOutput(
-    sk_unique_t        *uniq)
-{
-    assert(uniq);
+      case ERR_OUTOFMEMORY:
+      case ERR_NOMOREBLOCKS:
+        *memory_error |= 1;
+        return 1;
 
-    if (uniq->ready_for_input) {
-        skAppPrintErr("May not call skUniqueSetSortedOutput"
-                      " after calling skUniquePrepareForInput");
+      default:
+        skAppPrintErr("Unexpected return code '%d' from hash table insert",
+                      *insert_rv);
         return -1;
     }
-    uniq->sort_output = 1;
-    return 0;
 }
 
 
-/*  specify the temporary directory. */
-void
-skUniqueSetTempDirectory(
-    sk_unique_t        *uniq,
-    const char         *temp_dir)
+/*
+ *  uniquePrintMemoryError(insert_rv);
+ *
+ *    Print an error when memory is exhausted while adding a record to
+ *    an empty hash table, where 'insert_rv' is the result of
+ *    inserting the key into that table.
+ */
+static void
+uniquePrintMemoryError(
+    int                 insert_rv)
 {
-    assert(uniq);
-
-    if (uniq->ready_for_input) {
-        skAppPrintErr("May not call skUniqueSetTempDirectory"
-                      " after calling skUniquePrepareForInput");
-        return;
-    }
-
-    if (uniq->temp_dir) {
-        free(uniq->temp_dir);
-        uniq->temp_dir = NULL;
-    }
-    if (temp_dir) {
-        uniq->temp_dir = strdup(temp_dir);
+    if (OK != insert_rv) {
+        skAppPrintErr(("Unexpected return code '%d'"
+                       " from hash table insert on new hash table"),
+                      insert_rv);
+    } else {
+        skAppPrintErr(("Error allocating memory after writing"
+                       " hash table to temporary file"));
     }
 }
 
 
-/*  set the fields that 'uniq' will use. */
-int
-skUniqueSetFields(
-    sk_unique_t            *uniq,
-    const sk_fieldlist_t   *key_fields,
-    const sk_fieldlist_t   *distinct_fields,
-    const sk_fieldlist_t   *agg_value_fields)
+#ifndef SKTHREAD_UNKNOWN_ID
+/* Create a local copy of the function from libsilk-thrd. */
+/*
+ *    Tell the current thread to ignore all signals except those
+ *    indicating a failure (e.g., SIGBUS and SIGSEGV).
+ */
+static void
+skthread_ignore_signals(
+    void)
 {
-    assert(uniq);
+    sigset_t sigs;
 
-    if (uniq->ready_for_input) {
-        skAppPrintErr("May not call skUniqueSetFields"
-                      " after calling skUniquePrepareForInput");
-        return -1;
-    }
+    sigfillset(&sigs);
+    sigdelset(&sigs, SIGABRT);
+    sigdelset(&sigs, SIGBUS);
+    sigdelset(&sigs, SIGILL);
+    sigdelset(&sigs, SIGSEGV);
 
-    memset(&uniq->fi, 0, sizeof(sk_uniq_field_info_t));
-    uniq->fi.key_fields = key_fields;
-    uniq->fi.distinct_fields = distinct_fields;
-    uniq->fi.value_fields = agg_value_fields;
+#ifdef SIGEMT
+    sigdelset(&sigs, SIGEMT);
+#endif
+#ifdef SIGIOT
+    sigdelset(&sigs, SIGIOT);
+#endif
+#ifdef SIGSYS
+    sigdelset(&sigs, SIGSYS);
+#endif
 
-    return 0;
+    pthread_sigmask(SIG_SETMASK, &sigs, NULL);
 }
+#endif  /* #ifndef SKTHREAD_UNKNOWN_ID */
 
 
-/*  count distincts across all bins for first distinct field */
-int
-skUniqueEnableTotalDistinct(
-    sk_unique_t        *uniq)
+/*
+ *  ht = uniqueCreateThreadTable(uniq);
+ *
+ *    Create a hash table for one of the threads that add records to
+ *    'uniq'.  Return the table, or NULL on failure.
+ */
+static HashTable *
+uniqueCreateThreadTable(
+    const sk_unique_t  *uniq)
 {
-    assert(uniq);
+    uint8_t no_val[HASHLIB_MAX_VALUE_WIDTH];
+    HashTable *ht;
 
-    if (uniq->ready_for_input) {
-        skAppPrintErr("May not call skUniqueEnableTotalDistinct"
-                      " after calling skUniquePrepareForInput");
-        return -1;
+    memset(no_val, 0, sizeof(no_val));
+
+    ht = hashlib_create_table(uniq->fi.key_octets,
+                              uniq->hash_value_octets,
+                              HTT_INPLACE,
+                              no_val,
+                              NULL,
+                              0,
+                              THREAD_TABLE_SIZE,
+                              DEFAULT_LOAD_FACTOR);
+    if (NULL == ht) {
+        skAppPrintOutOfMemory("hash table");
     }
-    uniq->use_total_distinct = 1;
-    return 0;
+    return ht;
 }
 
 
-/*  return the number of distincts for first distinct field across all
- *  bins */
-uint64_t
-skUniqueGetTotalDistinctCount(
-    sk_unique_t        *uniq)
+/*
+ *  part_idx = uniquePartitionOfKey(uniq, key);
+ *
+ *    Return the index of the partition of 'uniq' that holds the bin
+ *    whose key is 'key'.
+ */
+static uint32_t
+uniquePartitionOfKey(
+    const sk_unique_t  *uniq,
+    const uint8_t      *key)
 {
-    if (!uniq->ready_for_output) {
-        skAppPrintErr("May not call skUniqueGetTotalDistinctCount"
-                      " before calling skUniquePrepareForOutput");
-        return UINT64_MAX;
-    }
-    return uniqTotalDistinctGetCount(&uniq->total_dist);
+    return ((uint32_t)hash(key, uniq->fi.key_octets, PARTITION_HASH_SEED)
+            % uniq->thread_count);
 }
 
 
-/*  tell the unique object that initialization is complete.  return an
- *  error if the object is not completely specified. */
-int
-skUniquePrepareForInput(
-    sk_unique_t        *uniq)
+/*
+ *  status = uniqueMergeBin(uniq, key, value);
+ *
+ *    Merge the bin whose key is 'key' and whose values and pointer to
+ *    the distinct counters are in 'value' into the hash table on
+ *    'uniq'.  'uniq' takes ownership of the distinct counters.  When
+ *    the hash table is full, write it to a temporary file and create
+ *    an empty table.  Return 0 on success or -1 on failure.
+ */
+static int
+uniqueMergeBin(
+    sk_unique_t        *uniq,
+    const uint8_t      *key,
+    const uint8_t      *value)
 {
-    assert(uniq);
-
-    if (uniq->ready_for_input) {
-        return 0;
-    }
+    distinct_value_t *distincts;
+    distinct_value_t *src_distincts = NULL;
+    uint8_t *hash_val;
+    int dumped = 0;
+    int rv;
 
-    if (uniqCheckFields(&uniq->fi)) {
-        return -1;
+    if (uniq->fi.distinct_num_fields) {
+        memcpy(&src_distincts, value + uniq->fi.value_octets, sizeof(void*));
     }
 
-    /* initialize the total distinct object */
-    if (uniq->use_total_distinct) {
-        if (uniqTotalDistinctPrepareInput(
+    for (;;) {
+        rv = hashlib_insert(uniq->ht, key, &hash_val);
+        switch (rv) {
+          case OK:
+            /* new key; copy the value and the distinct counters.  the
+             * counters are missing when memory was exhausted while
+             * creating the bin */
+            if (uniq->fi.distinct_num_fields && NULL == src_distincts) {
+                if (uniqDistinctAlloc(&uniq->fi, &src_distincts)) {
+                    break;
+                }
+            }
+            memcpy(hash_val, value, uniq->fi.value_octets);
+            if (uniq->fi.distinct_num_fields) {
+                memcpy(hash_val + uniq->fi.value_octets, &src_distincts,
+                       sizeof(void*));
+            }
+            return 0;
+
+          case OK_DUPLICATE:
+            /* existing key; merge the distinct fields first, then
+             * merge the value */
+            if (src_distincts) {
+                memcpy(&distincts, hash_val + uniq->fi.value_octets,
+                       sizeof(void*));
+                if (NULL == distincts) {
+                    memcpy(hash_val + uniq->fi.value_octets, &src_distincts,
+                           sizeof(void*));
+                } else if (uniqDistinctMerge(&uniq->fi, distincts,
+                                             src_distincts))
+                {
+                    /* out of memory; the bin is added to an empty
+                     * table below.  the distinct values that were
+                     * merged appear in two temporary files, and that
+                     * is resolved when the files are merged */
+                    break;
+                } else {
+                    uniqDistinctFree(&uniq->fi, src_distincts);
+                }
+            }
+            skFieldListMergeBuffers(uniq->fi.value_fields, hash_val, value);
+            return 0;
+
+          case ERR_OUTOFMEMORY:
+          case ERR_NOMOREBLOCKS:
+            break;
+
+          default:
+            skAppPrintErr("Unexpected return code '%d' from hash table insert",
+                          rv);
+            return -1;
+        }
+
+        /* ran out of memory */
+        if (dumped) {
+            uniquePrintMemoryError(rv);
+            return -1;
+        }
+        dumped = 1;
+        uniqueDumpHashToTemp(uniq);
+        if (uniqueCreateHashTable(uniq)) {
+            return -1;
+        }
+    }
+
+    return 0;                   /* NOTREACHED */
+}
+
+
+/*
+ *  status = uniqueMoveToPartition(uniq, ht, part_idx, part_ids);
+ *
+ *    Merge the bins in the hash table 'ht' whose keys belong to the
+ *    partition of 'uniq' whose index is 'part_idx' into that
+ *    partition.  The partition takes ownership of the distinct
+ *    counters of each bin that is moved.  'ht' is not modified, which
+ *    allows multiple threads to move bins from 'ht' at once.
+ *
+ *    When 'part_ids' is not NULL, it holds the partition index of
+ *    each entry in 'ht' in the order the entries are visited by the
+ *    iterator; otherwise the partition of each key is computed.
+ *
+ *    The caller must ensure no other thread is using the partition.
+ *    Return 0 on success or -1 on failure.
+ */
+static int
+uniqueMoveToPartition(
+    sk_unique_t        *uniq,
+    HashTable          *ht,
+    uint32_t            part_idx,
+    const uint16_t     *part_ids)
+{
+    sk_unique_t *part_uniq = uniq->parts[part_idx].uniq;
+    uint8_t *hash_key;
+    uint8_t *hash_val;
+    HASH_ITER ithash;
+    uint32_t p;
+    uint64_t i = 0;
+
+    ithash = hashlib_create_iterator(ht);
+    while (hashlib_iterate(ht, &ithash, &hash_key, &hash_val)
+           != ERR_NOMOREENTRIES)
+    {
+        p = (part_ids ? part_ids[i++] : uniquePartitionOfKey(uniq, hash_key));
+        if (p != part_idx) {
+            continue;
+        }
+        if (uniqueMergeBin(part_uniq, hash_key, hash_val)) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+
+/*
+ *  status = uniqueFlushThreadTable(uniq, thread_id);
+ *
+ *    Merge the bins in the hash table of the thread 'thread_id' into
+ *    the partitions of 'uniq' and replace the thread's table with an
+ *    empty table.  Return 0 on success or -1 on failure.
+ */
+static int
+uniqueFlushThreadTable(
+    sk_unique_t        *uniq,
+    uint32_t            thread_id)
+{
+    HashTable *ht;
+    uint16_t *part_ids;
+    uint8_t *hash_key;
+    uint8_t *hash_val;
+    HASH_ITER ithash;
+    uint64_t count;
+    uint64_t i;
+    uint32_t p;
+    int rv = 0;
+
+    ht = uniq->thread_ht[thread_id];
+    count = hashlib_count_entries(ht);
+
+    uniqDebug(uniq, "Thread %" PRIu32 " moving %" PRIu64 " bins to partitions",
+              thread_id, count);
+
+    /* find the partition of each key once; when there is no memory
+     * for the list, the partition is computed in each pass */
+    part_ids = (uint16_t*)malloc(count * sizeof(uint16_t));
+    if (part_ids) {
+        i = 0;
+        ithash = hashlib_create_iterator(ht);
+        while (hashlib_iterate(ht, &ithash, &hash_key, &hash_val)
+               != ERR_NOMOREENTRIES)
+        {
+            assert(i < count);
+            part_ids[i++] = (uint16_t)uniquePartitionOfKey(uniq, hash_key);
+        }
+    }
+
+    /* each thread starts with a different partition to reduce the
+     * time threads wait for each other */
+    for (i = 0; i < uniq->thread_count && 0 == rv; ++i) {
+        p = (uint32_t)((thread_id + i) % uniq->thread_count);
+        pthread_mutex_lock(&uniq->parts[p].mutex);
+        rv = uniqueMoveToPartition(uniq, ht, p, part_ids);
+        pthread_mutex_unlock(&uniq->parts[p].mutex);
+    }
+    free(part_ids);
+
+    /* the partitions own the distinct counters */
+    hashlib_free_table(ht);
+    uniq->thread_ht[thread_id] = uniqueCreateThreadTable(uniq);
+    if (NULL == uniq->thread_ht[thread_id]) {
+        return -1;
+    }
+    return rv;
+}
+
+
+/*
+ *  status = uniquePrepareThreads(uniq);
+ *
+ *    Create the partitions and the per-thread hash tables used when
+ *    multiple threads add records to 'uniq'.  Return 0 on success or
+ *    -1 on failure.
+ */
+static int
+uniquePrepareThreads(
+    sk_unique_t        *uniq)
+{
+    uniq_partition_t *part;
+    uint32_t i;
+
+    assert(uniq->thread_count > 1);
+
+    uniq->parts = ((uniq_partition_t*)
+                   calloc(uniq->thread_count, sizeof(uniq_partition_t)));
+    uniq->thread_ht = (HashTable**)calloc(uniq->thread_count,
+                                          sizeof(HashTable*));
+    if (NULL == uniq->parts || NULL == uniq->thread_ht) {
+        skAppPrintOutOfMemory("partitions");
+        free(uniq->parts);
+        uniq->parts = NULL;
+        return -1;
+    }
+    pthread_mutex_init(&uniq->total_dist_mutex, NULL);
+    for (i = 0; i < uniq->thread_count; ++i) {
+        part = &uniq->parts[i];
+        part->parent = uniq;
+        part->part_idx = i;
+        part->result_idx = -1;
+        pthread_mutex_init(&part->mutex, NULL);
+    }
+
+    for (i = 0; i < uniq->thread_count; ++i) {
+        part = &uniq->parts[i];
+        if (skUniqueCreate(&part->uniq)) {
+            skAppPrintOutOfMemory("partition");
+            return -1;
+        }
+        if (uniq->sort_output) {
+            skUniqueSetSortedOutput(part->uniq);
+        }
+        skUniqueSetTempDirectory(part->uniq, uniq->temp_dir);
+        if (skUniqueSetFields(part->uniq, uniq->fi.key_fields,
+                              uniq->fi.distinct_fields, uniq->fi.value_fields)
+            || skUniquePrepareForInput(part->uniq))
+        {
+            return -1;
+        }
+        uniq->thread_ht[i] = uniqueCreateThreadTable(uniq);
+        if (NULL == uniq->thread_ht[i]) {
+            return -1;
+        }
+    }
+
+    uniqDebug(uniq, "Prepared %" PRIu32 " threads and partitions",
+              uniq->thread_count);
+    return 0;
+}
+
+
+/*
+ *  status = uniquePartitionMergeTemp(part);
+ *
+ *    Merge the temporary files written by the partition 'part' into a
+ *    single temporary file that holds the key, the value, and the
+ *    distinct counts of each bin, and remove the files that were
+ *    merged.  Return 0 on success or -1 on failure.
+ */
+static int
+uniquePartitionMergeTemp(
+    uniq_partition_t   *part)
+{
+    sk_unique_t *uniq = part->uniq;
+    sk_unique_iterator_t *iter;
+    uint8_t *key_buf;
+    uint8_t *dist_buf;
+    uint8_t *val_buf;
+    skstream_t *fp;
+    int j;
+
+    if (skUniqueIteratorCreate(uniq, &iter)) {
+        return -1;
+    }
+    fp = uniqTempCreate(uniq->tmpctx, &part->result_idx);
+    uniqDebug(uniq, "Merging partition %" PRIu32 " into #%d",
+              part->part_idx, part->result_idx);
+
+    while (skUniqueIteratorNext(iter, &key_buf, &dist_buf, &val_buf)
+           == SK_ITERATOR_OK)
+    {
+        uniqTempWrite(fp, key_buf, uniq->fi.key_octets);
+        if (uniq->fi.value_octets) {
+            uniqTempWrite(fp, val_buf, uniq->fi.value_octets);
+        }
+        if (uniq->fi.distinct_num_fields) {
+            uniqTempWrite(fp, dist_buf, uniq->fi.distinct_octets);
+        }
+    }
+    skUniqueIteratorDestroy(&iter);
+    uniqTempClose(fp);
+
+    /* the files that were merged are no longer needed */
+    for (j = 0; j < part->result_idx; ++j) {
+        skTempFileRemove(uniq->tmpctx, j);
+    }
+    return 0;
+}
+
+
+/*
+ *  uniquePartitionFinish(part);
+ *
+ *    Merge the bins that each thread's hash table holds for the
+ *    partition 'part' into the partition and prepare the partition
+ *    for output.  When the partition wrote temporary files, merge the
+ *    files into one file.  Set the 'rv' member of 'part' to 0 on
+ *    success or -1 on failure.
+ */
+static void
+uniquePartitionFinish(
+    uniq_partition_t   *part)
+{
+    sk_unique_t *uniq = part->parent;
+    uint32_t i;
+
+    part->rv = -1;
+    for (i = 0; i < uniq->thread_count; ++i) {
+        if (uniq->thread_ht[i]
+            && uniqueMoveToPartition(uniq, uniq->thread_ht[i],
+                                     part->part_idx, NULL))
+        {
+            return;
+        }
+    }
+    if (skUniquePrepareForOutput(part->uniq)) {
+        return;
+    }
+    if (part->uniq->temp_idx > 0 && uniquePartitionMergeTemp(part)) {
+        return;
+    }
+    part->rv = 0;
+}
+
+
+/*
+ *  uniquePartitionThread(&part);
+ *
+ *    THREAD ENTRY POINT.
+ *
+ *    Finish the partition 'part'.
+ */
+static void *
+uniquePartitionThread(
+    void               *v_part)
+{
+    skthread_ignore_signals();
+
+    uniquePartitionFinish((uniq_partition_t*)v_part);
+    return NULL;
+}
+
+
+/*
+ *  status = uniqueFinishPartitions(uniq);
+ *
+ *    Finish every partition of 'uniq' using a thread per partition,
+ *    and then destroy the per-thread hash tables.  Return 0 on
+ *    success or -1 on failure.
+ */
+static int
+uniqueFinishPartitions(
+    sk_unique_t        *uniq)
+{
+    uniq_partition_t *part;
+    uint32_t i;
+    int rv = 0;
+
+    uniqDebug(uniq, "Finishing %" PRIu32 " partitions", uniq->thread_count);
+
+    /* start a thread for each partition; this thread finishes the
+     * final partition and any partition whose thread could not be
+     * created */
+    for (i = 0; i + 1 < uniq->thread_count; ++i) {
+        part = &uniq->parts[i];
+        if (0 == pthread_create(&part->thread, NULL,
+                                &uniquePartitionThread, part))
+        {
+            part->started = 1;
+        }
+    }
+    for (i = 0; i < uniq->thread_count; ++i) {
+        part = &uniq->parts[i];
+        if (part->started) {
+            pthread_join(part->thread, NULL);
+            part->started = 0;
+        } else {
+            uniquePartitionFinish(part);
+        }
+        if (part->rv) {
+            rv = -1;
+        }
+    }
+
+    /* every bin has been moved to a partition, and the partitions
+     * own the distinct counters */
+    for (i = 0; i < uniq->thread_count; ++i) {
+        hashlib_free_table(uniq->thread_ht[i]);
+        uniq->thread_ht[i] = NULL;
+    }
+
+    uniqDebug(uniq, "Finished %" PRIu32 " partitions", uniq->thread_count);
+    return rv;
+}
+
+
+/*
+ *    Return a pointer to the bin at index 'm_idx' on the
+ *    uniq_maxbins_t 'm_mb', or to the value of that bin.
+ */
+#define MAXBINS_BIN(m_mb, m_idx)                                \
+    ((m_mb)->bins + (size_t)(m_idx) * (m_mb)->bin_octets)
+#define MAXBINS_VALUE(m_uniq, m_idx)                            \
+    (MAXBINS_BIN((m_uniq)->maxbins, (m_idx)) + (m_uniq)->fi.key_octets)
+#define MAXBINS_ERROR(m_mb, m_idx)                              \
+    (MAXBINS_BIN((m_mb), (m_idx)) + (m_mb)->error_offset)
+
+/* value of an unused entry in the slots of a uniq_maxbins_t */
+#define MAXBINS_EMPTY  UINT32_MAX
+
+
+/*
+ *  rank = uniqueMaxbinsRank(uniq, idx);
+ *
+ *    Return the rank of the bin 'idx': its rank value plus its
+ *    error.
+ */
+static uint64_t
+uniqueMaxbinsRank(
+    const sk_unique_t  *uniq,
+    uint32_t            idx)
+{
+    const uniq_maxbins_t *mb = uniq->maxbins;
+    const uint8_t *value;
+    uint64_t error;
+    uint64_t rank;
+    uint32_t rank32;
+
+    value = MAXBINS_VALUE(uniq, idx) + mb->rank_field->offset;
+    if (sizeof(uint32_t) == mb->rank_field->octets) {
+        memcpy(&rank32, value, sizeof(rank32));
+        rank = rank32;
+    } else {
+        memcpy(&rank, value, sizeof(rank));
+    }
+    memcpy(&error, MAXBINS_ERROR(mb, idx), sizeof(error));
+    return rank + error;
+}
+
+
+/*
+ *  cmp = uniqueMaxbinsCmp(uniq, idx_a, idx_b);
+ *
+ *    Compare the ranks of the bins 'idx_a' and 'idx_b'.
+ */
+static int
+uniqueMaxbinsCmp(
+    const sk_unique_t  *uniq,
+    uint32_t            idx_a,
+    uint32_t            idx_b)
+{
+    uint64_t rank_a = uniqueMaxbinsRank(uniq, idx_a);
+    uint64_t rank_b = uniqueMaxbinsRank(uniq, idx_b);
+
+    return ((rank_a < rank_b) ? -1 : (rank_a > rank_b));
+}
+
+
+/*
+ *  uniqueMaxbinsHeapFix(uniq, pos);
+ *
+ *    Move the bin at position 'pos' in the min-heap up or down until
+ *    the heap is ordered.
+ */
+static void
+uniqueMaxbinsHeapFix(
+    sk_unique_t        *uniq,
+    uint32_t            pos)
+{
+    uniq_maxbins_t *mb = uniq->maxbins;
+    uint32_t bin = mb->heap[pos];
+    uint32_t child;
+    uint32_t parent;
+
+    while (pos > 0) {
+        parent = (pos - 1) >> 1;
+        if (uniqueMaxbinsCmp(uniq, bin, mb->heap[parent]) >= 0) {
+            break;
+        }
+        mb->heap[pos] = mb->heap[parent];
+        mb->heap_pos[mb->heap[pos]] = pos;
+        pos = parent;
+    }
+    for (;;) {
+        child = 2 * pos + 1;
+        if (child >= mb->num_bins) {
+            break;
+        }
+        if (child + 1 < mb->num_bins
+            && uniqueMaxbinsCmp(uniq, mb->heap[child + 1], mb->heap[child]) < 0)
+        {
+            ++child;
+        }
+        if (uniqueMaxbinsCmp(uniq, mb->heap[child], bin) >= 0) {
+            break;
+        }
+        mb->heap[pos] = mb->heap[child];
+        mb->heap_pos[mb->heap[pos]] = pos;
+        pos = child;
+    }
+    mb->heap[pos] = bin;
+    mb->heap_pos[bin] = pos;
+}
+
+
+/*
+ *  uniqueMaxbinsRemoveSlot(mb, bin);
+ *
+ *    Remove the bin 'bin' from the slots of 'mb', moving back any
+ *    following entries whose probe sequence passes through the slot.
+ */
+static void
+uniqueMaxbinsRemoveSlot(
+    uniq_maxbins_t     *mb,
+    uint32_t            bin)
+{
+    uint32_t i;
+    uint32_t j;
+    uint32_t home;
+
+    for (i = mb->bin_hash[bin] & mb->slot_mask;
+         mb->slots[i] != bin;
+         i = (i + 1) & mb->slot_mask)
+        ;                       /* empty */
+
+    for (j = (i + 1) & mb->slot_mask;
+         mb->slots[j] != MAXBINS_EMPTY;
+         j = (j + 1) & mb->slot_mask)
+    {
+        /* the entry at 'j' may move to 'i' unless its home slot is
+         * cyclically in the range (i, j] */
+        home = mb->bin_hash[mb->slots[j]] & mb->slot_mask;
+        if (((j - home) & mb->slot_mask) >= ((j - i) & mb->slot_mask)) {
+            mb->slots[i] = mb->slots[j];
+            i = j;
+        }
+    }
+    mb->slots[i] = MAXBINS_EMPTY;
+}
+
+
+/*
+ *  status = uniqueMaxbinsCreate(uniq);
+ *
+ *    Allocate the bins for a unique object whose number of bins is
+ *    bounded.  Return 0 on success, or -1 on error.
+ */
+static int
+uniqueMaxbinsCreate(
+    sk_unique_t        *uniq)
+{
+    uniq_maxbins_t *mb;
+    uint32_t slot_count;
+
+    if (uniq->fi.distinct_num_fields) {
+        skAppPrintErr("May not bound the number of bins"
+                      " when computing distinct fields");
+        return -1;
+    }
+    if (uniq->use_total_distinct) {
+        skAppPrintErr("May not bound the number of bins"
+                      " when computing the total distinct count");
+        return -1;
+    }
+    if (uniq->thread_count > 1) {
+        skAppPrintErr("May not bound the number of bins"
+                      " when using multiple threads");
+        return -1;
+    }
+    if (NULL == uniq->fi.value_fields
+        || uniq->maxbins_rank->parent_list != uniq->fi.value_fields)
+    {
+        skAppPrintErr("The field that ranks the bins"
+                      " must be an aggregate value field");
+        return -1;
+    }
+    switch (uniq->maxbins_rank->id) {
+      case SK_FIELD_RECORDS:
+      case SK_FIELD_SUM_BYTES:
+      case SK_FIELD_SUM_PACKETS:
+        break;
+      default:
+        skAppPrintErr("The field that ranks the bins must be a sum of"
+                      " records, bytes, or packets");
+        return -1;
+    }
+
+    /* use a slot table that is at least twice the number of bins */
+    slot_count = 2;
+    while (slot_count < 2 * uniq->maxbins_count) {
+        slot_count <<= 1;
+    }
+
+    mb = (uniq_maxbins_t*)calloc(1, sizeof(uniq_maxbins_t));
+    if (NULL == mb) {
+        skAppPrintOutOfMemory("bounded bins");
+        return -1;
+    }
+    mb->max_bins = uniq->maxbins_count;
+    mb->rank_field = uniq->maxbins_rank;
+    mb->slot_mask = slot_count - 1;
+    mb->error_offset = uniq->fi.key_octets + uniq->fi.value_octets;
+    mb->bin_octets = mb->error_offset + sizeof(uint64_t);
+    mb->bins = (uint8_t*)malloc((size_t)mb->max_bins * mb->bin_octets);
+    mb->bin_hash = (uint32_t*)malloc(mb->max_bins * sizeof(uint32_t));
+    mb->heap = (uint32_t*)malloc(mb->max_bins * sizeof(uint32_t));
+    mb->heap_pos = (uint32_t*)malloc(mb->max_bins * sizeof(uint32_t));
+    mb->slots = (uint32_t*)malloc(slot_count * sizeof(uint32_t));
+    uniq->maxbins = mb;
+    if (!mb->bins || !mb->bin_hash || !mb->heap || !mb->heap_pos
+        || !mb->slots)
+    {
+        skAppPrintOutOfMemory("bounded bins");
+        return -1;
+    }
+    memset(mb->slots, 0xFF, slot_count * sizeof(uint32_t));
+
+    uniqDebug(uniq, "Bounding the number of bins to %" PRIu32,
+              mb->max_bins);
+    return 0;
+}
+
+
+/*
+ *  uniqueMaxbinsDestroy(uniq);
+ *
+ *    Free the bins of a unique object whose number of bins is
+ *    bounded.
+ */
+static void
+uniqueMaxbinsDestroy(
+    sk_unique_t        *uniq)
+{
+    uniq_maxbins_t *mb = uniq->maxbins;
+
+    if (NULL == mb) {
+        return;
+    }
+    free(mb->bins);
+    free(mb->bin_hash);
+    free(mb->heap);
+    free(mb->heap_pos);
+    free(mb->slots);
+    free(mb);
+    uniq->maxbins = NULL;
+}
+
+
+/*
+ *  uniqueMaxbinsAddRecord(uniq, rwrec);
+ *
+ *    Add 'rwrec' to a unique object whose number of bins is bounded.
+ */
+static void
+uniqueMaxbinsAddRecord(
+    sk_unique_t        *uniq,
+    const rwRec        *rwrec)
+{
+    uniq_maxbins_t *mb = uniq->maxbins;
+    uint8_t key[HASHLIB_MAX_KEY_WIDTH];
+    uint64_t error;
+    uint32_t h;
+    uint32_t i;
+    uint32_t bin;
+
+    skFieldListRecToBinary(uniq->fi.key_fields, rwrec, key);
+    h = (uint32_t)hash(key, uniq->fi.key_octets, PARTITION_HASH_SEED);
+
+    for (i = h & mb->slot_mask;
+         mb->slots[i] != MAXBINS_EMPTY;
+         i = (i + 1) & mb->slot_mask)
+    {
+        bin = mb->slots[i];
+        if (mb->bin_hash[bin] == h
+            && 0 == memcmp(MAXBINS_BIN(mb, bin), key, uniq->fi.key_octets))
+        {
+            skFieldListAddRecToBuffer(uniq->fi.value_fields, rwrec,
+                                      MAXBINS_VALUE(uniq, bin));
+            uniqueMaxbinsHeapFix(uniq, mb->heap_pos[bin]);
+            return;
+        }
+    }
+
+    if (mb->num_bins < mb->max_bins) {
+        /* use a new bin */
+        bin = mb->num_bins;
+        ++mb->num_bins;
+        error = 0;
+        mb->heap[bin] = bin;
+        mb->heap_pos[bin] = bin;
+    } else {
+        /* replace the bin with the smallest rank; the new key may
+         * have been counted in that bin before, so its values may be
+         * low by as much as that bin's rank */
+        bin = mb->heap[0];
+        error = uniqueMaxbinsRank(uniq, bin);
+        uniqueMaxbinsRemoveSlot(mb, bin);
+        ++mb->evictions;
+        /* the removal may have moved an entry into the probe
+         * sequence of the new key */
+        for (i = h & mb->slot_mask;
+             mb->slots[i] != MAXBINS_EMPTY;
+             i = (i + 1) & mb->slot_mask)
+            ;                   /* empty */
+    }
+    memcpy(MAXBINS_BIN(mb, bin), key, uniq->fi.key_octets);
+    skFieldListInitializeBuffer(uniq->fi.value_fields,
+                                MAXBINS_VALUE(uniq, bin));
+    memcpy(MAXBINS_ERROR(mb, bin), &error, sizeof(error));
+    mb->bin_hash[bin] = h;
+    mb->slots[i] = bin;
+    skFieldListAddRecToBuffer(uniq->fi.value_fields, rwrec,
+                              MAXBINS_VALUE(uniq, bin));
+    uniqueMaxbinsHeapFix(uniq, mb->heap_pos[bin]);
+}
+
+
+/*  create a new unique object */
+int
+skUniqueCreate(
+    sk_unique_t       **uniq)
+{
+    sk_unique_t *u;
+    const char *env_value;
+    uint32_t debug_lvl;
+
+    u = (sk_unique_t*)calloc(1, sizeof(sk_unique_t));
+    if (NULL == u) {
+        *uniq = NULL;
+        return -1;
+    }
+
+    u->temp_idx = -1;
+    u->max_temp_idx = -1;
+    u->thread_count = 1;
+
+    env_value = getenv(SKUNIQUE_DEBUG_ENVAR);
+    if (env_value && 0 == skStringParseUint32(&debug_lvl, env_value, 1, 0)) {
+        u->print_debug = 1;
+    }
+
+    *uniq = u;
+    return 0;
+}
+
+
+/*  destroy a unique object; cleans up any temporary files; etc. */
+void
+skUniqueDestroy(
+    sk_unique_t       **uniq)
+{
+    sk_unique_t *u;
+    uint32_t i;
+
+    if (NULL == uniq || NULL == *uniq) {
+        return;
+    }
+
+    u = *uniq;
+    *uniq = NULL;
+
+    if (u->temp_fp) {
+        uniqTempClose(u->temp_fp);
+        u->temp_fp = NULL;
+    }
+    if (u->dist_fp) {
+        uniqTempClose(u->dist_fp);
+        u->dist_fp = NULL;
+    }
+    uniqTotalDistinctDestroy(&u->total_dist);
+    skTempFileTeardown(&u->tmpctx);
+    u->temp_idx = -1;
+    uniqueDestroyHashTable(u);
+    uniqueMaxbinsDestroy(u);
+    if (u->parts) {
+        for (i = 0; i < u->thread_count; ++i) {
+            if (u->thread_ht) {
+                uniqueFreeHashTable(&u->fi, u->thread_ht[i]);
+            }
+            skUniqueDestroy(&u->parts[i].uniq);
+            pthread_mutex_destroy(&u->parts[i].mutex);
+        }
+        pthread_mutex_destroy(&u->total_dist_mutex);
+        free(u->parts);
+    }
+    free(u->thread_ht);
+    free(u->temp_dir);
+
+    free(u);
+}
+
+
+/*  specify that output from 'uniq' should be sorted */
+int
+skUniqueSetSortedOutput(
+    sk_unique_t        *uniq)
+{
+    assert(uniq);
+
+    if (uniq->ready_for_input) {
+        skAppPrintErr("May not call skUniqueSetSortedOutput"
+                      " after calling skUniquePrepareForInput");
+        return -1;
+    }
+    uniq->sort_output = 1;
+    return 0;
+}
+
+
+/*  specify the temporary directory. */
+void
+skUniqueSetTempDirectory(
+    sk_unique_t        *uniq,
+    const char         *temp_dir)
+{
+    assert(uniq);
+
+    if (uniq->ready_for_input) {
+        skAppPrintErr("May not call skUniqueSetTempDirectory"
+                      " after calling skUniquePrepareForInput");
+        return;
+    }
+
+    if (uniq->temp_dir) {
+        free(uniq->temp_dir);
+        uniq->temp_dir = NULL;
+    }
+    if (temp_dir) {
+        uniq->temp_dir = strdup(temp_dir);
+    }
+}
+
+
+/*  specify the number of threads that add records */
+int
+skUniqueSetThreads(
+    sk_unique_t        *uniq,
+    uint32_t            thread_count)
+{
+    assert(uniq);
+
+    if (uniq->ready_for_input) {
+        skAppPrintErr("May not call skUniqueSetThreads"
+                      " after calling skUniquePrepareForInput");
+        return -1;
+    }
+    if (0 == thread_count || thread_count > SKUNIQUE_MAX_THREADS) {
+        skAppPrintErr("Invalid thread count %" PRIu32, thread_count);
+        return -1;
+    }
+    uniq->thread_count = thread_count;
+    return 0;
+}
+
+
+/*  bound the number of bins that 'uniq' holds */
+int
+skUniqueSetMaxBins(
+    sk_unique_t            *uniq,
+    uint32_t                max_bins,
+    const sk_fieldentry_t  *rank_field)
+{
+    assert(uniq);
+
+    if (uniq->ready_for_input) {
+        skAppPrintErr("May not call skUniqueSetMaxBins"
+                      " after calling skUniquePrepareForInput");
+        return -1;
+    }
+    if (0 == max_bins || max_bins >= MAXBINS_EMPTY || NULL == rank_field) {
+        skAppPrintErr("Invalid maximum number of bins %" PRIu32, max_bins);
+        return -1;
+    }
+    uniq->maxbins_count = max_bins;
+    uniq->maxbins_rank = rank_field;
+    return 0;
+}
+
+
+/*  return the most by which bounded bins may undercount a key */
+uint64_t
+skUniqueGetMaxBinsError(
+    const sk_unique_t  *uniq)
+{
+    assert(uniq);
+
+    if (NULL == uniq->maxbins || !uniq->ready_for_output) {
+        return 0;
+    }
+    return uniq->maxbins->error_bound;
+}
+
+
+/*  set the fields that 'uniq' will use. */
+int
+skUniqueSetFields(
+    sk_unique_t            *uniq,
+    const sk_fieldlist_t   *key_fields,
+    const sk_fieldlist_t   *distinct_fields,
+    const sk_fieldlist_t   *agg_value_fields)
+{
+    assert(uniq);
+
+    if (uniq->ready_for_input) {
+        skAppPrintErr("May not call skUniqueSetFields"
+                      " after calling skUniquePrepareForInput");
+        return -1;
+    }
+
+    memset(&uniq->fi, 0, sizeof(sk_uniq_field_info_t));
+    uniq->fi.key_fields = key_fields;
+    uniq->fi.distinct_fields = distinct_fields;
+    uniq->fi.value_fields = agg_value_fields;
+
+    return 0;
+}
+
+
+/*  count distincts across all bins for first distinct field */
+int
+skUniqueEnableTotalDistinct(
+    sk_unique_t        *uniq)
+{
+    assert(uniq);
+
+    if (uniq->ready_for_input) {
+        skAppPrintErr("May not call skUniqueEnableTotalDistinct"
+                      " after calling skUniquePrepareForInput");
+        return -1;
+    }
+    uniq->use_total_distinct = 1;
+    return 0;
+}
+
+
+/*  return the number of distincts for first distinct field across all
+ *  bins */
+uint64_t
+skUniqueGetTotalDistinctCount(
+    sk_unique_t        *uniq)
+{
+    if (!uniq->ready_for_output) {
+        skAppPrintErr("May not call skUniqueGetTotalDistinctCount"
+                      " before calling skUniquePrepareForOutput");
+        return UINT64_MAX;
+    }
+    return uniqTotalDistinctGetCount(&uniq->total_dist);
+}
+
+
+/*  tell the unique object that initialization is complete.  return an
+ *  error if the object is not completely specified. */
+int
+skUniquePrepareForInput(
+    sk_unique_t        *uniq)
+{
+    assert(uniq);
+
+    if (uniq->ready_for_input) {
+        return 0;
+    }
+
+    if (uniqCheckFields(&uniq->fi)) {
+        return -1;
+    }
+
+    /* initialize the total distinct object */
+    if (uniq->use_total_distinct) {
+        if (uniqTotalDistinctPrepareInput(
                 &uniq->total_dist, &uniq->fi, uniq->temp_dir))
         {
             return -1;
@@ -4020,6 +5578,24 @@ skUniquePrepareForInput(
              (uniq->fi.value_octets
               + (uniq->fi.distinct_num_fields ? sizeof(void*) : 0)));
 
+    if (uniq->maxbins_count) {
+        /* the bins are never written to temporary files */
+        if (uniqueMaxbinsCreate(uniq)) {
+            return -1;
+        }
+        uniq->ready_for_input = 1;
+        return 0;
+    }
+
+    if (uniq->thread_count > 1) {
+        /* the partitions hold the bins and the temporary files */
+        if (uniquePrepareThreads(uniq)) {
+            return -1;
+        }
+        uniq->ready_for_input = 1;
+        return 0;
+    }
+
     /* create the hash table */
     if (uniqueCreateHashTable(uniq)) {
         return -1;
@@ -4050,115 +5626,299 @@ skUniqueAddRecord(
     sk_unique_t        *uniq,
     const rwRec        *rwrec)
 {
-    distinct_value_t *distincts = NULL;
-    uint8_t field_buf[HASHLIB_MAX_KEY_WIDTH];
-    uint8_t *hash_val;
     uint32_t memory_error = 0;
+    int insert_rv;
     int rv;
 
     assert(uniq);
-    assert(uniq->ht);
     assert(rwrec);
     assert(uniq->ready_for_input);
 
+    if (uniq->maxbins) {
+        uniqueMaxbinsAddRecord(uniq, rwrec);
+        return 0;
+    }
+    if (uniq->thread_count > 1) {
+        return skUniqueAddRecordThread(uniq, 0, rwrec);
+    }
+    assert(uniq->ht);
+
     if (uniqTotalDistinctIncrement(&uniq->total_dist, rwrec)) {
         return -1;
     }
 
     for (;;) {
-        skFieldListRecToBinary(uniq->fi.key_fields, rwrec, field_buf);
+        rv = uniqueInsertRecord(&uniq->fi, uniq->ht, rwrec,
+                                &insert_rv, &memory_error);
+        if (rv <= 0) {
+            return rv;
+        }
 
-        /* the 'insert' will set 'hash_val' to the memory to use to
-         * store the values. either fresh memory or the existing
-         * value(s). */
-        rv = hashlib_insert(uniq->ht, field_buf, &hash_val);
-        switch (rv) {
-          case OK:
-            /* new key; don't increment value until we are sure we can
-             * allocate the space for the distinct fields */
-            skFieldListInitializeBuffer(uniq->fi.value_fields, hash_val);
-            if (uniq->fi.distinct_num_fields) {
-                skFieldListRecToBinary(uniq->fi.distinct_fields, rwrec,
-                                       field_buf);
-                if (uniqDistinctAlloc(&uniq->fi, &distincts)) {
-                    memory_error |= 2;
-                    break;
-                }
-                if (uniqDistinctIncrement(&uniq->fi, distincts, field_buf)) {
-                    memory_error |= 4;
-                    break;
-                }
-                memcpy(hash_val + uniq->fi.value_octets, &distincts,
-                       sizeof(void*));
+        /* ran out of memory somewhere */
+        TRACEMSG((("%s:%d: Memory error code is %" PRIu32),
+                  __FILE__, __LINE__, memory_error));
+
+        if (memory_error > (1u << 31)) {
+            /* this is our second memory error */
+            uniquePrintMemoryError(insert_rv);
+            return -1;
+        }
+        memory_error |= (1u << 31);
+
+        /*
+         *  If (memory_error & 8) then there is a partially updated
+         *  distinct count.  This should not matter as long as we can
+         *  write the current values to disk and then reset
+         *  everything.  At worst, the distinct value for this key
+         *  will appear in two separate temporary files, but that
+         *  should be resolved then the distinct values from the two
+         *  files for this key are merged.
+         */
+
+        /* out of memory */
+        uniqueDumpHashToTemp(uniq);
+
+        /* re-create the hash table */
+        if (uniqueCreateHashTable(uniq)) {
+            return -1;
+        }
+    }
+
+    return 0;                   /* NOTREACHED */
+}
+
+
+/*  add a flow record to a unique object from one of several threads */
+int
+skUniqueAddRecordThread(
+    sk_unique_t        *uniq,
+    uint32_t            thread_id,
+    const rwRec        *rwrec)
+{
+    uint32_t memory_error = 0;
+    int insert_rv;
+    int rv;
+
+    assert(uniq);
+    assert(rwrec);
+    assert(uniq->ready_for_input);
+
+    if (uniq->thread_count <= 1) {
+        return skUniqueAddRecord(uniq, rwrec);
+    }
+    assert(thread_id < uniq->thread_count);
+    assert(uniq->thread_ht[thread_id]);
+
+    if (uniq->use_total_distinct) {
+        pthread_mutex_lock(&uniq->total_dist_mutex);
+        rv = uniqTotalDistinctIncrement(&uniq->total_dist, rwrec);
+        pthread_mutex_unlock(&uniq->total_dist_mutex);
+        if (rv) {
+            return -1;
+        }
+    }
+
+    for (;;) {
+        rv = uniqueInsertRecord(&uniq->fi, uniq->thread_ht[thread_id], rwrec,
+                                &insert_rv, &memory_error);
+        if (rv < 0) {
+            return rv;
+        }
+        if (0 == rv) {
+            /* move the bins to the partitions once the thread's table
+             * holds THREAD_TABLE_SIZE of them */
+            if (OK == insert_rv
+                && (hashlib_count_entries(uniq->thread_ht[thread_id])
+                    >= THREAD_TABLE_SIZE))
+            {
+                return uniqueFlushThreadTable(uniq, thread_id);
             }
-            skFieldListAddRecToBuffer(uniq->fi.value_fields, rwrec, hash_val);
             return 0;
+        }
 
-          case OK_DUPLICATE:
-            /* existing key; merge the distinct fields first, then
-             * merge the value */
-            if (uniq->fi.distinct_num_fields) {
-                memcpy(&distincts, hash_val + uniq->fi.value_octets,
-                       sizeof(void*));
-                skFieldListRecToBinary(uniq->fi.distinct_fields, rwrec,
-                                       field_buf);
-                if (uniqDistinctIncrement(&uniq->fi, distincts, field_buf)) {
-                    memory_error |= 8;
+        /* ran out of memory; see the comments in skUniqueAddRecord() */
+        if (memory_error > (1u << 31)) {
+            uniquePrintMemoryError(insert_rv);
+            return -1;
+        }
+        memory_error |= (1u << 31);
+
+        if (uniqueFlushThreadTable(uniq, thread_id)) {
+            return -1;
+        }
+    }
+
+    return 0;                   /* NOTREACHED */
+}
+
+
+/*
+ *    uniq_reader_t holds the state shared by the threads that read
+ *    records in skUniqueAddInputs().
+ */
+typedef struct uniq_reader_st {
+    /* the object to add the records to */
+    sk_unique_t        *uniq;
+    /* function to open the next input stream */
+    int               (*next_input)(skstream_t **);
+    /* function to read a block of records from a stream */
+    int               (*stream_read)(skstream_t *, rwRec *, size_t, size_t *);
+    /* protects 'next_input' and 'error' */
+    pthread_mutex_t     mutex;
+    /* set when any thread encounters an error */
+    int                 error;
+} uniq_reader_t;
+
+/*
+ *    uniq_reader_thread_t is the state of one of the threads in
+ *    skUniqueAddInputs().
+ */
+typedef struct uniq_reader_thread_st {
+    uniq_reader_t      *reader;
+    pthread_t           thread;
+    uint32_t            thread_id;
+    unsigned            started :1;
+} uniq_reader_thread_t;
+
+
+/*
+ *  uniqueReadInputs(reader_thread);
+ *
+ *    Get input streams from the 'next_input' function on the reader
+ *    of 'reader_thread' and add the records in each stream to the
+ *    unique object until there are no more streams or until an error
+ *    occurs in any thread.
+ */
+static void
+uniqueReadInputs(
+    uniq_reader_thread_t   *reader_thread)
+{
+    uniq_reader_t *reader = reader_thread->reader;
+    rwRec recs[UNIQUE_READ_RECS];
+    skstream_t *stream;
+    size_t count;
+    size_t i;
+    int rv;
+
+    for (;;) {
+        pthread_mutex_lock(&reader->mutex);
+        rv = (reader->error ? 1 : reader->next_input(&stream));
+        if (-1 == rv) {
+            reader->error = 1;
+        }
+        pthread_mutex_unlock(&reader->mutex);
+        if (rv) {
+            return;
+        }
+
+        do {
+            rv = reader->stream_read(stream, recs, UNIQUE_READ_RECS, &count);
+            for (i = 0; i < count; ++i) {
+                if (skUniqueAddRecordThread(reader->uniq,
+                                            reader_thread->thread_id, &recs[i]))
+                {
+                    /* stop reading; handled as an error below */
+                    rv = SKSTREAM_OK;
                     break;
                 }
             }
-            skFieldListAddRecToBuffer(uniq->fi.value_fields, rwrec, hash_val);
-            return 0;
+        } while (SKSTREAM_OK == rv && i == count);
+        if (rv != SKSTREAM_ERR_EOF) {
+            if (rv != SKSTREAM_OK) {
+                skStreamPrintLastErr(stream, rv, &skAppPrintErr);
+            }
+            skStreamDestroy(&stream);
+            pthread_mutex_lock(&reader->mutex);
+            reader->error = 1;
+            pthread_mutex_unlock(&reader->mutex);
+            return;
+        }
+        skStreamDestroy(&stream);
+    }
+}
 
-          case ERR_OUTOFMEMORY:
-          case ERR_NOMOREBLOCKS:
-            memory_error |= 1;
-            break;
 
-          default:
-            skAppPrintErr("Unexpected return code '%d' from hash table insert",
-                          rv);
-            return -1;
-        }
+/*
+ *  uniqueReaderThread(&reader_thread);
+ *
+ *    THREAD ENTRY POINT.
+ *
+ *    Read records for skUniqueAddInputs().
+ */
+static void *
+uniqueReaderThread(
+    void               *v_reader_thread)
+{
+    skthread_ignore_signals();
+
+    uniqueReadInputs((uniq_reader_thread_t*)v_reader_thread);
+    return NULL;
+}
 
-        /* ran out of memory somewhere */
-        TRACEMSG((("%s:%d: Memory error code is %" PRIu32),
-                  __FILE__, __LINE__, memory_error));
 
-        if (memory_error > (1u << 31)) {
-            /* this is our second memory error */
-            if (OK != rv) {
-                skAppPrintErr(("Unexpected return code '%d'"
-                               " from hash table insert on new hash table"),
-                              rv);
-            } else {
-                skAppPrintErr(("Error allocating memory after writing"
-                               " hash table to temporary file"));
-            }
-            return -1;
-        }
-        memory_error |= (1u << 31);
+/*  add the records from a series of streams using multiple threads */
+int
+skUniqueAddInputs(
+    sk_unique_t        *uniq,
+    int               (*next_input)(skstream_t **),
+    int               (*stream_read)(skstream_t *, rwRec *, size_t,
+                                     size_t *))
+{
+    uniq_reader_thread_t *threads;
+    uniq_reader_t reader;
+    uint32_t i;
 
-        /*
-         *  If (memory_error & 8) then there is a partially updated
-         *  distinct count.  This should not matter as long as we can
-         *  write the current values to disk and then reset
-         *  everything.  At worst, the distinct value for this key
-         *  will appear in two separate temporary files, but that
-         *  should be resolved then the distinct values from the two
-         *  files for this key are merged.
-         */
+    assert(uniq);
+    assert(next_input);
 
-        /* out of memory */
-        uniqueDumpHashToTemp(uniq);
+    if (!uniq->ready_for_input) {
+        skAppPrintErr("May not call skUniqueAddInputs"
+                      " before calling skUniquePrepareForInput");
+        return -1;
+    }
 
-        /* re-create the hash table */
-        if (uniqueCreateHashTable(uniq)) {
-            return -1;
+    memset(&reader, 0, sizeof(reader));
+    reader.uniq = uniq;
+    reader.next_input = next_input;
+    reader.stream_read = (stream_read ? stream_read : &skStreamReadRecords);
+    pthread_mutex_init(&reader.mutex, NULL);
+
+    threads = ((uniq_reader_thread_t*)
+               calloc(uniq->thread_count, sizeof(uniq_reader_thread_t)));
+    if (NULL == threads) {
+        skAppPrintOutOfMemory("reader threads");
+        pthread_mutex_destroy(&reader.mutex);
+        return -1;
+    }
+
+    /* start a thread for each thread index; this thread reads using
+     * the final index and any index whose thread could not be
+     * created */
+    for (i = 0; i < uniq->thread_count; ++i) {
+        threads[i].reader = &reader;
+        threads[i].thread_id = i;
+        if (i + 1 < uniq->thread_count
+            && 0 == pthread_create(&threads[i].thread, NULL,
+                                   &uniqueReaderThread, &threads[i]))
+        {
+            threads[i].started = 1;
+        }
+    }
+    for (i = uniq->thread_count; i > 0; ) {
+        --i;
+        if (!threads[i].started) {
+            uniqueReadInputs(&threads[i]);
+        }
+    }
+    for (i = 0; i < uniq->thread_count; ++i) {
+        if (threads[i].started) {
+            pthread_join(threads[i].thread, NULL);
         }
     }
 
-    return 0;                   /* NOTREACHED */
+    free(threads);
+    pthread_mutex_destroy(&reader.mutex);
+    return ((reader.error) ? -1 : 0);
 }
 
 
@@ -4176,7 +5936,30 @@ skUniquePrepareForOutput(
         return -1;
     }
 
-    if (uniq->temp_idx > 0) {
+    if (uniq->maxbins) {
+        uniqDebug(uniq, "Holding %" PRIu32 " bins after %" PRIu64
+                  " replacements", uniq->maxbins->num_bins,
+                  uniq->maxbins->evictions);
+        /* no bin's error exceeds the smallest rank, and a key that is
+         * not present was counted no more than that */
+        if (uniq->maxbins->evictions) {
+            uniq->maxbins->error_bound
+                = uniqueMaxbinsRank(uniq, uniq->maxbins->heap[0]);
+        }
+        if (uniq->sort_output) {
+            /* the bins begin with the key */
+            skQSort_r(uniq->maxbins->bins, uniq->maxbins->num_bins,
+                      uniq->maxbins->bin_octets,
+                      COMP_FUNC_CAST(skFieldListCompareBuffers),
+                      (void*)uniq->fi.key_fields);
+        }
+    } else if (uniq->thread_count > 1) {
+        /* merge the bins into the partitions, and prepare each
+         * partition for output */
+        if (uniqueFinishPartitions(uniq)) {
+            return -1;
+        }
+    } else if (uniq->temp_idx > 0) {
         /* dump the current/final hash entries to a file */
         uniqueDumpHashToTemp(uniq);
     } else if (uniq->sort_output) {
@@ -4289,6 +6072,98 @@ uniqIterSimpleCreate(
 
 
 
+/****************************************************************
+ * Iterator for handling a bounded number of bins
+ ***************************************************************/
+
+/*
+ *    An iterator over the bins of a unique object whose number of
+ *    bins is bounded.
+ */
+
+typedef struct uniqiter_maxbins_st {
+    sk_uniqiter_next_fn_t   next_fn;
+    sk_uniqiter_free_fn_t   free_fn;
+    sk_unique_t            *uniq;
+    uint32_t                pos;
+} uniqiter_maxbins_t;
+
+
+/*
+ *  status = uniqIterMaxbinsNext(iter, &key, &distinct, &value);
+ *
+ *    Implementation for skUniqueIteratorNext().
+ */
+static int
+uniqIterMaxbinsNext(
+    sk_unique_iterator_t           *v_iter,
+    uint8_t                       **key_fields_buffer,
+    uint8_t                UNUSED(**distinct_fields_buffer),
+    uint8_t                       **value_fields_buffer)
+{
+    uniqiter_maxbins_t *iter = (uniqiter_maxbins_t*)v_iter;
+
+    if (iter->pos >= iter->uniq->maxbins->num_bins) {
+        return SK_ITERATOR_NO_MORE_ENTRIES;
+    }
+    *key_fields_buffer = MAXBINS_BIN(iter->uniq->maxbins, iter->pos);
+    *value_fields_buffer = MAXBINS_VALUE(iter->uniq, iter->pos);
+    ++iter->pos;
+    return SK_ITERATOR_OK;
+}
+
+
+/*
+ *  uniqIterMaxbinsDestroy(&iter);
+ *
+ *    Implementation for skUniqueIteratorDestroy().
+ */
+static void
+uniqIterMaxbinsDestroy(
+    sk_unique_iterator_t  **v_iter)
+{
+    uniqiter_maxbins_t *iter;
+
+    if (v_iter && *v_iter) {
+        iter = *(uniqiter_maxbins_t**)v_iter;
+        memset(iter, 0, sizeof(uniqiter_maxbins_t));
+        free(iter);
+        *v_iter = NULL;
+    }
+}
+
+
+/*
+ *  status = uniqIterMaxbinsCreate(uniq, &iter);
+ *
+ *    Helper function for skUniqueIteratorCreate().
+ */
+static int
+uniqIterMaxbinsCreate(
+    sk_unique_t            *uniq,
+    sk_unique_iterator_t  **new_iter)
+{
+    uniqiter_maxbins_t *iter;
+
+    iter = (uniqiter_maxbins_t*)calloc(1, sizeof(uniqiter_maxbins_t));
+    if (NULL == iter) {
+        skAppPrintOutOfMemory("unique iterator");
+        return -1;
+    }
+
+    iter->uniq = uniq;
+    iter->next_fn = uniqIterMaxbinsNext;
+    iter->free_fn = uniqIterMaxbinsDestroy;
+
+    uniqDebug(iter->uniq, "Created bounded iterator; num entries = %" PRIu32,
+              iter->uniq->maxbins->num_bins);
+
+    *new_iter = (sk_unique_iterator_t*)iter;
+    return 0;
+}
+
+
+
 /****************************************************************
  * Iterator for handling distinct values in one hash table
  ***************************************************************/
@@ -5746,6 +7621,297 @@ uniqIterTempDistOpenAll(
 
 
 
+/****************************************************************
+ * Iterator for handling the partitions used by multiple threads
+ ***************************************************************/
+
+/*
+ *    When multiple threads add records, the bins are divided among
+ *    partitions by the hash of the key, so a key appears in only one
+ *    partition.  The iterator visits the partitions in turn, or, when
+ *    sorted output is requested, merge-sorts the bins of the
+ *    partitions.
+ *
+ *    A partition that did not write temporary files is visited by an
+ *    iterator over its hash table.  For a partition that wrote
+ *    temporary files, uniquePartitionMergeTemp() has merged those
+ *    files into one file, and the bins are read from that file.
+ */
+
+typedef struct uniqiter_parts_st {
+    sk_uniqiter_next_fn_t   next_fn;
+    sk_uniqiter_free_fn_t   free_fn;
+    sk_unique_t            *uniq;
+    /* when the output is sorted, a heap of partition indexes where
+     * the comparison function uses the partition's current key */
+    skheap_t               *heap;
+    /* for each partition, an iterator over its hash table, or NULL
+     * when the bins are read from 'part_fp' */
+    sk_unique_iterator_t  **part_iter;
+    /* for each partition, the file holding its merged bins */
+    skstream_t            **part_fp;
+    /* for each partition, the key, value, and distinct counts of the
+     * partition's current bin, each PART_MAX_NODE_BYTES long */
+    uint8_t                *node;
+    /* buffer used to hold the bin returned to the caller when the
+     * output is sorted */
+    uint8_t                 returned_buf[PART_MAX_NODE_BYTES];
+    /* when the output is not sorted, the partition being visited */
+    uint32_t                cur_part;
+} uniqiter_parts_t;
+
+/* return the node on 'iter' for the partition 'p' */
+#define UNIQITER_PART_NODE(m_iter, m_p)                 \
+    ((m_iter)->node + (m_p) * PART_MAX_NODE_BYTES)
+
+
+/*
+ *  found = uniqIterPartsRead(iter, p);
+ *
+ *    Read the next bin of the partition 'p' into the node for that
+ *    partition.  Return 1 if a bin was read, or 0 when the partition
+ *    has no more bins or on read error.
+ */
+static int
+uniqIterPartsRead(
+    uniqiter_parts_t   *iter,
+    uint32_t            p)
+{
+    const sk_uniq_field_info_t *fi = &iter->uniq->fi;
+    uint8_t *node = UNIQITER_PART_NODE(iter, p);
+    uint8_t *key_buf;
+    uint8_t *dist_buf;
+    uint8_t *val_buf;
+
+    if (iter->part_iter[p]) {
+        if (skUniqueIteratorNext(iter->part_iter[p],
+                                 &key_buf, &dist_buf, &val_buf)
+            != SK_ITERATOR_OK)
+        {
+            return 0;
+        }
+        memcpy(node, key_buf, fi->key_octets);
+        if (fi->value_octets) {
+            memcpy(node + fi->key_octets, val_buf, fi->value_octets);
+        }
+        if (fi->distinct_num_fields) {
+            memcpy(node + fi->key_octets + fi->value_octets, dist_buf,
+                   fi->distinct_octets);
+        }
+        return 1;
+    }
+
+    if (!uniqTempRead(iter->part_fp[p], node, fi->key_octets)) {
+        if (skStreamGetLastErrno(iter->part_fp[p])) {
+            skAppPrintErr("Cannot read from temporary file: %s",
+                          strerror(skStreamGetLastErrno(iter->part_fp[p])));
+        }
+        return 0;
+    }
+    if ((fi->value_octets
+         && !uniqTempRead(iter->part_fp[p], node + fi->key_octets,
+                          fi->value_octets))
+        || (fi->distinct_num_fields
+            && !uniqTempRead(iter->part_fp[p],
+                             node + fi->key_octets + fi->value_octets,
+                             fi->distinct_octets)))
+    {
+        skAppPrintErr("Cannot read value field from temporary file");
+        return 0;
+    }
+    return 1;
+}
+
+
+/*
+ *  status = uniqIterPartsNext(iter, &key, &distinct, &value);
+ *
+ *    Implementation for skUniqueIteratorNext() when multiple threads
+ *    added the records.
+ */
+static int
+uniqIterPartsNext(
+    sk_unique_iterator_t   *v_iter,
+    uint8_t               **key_fields_buffer,
+    uint8_t               **distinct_fields_buffer,
+    uint8_t               **value_fields_buffer)
+{
+    uniqiter_parts_t *iter = (uniqiter_parts_t*)v_iter;
+    const sk_uniq_field_info_t *fi = &iter->uniq->fi;
+    uint32_t *top_heap;
+    uint32_t lowest;
+    uint8_t *buf;
+
+    if (NULL == iter->heap) {
+        /* visit each partition in turn */
+        for (;;) {
+            if (iter->cur_part >= iter->uniq->thread_count) {
+                return SK_ITERATOR_NO_MORE_ENTRIES;
+            }
+            if (uniqIterPartsRead(iter, iter->cur_part)) {
+                break;
+            }
+            ++iter->cur_part;
+        }
+        buf = UNIQITER_PART_NODE(iter, iter->cur_part);
+    } else {
+        /* get the partition with the lowest key, copy its bin, and
+         * read the partition's next bin */
+        if (SKHEAP_OK != skHeapPeekTop(iter->heap, (skheapnode_t*)&top_heap)) {
+            return SK_ITERATOR_NO_MORE_ENTRIES;
+        }
+        lowest = *top_heap;
+        buf = iter->returned_buf;
+        memcpy(buf, UNIQITER_PART_NODE(iter, lowest), PART_MAX_NODE_BYTES);
+        if (uniqIterPartsRead(iter, lowest)) {
+            skHeapReplaceTop(iter->heap, &lowest, NULL);
+        } else {
+            skHeapExtractTop(iter->heap, NULL);
+        }
+    }
+
+    *key_fields_buffer = buf;
+    *value_fields_buffer = buf + fi->key_octets;
+    *distinct_fields_buffer = buf + fi->key_octets + fi->value_octets;
+    return SK_ITERATOR_OK;
+}
+
+
+/*
+ *  uniqIterPartsDestroy(&iter);
+ *
+ *    Implementation for skUniqueIteratorDestroy().
+ */
+static void
+uniqIterPartsDestroy(
+    sk_unique_iterator_t  **v_iter)
+{
+    uniqiter_parts_t *iter;
+    uint32_t p;
+
+    if (v_iter && *v_iter) {
+        iter = *(uniqiter_parts_t**)v_iter;
+        for (p = 0; p < iter->uniq->thread_count; ++p) {
+            if (iter->part_iter) {
+                skUniqueIteratorDestroy(&iter->part_iter[p]);
+            }
+            if (iter->part_fp) {
+                uniqTempClose(iter->part_fp[p]);
+            }
+        }
+        skHeapFree(iter->heap);
+        free(iter->part_iter);
+        free(iter->part_fp);
+        free(iter->node);
+        free(iter);
+        *v_iter = NULL;
+    }
+}
+
+
+/*
+ *  status = uniqIterPartsKeyCmp(b, a, v_iter);
+ *
+ *    Comparison callback function used by the heap.  The values in
+ *    'b' and 'a' are partition indexes, and the function compares the
+ *    keys of the current bins of those partitions.
+ *
+ *    Note the order of arguments is 'b', 'a'.
+ */
+static int
+uniqIterPartsKeyCmp(
+    const skheapnode_t  b,
+    const skheapnode_t  a,
+    void               *v_iter)
+{
+    uniqiter_parts_t *iter = (uniqiter_parts_t *)v_iter;
+
+    return skFieldListCompareBuffers(
+        UNIQITER_PART_NODE(iter, *(uint32_t*)a),
+        UNIQITER_PART_NODE(iter, *(uint32_t*)b),
+        iter->uniq->fi.key_fields);
+}
+
+
+/*
+ *  status = uniqIterPartsCreate(uniq, &iter);
+ *
+ *    Helper function for skUniqueIteratorCreate().
+ */
+static int
+uniqIterPartsCreate(
+    sk_unique_t            *uniq,
+    sk_unique_iterator_t  **new_iter)
+{
+    uniqiter_parts_t *iter;
+    uniq_partition_t *part;
+    uint32_t p;
+
+    assert(uniq);
+    assert(uniq->thread_count > 1);
+
+    iter = (uniqiter_parts_t*)calloc(1, sizeof(uniqiter_parts_t));
+    if (NULL == iter) {
+        skAppPrintOutOfMemory("unique iterator");
+        return -1;
+    }
+    iter->uniq = uniq;
+    iter->next_fn = uniqIterPartsNext;
+    iter->free_fn = uniqIterPartsDestroy;
+
+    iter->part_iter = ((sk_unique_iterator_t**)
+                       calloc(uniq->thread_count,
+                              sizeof(sk_unique_iterator_t*)));
+    iter->part_fp = (skstream_t**)calloc(uniq->thread_count,
+                                         sizeof(skstream_t*));
+    iter->node = (uint8_t*)calloc(uniq->thread_count, PART_MAX_NODE_BYTES);
+    if (NULL == iter->part_iter || NULL == iter->part_fp
+        || NULL == iter->node)
+    {
+        skAppPrintOutOfMemory("unique iterator");
+        goto ERROR;
+    }
+    if (uniq->sort_output) {
+        iter->heap = skHeapCreate2(uniqIterPartsKeyCmp, uniq->thread_count,
+                                   sizeof(uint32_t), NULL, iter);
+        if (NULL == iter->heap) {
+            skAppPrintOutOfMemory("unique iterator");
+            goto ERROR;
+        }
+    }
+
+    for (p = 0; p < uniq->thread_count; ++p) {
+        part = &uniq->parts[p];
+        if (part->result_idx >= 0) {
+            iter->part_fp[p] = uniqTempReopen(part->uniq->tmpctx,
+                                              part->result_idx);
+            if (NULL == iter->part_fp[p]) {
+                skAppPrintErr("Unable to open temporary file '%s'",
+                              skTempFileGetName(part->uniq->tmpctx,
+                                                part->result_idx));
+                goto ERROR;
+            }
+        } else if (skUniqueIteratorCreate(part->uniq, &iter->part_iter[p])) {
+            goto ERROR;
+        }
+        if (iter->heap && uniqIterPartsRead(iter, p)) {
+            skHeapInsert(iter->heap, &p);
+        }
+    }
+
+    uniqDebug(uniq, "Created partition iterator; num partitions = %" PRIu32,
+              uniq->thread_count);
+
+    *new_iter = (sk_unique_iterator_t*)iter;
+    return 0;
+
+  ERROR:
+    uniqIterPartsDestroy((sk_unique_iterator_t**)&iter);
+    skAppPrintErr("Error creating unique iterator");
+    return -1;
+}
+
+
 /****************************************************************
  * Public Interface for Iterating over the bins
  ***************************************************************/
@@ -5764,6 +7930,12 @@ skUniqueIteratorCreate(
                       " before calling skUniquePrepareForOutput");
         return -1;
     }
+    if (uniq->maxbins) {
+        return uniqIterMaxbinsCreate(uniq, new_iter);
+    }
+    if (uniq->thread_count > 1) {
+        return uniqIterPartsCreate(uniq, new_iter);
+    }
     if (uniq->temp_idx > 0) {
         if (uniq->fi.distinct_num_fields) {
             return uniqIterTempDistCreate(uniq, new_iter);
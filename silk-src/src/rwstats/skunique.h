@@ -176,6 +176,51 @@ skFieldListAddKnownField(
     int                 field_id,
     void               *ctx);
 
+/*
+ *    The smallest and largest precision that may be given to
+ *    skFieldListAddApproxDistinctField().
+ */
+#define SK_FIELD_APPROX_DISTINCT_MIN_PRECISION  4
+#define SK_FIELD_APPROX_DISTINCT_MAX_PRECISION  8
+
+/*
+ *  entry = skFieldListAddApproxDistinctField(field_list, distinct_id,
+ *                                            precision, ctx);
+ *
+ *    Add to 'field_list' an aggregate value field that estimates the
+ *    number of distinct values of the known field 'distinct_id'.
+ *    'ctx' is a user-defined context.  Return NULL if 'precision' is
+ *    not between SK_FIELD_APPROX_DISTINCT_MIN_PRECISION and
+ *    SK_FIELD_APPROX_DISTINCT_MAX_PRECISION or if the field cannot be
+ *    added.
+ *
+ *    The field holds a HyperLogLog sketch of 2^'precision' registers
+ *    of 5 bits each, so its size is fixed regardless of the number of
+ *    distinct values.  The relative standard error of the estimate
+ *    is about 1.04/sqrt(2^'precision').  Unlike a distinct field,
+ *    the sketch is merged as any other aggregate value, and it does
+ *    not require the bins to be sorted or held in memory.  Use
+ *    skFieldListEntryGetApproxDistinctCount() to get the estimate.
+ */
+sk_fieldentry_t *
+skFieldListAddApproxDistinctField(
+    sk_fieldlist_t     *field_list,
+    int                 distinct_id,
+    uint8_t             precision,
+    void               *ctx);
+
+/*
+ *  precision = skFieldListApproxDistinctPrecision(error_percent);
+ *
+ *    Return the smallest precision for skFieldListAddApproxDistinctField()
+ *    whose relative standard error is no greater than
+ *    'error_percent' percent.  Return 0 if no precision provides that
+ *    error.
+ */
+uint8_t
+skFieldListApproxDistinctPrecision(
+    double              error_percent);
+
 /*
  *  count = skFieldListGetFieldCount(field_list);
  *
@@ -309,6 +354,29 @@ size_t
 skFieldListEntryGetBinOctets(
     const sk_fieldentry_t  *field);
 
+/*
+ *  count = skFieldListEntryGetApproxDistinctCount(field, field_buf);
+ *
+ *    Return the estimated number of distinct values held by the
+ *    buffer 'field_buf' for the field 'field', which must have been
+ *    created by skFieldListAddApproxDistinctField().
+ */
+uint64_t
+skFieldListEntryGetApproxDistinctCount(
+    const sk_fieldentry_t  *field,
+    const uint8_t          *field_buffer);
+
+/*
+ *  field_id = skFieldListEntryGetApproxDistinctId(field);
+ *
+ *    Return the sk_fieldid_t of the field whose distinct values are
+ *    estimated by 'field', which must have been created by
+ *    skFieldListAddApproxDistinctField().
+ */
+uint32_t
+skFieldListEntryGetApproxDistinctId(
+    const sk_fieldentry_t  *field);
+
 /*
  *  skFieldListExtractFromBuffer(field_list,all_fields_buf,field,one_field_buf);
  *
@@ -519,6 +587,7 @@ typedef enum sk_fieldid_en {
     SK_FIELD_SUM_ELAPSED,       /* 32 */
     SK_FIELD_MIN_STARTTIME,
     SK_FIELD_MAX_ENDTIME,
+    SK_FIELD_APPROX_DISTINCT,
     SK_FIELD_CALLER
 } sk_fieldid_t;
 
@@ -562,6 +631,8 @@ typedef enum sk_fieldid_en {
  *      skUniqueSetFields(u, key, distinct, value);
  *      skUniqueSetTempDirectory(u);  //optional
  *      skUniqueSetSortedOutput(u);   //optional
+ *      skUniqueSetThreads(u, n);     //optional
+ *      skUniqueSetMaxBins(u, n, f);  //optional
  *      skUniquePrepareForInput(u);
  *      foreach (input_file) {
  *          skStreamOpenSilkFlow(stream, input_file[i]);
@@ -579,6 +650,12 @@ typedef enum sk_fieldid_en {
  */
 typedef struct sk_unique_st sk_unique_t;
 
+/*
+ *    The maximum number of threads that may add records to an
+ *    sk_unique_t.  See skUniqueSetThreads().
+ */
+#define SKUNIQUE_MAX_THREADS  256
+
 /*
  *    The sk_unique_iterator_t structure supports iterating over the
  *    bins once records have been added.  The internal structure of
@@ -634,6 +711,76 @@ skUniqueSetTempDirectory(
     sk_unique_t        *uniq,
     const char         *temp_dir);
 
+/*
+ *  ok = skUniqueSetThreads(uniq, thread_count);
+ *
+ *    Specify that 'thread_count' threads will add records to the
+ *    unique object 'uniq' by calling skUniqueAddRecordThread().
+ *    Return -1 if this function is called after
+ *    skUniquePrepareForInput() or if 'thread_count' is 0 or greater
+ *    than SKUNIQUE_MAX_THREADS.
+ *
+ *    When 'thread_count' is greater than 1, each thread bins its
+ *    records in its own hash table.  When that table is full, its
+ *    bins are merged into one of 'thread_count' partitions, where the
+ *    partition is chosen by a hash of the key.  Each partition writes
+ *    its bins to temporary files when it fills.  The partitions are
+ *    merged concurrently by skUniquePrepareForOutput().
+ *
+ *    The caller must ensure that the functions on the field lists are
+ *    safe to call from multiple threads.
+ */
+int
+skUniqueSetThreads(
+    sk_unique_t        *uniq,
+    uint32_t            thread_count);
+
+/*
+ *  ok = skUniqueSetMaxBins(uniq, max_bins, rank_field);
+ *
+ *    Specify that the unique object 'uniq' should hold no more than
+ *    'max_bins' bins, where the bins are ranked by the aggregate
+ *    value field 'rank_field'.  Return -1 if this function is called
+ *    after skUniquePrepareForInput() or if 'max_bins' is 0.
+ *
+ *    The bins are maintained with the Space-Saving algorithm: when
+ *    all bins are in use and a record has a key that is not present,
+ *    the bin having the smallest rank is given the new key, its
+ *    values are reset, and the record is added to them.  The rank of
+ *    the replaced bin becomes the error of the new bin, and bins are
+ *    ranked by their 'rank_field' value plus their error.  The values
+ *    of every bin are therefore lower bounds, and a key's true rank
+ *    value exceeds its bin's value by no more than the bin's error.
+ *    Any key whose rank exceeds 1/'max_bins' of the total rank is
+ *    guaranteed to be present.  See skUniqueGetMaxBinsError().
+ *
+ *    The bins use a fixed amount of memory and are never written to
+ *    temporary files.  skUniquePrepareForInput() returns an error
+ *    when distinct fields are specified, when the total distinct
+ *    count is enabled, when more than one thread is specified, or
+ *    when 'rank_field' is not a member of the value fields that sums
+ *    the records, bytes, or packets.
+ */
+int
+skUniqueSetMaxBins(
+    sk_unique_t            *uniq,
+    uint32_t                max_bins,
+    const sk_fieldentry_t  *rank_field);
+
+/*
+ *  error = skUniqueGetMaxBinsError(uniq);
+ *
+ *    Return the largest amount by which the rank value of a key may
+ *    exceed the value reported by a unique object whose number of
+ *    bins was bounded by skUniqueSetMaxBins().  This also bounds the
+ *    rank value of any key that is not reported.  Return 0 when no
+ *    bin was ever replaced, when the bins are not bounded, or when
+ *    skUniquePrepareForOutput() has not been called.
+ */
+uint64_t
+skUniqueGetMaxBinsError(
+    const sk_unique_t  *uniq);
+
 /*
  *  ok = skUniqueSetFields(uniq, keys, distincts, values);
  *
@@ -750,6 +897,55 @@ skUniqueAddRecord(
     sk_unique_t        *uniq,
     const rwRec        *rwrec);
 
+/*
+ *  ok = skUniqueAddRecordThread(uniq, thread_id, rwrec);
+ *
+ *    Add the SiLK Flow record 'rwrec' to the unique object 'uniq' on
+ *    behalf of the thread whose index is 'thread_id', which must be
+ *    less than the count given to skUniqueSetThreads().  Multiple
+ *    threads may call this function at the same time as long as each
+ *    uses a different 'thread_id'.
+ *
+ *    When skUniqueSetThreads() has not been called, this function is
+ *    identical to skUniqueAddRecord().  The return values are the
+ *    same as those of skUniqueAddRecord().
+ */
+int
+skUniqueAddRecordThread(
+    sk_unique_t        *uniq,
+    uint32_t            thread_id,
+    const rwRec        *rwrec);
+
+/*
+ *  ok = skUniqueAddInputs(uniq, next_input_fn, stream_read_fn);
+ *
+ *    Add the records from a series of input streams to the unique
+ *    object 'uniq' using the number of threads given to
+ *    skUniqueSetThreads().  This function should only be called after
+ *    a call to skUniquePrepareForInput().
+ *
+ *    Each thread calls 'next_input_fn' to get an open stream, reads
+ *    its records, and destroys the stream.  Only one thread calls
+ *    'next_input_fn' at a time.  'next_input_fn' must return 0 when
+ *    it opens a stream, 1 when there are no more inputs, and -1 on
+ *    error.
+ *
+ *    Blocks of records are read by calling 'stream_read_fn', which
+ *    has the same signature and return values as
+ *    skStreamReadRecords().  When 'stream_read_fn' is NULL,
+ *    skStreamReadRecords() is used.
+ *
+ *    Return 0 on success.  Return -1 when 'next_input_fn' returns -1,
+ *    when a stream cannot be read, or when skUniqueAddRecordThread()
+ *    returns an error.
+ */
+int
+skUniqueAddInputs(
+    sk_unique_t        *uniq,
+    int               (*next_input_fn)(skstream_t **),
+    int               (*stream_read_fn)(skstream_t *, rwRec *, size_t,
+                                        size_t *));
+
 /*
  *  count = skUniqueGetTotalDistinctCount(uniq);
  *
@@ -0,0 +1,14 @@
+#! /usr/bin/perl -w
+# MD5: 1ae41a0e6a002669d74341b842b076c7
+# TEST: ./rwstats --fields=dport --values=sip-distinct,bytes --count=10 --approximate-distinct ../../tests/data.rwf
+
+use strict;
+use SiLKTests;
+
+my $rwstats = check_silk_app('rwstats');
+my %file;
+$file{data} = get_data_or_exit77('data');
+my $cmd = "$rwstats --fields=dport --values=sip-distinct,bytes --count=10 --approximate-distinct $file{data}";
+my $md5 = "1ae41a0e6a002669d74341b842b076c7";
+
+check_md5_output($md5, $cmd);
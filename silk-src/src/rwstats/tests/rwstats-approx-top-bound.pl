@@ -0,0 +1,88 @@
+#! /usr/bin/perl -w
+#
+#
+# RCSIDENT("$SiLK: rwstats-approx-top-bound.pl $")
+#
+#  Compare the output of --approximate-top with the exact values given
+#  by rwuniq.  Every value printed must be a lower bound on the exact
+#  value, and the exact value may exceed it by no more than the error
+#  that rwstats reports.
+
+use strict;
+use SiLKTests;
+
+my $NAME = $0;
+$NAME =~ s,.*/,,;
+
+my $rwstats = check_silk_app('rwstats');
+my $rwuniq = check_silk_app('rwuniq');
+my %file;
+$file{data} = get_data_or_exit77('data');
+
+my $format = "--no-titles --delimited=, --no-final-delimiter";
+
+for my $test (['sip', 'bytes', 20, '0.5'],
+              ['dport', 'bytes', 10, '5'],
+              ['sip,dip', 'records', 20, '0.2'])
+{
+    my ($fields, $value, $count, $percent) = @$test;
+
+    # the exact values of every key
+    my %exact;
+    my $cmd = "$rwuniq --fields=$fields --values=$value $format"
+        ." $file{data}";
+    run_command($cmd, sub {
+        my ($io) = @_;
+        while (<$io>) {
+            chomp;
+            my @f = split /,/;
+            my $v = pop @f;
+            $exact{join ",", @f} = $v;
+        }
+    });
+    die "$NAME: No output from '$cmd'\n" unless %exact;
+
+    # the approximate top values and the reported error
+    my $error = 0;
+    my @rows;
+    $cmd = "$rwstats --fields=$fields --values=$value --count=$count"
+        ." --approximate-top=$percent --no-percents $format $file{data}"
+        ." 2>&1";
+    run_command($cmd, sub {
+        my ($io) = @_;
+        while (<$io>) {
+            chomp;
+            if (/low by as much as (\d+)/) {
+                $error = $1;
+                next;
+            }
+            my @f = split /,/;
+            my $v = pop @f;
+            push @rows, [join(",", @f), $v];
+        }
+    });
+    die "$NAME: Expected $count rows from '$cmd'\n"
+        unless $count == @rows;
+
+    for my $r (@rows) {
+        my ($key, $v) = @$r;
+        die "$NAME: Key $key from '$cmd' is not in the data\n"
+            unless defined $exact{$key};
+        die("$NAME: Value $v for key $key is not within $error below"
+            ." the exact value $exact{$key}\n")
+            unless ($v <= $exact{$key} && $exact{$key} <= $v + $error);
+    }
+
+    # a key that is missing from the approximate output cannot exceed
+    # the smallest value printed by more than the error
+    my $smallest = $rows[-1][1];
+    my %seen = map { $_->[0] => 1 } @rows;
+    for my $key (keys %exact) {
+        next if $seen{$key};
+        die("$NAME: Missing key $key has exact value $exact{$key} which"
+            ." is more than $error above $smallest\n")
+            if $exact{$key} > $smallest + $error;
+    }
+}
+
+exit 0;
@@ -0,0 +1,14 @@
+#! /usr/bin/perl -w
+# MD5: 23b6d75953b2645dbd2b17a443a4b16b
+# TEST: ./rwstats --fields=sip --values=bytes,records --count=20 --approximate-top=0.5 ../../tests/data.rwf
+
+use strict;
+use SiLKTests;
+
+my $rwstats = check_silk_app('rwstats');
+my %file;
+$file{data} = get_data_or_exit77('data');
+my $cmd = "$rwstats --fields=sip --values=bytes,records --count=20 --approximate-top=0.5 $file{data}";
+my $md5 = "23b6d75953b2645dbd2b17a443a4b16b";
+
+check_md5_output($md5, $cmd);
@@ -0,0 +1,17 @@
+#! /usr/bin/perl -w
+# MD5: a2ca07b256f1dd2e101089c1dabd89f9
+# TEST: ./rwstats --fields=dport --values=bytes,sip-distinct --count=20 --top --threads=4 ../../tests/data.rwf ../../tests/data-v6.rwf ../../tests/empty.rwf ../../tests/data.rwf
+
+use strict;
+use SiLKTests;
+
+my $rwstats = check_silk_app('rwstats');
+my %file;
+$file{data} = get_data_or_exit77('data');
+$file{v6data} = get_data_or_exit77('v6data');
+$file{empty} = get_data_or_exit77('empty');
+check_features(qw(ipv6));
+my $cmd = "$rwstats --fields=dport --values=bytes,sip-distinct --count=20 --top --threads=4 $file{data} $file{v6data} $file{empty} $file{data}";
+my $md5 = "a2ca07b256f1dd2e101089c1dabd89f9";
+
+check_md5_output($md5, $cmd);
@@ -0,0 +1,14 @@
+#! /usr/bin/perl -w
+# MD5: b3d6b995e4021c6987b2a7d39ff31762
+# TEST: ./rwuniq --fields=dport --values=distinct:sip,records --approximate-distinct=10 --sort-output ../../tests/data.rwf
+
+use strict;
+use SiLKTests;
+
+my $rwuniq = check_silk_app('rwuniq');
+my %file;
+$file{data} = get_data_or_exit77('data');
+my $cmd = "$rwuniq --fields=dport --values=distinct:sip,records --approximate-distinct=10 --sort-output $file{data}";
+my $md5 = "b3d6b995e4021c6987b2a7d39ff31762";
+
+check_md5_output($md5, $cmd);
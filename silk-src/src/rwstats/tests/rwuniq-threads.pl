@@ -0,0 +1,17 @@
+#! /usr/bin/perl -w
+# MD5: 312debb3ee5a67b9c084b76251f07faf
+# TEST: ./rwuniq --fields=sip,sport --values=bytes,dip-distinct --sort-output --threads=4 ../../tests/data.rwf ../../tests/data-v6.rwf ../../tests/empty.rwf ../../tests/data.rwf
+
+use strict;
+use SiLKTests;
+
+my $rwuniq = check_silk_app('rwuniq');
+my %file;
+$file{data} = get_data_or_exit77('data');
+$file{v6data} = get_data_or_exit77('v6data');
+$file{empty} = get_data_or_exit77('empty');
+check_features(qw(ipv6));
+my $cmd = "$rwuniq --fields=sip,sport --values=bytes,dip-distinct --sort-output --threads=4 $file{data} $file{v6data} $file{empty} $file{data}";
+my $md5 = "312debb3ee5a67b9c084b76251f07faf";
+
+check_md5_output($md5, $cmd);
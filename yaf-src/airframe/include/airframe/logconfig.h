@@ -119,6 +119,18 @@ gboolean logc_setup(
     GError          **err);
 
 
+/**
+ * Check whether messages at a log level are routed by logconfig. Call this
+ * after logc_setup().
+ *
+ * @param level a glib log level, such as G_LOG_LEVEL_DEBUG
+ * @return TRUE if messages at level are logged, FALSE otherwise.
+ */
+
+gboolean logc_level_enabled(
+    GLogLevelFlags  level);
+
+
 void logc_set(
     char * spec,
     char * level);
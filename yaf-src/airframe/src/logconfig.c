@@ -77,9 +77,11 @@ typedef struct logc_st {
     gboolean        opt_verbose;
     /* Logging sockets */
     GIOChannel      *logfile;
+    /* Levels routed by logc_setup() */
+    GLogLevelFlags  levels;
 } logc_t;
 
-static logc_t logc = { "", "", NULL, NULL, FALSE, FALSE, NULL };
+static logc_t logc = { "", "", NULL, NULL, FALSE, FALSE, NULL, 0 };
 
 AirOptionEntry logc_optentries[] = {
     AF_OPTION( "log", 'l', 0, AF_OPT_TYPE_STRING, &(logc.logspec),
@@ -498,5 +500,13 @@ gboolean logc_setup(
 #endif
     g_message("%s starting", logc.appname);
 
+    logc.levels = levels;
+
     return TRUE;
 }
+
+gboolean logc_level_enabled(
+    GLogLevelFlags  level)
+{
+    return (logc.levels & level) ? TRUE : FALSE;
+}
@@ -61,6 +61,12 @@
 #define _YAF_RING_H_
 #include <yaf/autoinc.h>
 
+/* the blocking calls for sharing a ring between two threads are built
+ * whenever pthreads are available */
+#if defined(HAVE_LIBPTHREAD) && !defined(YAF_RING_THREAD)
+#define YAF_RING_THREAD 1
+#endif
+
 struct rgaRing_st;
 typedef struct rgaRing_st rgaRing_t;
 
@@ -80,6 +86,10 @@ void rgaRewindHead(
 uint8_t *rgaNextTail(
     rgaRing_t       *ring);
 
+uint8_t *rgaPeekTail(
+    rgaRing_t       *ring,
+    size_t          off);
+
 size_t rgaCount(
     rgaRing_t       *ring);
 
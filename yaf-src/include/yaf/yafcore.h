@@ -281,6 +281,8 @@ typedef struct yfFlowVal_st {
 #   if YAF_ENABLE_PAYLOAD
     /** Payload length */
     uint32_t    paylen;
+    /** Size of the captured payload buffer */
+    uint32_t    paycap;
     /** Captured payload buffer */
     uint8_t     *payload;
     /** Offsets into the payload on packet boundaries */
@@ -337,8 +339,8 @@ typedef struct yfFlowVal_st {
 
 #if YAF_MPLS
 typedef struct yfMPLSNode_st {
-    /** Flow Key Hash Tables */
-    GHashTable       *tab;
+    /** Flow Key Hash Table (private to yaftab.c) */
+    struct yfFlowHash_st *tab;
     /** TOP 3 MPLS Labels */
     uint32_t         mpls_label[YAF_MAX_MPLS_LABELS];
     /** number of mpls nodes hash table */
@@ -94,6 +94,10 @@
  *
  * ypFreeLists - called by yfWriteFlow()
  *
+ * The plugin may also implement:
+ *
+ * ypDumpStats - called by yfHookDumpStats() when yaf shuts down
+ *
  *
  */
 
@@ -363,4 +367,13 @@ uint8_t yfHookGetTemplateCount(
 void yfHookFreeLists(
     yfFlow_t *flow);
 
+/**
+ * Gives each plugin that implements ypDumpStats a chance to log its
+ * statistics at shutdown.
+ *
+ * @param yfctx the plugin configuration contexts passed to yfHookAddNewHook
+ */
+void yfHookDumpStats(
+    void **yfctx);
+
 #endif
@@ -131,6 +131,9 @@ struct yfFlowTab_st;
  */
 typedef struct yfFlowTab_st yfFlowTab_t;
 
+/** A payload inspection thread pool; see yfFlowTabSetInspect(). */
+struct yfInspect_st;
+
 /**
  *yfFlowTabAlloc
  *
@@ -274,6 +277,39 @@ void yfGetFlowTabStats(
     uint32_t *peak,
     uint32_t *flush);
 
+/**
+ * yfSetFlowTabStats
+ * Replace the Flow Table Stats reported for Export; used to report the
+ * totals of several flow tables through one of them.
+ *
+ * @param flowtab
+ * @param packets number of packets processed
+ * @param flows number of flows created
+ * @param rej_pkts number of packets rejected due to out of sequence
+ * @param peak maximum number of flows in the flow table at any 1 time
+ * @param flush number of flush events called on flow table
+ */
+void yfSetFlowTabStats(
+    yfFlowTab_t *flowtab,
+    uint64_t packets,
+    uint64_t flows,
+    uint64_t rej_pkts,
+    uint32_t peak,
+    uint32_t flush);
+
+/**
+ * yfFlowTabAddStats
+ * Add the Flow Table Stats of one flow table to those of another; used to
+ * total the stats of several flow tables once they are no longer in use.
+ * Peak flow table sizes are summed.
+ *
+ * @param flowtab flow table to add stats to
+ * @param from flow table to take stats from
+ */
+void yfFlowTabAddStats(
+    yfFlowTab_t *flowtab,
+    yfFlowTab_t *from);
+
 /**
  * Add a decoded packet buffer to a given flow table. Adds the packet to
  * the flow to which it belongs, creating a new flow if necessary. Causes
@@ -291,6 +327,20 @@ void yfFlowPBuf(
     size_t                      pbuflen,
     yfPBuf_t                    *pbuf);
 
+/**
+ * Hint that a packet buffer will be passed to yfFlowPBuf() shortly.
+ * Starts loading the part of the flow table the packet will look at;
+ * calling this a few packets ahead hides most of the cache misses of
+ * the flow table lookup.  Has no other effect on the flow table.
+ *
+ * @param flowtab   flow table the packet will be added to
+ * @param pbuf      packet buffer containing decoded packet
+ */
+
+void yfFlowPBufPrefetch(
+    yfFlowTab_t                 *flowtab,
+    yfPBuf_t                    *pbuf);
+
 /**
  * Flush closed flows in the given flow table to the given IPFIX Message
  * Buffer. Causes any idle flows to time out, removing them from the active
@@ -320,6 +370,48 @@ gboolean yfFlowTabFlush(
 uint64_t yfFlowTabCurrentTime(
     yfFlowTab_t     *flowtab);
 
+/**
+ * Move the packet clock of a flow table forward without adding a packet,
+ * so that its idle flows time out at the next flush even when it is not
+ * receiving packets. Does nothing if ctime is not ahead of the clock.
+ *
+ * @param flowtab a flow table
+ * @param ctime   packet time to advance the clock to, in epoch milliseconds
+ */
+
+void yfFlowTabAdvanceTime(
+    yfFlowTab_t     *flowtab,
+    uint64_t        ctime);
+
+/**
+ * Hand the payload inspection of closed flows (application labeling,
+ * entropy, and the flow close hooks) to a pool of inspection threads
+ * instead of doing it as each flow is closed. Closed flows are written
+ * only once they have been inspected. Must be set before any packets are
+ * added; the pool must outlive the flow table.
+ *
+ * @param flowtab a flow table
+ * @param inspect inspection thread pool (see yafinspect.h), or NULL
+ */
+
+void yfFlowTabSetInspect(
+    yfFlowTab_t         *flowtab,
+    struct yfInspect_st *inspect);
+
+/**
+ * Get a hash of the flow key of a decoded packet that does not depend on
+ * the direction of the packet; both directions of a flow hash to the same
+ * value. The high-order bits are used to pick a flow table when packets
+ * are spread across several; use them in preference to the low-order bits,
+ * which the flow table itself uses.
+ *
+ * @param pbuf      packet buffer containing decoded packet
+ * @return direction-independent hash of the packet's flow key
+ */
+
+uint32_t yfFlowPBufHash(
+    yfPBuf_t                    *pbuf);
+
 /**
  * Print flow table statistics to the log.
  *
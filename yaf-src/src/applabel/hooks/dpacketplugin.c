@@ -1037,6 +1037,13 @@ gboolean ypInitializeProtocolRules(
                     newExtra = pcre_study(newRule, 0, &errorString);
                     ctx->ruleSet[rulePos].regexFields[ctx->ruleSet[rulePos].numRules].rule = newRule;
                     ctx->ruleSet[rulePos].regexFields[ctx->ruleSet[rulePos].numRules].extra = newExtra;
+                    if (NULL == ctx->ruleSet[rulePos].prefilter) {
+                        ctx->ruleSet[rulePos].prefilter =
+                            ycPrefilterAlloc(MAX_PAYLOAD_RULES);
+                    }
+                    ycPrefilterAddRegex(ctx->ruleSet[rulePos].prefilter,
+                                        ctx->ruleSet[rulePos].numRules,
+                                        captString);
                     ctx->ruleSet[rulePos].numRules++;
                     tempNumRules++;
                 }
@@ -1123,6 +1130,13 @@ gboolean ypInitializeProtocolRules(
                     newExtra = pcre_study(newRule, 0, &errorString);
                     ctx->ruleSet[rulePos].regexFields[ctx->ruleSet[rulePos].numRules].rule = newRule;
                     ctx->ruleSet[rulePos].regexFields[ctx->ruleSet[rulePos].numRules].extra = newExtra;
+                    if (NULL == ctx->ruleSet[rulePos].prefilter) {
+                        ctx->ruleSet[rulePos].prefilter =
+                            ycPrefilterAlloc(MAX_PAYLOAD_RULES);
+                    }
+                    ycPrefilterAddRegex(ctx->ruleSet[rulePos].prefilter,
+                                        ctx->ruleSet[rulePos].numRules,
+                                        captString);
                     ctx->ruleSet[rulePos].numRules++;
                     tempNumRules++;
                 }
@@ -1259,6 +1273,12 @@ gboolean ypInitializeProtocolRules(
         }
     }
 
+    for (rc = 0; rc < DPI_TOTAL_PROTOCOLS + 1; rc++) {
+        if (ctx->ruleSet[rc].prefilter) {
+            ycPrefilterBuild(ctx->ruleSet[rc].prefilter);
+        }
+    }
+
     g_debug("DPI rule scanner accepted %d rules from the DPI Rule File",
             tempNumRules);
     if (tempNumProtos) {
@@ -2613,16 +2633,35 @@ ypDPIScanner (
     pcre_extra         *extraHolder;
     int                rulePos = 0;
     yfDPIContext_t     *ctx = flowContext->yfctx;
+    uint8_t            candidates[YC_PREFILTER_BITMAP_SIZE(MAX_PAYLOAD_RULES)];
+    uint64_t           start;
 
     rulePos = ypProtocolHashSearch(ctx->dpiActiveHash, flow->appLabel, 0);
 
+    if (ctx->ruleSet[rulePos].prefilter) {
+        /* a match starting at offset has its anchor at or after offset */
+        ycPrefilterScan(ctx->ruleSet[rulePos].prefilter,
+                        payloadData + offset,
+                        (offset < payloadSize) ? (payloadSize - offset) : 0,
+                        candidates);
+    } else {
+        memset(candidates, 0xff, sizeof(candidates));
+    }
+
     for ( loop = 0; loop < ctx->ruleSet[rulePos].numRules; loop++) {
+        if (!YC_PREFILTER_ISSET(candidates, loop)) {
+            ycRuleStatsSkip(&ctx->ruleSet[rulePos].regexFields[loop].stats);
+            continue;
+        }
         ruleHolder = ctx->ruleSet[rulePos].regexFields[loop].rule;
         extraHolder = ctx->ruleSet[rulePos].regexFields[loop].extra;
         offsetptr = offset;
+        start = ycRuleStatsClock();
         rc = pcre_exec(ruleHolder, extraHolder,
                        (char *)(payloadData), payloadSize, offsetptr,
                        0, subVects, NUM_SUBSTRING_VECTS) ;
+        ycRuleStatsRecord(&ctx->ruleSet[rulePos].regexFields[loop].stats,
+                          start, (rc > 0));
         while ( (rc > 0) && (captDirection < YAF_MAX_CAPTURE_SIDE)) {
             /*Get only matched substring - don't need Labels*/
             if (rc > 1) {
@@ -2669,6 +2708,31 @@ ypDPIScanner (
     return captDirection;
 }
 
+/**
+ * ypDumpStats
+ *
+ * logs the run, hit, and prefilter skip counters of the DPI rules
+ *
+ */
+void ypDumpStats(
+    void           *yfctx)
+{
+    yfDPIContext_t *ctx = (yfDPIContext_t *)yfctx;
+    int            rulePos;
+    int            loop;
+
+    if (NULL == ctx || ctx->dpiInitialized == 0) {
+        return;
+    }
+
+    for (rulePos = 1; rulePos < DPI_TOTAL_PROTOCOLS + 1; rulePos++) {
+        for (loop = 0; loop < ctx->ruleSet[rulePos].numRules; loop++) {
+            ycRuleStatsLog("DPI", ctx->ruleSet[rulePos].applabel, loop + 1,
+                           &ctx->ruleSet[rulePos].regexFields[loop].stats);
+        }
+    }
+}
+
 
 /**
  * Protocol Specific Functions
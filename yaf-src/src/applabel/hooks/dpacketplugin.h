@@ -90,6 +90,7 @@
 #include <yaf/CERT_IE.h>
 #include <yaf/yafhooks.h>
 #include "payloadScanner.h"
+#include "prefilter.h"
 #include <pcre.h>
 
 
@@ -181,12 +182,16 @@ typedef struct protocolRegexFields_st {
     pcre_extra              *extra;
     const fbInfoElement_t   *elem;
     uint16_t                info_element_id;
+    ycRuleStats_t           stats;
 } protocolRegexFields;
 
 typedef struct protocolRegexRules_st {
     int numRules;
     enum { REGEX, PLUGIN, EMPTY, SIGNATURE } ruleType;
     uint16_t applabel;
+    /* literal anchors of the rules, so ypDPIScanner can skip rules that
+       cannot match */
+    ycPrefilter_t *prefilter;
     protocolRegexFields regexFields[MAX_PAYLOAD_RULES];
 } protocolRegexRules_t;
 
@@ -964,6 +969,9 @@ uint8_t ypDPIScanner(
     yfFlow_t         *flow,
     yfFlowVal_t      *val);
 
+void ypDumpStats(
+    void             *yfctx);
+
 
 /**
  * DPI FREE FUNCTIONS
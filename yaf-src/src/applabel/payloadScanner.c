@@ -74,6 +74,7 @@
 #include <search.h>
 #include <stdlib.h>
 #include "portHash.h"
+#include "prefilter.h"
 #include "payloadScanner.h"
 
 #ifdef YAF_ENABLE_HOOKS
@@ -113,6 +114,7 @@ typedef struct payloadScanRule_st {
             ycScannerPlugin_fn  func;
         } pluginArgs;
     } ruleArgs;
+    ycRuleStats_t       stats;
 } payloadScanRule_t;
 
 
@@ -133,6 +135,8 @@ static payloadScanRule_t ruleTable[MAX_PAYLOAD_RULES];
 static unsigned int numPayloadRules = 0;
 static payloadScanRule_t sigTable[MAX_PAYLOAD_RULES];
 static unsigned int numSigRules = 0;
+static ycPrefilter_t *rulePrefilter = NULL;
+static ycPrefilter_t *sigPrefilter = NULL;
 
 
 /**
@@ -153,6 +157,23 @@ static void         ycChunkString (
     int *argNum,
     char **argStrings[]);
 
+static void         ycBuildPrefilters (
+    void);
+
+static int          ycScanRegex (
+    payloadScanRule_t *rule,
+    const uint8_t * payloadData,
+    unsigned int payloadSize,
+    int *captVects,
+    int numCaptVects);
+
+static int          ycScanPlugin (
+    payloadScanRule_t *rule,
+    const uint8_t * payloadData,
+    unsigned int payloadSize,
+    yfFlow_t * flow,
+    yfFlowVal_t * val);
+
 #if YFDEBUG_APPLABEL
 static void         ycPayloadPrinter (
     uint8_t * payloadData,
@@ -304,6 +325,9 @@ ycInitializeScanRules (
         return FALSE;
     }
 
+    rulePrefilter = ycPrefilterAlloc(MAX_PAYLOAD_RULES);
+    sigPrefilter = ycPrefilterAlloc(MAX_PAYLOAD_RULES);
+
     /*
      * this is the loop that does the lion's share of the rule file
      * processing first read a hunk of the rule file, (this may include
@@ -438,6 +462,8 @@ ycInitializeScanRules (
                     ruleTable[numPayloadRules].ruleArgs.regexFields.
                       scannerExtra = newExtra;
                     ruleTable[numPayloadRules].ruleType = REGEX;
+                    ycPrefilterAddRegex(rulePrefilter, numPayloadRules,
+                                        captString);
                     ycPortHashInsert(ruleTable[numPayloadRules].payloadLabelValue, numPayloadRules);
                     numPayloadRules++;
                 }
@@ -563,6 +589,7 @@ ycInitializeScanRules (
 
                 if (MAX_PAYLOAD_RULES == numPayloadRules) {
                     g_warning ("maximum number of rules has been reached\n");
+                    ycBuildPrefilters();
                     return TRUE;
                 }
                 continue;
@@ -615,6 +642,7 @@ ycInitializeScanRules (
                 sigTable[numSigRules].ruleArgs.regexFields.
                     scannerExtra = newExtra;
                 sigTable[numSigRules].ruleType = SIGNATURE;
+                ycPrefilterAddRegex(sigPrefilter, numSigRules, captString);
                 numSigRules++;
             }
 
@@ -679,11 +707,88 @@ ycInitializeScanRules (
     pcre_free(pluginArgScanner);
     pcre_free(signatureScanner);
 
+    ycBuildPrefilters();
+
     /* debug */
     return TRUE;
 }
 
 
+/**
+ * ycBuildPrefilters
+ *
+ * compile the literal anchors of the regex and signature rules so that
+ * ycScanPayload only runs the rules that can match a payload
+ *
+ */
+static void
+ycBuildPrefilters (
+    void)
+{
+    ycPrefilterBuild(rulePrefilter);
+    ycPrefilterBuild(sigPrefilter);
+
+    g_debug("Application Labeler prefilter anchors %u rules and %u "
+            "signatures.", ycPrefilterCount(rulePrefilter),
+            ycPrefilterCount(sigPrefilter));
+}
+
+
+/**
+ * ycScanRegex
+ *
+ * run a single regex or signature rule against a payload, counting the run
+ * in the rule's statistics
+ *
+ */
+static int
+ycScanRegex (
+    payloadScanRule_t *rule,
+    const uint8_t * payloadData,
+    unsigned int payloadSize,
+    int *captVects,
+    int numCaptVects)
+{
+    uint64_t            start = ycRuleStatsClock();
+    int                 rc;
+
+    rc = pcre_exec(rule->ruleArgs.regexFields.scannerExpression,
+                   rule->ruleArgs.regexFields.scannerExtra,
+                   (char *) payloadData, payloadSize, 0, 0, captVects,
+                   numCaptVects);
+    ycRuleStatsRecord(&rule->stats, start, (rc > 0));
+
+    return rc;
+}
+
+
+/**
+ * ycScanPlugin
+ *
+ * run a single plugin rule against a payload, counting the run in the
+ * rule's statistics
+ *
+ */
+static int
+ycScanPlugin (
+    payloadScanRule_t *rule,
+    const uint8_t * payloadData,
+    unsigned int payloadSize,
+    yfFlow_t * flow,
+    yfFlowVal_t * val)
+{
+    uint64_t            start = ycRuleStatsClock();
+    int                 rc;
+
+    rc = rule->ruleArgs.pluginArgs.func(rule->ruleArgs.pluginArgs.numArgs,
+                                        rule->ruleArgs.pluginArgs.pluginArgs,
+                                        payloadData, payloadSize, flow, val);
+    ycRuleStatsRecord(&rule->stats, start, (rc > 0));
+
+    return rc;
+}
+
+
 
 
 /**
@@ -709,8 +814,13 @@ ycScanPayload (
 {
 #define NUM_CAPT_VECTS 18
     unsigned int        loop = 0;
+    unsigned int        portRule = MAX_PAYLOAD_RULES + 1;
     int                 rc = 0;
     int                 captVects[NUM_CAPT_VECTS];
+    uint8_t             fwdSigs[YC_PREFILTER_BITMAP_SIZE(MAX_PAYLOAD_RULES)];
+    uint8_t             revSigs[YC_PREFILTER_BITMAP_SIZE(MAX_PAYLOAD_RULES)];
+    uint8_t             candidates[YC_PREFILTER_BITMAP_SIZE(MAX_PAYLOAD_RULES)];
+    gboolean            prefiltered = FALSE;
     uint16_t            dstPort;
     uint16_t            srcPort;
 
@@ -722,21 +832,29 @@ ycScanPayload (
     /* first check the signature table to see if any signatures should
      * be executed first  - check both directions and only check once*/
     if ( numSigRules > 0 && (val == &(flow->val))) {
+        ycPrefilterScan(sigPrefilter, payloadData, payloadSize, fwdSigs);
+        if (flow->rval.paylen) {
+            ycPrefilterScan(sigPrefilter, flow->rval.payload,
+                            flow->rval.paylen, revSigs);
+        }
         for (loop = 0; loop < numSigRules; loop++) {
-            rc = pcre_exec(sigTable[loop].ruleArgs.regexFields.scannerExpression,
-                    sigTable[loop].ruleArgs.regexFields.scannerExtra,
-                    (char *) payloadData, payloadSize, 0, 0, captVects,
-                    NUM_CAPT_VECTS);
-
-            if (rc > 0) {
-                /* Found a signature match */
-                return sigTable[loop].payloadLabelValue;
+            if (YC_PREFILTER_ISSET(fwdSigs, loop)) {
+                rc = ycScanRegex(&sigTable[loop], payloadData, payloadSize,
+                                 captVects, NUM_CAPT_VECTS);
+                if (rc > 0) {
+                    /* Found a signature match */
+                    return sigTable[loop].payloadLabelValue;
+                }
+            } else {
+                ycRuleStatsSkip(&sigTable[loop].stats);
             }
             if (flow->rval.paylen) {
-                rc = pcre_exec (sigTable[loop].ruleArgs.regexFields.scannerExpression,
-                        sigTable[loop].ruleArgs.regexFields.scannerExtra,
-                        (char *) flow->rval.payload, flow->rval.paylen, 0, 0,
-                        captVects, NUM_CAPT_VECTS);
+                if (!YC_PREFILTER_ISSET(revSigs, loop)) {
+                    ycRuleStatsSkip(&sigTable[loop].stats);
+                    continue;
+                }
+                rc = ycScanRegex(&sigTable[loop], flow->rval.payload,
+                                 flow->rval.paylen, captVects, NUM_CAPT_VECTS);
                 if (rc > 0) {
                     /* Found a signature match on reverse direction */
                     return sigTable[loop].payloadLabelValue;
@@ -749,22 +867,12 @@ ycScanPayload (
      * match, then exhaustively try all the rules in definition order */
     if ((MAX_PAYLOAD_RULES + 1) != (loop = ycPortHashSearch (srcPort))) {
         if (REGEX == ruleTable[loop].ruleType) {
-            rc =
-             pcre_exec(ruleTable[loop].ruleArgs.regexFields.scannerExpression,
-                       ruleTable[loop].ruleArgs.regexFields.scannerExtra,
-                       (char *) payloadData, payloadSize, 0, 0, captVects,
-                       NUM_CAPT_VECTS);
+            portRule = loop;
+            rc = ycScanRegex(&ruleTable[loop], payloadData, payloadSize,
+                             captVects, NUM_CAPT_VECTS);
         } else if (PLUGIN == ruleTable[loop].ruleType) {
-            rc =
-                ruleTable[loop].ruleArgs.pluginArgs.func(ruleTable[loop].
-                                                         ruleArgs.pluginArgs.
-                                                         numArgs,
-                                                         ruleTable[loop].
-                                                         ruleArgs.pluginArgs.
-                                                         pluginArgs,
-                                                         payloadData,
-                                                         payloadSize,
-                                                         flow, val);
+            rc = ycScanPlugin(&ruleTable[loop], payloadData, payloadSize,
+                              flow, val);
             if (rc > 0) {
                 if (rc == 1) {
                     return ruleTable[loop].payloadLabelValue;
@@ -777,22 +885,12 @@ ycScanPayload (
     } else if ((MAX_PAYLOAD_RULES + 1) != (loop = ycPortHashSearch (dstPort)))
     {
         if (REGEX == ruleTable[loop].ruleType) {
-            rc =
-                pcre_exec (ruleTable[loop].ruleArgs.regexFields.scannerExpression,
-                           ruleTable[loop].ruleArgs.regexFields.scannerExtra,
-                           (char *) payloadData, payloadSize, 0, 0, captVects,
-                           NUM_CAPT_VECTS);
+            portRule = loop;
+            rc = ycScanRegex(&ruleTable[loop], payloadData, payloadSize,
+                             captVects, NUM_CAPT_VECTS);
         } else if (PLUGIN == ruleTable[loop].ruleType) {
-            rc =
-                ruleTable[loop].ruleArgs.pluginArgs.func (ruleTable[loop].
-                                                          ruleArgs.pluginArgs.
-                                                          numArgs,
-                                                          ruleTable[loop].
-                                                          ruleArgs.pluginArgs.
-                                                          pluginArgs,
-                                                          payloadData,
-                                                          payloadSize,
-                                                          flow, val);
+            rc = ycScanPlugin(&ruleTable[loop], payloadData, payloadSize,
+                              flow, val);
             if (rc > 0) {
                 if (rc == 1) {
                     return ruleTable[loop].payloadLabelValue;
@@ -815,11 +913,22 @@ ycScanPayload (
 
     for (loop = 0; loop < numPayloadRules; loop++) {
         if (REGEX == ruleTable[loop].ruleType) {
-            rc =
-              pcre_exec(ruleTable[loop].ruleArgs.regexFields.scannerExpression,
-                         ruleTable[loop].ruleArgs.regexFields.scannerExtra,
-                         (char *) payloadData, payloadSize, 0, 0, captVects,
-                         NUM_CAPT_VECTS);
+            if (loop == portRule) {
+                /* already tried against this payload above */
+                continue;
+            }
+            /* only scan for the literal anchors once a regex is needed */
+            if (!prefiltered) {
+                ycPrefilterScan(rulePrefilter, payloadData, payloadSize,
+                                candidates);
+                prefiltered = TRUE;
+            }
+            if (!YC_PREFILTER_ISSET(candidates, loop)) {
+                ycRuleStatsSkip(&ruleTable[loop].stats);
+                continue;
+            }
+            rc = ycScanRegex(&ruleTable[loop], payloadData, payloadSize,
+                             captVects, NUM_CAPT_VECTS);
             if (rc > 0) {
 #if YFDEBUG_APPLABEL
                 g_debug("protocol match (%u, %u): \"",
@@ -829,16 +938,8 @@ ycScanPayload (
                 return ruleTable[loop].payloadLabelValue;
             }
         } else if (PLUGIN == ruleTable[loop].ruleType) {
-            rc =
-                ruleTable[loop].ruleArgs.pluginArgs.func (ruleTable[loop].
-                                                          ruleArgs.pluginArgs.
-                                                          numArgs,
-                                                          ruleTable[loop].
-                                                          ruleArgs.pluginArgs.
-                                                          pluginArgs,
-                                                          payloadData,
-                                                          payloadSize,
-                                                          flow, val);
+            rc = ycScanPlugin(&ruleTable[loop], payloadData, payloadSize,
+                              flow, val);
             if (rc > 0) {
 #if YFDEBUG_APPLABEL
                 g_debug("protocol match (%u, %u): \"",
@@ -871,6 +972,28 @@ ycScanPayload (
 
 }
 
+/**
+ * ycScanPayloadDumpStats
+ *
+ *
+ */
+void ycScanPayloadDumpStats(
+    void)
+{
+    unsigned int loop;
+
+    for (loop = 0; loop < numSigRules; loop++) {
+        ycRuleStatsLog("Application Labeler signature",
+                       sigTable[loop].payloadLabelValue, loop + 1,
+                       &sigTable[loop].stats);
+    }
+    for (loop = 0; loop < numPayloadRules; loop++) {
+        ycRuleStatsLog("Application Labeler",
+                       ruleTable[loop].payloadLabelValue, loop + 1,
+                       &ruleTable[loop].stats);
+    }
+}
+
 /**
  * ycGetRuleType
  *
@@ -131,6 +131,17 @@ ycScanPayload (
     yfFlow_t * flow,
     yfFlowVal_t * val);
 
+/**
+ * ycScanPayloadDumpStats
+ *
+ * logs the run, hit, and prefilter skip counters of each rule that was
+ * considered by ycScanPayload
+ *
+ */
+void
+ycScanPayloadDumpStats (
+    void);
+
 
 /**
  * ycDnsScanRebuildHeader
@@ -71,6 +71,7 @@
 #include <yaf/yafcore.h>
 #include <yaf/decode.h>
 #include <pcre.h>
+#include <pthread.h>
 
 #if YAF_ENABLE_HOOKS
 #include <yaf/yafhooks.h>
@@ -89,6 +90,8 @@ static pcre *ircMsgRegex = NULL;
 static pcre *ircRegex = NULL;
 static pcre *ircDPIRegex = NULL;
 static unsigned int pcreInitialized = 0;
+/* scanners may run on several threads at once */
+static pthread_once_t pcreInitOnce = PTHREAD_ONCE_INIT;
 
 
 
@@ -98,6 +101,7 @@ static unsigned int pcreInitialized = 0;
  *
  */
 static uint16_t ycIrcScanInit (void);
+static void ycIrcScanInitOnce (void);
 #if IRCDEBUG
 static int ycDebugBinPrintf(uint8_t *data, uint16_t size);
 #endif
@@ -136,10 +140,9 @@ ircplugin_LTX_ycIrcScanScan (
 #   define NUM_CAPT_VECTS 60
     int vects[NUM_CAPT_VECTS];
 
+    pthread_once(&pcreInitOnce, ycIrcScanInitOnce);
     if (0 == pcreInitialized) {
-        if (0 == ycIrcScanInit()) {
-            return 0;
-        }
+        return 0;
     }
 
     rc = pcre_exec(ircMsgRegex, NULL, (char *)payload, payloadSize,
@@ -266,3 +269,15 @@ ycDebugBinPrintf(uint8_t *data, uint16_t size)
     return numPrinted;
 }
 #endif
+
+/**
+ * ycIrcScanInitOnce
+ *
+ * runs ycIrcScanInit; called once, through pthread_once
+ *
+ */
+static void
+ycIrcScanInitOnce (void)
+{
+    ycIrcScanInit();
+}
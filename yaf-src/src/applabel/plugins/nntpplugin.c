@@ -76,6 +76,7 @@
 #endif
 
 #include <pcre.h>
+#include <pthread.h>
 
 
 #define NNTP_PORT 119
@@ -88,6 +89,8 @@
 static pcre *nntpCommandRegex = NULL;
 static pcre *nntpResponseRegex = NULL;
 static unsigned int pcreInitialized = 0;
+/* scanners may run on several threads at once */
+static pthread_once_t pcreInitOnce = PTHREAD_ONCE_INIT;
 
 
 /**
@@ -95,6 +98,7 @@ static unsigned int pcreInitialized = 0;
  *
  */
 static uint16_t ycNNTPScanInit (void);
+static void ycNNTPScanInitOnce (void);
 
 /*static int ycDebugBinPrintf(uint8_t *data, uint16_t size);*/
 
@@ -132,10 +136,9 @@ nntpplugin_LTX_ycNNTPScanScan (
     int vects[NUM_CAPT_VECTS];
 
 
+    pthread_once(&pcreInitOnce, ycNNTPScanInitOnce);
     if (0 == pcreInitialized) {
-        if (0 == ycNNTPScanInit()) {
-            return 0;
-        }
+        return 0;
     }
 
     rc = pcre_exec(nntpCommandRegex, NULL, (char *)payload, payloadSize,
@@ -236,3 +239,15 @@ ycDebugBinPrintf(uint8_t *data, uint16_t size)
     return numPrinted;
 }
 */
+
+/**
+ * ycNNTPScanInitOnce
+ *
+ * runs ycNNTPScanInit; called once, through pthread_once
+ *
+ */
+static void
+ycNNTPScanInitOnce (void)
+{
+    ycNNTPScanInit();
+}
@@ -75,6 +75,7 @@
 #endif
 
 #include <pcre.h>
+#include <pthread.h>
 
 #define POP3DEBUG 0
 #define POP3_PORT 110
@@ -88,6 +89,8 @@ static pcre *pop3ReqRegex = NULL;
 static pcre *pop3RespRegex = NULL;
 
 static unsigned int pcreInitialized = 0;
+/* scanners may run on several threads at once */
+static pthread_once_t pcreInitOnce = PTHREAD_ONCE_INIT;
 
 
 /**
@@ -96,6 +99,7 @@ static unsigned int pcreInitialized = 0;
  */
 
 static uint16_t ycPop3ScanInit (void);
+static void ycPop3ScanInitOnce (void);
 #if POP3DEBUG
 static int ycDebugBinPrintf(uint8_t *data, uint16_t size);
 #endif
@@ -135,10 +139,9 @@ pop3plugin_LTX_ycPop3ScanScan (
     uint16_t infoElement = 110;
     pcre *currentRegex = NULL;
 
+    pthread_once(&pcreInitOnce, ycPop3ScanInitOnce);
     if (0 == pcreInitialized) {
-        if (0 == ycPop3ScanInit()) {
-            return 0;
-        }
+        return 0;
     }
 
     currentRegex = pop3ReqRegex;
@@ -239,3 +242,15 @@ ycDebugBinPrintf(uint8_t *data, uint16_t size)
     return numPrinted;
 }
 #endif
+
+/**
+ * ycPop3ScanInitOnce
+ *
+ * runs ycPop3ScanInit; called once, through pthread_once
+ *
+ */
+static void
+ycPop3ScanInitOnce (void)
+{
+    ycPop3ScanInit();
+}
@@ -78,9 +78,12 @@
 #endif
 
 #include <pcre.h>
+#include <pthread.h>
 
 static pcre *httpConnectRegex = NULL;
 static unsigned int pcreInitialized = 0;
+/* scanners may run on several threads at once */
+static pthread_once_t pcreInitOnce = PTHREAD_ONCE_INIT;
 static pcre *httpConnectEstRegex = NULL;
 
 /* this might be more - but I have to have a limit somewhere */
@@ -125,6 +128,7 @@ gboolean decodeTLSv1(uint8_t *payload,
                  uint8_t  type);
 
 static uint16_t yfProxyScanInit(void);
+static void yfProxyScanInitOnce(void);
 
 #define TLS_PORT_NUMBER  443
 
@@ -171,10 +175,9 @@ proxyplugin_LTX_ycProxyScanScan (
     unsigned int payloadLength = payloadSize;
     int        rc, loop = 0;
 
+    pthread_once(&pcreInitOnce, yfProxyScanInitOnce);
     if (0 == pcreInitialized) {
-        if (0 == yfProxyScanInit()) {
-            return 0;
-        }
+        return 0;
     }
 
     /* if the applabel is 0, this is the fwd direction which should have
@@ -713,3 +716,14 @@ static uint16_t yfProxyScanInit()
 
     return pcreInitialized;
 }
+
+/**
+ * yfProxyScanInitOnce
+ *
+ * runs yfProxyScanInit; called once, through pthread_once
+ *
+ */
+static void yfProxyScanInitOnce(void)
+{
+    yfProxyScanInit();
+}
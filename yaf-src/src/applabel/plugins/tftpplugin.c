@@ -82,18 +82,22 @@
 #endif
 
 #include <pcre.h>
+#include <pthread.h>
 
 #define TFTP_PORT_NUMBER 69
 
 
 static pcre *tftpRegex = NULL;
 static unsigned int pcreInitialized = 0;
+/* scanners may run on several threads at once */
+static pthread_once_t pcreInitOnce = PTHREAD_ONCE_INIT;
 
 /**
  * static local functions
  *
  */
 static uint16_t ycTFTPScanInit (void);
+static void ycTFTPScanInitOnce (void);
 
 /**
  * tftpplugin_LTX_ycTFTPScan
@@ -132,10 +136,9 @@ tftpplugin_LTX_ycTFTPScanScan (
         return 0;
     }
 
+    pthread_once(&pcreInitOnce, ycTFTPScanInitOnce);
     if (0 == pcreInitialized) {
-        if (0 == ycTFTPScanInit()) {
-            return 0;
-        }
+        return 0;
     }
 
     opcode = ntohs(*(uint16_t*)payload);
@@ -219,3 +222,15 @@ ycTFTPScanInit ()
 
     return pcreInitialized;
 }
+
+/**
+ * ycTFTPScanInitOnce
+ *
+ * runs ycTFTPScanInit; called once, through pthread_once
+ *
+ */
+static void
+ycTFTPScanInitOnce (void)
+{
+    ycTFTPScanInit();
+}
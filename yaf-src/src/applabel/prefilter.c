@@ -0,0 +1,922 @@
+/**
+ *@internal
+ *
+ *@file prefilter.c
+ *
+ * Literal anchor extraction and Aho-Corasick matching used to decide which
+ * regular expression rules need to be run against a payload.
+ *
+ * An anchor is only extracted when it is certain to be part of every
+ * match: anything the extractor does not understand makes the rule
+ * unfiltered rather than risk skipping a rule that would have matched.
+ *
+ ** ------------------------------------------------------------------------
+ ** Copyright (C) 2007-2016 Carnegie Mellon University. All Rights Reserved.
+ ** ------------------------------------------------------------------------
+ **
+ ** @OPENSOURCE_HEADER_START@
+ ** Use of the YAF system and related source code is subject to the terms
+ ** of the following licenses:
+ **
+ ** GNU Public License (GPL) Rights pursuant to Version 2, June 1991
+ ** Government Purpose License Rights (GPLR) pursuant to DFARS 252.227.7013
+ **
+ ** NO WARRANTY
+ **
+ ** ANY INFORMATION, MATERIALS, SERVICES, INTELLECTUAL PROPERTY OR OTHER
+ ** PROPERTY OR RIGHTS GRANTED OR PROVIDED BY CARNEGIE MELLON UNIVERSITY
+ ** PURSUANT TO THIS LICENSE (HEREINAFTER THE "DELIVERABLES") ARE ON AN
+ ** "AS-IS" BASIS. CARNEGIE MELLON UNIVERSITY MAKES NO WARRANTIES OF ANY
+ ** KIND, EITHER EXPRESS OR IMPLIED AS TO ANY MATTER INCLUDING, BUT NOT
+ ** LIMITED TO, WARRANTY OF FITNESS FOR A PARTICULAR PURPOSE,
+ ** MERCHANTABILITY, INFORMATIONAL CONTENT, NONINFRINGEMENT, OR ERROR-FREE
+ ** OPERATION. CARNEGIE MELLON UNIVERSITY SHALL NOT BE LIABLE FOR INDIRECT,
+ ** SPECIAL OR CONSEQUENTIAL DAMAGES, SUCH AS LOSS OF PROFITS OR INABILITY
+ ** TO USE SAID INTELLECTUAL PROPERTY, UNDER THIS LICENSE, REGARDLESS OF
+ ** WHETHER SUCH PARTY WAS AWARE OF THE POSSIBILITY OF SUCH DAMAGES.
+ ** LICENSEE AGREES THAT IT WILL NOT MAKE ANY WARRANTY ON BEHALF OF
+ ** CARNEGIE MELLON UNIVERSITY, EXPRESS OR IMPLIED, TO ANY PERSON
+ ** CONCERNING THE APPLICATION OF OR THE RESULTS TO BE OBTAINED WITH THE
+ ** DELIVERABLES UNDER THIS LICENSE.
+ **
+ ** Licensee hereby agrees to defend, indemnify, and hold harmless Carnegie
+ ** Mellon University, its trustees, officers, employees, and agents from
+ ** all claims or demands made against them (and any related losses,
+ ** expenses, or attorney's fees) arising out of, or relating to Licensee's
+ ** and/or its sub licensees' negligent use or willful misuse of or
+ ** negligent conduct or willful misconduct regarding the Software,
+ ** facilities, or other rights or assistance granted by Carnegie Mellon
+ ** University under this License, including, but not limited to, any
+ ** claims of product liability, personal injury, death, damage to
+ ** property, or violation of any laws or regulations.
+ **
+ ** Carnegie Mellon University Software Engineering Institute authored
+ ** documents are sponsored by the U.S. Department of Defense under
+ ** Contract FA8721-05-C-0003. Carnegie Mellon University retains
+ ** copyrights in all material produced under this contract. The U.S.
+ ** Government retains a non-exclusive, royalty-free license to publish or
+ ** reproduce these documents, or allow others to do so, for U.S.
+ ** Government purposes only pursuant to the copyright license under the
+ ** contract clause at 252.227.7013.
+ **
+ ** @OPENSOURCE_HEADER_END@
+ */
+
+#define _YAF_SOURCE_
+#include <yaf/autoinc.h>
+
+#if YAF_ENABLE_APPLABEL
+
+#include <ctype.h>
+#include <pthread.h>
+#include "prefilter.h"
+
+/* anchors shorter than this match too often to be worth filtering on */
+#define YC_PREFILTER_MIN_LITERAL 2
+/* any part of a required literal is also required, so long ones are cut */
+#define YC_PREFILTER_MAX_LITERAL 32
+
+/* PCRE's default character tables only fold ASCII letters */
+#define YC_FOLD(c) ((((c) >= 'A') && ((c) <= 'Z')) ? ((c) + 32) : (c))
+
+typedef struct ycLiteral_st {
+    uint8_t             str[YC_PREFILTER_MAX_LITERAL];
+    unsigned int        len;
+} ycLiteral_t;
+
+typedef struct ycAnchor_st {
+    ycLiteral_t         lit;
+    unsigned int        id;
+    gboolean            caseless;
+    /* next anchor ending in the same automaton state, or -1 */
+    int                 next;
+} ycAnchor_t;
+
+struct ycPrefilter_st {
+    unsigned int        maxIds;
+    /* rules without an anchor, copied into every candidate bitmap */
+    uint8_t            *always;
+    ycAnchor_t         *anchors;
+    unsigned int        numAnchors;
+    /* automaton, over byte classes of case-folded input */
+    uint8_t             classMap[256];
+    unsigned int        numClasses;
+    unsigned int        numStates;
+    uint32_t           *delta;
+    /* first anchor ending at each state, or -1 */
+    int                *match;
+    /* nearest state on the failure chain that ends an anchor, 0 if none */
+    uint32_t           *outLink;
+};
+
+/* counters kept by one thread for one rule */
+typedef struct ycRuleCounts_st {
+    uint64_t            runs;
+    uint64_t            hits;
+    uint64_t            skips;
+    uint64_t            nsec;
+} ycRuleCounts_t;
+
+/* counters of every rule for one thread, indexed by rule id */
+typedef struct ycRuleStatsTable_st {
+    struct ycRuleStatsTable_st *next;
+    ycRuleCounts_t     *counts;
+    unsigned int        size;
+} ycRuleStatsTable_t;
+
+static gboolean ycRuleStatsEnabled = FALSE;
+/* last rule id handed out */
+static unsigned int ycRuleStatsLastId = 0;
+/* tables of all threads; the lock guards the list and each table's size */
+static ycRuleStatsTable_t *ycRuleStatsTables = NULL;
+static pthread_mutex_t ycRuleStatsLock = PTHREAD_MUTEX_INITIALIZER;
+/* table of the calling thread */
+static __thread ycRuleStatsTable_t *ycRuleStatsMine = NULL;
+
+typedef struct ycRegexParse_st {
+    const char         *p;
+    gboolean            fail;
+    gboolean            caseless;
+} ycRegexParse_t;
+
+static void ycParseSequence(
+    ycRegexParse_t     *ps,
+    ycLiteral_t        *best,
+    gboolean           *alt);
+
+
+/**
+ * ycLiteralKeep
+ *
+ * remember cur as the best literal if it is the longest seen so far
+ *
+ */
+static void ycLiteralKeep(
+    ycLiteral_t        *best,
+    const ycLiteral_t  *cur)
+{
+    if (cur->len > best->len) {
+        memcpy(best, cur, sizeof(ycLiteral_t));
+    }
+}
+
+/**
+ * ycParseQuantifier
+ *
+ * parse an optional quantifier at the current position
+ *
+ * @return -1 if there is none, otherwise its minimum repeat count
+ */
+static int ycParseQuantifier(
+    ycRegexParse_t     *ps)
+{
+    const char *p = ps->p;
+    int         min;
+
+    switch (*p) {
+      case '?':
+      case '*':
+        min = 0;
+        p++;
+        break;
+      case '+':
+        min = 1;
+        p++;
+        break;
+      case '{':
+        p++;
+        if (!isdigit((unsigned char)*p)) {
+            /* PCRE takes this as a literal brace; not worth handling */
+            ps->fail = TRUE;
+            return -1;
+        }
+        min = 0;
+        while (isdigit((unsigned char)*p)) {
+            min = (min > 1000) ? min : (min * 10 + (*p - '0'));
+            p++;
+        }
+        if (*p == ',') {
+            p++;
+            while (isdigit((unsigned char)*p)) {
+                p++;
+            }
+        }
+        if (*p != '}') {
+            ps->fail = TRUE;
+            return -1;
+        }
+        p++;
+        break;
+      default:
+        return -1;
+    }
+
+    /* lazy and possessive forms do not change what is required */
+    if (*p == '?' || *p == '+') {
+        p++;
+    }
+    ps->p = p;
+
+    return min;
+}
+
+/**
+ * ycParseEscape
+ *
+ * parse the escape sequence following a backslash
+ *
+ * @return the literal octet it stands for, or -1 if it is not a literal
+ */
+static int ycParseEscape(
+    ycRegexParse_t     *ps)
+{
+    int c = (unsigned char)*ps->p;
+    int val, i;
+
+    if (c == '\0') {
+        ps->fail = TRUE;
+        return -1;
+    }
+    ps->p++;
+
+    switch (c) {
+      case 'n':
+        return '\n';
+      case 'r':
+        return '\r';
+      case 't':
+        return '\t';
+      case 'f':
+        return '\f';
+      case 'e':
+        return 0x1b;
+      case 'a':
+        return 0x07;
+      case 'x':
+        if (*ps->p == '{') {
+            ps->fail = TRUE;
+            return -1;
+        }
+        val = 0;
+        for (i = 0; i < 2 && isxdigit((unsigned char)*ps->p); i++) {
+            val = val * 16 + g_ascii_xdigit_value(*ps->p);
+            ps->p++;
+        }
+        return val;
+      case '0':
+        val = 0;
+        for (i = 0; i < 2 && *ps->p >= '0' && *ps->p <= '7'; i++) {
+            val = val * 8 + (*ps->p - '0');
+            ps->p++;
+        }
+        return val;
+      case 'd': case 'D': case 'w': case 'W': case 's': case 'S':
+      case 'h': case 'H': case 'v': case 'V': case 'R': case 'N':
+      case 'X': case 'C':
+      case 'b': case 'B': case 'A': case 'z': case 'Z': case 'G':
+      case 'K':
+        /* character types and assertions */
+        return -1;
+      default:
+        break;
+    }
+
+    if (isalnum(c)) {
+        /* back references, \Q..\E, properties, and the like */
+        ps->fail = TRUE;
+        return -1;
+    }
+
+    return c;
+}
+
+/**
+ * ycSkipClass
+ *
+ * skip over a character class; the opening bracket is already consumed
+ *
+ */
+static void ycSkipClass(
+    ycRegexParse_t     *ps)
+{
+    const char *p = ps->p;
+
+    if (*p == '^') {
+        p++;
+    }
+    /* a leading close bracket is part of the class */
+    if (*p == ']') {
+        p++;
+    }
+    while (*p && *p != ']') {
+        if (*p == '\\') {
+            p++;
+            if (*p == '\0') {
+                break;
+            }
+        } else if (*p == '[' && p[1] == ':') {
+            const char *end = strstr(p + 2, ":]");
+            if (end) {
+                p = end + 1;
+            }
+        }
+        p++;
+    }
+
+    if (*p != ']') {
+        ps->fail = TRUE;
+        return;
+    }
+    ps->p = p + 1;
+}
+
+/**
+ * ycParseGroup
+ *
+ * parse a parenthesized group; the opening parenthesis is already consumed
+ *
+ * @return TRUE if best holds a literal every match of the group contains
+ */
+static gboolean ycParseGroup(
+    ycRegexParse_t     *ps,
+    ycLiteral_t        *best)
+{
+    gboolean    alt = FALSE;
+    gboolean    lookaround = FALSE;
+    const char *p = ps->p;
+
+    best->len = 0;
+
+    if (*p == '*') {
+        /* (*VERB) */
+        ps->fail = TRUE;
+        return FALSE;
+    }
+
+    if (*p == '?') {
+        p++;
+        switch (*p) {
+          case ':':
+          case '>':
+          case '|':
+            p++;
+            break;
+          case '=':
+          case '!':
+            lookaround = TRUE;
+            p++;
+            break;
+          case '<':
+            if (p[1] == '=' || p[1] == '!') {
+                lookaround = TRUE;
+                p += 2;
+                break;
+            }
+            /* FALLTHROUGH */
+          case '\'':
+            /* named group */
+            p = strpbrk(p + 1, ">'");
+            if (NULL == p) {
+                ps->fail = TRUE;
+                return FALSE;
+            }
+            p++;
+            break;
+          case 'P':
+            if (p[1] != '<') {
+                /* named back reference or recursion */
+                ps->fail = TRUE;
+                return FALSE;
+            }
+            p = strchr(p + 2, '>');
+            if (NULL == p) {
+                ps->fail = TRUE;
+                return FALSE;
+            }
+            p++;
+            break;
+          case '#':
+            p = strchr(p, ')');
+            if (NULL == p) {
+                ps->fail = TRUE;
+                return FALSE;
+            }
+            ps->p = p + 1;
+            return FALSE;
+          default:
+            /* option setting, either alone or starting a group */
+            while (*p && strchr("imsxXJU-", *p)) {
+                if (*p == 'x') {
+                    ps->fail = TRUE;
+                    return FALSE;
+                }
+                if (*p == 'i') {
+                    ps->caseless = TRUE;
+                }
+                p++;
+            }
+            if (*p == ')') {
+                ps->p = p + 1;
+                return FALSE;
+            }
+            if (*p != ':') {
+                /* conditions, recursion, and callouts */
+                ps->fail = TRUE;
+                return FALSE;
+            }
+            p++;
+            break;
+        }
+    }
+
+    ps->p = p;
+    ycParseSequence(ps, best, &alt);
+    if (ps->fail) {
+        return FALSE;
+    }
+    if (*ps->p != ')') {
+        ps->fail = TRUE;
+        return FALSE;
+    }
+    ps->p++;
+
+    return (!alt && !lookaround && best->len > 0);
+}
+
+/**
+ * ycParseSequence
+ *
+ * parse a sequence of alternatives up to a closing parenthesis or the end
+ * of the expression, finding the longest run of literal octets every match
+ * must contain.  Nothing is returned in best if the sequence has more than
+ * one alternative.
+ *
+ */
+static void ycParseSequence(
+    ycRegexParse_t     *ps,
+    ycLiteral_t        *best,
+    gboolean           *alt)
+{
+    ycLiteral_t cur;
+    ycLiteral_t group;
+    int         c;
+    int         min;
+    gboolean    required;
+
+    best->len = 0;
+    cur.len = 0;
+    *alt = FALSE;
+
+    while (*ps->p && *ps->p != ')' && !ps->fail) {
+        c = (unsigned char)*ps->p++;
+        switch (c) {
+          case '|':
+            *alt = TRUE;
+            cur.len = 0;
+            continue;
+          case '(':
+            ycLiteralKeep(best, &cur);
+            cur.len = 0;
+            required = ycParseGroup(ps, &group);
+            min = ycParseQuantifier(ps);
+            if (required && min != 0) {
+                ycLiteralKeep(best, &group);
+            }
+            continue;
+          case '[':
+            ycSkipClass(ps);
+            c = -1;
+            break;
+          case '.':
+          case '^':
+          case '$':
+            c = -1;
+            break;
+          case '\\':
+            c = ycParseEscape(ps);
+            break;
+          case '?':
+          case '*':
+          case '+':
+          case '{':
+            /* quantifier with nothing to repeat */
+            ps->fail = TRUE;
+            continue;
+          default:
+            break;
+        }
+
+        if (ps->fail) {
+            break;
+        }
+        min = ycParseQuantifier(ps);
+        if (c < 0 || min == 0) {
+            /* not a literal, or an optional one: the run ends here */
+            ycLiteralKeep(best, &cur);
+            cur.len = 0;
+            continue;
+        }
+        if (cur.len == YC_PREFILTER_MAX_LITERAL) {
+            ycLiteralKeep(best, &cur);
+            cur.len = 0;
+        }
+        cur.str[cur.len++] = (uint8_t)c;
+        if (min > 0) {
+            /* the octet appears at least once, but what follows it is
+             * not adjacent to that one occurrence */
+            ycLiteralKeep(best, &cur);
+            cur.len = 0;
+        }
+    }
+
+    ycLiteralKeep(best, &cur);
+    if (*alt) {
+        best->len = 0;
+    }
+}
+
+/**
+ * ycPrefilterAlloc
+ *
+ *
+ *
+ */
+ycPrefilter_t *ycPrefilterAlloc(
+    unsigned int        maxIds)
+{
+    ycPrefilter_t *pf = g_new0(ycPrefilter_t, 1);
+
+    pf->maxIds = maxIds;
+    pf->always = g_new0(uint8_t, YC_PREFILTER_BITMAP_SIZE(maxIds));
+    pf->anchors = g_new0(ycAnchor_t, maxIds);
+
+    return pf;
+}
+
+/**
+ * ycPrefilterAddRegex
+ *
+ *
+ *
+ */
+gboolean ycPrefilterAddRegex(
+    ycPrefilter_t      *pf,
+    unsigned int        id,
+    const char         *regex)
+{
+    ycRegexParse_t ps;
+    ycLiteral_t    best;
+    gboolean       alt;
+    ycAnchor_t    *anchor;
+
+    g_assert(id < pf->maxIds && NULL == pf->delta);
+
+    ps.p = regex;
+    ps.fail = FALSE;
+    ps.caseless = FALSE;
+    ycParseSequence(&ps, &best, &alt);
+    if (*ps.p != '\0') {
+        /* unbalanced parenthesis */
+        ps.fail = TRUE;
+    }
+
+    if (ps.fail || best.len < YC_PREFILTER_MIN_LITERAL) {
+        pf->always[id >> 3] |= (1 << (id & 7));
+        return FALSE;
+    }
+
+    anchor = &pf->anchors[pf->numAnchors++];
+    memcpy(&anchor->lit, &best, sizeof(ycLiteral_t));
+    anchor->id = id;
+    anchor->caseless = ps.caseless;
+    anchor->next = -1;
+
+    return TRUE;
+}
+
+/**
+ * ycPrefilterBuild
+ *
+ *
+ *
+ */
+void ycPrefilterBuild(
+    ycPrefilter_t      *pf)
+{
+    unsigned int  i, j, c;
+    unsigned int  nc, maxStates;
+    uint32_t      s, t, f;
+    uint32_t     *fail;
+    uint32_t     *queue;
+    unsigned int  head, tail;
+    ycAnchor_t   *anchor;
+
+    /* one class for every folded octet used by an anchor, and class 0 for
+     * all the rest */
+    memset(pf->classMap, 0, sizeof(pf->classMap));
+    nc = 1;
+    maxStates = 1;
+    for (i = 0; i < pf->numAnchors; i++) {
+        anchor = &pf->anchors[i];
+        maxStates += anchor->lit.len;
+        for (j = 0; j < anchor->lit.len; j++) {
+            c = YC_FOLD(anchor->lit.str[j]);
+            if (pf->classMap[c] == 0) {
+                pf->classMap[c] = nc;
+                if (c >= 'a' && c <= 'z') {
+                    pf->classMap[c - 32] = nc;
+                }
+                nc++;
+            }
+        }
+    }
+    pf->numClasses = nc;
+
+    /* the trie; 0 means no edge since nothing leads back to the root */
+    pf->delta = g_new0(uint32_t, (size_t)maxStates * nc);
+    pf->match = g_new(int, maxStates);
+    pf->outLink = g_new0(uint32_t, maxStates);
+    pf->match[0] = -1;
+    pf->numStates = 1;
+    for (i = 0; i < pf->numAnchors; i++) {
+        anchor = &pf->anchors[i];
+        s = 0;
+        for (j = 0; j < anchor->lit.len; j++) {
+            c = pf->classMap[anchor->lit.str[j]];
+            if (pf->delta[s * nc + c] == 0) {
+                t = pf->numStates++;
+                pf->match[t] = -1;
+                pf->delta[s * nc + c] = t;
+            }
+            s = pf->delta[s * nc + c];
+        }
+        anchor->next = pf->match[s];
+        pf->match[s] = i;
+    }
+
+    /* breadth first, turn the trie into a complete automaton */
+    fail = g_new0(uint32_t, pf->numStates);
+    queue = g_new(uint32_t, pf->numStates);
+    head = tail = 0;
+    for (c = 0; c < nc; c++) {
+        if ((t = pf->delta[c])) {
+            fail[t] = 0;
+            queue[tail++] = t;
+        }
+    }
+    while (head < tail) {
+        s = queue[head++];
+        for (c = 0; c < nc; c++) {
+            t = pf->delta[s * nc + c];
+            if (t) {
+                f = pf->delta[fail[s] * nc + c];
+                fail[t] = f;
+                pf->outLink[t] = (pf->match[f] >= 0) ? f : pf->outLink[f];
+                queue[tail++] = t;
+            } else {
+                pf->delta[s * nc + c] = pf->delta[fail[s] * nc + c];
+            }
+        }
+    }
+
+    g_free(queue);
+    g_free(fail);
+}
+
+/**
+ * ycPrefilterScan
+ *
+ *
+ *
+ */
+void ycPrefilterScan(
+    const ycPrefilter_t *pf,
+    const uint8_t      *data,
+    size_t              len,
+    uint8_t            *candidates)
+{
+    const ycAnchor_t *anchor;
+    unsigned int      remaining = pf->numAnchors;
+    unsigned int      nc = pf->numClasses;
+    uint32_t          s = 0;
+    uint32_t          t;
+    size_t            i;
+    int               a;
+
+    memcpy(candidates, pf->always, YC_PREFILTER_BITMAP_SIZE(pf->maxIds));
+
+    for (i = 0; i < len && remaining; i++) {
+        s = pf->delta[s * nc + pf->classMap[data[i]]];
+        t = (pf->match[s] >= 0) ? s : pf->outLink[s];
+        for (; t; t = pf->outLink[t]) {
+            for (a = pf->match[t]; a >= 0; a = anchor->next) {
+                anchor = &pf->anchors[a];
+                if (YC_PREFILTER_ISSET(candidates, anchor->id)) {
+                    continue;
+                }
+                if (!anchor->caseless &&
+                    memcmp(data + i + 1 - anchor->lit.len, anchor->lit.str,
+                           anchor->lit.len))
+                {
+                    continue;
+                }
+                candidates[anchor->id >> 3] |= (1 << (anchor->id & 7));
+                remaining--;
+            }
+        }
+    }
+}
+
+/**
+ * ycPrefilterCount
+ *
+ *
+ *
+ */
+unsigned int ycPrefilterCount(
+    const ycPrefilter_t *pf)
+{
+    return pf->numAnchors;
+}
+
+/**
+ * ycPrefilterFree
+ *
+ *
+ *
+ */
+void ycPrefilterFree(
+    ycPrefilter_t      *pf)
+{
+    if (NULL == pf) {
+        return;
+    }
+    g_free(pf->outLink);
+    g_free(pf->match);
+    g_free(pf->delta);
+    g_free(pf->anchors);
+    g_free(pf->always);
+    g_free(pf);
+}
+
+/**
+ * ycRuleStatsEnable
+ *
+ *
+ *
+ */
+void ycRuleStatsEnable(
+    void)
+{
+    ycRuleStatsEnabled = TRUE;
+}
+
+/**
+ * ycRuleStatsClock
+ *
+ *
+ *
+ */
+uint64_t ycRuleStatsClock(
+    void)
+{
+    struct timespec ts;
+
+    if (!ycRuleStatsEnabled) {
+        return 0;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+/**
+ * ycRuleStatsCounts
+ *
+ * returns the calling thread's counters for a rule, numbering the rule and
+ * growing the thread's table as needed
+ *
+ */
+static ycRuleCounts_t *ycRuleStatsCounts(
+    ycRuleStats_t      *stats)
+{
+    ycRuleStatsTable_t *table = ycRuleStatsMine;
+    unsigned int        id;
+    unsigned int        unset = 0;
+    unsigned int        size;
+
+    id = __atomic_load_n(&stats->id, __ATOMIC_RELAXED);
+    if (0 == id) {
+        /* another thread may number the rule first */
+        id = __atomic_add_fetch(&ycRuleStatsLastId, 1, __ATOMIC_RELAXED);
+        if (!__atomic_compare_exchange_n(&stats->id, &unset, id, FALSE,
+                                         __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+        {
+            id = unset;
+        }
+    }
+
+    if (NULL == table || id >= table->size) {
+        pthread_mutex_lock(&ycRuleStatsLock);
+        if (NULL == table) {
+            table = g_new0(ycRuleStatsTable_t, 1);
+            table->next = ycRuleStatsTables;
+            ycRuleStatsTables = table;
+            ycRuleStatsMine = table;
+        }
+        /* make room for every rule numbered so far */
+        size = __atomic_load_n(&ycRuleStatsLastId, __ATOMIC_RELAXED) + 1;
+        table->counts = g_renew(ycRuleCounts_t, table->counts, size);
+        memset(table->counts + table->size, 0,
+               (size - table->size) * sizeof(ycRuleCounts_t));
+        table->size = size;
+        pthread_mutex_unlock(&ycRuleStatsLock);
+    }
+
+    return &table->counts[id];
+}
+
+/**
+ * ycRuleStatsRecord
+ *
+ *
+ *
+ */
+void ycRuleStatsRecord(
+    ycRuleStats_t      *stats,
+    uint64_t            start,
+    gboolean            hit)
+{
+    ycRuleCounts_t     *counts;
+
+    if (!ycRuleStatsEnabled) {
+        return;
+    }
+
+    counts = ycRuleStatsCounts(stats);
+    ++counts->runs;
+    if (hit) {
+        ++counts->hits;
+    }
+    counts->nsec += ycRuleStatsClock() - start;
+}
+
+/**
+ * ycRuleStatsSkip
+ *
+ *
+ *
+ */
+void ycRuleStatsSkip(
+    ycRuleStats_t      *stats)
+{
+    if (!ycRuleStatsEnabled) {
+        return;
+    }
+
+    ++ycRuleStatsCounts(stats)->skips;
+}
+
+/**
+ * ycRuleStatsLog
+ *
+ *
+ *
+ */
+void ycRuleStatsLog(
+    const char         *what,
+    uint16_t            label,
+    unsigned int        rule,
+    const ycRuleStats_t *stats)
+{
+    ycRuleStatsTable_t *table;
+    ycRuleCounts_t      sum;
+
+    if (!ycRuleStatsEnabled || 0 == stats->id) {
+        return;
+    }
+
+    memset(&sum, 0, sizeof(sum));
+    pthread_mutex_lock(&ycRuleStatsLock);
+    for (table = ycRuleStatsTables; table; table = table->next) {
+        if (stats->id < table->size) {
+            sum.runs += table->counts[stats->id].runs;
+            sum.hits += table->counts[stats->id].hits;
+            sum.skips += table->counts[stats->id].skips;
+            sum.nsec += table->counts[stats->id].nsec;
+        }
+    }
+    pthread_mutex_unlock(&ycRuleStatsLock);
+
+    if (!sum.runs && !sum.skips) {
+        return;
+    }
+
+    g_debug("%s rule %u (label %u): %"PRIu64" runs, %"PRIu64" hits, "
+            "%"PRIu64" misses, %"PRIu64" skipped, %.3f ms", what, rule,
+            label, sum.runs, sum.hits, sum.runs - sum.hits,
+            sum.skips, (double)sum.nsec / 1000000.0);
+}
+
+#endif /* YAF_ENABLE_APPLABEL */
@@ -0,0 +1,227 @@
+/**
+ *@internal
+ *
+ *@file prefilter.h
+ *
+ * a multi-pattern literal prefilter for the regular expression rules
+ * used by the application labeler and the DPI plugin
+ *
+ ** ------------------------------------------------------------------------
+ ** Copyright (C) 2007-2016 Carnegie Mellon University. All Rights Reserved.
+ ** ------------------------------------------------------------------------
+ **
+ ** @OPENSOURCE_HEADER_START@
+ ** Use of the YAF system and related source code is subject to the terms
+ ** of the following licenses:
+ **
+ ** GNU Public License (GPL) Rights pursuant to Version 2, June 1991
+ ** Government Purpose License Rights (GPLR) pursuant to DFARS 252.227.7013
+ **
+ ** NO WARRANTY
+ **
+ ** ANY INFORMATION, MATERIALS, SERVICES, INTELLECTUAL PROPERTY OR OTHER
+ ** PROPERTY OR RIGHTS GRANTED OR PROVIDED BY CARNEGIE MELLON UNIVERSITY
+ ** PURSUANT TO THIS LICENSE (HEREINAFTER THE "DELIVERABLES") ARE ON AN
+ ** "AS-IS" BASIS. CARNEGIE MELLON UNIVERSITY MAKES NO WARRANTIES OF ANY
+ ** KIND, EITHER EXPRESS OR IMPLIED AS TO ANY MATTER INCLUDING, BUT NOT
+ ** LIMITED TO, WARRANTY OF FITNESS FOR A PARTICULAR PURPOSE,
+ ** MERCHANTABILITY, INFORMATIONAL CONTENT, NONINFRINGEMENT, OR ERROR-FREE
+ ** OPERATION. CARNEGIE MELLON UNIVERSITY SHALL NOT BE LIABLE FOR INDIRECT,
+ ** SPECIAL OR CONSEQUENTIAL DAMAGES, SUCH AS LOSS OF PROFITS OR INABILITY
+ ** TO USE SAID INTELLECTUAL PROPERTY, UNDER THIS LICENSE, REGARDLESS OF
+ ** WHETHER SUCH PARTY WAS AWARE OF THE POSSIBILITY OF SUCH DAMAGES.
+ ** LICENSEE AGREES THAT IT WILL NOT MAKE ANY WARRANTY ON BEHALF OF
+ ** CARNEGIE MELLON UNIVERSITY, EXPRESS OR IMPLIED, TO ANY PERSON
+ ** CONCERNING THE APPLICATION OF OR THE RESULTS TO BE OBTAINED WITH THE
+ ** DELIVERABLES UNDER THIS LICENSE.
+ **
+ ** Licensee hereby agrees to defend, indemnify, and hold harmless Carnegie
+ ** Mellon University, its trustees, officers, employees, and agents from
+ ** all claims or demands made against them (and any related losses,
+ ** expenses, or attorney's fees) arising out of, or relating to Licensee's
+ ** and/or its sub licensees' negligent use or willful misuse of or
+ ** negligent conduct or willful misconduct regarding the Software,
+ ** facilities, or other rights or assistance granted by Carnegie Mellon
+ ** University under this License, including, but not limited to, any
+ ** claims of product liability, personal injury, death, damage to
+ ** property, or violation of any laws or regulations.
+ **
+ ** Carnegie Mellon University Software Engineering Institute authored
+ ** documents are sponsored by the U.S. Department of Defense under
+ ** Contract FA8721-05-C-0003. Carnegie Mellon University retains
+ ** copyrights in all material produced under this contract. The U.S.
+ ** Government retains a non-exclusive, royalty-free license to publish or
+ ** reproduce these documents, or allow others to do so, for U.S.
+ ** Government purposes only pursuant to the copyright license under the
+ ** contract clause at 252.227.7013.
+ **
+ ** @OPENSOURCE_HEADER_END@
+ */
+
+#ifndef PREFILTER_H_
+#define PREFILTER_H_
+
+#define _YAF_SOURCE_
+#include <yaf/autoinc.h>
+
+/**
+ * A compiled set of literal anchors, one per rule at most.  Each anchor is
+ * a string that must appear in any payload the rule's regular expression
+ * can match, so a rule whose anchor is absent from a payload does not need
+ * to be run.  Rules with no usable anchor are always candidates.
+ */
+typedef struct ycPrefilter_st ycPrefilter_t;
+
+/** size in octets of a candidate bitmap holding rule ids below n */
+#define YC_PREFILTER_BITMAP_SIZE(n) (((n) + 7) / 8)
+
+/** TRUE if rule id is set in a candidate bitmap filled by ycPrefilterScan */
+#define YC_PREFILTER_ISSET(bm, id) ((bm)[(id) >> 3] & (1 << ((id) & 7)))
+
+/**
+ * Per-rule match counters.  Nothing is counted unless ycRuleStatsEnable()
+ * was called.  Each thread that runs rules keeps its own counters, which
+ * are found by the rule's id; ycRuleStatsLog() adds them up.  A zeroed
+ * ycRuleStats_t is ready for use.
+ */
+typedef struct ycRuleStats_st {
+    /** index of the rule's counters in each thread, 0 until first counted */
+    unsigned int        id;
+} ycRuleStats_t;
+
+/**
+ * ycPrefilterAlloc
+ *
+ * @param maxIds one more than the largest rule id that will be added
+ *
+ * @return a new, empty prefilter
+ */
+ycPrefilter_t *ycPrefilterAlloc(
+    unsigned int        maxIds);
+
+/**
+ * ycPrefilterAddRegex
+ *
+ * Extracts the longest literal string that every match of regex must
+ * contain and adds it to the prefilter under the given rule id.  If no
+ * such literal can be found, the rule is marked as always a candidate.
+ *
+ * @param pf prefilter, not yet built
+ * @param id rule id, less than the maxIds given to ycPrefilterAlloc
+ * @param regex the PCRE source of the rule
+ *
+ * @return TRUE if a literal anchor was found for the rule
+ */
+gboolean ycPrefilterAddRegex(
+    ycPrefilter_t      *pf,
+    unsigned int        id,
+    const char         *regex);
+
+/**
+ * ycPrefilterBuild
+ *
+ * Compiles the anchors added so far into an Aho-Corasick automaton.  Must
+ * be called once after the last ycPrefilterAddRegex and before the first
+ * ycPrefilterScan.
+ *
+ * @param pf prefilter
+ */
+void ycPrefilterBuild(
+    ycPrefilter_t      *pf);
+
+/**
+ * ycPrefilterScan
+ *
+ * Finds the rules that may match the given data.  This does not modify the
+ * prefilter and may be called from several threads at once.
+ *
+ * @param pf built prefilter
+ * @param data payload to scan
+ * @param len length of data
+ * @param candidates bitmap of YC_PREFILTER_BITMAP_SIZE(maxIds) octets, set
+ *        on return to the ids of the rules that need to be run
+ */
+void ycPrefilterScan(
+    const ycPrefilter_t *pf,
+    const uint8_t      *data,
+    size_t              len,
+    uint8_t            *candidates);
+
+/**
+ * ycPrefilterCount
+ *
+ * @param pf prefilter
+ *
+ * @return the number of rules that have a literal anchor
+ */
+unsigned int ycPrefilterCount(
+    const ycPrefilter_t *pf);
+
+/**
+ * ycPrefilterFree
+ *
+ * @param pf prefilter to free, may be NULL
+ */
+void ycPrefilterFree(
+    ycPrefilter_t      *pf);
+
+/**
+ * ycRuleStatsEnable
+ *
+ * Starts counting rule runs, hits, skips, and time.  Call this before any
+ * rules are run.
+ */
+void ycRuleStatsEnable(
+    void);
+
+/**
+ * ycRuleStatsClock
+ *
+ * @return a monotonic timestamp in nanoseconds for ycRuleStatsRecord, or 0
+ *         if statistics are not enabled
+ */
+uint64_t ycRuleStatsClock(
+    void);
+
+/**
+ * ycRuleStatsRecord
+ *
+ * Counts one run of a rule that started at the given ycRuleStatsClock time.
+ *
+ * @param stats counters of the rule
+ * @param start timestamp taken before the rule was run
+ * @param hit TRUE if the rule matched
+ */
+void ycRuleStatsRecord(
+    ycRuleStats_t      *stats,
+    uint64_t            start,
+    gboolean            hit);
+
+/**
+ * ycRuleStatsSkip
+ *
+ * Counts one run of a rule avoided by the prefilter.
+ *
+ * @param stats counters of the rule
+ */
+void ycRuleStatsSkip(
+    ycRuleStats_t      *stats);
+
+/**
+ * ycRuleStatsLog
+ *
+ * Logs the counters of a rule summed over all threads, if it was ever
+ * considered.  Call this once the threads that run rules are idle.
+ *
+ * @param what name of the rule set the rule belongs to
+ * @param label application label of the rule
+ * @param rule position of the rule in its rule set
+ * @param stats counters of the rule
+ */
+void ycRuleStatsLog(
+    const char         *what,
+    uint16_t            label,
+    unsigned int        rule,
+    const ycRuleStats_t *stats);
+
+#endif
@@ -58,6 +58,9 @@
 
 #define _YAF_SOURCE_
 #include <yaf/ring.h>
+#if YAF_RING_THREAD
+#include <pthread.h>
+#endif
 
 struct rgaRing_st {
     size_t          elt_sz;
@@ -71,9 +74,10 @@ struct rgaRing_st {
     uint8_t         *head;
     uint8_t         *tail;
 #if YAF_RING_THREAD
-    GMutex          *mtx;
-    GCond           *cnd_zero;
-    GCond           *cnd_full;
+    gboolean        threaded;
+    pthread_mutex_t mtx;
+    pthread_cond_t  cnd_zero;
+    pthread_cond_t  cnd_full;
     uint32_t        interrupt;
 #endif
 };
@@ -127,10 +131,11 @@ rgaRing_t *rgaAllocThreaded(
 {
     rgaRing_t        *ring = rgaAlloc(elt_sz, cap);
 
-    /* allocate mutex and conditions */
-    ring->mtx = g_mutex_new();
-    ring->cnd_zero = g_cond_new();
-    ring->cnd_full = g_cond_new();
+    /* initialize mutex and conditions */
+    pthread_mutex_init(&ring->mtx, NULL);
+    pthread_cond_init(&ring->cnd_zero, NULL);
+    pthread_cond_init(&ring->cnd_full, NULL);
+    ring->threaded = TRUE;
 
     return ring;
 }
@@ -151,16 +156,10 @@ void rgaFree(
 
 #if YAF_RING_THREAD
     /* free conditions and mutex if present */
-    if (ring->cnd_zero) {
-        g_cond_free(ring->cnd_zero);
-    }
-
-    if (ring->cnd_full) {
-        g_cond_free(ring->cnd_full);
-    }
-
-    if (ring->mtx) {
-        g_mutex_free(ring->mtx);
+    if (ring->threaded) {
+        pthread_cond_destroy(&ring->cnd_zero);
+        pthread_cond_destroy(&ring->cnd_full);
+        pthread_mutex_destroy(&ring->mtx);
     }
 #endif
 
@@ -208,19 +207,22 @@ uint8_t *rgaNextHead(
 
 #if YAF_RING_THREAD
 /**
- * rgaNextHead
- *
+ * rgaWaitHead
  *
+ * Reserve the next head element, waiting for the consumer to free one
+ * if the ring is full.  The element is not visible to the consumer
+ * until it is released with rgaReleaseHead().  Returns NULL if the
+ * ring is interrupted.
  *
  */
-uint8_t *rgaNextHead(
+uint8_t *rgaWaitHead(
     rgaRing_t       *ring)
 {
     uint8_t         *head = NULL;
 
-    g_mutex_lock(ring->mtx);
+    pthread_mutex_lock(&ring->mtx);
     while (!ring->interrupt && ((head = rgaNextHead(ring)) == NULL)) {
-        g_cond_wait(ring->cnd_full, ring->mtx);
+        pthread_cond_wait(&ring->cnd_full, &ring->mtx);
     }
     if (ring->interrupt) {
         head = NULL;
@@ -229,9 +231,8 @@ uint8_t *rgaNextHead(
     if (++(ring->hrsv) > ring->cap) {
         ring->hrsv = ring->cap;
     }
-    g_cond_signal(ring->cnd_zero);
 end:
-    g_mutex_unlock(ring->mtx);
+    pthread_mutex_unlock(&ring->mtx);
     return head;
 }
 #endif
@@ -247,13 +248,14 @@ void rgaReleaseHead(
     rgaRing_t       *ring,
     size_t          rsv)
 {
-    g_mutex_lock(ring->mtx);
+    pthread_mutex_lock(&ring->mtx);
     if (rsv > ring->hrsv) {
         rsv = ring->hrsv;
     }
     ring->hrsv -= rsv;
-    g_cond_signal(ring->cnd_full);
-    g_mutex_unlock(ring->mtx);
+    /* released elements are now available to the consumer */
+    pthread_cond_signal(&ring->cnd_zero);
+    pthread_mutex_unlock(&ring->mtx);
 }
 #endif
 
@@ -289,6 +291,33 @@ uint8_t *rgaNextTail(
     return tail;
 }
 
+/**
+ * rgaPeekTail
+ *
+ * Return the element off places behind the tail without consuming it,
+ * or NULL if the ring does not hold that many elements.
+ *
+ */
+uint8_t *rgaPeekTail(
+    rgaRing_t       *ring,
+    size_t          off)
+{
+    uint8_t         *elt;
+
+    /* return null if element not yet available */
+    if (ring->count <= ring->hrsv + off) {
+        return NULL;
+    }
+
+    /* step forward from tail pointer and wrap */
+    elt = ring->tail + (ring->elt_sz * off);
+    if (elt > ring->end) {
+        elt -= ring->elt_sz * ring->cap;
+    }
+
+    return elt;
+}
+
 #if YAF_RING_THREAD
 /**
  * rgaWaitTail
@@ -301,9 +330,9 @@ uint8_t *rgaWaitTail(
 {
     uint8_t         *tail = NULL;
 
-    g_mutex_lock(ring->mtx);
+    pthread_mutex_lock(&ring->mtx);
     while (!ring->interrupt && ((tail = rgaNextTail(ring)) == NULL)) {
-        g_cond_wait(ring->cnd_zero, ring->mtx);
+        pthread_cond_wait(&ring->cnd_zero, &ring->mtx);
     }
     if (ring->interrupt) {
         tail = NULL;
@@ -312,9 +341,8 @@ uint8_t *rgaWaitTail(
     if (++(ring->trsv) >= ring->cap) {
         ring->trsv = ring->cap;
     }
-    g_cond_signal(ring->cnd_full);
 end:
-    g_mutex_unlock(ring->mtx);
+    pthread_mutex_unlock(&ring->mtx);
     return tail;
 }
 #endif
@@ -330,13 +358,14 @@ void rgaReleaseTail(
     rgaRing_t       *ring,
     size_t          rsv)
 {
-    g_mutex_lock(ring->mtx);
+    pthread_mutex_lock(&ring->mtx);
     if (rsv > ring->trsv) {
         rsv = ring->trsv;
     }
     ring->trsv -= rsv;
-    g_cond_signal(ring->cnd_zero);
-    g_mutex_unlock(ring->mtx);
+    /* released elements may now be reused by the producer */
+    pthread_cond_signal(&ring->cnd_full);
+    pthread_mutex_unlock(&ring->mtx);
 }
 #endif
 
@@ -350,11 +379,11 @@ void rgaReleaseTail(
 void rgaSetInterrupt(
     rgaRing_t       *ring)
 {
-    g_mutex_lock(ring->mtx);
+    pthread_mutex_lock(&ring->mtx);
     ++(ring->interrupt);
-    g_cond_broadcast(ring->cnd_zero);
-    g_cond_broadcast(ring->cnd_full);
-    g_mutex_unlock(ring->mtx);
+    pthread_cond_broadcast(&ring->cnd_zero);
+    pthread_cond_broadcast(&ring->cnd_full);
+    pthread_mutex_unlock(&ring->mtx);
 }
 #endif
 
@@ -368,9 +397,9 @@ void rgaSetInterrupt(
 void rgaClearInterrupt(
     rgaRing_t       *ring)
 {
-    g_mutex_lock(ring->mtx);
+    pthread_mutex_lock(&ring->mtx);
     --(ring->interrupt);
-    g_mutex_unlock(ring->mtx);
+    pthread_mutex_unlock(&ring->mtx);
 }
 #endif
 
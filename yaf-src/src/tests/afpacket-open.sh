@@ -0,0 +1,52 @@
+#!/bin/sh
+##
+## afpacket-open.sh
+## Smoke test: open an AF_PACKET capture ring on the loopback interface
+## with a BPF filter, capture briefly, and shut down cleanly.
+##
+## Skipped (exit 77) when yaf was built without AF_PACKET support or the
+## caller lacks CAP_NET_RAW.
+##
+
+YAF=${1:-./yaf}
+
+if ! "$YAF" --version 2>&1 | grep 'AF_PACKET support: *YES' >/dev/null
+then
+    echo "SKIP: yaf built without AF_PACKET support"
+    exit 77
+fi
+
+# CAP_NET_RAW is capability 13
+capeff=`sed -n 's/^CapEff:[ 	]*//p' /proc/self/status 2>/dev/null`
+if [ -z "$capeff" ] || [ $(( (0x$capeff >> 13) & 1 )) -eq 0 ]; then
+    echo "SKIP: CAP_NET_RAW required to open a packet socket"
+    exit 77
+fi
+
+tmpdir=`mktemp -d "${TMPDIR:-/tmp}/yafafp.XXXXXX"` || exit 1
+trap 'rm -rf "$tmpdir"' 0
+
+"$YAF" --live afpacket --in lo --filter icmp --out "$tmpdir/out.yaf" \
+    --log "$tmpdir/yaf.log" &
+pid=$!
+
+sleep 1
+ping -c 3 -i 0.2 127.0.0.1 >/dev/null 2>&1
+sleep 1
+kill -TERM $pid
+wait $pid
+status=$?
+
+if [ $status -ne 0 ]; then
+    echo "FAIL: yaf exited with status $status"
+    cat "$tmpdir/yaf.log"
+    exit 1
+fi
+if [ ! -s "$tmpdir/out.yaf" ]; then
+    echo "FAIL: yaf wrote no output"
+    cat "$tmpdir/yaf.log"
+    exit 1
+fi
+
+echo "PASS: AF_PACKET open/close on lo"
+exit 0
@@ -69,6 +69,8 @@
 #include "yafcap.h"
 #include "yafstat.h"
 #include "yafctx.h"
+#include "yafthread.h"
+#include "yafinspect.h"
 #if YAF_ENABLE_DAG
 #include "yafdag.h"
 #endif
@@ -81,8 +83,12 @@
 #if YAF_ENABLE_PFRING
 #include "yafpfring.h"
 #endif
+#if YAF_ENABLE_AFPACKET
+#include "yafafpacket.h"
+#endif
 #if YAF_ENABLE_APPLABEL
 #include "yafapplabel.h"
+#include "applabel/prefilter.h"
 #endif
 #if YAF_ENABLE_HOOKS
 #include <yaf/yafhooks.h>
@@ -121,8 +127,11 @@ static char         *yaf_opt_spread_groupby = 0;
 static int          yaf_opt_idle = 300;
 static int          yaf_opt_active = 1800;
 static int          yaf_opt_max_flows = 0;
+static int          yaf_opt_threads = 1;
 static int          yaf_opt_max_payload = 0;
 static int          yaf_opt_payload_export = 0;
+static int          yaf_opt_inspect_threads = 0;
+static gboolean     yaf_opt_inspect_ordered = FALSE;
 static gboolean     yaf_opt_payload_export_on = FALSE;
 static gboolean     yaf_opt_applabel_mode = FALSE;
 static gboolean     yaf_opt_force_read_all = FALSE;
@@ -220,7 +229,7 @@ AirOptionEntry yaf_optent_core[] = {
     AF_OPTION( "live", 'P', 0, AF_OPT_TYPE_STRING, &yaf_config.livetype,
                THE_LAME_80COL_FORMATTER_STRING"Capture from interface in -i; "
                "type is "THE_LAME_80COL_FORMATTER_STRING"[pcap], dag, "
-               "napatech, netronome, pfring, zc", "type"),
+               "napatech, netronome, pfring, zc, afpacket", "type"),
     AF_OPTION( "filter", 'F', 0, AF_OPT_TYPE_STRING, &yaf_config.bpf_expr,
                THE_LAME_80COL_FORMATTER_STRING"BPF filtering expression",
                "expression"),
@@ -292,6 +301,9 @@ AirOptionEntry yaf_optent_flow[] = {
     AF_OPTION( "max-flows", (char)0, 0, AF_OPT_TYPE_INT, &yaf_opt_max_flows,
                THE_LAME_80COL_FORMATTER_STRING"Maximum size of flow table [0]",
                "flows" ),
+    AF_OPTION( "threads", (char)0, 0, AF_OPT_TYPE_INT, &yaf_opt_threads,
+               THE_LAME_80COL_FORMATTER_STRING"Number of flow table worker "
+               "threads [1]", "count" ),
     AF_OPTION( "udp-temp-timeout", (char)0, 0, AF_OPT_TYPE_INT,
                &yaf_opt_udp_temp_timeout,
                THE_LAME_80COL_FORMATTER_STRING"UDP template timeout period "
@@ -463,6 +475,14 @@ AirOptionEntry yaf_optent_payload[] = {
               "headers for"THE_LAME_80COL_FORMATTER_STRING"external OS "
               "fingerprinters", NULL ),
 #endif
+    AF_OPTION( "inspect-threads", (char)0, 0, AF_OPT_TYPE_INT,
+               &yaf_opt_inspect_threads, THE_LAME_80COL_FORMATTER_STRING
+               "Number of threads for payload inspection"
+               THE_LAME_80COL_FORMATTER_STRING"of closed flows [0]", "count"),
+    AF_OPTION( "inspect-ordered", (char)0, 0, AF_OPT_TYPE_NONE,
+               &yaf_opt_inspect_ordered, THE_LAME_80COL_FORMATTER_STRING
+               "Export inspected flows in the order they"
+               THE_LAME_80COL_FORMATTER_STRING"were closed", NULL),
     AF_OPTION_END
 };
 #endif
@@ -551,6 +571,14 @@ static GString *yfVersionString(
                            "YES"
 #else
                            "NO"
+#endif
+                           );
+    g_string_append_printf(resultString,"    * %-32s  %s\n",
+                           "AF_PACKET support:",
+#if YAF_ENABLE_AFPACKET
+                           "YES"
+#else
+                           "NO"
 #endif
                            );
     g_string_append_printf(resultString,"    * %-32s  %s\n",
@@ -983,6 +1011,7 @@ static void yfLuaLoadConfig(
     yf_lua_getnum("egress", yaf_opt_egress_int);
     yf_lua_getnum("obdomain", yaf_config.odid);
     yf_lua_getnum("maxflows", yaf_opt_max_flows);
+    yf_lua_getnum("threads", yaf_opt_threads);
     yf_lua_getnum("maxfrags", yaf_opt_max_frags);
     yf_lua_getnum("idle_timeout", yaf_opt_idle);
     yf_lua_getnum("active_timeout", yaf_opt_active);
@@ -991,6 +1020,8 @@ static void yfLuaLoadConfig(
     yf_lua_getbool("export_payload", yaf_opt_payload_export_on);
     yf_lua_getnum("udp_uniflow", yaf_opt_udp_uniflow_port);
     yf_lua_getbool("udp_payload", yaf_opt_udp_max_payload);
+    yf_lua_getnum("inspect_threads", yaf_opt_inspect_threads);
+    yf_lua_getbool("inspect_ordered", yaf_opt_inspect_ordered);
 
     /* decode options */
     lua_getglobal(L, "decode");
@@ -1184,6 +1215,10 @@ static void yfParseOptions(
     }
 
 #if YAF_ENABLE_APPLABEL
+    /* per-rule statistics are only logged at debug level */
+    if (logc_level_enabled(G_LOG_LEVEL_DEBUG)) {
+        ycRuleStatsEnable();
+    }
     if (yaf_opt_applabel_rules && (FALSE == yaf_opt_applabel_mode)) {
         g_warning("--applabel-rules requires --applabel.");
         g_warning("application labeling engine will not operate");
@@ -1239,6 +1274,21 @@ static void yfParseOptions(
         }
     }
 
+    if (yaf_opt_inspect_threads < 0 ||
+        yaf_opt_inspect_threads > YF_INSPECT_MAX)
+    {
+        air_opterr("--inspect-threads must be between 0 and %d",
+                   YF_INSPECT_MAX);
+    }
+    if (yaf_opt_inspect_threads && yaf_opt_max_payload == 0) {
+        g_warning("--inspect-threads requires --max-payload.");
+        yaf_opt_inspect_threads = 0;
+    }
+    if (yaf_opt_inspect_ordered && !yaf_opt_inspect_threads) {
+        g_warning("--inspect-ordered requires --inspect-threads.");
+        yaf_opt_inspect_ordered = FALSE;
+    }
+
 #ifdef YAF_ENABLE_HOOKS
     if (NULL != pluginName && !hooks_initialized) {
         pluginOptParse(&err);
@@ -1365,6 +1415,17 @@ static void yfParseOptions(
             yaf_config.pcapdir = NULL;
           }
 #endif
+#endif
+#if YAF_ENABLE_AFPACKET
+        } else if (strncmp(yaf_config.livetype, "afpacket", 8) == 0) {
+            /* live capture via AF_PACKET ring (--live=afpacket) */
+            yaf_liveopen_fn = (yfLiveOpen_fn)yfAfPacketOpenLive;
+            yaf_loop_fn = (yfLoop_fn)yfAfPacketMain;
+            yaf_close_fn = (yfClose_fn)yfAfPacketClose;
+            if (yaf_config.pcapdir) {
+                g_warning("--pcap not valid for --live afpacket");
+                yaf_config.pcapdir = NULL;
+            }
 #endif
         } else {
             /* unsupported live capture type */
@@ -1596,10 +1657,29 @@ static void yfParseOptions(
         }
     }
 
+    if (yaf_opt_threads < 1 || yaf_opt_threads > YF_THREADS_MAX) {
+        air_opterr("--threads must be between 1 and %d", YF_THREADS_MAX);
+    }
+    if (yaf_opt_threads > 1) {
+        if (yaf_config.pcapdir) {
+            air_opterr("--pcap is not supported with --threads");
+        }
+        if (yaf_pcap_meta_file) {
+            air_opterr("--pcap-meta-file is not supported with --threads");
+        }
+    }
+
     if (yaf_opt_promisc) {
         yfSetPromiscMode(0);
+#if YAF_ENABLE_AFPACKET
+        yfAfPacketSetPromiscMode(0);
+#endif
     }
 
+#if YAF_ENABLE_AFPACKET
+    yfAfPacketSetFilter(yaf_config.bpf_expr);
+#endif
+
     if (yaf_daemon) {
         yfDaemonize();
     }
@@ -1765,6 +1845,49 @@ static void yfQuitInit()
     }
 }
 
+/**
+ * yfFlowTabAllocFromOptions
+ *
+ * allocates a flow table configured by the command line options
+ *
+ * @param max_flows flow limit of the table, or 0 for no limit
+ * @param inspect payload inspection threads for the flow table, or NULL
+ *
+ */
+static yfFlowTab_t *yfFlowTabAllocFromOptions(
+    uint32_t        max_flows,
+    yfInspect_t     *inspect)
+{
+    yfFlowTab_t     *flowtab;
+
+    flowtab = yfFlowTabAlloc(yaf_opt_idle * 1000,
+                             yaf_opt_active * 1000,
+                             max_flows,
+                             yaf_opt_max_payload,
+                             yaf_opt_uniflow_mode,
+                             yaf_opt_silk_mode,
+                             yaf_opt_mac_mode,
+                             yaf_opt_applabel_mode,
+                             yaf_opt_entropy_mode,
+                             yaf_opt_p0fprint_mode,
+                             yaf_opt_fpExport_mode,
+                             yaf_opt_udp_max_payload,
+                             yaf_opt_udp_uniflow_port,
+                             yaf_config.pcapdir,
+                             yaf_pcap_meta_file,
+                             yaf_config.max_pcap,
+                             yaf_config.pcap_per_flow,
+                             yaf_opt_force_read_all,
+                             yaf_opt_extra_stats_mode,
+                             yaf_index_pcap,
+                             yaf_hash_search,
+                             yaf_stime_search,
+                             yfctx);
+    yfFlowTabSetInspect(flowtab, inspect);
+
+    return flowtab;
+}
+
 /**
  *
  *
@@ -1778,6 +1901,7 @@ int main (
 {
     GError          *err = NULL;
     yfContext_t     ctx = YF_CTX_INIT;
+    yfInspect_t     *inspect = NULL;
     int             datalink;
     gboolean        loop_ok = TRUE;
 
@@ -1880,30 +2004,39 @@ int main (
     /* Set up decode context */
     ctx.dectx = yfDecodeCtxAlloc(datalink, yaf_reqtype, yaf_opt_gre_mode);
 
-    /* Set up flow table */
-    ctx.flowtab = yfFlowTabAlloc(yaf_opt_idle * 1000,
-                                 yaf_opt_active * 1000,
-                                 yaf_opt_max_flows,
-                                 yaf_opt_max_payload,
-                                 yaf_opt_uniflow_mode,
-                                 yaf_opt_silk_mode,
-                                 yaf_opt_mac_mode,
-                                 yaf_opt_applabel_mode,
-                                 yaf_opt_entropy_mode,
-                                 yaf_opt_p0fprint_mode,
-                                 yaf_opt_fpExport_mode,
-                                 yaf_opt_udp_max_payload,
-                                 yaf_opt_udp_uniflow_port,
-                                 yaf_config.pcapdir,
-                                 yaf_pcap_meta_file,
-                                 yaf_config.max_pcap,
-                                 yaf_config.pcap_per_flow,
-                                 yaf_opt_force_read_all,
-                                 yaf_opt_extra_stats_mode,
-                                 yaf_index_pcap,
-                                 yaf_hash_search,
-                                 yaf_stime_search,
-                                 yfctx);
+    /* Set up payload inspection threads, shared by all flow tables */
+    if (yaf_opt_inspect_threads) {
+        inspect = yfInspectAlloc(yaf_opt_inspect_threads,
+                                 yaf_opt_inspect_ordered, &(ctx.err));
+        if (!inspect) {
+            g_warning("yaf terminating on error: %s", ctx.err->message);
+            exit(1);
+        }
+    }
+
+    /* Set up flow table; with worker threads, it only keeps the totals,
+     * so it is left unlimited rather than reserving nodes and sizing its
+     * hash for a flow limit it never holds */
+    if (yaf_opt_threads > 1) {
+        ctx.flowtab = yfFlowTabAllocFromOptions(0, inspect);
+    } else {
+        ctx.flowtab = yfFlowTabAllocFromOptions(yaf_opt_max_flows, inspect);
+    }
+
+    /* Set up flow table worker threads */
+    if (yaf_opt_threads > 1) {
+        yfFlowTab_t *tabs[YF_THREADS_MAX];
+        uint32_t    max_flows;
+        int         i;
+
+        /* each worker gets an equal share of the flow limit */
+        max_flows = ((yaf_opt_max_flows + yaf_opt_threads - 1)
+                     / yaf_opt_threads);
+        for (i = 0; i < yaf_opt_threads; i++) {
+            tabs[i] = yfFlowTabAllocFromOptions(max_flows, inspect);
+        }
+        ctx.threads = yfThreadsAlloc(&ctx, tabs, yaf_opt_threads);
+    }
 
     /* Set up fragment table - ONLY IF USER SAYS */
     if (!yaf_opt_nofrag) {
@@ -1917,17 +2050,32 @@ int main (
 
     yfStatInit(&ctx);
 
+    if (ctx.threads && !yfThreadsStart(&ctx, &(ctx.err))) {
+        g_warning("yaf terminating on error: %s", ctx.err->message);
+        exit(1);
+    }
+
     loop_ok = yaf_loop_fn(&ctx);
 
     yfStatComplete();
+#if YAF_ENABLE_APPLABEL
+    if (yaf_opt_applabel_mode) {
+        yfAppLabelDumpStats();
+    }
+#endif
+#if YAF_ENABLE_HOOKS
+    yfHookDumpStats(yfctx);
+#endif
 
     /* Close packet source */
     yaf_close_fn(ctx.pktsrc);
 
     /* Clean up! */
+    yfThreadsFree(&ctx);
     if (ctx.flowtab) {
         yfFlowTabFree(ctx.flowtab);
     }
+    yfInspectFree(inspect);
     if (ctx.fragtab) {
         yfFragTabFree(ctx.fragtab);
     }
@@ -0,0 +1,604 @@
+/*
+ ** yafafpacket.c
+ ** YAF AF_PACKET live input support
+ **
+ ** ------------------------------------------------------------------------
+ ** Copyright (C) 2006-2016 Carnegie Mellon University. All Rights Reserved.
+ ** ------------------------------------------------------------------------
+ ** @OPENSOURCE_HEADER_START@
+ ** Use of the YAF system and related source code is subject to the terms
+ ** of the following licenses:
+ **
+ ** GNU Public License (GPL) Rights pursuant to Version 2, June 1991
+ ** Government Purpose License Rights (GPLR) pursuant to DFARS 252.227.7013
+ **
+ ** NO WARRANTY
+ **
+ ** ANY INFORMATION, MATERIALS, SERVICES, INTELLECTUAL PROPERTY OR OTHER
+ ** PROPERTY OR RIGHTS GRANTED OR PROVIDED BY CARNEGIE MELLON UNIVERSITY
+ ** PURSUANT TO THIS LICENSE (HEREINAFTER THE "DELIVERABLES") ARE ON AN
+ ** "AS-IS" BASIS. CARNEGIE MELLON UNIVERSITY MAKES NO WARRANTIES OF ANY
+ ** KIND, EITHER EXPRESS OR IMPLIED AS TO ANY MATTER INCLUDING, BUT NOT
+ ** LIMITED TO, WARRANTY OF FITNESS FOR A PARTICULAR PURPOSE,
+ ** MERCHANTABILITY, INFORMATIONAL CONTENT, NONINFRINGEMENT, OR ERROR-FREE
+ ** OPERATION. CARNEGIE MELLON UNIVERSITY SHALL NOT BE LIABLE FOR INDIRECT,
+ ** SPECIAL OR CONSEQUENTIAL DAMAGES, SUCH AS LOSS OF PROFITS OR INABILITY
+ ** TO USE SAID INTELLECTUAL PROPERTY, UNDER THIS LICENSE, REGARDLESS OF
+ ** WHETHER SUCH PARTY WAS AWARE OF THE POSSIBILITY OF SUCH DAMAGES.
+ ** LICENSEE AGREES THAT IT WILL NOT MAKE ANY WARRANTY ON BEHALF OF
+ ** CARNEGIE MELLON UNIVERSITY, EXPRESS OR IMPLIED, TO ANY PERSON
+ ** CONCERNING THE APPLICATION OF OR THE RESULTS TO BE OBTAINED WITH THE
+ ** DELIVERABLES UNDER THIS LICENSE.
+ **
+ ** Licensee hereby agrees to defend, indemnify, and hold harmless Carnegie
+ ** Mellon University, its trustees, officers, employees, and agents from
+ ** all claims or demands made against them (and any related losses,
+ ** expenses, or attorney's fees) arising out of, or relating to Licensee's
+ ** and/or its sub licensees' negligent use or willful misuse of or
+ ** negligent conduct or willful misconduct regarding the Software,
+ ** facilities, or other rights or assistance granted by Carnegie Mellon
+ ** University under this License, including, but not limited to, any
+ ** claims of product liability, personal injury, death, damage to
+ ** property, or violation of any laws or regulations.
+ **
+ ** Carnegie Mellon University Software Engineering Institute authored
+ ** documents are sponsored by the U.S. Department of Defense under
+ ** Contract FA8721-05-C-0003. Carnegie Mellon University retains
+ ** copyrights in all material produced under this contract. The U.S.
+ ** Government retains a non-exclusive, royalty-free license to publish or
+ ** reproduce these documents, or allow others to do so, for U.S.
+ ** Government purposes only pursuant to the copyright license under the
+ ** contract clause at 252.227.7013.
+ **
+ ** @OPENSOURCE_HEADER_END@
+ ** ------------------------------------------------------------------------
+ */
+
+#define _YAF_SOURCE_
+#include <yaf/autoinc.h>
+
+#if YAF_ENABLE_AFPACKET
+#include "yafafpacket.h"
+#include "yafstat.h"
+#include "yaflush.h"
+#include <yaf/yafcore.h>
+#include <yaf/decode.h>
+#include <yaf/yafrag.h>
+#include <pcap.h>
+#include <poll.h>
+#include <net/if.h>
+#include <net/if_arp.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <linux/if_ether.h>
+#include <linux/if_packet.h>
+#include <linux/filter.h>
+
+/* Ring geometry: 64 blocks of 4 MiB */
+#define YF_AFP_BLOCK_SIZE       (1 << 22)
+#define YF_AFP_BLOCK_COUNT      64
+#define YF_AFP_FRAME_SIZE       (1 << 11)
+/* Hand a partly filled block to yaf after this many milliseconds */
+#define YF_AFP_BLOCK_TIMEOUT    60
+
+/* One second timeout for capture loop */
+#define YAF_CAP_TIMEOUT 1000
+
+/* Process at most 64 packets at once */
+#define YAF_CAP_COUNT   64
+
+struct yfAfPacketSource_st {
+    int                     fd;
+    uint8_t                 *map;
+    size_t                  map_sz;
+    int                     snaplen;
+    int                     datalink;
+    /* capturing on a loopback interface */
+    gboolean                loopback;
+    /* index of the block to read next */
+    unsigned int            block;
+    /* block being read, or NULL if waiting for the kernel */
+    struct tpacket_block_desc *cur;
+    /* next packet in the current block, and packets left in it */
+    struct tpacket3_hdr     *pkt;
+    uint32_t                left;
+};
+
+static int     yaf_promisc_mode = 1;
+static char    *yaf_afp_filter = NULL;
+
+/* Quit flag support */
+extern int yaf_quit;
+
+/* Statistics */
+static uint32_t            yaf_stats_out = 0;
+static uint64_t            yaf_afp_packets = 0;
+static uint64_t            yaf_afp_blocks = 0;
+static uint64_t            yaf_afp_drop = 0;
+static uint64_t            yaf_afp_freeze = 0;
+
+void yfAfPacketSetPromiscMode(
+    int              mode)
+{
+    yaf_promisc_mode = mode;
+}
+
+void yfAfPacketSetFilter(
+    char             *bpf_expr)
+{
+    yaf_afp_filter = bpf_expr;
+}
+
+/**
+ * yfAfPacketDatalink
+ *
+ * map the hardware type of an interface to a pcap datalink type
+ *
+ */
+static gboolean yfAfPacketDatalink(
+    int                     fd,
+    const char              *ifname,
+    int                     *datalink,
+    gboolean                *loopback,
+    GError                  **err)
+{
+    struct ifreq            ifr;
+
+    memset(&ifr, 0, sizeof(ifr));
+    g_strlcpy(ifr.ifr_name, ifname, sizeof(ifr.ifr_name));
+    if (ioctl(fd, SIOCGIFHWADDR, &ifr) < 0) {
+        g_set_error(err, YAF_ERROR_DOMAIN, YAF_ERROR_IO,
+                    "Couldn't get hardware type of %s: %s",
+                    ifname, strerror(errno));
+        return FALSE;
+    }
+
+    *loopback = (ifr.ifr_hwaddr.sa_family == ARPHRD_LOOPBACK);
+    switch (ifr.ifr_hwaddr.sa_family) {
+      case ARPHRD_ETHER:
+      case ARPHRD_LOOPBACK:
+        *datalink = DLT_EN10MB;
+        return TRUE;
+      case ARPHRD_NONE:
+        *datalink = DLT_RAW;
+        return TRUE;
+      default:
+        g_set_error(err, YAF_ERROR_DOMAIN, YAF_ERROR_IO,
+                    "Unsupported hardware type %d on %s",
+                    ifr.ifr_hwaddr.sa_family, ifname);
+        return FALSE;
+    }
+}
+
+/**
+ * yfAfPacketAttachFilter
+ *
+ * compile a BPF expression with libpcap and attach it to the socket
+ *
+ */
+static gboolean yfAfPacketAttachFilter(
+    yfAfPacketSource_t      *ps,
+    char                    *bp_filter,
+    GError                  **err)
+{
+    pcap_t                  *dead;
+    struct bpf_program      bpf;
+    struct sock_fprog       fprog;
+    int                     rv;
+
+    dead = pcap_open_dead(ps->datalink, ps->snaplen);
+    if (pcap_compile(dead, &bpf, bp_filter, 1, PCAP_NETMASK_UNKNOWN)) {
+        g_set_error(err, YAF_ERROR_DOMAIN, YAF_ERROR_ARGUMENT,
+                    "couldn't compile BPF expression %s: %s",
+                    bp_filter, pcap_geterr(dead));
+        pcap_close(dead);
+        return FALSE;
+    }
+
+    fprog.len = bpf.bf_len;
+    fprog.filter = (struct sock_filter *)bpf.bf_insns;
+    rv = setsockopt(ps->fd, SOL_SOCKET, SO_ATTACH_FILTER,
+                    &fprog, sizeof(fprog));
+    pcap_freecode(&bpf);
+    pcap_close(dead);
+
+    if (rv < 0) {
+        g_set_error(err, YAF_ERROR_DOMAIN, YAF_ERROR_ARGUMENT,
+                    "couldn't set BPF filter %s: %s",
+                    bp_filter, strerror(errno));
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+yfAfPacketSource_t *yfAfPacketOpenLive(
+    const char              *ifname,
+    int                     snaplen,
+    int                     *datalink,
+    GError                  **err)
+{
+    yfAfPacketSource_t      *ps = NULL;
+    struct tpacket_req3     req;
+    struct sockaddr_ll      sll;
+    struct packet_mreq      mreq;
+    gchar                   *name = NULL;
+    char                    *group = NULL;
+    char                    *ep = NULL;
+    unsigned long           fanout_id = 0;
+    uint32_t                fanout;
+    int                     version = TPACKET_V3;
+    int                     ifindex;
+
+    /* split off fanout group */
+    name = g_strdup(ifname);
+    if ((group = strrchr(name, ':'))) {
+        *group++ = '\0';
+        fanout_id = strtoul(group, &ep, 10);
+        if (!*group || *ep || fanout_id > 0xFFFF) {
+            g_set_error(err, YAF_ERROR_DOMAIN, YAF_ERROR_ARGUMENT,
+                        "Invalid fanout group \"%s\". "
+                        " Valid Form: -i [interface]:[0-65535]", group);
+            goto err;
+        }
+    }
+
+    if (!(ifindex = if_nametoindex(name))) {
+        g_set_error(err, YAF_ERROR_DOMAIN, YAF_ERROR_IO,
+                    "Couldn't find interface %s: %s", name, strerror(errno));
+        goto err;
+    }
+
+    ps = g_new0(yfAfPacketSource_t, 1);
+    ps->snaplen = snaplen;
+    ps->map = MAP_FAILED;
+
+    /* open with protocol 0 so that nothing is queued until the socket
+     * is bound, after the filter is attached */
+    if ((ps->fd = socket(AF_PACKET, SOCK_RAW, 0)) < 0) {
+        g_set_error(err, YAF_ERROR_DOMAIN, YAF_ERROR_IO,
+                    "Couldn't open packet socket: %s", strerror(errno));
+        goto err;
+    }
+
+    if (!yfAfPacketDatalink(ps->fd, name, datalink, &ps->loopback, err)) {
+        goto err;
+    }
+    ps->datalink = *datalink;
+
+    if (yaf_afp_filter) {
+        if (!yfAfPacketAttachFilter(ps, yaf_afp_filter, err)) {
+            goto err;
+        }
+    }
+
+    memset(&sll, 0, sizeof(sll));
+    sll.sll_family = AF_PACKET;
+    sll.sll_protocol = htons(ETH_P_ALL);
+    sll.sll_ifindex = ifindex;
+    if (bind(ps->fd, (struct sockaddr *)&sll, sizeof(sll)) < 0) {
+        g_set_error(err, YAF_ERROR_DOMAIN, YAF_ERROR_IO,
+                    "Couldn't bind to %s: %s", name, strerror(errno));
+        goto err;
+    }
+
+    if (setsockopt(ps->fd, SOL_PACKET, PACKET_VERSION,
+                   &version, sizeof(version)) < 0)
+    {
+        g_set_error(err, YAF_ERROR_DOMAIN, YAF_ERROR_IO,
+                    "Couldn't select TPACKET_V3: %s", strerror(errno));
+        goto err;
+    }
+
+    /* set up and map the receive ring */
+    memset(&req, 0, sizeof(req));
+    req.tp_block_size = YF_AFP_BLOCK_SIZE;
+    req.tp_block_nr = YF_AFP_BLOCK_COUNT;
+    req.tp_frame_size = YF_AFP_FRAME_SIZE;
+    req.tp_frame_nr = (YF_AFP_BLOCK_SIZE / YF_AFP_FRAME_SIZE) *
+                      YF_AFP_BLOCK_COUNT;
+    req.tp_retire_blk_tov = YF_AFP_BLOCK_TIMEOUT;
+    if (setsockopt(ps->fd, SOL_PACKET, PACKET_RX_RING,
+                   &req, sizeof(req)) < 0)
+    {
+        g_set_error(err, YAF_ERROR_DOMAIN, YAF_ERROR_IO,
+                    "Couldn't set up receive ring: %s", strerror(errno));
+        goto err;
+    }
+
+    ps->map_sz = (size_t)req.tp_block_size * req.tp_block_nr;
+    ps->map = mmap(NULL, ps->map_sz, PROT_READ | PROT_WRITE, MAP_SHARED,
+                   ps->fd, 0);
+    if (ps->map == MAP_FAILED) {
+        g_set_error(err, YAF_ERROR_DOMAIN, YAF_ERROR_IO,
+                    "Couldn't map receive ring: %s", strerror(errno));
+        goto err;
+    }
+
+    if (yaf_promisc_mode) {
+        memset(&mreq, 0, sizeof(mreq));
+        mreq.mr_ifindex = ifindex;
+        mreq.mr_type = PACKET_MR_PROMISC;
+        if (setsockopt(ps->fd, SOL_PACKET, PACKET_ADD_MEMBERSHIP,
+                       &mreq, sizeof(mreq)) < 0)
+        {
+            g_warning("Couldn't set %s promiscuous: %s",
+                      name, strerror(errno));
+        }
+    }
+
+    /* spread flows across the sockets in the group by flow hash */
+    if (group) {
+        fanout = (uint32_t)fanout_id |
+                 ((uint32_t)(PACKET_FANOUT_HASH |
+                             PACKET_FANOUT_FLAG_DEFRAG) << 16);
+        if (setsockopt(ps->fd, SOL_PACKET, PACKET_FANOUT,
+                       &fanout, sizeof(fanout)) < 0)
+        {
+            g_set_error(err, YAF_ERROR_DOMAIN, YAF_ERROR_IO,
+                        "Couldn't join fanout group %lu: %s",
+                        fanout_id, strerror(errno));
+            goto err;
+        }
+        g_debug("Joined AF_PACKET fanout group %lu on %s", fanout_id, name);
+    }
+
+    g_free(name);
+    return ps;
+
+  err:
+    if (ps) {
+        yfAfPacketClose(ps);
+    }
+    g_free(name);
+    return NULL;
+}
+
+void yfAfPacketClose(
+    yfAfPacketSource_t      *ps)
+{
+    if (ps->map != MAP_FAILED) {
+        munmap(ps->map, ps->map_sz);
+    }
+    if (ps->fd >= 0) {
+        close(ps->fd);
+    }
+    g_free(ps);
+}
+
+static void yfAfPacketUpdateStats(
+    yfAfPacketSource_t      *ps)
+{
+    struct tpacket_stats_v3 st;
+    socklen_t               len = sizeof(st);
+
+    /* the kernel clears its counters on each read */
+    if (getsockopt(ps->fd, SOL_PACKET, PACKET_STATISTICS, &st, &len) < 0) {
+        g_warning("couldn't get statistics: %s", strerror(errno));
+        return;
+    }
+
+    yaf_afp_drop += st.tp_drops;
+    yaf_afp_freeze += st.tp_freeze_q_cnt;
+}
+
+void yfAfPacketDumpStats() {
+
+    if (yaf_stats_out) {
+        g_debug("yaf Exported %u stats records.", yaf_stats_out);
+    }
+
+    if (yaf_afp_blocks) {
+        g_debug("AF_PACKET ring returned %"PRIu64" packets in %"PRIu64
+                " blocks (%.1f per block).", yaf_afp_packets, yaf_afp_blocks,
+                (double)yaf_afp_packets / yaf_afp_blocks);
+    }
+
+    if (yaf_afp_drop) {
+        g_warning("Live capture device dropped %"PRIu64" packets.",
+                  yaf_afp_drop);
+    }
+
+    if (yaf_afp_freeze) {
+        g_warning("AF_PACKET ring was full %"PRIu64" times.", yaf_afp_freeze);
+    }
+}
+
+/**
+ * yfAfPacketHandle
+ *
+ * decode one packet straight out of the receive ring
+ *
+ */
+static void yfAfPacketHandle(
+    yfContext_t             *ctx,
+    yfAfPacketSource_t      *ps,
+    struct tpacket3_hdr     *hdr)
+{
+    yfPBuf_t                *pbuf;
+    const uint8_t           *pkt = (const uint8_t *)hdr + hdr->tp_mac;
+    const struct sockaddr_ll *sll;
+    size_t                  caplen = hdr->tp_snaplen;
+    uint64_t                ptime;
+    yfIPFragInfo_t          fraginfo_buf,
+                            *fraginfo = ctx->fragtab ?
+                                        &fraginfo_buf : NULL;
+
+    /* on loopback each packet is seen both leaving and arriving; keep
+     * only the incoming copy, as libpcap does */
+    if (ps->loopback) {
+        sll = (const struct sockaddr_ll *)
+              ((const uint8_t *)hdr +
+               TPACKET_ALIGN(sizeof(struct tpacket3_hdr)));
+        if (sll->sll_pkttype == PACKET_OUTGOING) {
+            return;
+        }
+    }
+
+    /* get next spot in ring buffer */
+    pbuf = (yfPBuf_t *)rgaNextHead(ctx->pbufring);
+    g_assert(pbuf);
+
+    if (caplen > (size_t)ps->snaplen) {
+        caplen = ps->snaplen;
+    }
+    ptime = ((uint64_t)hdr->tp_sec * 1000) + (hdr->tp_nsec / 1000000);
+
+    /* Decode packet into packet buffer */
+    if (!yfDecodeToPBuf(ctx->dectx, ptime, caplen, pkt,
+                        fraginfo, ctx->pbuflen, pbuf))
+    {
+        /* Couldn't decode packet; counted in dectx. Skip. */
+        return;
+    }
+
+    /* the kernel strips the outer VLAN tag into the header */
+    if ((hdr->tp_status & TP_STATUS_VLAN_VALID) && !pbuf->key.vlanId) {
+        pbuf->key.vlanId = hdr->hv1.tp_vlan_tci & 0x0FFF;
+    }
+
+    /* Handle fragmentation if necessary */
+    if (fraginfo && fraginfo->frag) {
+        if (!yfDefragPBuf(ctx->fragtab, fraginfo,
+                          ctx->pbuflen, pbuf, pkt, caplen))
+        {
+            /* No complete defragmented packet available. Skip. */
+            return;
+        }
+    }
+}
+
+/**
+ * yfAfPacketRead
+ *
+ * decode up to max packets from the blocks the kernel has handed over,
+ * returning each block to the kernel once all of its packets are decoded.
+ * Returns the number of packets read.
+ *
+ */
+static uint32_t yfAfPacketRead(
+    yfContext_t             *ctx,
+    yfAfPacketSource_t      *ps,
+    uint32_t                max)
+{
+    struct tpacket_block_desc *bd;
+    uint32_t                count = 0;
+
+    while (count < max) {
+        if (!ps->cur) {
+            bd = (struct tpacket_block_desc *)
+                 (ps->map + ((size_t)ps->block * YF_AFP_BLOCK_SIZE));
+            if (!(__atomic_load_n(&(bd->hdr.bh1.block_status),
+                                  __ATOMIC_ACQUIRE) & TP_STATUS_USER))
+            {
+                break;
+            }
+            ps->cur = bd;
+            ps->left = bd->hdr.bh1.num_pkts;
+            ps->pkt = (struct tpacket3_hdr *)
+                      ((uint8_t *)bd + bd->hdr.bh1.offset_to_first_pkt);
+            ++yaf_afp_blocks;
+        }
+
+        if (ps->left) {
+            yfAfPacketHandle(ctx, ps, ps->pkt);
+            ps->pkt = (struct tpacket3_hdr *)
+                      ((uint8_t *)ps->pkt + ps->pkt->tp_next_offset);
+            --(ps->left);
+            ++count;
+        }
+
+        if (!ps->left) {
+            /* packets are decoded into the packet ring; the block is free */
+            __atomic_store_n(&(ps->cur->hdr.bh1.block_status),
+                             TP_STATUS_KERNEL, __ATOMIC_RELEASE);
+            ps->cur = NULL;
+            ps->block = (ps->block + 1) % YF_AFP_BLOCK_COUNT;
+        }
+    }
+
+    yaf_afp_packets += count;
+    return count;
+}
+
+gboolean yfAfPacketMain(
+    yfContext_t             *ctx)
+{
+    gboolean                ok = TRUE;
+    yfAfPacketSource_t      *ps = (yfAfPacketSource_t *)ctx->pktsrc;
+    GTimer                  *stimer = NULL;  /* to export stats */
+    struct pollfd           pfd;
+    int                     rv;
+
+    if (!ctx->cfg->nostats) {
+        stimer = g_timer_new();
+    }
+
+    /* process input until we're done */
+    while (!yaf_quit) {
+
+        if (!yfAfPacketRead(ctx, ps, YAF_CAP_COUNT)) {
+            /* wait for the kernel to retire a block */
+            pfd.fd = ps->fd;
+            pfd.events = POLLIN | POLLERR;
+            pfd.revents = 0;
+            rv = poll(&pfd, 1, YAF_CAP_TIMEOUT);
+            if (rv < 0 && errno != EINTR) {
+                g_set_error(&(ctx->err), YAF_ERROR_DOMAIN, YAF_ERROR_IO,
+                            "Couldn't poll packet socket: %s",
+                            strerror(errno));
+                ok = FALSE;
+                break;
+            }
+            if (rv == 0) {
+                /* Live, no packet processed (timeout). Flush buffer */
+                yfAfPacketUpdateStats(ps);
+                if (!yfTimeOutFlush(ctx, (uint32_t)yaf_afp_drop,
+                                    &yaf_stats_out,
+                                    yfStatGetTimer(), stimer,
+                                    &(ctx->err)))
+                {
+                    ok = FALSE;
+                    break;
+                }
+            }
+            continue;
+        }
+
+        /* Process the packet buffer */
+        if (!yfProcessPBufRing(ctx, &(ctx->err))) {
+            ok = FALSE;
+            break;
+        }
+
+        if (!ctx->cfg->nostats) {
+            if (g_timer_elapsed(stimer, NULL) > ctx->cfg->stats) {
+                yfAfPacketUpdateStats(ps);
+                if (!yfLockedWriteStatsFlow(ctx, (uint32_t)yaf_afp_drop,
+                                            yfStatGetTimer(), &(ctx->err)))
+                {
+                    ok = FALSE;
+                    break;
+                }
+                g_timer_start(stimer);
+                yaf_stats_out++;
+            }
+        }
+    }
+
+    yfAfPacketUpdateStats(ps);
+
+    if (!ctx->cfg->nostats) {
+        /* add one for final flush */
+        if (ok) yaf_stats_out++;
+        /* free timer */
+        g_timer_destroy(stimer);
+    }
+
+    /* Handle final flush */
+    return yfFinalFlush(ctx, ok, (uint32_t)yaf_afp_drop, yfStatGetTimer(),
+                        &(ctx->err));
+}
+
+#endif
@@ -0,0 +1,104 @@
+/*
+ ** yafafpacket.h
+ ** YAF AF_PACKET live input support
+ **
+ ** ------------------------------------------------------------------------
+ ** Copyright (C) 2006-2016 Carnegie Mellon University. All Rights Reserved.
+ ** ------------------------------------------------------------------------
+ ** @OPENSOURCE_HEADER_START@
+ ** Use of the YAF system and related source code is subject to the terms
+ ** of the following licenses:
+ **
+ ** GNU Public License (GPL) Rights pursuant to Version 2, June 1991
+ ** Government Purpose License Rights (GPLR) pursuant to DFARS 252.227.7013
+ **
+ ** NO WARRANTY
+ **
+ ** ANY INFORMATION, MATERIALS, SERVICES, INTELLECTUAL PROPERTY OR OTHER
+ ** PROPERTY OR RIGHTS GRANTED OR PROVIDED BY CARNEGIE MELLON UNIVERSITY
+ ** PURSUANT TO THIS LICENSE (HEREINAFTER THE "DELIVERABLES") ARE ON AN
+ ** "AS-IS" BASIS. CARNEGIE MELLON UNIVERSITY MAKES NO WARRANTIES OF ANY
+ ** KIND, EITHER EXPRESS OR IMPLIED AS TO ANY MATTER INCLUDING, BUT NOT
+ ** LIMITED TO, WARRANTY OF FITNESS FOR A PARTICULAR PURPOSE,
+ ** MERCHANTABILITY, INFORMATIONAL CONTENT, NONINFRINGEMENT, OR ERROR-FREE
+ ** OPERATION. CARNEGIE MELLON UNIVERSITY SHALL NOT BE LIABLE FOR INDIRECT,
+ ** SPECIAL OR CONSEQUENTIAL DAMAGES, SUCH AS LOSS OF PROFITS OR INABILITY
+ ** TO USE SAID INTELLECTUAL PROPERTY, UNDER THIS LICENSE, REGARDLESS OF
+ ** WHETHER SUCH PARTY WAS AWARE OF THE POSSIBILITY OF SUCH DAMAGES.
+ ** LICENSEE AGREES THAT IT WILL NOT MAKE ANY WARRANTY ON BEHALF OF
+ ** CARNEGIE MELLON UNIVERSITY, EXPRESS OR IMPLIED, TO ANY PERSON
+ ** CONCERNING THE APPLICATION OF OR THE RESULTS TO BE OBTAINED WITH THE
+ ** DELIVERABLES UNDER THIS LICENSE.
+ **
+ ** Licensee hereby agrees to defend, indemnify, and hold harmless Carnegie
+ ** Mellon University, its trustees, officers, employees, and agents from
+ ** all claims or demands made against them (and any related losses,
+ ** expenses, or attorney's fees) arising out of, or relating to Licensee's
+ ** and/or its sub licensees' negligent use or willful misuse of or
+ ** negligent conduct or willful misconduct regarding the Software,
+ ** facilities, or other rights or assistance granted by Carnegie Mellon
+ ** University under this License, including, but not limited to, any
+ ** claims of product liability, personal injury, death, damage to
+ ** property, or violation of any laws or regulations.
+ **
+ ** Carnegie Mellon University Software Engineering Institute authored
+ ** documents are sponsored by the U.S. Department of Defense under
+ ** Contract FA8721-05-C-0003. Carnegie Mellon University retains
+ ** copyrights in all material produced under this contract. The U.S.
+ ** Government retains a non-exclusive, royalty-free license to publish or
+ ** reproduce these documents, or allow others to do so, for U.S.
+ ** Government purposes only pursuant to the copyright license under the
+ ** contract clause at 252.227.7013.
+ **
+ ** @OPENSOURCE_HEADER_END@
+ ** ------------------------------------------------------------------------
+ */
+
+#ifndef _YAF_AFPACKET_H_
+#define _YAF_AFPACKET_H_
+
+#include <yaf/autoinc.h>
+#include "yafctx.h"
+
+struct yfAfPacketSource_st;
+typedef struct yfAfPacketSource_st yfAfPacketSource_t;
+
+/**
+ * Open an AF_PACKET (TPACKET_V3) capture ring on an interface.  The
+ * interface may be given as IFNAME:GROUP to join PACKET_FANOUT group GROUP,
+ * so that several yaf processes capturing on the same interface each see
+ * whole flows.
+ *
+ * @param ifname    interface name, optionally followed by :GROUP
+ * @param snaplen   maximum number of octets of each packet to decode
+ * @param datalink  set to the datalink type of the interface
+ * @param err       an error description
+ * @return a new capture source, or NULL on error
+ */
+yfAfPacketSource_t *yfAfPacketOpenLive(
+    const char              *ifname,
+    int                     snaplen,
+    int                     *datalink,
+    GError                  **err);
+
+void yfAfPacketSetPromiscMode(
+    int                     mode);
+
+/**
+ * Set the BPF expression to attach to each capture socket.  It is attached
+ * before the socket is bound, so no unfiltered packets are delivered.
+ *
+ * @param bpf_expr  a libpcap filter expression, or NULL for no filter
+ */
+void yfAfPacketSetFilter(
+    char                    *bpf_expr);
+
+void yfAfPacketClose(
+    yfAfPacketSource_t      *ps);
+
+gboolean yfAfPacketMain(
+    yfContext_t             *ctx);
+
+void yfAfPacketDumpStats(void);
+
+#endif
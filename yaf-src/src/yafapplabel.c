@@ -124,4 +124,10 @@ void yfAppLabelFlow(
     }
 }
 
+void yfAppLabelDumpStats(
+    void)
+{
+    ycScanPayloadDumpStats();
+}
+
 #endif /*YAF_ENABLE_APPLABEL*/
@@ -104,6 +104,15 @@ gboolean yfAppLabelInit(
 void yfAppLabelFlow(
     yfFlow_t        *flow);
 
+/**
+ * Logs the per-rule run, hit, and prefilter skip counters of the
+ * application labeler rules.
+ *
+ */
+
+void yfAppLabelDumpStats(
+    void);
+
 #endif /* YAF_ENABLE_APPLABEL */
 
 #endif
@@ -76,6 +76,9 @@
 #include "yafcap.h"
 #include "yaflush.h"
 #include "yafstat.h"
+#if YAF_ENABLE_AFPACKET
+#include "yafafpacket.h"
+#endif
 
 #define YF_CHUNK 16384
 /*RFC 1950 */
@@ -677,6 +680,10 @@ void yfCapDumpStats() {
     if (yaf_ifdrop) {
         g_warning("Network Interface dropped %u packets.", yaf_ifdrop);
     }
+
+#if YAF_ENABLE_AFPACKET
+    yfAfPacketDumpStats();
+#endif
 }
 
 static pcap_dumper_t *yfCapPcapRotate(
@@ -971,9 +978,9 @@ gboolean yfCapMain(
                     yfCapUpdateStats(cs->pcap);
                 }
 
-                if (!yfWriteStatsFlow(ctx, yaf_pcap_drop+yaf_ifdrop,
-                                      yfStatGetTimer(),
-                                      &(ctx->err)))
+                if (!yfLockedWriteStatsFlow(ctx, yaf_pcap_drop+yaf_ifdrop,
+                                            yfStatGetTimer(),
+                                            &(ctx->err)))
                 {
                     ok = FALSE;
                     break;
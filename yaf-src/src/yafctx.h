@@ -140,8 +140,10 @@ typedef struct yfContext_st {
     uint64_t             pcap_offset;
     /** Pcap Lock Buffer */
     AirLock             pcap_lock;
+    /** Flow table worker threads, if more than one flow table */
+    struct yfThreads_st *threads;
 } yfContext_t;
 
-#define YF_CTX_INIT {NULL, NULL, 0, NULL, NULL, NULL, NULL, 0, AIR_LOCK_INIT, NULL, 0, 0, NULL, NULL, 0, AIR_LOCK_INIT}
+#define YF_CTX_INIT {NULL, NULL, 0, NULL, NULL, NULL, NULL, 0, AIR_LOCK_INIT, NULL, 0, 0, NULL, NULL, 0, AIR_LOCK_INIT, NULL}
 
 #endif
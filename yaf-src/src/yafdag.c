@@ -329,8 +329,8 @@ gboolean yfDagMain(
 
         if (!ctx->cfg->nostats) {
             if (g_timer_elapsed(stimer, NULL) > ctx->cfg->stats) {
-                if (!yfWriteStatsFlow(ctx, yaf_dag_drop, yfStatGetTimer(),
-                                      &(ctx->err)))
+                if (!yfLockedWriteStatsFlow(ctx, yaf_dag_drop,
+                                            yfStatGetTimer(), &(ctx->err)))
                 {
                     ok = FALSE;
                     break;
@@ -128,6 +128,7 @@ typedef gboolean (*yfHookValidateFlowTab_fn)(void *yfctx,
                                              GError **err);
 typedef uint8_t (*yfHookGetTemplateCount_fn)(void *yfHookConext, yfFlow_t *flow);
 typedef void (*yfHookFreeLists_fn)(void * yfHookConext, yfFlow_t *flow);
+typedef void (*yfHookDumpStats_fn)(void *yfctx);
 
 typedef struct yfHooksFuncs_st {
     yfHookGetMetaData_fn    getMetaData;
@@ -156,6 +157,8 @@ typedef struct yfHookPlugin_st {
                                    sizeof (char *)];
         yfHooksFuncs_t          funcPtrs;
     } ufptr;
+    /* optional, NULL if the plugin does not keep statistics */
+    yfHookDumpStats_fn  dumpStats;
     struct yfHookPlugin_st *next;
 } yfHookPlugin_t;
 
@@ -668,6 +671,8 @@ yfHookAddNewHook (
              pluginFunctionNames[loop], hookName);
         return FALSE;
     }
+    newPlugin->dumpStats = (yfHookDumpStats_fn)lt_dlsym(libHandle,
+                                                        "ypDumpStats");
 
      /* insert this plugin into an empty plugin list */
     if (NULL == headPlugin) {
@@ -792,6 +797,31 @@ yfHookGetTemplateCount(
     return count;
 }
 
+/**
+ * yfHookDumpStats
+ *
+ *
+ */
+void
+yfHookDumpStats(
+    void **yfctx)
+{
+    unsigned int loop;
+    yfHookPlugin_t *pluginIndex;
+
+    pluginIndex = headPlugin;
+
+    for (loop = 0; loop < yaf_hooked; loop++) {
+        if (NULL == pluginIndex) {
+            break;
+        }
+        if (pluginIndex->dumpStats) {
+            (pluginIndex->dumpStats)(yfctx[loop]);
+        }
+        pluginIndex = pluginIndex->next;
+    }
+}
+
 /**
  * yfHookFreeLists
  *
@@ -0,0 +1,308 @@
+/*
+ ** yafinspect.c
+ ** YAF payload inspection threads
+ **
+ ** ------------------------------------------------------------------------
+ ** Copyright (C) 2006-2016 Carnegie Mellon University. All Rights Reserved.
+ ** ------------------------------------------------------------------------
+ ** @OPENSOURCE_HEADER_START@
+ ** Use of the YAF system and related source code is subject to the terms
+ ** of the following licenses:
+ **
+ ** GNU Public License (GPL) Rights pursuant to Version 2, June 1991
+ ** Government Purpose License Rights (GPLR) pursuant to DFARS 252.227.7013
+ **
+ ** NO WARRANTY
+ **
+ ** ANY INFORMATION, MATERIALS, SERVICES, INTELLECTUAL PROPERTY OR OTHER
+ ** PROPERTY OR RIGHTS GRANTED OR PROVIDED BY CARNEGIE MELLON UNIVERSITY
+ ** PURSUANT TO THIS LICENSE (HEREINAFTER THE "DELIVERABLES") ARE ON AN
+ ** "AS-IS" BASIS. CARNEGIE MELLON UNIVERSITY MAKES NO WARRANTIES OF ANY
+ ** KIND, EITHER EXPRESS OR IMPLIED AS TO ANY MATTER INCLUDING, BUT NOT
+ ** LIMITED TO, WARRANTY OF FITNESS FOR A PARTICULAR PURPOSE,
+ ** MERCHANTABILITY, INFORMATIONAL CONTENT, NONINFRINGEMENT, OR ERROR-FREE
+ ** OPERATION. CARNEGIE MELLON UNIVERSITY SHALL NOT BE LIABLE FOR INDIRECT,
+ ** SPECIAL OR CONSEQUENTIAL DAMAGES, SUCH AS LOSS OF PROFITS OR INABILITY
+ ** TO USE SAID INTELLECTUAL PROPERTY, UNDER THIS LICENSE, REGARDLESS OF
+ ** WHETHER SUCH PARTY WAS AWARE OF THE POSSIBILITY OF SUCH DAMAGES.
+ ** LICENSEE AGREES THAT IT WILL NOT MAKE ANY WARRANTY ON BEHALF OF
+ ** CARNEGIE MELLON UNIVERSITY, EXPRESS OR IMPLIED, TO ANY PERSON
+ ** CONCERNING THE APPLICATION OF OR THE RESULTS TO BE OBTAINED WITH THE
+ ** DELIVERABLES UNDER THIS LICENSE.
+ **
+ ** Licensee hereby agrees to defend, indemnify, and hold harmless Carnegie
+ ** Mellon University, its trustees, officers, employees, and agents from
+ ** all claims or demands made against them (and any related losses,
+ ** expenses, or attorney's fees) arising out of, or relating to Licensee's
+ ** and/or its sub licensees' negligent use or willful misuse of or
+ ** negligent conduct or willful misconduct regarding the Software,
+ ** facilities, or other rights or assistance granted by Carnegie Mellon
+ ** University under this License, including, but not limited to, any
+ ** claims of product liability, personal injury, death, damage to
+ ** property, or violation of any laws or regulations.
+ **
+ ** Carnegie Mellon University Software Engineering Institute authored
+ ** documents are sponsored by the U.S. Department of Defense under
+ ** Contract FA8721-05-C-0003. Carnegie Mellon University retains
+ ** copyrights in all material produced under this contract. The U.S.
+ ** Government retains a non-exclusive, royalty-free license to publish or
+ ** reproduce these documents, or allow others to do so, for U.S.
+ ** Government purposes only pursuant to the copyright license under the
+ ** contract clause at 252.227.7013.
+ **
+ ** @OPENSOURCE_HEADER_END@
+ ** ------------------------------------------------------------------------
+ */
+
+#define _YAF_SOURCE_
+#include "yafinspect.h"
+#include <yaf/yafcore.h>
+#include <pthread.h>
+#include <signal.h>
+
+/* number of jobs the queue can hold */
+#define YF_INSPECT_QUEUE_SIZE   8192
+
+typedef struct yfInspectJob_st {
+    yfInspectFn_t       fn;
+    void                *ctx;
+    void                *item;
+} yfInspectJob_t;
+
+struct yfInspect_st {
+    /** Guards everything below but the threads */
+    pthread_mutex_t     lock;
+    /** Signalled when a job is queued or the threads are to stop */
+    pthread_cond_t      work;
+    /** Broadcast when a job is done and someone is waiting */
+    pthread_cond_t      done;
+    /** Job queue; a ring of YF_INSPECT_QUEUE_SIZE jobs */
+    yfInspectJob_t      *jobs;
+    size_t              head;
+    size_t              count;
+    /** Threads waiting in yfInspectWait() */
+    unsigned int        waiting;
+    /** Set when the threads are to stop once the queue is empty */
+    gboolean            stop;
+    gboolean            ordered;
+    /** Inspection threads */
+    pthread_t           *threads;
+    unsigned int        nthreads;
+    /** Statistics */
+    uint64_t            queued;
+    uint64_t            full;
+    uint32_t            peak;
+};
+
+/**
+ * yfInspectMain
+ *
+ * Inspection thread: run queued jobs until told to stop.
+ *
+ */
+static void *yfInspectMain(
+    void                *arg)
+{
+    yfInspect_t         *insp = (yfInspect_t *)arg;
+    yfInspectJob_t      job;
+
+    pthread_mutex_lock(&insp->lock);
+    for (;;) {
+        while (!insp->count && !insp->stop) {
+            pthread_cond_wait(&insp->work, &insp->lock);
+        }
+        if (!insp->count) {
+            break;
+        }
+        job = insp->jobs[insp->head];
+        insp->head = (insp->head + 1) % YF_INSPECT_QUEUE_SIZE;
+        --(insp->count);
+        pthread_mutex_unlock(&insp->lock);
+
+        job.fn(job.ctx, job.item);
+
+        pthread_mutex_lock(&insp->lock);
+        if (insp->waiting) {
+            pthread_cond_broadcast(&insp->done);
+        }
+    }
+    pthread_mutex_unlock(&insp->lock);
+
+    return NULL;
+}
+
+/**
+ * yfInspectAlloc
+ *
+ *
+ *
+ */
+yfInspect_t *yfInspectAlloc(
+    unsigned int        count,
+    gboolean            ordered,
+    GError              **err)
+{
+    yfInspect_t         *insp = NULL;
+    sigset_t            sigs, osigs;
+    unsigned int        i;
+    int                 rv = 0;
+
+    insp = g_slice_new0(yfInspect_t);
+    pthread_mutex_init(&insp->lock, NULL);
+    pthread_cond_init(&insp->work, NULL);
+    pthread_cond_init(&insp->done, NULL);
+    insp->jobs = g_new(yfInspectJob_t, YF_INSPECT_QUEUE_SIZE);
+    insp->ordered = ordered;
+    insp->threads = g_new0(pthread_t, count);
+
+    /* signals are left to the capture thread */
+    sigfillset(&sigs);
+    pthread_sigmask(SIG_SETMASK, &sigs, &osigs);
+
+    for (i = 0; i < count; i++) {
+        if ((rv = pthread_create(&insp->threads[i], NULL,
+                                 yfInspectMain, insp)))
+        {
+            break;
+        }
+        ++(insp->nthreads);
+    }
+
+    pthread_sigmask(SIG_SETMASK, &osigs, NULL);
+
+    if (rv) {
+        g_set_error(err, YAF_ERROR_DOMAIN, YAF_ERROR_INTERNAL,
+                    "Couldn't start payload inspection thread %u: %s",
+                    i, strerror(rv));
+        yfInspectFree(insp);
+        return NULL;
+    }
+
+    return insp;
+}
+
+/**
+ * yfInspectSubmit
+ *
+ *
+ *
+ */
+gboolean yfInspectSubmit(
+    yfInspect_t         *insp,
+    yfInspectFn_t       fn,
+    void                *ctx,
+    void                *item)
+{
+    yfInspectJob_t      *job = NULL;
+
+    pthread_mutex_lock(&insp->lock);
+
+    if (insp->count == YF_INSPECT_QUEUE_SIZE) {
+        ++(insp->full);
+        pthread_mutex_unlock(&insp->lock);
+        return FALSE;
+    }
+
+    job = &insp->jobs[(insp->head + insp->count) % YF_INSPECT_QUEUE_SIZE];
+    job->fn = fn;
+    job->ctx = ctx;
+    job->item = item;
+    ++(insp->count);
+    ++(insp->queued);
+    if (insp->count > insp->peak) {
+        insp->peak = insp->count;
+    }
+
+    pthread_cond_signal(&insp->work);
+    pthread_mutex_unlock(&insp->lock);
+
+    return TRUE;
+}
+
+/**
+ * yfInspectWait
+ *
+ *
+ *
+ */
+void yfInspectWait(
+    yfInspect_t         *insp,
+    yfInspectDoneFn_t   done,
+    void                *item)
+{
+    pthread_mutex_lock(&insp->lock);
+    ++(insp->waiting);
+    while (!done(item)) {
+        pthread_cond_wait(&insp->done, &insp->lock);
+    }
+    --(insp->waiting);
+    pthread_mutex_unlock(&insp->lock);
+}
+
+/**
+ * yfInspectOrdered
+ *
+ *
+ *
+ */
+gboolean yfInspectOrdered(
+    yfInspect_t         *insp)
+{
+    return insp->ordered;
+}
+
+/**
+ * yfInspectFree
+ *
+ *
+ *
+ */
+void yfInspectFree(
+    yfInspect_t         *insp)
+{
+    unsigned int        i;
+
+    if (!insp) {
+        return;
+    }
+
+    /* the threads drain the queue before they exit */
+    pthread_mutex_lock(&insp->lock);
+    insp->stop = TRUE;
+    pthread_cond_broadcast(&insp->work);
+    pthread_mutex_unlock(&insp->lock);
+
+    for (i = 0; i < insp->nthreads; i++) {
+        pthread_join(insp->threads[i], NULL);
+    }
+
+    g_free(insp->threads);
+    g_free(insp->jobs);
+    pthread_cond_destroy(&insp->done);
+    pthread_cond_destroy(&insp->work);
+    pthread_mutex_destroy(&insp->lock);
+    g_slice_free(yfInspect_t, insp);
+}
+
+/**
+ * yfInspectDumpStats
+ *
+ *
+ *
+ */
+void yfInspectDumpStats(
+    yfInspect_t         *insp)
+{
+    if (!insp) {
+        return;
+    }
+
+    pthread_mutex_lock(&insp->lock);
+    g_debug("  %u payload inspection threads: %"PRIu64" flows queued, "
+            "peak queue %u.", insp->nthreads, insp->queued, insp->peak);
+    if (insp->full) {
+        g_debug("  %"PRIu64" flows inspected by the flow table with the "
+                "inspection queue full.", insp->full);
+    }
+    pthread_mutex_unlock(&insp->lock);
+}
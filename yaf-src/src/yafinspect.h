@@ -0,0 +1,171 @@
+/*
+ ** yafinspect.h
+ ** YAF payload inspection threads
+ **
+ ** ------------------------------------------------------------------------
+ ** Copyright (C) 2006-2016 Carnegie Mellon University. All Rights Reserved.
+ ** ------------------------------------------------------------------------
+ ** @OPENSOURCE_HEADER_START@
+ ** Use of the YAF system and related source code is subject to the terms
+ ** of the following licenses:
+ **
+ ** GNU Public License (GPL) Rights pursuant to Version 2, June 1991
+ ** Government Purpose License Rights (GPLR) pursuant to DFARS 252.227.7013
+ **
+ ** NO WARRANTY
+ **
+ ** ANY INFORMATION, MATERIALS, SERVICES, INTELLECTUAL PROPERTY OR OTHER
+ ** PROPERTY OR RIGHTS GRANTED OR PROVIDED BY CARNEGIE MELLON UNIVERSITY
+ ** PURSUANT TO THIS LICENSE (HEREINAFTER THE "DELIVERABLES") ARE ON AN
+ ** "AS-IS" BASIS. CARNEGIE MELLON UNIVERSITY MAKES NO WARRANTIES OF ANY
+ ** KIND, EITHER EXPRESS OR IMPLIED AS TO ANY MATTER INCLUDING, BUT NOT
+ ** LIMITED TO, WARRANTY OF FITNESS FOR A PARTICULAR PURPOSE,
+ ** MERCHANTABILITY, INFORMATIONAL CONTENT, NONINFRINGEMENT, OR ERROR-FREE
+ ** OPERATION. CARNEGIE MELLON UNIVERSITY SHALL NOT BE LIABLE FOR INDIRECT,
+ ** SPECIAL OR CONSEQUENTIAL DAMAGES, SUCH AS LOSS OF PROFITS OR INABILITY
+ ** TO USE SAID INTELLECTUAL PROPERTY, UNDER THIS LICENSE, REGARDLESS OF
+ ** WHETHER SUCH PARTY WAS AWARE OF THE POSSIBILITY OF SUCH DAMAGES.
+ ** LICENSEE AGREES THAT IT WILL NOT MAKE ANY WARRANTY ON BEHALF OF
+ ** CARNEGIE MELLON UNIVERSITY, EXPRESS OR IMPLIED, TO ANY PERSON
+ ** CONCERNING THE APPLICATION OF OR THE RESULTS TO BE OBTAINED WITH THE
+ ** DELIVERABLES UNDER THIS LICENSE.
+ **
+ ** Licensee hereby agrees to defend, indemnify, and hold harmless Carnegie
+ ** Mellon University, its trustees, officers, employees, and agents from
+ ** all claims or demands made against them (and any related losses,
+ ** expenses, or attorney's fees) arising out of, or relating to Licensee's
+ ** and/or its sub licensees' negligent use or willful misuse of or
+ ** negligent conduct or willful misconduct regarding the Software,
+ ** facilities, or other rights or assistance granted by Carnegie Mellon
+ ** University under this License, including, but not limited to, any
+ ** claims of product liability, personal injury, death, damage to
+ ** property, or violation of any laws or regulations.
+ **
+ ** Carnegie Mellon University Software Engineering Institute authored
+ ** documents are sponsored by the U.S. Department of Defense under
+ ** Contract FA8721-05-C-0003. Carnegie Mellon University retains
+ ** copyrights in all material produced under this contract. The U.S.
+ ** Government retains a non-exclusive, royalty-free license to publish or
+ ** reproduce these documents, or allow others to do so, for U.S.
+ ** Government purposes only pursuant to the copyright license under the
+ ** contract clause at 252.227.7013.
+ **
+ ** @OPENSOURCE_HEADER_END@
+ ** ------------------------------------------------------------------------
+ */
+
+/*
+ * Payload inspection threads.  Application labeling, entropy, and the
+ * flow close hooks (DPI) run once per flow, when it is closed, and can be
+ * far more expensive than adding packets to the flow table.  With
+ * inspection threads, the flow table queues each closed flow that carries
+ * payload for one of a pool of threads and goes back to capturing; the
+ * flow stays on the close queue, and is not written, until it has been
+ * inspected.  When the queue is full, the flow table inspects the flow
+ * itself instead of waiting.
+ */
+
+#ifndef _YAF_INSPECT_H_
+#define _YAF_INSPECT_H_
+
+#include <yaf/autoinc.h>
+
+/** Maximum number of payload inspection threads */
+#define YF_INSPECT_MAX 64
+
+/** Payload inspection thread pool */
+typedef struct yfInspect_st yfInspect_t;
+
+/**
+ * Inspection job function.
+ *
+ * @param ctx      context given to yfInspectSubmit()
+ * @param item     item given to yfInspectSubmit()
+ */
+typedef void (*yfInspectFn_t)(
+    void                *ctx,
+    void                *item);
+
+/**
+ * Inspection done predicate, for yfInspectWait().
+ *
+ * @param item     item given to yfInspectWait()
+ * @return TRUE if the item has been inspected
+ */
+typedef gboolean (*yfInspectDoneFn_t)(
+    void                *item);
+
+/**
+ * Allocate a payload inspection thread pool and start its threads.  The
+ * threads are started with all signals blocked.
+ *
+ * @param count    number of threads
+ * @param ordered  TRUE if inspected flows are to be written in the order
+ *                 they were closed
+ * @param err      an error description
+ * @return a new thread pool, or NULL if a thread could not be started
+ */
+yfInspect_t *yfInspectAlloc(
+    unsigned int        count,
+    gboolean            ordered,
+    GError              **err);
+
+/**
+ * Queue a job for the inspection threads.  Does not block; if the queue is
+ * full, the job is not queued, and the caller should run it itself.
+ *
+ * @param insp     thread pool
+ * @param fn       job function, called as fn(ctx, item) on an inspection
+ *                 thread
+ * @param ctx      job context
+ * @param item     item to inspect
+ * @return TRUE if the job was queued, FALSE if the queue is full
+ */
+gboolean yfInspectSubmit(
+    yfInspect_t         *insp,
+    yfInspectFn_t       fn,
+    void                *ctx,
+    void                *item);
+
+/**
+ * Wait until a queued item has been inspected.  The job function must mark
+ * the item done, in a way done() can see, before it returns.
+ *
+ * @param insp     thread pool
+ * @param done     predicate; called with the pool locked
+ * @param item     item to wait for
+ */
+void yfInspectWait(
+    yfInspect_t         *insp,
+    yfInspectDoneFn_t   done,
+    void                *item);
+
+/**
+ * Find out whether inspected flows are to be written in the order they
+ * were closed, rather than as soon as they have been inspected.
+ *
+ * @param insp     thread pool
+ * @return TRUE if flows are written in close order
+ */
+gboolean yfInspectOrdered(
+    yfInspect_t         *insp);
+
+/**
+ * Run every queued job, stop the inspection threads, and free the pool.
+ * Does nothing if insp is NULL.
+ *
+ * @param insp     thread pool
+ */
+void yfInspectFree(
+    yfInspect_t         *insp);
+
+/**
+ * Print inspection thread statistics to the log.  Does nothing if insp is
+ * NULL.
+ *
+ * @param insp     thread pool
+ */
+void yfInspectDumpStats(
+    yfInspect_t         *insp);
+
+#endif
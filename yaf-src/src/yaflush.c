@@ -60,14 +60,20 @@
 #include "yaflush.h"
 #include "yafout.h"
 #include "yafstat.h"
+#include "yafthread.h"
 #include <yaf/yafcore.h>
 
+/* number of packets ahead of the current one whose flow table slot is
+ * prefetched */
+#define YF_PREFETCH_AHEAD 8
+
 gboolean yfProcessPBufRing(
     yfContext_t        *ctx,
     GError             **err)
 {
     AirLock             *lock = NULL;
     yfPBuf_t            *pbuf = NULL;
+    yfPBuf_t            *ahead = NULL;
     gboolean            ok = TRUE;
     uint64_t            cur_time;
 
@@ -78,20 +84,45 @@ gboolean yfProcessPBufRing(
 
     /* Open output if we need to */
     if (!ctx->cfg->no_output) {
+        yfThreadsLockOutput(ctx);
         if (!ctx->fbuf) {
-            if (!(ctx->fbuf = yfOutputOpen(ctx->cfg, lock, err))) {
-                ok = FALSE;
-                goto end;
-            }
+            ctx->fbuf = yfOutputOpen(ctx->cfg, lock, err);
+        }
+        yfThreadsUnlockOutput(ctx);
+        if (!ctx->fbuf) {
+            ok = FALSE;
+            goto end;
         }
     }
 
     /* Dump statistics if requested */
     yfStatDumpLoop();
 
+    /* hand packets to the flow table workers if there are any */
+    if (ctx->threads) {
+        while ((pbuf = (yfPBuf_t *)rgaNextTail(ctx->pbufring))) {
+            if (pbuf->ptime && !yfThreadsDispatch(ctx, pbuf, err)) {
+                ok = FALSE;
+                goto end;
+            }
+        }
+        if (!yfThreadsRelease(ctx, err)) {
+            ok = FALSE;
+            goto end;
+        }
+        goto rotate;
+    }
+
     /* process packets from the ring buffer */
     while ((pbuf = (yfPBuf_t *)rgaNextTail(ctx->pbufring))) {
 
+        /* Warm the flow table for a packet further down the ring */
+        if ((ahead = (yfPBuf_t *)rgaPeekTail(ctx->pbufring,
+                                             YF_PREFETCH_AHEAD)))
+        {
+            yfFlowPBufPrefetch(ctx->flowtab, ahead);
+        }
+
         /* Skip time zero packets (these are marked invalid) */
         if (!pbuf->ptime) {
             continue;
@@ -107,15 +138,19 @@ gboolean yfProcessPBufRing(
         goto end;
     }
 
+rotate:
     /* Close output file for rotation if necessary */
     if (ctx->cfg->rotate_ms) {
         cur_time = yfFlowTabCurrentTime(ctx->flowtab);
         if (ctx->last_rotate_ms) {
             if (cur_time - ctx->last_rotate_ms > ctx->cfg->rotate_ms) {
+                yfThreadsLockOutput(ctx);
                 yfOutputClose(ctx->fbuf, lock, TRUE);
                 ctx->fbuf = NULL;
                 ctx->last_rotate_ms = cur_time;
-                if (!(ctx->fbuf = yfOutputOpen(ctx->cfg, lock, err))) {
+                ctx->fbuf = yfOutputOpen(ctx->cfg, lock, err);
+                yfThreadsUnlockOutput(ctx);
+                if (!ctx->fbuf) {
                     ok = FALSE;
                     goto end;
                 }
@@ -139,27 +174,31 @@ gboolean yfTimeOutFlush(
 {
     AirLock             *lock = NULL;
     uint64_t            cur_time;
+    gboolean            ok = FALSE;
 
     /* point to lock buffer if we need it */
     if (ctx->cfg->lockmode) {
         lock = &ctx->lockbuf;
     }
 
+    /* Dump statistics if requested */
+    yfStatDumpLoop();
+
+    /* Flow table workers write to the output too */
+    yfThreadsLockOutput(ctx);
+
     /* Open output if we need to */
     if (!ctx->cfg->no_output) {
         if (!ctx->fbuf) {
             if (!(ctx->fbuf = yfOutputOpen(ctx->cfg, lock, err))) {
-                return FALSE;
+                goto end;
             }
         }
     }
 
-    /* Dump statistics if requested */
-    yfStatDumpLoop();
-
     /* Flush the flow table */
     if (!yfFlowTabFlush(ctx, FALSE, err)) {
-        return FALSE;
+        goto end;
     }
 
     if (!ctx->cfg->nostats) {
@@ -168,7 +207,7 @@ gboolean yfTimeOutFlush(
         }
         if (g_timer_elapsed(stats_timer, NULL) > ctx->cfg->stats) {
             if (!yfWriteStatsFlow(ctx, pcap_drop, timer, err)) {
-                return FALSE;
+                goto end;
             }
             g_timer_start(stats_timer);
             *total_stats += 1;
@@ -177,7 +216,7 @@ gboolean yfTimeOutFlush(
 
     if (!ctx->cfg->no_output) {
         if (!fBufEmit(ctx->fbuf, err)) {
-            return FALSE;
+            goto end;
         }
     }
 
@@ -195,7 +234,11 @@ gboolean yfTimeOutFlush(
         }
     }
 
-    return TRUE;
+    ok = TRUE;
+
+end:
+    yfThreadsUnlockOutput(ctx);
+    return ok;
 }
 
 
@@ -216,6 +259,13 @@ gboolean yfFinalFlush(
          lock = &ctx->lockbuf;
      }
 
+    /* stop flow table workers, flushing their flows on successful exit */
+    if (ok) {
+        ok = yfThreadsFinish(ctx, (ctx->fbuf != NULL), err);
+    } else {
+        yfThreadsFinish(ctx, FALSE, NULL);
+    }
+
     /* handle final flush and close */
     if (ctx->fbuf) {
         if (ok) {
@@ -236,3 +286,19 @@ gboolean yfFinalFlush(
 
     return ok;
 }
+
+gboolean yfLockedWriteStatsFlow(
+    yfContext_t         *ctx,
+    uint32_t            pcap_drop,
+    GTimer              *timer,
+    GError              **err)
+{
+    gboolean            ok;
+
+    /* flow table workers may be writing flows to the same buffer */
+    yfThreadsLockOutput(ctx);
+    ok = yfWriteStatsFlow(ctx, pcap_drop, timer, err);
+    yfThreadsUnlockOutput(ctx);
+
+    return ok;
+}
@@ -81,4 +81,10 @@ gboolean yfFinalFlush(
     GTimer              *timer,
     GError              **err);
 
+gboolean yfLockedWriteStatsFlow(
+    yfContext_t         *ctx,
+    uint32_t            pcap_drop,
+    GTimer              *timer,
+    GError              **err);
+
 #endif
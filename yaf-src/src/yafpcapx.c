@@ -407,9 +407,9 @@ gboolean yfPcapxMain(
 
         if (!ctx->cfg->nostats) {
             if (g_timer_elapsed(stimer, NULL) > ctx->cfg->stats) {
-                if (!yfWriteStatsFlow(ctx,
+                if (!yfLockedWriteStatsFlow(ctx,
                                     (uint32_t)(yaf_nt_dropped+yaf_nt_dev_drop),
-                                      yfStatGetTimer(), &(ctx->err)))
+                                            yfStatGetTimer(), &(ctx->err)))
                 {
                     ok = FALSE;
                     break;
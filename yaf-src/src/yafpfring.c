@@ -368,8 +368,8 @@ gboolean yfPfRingMain(
 
         if (!ctx->cfg->nostats) {
             if (g_timer_elapsed(stimer, NULL) > ctx->cfg->stats) {
-                if (!yfWriteStatsFlow(ctx, pf->stat.drop, yfStatGetTimer(),
-                                      &(ctx->err)))
+                if (!yfLockedWriteStatsFlow(ctx, pf->stat.drop,
+                                            yfStatGetTimer(), &(ctx->err)))
                 {
                     ok = FALSE;
                     break;
@@ -477,8 +477,8 @@ gboolean yfPfRingZCMain(
       if (!ctx->cfg->nostats) {
           if (g_timer_elapsed(stimer, NULL) > ctx->cfg->stats) {
 
-              if (!yfWriteStatsFlow(ctx, zc->stat.drop, yfStatGetTimer(),
-                                    &(ctx->err)))
+              if (!yfLockedWriteStatsFlow(ctx, zc->stat.drop,
+                                          yfStatGetTimer(), &(ctx->err)))
               {
                   ok = FALSE;
                   break;
@@ -62,6 +62,7 @@
 #include <yaf/yafrag.h>
 #include <yaf/decode.h>
 #include "yafcap.h"
+#include "yafthread.h"
 
 #if YAF_ENABLE_NETRONOME
 #include "yafnfe.h"
@@ -111,6 +112,7 @@ static void yfStatDump()
     uint32_t dropped, assembled, frags;
 
     numPackets = yfFlowDumpStats(statctx->flowtab, yaf_fft);
+    yfThreadsDumpStats(statctx);
     numPackets += yfGetDecodeStats(statctx->dectx);
     yfGetFragTabStats(statctx->fragtab, &dropped, &assembled, &frags);
     numPackets += (frags - assembled);
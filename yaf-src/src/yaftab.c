@@ -69,6 +69,7 @@
 #include <yaf/yaftab.h>
 #include <yaf/yafrag.h>
 #include "yafctx.h"
+#include "yafinspect.h"
 
 #if YAF_ENABLE_APPLABEL
 #include "yafapplabel.h"
@@ -110,10 +111,25 @@
 #define YAF_STATE_RFINACK       0x00000080
 #define YAF_STATE_FIN           0x000000F0
 #define YAF_STATE_ATO           0x00000100
+/* closed flow queued for payload inspection; cleared by the inspector */
+#define YAF_STATE_INSPECT       0x00000200
 
 #define YF_FLUSH_DELAY 5000
 #define YF_MAX_CQ      2500
 
+/* initial slot count of a key table when no flow limit is configured */
+#define YF_FLOW_HASH_INIT       8192
+/* initial slot count of the key table of each MPLS label set */
+#define YF_FLOW_HASH_MPLS_INIT  64
+/* largest slot count a key table is allowed to grow to */
+#define YF_FLOW_HASH_MAX        0x40000000
+/* number of nodes added to a node pool each time it runs dry */
+#define YF_NODE_POOL_CHUNK      4096
+/* smallest payload buffer handed out by a payload arena */
+#define YF_PAY_CLASS_MIN        256
+/* number of payload buffer size classes; enough to reach 4GB */
+#define YF_PAY_CLASSES          25
+
 #define YAF_PCAP_META_ROTATE 45000000
 /* full path */
 #define YAF_PCAP_META_ROTATE_FP 23000000
@@ -200,6 +216,75 @@ typedef struct yfFlowNodeIPv4_st {
 
 #endif
 
+/*
+ * The active flow table is an open-addressed hash table with linear
+ * probing.  Each slot holds the flow node and the direction-independent
+ * hash of its key (see yfFlowKeyHashCanon()), so that both directions
+ * of a flow land on the same probe sequence and mismatches are almost
+ * always rejected without touching the node.  Deletion shifts the
+ * following entries back, so the table holds no tombstones.
+ */
+typedef struct yfFlowHashSlot_st {
+    uint32_t            hash;
+    yfFlowNode_t        *fn;
+} yfFlowHashSlot_t;
+
+struct yfFlowHash_st {
+    yfFlowHashSlot_t    *slots;
+    uint32_t            mask;
+    uint32_t            count;
+    uint32_t            grown;
+};
+
+typedef struct yfFlowHash_st yfFlowHash_t;
+
+/*
+ * Flow nodes come from a pool rather than the slice allocator.  Nodes
+ * are carved in order out of large chunks, and freed nodes go onto a
+ * free list (linked through the node's n pointer) for reuse.  Memory
+ * is returned to the system only when the flow table is freed.
+ */
+typedef struct yfFlowNodeChunk_st {
+    struct yfFlowNodeChunk_st   *next;
+    uint8_t                     *nodes;
+} yfFlowNodeChunk_t;
+
+typedef struct yfFlowNodePool_st {
+    yfFlowNodeChunk_t   *chunks;
+    yfFlowNode_t        *free;
+    uint8_t             *next;
+    uint8_t             *end;
+    size_t              node_sz;
+    uint32_t            count;
+    uint32_t            inuse;
+    uint32_t            peak;
+} yfFlowNodePool_t;
+
+/*
+ * Payload buffers come from a per-table arena of power-of-two size
+ * classes running from YF_PAY_CLASS_MIN bytes up to the payload limit,
+ * which is always the size of the last class.  A flow starts with a
+ * buffer of the smallest class that holds its first payload and moves
+ * to a larger class only when it captures more.  Buffers are not
+ * zeroed; bytes past a flow's paylen are never read.  Freed buffers go
+ * onto the free list of their class (linked through the buffer itself)
+ * and, like flow nodes, are returned to the system only when the flow
+ * table is freed.
+ */
+typedef struct yfPayBuf_st {
+    struct yfPayBuf_st  *next;
+} yfPayBuf_t;
+
+typedef struct yfPayArena_st {
+    yfPayBuf_t          *free[YF_PAY_CLASSES];
+    uint32_t            max_payload;
+    uint64_t            held;
+    uint64_t            inuse;
+    uint64_t            peak;
+    uint64_t            allocs;
+    uint64_t            reuses;
+} yfPayArena_t;
+
 struct yfFlowTabStats_st {
     uint64_t        stat_octets;
     uint64_t        stat_packets;
@@ -218,7 +303,18 @@ struct yfFlowTab_st {
     /* State */
     uint64_t        ctime;
     uint64_t        flushtime;
+#if YAF_MPLS
     GHashTable      *table;
+#else
+    yfFlowHash_t    *table;
+#endif
+    yfFlowNodePool_t pool;
+#if YAF_ENABLE_COMPACT_IP4
+    yfFlowNodePool_t pool4;
+#endif
+#if YAF_ENABLE_PAYLOAD
+    yfPayArena_t    payarena;
+#endif
 #ifdef YAF_ENABLE_HOOKS
     /** Plugin context array for this yaf **/
     void            **yfctx;
@@ -257,6 +353,8 @@ struct yfFlowTab_st {
     gboolean        stats_mode;
     gboolean        index_pcap;
     uint16_t        udp_uniflow_port;
+    /* Payload inspection threads, or NULL to inspect flows when closed */
+    yfInspect_t     *inspect;
     /* Statistics */
     struct yfFlowTabStats_st stats;
 };
@@ -288,6 +386,49 @@ void yfGetFlowTabStats(
     *flush = flowtab->stats.stat_flush;
 }
 
+/**
+ * yfSetFlowTabStats
+ *
+ *
+ */
+void yfSetFlowTabStats(
+    yfFlowTab_t *flowtab,
+    uint64_t packets,
+    uint64_t flows,
+    uint64_t rej_pkts,
+    uint32_t peak,
+    uint32_t flush)
+{
+    flowtab->stats.stat_packets = packets;
+    flowtab->stats.stat_flows = flows;
+    flowtab->stats.stat_seqrej = rej_pkts;
+    flowtab->stats.stat_peak = peak;
+    flowtab->stats.stat_flush = flush;
+}
+
+/**
+ * yfFlowTabAddStats
+ *
+ *
+ */
+void yfFlowTabAddStats(
+    yfFlowTab_t *flowtab,
+    yfFlowTab_t *from)
+{
+    flowtab->stats.stat_octets += from->stats.stat_octets;
+    flowtab->stats.stat_packets += from->stats.stat_packets;
+    flowtab->stats.stat_seqrej += from->stats.stat_seqrej;
+    flowtab->stats.stat_flows += from->stats.stat_flows;
+    flowtab->stats.stat_uniflows += from->stats.stat_uniflows;
+    flowtab->stats.stat_peak += from->stats.stat_peak;
+    flowtab->stats.stat_flush += from->stats.stat_flush;
+#if YAF_MPLS
+    if (from->stats.max_mpls_labels > flowtab->stats.max_mpls_labels) {
+        flowtab->stats.max_mpls_labels = from->stats.max_mpls_labels;
+    }
+#endif
+}
+
 #if YAF_MPLS
 /**
  * yfMPLSHash
@@ -528,6 +669,565 @@ static void yfFlowKeyCopy(
 #endif
 }
 
+/**
+ * yfFlowHashMix
+ *
+ * final avalanche step for the flow key hashes; every input bit
+ * affects every output bit.
+ *
+ */
+static uint32_t yfFlowHashMix(
+    uint32_t          h)
+{
+    h ^= h >> 16;
+    h *= 0x85ebca6b;
+    h ^= h >> 13;
+    h *= 0xc2b2ae35;
+    h ^= h >> 16;
+    return h;
+}
+
+/**
+ * yfFlowKeyHashCanon
+ *
+ * direction-independent hash of a flow key: a key and its reverse (as
+ * produced by yfFlowKeyReverse()) hash to the same value.  Each
+ * endpoint is hashed on its own and the two are combined with an
+ * addition, which does not depend on their order.  ICMP keeps type and
+ * code in sp/dp in both directions, so for ICMP these are mixed in with
+ * the fields that do not change when the key is reversed.
+ *
+ * @param key pointer to the flow key
+ *
+ * @return 32-bit hash of the flow key
+ */
+static uint32_t yfFlowKeyHashCanon(
+    yfFlowKey_t       *key)
+{
+    uint32_t          w[4];
+    uint32_t          sh, dh, ports, meta;
+
+    /* Mask out priority/CFI bits */
+    meta = ((0x0FFF & (uint32_t)key->vlanId) << 16 |
+            (uint32_t)key->version << 8 | key->proto);
+#if YAF_ENABLE_DAG_SEPARATE_INTERFACES
+    meta ^= (uint32_t)key->netIf << 28;
+#endif
+
+    if (key->version == 4) {
+        sh = key->addr.v4.sip;
+        dh = key->addr.v4.dip;
+    } else {
+        memcpy(w, key->addr.v6.sip, sizeof(w));
+        sh = ((w[0] * 0x9E3779B1 + w[1]) * 0x9E3779B1 + w[2]) * 0x9E3779B1
+            + w[3];
+        memcpy(w, key->addr.v6.dip, sizeof(w));
+        dh = ((w[0] * 0x9E3779B1 + w[1]) * 0x9E3779B1 + w[2]) * 0x9E3779B1
+            + w[3];
+    }
+
+    if (key->proto == YF_PROTO_ICMP || key->proto == YF_PROTO_ICMP6) {
+        ports = (uint32_t)key->sp << 16 | key->dp;
+    } else {
+        sh += (uint32_t)key->sp * 0x85ebca6b;
+        dh += (uint32_t)key->dp * 0x85ebca6b;
+        ports = 0;
+    }
+
+    return yfFlowHashMix((yfFlowHashMix(sh) + yfFlowHashMix(dh)) ^
+                         yfFlowHashMix(ports * 0x9E3779B1 + meta));
+}
+
+/**
+ * yfFlowHashAlloc
+ *
+ * allocate an empty flow key table with room for at least min_slots
+ * slots.
+ *
+ */
+static yfFlowHash_t *yfFlowHashAlloc(
+    uint64_t          min_slots)
+{
+    yfFlowHash_t      *ht;
+    uint32_t          cap = 16;
+
+    while (cap < min_slots && cap < YF_FLOW_HASH_MAX) {
+        cap <<= 1;
+    }
+
+    ht = yg_slice_new0(yfFlowHash_t);
+    ht->slots = g_new0(yfFlowHashSlot_t, cap);
+    ht->mask = cap - 1;
+
+    return ht;
+}
+
+/**
+ * yfFlowHashFree
+ *
+ * free a flow key table; the flow nodes it refers to are untouched.
+ *
+ */
+static void yfFlowHashFree(
+    yfFlowHash_t      *ht)
+{
+    g_free(ht->slots);
+    yg_slice_free(yfFlowHash_t, ht);
+}
+
+/**
+ * yfFlowHashGrow
+ *
+ * double the number of slots in a flow key table, moving every entry
+ * to its slot in the new array using the stored hash.
+ *
+ */
+static void yfFlowHashGrow(
+    yfFlowHash_t      *ht)
+{
+    yfFlowHashSlot_t  *old = ht->slots;
+    uint32_t          old_cap = ht->mask + 1;
+    uint32_t          i, j;
+
+    if (old_cap >= YF_FLOW_HASH_MAX) {
+        return;
+    }
+
+    ht->slots = g_new0(yfFlowHashSlot_t, 2 * old_cap);
+    ht->mask = 2 * old_cap - 1;
+    ++(ht->grown);
+
+    for (i = 0; i < old_cap; ++i) {
+        if (old[i].fn) {
+            for (j = old[i].hash & ht->mask; ht->slots[j].fn;
+                 j = (j + 1) & ht->mask);
+            ht->slots[j] = old[i];
+        }
+    }
+
+    g_free(old);
+}
+
+/**
+ * yfFlowHashLookup
+ *
+ * find the flow to which a packet with the given key belongs, in
+ * either direction, with a single walk of the probe sequence.  Stores
+ * the hash of the key in hashp for a following yfFlowHashInsert() and
+ * sets revp to TRUE when the key matched the reverse direction of the
+ * flow.
+ *
+ * @return the flow node, or NULL if there is none
+ */
+static yfFlowNode_t *yfFlowHashLookup(
+    yfFlowHash_t      *ht,
+    yfFlowKey_t       *key,
+    uint32_t          *hashp,
+    gboolean          *revp)
+{
+    yfFlowHashSlot_t  *slot;
+    yfFlowKey_t       rkey;
+    gboolean          have_rkey = FALSE;
+    uint32_t          hash = yfFlowKeyHashCanon(key);
+    uint32_t          i;
+
+    *hashp = hash;
+
+    for (i = hash & ht->mask; ht->slots[i].fn; i = (i + 1) & ht->mask) {
+        slot = &(ht->slots[i]);
+        if (slot->hash != hash) {
+            continue;
+        }
+        if (yfFlowKeyEqual(key, &(slot->fn->f.key))) {
+            *revp = FALSE;
+            return slot->fn;
+        }
+        if (!have_rkey) {
+            yfFlowKeyReverse(key, &rkey);
+            have_rkey = TRUE;
+        }
+        if (yfFlowKeyEqual(&rkey, &(slot->fn->f.key))) {
+            *revp = TRUE;
+            return slot->fn;
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * yfFlowHashFull
+ *
+ * check whether a flow key table has reached YF_FLOW_HASH_MAX slots and
+ * is half full, so that it can no longer grow.
+ *
+ * @return TRUE if no flow may be inserted into the table
+ */
+static gboolean yfFlowHashFull(
+    yfFlowHash_t      *ht)
+{
+    return (ht->mask + 1 >= YF_FLOW_HASH_MAX &&
+            ht->count >= (ht->mask >> 1));
+}
+
+/**
+ * yfFlowHashInsert
+ *
+ * add a flow node whose key hashes to hash to a flow key table.  The
+ * caller must have checked that the flow is not already present, and
+ * that the table is not full (see yfFlowHashFull()); a full table has
+ * no empty slot at which the probe could stop.
+ *
+ */
+static void yfFlowHashInsert(
+    yfFlowHash_t      *ht,
+    uint32_t          hash,
+    yfFlowNode_t      *fn)
+{
+    uint32_t          i;
+
+    /* keep the table at most half full */
+    if (ht->count >= (ht->mask >> 1)) {
+        yfFlowHashGrow(ht);
+    }
+
+    for (i = hash & ht->mask; ht->slots[i].fn; i = (i + 1) & ht->mask);
+    ht->slots[i].hash = hash;
+    ht->slots[i].fn = fn;
+    ++(ht->count);
+}
+
+/**
+ * yfFlowHashRemove
+ *
+ * remove a flow node from a flow key table, then move later entries of
+ * the probe run back so that no lookup stops early at the emptied slot.
+ *
+ */
+static void yfFlowHashRemove(
+    yfFlowHash_t      *ht,
+    yfFlowNode_t      *fn)
+{
+    uint32_t          i, j, home;
+
+    for (i = yfFlowKeyHashCanon(&(fn->f.key)) & ht->mask;
+         ht->slots[i].fn != fn;
+         i = (i + 1) & ht->mask)
+    {
+        if (NULL == ht->slots[i].fn) {
+            /* not in table */
+            return;
+        }
+    }
+
+    for (j = (i + 1) & ht->mask; ht->slots[j].fn; j = (j + 1) & ht->mask) {
+        /* the entry in j may fill the hole in i unless its home slot
+         * lies after i on the run leading up to j */
+        home = ht->slots[j].hash & ht->mask;
+        if (((j - home) & ht->mask) >= ((j - i) & ht->mask)) {
+            ht->slots[i] = ht->slots[j];
+            i = j;
+        }
+    }
+
+    ht->slots[i].fn = NULL;
+    --(ht->count);
+}
+
+/**
+ * yfFlowNodePoolInit
+ *
+ * set up a pool of flow nodes of node_sz bytes each, reserving room for
+ * count nodes up front when count is non-zero.
+ *
+ */
+static void yfFlowNodePoolInit(
+    yfFlowNodePool_t  *pool,
+    size_t            node_sz,
+    uint32_t          count)
+{
+    yfFlowNodeChunk_t *chunk;
+
+    memset(pool, 0, sizeof(*pool));
+    pool->node_sz = node_sz;
+
+    if (count) {
+        /* the chunk is not zeroed, so its pages are only touched as
+         * nodes are handed out */
+        chunk = g_new0(yfFlowNodeChunk_t, 1);
+        chunk->nodes = g_malloc(node_sz * count);
+        pool->chunks = chunk;
+        pool->next = chunk->nodes;
+        pool->end = chunk->nodes + (node_sz * count);
+        pool->count = count;
+    }
+}
+
+/**
+ * yfFlowNodePoolFree
+ *
+ * release all memory held by a pool of flow nodes.
+ *
+ */
+static void yfFlowNodePoolFree(
+    yfFlowNodePool_t  *pool)
+{
+    yfFlowNodeChunk_t *chunk, *next;
+
+    for (chunk = pool->chunks; chunk; chunk = next) {
+        next = chunk->next;
+        g_free(chunk->nodes);
+        g_free(chunk);
+    }
+    memset(pool, 0, sizeof(*pool));
+}
+
+/**
+ * yfFlowNodeGet
+ *
+ * take a zeroed flow node from a pool, adding a chunk to the pool when
+ * it has no free nodes left.
+ *
+ */
+static yfFlowNode_t *yfFlowNodeGet(
+    yfFlowNodePool_t  *pool)
+{
+    yfFlowNodeChunk_t *chunk;
+    yfFlowNode_t      *fn;
+
+    if (pool->free) {
+        fn = pool->free;
+        pool->free = fn->n;
+    } else {
+        if (pool->next == pool->end) {
+            chunk = g_new0(yfFlowNodeChunk_t, 1);
+            chunk->nodes = g_malloc(pool->node_sz * YF_NODE_POOL_CHUNK);
+            chunk->next = pool->chunks;
+            pool->chunks = chunk;
+            pool->next = chunk->nodes;
+            pool->end = chunk->nodes + (pool->node_sz * YF_NODE_POOL_CHUNK);
+            pool->count += YF_NODE_POOL_CHUNK;
+        }
+        fn = (yfFlowNode_t *)pool->next;
+        pool->next += pool->node_sz;
+    }
+
+    if (++(pool->inuse) > pool->peak) {
+        pool->peak = pool->inuse;
+    }
+
+    memset(fn, 0, pool->node_sz);
+    return fn;
+}
+
+/**
+ * yfFlowNodePut
+ *
+ * return a flow node to the pool it came from.
+ *
+ */
+static void yfFlowNodePut(
+    yfFlowNodePool_t  *pool,
+    yfFlowNode_t      *fn)
+{
+    fn->n = pool->free;
+    pool->free = fn;
+    --(pool->inuse);
+}
+
+/**
+ * yfFlowNodeAlloc
+ *
+ * allocate a zeroed flow node large enough for a flow of the given IP
+ * version.
+ *
+ */
+static yfFlowNode_t *yfFlowNodeAlloc(
+    yfFlowTab_t       *flowtab,
+    uint8_t           version)
+{
+#if YAF_ENABLE_COMPACT_IP4
+    if (version == 4) {
+        return yfFlowNodeGet(&(flowtab->pool4));
+    }
+#endif
+    return yfFlowNodeGet(&(flowtab->pool));
+}
+
+/**
+ * yfFlowNodeRelease
+ *
+ * give a flow node back to the pool matching the IP version of its key.
+ *
+ */
+static void yfFlowNodeRelease(
+    yfFlowTab_t       *flowtab,
+    yfFlowNode_t      *fn)
+{
+#if YAF_ENABLE_COMPACT_IP4
+    if (fn->f.key.version == 4) {
+        yfFlowNodePut(&(flowtab->pool4), fn);
+        return;
+    }
+#endif
+    yfFlowNodePut(&(flowtab->pool), fn);
+}
+
+#if YAF_ENABLE_PAYLOAD
+/**
+ * yfPayArenaInit
+ *
+ * set up an empty payload arena for buffers of at most max_payload
+ * bytes.
+ *
+ */
+static void yfPayArenaInit(
+    yfPayArena_t      *arena,
+    uint32_t          max_payload)
+{
+    memset(arena, 0, sizeof(*arena));
+    arena->max_payload = max_payload;
+}
+
+/**
+ * yfPayClassSize
+ *
+ * returns the buffer size of a payload size class.
+ *
+ */
+static uint32_t yfPayClassSize(
+    yfPayArena_t      *arena,
+    unsigned int      cls)
+{
+    uint64_t          size = (uint64_t)YF_PAY_CLASS_MIN << cls;
+
+    return (size < arena->max_payload) ? (uint32_t)size : arena->max_payload;
+}
+
+/**
+ * yfPayClass
+ *
+ * returns the smallest payload size class holding need bytes.
+ *
+ */
+static unsigned int yfPayClass(
+    yfPayArena_t      *arena,
+    uint32_t          need)
+{
+    unsigned int      cls = 0;
+
+    while (cls < YF_PAY_CLASSES - 1 && yfPayClassSize(arena, cls) < need) {
+        ++cls;
+    }
+    return cls;
+}
+
+/**
+ * yfPayArenaFree
+ *
+ * release all buffers on the free lists of a payload arena.
+ *
+ */
+static void yfPayArenaFree(
+    yfPayArena_t      *arena)
+{
+    yfPayBuf_t        *buf, *next;
+    unsigned int      cls;
+
+    for (cls = 0; cls < YF_PAY_CLASSES; cls++) {
+        for (buf = arena->free[cls]; buf; buf = next) {
+            next = buf->next;
+            yg_slice_free1(MAX(yfPayClassSize(arena, cls),
+                               sizeof(yfPayBuf_t)), buf);
+        }
+    }
+    memset(arena, 0, sizeof(*arena));
+}
+
+/**
+ * yfPayGet
+ *
+ * take an unzeroed buffer of at least need bytes from a payload arena,
+ * storing its size in cap.
+ *
+ */
+static uint8_t *yfPayGet(
+    yfPayArena_t      *arena,
+    uint32_t          need,
+    uint32_t          *cap)
+{
+    unsigned int      cls = yfPayClass(arena, need);
+    yfPayBuf_t        *buf;
+
+    *cap = yfPayClassSize(arena, cls);
+
+    if (arena->free[cls]) {
+        buf = arena->free[cls];
+        arena->free[cls] = buf->next;
+        ++(arena->reuses);
+    } else {
+        buf = yg_slice_alloc(MAX(*cap, sizeof(yfPayBuf_t)));
+        arena->held += *cap;
+    }
+    ++(arena->allocs);
+
+    arena->inuse += *cap;
+    if (arena->inuse > arena->peak) {
+        arena->peak = arena->inuse;
+    }
+
+    return (uint8_t *)buf;
+}
+
+/**
+ * yfPayPut
+ *
+ * return a payload buffer of cap bytes to the arena it came from.
+ *
+ */
+static void yfPayPut(
+    yfPayArena_t      *arena,
+    uint8_t           *payload,
+    uint32_t          cap)
+{
+    unsigned int      cls = yfPayClass(arena, cap);
+    yfPayBuf_t        *buf = (yfPayBuf_t *)payload;
+
+    buf->next = arena->free[cls];
+    arena->free[cls] = buf;
+    arena->inuse -= cap;
+}
+
+/**
+ * yfFlowPayloadReserve
+ *
+ * make sure a flow value has a payload buffer of at least need bytes,
+ * moving its captured payload to a larger buffer if necessary.  need
+ * must not exceed the payload limit of the flow table.
+ *
+ */
+static void yfFlowPayloadReserve(
+    yfFlowTab_t       *flowtab,
+    yfFlowVal_t       *val,
+    uint32_t          need)
+{
+    uint8_t           *payload;
+    uint32_t          cap;
+
+    if (val->payload && need <= val->paycap) {
+        return;
+    }
+
+    payload = yfPayGet(&(flowtab->payarena), need, &cap);
+    if (val->payload) {
+        memcpy(payload, val->payload, val->paylen);
+        yfPayPut(&(flowtab->payarena), val->payload, val->paycap);
+    }
+    val->payload = payload;
+    val->paycap = cap;
+}
+#endif
+
 /**
  *yfFlowIncrementUniflow
  *
@@ -609,7 +1309,7 @@ static void yfMPLSNodeFree(
 {
     g_hash_table_remove(flowtab->table, mpls);
 
-    g_hash_table_destroy(mpls->tab);
+    yfFlowHashFree(mpls->tab);
 
     yg_slice_free(yfMPLSNode_t, mpls);
 
@@ -634,12 +1334,13 @@ static void yfFlowFree(
 #if YAF_ENABLE_PAYLOAD
     /* free payload if present */
     if (fn->f.val.payload) {
-        yg_slice_free1(flowtab->max_payload, fn->f.val.payload);
+        yfPayPut(&(flowtab->payarena), fn->f.val.payload, fn->f.val.paycap);
         yg_slice_free1((sizeof(size_t) * YAF_MAX_PKT_BOUNDARY),
                        fn->f.val.paybounds);
     }
     if (fn->f.rval.payload) {
-        yg_slice_free1(flowtab->max_payload, fn->f.rval.payload);
+        yfPayPut(&(flowtab->payarena), fn->f.rval.payload,
+                 fn->f.rval.paycap);
         yg_slice_free1((sizeof(size_t) * YAF_MAX_PKT_BOUNDARY),
                        fn->f.rval.paybounds);
     }
@@ -691,15 +1392,7 @@ static void yfFlowFree(
 #endif
 
     /* free flow */
-#if YAF_ENABLE_COMPACT_IP4
-    if (fn->f.key.version == 4) {
-        yg_slice_free(yfFlowNodeIPv4_t, (yfFlowNodeIPv4_t *)fn);
-    } else {
-#endif
-        yg_slice_free(yfFlowNode_t, fn);
-#if YAF_ENABLE_COMPACT_IP4
-    }
-#endif
+    yfFlowNodeRelease(flowtab, fn);
 }
 
 /**
@@ -823,6 +1516,77 @@ static void yfFlowDoEntropy(
 }
 #endif
 
+#if YAF_ENABLE_PAYLOAD
+/**
+ * yfFlowInspect
+ *
+ * run the payload inspection that is done when a flow is closed:
+ * application labeling, entropy, and the flow close hooks
+ *
+ * @param flowtab pointer to the flow table
+ * @param fn pointer to the flow node entry in the table
+ *
+ */
+static void yfFlowInspect(
+    yfFlowTab_t                     *flowtab,
+    yfFlowNode_t                    *fn)
+{
+#if YAF_ENABLE_APPLABEL
+    /* do application label processing if necessary */
+    if (flowtab->applabelmode) {
+        yfFlowLabelApp(flowtab, fn);
+    }
+#endif
+
+#if YAF_ENABLE_ENTROPY
+    /* do entropy calculation if necessary */
+    if (flowtab->entropymode) {
+        yfFlowDoEntropy(flowtab, fn);
+    }
+#endif
+
+#if YAF_ENABLE_HOOKS
+    yfHookFlowClose(&(fn->f));
+#endif
+}
+
+/**
+ * yfFlowInspectJob
+ *
+ * payload inspection thread job: inspect a closed flow, then mark it
+ * ready to be written
+ *
+ * @param vflowtab pointer to the flow table
+ * @param vfn pointer to the flow node entry in the table
+ *
+ */
+static void yfFlowInspectJob(
+    void                            *vflowtab,
+    void                            *vfn)
+{
+    yfFlowNode_t                    *fn = (yfFlowNode_t *)vfn;
+
+    yfFlowInspect((yfFlowTab_t *)vflowtab, fn);
+
+    __atomic_and_fetch(&(fn->state), ~YAF_STATE_INSPECT, __ATOMIC_RELEASE);
+}
+#endif
+
+/**
+ * yfFlowInspected
+ *
+ * returns FALSE if a closed flow is still queued for payload inspection
+ *
+ */
+static gboolean yfFlowInspected(
+    void                            *vfn)
+{
+    yfFlowNode_t                    *fn = (yfFlowNode_t *)vfn;
+
+    return !(__atomic_load_n(&(fn->state), __ATOMIC_ACQUIRE) &
+             YAF_STATE_INSPECT);
+}
+
 /**
  * yfFlowClose
  *
@@ -842,10 +1606,10 @@ static void yfFlowClose(
 {
 
 #if YAF_MPLS
-    g_hash_table_remove(fn->f.mpls->tab, &(fn->f.key));
+    yfFlowHashRemove(fn->f.mpls->tab, fn);
 #else
     /* remove flow from table */
-    g_hash_table_remove(flowtab->table, &(fn->f.key));
+    yfFlowHashRemove(flowtab->table, fn);
 #endif
 
     /* store closure reason */
@@ -859,25 +1623,19 @@ static void yfFlowClose(
     piqEnQ(&flowtab->cq, fn);
 
 #if YAF_ENABLE_PAYLOAD
-
-#if YAF_ENABLE_APPLABEL
-    /* do application label processing if necessary */
-    if (flowtab->applabelmode) {
-        yfFlowLabelApp(flowtab, fn);
-    }
-#endif
-
-#if YAF_ENABLE_ENTROPY
-    /* do entropy calculation if necessary */
-    if (flowtab->entropymode) {
-        yfFlowDoEntropy(flowtab, fn);
+    /* leave flows with payload to the inspection threads, if any; if
+       they are behind, inspect the flow here rather than wait */
+    if (flowtab->inspect && (fn->f.val.paylen || fn->f.rval.paylen)) {
+        fn->state |= YAF_STATE_INSPECT;
+        if (!yfInspectSubmit(flowtab->inspect, yfFlowInspectJob,
+                             flowtab, fn))
+        {
+            fn->state &= ~YAF_STATE_INSPECT;
+            yfFlowInspect(flowtab, fn);
+        }
+    } else {
+        yfFlowInspect(flowtab, fn);
     }
-#endif
-
-#if YAF_ENABLE_HOOKS
-    yfHookFlowClose(&(fn->f));
-#endif
-
 #endif
 
     /** count the flow in the close queue */
@@ -938,13 +1696,12 @@ static void yfCloseActiveFlow(
     yfFlowNode_t *tfn;  /*temp flow to write*/
     yfFlowVal_t *valtemp;
 
+    tfn = yfFlowNodeAlloc(flowtab, fn->f.key.version);
 #if YAF_ENABLE_COMPACT_IP4
     if (fn->f.key.version == 4) {
-        tfn = (yfFlowNode_t *) yg_slice_new0(yfFlowNodeIPv4_t);
         memcpy(tfn, fn, sizeof(yfFlowNodeIPv4_t));
     } else {
 #endif
-        tfn = yg_slice_new0(yfFlowNode_t);
         memcpy(tfn, fn, sizeof(yfFlowNode_t));
 #if YAF_ENABLE_COMPACT_IP4
     }
@@ -985,17 +1742,18 @@ static void yfCloseActiveFlow(
     valtemp->stats = NULL;
 #if YAF_ENABLE_PAYLOAD
     valtemp->payload = NULL;
+    valtemp->paycap = 0;
 
     /* Short-circuit no payload capture */
     if (flowtab->max_payload && paylen && pkt) {
 
-        valtemp->payload = yg_slice_alloc0(flowtab->max_payload);
-
         /* truncate capture length to payload limit */
         if (paylen  > flowtab->max_payload) {
             paylen = flowtab->max_payload;
         }
 
+        yfFlowPayloadReserve(flowtab, valtemp, paylen);
+
         /* only need 1 entry in paybounds */
         valtemp->paybounds = (size_t *)yg_slice_alloc0(sizeof(size_t) *
                                                        YAF_MAX_PKT_BOUNDARY);
@@ -1142,9 +1900,22 @@ yfFlowTab_t *yfFlowTabAlloc(
     flowtab->table = g_hash_table_new((GHashFunc)yfMPLSHash,
                                       (GEqualFunc)yfMPLSEqual);
 #else
-    /* Allocate key index table */
-    flowtab->table = g_hash_table_new((GHashFunc)yfFlowKeyHash,
-                                      (GEqualFunc)yfFlowKeyEqual);
+    /* Allocate key index table, sized so the flow limit leaves it at
+     * most half full */
+    flowtab->table = yfFlowHashAlloc(max_flows ? (2 * (uint64_t)max_flows)
+                                     : YF_FLOW_HASH_INIT);
+#endif
+
+    /* Reserve nodes for the flow limit plus a full close queue */
+#if YAF_ENABLE_COMPACT_IP4
+    yfFlowNodePoolInit(&(flowtab->pool4), sizeof(yfFlowNodeIPv4_t),
+                       max_flows ? (max_flows + YF_MAX_CQ) : 0);
+#endif
+    yfFlowNodePoolInit(&(flowtab->pool), sizeof(yfFlowNode_t),
+                       max_flows ? (max_flows + YF_MAX_CQ) : 0);
+
+#if YAF_ENABLE_PAYLOAD
+    yfPayArenaInit(&(flowtab->payarena), max_payload);
 #endif
 
 #if YAF_ENABLE_HOOKS
@@ -1170,6 +1941,9 @@ void yfFlowTabFree(
     /* zip through the close queue freeing flows */
     for (fn = flowtab->cq.head; fn; fn = nfn) {
         nfn = fn->p;
+        if (!yfFlowInspected(fn)) {
+            yfInspectWait(flowtab->inspect, yfFlowInspected, fn);
+        }
         yfFlowFree(flowtab, fn);
     }
 
@@ -1193,7 +1967,22 @@ void yfFlowTabFree(
     }
 
    /* free the key index table */
+#if YAF_MPLS
     g_hash_table_destroy(flowtab->table);
+#else
+    yfFlowHashFree(flowtab->table);
+#endif
+
+    /* free the flow nodes */
+#if YAF_ENABLE_COMPACT_IP4
+    yfFlowNodePoolFree(&(flowtab->pool4));
+#endif
+    yfFlowNodePoolFree(&(flowtab->pool));
+
+#if YAF_ENABLE_PAYLOAD
+    /* free the payload buffers */
+    yfPayArenaFree(&(flowtab->payarena));
+#endif
 
     /* now free the flow table */
     yg_slice_free(yfFlowTab_t, flowtab);
@@ -1227,8 +2016,7 @@ static yfMPLSNode_t *yfMPLSGetNode(
     memcpy(mpls->mpls_label, l2info->mpls_label, sizeof(uint32_t)*3);
 
     /* Allocate key index table */
-    mpls->tab = g_hash_table_new((GHashFunc)yfFlowKeyHash,
-                                 (GEqualFunc)yfFlowKeyEqual);
+    mpls->tab = yfFlowHashAlloc(YF_FLOW_HASH_MPLS_INIT);
     flowtab->cur_mpls_node = mpls;
 
     g_hash_table_insert(flowtab->table, mpls, mpls);
@@ -1244,6 +2032,35 @@ static yfMPLSNode_t *yfMPLSGetNode(
     return mpls;
 }
 #endif
+/**
+ * yfFlowMakeRoom
+ *
+ * make room for a new flow in a flow key table that can no longer grow
+ * by closing the oldest active flows in that table.
+ *
+ */
+static void yfFlowMakeRoom(
+    yfFlowTab_t             *flowtab,
+    yfFlowHash_t            *ht)
+{
+#if YAF_MPLS
+    yfFlowNode_t            *fn;
+    yfFlowNode_t            *nfn;
+
+    /* each label stack has its own table; skip flows in other tables */
+    for (fn = flowtab->aq.tail; fn && yfFlowHashFull(ht); fn = nfn) {
+        nfn = fn->n;
+        if (fn->f.mpls->tab == ht) {
+            yfFlowClose(flowtab, fn, YAF_END_RESOURCE);
+        }
+    }
+#else
+    while (flowtab->aq.tail && yfFlowHashFull(ht)) {
+        yfFlowClose(flowtab, flowtab->aq.tail, YAF_END_RESOURCE);
+    }
+#endif
+}
+
 /**
  * yfFlowGetNode
  *
@@ -1256,9 +2073,10 @@ static yfFlowNode_t *yfFlowGetNode(
     yfFlowKey_t             *key,
     yfFlowVal_t             **valp)
 {
-    yfFlowKey_t             rkey;
     yfFlowNode_t            *fn;
-    GHashTable              *ht;
+    yfFlowHash_t            *ht;
+    uint32_t                hash;
+    gboolean                rev;
 
 #if YAF_MPLS
     ht = flowtab->cur_mpls_node->tab;
@@ -1266,32 +2084,23 @@ static yfFlowNode_t *yfFlowGetNode(
     ht = flowtab->table;
 #endif
 
-    /* Look for flow in table */
-    if ((fn = g_hash_table_lookup(ht, key))) {
-        /* Forward flow found. */
-        *valp = &(fn->f.val);
-        return fn;
-    }
-
-    /* Okay. Check for reverse flow. */
-    yfFlowKeyReverse(key, &rkey);
-    if ((fn = g_hash_table_lookup(ht, &rkey))) {
-        /* Reverse flow found. */
-        *valp = &(fn->f.rval);
-        fn->f.rtos = key->tos;
+    /* Look for flow in either direction in table */
+    if ((fn = yfFlowHashLookup(ht, key, &hash, &rev))) {
+        if (!rev) {
+            /* Forward flow found. */
+            *valp = &(fn->f.val);
+        } else {
+            /* Reverse flow found. */
+            *valp = &(fn->f.rval);
+            fn->f.rtos = key->tos;
+        }
         return fn;
     }
 
     /* Neither exists. Create a new flow and put it in the table. */
-#if YAF_ENABLE_COMPACT_IP4
-    if (key->version == 4) {
-        fn = (yfFlowNode_t *)yg_slice_new0(yfFlowNodeIPv4_t);
-    } else {
-#endif
-        fn = yg_slice_new0(yfFlowNode_t);
-#if YAF_ENABLE_COMPACT_IP4
-    }
-#endif
+    yfFlowMakeRoom(flowtab, ht);
+    fn = yfFlowNodeAlloc(flowtab, key->version);
+
     /* Copy key */
     yfFlowKeyCopy(key, &(fn->f.key));
 
@@ -1302,7 +2111,7 @@ static yfFlowNode_t *yfFlowGetNode(
     fn->f.etime = flowtab->ctime;
 
     /* stuff the flow in the table */
-    g_hash_table_insert(ht, &(fn->f.key), fn);
+    yfFlowHashInsert(ht, hash, fn);
 
 #if YAF_MPLS
     fn->f.mpls = flowtab->cur_mpls_node;
@@ -1707,13 +2516,13 @@ static void yfFlowPktGenericTpt(
         caplen = flowtab->max_payload - val->paylen;
     }
 
-    /* allocate */
+    /* allocate, or grow the buffer to fit */
 
     if (!val->payload) {
-        val->payload = yg_slice_alloc0(flowtab->max_payload);
         val->paybounds = (size_t *)yg_slice_alloc0(sizeof(size_t) *
                                                    YAF_MAX_PKT_BOUNDARY);
     }
+    yfFlowPayloadReserve(flowtab, val, val->paylen + caplen);
 
     memcpy(val->payload + val->paylen, pkt, caplen);
 
@@ -1899,7 +2708,7 @@ static void yfFlowPktTCP(
 
     /* allocate and copy */
     if (!val->payload) {
-        val->payload = yg_slice_alloc0(flowtab->max_payload);
+        yfFlowPayloadReserve(flowtab, val, 0);
         val->paybounds = (size_t *)yg_slice_alloc0(sizeof(size_t) *
                                                    YAF_MAX_PKT_BOUNDARY);
     }
@@ -1927,6 +2736,12 @@ static void yfFlowPktTCP(
         }
     }
 
+    yfFlowPayloadReserve(flowtab, val, appdata_po + caplen);
+
+    /* buffers are not zeroed, so clear any hole left by missing segments */
+    if (val->paylen < appdata_po) {
+        memset(val->payload + val->paylen, 0, appdata_po - val->paylen);
+    }
     if (val->paylen < appdata_po + caplen) {
         val->paylen = appdata_po + caplen;
     }
@@ -2001,13 +2816,14 @@ yfAddOutOfSequence(
     uint16_t                datalen = (pbuf->iplen - pbuf->allHeaderLen +
                                        l2info->l2hlen);
     uint32_t                pcap_len = 0;
+    uint32_t                hash;
     gboolean                rev = FALSE;
-    GHashTable              *ht;
+    yfFlowHash_t            *ht;
 #if YAF_MPLS
     yfMPLSNode_t            *mpls = NULL;
 
-    ht = flowtab->cur_mpls_node->tab;
     mpls = yfMPLSGetNode(flowtab, l2info);
+    ht = mpls->tab;
 #else
     ht = flowtab->table;
 #endif
@@ -2026,33 +2842,27 @@ yfAddOutOfSequence(
         }
     }
 
-    /* Look for flow in table */
-    if ((fn = g_hash_table_lookup(ht, key))) {
-        /* Forward flow found. */
-        val = &(fn->f.val);
+    /* Look for flow in either direction in table */
+    if ((fn = yfFlowHashLookup(ht, key, &hash, &rev))) {
+        if (!rev) {
+            /* Forward flow found. */
+            val = &(fn->f.val);
+        } else {
+            /* Reverse flow found. */
+            val = &(fn->f.rval);
+        }
     }
 
-    if (fn == NULL) {
-        /* Okay. Check for reverse flow. */
+    if (fn == NULL || rev) {
         yfFlowKeyReverse(key, &rkey);
         rev = TRUE;
-        if ((fn = g_hash_table_lookup(ht, &rkey))) {
-            /* Reverse flow found. */
-            val = &(fn->f.rval);
-        }
     }
 
     if (fn == NULL) {
         /* Neither exists. Create a new flow and put it in the table. */
-#if YAF_ENABLE_COMPACT_IP4
-        if (key->version == 4) {
-            fn = (yfFlowNode_t *)yg_slice_new0(yfFlowNodeIPv4_t);
-        } else {
-#endif
-            fn = yg_slice_new0(yfFlowNode_t);
-#if YAF_ENABLE_COMPACT_IP4
-        }
-#endif
+        yfFlowMakeRoom(flowtab, ht);
+        fn = yfFlowNodeAlloc(flowtab, key->version);
+
         /* Copy key */
         yfFlowKeyCopy(key, &(fn->f.key));
 
@@ -2063,7 +2873,7 @@ yfAddOutOfSequence(
         fn->f.etime = pbuf->ptime;
 
         /* stuff the flow in the table */
-        g_hash_table_insert(ht, &(fn->f.key), fn);
+        yfFlowHashInsert(ht, hash, fn);
 
         /* This is a forward flow */
         val = &(fn->f.val);
@@ -2285,6 +3095,32 @@ yfAddOutOfSequence(
 }
 
 
+/**
+ * yfFlowPBufPrefetch
+ *
+ * start loading the flow key table slot that the given packet will
+ * probe, so that it is in cache by the time yfFlowPBuf() reaches the
+ * packet.  Does nothing in MPLS mode, where the key table depends on
+ * the MPLS node current at the time the packet is processed.
+ *
+ * @param flowtab pointer to the flow table
+ * @param pbuf pointer to a packet that has not been processed yet
+ *
+ */
+void yfFlowPBufPrefetch(
+    yfFlowTab_t                 *UNUSED(flowtab),
+    yfPBuf_t                    *UNUSED(pbuf))
+{
+#if !YAF_MPLS && defined(__GNUC__)
+    yfFlowHash_t                *ht = flowtab->table;
+
+    if (pbuf->ptime) {
+        __builtin_prefetch(
+            &(ht->slots[yfFlowKeyHashCanon(&(pbuf->key)) & ht->mask]));
+    }
+#endif
+}
+
 /**
  * yfFlowPBuf
  *
@@ -2628,7 +3464,7 @@ gboolean yfFlowTabFlush(
     GError          **err)
 {
     gboolean        wok = TRUE;
-    yfFlowNode_t    *fn = NULL;
+    yfFlowNode_t    *fn = NULL, *nfn = NULL;
     yfFlow_t        uf;
     yfContext_t     *ctx = (yfContext_t *)yfContext;
     yfFlowTab_t     *flowtab = ctx->flowtab;
@@ -2667,8 +3503,22 @@ gboolean yfFlowTabFlush(
         yfFlowClose(flowtab, flowtab->aq.tail, YAF_END_FORCED);
     }
 
-    /* flush flows from close queue */
-    while ((fn = piqDeQ(&flowtab->cq))) {
+    /* flush flows from close queue, oldest first */
+    for (fn = flowtab->cq.tail; fn; fn = nfn) {
+        nfn = fn->n;
+        if (!yfFlowInspected(fn)) {
+            if (close) {
+                yfInspectWait(flowtab->inspect, yfFlowInspected, fn);
+            } else if (yfInspectOrdered(flowtab->inspect)) {
+                /* flows closed after this one wait for it */
+                break;
+            } else {
+                /* write it at a later flush */
+                continue;
+            }
+        }
+        piqPick(&flowtab->cq, fn);
+
         /* quick accounting of asymmetric/uniflow records present */
         if ((fn->f.rval.oct == 0) && (fn->f.rval.pkt == 0)) {
             ++(flowtab->stats.stat_uniflows);
@@ -2719,6 +3569,49 @@ uint64_t yfFlowTabCurrentTime(
     return flowtab->ctime;
 }
 
+/**
+ * yfFlowTabAdvanceTime
+ *
+ *
+ *
+ *
+ */
+void yfFlowTabAdvanceTime(
+    yfFlowTab_t     *flowtab,
+    uint64_t        ctime)
+{
+    if (ctime > flowtab->ctime) {
+        flowtab->ctime = ctime;
+    }
+}
+
+/**
+ * yfFlowTabSetInspect
+ *
+ *
+ *
+ *
+ */
+void yfFlowTabSetInspect(
+    yfFlowTab_t         *flowtab,
+    struct yfInspect_st *inspect)
+{
+    flowtab->inspect = inspect;
+}
+
+/**
+ * yfFlowPBufHash
+ *
+ *
+ *
+ *
+ */
+uint32_t yfFlowPBufHash(
+    yfPBuf_t                    *pbuf)
+{
+    return yfFlowKeyHashCanon(&(pbuf->key));
+}
+
 
 /**
  * yfFlowDumpStats
@@ -2750,8 +3643,32 @@ uint64_t yfFlowDumpStats(
     }
     g_debug("  Maximum flow table size %u.", flowtab->stats.stat_peak);
     g_debug("  %u flush events.", flowtab->stats.stat_flush);
+    yfInspectDumpStats(flowtab->inspect);
 #if YAF_MPLS
     g_debug("  %u Max. MPLS Nodes.", flowtab->stats.max_mpls_labels);
+#else
+    g_debug("  Flow key table %u slots, grown %u times.",
+            flowtab->table->mask + 1, flowtab->table->grown);
+#endif
+#if YAF_ENABLE_COMPACT_IP4
+    g_debug("  %u flow nodes allocated, peak %u IPv4 and %u IPv6 in use.",
+            flowtab->pool.count + flowtab->pool4.count,
+            flowtab->pool4.peak, flowtab->pool.peak);
+#else
+    g_debug("  %u flow nodes allocated, peak %u in use.",
+            flowtab->pool.count, flowtab->pool.peak);
+#endif
+#if YAF_ENABLE_PAYLOAD
+    if (flowtab->payarena.allocs) {
+        g_debug("  Payload buffers: %"PRIu64" bytes held, peak %"PRIu64
+                " bytes in use.", flowtab->payarena.held,
+                flowtab->payarena.peak);
+        g_debug("  %"PRIu64" payload buffers handed out, %"PRIu64
+                " reused (%2.2f%%).", flowtab->payarena.allocs,
+                flowtab->payarena.reuses,
+                ((double)flowtab->payarena.reuses /
+                 (double)flowtab->payarena.allocs) * 100);
+    }
 #endif
     if (flowtab->stats.stat_seqrej) {
         g_warning("Rejected %"PRIu64" out-of-sequence packets.",
@@ -0,0 +1,595 @@
+/*
+ ** yafthread.c
+ ** YAF flow table worker threads
+ **
+ ** ------------------------------------------------------------------------
+ ** Copyright (C) 2006-2016 Carnegie Mellon University. All Rights Reserved.
+ ** ------------------------------------------------------------------------
+ ** @OPENSOURCE_HEADER_START@
+ ** Use of the YAF system and related source code is subject to the terms
+ ** of the following licenses:
+ **
+ ** GNU Public License (GPL) Rights pursuant to Version 2, June 1991
+ ** Government Purpose License Rights (GPLR) pursuant to DFARS 252.227.7013
+ **
+ ** NO WARRANTY
+ **
+ ** ANY INFORMATION, MATERIALS, SERVICES, INTELLECTUAL PROPERTY OR OTHER
+ ** PROPERTY OR RIGHTS GRANTED OR PROVIDED BY CARNEGIE MELLON UNIVERSITY
+ ** PURSUANT TO THIS LICENSE (HEREINAFTER THE "DELIVERABLES") ARE ON AN
+ ** "AS-IS" BASIS. CARNEGIE MELLON UNIVERSITY MAKES NO WARRANTIES OF ANY
+ ** KIND, EITHER EXPRESS OR IMPLIED AS TO ANY MATTER INCLUDING, BUT NOT
+ ** LIMITED TO, WARRANTY OF FITNESS FOR A PARTICULAR PURPOSE,
+ ** MERCHANTABILITY, INFORMATIONAL CONTENT, NONINFRINGEMENT, OR ERROR-FREE
+ ** OPERATION. CARNEGIE MELLON UNIVERSITY SHALL NOT BE LIABLE FOR INDIRECT,
+ ** SPECIAL OR CONSEQUENTIAL DAMAGES, SUCH AS LOSS OF PROFITS OR INABILITY
+ ** TO USE SAID INTELLECTUAL PROPERTY, UNDER THIS LICENSE, REGARDLESS OF
+ ** WHETHER SUCH PARTY WAS AWARE OF THE POSSIBILITY OF SUCH DAMAGES.
+ ** LICENSEE AGREES THAT IT WILL NOT MAKE ANY WARRANTY ON BEHALF OF
+ ** CARNEGIE MELLON UNIVERSITY, EXPRESS OR IMPLIED, TO ANY PERSON
+ ** CONCERNING THE APPLICATION OF OR THE RESULTS TO BE OBTAINED WITH THE
+ ** DELIVERABLES UNDER THIS LICENSE.
+ **
+ ** Licensee hereby agrees to defend, indemnify, and hold harmless Carnegie
+ ** Mellon University, its trustees, officers, employees, and agents from
+ ** all claims or demands made against them (and any related losses,
+ ** expenses, or attorney's fees) arising out of, or relating to Licensee's
+ ** and/or its sub licensees' negligent use or willful misuse of or
+ ** negligent conduct or willful misconduct regarding the Software,
+ ** facilities, or other rights or assistance granted by Carnegie Mellon
+ ** University under this License, including, but not limited to, any
+ ** claims of product liability, personal injury, death, damage to
+ ** property, or violation of any laws or regulations.
+ **
+ ** Carnegie Mellon University Software Engineering Institute authored
+ ** documents are sponsored by the U.S. Department of Defense under
+ ** Contract FA8721-05-C-0003. Carnegie Mellon University retains
+ ** copyrights in all material produced under this contract. The U.S.
+ ** Government retains a non-exclusive, royalty-free license to publish or
+ ** reproduce these documents, or allow others to do so, for U.S.
+ ** Government purposes only pursuant to the copyright license under the
+ ** contract clause at 252.227.7013.
+ **
+ ** @OPENSOURCE_HEADER_END@
+ ** ------------------------------------------------------------------------
+ */
+
+#define _YAF_SOURCE_
+#include "yafthread.h"
+#include <yaf/yafcore.h>
+#include <pthread.h>
+#include <signal.h>
+
+/* number of packet messages each worker ring can hold */
+#define YF_THREAD_RING_SIZE     4096
+/* number of packets dispatched to a worker before they are released to it */
+#define YF_THREAD_BATCH         64
+/* number of packets a worker adds to its flow table between flushes */
+#define YF_THREAD_FLUSH_EVERY   256
+
+/* message types */
+#define YF_THREAD_MSG_PACKET    0
+#define YF_THREAD_MSG_TICK      1
+#define YF_THREAD_MSG_STOP      2
+
+/** Worker ring element header; a PACKET message's yfPBuf_t follows it */
+typedef struct yfThreadMsg_st {
+    /** Packet time; for a TICK, the time to advance the flow table to */
+    uint64_t            ptime;
+    /** Message type */
+    uint32_t            type;
+    uint32_t            pad;
+} yfThreadMsg_t;
+
+typedef struct yfThreadWorker_st {
+    /** Worker context; a copy of the main context with its own flow table */
+    yfContext_t         ctx;
+    /** Worker state this worker belongs to */
+    struct yfThreads_st *threads;
+    /** Messages from the capture thread */
+    rgaRing_t           *ring;
+    /** Number of messages reserved in ring but not yet released */
+    size_t              pending;
+    /** Worker thread */
+    pthread_t           thread;
+    gboolean            running;
+    /** Worker index */
+    unsigned int        id;
+    /** Error description, set before the worker fails */
+    GError              *err;
+    /** Flow table statistics as of the last flush; guarded by outlock */
+    uint64_t            packets;
+    uint64_t            flows;
+    uint64_t            rej_pkts;
+    uint32_t            peak;
+    uint32_t            flush;
+} yfThreadWorker_t;
+
+struct yfThreads_st {
+    /** Output lock; guards the output of ctx, failed, and worker stats */
+    pthread_mutex_t     outlock;
+    /** Main context */
+    yfContext_t         *ctx;
+    /** Workers */
+    yfThreadWorker_t    *workers;
+    unsigned int        count;
+    /** Worker ring element size */
+    size_t              elt_sz;
+    /** Latest packet time dispatched */
+    uint64_t            ptime;
+    /** Set when a worker has failed */
+    gboolean            failed;
+    /** Set when the workers have been stopped */
+    gboolean            finished;
+};
+
+/**
+ * yfThreadsAlloc
+ *
+ *
+ *
+ */
+struct yfThreads_st *yfThreadsAlloc(
+    yfContext_t         *ctx,
+    yfFlowTab_t         **tabs,
+    unsigned int        count)
+{
+    struct yfThreads_st *th = NULL;
+    unsigned int        i;
+
+    th = g_slice_new0(struct yfThreads_st);
+    pthread_mutex_init(&th->outlock, NULL);
+    th->ctx = ctx;
+    th->count = count;
+    th->workers = g_new0(yfThreadWorker_t, count);
+
+    /* header plus packet buffer, kept aligned for the header */
+    th->elt_sz = sizeof(yfThreadMsg_t) + ctx->pbuflen;
+    th->elt_sz += (sizeof(uint64_t) - 1);
+    th->elt_sz -= th->elt_sz % sizeof(uint64_t);
+
+    for (i = 0; i < count; i++) {
+        th->workers[i].ctx.flowtab = tabs[i];
+        th->workers[i].threads = th;
+        th->workers[i].id = i;
+        th->workers[i].ring = rgaAllocThreaded(th->elt_sz,
+                                               YF_THREAD_RING_SIZE);
+    }
+
+    return th;
+}
+
+/**
+ * yfThreadsWorkerFail
+ *
+ * Mark a worker as failed and stop it from taking further messages.
+ *
+ */
+static void yfThreadsWorkerFail(
+    yfThreadWorker_t    *w)
+{
+    pthread_mutex_lock(&w->threads->outlock);
+    if (!w->err) {
+        g_set_error(&w->err, YAF_ERROR_DOMAIN, YAF_ERROR_INTERNAL,
+                    "Flow table worker %u failed", w->id);
+    }
+    w->threads->failed = TRUE;
+    pthread_mutex_unlock(&w->threads->outlock);
+
+    rgaSetInterrupt(w->ring);
+}
+
+/**
+ * yfThreadsWorkerFlush
+ *
+ * Write the flows a worker has closed to the main context's output and
+ * publish the worker's flow table statistics.
+ *
+ */
+static gboolean yfThreadsWorkerFlush(
+    yfThreadWorker_t    *w)
+{
+    struct yfThreads_st *th = w->threads;
+    gboolean            ok = TRUE;
+
+    pthread_mutex_lock(&th->outlock);
+
+    /* the output may be closed for rotation; flush at the next tick */
+    if (!th->failed && (th->ctx->fbuf || th->ctx->cfg->no_output)) {
+        w->ctx.fbuf = th->ctx->fbuf;
+        w->ctx.lastUdpTempTime = th->ctx->lastUdpTempTime;
+        ok = yfFlowTabFlush(&w->ctx, FALSE, &w->err);
+        th->ctx->lastUdpTempTime = w->ctx.lastUdpTempTime;
+        w->ctx.fbuf = NULL;
+    }
+
+    yfGetFlowTabStats(w->ctx.flowtab, &w->packets, &w->flows,
+                      &w->rej_pkts, &w->peak, &w->flush);
+
+    pthread_mutex_unlock(&th->outlock);
+
+    return ok;
+}
+
+/**
+ * yfThreadsWorkerMain
+ *
+ * Worker thread: add packets to the worker's flow table until told to
+ * stop.
+ *
+ */
+static void *yfThreadsWorkerMain(
+    void                *arg)
+{
+    yfThreadWorker_t    *w = (yfThreadWorker_t *)arg;
+    yfThreadMsg_t       *msg = NULL;
+    uint32_t            unflushed = 0;
+    gboolean            flush;
+    gboolean            stop = FALSE;
+
+    while (!stop && (msg = (yfThreadMsg_t *)rgaWaitTail(w->ring))) {
+        flush = FALSE;
+        switch (msg->type) {
+          case YF_THREAD_MSG_PACKET:
+            yfFlowPBuf(w->ctx.flowtab, w->ctx.pbuflen, (yfPBuf_t *)(msg + 1));
+            flush = (++unflushed >= YF_THREAD_FLUSH_EVERY);
+            break;
+          case YF_THREAD_MSG_TICK:
+            yfFlowTabAdvanceTime(w->ctx.flowtab, msg->ptime);
+            flush = TRUE;
+            break;
+          default:
+            stop = TRUE;
+            break;
+        }
+        rgaReleaseTail(w->ring, 1);
+
+        if (flush) {
+            unflushed = 0;
+            if (!yfThreadsWorkerFlush(w)) {
+                yfThreadsWorkerFail(w);
+                break;
+            }
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * yfThreadsError
+ *
+ * Set err to the error of the first failed worker.
+ *
+ */
+static void yfThreadsError(
+    struct yfThreads_st *th,
+    GError              **err)
+{
+    unsigned int        i;
+
+    for (i = 0; i < th->count; i++) {
+        if (th->workers[i].err) {
+            g_propagate_error(err, g_error_copy(th->workers[i].err));
+            return;
+        }
+    }
+    g_set_error(err, YAF_ERROR_DOMAIN, YAF_ERROR_INTERNAL,
+                "Flow table worker failed");
+}
+
+/**
+ * yfThreadsStart
+ *
+ *
+ *
+ */
+gboolean yfThreadsStart(
+    yfContext_t         *ctx,
+    GError              **err)
+{
+    struct yfThreads_st *th = ctx->threads;
+    yfThreadWorker_t    *w = NULL;
+    yfFlowTab_t         *flowtab = NULL;
+    sigset_t            sigs, osigs;
+    unsigned int        i;
+    int                 rv;
+
+    /* signals are left to the capture thread; workers start with all
+     * signals blocked */
+    sigfillset(&sigs);
+    pthread_sigmask(SIG_SETMASK, &sigs, &osigs);
+
+    for (i = 0; i < th->count; i++) {
+        w = &th->workers[i];
+
+        /* workers share the main context but for the flow table */
+        flowtab = w->ctx.flowtab;
+        w->ctx = *ctx;
+        w->ctx.flowtab = flowtab;
+        w->ctx.pbufring = NULL;
+        w->ctx.fbuf = NULL;
+        w->ctx.err = NULL;
+        w->ctx.threads = NULL;
+
+        if ((rv = pthread_create(&w->thread, NULL,
+                                 yfThreadsWorkerMain, w)))
+        {
+            g_set_error(err, YAF_ERROR_DOMAIN, YAF_ERROR_INTERNAL,
+                        "Couldn't start flow table worker %u: %s",
+                        i, strerror(rv));
+            break;
+        }
+        w->running = TRUE;
+    }
+
+    pthread_sigmask(SIG_SETMASK, &osigs, NULL);
+
+    if (i < th->count) {
+        yfThreadsFinish(ctx, FALSE, NULL);
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+/**
+ * yfThreadsDispatch
+ *
+ *
+ *
+ */
+gboolean yfThreadsDispatch(
+    yfContext_t         *ctx,
+    yfPBuf_t            *pbuf,
+    GError              **err)
+{
+    struct yfThreads_st *th = ctx->threads;
+    yfThreadWorker_t    *w = NULL;
+    yfThreadMsg_t       *msg = NULL;
+
+    /* scale the hash to the worker count using its high-order bits */
+    w = &th->workers[((uint64_t)yfFlowPBufHash(pbuf) * th->count) >> 32];
+
+    if (!(msg = (yfThreadMsg_t *)rgaWaitHead(w->ring))) {
+        yfThreadsError(th, err);
+        return FALSE;
+    }
+    msg->ptime = pbuf->ptime;
+    msg->type = YF_THREAD_MSG_PACKET;
+    memcpy(msg + 1, pbuf, ctx->pbuflen);
+
+    if (pbuf->ptime > th->ptime) {
+        th->ptime = pbuf->ptime;
+    }
+
+    /* hand packets over in batches to keep ring locking down */
+    if (++(w->pending) >= YF_THREAD_BATCH) {
+        rgaReleaseHead(w->ring, w->pending);
+        w->pending = 0;
+    }
+
+    return TRUE;
+}
+
+/**
+ * yfThreadsSend
+ *
+ * Send a control message to a worker, releasing any packets pending for
+ * it first.
+ *
+ */
+static gboolean yfThreadsSend(
+    yfThreadWorker_t    *w,
+    uint32_t            type,
+    uint64_t            ptime)
+{
+    yfThreadMsg_t       *msg = NULL;
+
+    if (!(msg = (yfThreadMsg_t *)rgaWaitHead(w->ring))) {
+        w->pending = 0;
+        return FALSE;
+    }
+    msg->ptime = ptime;
+    msg->type = type;
+    rgaReleaseHead(w->ring, w->pending + 1);
+    w->pending = 0;
+
+    return TRUE;
+}
+
+/**
+ * yfThreadsRelease
+ *
+ *
+ *
+ */
+gboolean yfThreadsRelease(
+    yfContext_t         *ctx,
+    GError              **err)
+{
+    struct yfThreads_st *th = ctx->threads;
+    yfThreadWorker_t    *w = NULL;
+    uint64_t            packets = 0, flows = 0, rej_pkts = 0;
+    uint32_t            peak = 0, flush = 0;
+    gboolean            ok = TRUE;
+    unsigned int        i;
+
+    /* every worker gets a tick, so idle flows time out on quiet workers */
+    for (i = 0; i < th->count; i++) {
+        if (!yfThreadsSend(&th->workers[i], YF_THREAD_MSG_TICK, th->ptime)) {
+            ok = FALSE;
+        }
+    }
+
+    pthread_mutex_lock(&th->outlock);
+    if (th->failed) {
+        ok = FALSE;
+    }
+    for (i = 0; i < th->count; i++) {
+        w = &th->workers[i];
+        packets += w->packets;
+        flows += w->flows;
+        rej_pkts += w->rej_pkts;
+        peak += w->peak;
+        flush += w->flush;
+    }
+    pthread_mutex_unlock(&th->outlock);
+
+    if (!ok) {
+        yfThreadsError(th, err);
+        return FALSE;
+    }
+
+    /* the main flow table reports the totals and keeps time for rotation */
+    yfSetFlowTabStats(ctx->flowtab, packets, flows, rej_pkts, peak, flush);
+    yfFlowTabAdvanceTime(ctx->flowtab, th->ptime);
+
+    return TRUE;
+}
+
+/**
+ * yfThreadsFinish
+ *
+ *
+ *
+ */
+gboolean yfThreadsFinish(
+    yfContext_t         *ctx,
+    gboolean            flush,
+    GError              **err)
+{
+    struct yfThreads_st *th = ctx->threads;
+    yfThreadWorker_t    *w = NULL;
+    gboolean            ok = TRUE;
+    unsigned int        i;
+
+    if (!th || th->finished) {
+        return TRUE;
+    }
+    th->finished = TRUE;
+
+    /* stop the workers once they have drained their rings */
+    for (i = 0; i < th->count; i++) {
+        w = &th->workers[i];
+        if (w->running) {
+            yfThreadsSend(w, YF_THREAD_MSG_STOP, th->ptime);
+            pthread_join(w->thread, NULL);
+            w->running = FALSE;
+        }
+    }
+
+    if (th->failed) {
+        yfThreadsError(th, err);
+        ok = FALSE;
+    }
+
+    /* the workers are gone; flush their flow tables from here */
+    for (i = 0; ok && flush && i < th->count; i++) {
+        w = &th->workers[i];
+        w->ctx.fbuf = ctx->fbuf;
+        w->ctx.lastUdpTempTime = ctx->lastUdpTempTime;
+        ok = yfFlowTabFlush(&w->ctx, TRUE, err);
+        ctx->lastUdpTempTime = w->ctx.lastUdpTempTime;
+        w->ctx.fbuf = NULL;
+    }
+
+    yfSetFlowTabStats(ctx->flowtab, 0, 0, 0, 0, 0);
+    for (i = 0; i < th->count; i++) {
+        yfFlowTabAddStats(ctx->flowtab, th->workers[i].ctx.flowtab);
+    }
+
+    return ok;
+}
+
+/**
+ * yfThreadsFree
+ *
+ *
+ *
+ */
+void yfThreadsFree(
+    yfContext_t         *ctx)
+{
+    struct yfThreads_st *th = ctx->threads;
+    yfThreadWorker_t    *w = NULL;
+    unsigned int        i;
+
+    if (!th) {
+        return;
+    }
+
+    yfThreadsFinish(ctx, FALSE, NULL);
+
+    for (i = 0; i < th->count; i++) {
+        w = &th->workers[i];
+        rgaFree(w->ring);
+        if (w->ctx.flowtab) {
+            yfFlowTabFree(w->ctx.flowtab);
+        }
+        g_clear_error(&w->err);
+    }
+    g_free(th->workers);
+    pthread_mutex_destroy(&th->outlock);
+    g_slice_free(struct yfThreads_st, th);
+
+    ctx->threads = NULL;
+}
+
+/**
+ * yfThreadsLockOutput
+ *
+ *
+ *
+ */
+void yfThreadsLockOutput(
+    yfContext_t         *ctx)
+{
+    if (ctx->threads) {
+        pthread_mutex_lock(&ctx->threads->outlock);
+    }
+}
+
+/**
+ * yfThreadsUnlockOutput
+ *
+ *
+ *
+ */
+void yfThreadsUnlockOutput(
+    yfContext_t         *ctx)
+{
+    if (ctx->threads) {
+        pthread_mutex_unlock(&ctx->threads->outlock);
+    }
+}
+
+/**
+ * yfThreadsDumpStats
+ *
+ *
+ *
+ */
+void yfThreadsDumpStats(
+    yfContext_t         *ctx)
+{
+    struct yfThreads_st *th = ctx->threads;
+    yfThreadWorker_t    *w = NULL;
+    unsigned int        i;
+
+    if (!th) {
+        return;
+    }
+
+    pthread_mutex_lock(&th->outlock);
+    for (i = 0; i < th->count; i++) {
+        w = &th->workers[i];
+        if (th->finished) {
+            yfGetFlowTabStats(w->ctx.flowtab, &w->packets, &w->flows,
+                              &w->rej_pkts, &w->peak, &w->flush);
+        }
+        g_debug("  Flow table worker %u: %"PRIu64" packets, %"PRIu64
+                " flows, peak %u.", i, w->packets, w->flows, w->peak);
+    }
+    pthread_mutex_unlock(&th->outlock);
+}
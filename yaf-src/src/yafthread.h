@@ -0,0 +1,181 @@
+/*
+ ** yafthread.h
+ ** YAF flow table worker threads
+ **
+ ** ------------------------------------------------------------------------
+ ** Copyright (C) 2006-2016 Carnegie Mellon University. All Rights Reserved.
+ ** ------------------------------------------------------------------------
+ ** @OPENSOURCE_HEADER_START@
+ ** Use of the YAF system and related source code is subject to the terms
+ ** of the following licenses:
+ **
+ ** GNU Public License (GPL) Rights pursuant to Version 2, June 1991
+ ** Government Purpose License Rights (GPLR) pursuant to DFARS 252.227.7013
+ **
+ ** NO WARRANTY
+ **
+ ** ANY INFORMATION, MATERIALS, SERVICES, INTELLECTUAL PROPERTY OR OTHER
+ ** PROPERTY OR RIGHTS GRANTED OR PROVIDED BY CARNEGIE MELLON UNIVERSITY
+ ** PURSUANT TO THIS LICENSE (HEREINAFTER THE "DELIVERABLES") ARE ON AN
+ ** "AS-IS" BASIS. CARNEGIE MELLON UNIVERSITY MAKES NO WARRANTIES OF ANY
+ ** KIND, EITHER EXPRESS OR IMPLIED AS TO ANY MATTER INCLUDING, BUT NOT
+ ** LIMITED TO, WARRANTY OF FITNESS FOR A PARTICULAR PURPOSE,
+ ** MERCHANTABILITY, INFORMATIONAL CONTENT, NONINFRINGEMENT, OR ERROR-FREE
+ ** OPERATION. CARNEGIE MELLON UNIVERSITY SHALL NOT BE LIABLE FOR INDIRECT,
+ ** SPECIAL OR CONSEQUENTIAL DAMAGES, SUCH AS LOSS OF PROFITS OR INABILITY
+ ** TO USE SAID INTELLECTUAL PROPERTY, UNDER THIS LICENSE, REGARDLESS OF
+ ** WHETHER SUCH PARTY WAS AWARE OF THE POSSIBILITY OF SUCH DAMAGES.
+ ** LICENSEE AGREES THAT IT WILL NOT MAKE ANY WARRANTY ON BEHALF OF
+ ** CARNEGIE MELLON UNIVERSITY, EXPRESS OR IMPLIED, TO ANY PERSON
+ ** CONCERNING THE APPLICATION OF OR THE RESULTS TO BE OBTAINED WITH THE
+ ** DELIVERABLES UNDER THIS LICENSE.
+ **
+ ** Licensee hereby agrees to defend, indemnify, and hold harmless Carnegie
+ ** Mellon University, its trustees, officers, employees, and agents from
+ ** all claims or demands made against them (and any related losses,
+ ** expenses, or attorney's fees) arising out of, or relating to Licensee's
+ ** and/or its sub licensees' negligent use or willful misuse of or
+ ** negligent conduct or willful misconduct regarding the Software,
+ ** facilities, or other rights or assistance granted by Carnegie Mellon
+ ** University under this License, including, but not limited to, any
+ ** claims of product liability, personal injury, death, damage to
+ ** property, or violation of any laws or regulations.
+ **
+ ** Carnegie Mellon University Software Engineering Institute authored
+ ** documents are sponsored by the U.S. Department of Defense under
+ ** Contract FA8721-05-C-0003. Carnegie Mellon University retains
+ ** copyrights in all material produced under this contract. The U.S.
+ ** Government retains a non-exclusive, royalty-free license to publish or
+ ** reproduce these documents, or allow others to do so, for U.S.
+ ** Government purposes only pursuant to the copyright license under the
+ ** contract clause at 252.227.7013.
+ **
+ ** @OPENSOURCE_HEADER_END@
+ ** ------------------------------------------------------------------------
+ */
+
+/*
+ * Flow table worker threads.  With more than one flow table, the packet
+ * ring is drained by the capture thread, which hands each packet to one of
+ * a set of worker threads by a hash of its flow key; each worker owns one
+ * flow table and so sees every packet of the flows assigned to it.  Flows
+ * closed by the workers are written to the single output buffer of the
+ * main context under an output lock, which the capture thread also holds
+ * while it rotates the output or writes statistics.
+ */
+
+#ifndef _YAF_THREAD_H_
+#define _YAF_THREAD_H_
+
+#include <yaf/autoinc.h>
+#include "yafctx.h"
+
+/** Maximum number of flow table worker threads */
+#define YF_THREADS_MAX 64
+
+/**
+ * Allocate flow table worker state for a context.  Takes ownership of the
+ * flow tables, one per worker, which will be freed by yfThreadsFree().
+ * The workers are not started until yfThreadsStart() is called.
+ *
+ * @param ctx      main context; its configuration is shared by the workers
+ * @param tabs     array of count flow tables, one per worker
+ * @param count    number of workers
+ * @return worker state, to be stored in ctx->threads
+ */
+struct yfThreads_st *yfThreadsAlloc(
+    yfContext_t         *ctx,
+    yfFlowTab_t         **tabs,
+    unsigned int        count);
+
+/**
+ * Start the flow table worker threads of ctx->threads.
+ *
+ * @param ctx      main context
+ * @param err      an error description
+ * @return TRUE on success, FALSE if a thread could not be started
+ */
+gboolean yfThreadsStart(
+    yfContext_t         *ctx,
+    GError              **err);
+
+/**
+ * Hand a decoded packet to the worker thread that owns its flow.  The
+ * packet is copied; the packet buffer may be reused on return.
+ *
+ * @param ctx      main context
+ * @param pbuf     decoded packet
+ * @param err      an error description
+ * @return TRUE on success, FALSE if a worker has failed
+ */
+gboolean yfThreadsDispatch(
+    yfContext_t         *ctx,
+    yfPBuf_t            *pbuf,
+    GError              **err);
+
+/**
+ * End a batch of dispatched packets: make every packet dispatched so far
+ * visible to the workers, let each worker advance its clock and flush, and
+ * copy the workers' flow table statistics to the main flow table.
+ *
+ * @param ctx      main context
+ * @param err      an error description
+ * @return TRUE on success, FALSE if a worker has failed
+ */
+gboolean yfThreadsRelease(
+    yfContext_t         *ctx,
+    GError              **err);
+
+/**
+ * Stop and join the worker threads.  If flush is TRUE, every flow left in
+ * the workers' flow tables is then written to the output of the main
+ * context.  The main flow table's statistics are set to the totals of the
+ * workers' flow tables.  Does nothing if ctx->threads is NULL.
+ *
+ * @param ctx      main context
+ * @param flush    TRUE to flush the workers' flow tables
+ * @param err      an error description
+ * @return TRUE on success, FALSE if a worker failed or the flush failed
+ */
+gboolean yfThreadsFinish(
+    yfContext_t         *ctx,
+    gboolean            flush,
+    GError              **err);
+
+/**
+ * Stop any running worker threads and free the worker state and flow
+ * tables of ctx->threads.  Does nothing if ctx->threads is NULL.
+ *
+ * @param ctx      main context
+ */
+void yfThreadsFree(
+    yfContext_t         *ctx);
+
+/**
+ * Take the output lock, which must be held to use the output buffer of
+ * the main context while worker threads are running.  Does nothing if
+ * ctx->threads is NULL.
+ *
+ * @param ctx      main context
+ */
+void yfThreadsLockOutput(
+    yfContext_t         *ctx);
+
+/**
+ * Release the output lock taken by yfThreadsLockOutput().
+ *
+ * @param ctx      main context
+ */
+void yfThreadsUnlockOutput(
+    yfContext_t         *ctx);
+
+/**
+ * Print per-worker statistics to the log.  Does nothing if ctx->threads
+ * is NULL.
+ *
+ * @param ctx      main context
+ */
+void yfThreadsDumpStats(
+    yfContext_t         *ctx);
+
+#endif